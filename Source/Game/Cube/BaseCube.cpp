@@ -5,9 +5,9 @@ BaseCube::BaseCube(_In_ const XMFLOAT4& outputColor)
 {
 }
 
-HRESULT BaseCube::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+HRESULT BaseCube::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ library::GeometryRegistry* pGeometryRegistry)
 {
-    return initialize(pDevice, pImmediateContext);
+    return initialize(pDevice, pImmediateContext, pGeometryRegistry);
 }
 
 UINT BaseCube::GetNumVertices() const
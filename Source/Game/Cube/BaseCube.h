@@ -36,7 +36,7 @@ public:
     BaseCube& operator=(BaseCube&& other) = delete;
     ~BaseCube() = default;
 
-    virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
+    virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ library::GeometryRegistry* pGeometryRegistry) override;
     virtual void Update(_In_ FLOAT deltaTime) = 0;
 
     UINT GetNumVertices() const override;
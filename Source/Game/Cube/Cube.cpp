@@ -37,7 +37,7 @@ void Cube::Update(_In_ FLOAT deltaTime)
     // Does nothing
 }
 
-HRESULT Cube::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+HRESULT Cube::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ library::GeometryRegistry* pGeometryRegistry)
 {
     BasicMeshEntry basicMeshEntry;
     basicMeshEntry.uNumIndices = NUM_INDICES;
@@ -49,5 +49,5 @@ HRESULT Cube::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* p
         SetMaterialOfMesh(0, 0);
     }
 
-    return initialize(pDevice, pImmediateContext);
+    return initialize(pDevice, pImmediateContext, pGeometryRegistry);
 }
\ No newline at end of file
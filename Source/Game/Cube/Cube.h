@@ -25,6 +25,6 @@ public:
     Cube& operator=(Cube&& other) = delete;
     ~Cube() = default;
 
-    virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
+    virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ library::GeometryRegistry* pGeometryRegistry) override;
     virtual void Update(_In_ FLOAT deltaTime) override;
 };
@@ -89,6 +89,52 @@ namespace library
         return m_view;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Camera::GetForward
+
+      Summary:  Returns the forward vector on the horizontal plane
+
+      Returns:  const XMVECTOR&
+                  The forward vector
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    const XMVECTOR& Camera::GetForward() const
+    {
+        return m_cameraForward;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Camera::GetRight
+
+      Summary:  Returns the right vector on the horizontal plane
+
+      Returns:  const XMVECTOR&
+                  The right vector
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    const XMVECTOR& Camera::GetRight() const
+    {
+        return m_cameraRight;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Camera::SetEye
+
+      Summary:  Moves the eye to a position, e.g. the one resolved by
+                the collision of the walk mode. The view is rebuilt on
+                the next Update.
+
+      Args:     const XMVECTOR& eye
+                  New eye position
+
+      Modifies: [m_eye].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    void Camera::SetEye(_In_ const XMVECTOR& eye)
+    {
+        m_eye = eye;
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Camera::GetConstantBuffer
 
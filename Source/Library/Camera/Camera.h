@@ -31,6 +31,12 @@ namespace library
                   Getter for the up vector
                 GetView
                   Getter for the view transform matrix
+                GetForward
+                  Getter for the horizontal forward vector
+                GetRight
+                  Getter for the horizontal right vector
+                SetEye
+                  Moves the eye to a position
                 GetConstantBuffer
                   Get the constant buffer containing the view transform
                 HandleInput
@@ -59,6 +65,9 @@ namespace library
         const XMVECTOR& GetAt() const;
         const XMVECTOR& GetUp() const;
         const XMMATRIX& GetView() const;
+        const XMVECTOR& GetForward() const;
+        const XMVECTOR& GetRight() const;
+        void SetEye(_In_ const XMVECTOR& eye);
         ComPtr<ID3D11Buffer>& GetConstantBuffer();
 
         virtual void HandleInput(_In_ const DirectionsInput& directions, _In_ const MouseRelativeMovement& mouseRelativeMovement, _In_ FLOAT deltaTime);
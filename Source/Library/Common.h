@@ -87,6 +87,7 @@ namespace library
     E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
     enum class eBlockType : CHAR
     {
+        AIR = 0,
         GRASSLAND = 21,
         SNOW,
         OCEAN,
@@ -93,6 +93,7 @@ namespace library
 				m_renderer->Update(ElapsedTime);
 				QueryPerformanceCounter(&StartingTime);
 				m_renderer->Render();
+				m_renderer->Present();
 			}
 		}
 
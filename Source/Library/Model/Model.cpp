@@ -107,6 +107,8 @@ namespace library
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
+                GeometryRegistry* pGeometryRegistry
+                  Unused, a model has buffers of its own
 
       Modifies: [m_pScene, m_globalInverseTransform, m_animationBuffer,
                  m_skinningConstantBuffer].
@@ -118,7 +120,7 @@ namespace library
       TODO: Model::Initialize definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    HRESULT Model::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    HRESULT Model::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry*)
     {
         HRESULT hr = S_OK;
 
@@ -580,7 +582,8 @@ namespace library
             );
         }
 
-        hr = initialize(pDevice, pImmediateContext);
+        // The tangents come with the vertices, so the buffers of a model are never shared
+        hr = initialize(pDevice, pImmediateContext, nullptr);
         if (FAILED(hr))
         {
             return hr;
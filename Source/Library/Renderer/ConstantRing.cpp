@@ -0,0 +1,220 @@
+#include "Renderer/ConstantRing.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::ConstantRing
+
+      Summary:  Constructor
+
+      Modifies: [m_buffer, m_uSize, m_uOffset, m_bDiscard, m_pMapped,
+                 m_uNumAllocatedBytes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ConstantRing::ConstantRing()
+        : m_buffer()
+        , m_uSize(0u)
+        , m_uOffset(0u)
+        , m_bDiscard(TRUE)
+        , m_pMapped(nullptr)
+        , m_uNumAllocatedBytes(0u)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::Initialize
+
+      Summary:  Creates the dynamic constant buffer through a context.
+                Binding ranges of it needs a Direct3D 11.1 device that
+                reports ConstantBufferOffsetting.
+
+      Args:     GraphicsContext& context
+                  Context to create the buffer with
+                UINT uSize
+                  Size of the ring in bytes, a multiple of
+                  RANGE_ALIGNMENT
+
+      Modifies: [m_buffer, m_uSize, m_uOffset, m_bDiscard].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT ConstantRing::Initialize(_In_ GraphicsContext& context, _In_ UINT uSize)
+    {
+        if (uSize == 0u || uSize % RANGE_ALIGNMENT != 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = uSize,
+            .Usage = D3D11_USAGE_DYNAMIC,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE
+        };
+
+        m_buffer.Reset();
+        HRESULT hr = context.CreateBuffer(&bd, m_buffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_uSize = uSize;
+        m_uOffset = 0u;
+        m_bDiscard = TRUE;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::Allocate
+
+      Summary:  Returns the next range of the mapped buffer, rounded up
+                to RANGE_ALIGNMENT bytes
+
+      Args:     UINT uNumBytes
+                  Number of bytes the range has to hold
+                UINT& uOutFirstConstant
+                  First constant of the range
+                UINT& uOutNumConstants
+                  Number of constants of the range
+
+      Modifies: [m_uOffset, m_uNumAllocatedBytes].
+
+      Returns:  void*
+                  Memory to write the constants into, nullptr if the
+                  buffer is not mapped or the frame has used it up
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void* ConstantRing::Allocate(_In_ UINT uNumBytes, _Out_ UINT& uOutFirstConstant, _Out_ UINT& uOutNumConstants)
+    {
+        uOutFirstConstant = 0u;
+        uOutNumConstants = 0u;
+
+        UINT uRangeSize = (uNumBytes + RANGE_ALIGNMENT - 1u) & ~(RANGE_ALIGNMENT - 1u);
+        if (!m_pMapped || uRangeSize == 0u || uRangeSize > MAX_RANGE_SIZE || uRangeSize > m_uSize - m_uOffset)
+        {
+            return nullptr;
+        }
+
+        void* pRange = m_pMapped + m_uOffset;
+        uOutFirstConstant = m_uOffset / CONSTANT_SIZE;
+        uOutNumConstants = uRangeSize / CONSTANT_SIZE;
+
+        m_uOffset += uRangeSize;
+        m_uNumAllocatedBytes += uRangeSize;
+
+        return pRange;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::BeginFrame
+
+      Summary:  Rewinds the ring, the next map discards the ranges of
+                the last frame. The buffer must not be mapped.
+
+      Modifies: [m_uOffset, m_bDiscard].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ConstantRing::BeginFrame()
+    {
+        m_uOffset = 0u;
+        m_bDiscard = TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::GetBuffer
+
+      Summary:  Returns the constant buffer the ranges are bound from
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Constant buffer, empty before Initialize
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& ConstantRing::GetBuffer()
+    {
+        return m_buffer;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::GetNumAllocatedBytes
+
+      Summary:  Returns the number of bytes of all the ranges allocated
+                so far
+
+      Returns:  UINT64
+                  Number of allocated bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 ConstantRing::GetNumAllocatedBytes() const
+    {
+        return m_uNumAllocatedBytes;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::IsMapped
+
+      Summary:  Returns whether the buffer is mapped
+
+      Returns:  BOOL
+                  TRUE between Map and Unmap
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL ConstantRing::IsMapped() const
+    {
+        return m_pMapped != nullptr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::Map
+
+      Summary:  Maps the buffer to allocate ranges from it, discarding
+                on the first map of a frame
+
+      Args:     GraphicsContext& context
+                  Context to map the buffer with
+
+      Modifies: [m_bDiscard, m_pMapped].
+
+      Returns:  HRESULT
+                  Status code, E_NOT_VALID_STATE before Initialize or
+                  while mapped
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT ConstantRing::Map(_In_ GraphicsContext& context)
+    {
+        if (!m_buffer || m_pMapped)
+        {
+            return E_NOT_VALID_STATE;
+        }
+
+        void* pData = nullptr;
+        HRESULT hr = context.MapBuffer(m_buffer.Get(), m_bDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, m_uSize, &pData);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_bDiscard = FALSE;
+        m_pMapped = static_cast<BYTE*>(pData);
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ConstantRing::Unmap
+
+      Summary:  Unmaps the buffer, the draws can only read the ranges
+                after it is unmapped
+
+      Args:     GraphicsContext& context
+                  Context the buffer was mapped with
+
+      Modifies: [m_pMapped].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ConstantRing::Unmap(_In_ GraphicsContext& context)
+    {
+        if (!m_pMapped)
+        {
+            return;
+        }
+
+        context.UnmapBuffer(m_buffer.Get());
+        m_pMapped = nullptr;
+    }
+}
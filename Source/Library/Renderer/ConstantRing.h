@@ -0,0 +1,96 @@
+/*+===================================================================
+  File:      CONSTANTRING.H
+
+  Summary:   ConstantRing header file contains declarations of the
+             ConstantRing class that hands out ranges of one dynamic
+             constant buffer to the draws of a frame.
+
+  Classes: ConstantRing
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/GraphicsContext.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    ConstantRing
+
+      Summary:  Dynamic constant buffer that the per draw constants of a
+                frame are written into one after the other, each draw
+                binds its range with VSSetConstantBuffers1 and
+                PSSetConstantBuffers1. The first map of a frame uses
+                D3D11_MAP_WRITE_DISCARD, so the driver hands out fresh
+                memory while the GPU reads the last frame, the later
+                maps use D3D11_MAP_WRITE_NO_OVERWRITE and only append.
+
+                Ranges start and end on multiples of 16 constants of 16
+                bytes, as Direct3D 11.1 requires. Allocate fails once
+                the frame has used up the buffer, the draw then falls
+                back to a constant buffer of its own.
+
+                The buffer is created, mapped and written through a
+                GraphicsContext, so with a RecordingGraphicsContext the
+                ring runs headless.
+
+      Methods:  Initialize
+                  Creates the constant buffer through a context
+                Allocate
+                  Returns a range of the mapped buffer
+                BeginFrame
+                  Rewinds the ring for a new frame
+                GetBuffer
+                  Returns the constant buffer
+                GetNumAllocatedBytes
+                  Returns the number of bytes allocated so far
+                IsMapped
+                  Returns whether the buffer is mapped
+                Map
+                  Maps the buffer to allocate from it
+                Unmap
+                  Unmaps the buffer before the draws read it
+                ConstantRing
+                  Constructor.
+                ~ConstantRing
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class ConstantRing final
+    {
+    public:
+        static constexpr const UINT DEFAULT_SIZE = 1u << 20u;
+        static constexpr const UINT CONSTANT_SIZE = 16u;
+        static constexpr const UINT RANGE_ALIGNMENT = 16u * CONSTANT_SIZE;
+        // A bound range may span at most 4096 constants
+        static constexpr const UINT MAX_RANGE_SIZE = 4096u * CONSTANT_SIZE;
+
+    public:
+        ConstantRing();
+        ConstantRing(const ConstantRing& other) = delete;
+        ConstantRing(ConstantRing&& other) = delete;
+        ConstantRing& operator=(const ConstantRing& other) = delete;
+        ConstantRing& operator=(ConstantRing&& other) = delete;
+        ~ConstantRing() = default;
+
+        HRESULT Initialize(_In_ GraphicsContext& context, _In_ UINT uSize = DEFAULT_SIZE);
+
+        void* Allocate(_In_ UINT uNumBytes, _Out_ UINT& uOutFirstConstant, _Out_ UINT& uOutNumConstants);
+        void BeginFrame();
+        ComPtr<ID3D11Buffer>& GetBuffer();
+        UINT64 GetNumAllocatedBytes() const;
+        BOOL IsMapped() const;
+        HRESULT Map(_In_ GraphicsContext& context);
+        void Unmap(_In_ GraphicsContext& context);
+
+    private:
+        ComPtr<ID3D11Buffer> m_buffer;
+        UINT m_uSize;
+        UINT m_uOffset;
+        BOOL m_bDiscard;
+        BYTE* m_pMapped;
+        UINT64 m_uNumAllocatedBytes;
+    };
+}
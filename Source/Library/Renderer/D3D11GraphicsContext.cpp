@@ -0,0 +1,537 @@
+#include "Renderer/D3D11GraphicsContext.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::D3D11GraphicsContext
+
+      Summary:  Constructor
+
+      Args:     ID3D11DeviceContext* pDeviceContext
+                  Device context to forward the calls to
+
+      Modifies: [m_deviceContext, m_deviceContext1, m_commandList,
+                 m_bDeferred].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    D3D11GraphicsContext::D3D11GraphicsContext(_In_ ID3D11DeviceContext* pDeviceContext)
+        : m_deviceContext(pDeviceContext)
+        , m_deviceContext1()
+        , m_commandList()
+        , m_bDeferred(pDeviceContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+    {
+        // Direct3D 11.0 contexts have no ID3D11DeviceContext1, the ranged binds then bind whole buffers
+        m_deviceContext.As(&m_deviceContext1);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::GetDeviceContext
+
+      Summary:  Returns the device context the calls are forwarded to
+
+      Returns:  ComPtr<ID3D11DeviceContext>&
+                  Device context
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11DeviceContext>& D3D11GraphicsContext::GetDeviceContext()
+    {
+        return m_deviceContext;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::ClearDepthStencilView
+
+      Summary:  Clears a depth stencil view
+
+      Args:     ID3D11DepthStencilView* pDepthStencilView
+                  View to clear
+                UINT uClearFlags
+                  D3D11_CLEAR_FLAG bits
+                FLOAT depth
+                  Depth to clear to
+                UINT8 stencil
+                  Stencil to clear to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil)
+    {
+        m_deviceContext->ClearDepthStencilView(pDepthStencilView, uClearFlags, depth, stencil);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::ClearRenderTargetView
+
+      Summary:  Clears a render target view
+
+      Args:     ID3D11RenderTargetView* pRenderTargetView
+                  View to clear
+                const FLOAT aColorRGBA[4]
+                  Color to clear to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4])
+    {
+        m_deviceContext->ClearRenderTargetView(pRenderTargetView, aColorRGBA);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::CreateBuffer
+
+      Summary:  Creates a buffer of the device of the context
+
+      Args:     const D3D11_BUFFER_DESC* pDesc
+                  Description of the buffer
+                ID3D11Buffer** ppBuffer
+                  Receives the buffer
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT D3D11GraphicsContext::CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer)
+    {
+        ComPtr<ID3D11Device> device;
+        m_deviceContext->GetDevice(device.GetAddressOf());
+
+        return device->CreateBuffer(pDesc, nullptr, ppBuffer);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::CreateDeferredContext
+
+      Summary:  Creates a deferred context of the device of the context
+
+      Args:     std::shared_ptr<GraphicsContext>& outDeferredContext
+                  Receives the deferred context
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT D3D11GraphicsContext::CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext)
+    {
+        outDeferredContext.reset();
+
+        ComPtr<ID3D11Device> device;
+        m_deviceContext->GetDevice(device.GetAddressOf());
+
+        ComPtr<ID3D11DeviceContext> deferredContext;
+        HRESULT hr = device->CreateDeferredContext(0u, deferredContext.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        outDeferredContext = std::make_shared<D3D11GraphicsContext>(deferredContext.Get());
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::DrawIndexed
+
+      Summary:  Draws indexed primitives
+
+      Args:     UINT uIndexCount
+                  Number of indices
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation)
+    {
+        m_deviceContext->DrawIndexed(uIndexCount, uStartIndexLocation, baseVertexLocation);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::DrawIndexedInstanced
+
+      Summary:  Draws instances of indexed primitives
+
+      Args:     UINT uIndexCountPerInstance
+                  Number of indices of an instance
+                UINT uInstanceCount
+                  Number of instances
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+                UINT uStartInstanceLocation
+                  First instance
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation)
+    {
+        m_deviceContext->DrawIndexedInstanced(uIndexCountPerInstance, uInstanceCount, uStartIndexLocation, baseVertexLocation, uStartInstanceLocation);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::ExecuteCommandList
+
+      Summary:  Executes the command list of the last FinishCommandList
+                of a deferred context and releases it. The state of the
+                context is cleared afterwards.
+
+      Args:     GraphicsContext& deferredContext
+                  D3D11GraphicsContext created by CreateDeferredContext
+                  of this context
+
+      Modifies: [m_commandList of deferredContext].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::ExecuteCommandList(_In_ GraphicsContext& deferredContext)
+    {
+        D3D11GraphicsContext& d3d11DeferredContext = static_cast<D3D11GraphicsContext&>(deferredContext);
+        if (!d3d11DeferredContext.m_commandList)
+        {
+            return;
+        }
+
+        m_deviceContext->ExecuteCommandList(d3d11DeferredContext.m_commandList.Get(), FALSE);
+        d3d11DeferredContext.m_commandList.Reset();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::FinishCommandList
+
+      Summary:  Closes the calls recorded on a deferred context into a
+                command list and clears the state of the context
+
+      Modifies: [m_commandList].
+
+      Returns:  HRESULT
+                  Status code, E_NOT_VALID_STATE on an immediate context
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT D3D11GraphicsContext::FinishCommandList()
+    {
+        if (!m_bDeferred)
+        {
+            return E_NOT_VALID_STATE;
+        }
+
+        m_commandList.Reset();
+        return m_deviceContext->FinishCommandList(FALSE, m_commandList.GetAddressOf());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::IASetIndexBuffer
+
+      Summary:  Binds the index buffer
+
+      Args:     ID3D11Buffer* pIndexBuffer
+                  Index buffer
+                DXGI_FORMAT format
+                  Format of the indices
+                UINT uOffset
+                  Offset of the first index in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset)
+    {
+        m_deviceContext->IASetIndexBuffer(pIndexBuffer, format, uOffset);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::IASetInputLayout
+
+      Summary:  Binds the input layout
+
+      Args:     ID3D11InputLayout* pInputLayout
+                  Input layout
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout)
+    {
+        m_deviceContext->IASetInputLayout(pInputLayout);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::IASetPrimitiveTopology
+
+      Summary:  Sets the primitive topology
+
+      Args:     D3D11_PRIMITIVE_TOPOLOGY topology
+                  Primitive topology
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology)
+    {
+        m_deviceContext->IASetPrimitiveTopology(topology);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::IASetVertexBuffers
+
+      Summary:  Binds vertex buffers
+
+      Args:     UINT uStartSlot
+                  First input slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppVertexBuffers
+                  Vertex buffers
+                const UINT* pStrides
+                  Stride of every buffer
+                const UINT* pOffsets
+                  Offset of every buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets)
+    {
+        m_deviceContext->IASetVertexBuffers(uStartSlot, uNumBuffers, ppVertexBuffers, pStrides, pOffsets);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::MapBuffer
+
+      Summary:  Maps a buffer for writing
+
+      Args:     ID3D11Buffer* pBuffer
+                  Dynamic buffer to map
+                D3D11_MAP mapType
+                  D3D11_MAP_WRITE_DISCARD or D3D11_MAP_WRITE_NO_OVERWRITE
+                UINT uNumBytes
+                  Number of bytes that will be written
+                void** ppData
+                  Receives the mapped memory
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT D3D11GraphicsContext::MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData)
+    {
+        UNREFERENCED_PARAMETER(uNumBytes);
+
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        HRESULT hr = m_deviceContext->Map(pBuffer, 0u, mapType, 0u, &mapped);
+        *ppData = mapped.pData;
+        return hr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::OMSetRenderTargets
+
+      Summary:  Binds render targets and a depth stencil view
+
+      Args:     UINT uNumViews
+                  Number of render targets
+                ID3D11RenderTargetView* const* ppRenderTargetViews
+                  Render targets
+                ID3D11DepthStencilView* pDepthStencilView
+                  Depth stencil view
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView)
+    {
+        m_deviceContext->OMSetRenderTargets(uNumViews, ppRenderTargetViews, pDepthStencilView);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::PSSetConstantBuffers
+
+      Summary:  Binds constant buffers of the pixel shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        m_deviceContext->PSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::PSSetConstantBuffers1
+
+      Summary:  Binds ranges of constant buffers of the pixel shader
+                stage, or the whole buffers without a Direct3D 11.1
+                device context
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First 16-byte constant of every range, a multiple of
+                  16
+                const UINT* pNumConstants
+                  Number of constants of every range, a multiple of 16
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        if (!m_deviceContext1)
+        {
+            m_deviceContext->PSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+            return;
+        }
+
+        if (m_bDeferred)
+        {
+            ID3D11Buffer* const apNullBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr, };
+            m_deviceContext->PSSetConstantBuffers(uStartSlot, uNumBuffers, apNullBuffers);
+        }
+
+        m_deviceContext1->PSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::PSSetSamplers
+
+      Summary:  Binds samplers of the pixel shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumSamplers
+                  Number of samplers
+                ID3D11SamplerState* const* ppSamplers
+                  Samplers
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers)
+    {
+        m_deviceContext->PSSetSamplers(uStartSlot, uNumSamplers, ppSamplers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::PSSetShader
+
+      Summary:  Binds the pixel shader
+
+      Args:     ID3D11PixelShader* pPixelShader
+                  Pixel shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        m_deviceContext->PSSetShader(pPixelShader, ppClassInstances, uNumClassInstances);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::PSSetShaderResources
+
+      Summary:  Binds shader resources of the pixel shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumViews
+                  Number of views
+                ID3D11ShaderResourceView* const* ppShaderResourceViews
+                  Shader resource views
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews)
+    {
+        m_deviceContext->PSSetShaderResources(uStartSlot, uNumViews, ppShaderResourceViews);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::RSSetViewports
+
+      Summary:  Sets the viewports
+
+      Args:     UINT uNumViewports
+                  Number of viewports
+                const D3D11_VIEWPORT* pViewports
+                  Viewports
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports)
+    {
+        m_deviceContext->RSSetViewports(uNumViewports, pViewports);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::UnmapBuffer
+
+      Summary:  Unmaps a mapped buffer
+
+      Args:     ID3D11Buffer* pBuffer
+                  Mapped buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::UnmapBuffer(_In_ ID3D11Buffer* pBuffer)
+    {
+        m_deviceContext->Unmap(pBuffer, 0u);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::UpdateBuffer
+
+      Summary:  Replaces the contents of a default usage buffer with
+                UpdateSubresource
+
+      Args:     ID3D11Buffer* pBuffer
+                  Buffer to update
+                const void* pData
+                  New contents of the buffer
+                UINT uNumBytes
+                  Size of the buffer in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes)
+    {
+        UNREFERENCED_PARAMETER(uNumBytes);
+
+        m_deviceContext->UpdateSubresource(pBuffer, 0u, nullptr, pData, 0u, 0u);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::VSSetConstantBuffers
+
+      Summary:  Binds constant buffers of the vertex shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        m_deviceContext->VSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::VSSetConstantBuffers1
+
+      Summary:  Binds ranges of constant buffers of the vertex shader
+                stage, or the whole buffers without a Direct3D 11.1
+                device context
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First 16-byte constant of every range, a multiple of
+                  16
+                const UINT* pNumConstants
+                  Number of constants of every range, a multiple of 16
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        if (!m_deviceContext1)
+        {
+            m_deviceContext->VSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+            return;
+        }
+
+        if (m_bDeferred)
+        {
+            ID3D11Buffer* const apNullBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr, };
+            m_deviceContext->VSSetConstantBuffers(uStartSlot, uNumBuffers, apNullBuffers);
+        }
+
+        m_deviceContext1->VSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   D3D11GraphicsContext::VSSetShader
+
+      Summary:  Binds the vertex shader
+
+      Args:     ID3D11VertexShader* pVertexShader
+                  Vertex shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void D3D11GraphicsContext::VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        m_deviceContext->VSSetShader(pVertexShader, ppClassInstances, uNumClassInstances);
+    }
+}
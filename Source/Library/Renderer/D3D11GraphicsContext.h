@@ -0,0 +1,88 @@
+/*+===================================================================
+  File:      D3D11GRAPHICSCONTEXT.H
+
+  Summary:   D3D11GraphicsContext header file contains declarations of
+             the D3D11GraphicsContext class that forwards the frame
+             calls of the renderer to a Direct3D 11 device context.
+
+  Classes: D3D11GraphicsContext
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/GraphicsContext.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    D3D11GraphicsContext
+
+      Summary:  GraphicsContext that calls a Direct3D 11 device context,
+                which keeps the behaviour of a renderer that calls the
+                device context itself. The ranged constant buffer binds
+                call the ID3D11DeviceContext1 of the context if it has
+                one.
+
+                A deferred context keeps the command list of its last
+                FinishCommandList until the context that created it
+                executes it. On a deferred context a ranged bind unbinds
+                its slots first, since the Direct3D 11.1 runtime may
+                drop a bind of a buffer that is already bound with
+                another range when it records a command list.
+
+      Methods:  GetDeviceContext
+                  Returns the device context
+                D3D11GraphicsContext
+                  Constructor.
+                ~D3D11GraphicsContext
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class D3D11GraphicsContext final : public GraphicsContext
+    {
+    public:
+        D3D11GraphicsContext() = delete;
+        D3D11GraphicsContext(_In_ ID3D11DeviceContext* pDeviceContext);
+        D3D11GraphicsContext(const D3D11GraphicsContext& other) = delete;
+        D3D11GraphicsContext(D3D11GraphicsContext&& other) = delete;
+        D3D11GraphicsContext& operator=(const D3D11GraphicsContext& other) = delete;
+        D3D11GraphicsContext& operator=(D3D11GraphicsContext&& other) = delete;
+        ~D3D11GraphicsContext() = default;
+
+        ComPtr<ID3D11DeviceContext>& GetDeviceContext();
+
+        void ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil) override;
+        void ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4]) override;
+        HRESULT CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer) override;
+        HRESULT CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext) override;
+        void DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation) override;
+        void DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation) override;
+        void ExecuteCommandList(_In_ GraphicsContext& deferredContext) override;
+        HRESULT FinishCommandList() override;
+        void IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset) override;
+        void IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout) override;
+        void IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology) override;
+        void IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets) override;
+        HRESULT MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData) override;
+        void OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView) override;
+        void PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers) override;
+        void PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+        void PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+        void RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports) override;
+        void UnmapBuffer(_In_ ID3D11Buffer* pBuffer) override;
+        void UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes) override;
+        void VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+
+    private:
+        ComPtr<ID3D11DeviceContext> m_deviceContext;
+        ComPtr<ID3D11DeviceContext1> m_deviceContext1;
+        ComPtr<ID3D11CommandList> m_commandList;
+        BOOL m_bDeferred;
+    };
+}
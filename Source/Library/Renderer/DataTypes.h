@@ -20,6 +20,33 @@ namespace library
 		XMMATRIX Transformation;
 	};
 
+	/*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+		Struct:   VoxelInstanceData
+
+		Summary:  Packed per-instance data of a voxel, read as a
+				  R16G16B16A16_SINT and two R32G32_UINT elements. X, Y
+				  and Z are the grid coordinates of the voxel, FaceMask
+				  has one bit per visible face in the order of
+				  Voxel::VERTICES. AmbientOcclusion holds 2 bits per
+				  corner of every face, 8 bits per face with faces 0 to
+				  3 in the first word, from 0 for an open corner to 3
+				  for a corner between two blocks. Light holds the
+				  light of the cell in front of every face in the same
+				  layout, the skylight level in the low and the block
+				  light level in the high nibble
+	S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+	struct VoxelInstanceData
+	{
+		INT16 X;
+		INT16 Y;
+		INT16 Z;
+		BYTE BlockType;
+		BYTE FaceMask;
+		UINT AmbientOcclusion[2];
+		UINT Light[2];
+	};
+	static_assert(sizeof(VoxelInstanceData) == 24u, "VoxelInstanceData must match DXGI_FORMAT_R16G16B16A16_SINT followed by two DXGI_FORMAT_R32G32_UINT");
+
 	struct AnimationData
 	{
 		XMUINT4 aBoneIndices;
@@ -32,6 +59,18 @@ namespace library
 		XMFLOAT3 Bitangent;
 	};
 
+	/*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+		Struct:   AxisAlignedBox
+
+		Summary:  Axis-aligned bounding box stored as its center and its
+				  non-negative half size along every axis
+	S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+	struct AxisAlignedBox
+	{
+		XMFLOAT3 Center;
+		XMFLOAT3 Extents;
+	};
+
 	struct CBChangeOnCameraMovement
 	{
 		XMMATRIX View;
@@ -67,6 +106,18 @@ namespace library
 		PointLightStruct PointLights[NUM_LIGHTS];
 	};
 
+	/*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+		Struct:   CBVoxelPalette
+
+		Summary:  Color of every block type, indexed by
+				  VoxelInstanceData::BlockType, so the blocks of all
+				  biomes are drawn by one instanced draw
+	S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+	struct CBVoxelPalette
+	{
+		XMFLOAT4 BlockColors[static_cast<size_t>(eBlockType::COUNT)];
+	};
+
 	struct CBShadowMatrix
 	{
 		XMMATRIX World;
@@ -0,0 +1,284 @@
+#include "Renderer/DrawQueue.h"
+
+#include "Texture/Material.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetPass
+
+      Summary:  Returns the pass of a sort key
+
+      Args:     UINT64 uSortKey
+                  Sort key made by MakeSortKey
+
+      Returns:  eRenderPass
+                  Pass of the draw
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eRenderPass DrawQueue::GetPass(_In_ UINT64 uSortKey)
+    {
+        return static_cast<eRenderPass>(uSortKey >> PASS_SHIFT);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetStateKey
+
+      Summary:  Returns the fields of a sort key above the depth, the
+                draws with the same state key share the pass, the
+                shader pair id and the material id
+
+      Args:     UINT64 uSortKey
+                  Sort key made by MakeSortKey
+
+      Returns:  UINT
+                  Pass, shader pair and material of the draw
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DrawQueue::GetStateKey(_In_ UINT64 uSortKey)
+    {
+        return static_cast<UINT>(uSortKey >> MATERIAL_SHIFT);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::MakeSortKey
+
+      Summary:  Packs the fields of a draw item into its sort key
+
+      Args:     eRenderPass pass
+                  Pass of the draw
+                UINT uShaderId
+                  Id of the shader pair, see GetShaderId
+                UINT uMaterialId
+                  Id of the material, see GetMaterialId
+                FLOAT depth
+                  Non-negative distance to the camera, or any
+                  monotonic function of it
+
+      Returns:  UINT64
+                  Sort key, the draws with smaller keys are drawn first
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 DrawQueue::MakeSortKey(_In_ eRenderPass pass, _In_ UINT uShaderId, _In_ UINT uMaterialId, _In_ FLOAT depth)
+    {
+        // The bits of a non-negative float order like the float, the upper 16 keep the
+        // exponent and 7 bits of the mantissa, which is enough to draw front to back
+        UINT uDepthBits = XMVectorGetIntX(XMVectorReplicate(depth > 0.0f ? depth : 0.0f)) >> 16u;
+
+        return (static_cast<UINT64>(pass) << PASS_SHIFT)
+            | (static_cast<UINT64>(uShaderId & (MAX_SHADER_IDS - 1u)) << SHADER_SHIFT)
+            | (static_cast<UINT64>(uMaterialId & (MAX_MATERIAL_IDS - 1u)) << MATERIAL_SHIFT)
+            | (static_cast<UINT64>(uDepthBits) << DEPTH_SHIFT);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::DrawQueue
+
+      Summary:  Constructor
+
+      Modifies: [m_aItems, m_aSortedItems, m_aShaderPairs,
+                  m_materialIds].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DrawQueue::DrawQueue()
+        : m_aItems()
+        , m_aSortedItems()
+        , m_aShaderPairs()
+        , m_materialIds()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::Add
+
+      Summary:  Queues a draw item
+
+      Args:     const DrawItem& item
+                  Draw item with its sort key
+
+      Modifies: [m_aItems].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DrawQueue::Add(_In_ const DrawItem& item)
+    {
+        m_aItems.push_back(item);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::Clear
+
+      Summary:  Removes the items and the ids of the frame, the memory
+                is kept for the next frame
+
+      Modifies: [m_aItems, m_aShaderPairs, m_materialIds].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DrawQueue::Clear()
+    {
+        m_aItems.clear();
+        m_aShaderPairs.clear();
+        m_materialIds.clear();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetItems
+
+      Summary:  Returns the items, in their sorted order after Sort
+
+      Returns:  const std::vector<DrawItem>&
+                  Draw items
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<DrawItem>& DrawQueue::GetItems() const
+    {
+        return m_aItems;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetItems
+
+      Summary:  Returns the items to fill in their constants, the sort
+                keys must not change
+
+      Returns:  std::vector<DrawItem>&
+                  Draw items
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::vector<DrawItem>& DrawQueue::GetItems()
+    {
+        return m_aItems;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetMaterialId
+
+      Summary:  Returns the id of a material in this frame. The ids
+                past MAX_MATERIAL_IDS share the last id, which only
+                makes the order less tight.
+
+      Args:     const Material* pMaterial
+                  Material, nullptr for no material
+
+      Modifies: [m_materialIds].
+
+      Returns:  UINT
+                  Id of the material, 0 for no material
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DrawQueue::GetMaterialId(_In_opt_ const Material* pMaterial)
+    {
+        if (!pMaterial)
+        {
+            return 0u;
+        }
+
+        UINT uNextId = static_cast<UINT>(m_materialIds.size()) + 1u;
+        auto materialId = m_materialIds.try_emplace(pMaterial, uNextId < MAX_MATERIAL_IDS ? uNextId : MAX_MATERIAL_IDS - 1u);
+        return materialId.first->second;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::GetShaderId
+
+      Summary:  Returns the id of a pair of shaders in this frame. The
+                ids past MAX_SHADER_IDS share the last id.
+
+      Args:     ID3D11VertexShader* pVertexShader
+                  Vertex shader
+                ID3D11PixelShader* pPixelShader
+                  Pixel shader
+
+      Modifies: [m_aShaderPairs].
+
+      Returns:  UINT
+                  Id of the shader pair
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DrawQueue::GetShaderId(_In_opt_ ID3D11VertexShader* pVertexShader, _In_opt_ ID3D11PixelShader* pPixelShader)
+    {
+        UINT uId = 0u;
+        while (uId < m_aShaderPairs.size()
+            && (m_aShaderPairs[uId].first != pVertexShader || m_aShaderPairs[uId].second != pPixelShader))
+        {
+            ++uId;
+        }
+
+        if (uId == m_aShaderPairs.size())
+        {
+            m_aShaderPairs.emplace_back(pVertexShader, pPixelShader);
+        }
+        return uId < MAX_SHADER_IDS ? uId : MAX_SHADER_IDS - 1u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::RemoveHidden
+
+      Summary:  Removes the items that are not visible, the others keep
+                their order
+
+      Args:     const std::vector<BOOL>& aVisible
+                  FALSE for every item to remove, in the order the items
+                  were added. The items past its end are kept.
+
+      Modifies: [m_aItems].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DrawQueue::RemoveHidden(_In_ const std::vector<BOOL>& aVisible)
+    {
+        size_t uNumKept = 0u;
+        for (size_t uItemIdx = 0u; uItemIdx < m_aItems.size(); ++uItemIdx)
+        {
+            if (uItemIdx >= aVisible.size() || aVisible[uItemIdx])
+            {
+                m_aItems[uNumKept++] = m_aItems[uItemIdx];
+            }
+        }
+        m_aItems.resize(uNumKept);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DrawQueue::Sort
+
+      Summary:  Sorts the items by their keys with a stable LSD radix
+                sort, the items with equal keys keep the order they
+                were added in
+
+      Modifies: [m_aItems, m_aSortedItems].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DrawQueue::Sort()
+    {
+        const UINT uNumItems = static_cast<UINT>(m_aItems.size());
+        if (uNumItems < 2u)
+        {
+            return;
+        }
+
+        UINT aCounts[NUM_RADIX_PASSES][RADIX_SIZE] = {};
+        for (UINT uItemIdx = 0u; uItemIdx < uNumItems; ++uItemIdx)
+        {
+            UINT64 uSortKey = m_aItems[uItemIdx].uSortKey;
+            for (UINT uPass = 0u; uPass < NUM_RADIX_PASSES; ++uPass)
+            {
+                ++aCounts[uPass][(uSortKey >> (uPass * RADIX_BITS)) & (RADIX_SIZE - 1u)];
+            }
+        }
+
+        m_aSortedItems.resize(uNumItems);
+        for (UINT uPass = 0u; uPass < NUM_RADIX_PASSES; ++uPass)
+        {
+            UINT* pCounts = aCounts[uPass];
+            UINT uShift = uPass * RADIX_BITS;
+
+            // Every key has the same digit, the pass would not move an item
+            if (pCounts[(m_aItems[0].uSortKey >> uShift) & (RADIX_SIZE - 1u)] == uNumItems)
+            {
+                continue;
+            }
+
+            // Turn the counts into the first position of every digit
+            UINT uOffset = 0u;
+            for (UINT uDigit = 0u; uDigit < RADIX_SIZE; ++uDigit)
+            {
+                UINT uCount = pCounts[uDigit];
+                pCounts[uDigit] = uOffset;
+                uOffset += uCount;
+            }
+
+            for (UINT uItemIdx = 0u; uItemIdx < uNumItems; ++uItemIdx)
+            {
+                const DrawItem& item = m_aItems[uItemIdx];
+                m_aSortedItems[pCounts[(item.uSortKey >> uShift) & (RADIX_SIZE - 1u)]++] = item;
+            }
+            m_aItems.swap(m_aSortedItems);
+        }
+    }
+}
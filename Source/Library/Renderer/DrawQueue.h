@@ -0,0 +1,151 @@
+/*+===================================================================
+  File:      DRAWQUEUE.H
+
+  Summary:   DrawQueue header file contains declarations of the
+             DrawQueue class that sorts the draws of a frame by their
+             pipeline state.
+
+  Classes: DrawQueue
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/Renderable.h"
+
+namespace library
+{
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eRenderPass
+
+        Summary:  Enumeration of the passes of a frame, in the order they
+                  are drawn
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eRenderPass : BYTE
+    {
+        MESHES,
+        SKYBOX,
+        COUNT,
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   DrawItem
+
+      Summary:  Draw of a mesh of a renderable, or of its whole index
+                buffer if uMeshIndex is DrawQueue::WHOLE_RENDERABLE. The
+                animation buffer is bound as a third vertex stream if it
+                is not nullptr. The per draw constants are the range of
+                the constant ring from uFirstConstant, or the constant
+                buffer of the renderable if uNumConstants is 0. An item
+                with instances draws uNumInstances copies of the mesh
+                with the instanced variant of the vertex shader, their
+                world matrices are the instance stream of the frame from
+                uFirstInstance.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct DrawItem
+    {
+        UINT64 uSortKey;
+        Renderable* pRenderable;
+        ID3D11Buffer* pAnimationBuffer;
+        UINT uMeshIndex;
+        UINT uFirstConstant;
+        UINT uNumConstants;
+        UINT uFirstInstance;
+        UINT uNumInstances;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    DrawQueue
+
+      Summary:  Flat array of the draw items of a frame, sorted by a
+                64-bit key so that the draws that share a shader pair
+                and a material are submitted next to each other.
+
+                From the most significant bit the key packs the pass
+                (4 bits), the shader pair (12 bits), the material (16
+                bits) and the upper 16 bits of the non-negative depth,
+                which order like the depth itself. The lowest 16 bits
+                are zero. Shader pairs and materials get their ids in
+                the order they are first queued within a frame,
+                material 0 is no material.
+
+                The items are sorted by a stable LSD radix sort of 8
+                passes of 8 bits. The digit counts of all passes are
+                gathered in one sweep over the keys, and a pass where
+                every key has the same digit is skipped, so the zero
+                bits, and the fields that do not vary in a frame, cost
+                no pass over the items.
+
+      Methods:  GetPass
+                  Returns the pass of a sort key
+                GetStateKey
+                  Returns the pass, shader pair and material of a sort
+                  key
+                MakeSortKey
+                  Packs a pass, a shader pair, a material and a depth
+                Add
+                  Queues a draw item
+                Clear
+                  Removes the items and the ids of the frame
+                GetItems
+                  Returns the items
+                GetMaterialId
+                  Returns the id of a material
+                GetShaderId
+                  Returns the id of a shader pair
+                RemoveHidden
+                  Removes the items that are not visible
+                Sort
+                  Sorts the items by their keys
+                DrawQueue
+                  Constructor.
+                ~DrawQueue
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class DrawQueue final
+    {
+    public:
+        static constexpr const UINT WHOLE_RENDERABLE = 0xFFFFFFFF;
+        static constexpr const UINT MAX_SHADER_IDS = 1u << 12u;
+        static constexpr const UINT MAX_MATERIAL_IDS = 1u << 16u;
+
+    public:
+        static eRenderPass GetPass(_In_ UINT64 uSortKey);
+        static UINT GetStateKey(_In_ UINT64 uSortKey);
+        static UINT64 MakeSortKey(_In_ eRenderPass pass, _In_ UINT uShaderId, _In_ UINT uMaterialId, _In_ FLOAT depth);
+
+        DrawQueue();
+        DrawQueue(const DrawQueue& other) = delete;
+        DrawQueue(DrawQueue&& other) = delete;
+        DrawQueue& operator=(const DrawQueue& other) = delete;
+        DrawQueue& operator=(DrawQueue&& other) = delete;
+        ~DrawQueue() = default;
+
+        void Add(_In_ const DrawItem& item);
+        void Clear();
+        std::vector<DrawItem>& GetItems();
+        const std::vector<DrawItem>& GetItems() const;
+        UINT GetMaterialId(_In_opt_ const Material* pMaterial);
+        UINT GetShaderId(_In_opt_ ID3D11VertexShader* pVertexShader, _In_opt_ ID3D11PixelShader* pPixelShader);
+        void RemoveHidden(_In_ const std::vector<BOOL>& aVisible);
+        void Sort();
+
+    private:
+        static constexpr const UINT PASS_SHIFT = 60u;
+        static constexpr const UINT SHADER_SHIFT = 48u;
+        static constexpr const UINT MATERIAL_SHIFT = 32u;
+        static constexpr const UINT DEPTH_SHIFT = 16u;
+        static constexpr const UINT RADIX_BITS = 8u;
+        static constexpr const UINT RADIX_SIZE = 1u << RADIX_BITS;
+        static constexpr const UINT NUM_RADIX_PASSES = 64u / RADIX_BITS;
+
+    private:
+        std::vector<DrawItem> m_aItems;
+        std::vector<DrawItem> m_aSortedItems;
+        // Shader pairs of the frame, a frame has few, so they are searched linearly
+        std::vector<std::pair<ID3D11VertexShader*, ID3D11PixelShader*>> m_aShaderPairs;
+        std::unordered_map<const Material*, UINT> m_materialIds;
+    };
+}
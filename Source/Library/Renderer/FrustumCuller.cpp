@@ -0,0 +1,341 @@
+#include "Renderer/FrustumCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <immintrin.h>
+
+#include "Scene/Noise.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::ExtractPlanes
+
+      Summary:  Extracts the planes of the frustum from the columns of
+                the view projection matrix. A point is inside when its
+                clip space coordinates satisfy -w <= x <= w,
+                -w <= y <= w and 0 <= z <= w, every inequality is a
+                plane of the world space point.
+
+      Args:     FXMMATRIX viewProjection
+                  View matrix times the projection matrix
+                XMFLOAT4* aOutPlanes
+                  Normalized planes, the normals point inside
+
+      Modifies: [aOutPlanes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void FrustumCuller::ExtractPlanes(_In_ FXMMATRIX viewProjection, _Out_writes_(NUM_PLANES) XMFLOAT4* aOutPlanes)
+    {
+        // Row vectors, so the clip space coordinates are the dot products with the columns
+        XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+        const XMVECTOR aPlanes[NUM_PLANES] =
+        {
+            XMVectorAdd(columns.r[3], columns.r[0]),
+            XMVectorSubtract(columns.r[3], columns.r[0]),
+            XMVectorAdd(columns.r[3], columns.r[1]),
+            XMVectorSubtract(columns.r[3], columns.r[1]),
+            columns.r[2],
+            XMVectorSubtract(columns.r[3], columns.r[2]),
+        };
+
+        for (UINT uPlane = 0u; uPlane < NUM_PLANES; ++uPlane)
+        {
+            XMStoreFloat4(&aOutPlanes[uPlane], XMPlaneNormalize(aPlanes[uPlane]));
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::FrustumCuller
+
+      Summary:  Constructor
+
+      Modifies: [m_uNumBoxes, m_aComponents, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FrustumCuller::FrustumCuller()
+        : m_uNumBoxes(0u)
+        , m_aComponents()
+        , m_statistics()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::Add
+
+      Summary:  Adds a box to test, its index is the number of boxes
+                added before it
+
+      Args:     const AxisAlignedBox& box
+                  World space box
+
+      Modifies: [m_uNumBoxes, m_aComponents].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void FrustumCuller::Add(_In_ const AxisAlignedBox& box)
+    {
+        // Drop the padding of the last Cull before appending
+        for (std::vector<FLOAT>& aComponent : m_aComponents)
+        {
+            aComponent.resize(m_uNumBoxes);
+        }
+
+        m_aComponents[CENTER_X].push_back(box.Center.x);
+        m_aComponents[CENTER_Y].push_back(box.Center.y);
+        m_aComponents[CENTER_Z].push_back(box.Center.z);
+        m_aComponents[EXTENTS_X].push_back(box.Extents.x);
+        m_aComponents[EXTENTS_Y].push_back(box.Extents.y);
+        m_aComponents[EXTENTS_Z].push_back(box.Extents.z);
+        ++m_uNumBoxes;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::AddUnbounded
+
+      Summary:  Adds a box that reaches past every plane, for the draws
+                whose vertices are not known on the CPU
+
+      Modifies: [m_uNumBoxes, m_aComponents].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void FrustumCuller::AddUnbounded()
+    {
+        Add(
+            AxisAlignedBox
+            {
+                .Center = XMFLOAT3(0.0f, 0.0f, 0.0f),
+                .Extents = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX)
+            }
+        );
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::Clear
+
+      Summary:  Removes the boxes, the memory is kept for the next frame
+
+      Modifies: [m_uNumBoxes, m_aComponents].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void FrustumCuller::Clear()
+    {
+        for (std::vector<FLOAT>& aComponent : m_aComponents)
+        {
+            aComponent.clear();
+        }
+        m_uNumBoxes = 0u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::Cull
+
+      Summary:  Tests every box against the planes of the frustum, 8
+                boxes per iteration with AVX2 and 4 with SSE
+
+      Args:     FXMMATRIX viewProjection
+                  View matrix times the projection matrix
+                std::vector<BOOL>& aOutVisible
+                  FALSE for every box outside of the frustum, resized to
+                  the number of boxes
+
+      Modifies: [m_aComponents, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void FrustumCuller::Cull(_In_ FXMMATRIX viewProjection, _Out_ std::vector<BOOL>& aOutVisible)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        XMFLOAT4 aPlanes[NUM_PLANES];
+        ExtractPlanes(viewProjection, aPlanes);
+
+        // Pad with empty boxes so that the last iteration reads and writes a whole register
+        UINT uNumPadded = (m_uNumBoxes + SSE_WIDTH - 1u) / SSE_WIDTH * SSE_WIDTH;
+        for (std::vector<FLOAT>& aComponent : m_aComponents)
+        {
+            aComponent.resize(uNumPadded, 0.0f);
+        }
+        aOutVisible.resize(uNumPadded);
+
+        UINT uNumDone = 0u;
+        if (IsAvx2Supported())
+        {
+            uNumDone = cullAvx2(aPlanes, 0u, uNumPadded, aOutVisible.data());
+        }
+        cullSse(aPlanes, uNumDone, uNumPadded - uNumDone, aOutVisible.data() + uNumDone);
+
+        aOutVisible.resize(m_uNumBoxes);
+
+        m_statistics.uNumTestedBoxes = m_uNumBoxes;
+        m_statistics.uNumCulledBoxes = static_cast<UINT>(std::count(aOutVisible.begin(), aOutVisible.end(), FALSE));
+        m_statistics.cullTime = std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::GetNumBoxes
+
+      Summary:  Returns the number of boxes added since the last Clear
+
+      Returns:  UINT
+                  Number of boxes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT FrustumCuller::GetNumBoxes() const
+    {
+        return m_uNumBoxes;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::GetStatistics
+
+      Summary:  Returns the counters of the last Cull
+
+      Returns:  const Statistics&
+                  Tested and culled boxes and the time of the test
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const FrustumCuller::Statistics& FrustumCuller::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::cullSse
+
+      Summary:  Tests the boxes 4 at a time with SSE
+
+      Args:     const XMFLOAT4* aPlanes
+                  Planes of the frustum
+                UINT uFirstBox
+                  Index of the first box to test
+                UINT uNumBoxes
+                  Number of boxes to test
+                BOOL* pOutVisible
+                  Result of the first box to test
+
+      Returns:  UINT
+                  Number of boxes tested, a multiple of 4
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT FrustumCuller::cullSse(_In_reads_(NUM_PLANES) const XMFLOAT4* aPlanes, _In_ UINT uFirstBox, _In_ UINT uNumBoxes, _Out_writes_(uNumBoxes) BOOL* pOutVisible) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        __m128 aNormalsX[NUM_PLANES];
+        __m128 aNormalsY[NUM_PLANES];
+        __m128 aNormalsZ[NUM_PLANES];
+        __m128 aDistances[NUM_PLANES];
+        for (UINT uPlane = 0u; uPlane < NUM_PLANES; ++uPlane)
+        {
+            aNormalsX[uPlane] = _mm_set1_ps(aPlanes[uPlane].x);
+            aNormalsY[uPlane] = _mm_set1_ps(aPlanes[uPlane].y);
+            aNormalsZ[uPlane] = _mm_set1_ps(aPlanes[uPlane].z);
+            aDistances[uPlane] = _mm_set1_ps(aPlanes[uPlane].w);
+        }
+
+        const FLOAT* pCentersX = m_aComponents[CENTER_X].data() + uFirstBox;
+        const FLOAT* pCentersY = m_aComponents[CENTER_Y].data() + uFirstBox;
+        const FLOAT* pCentersZ = m_aComponents[CENTER_Z].data() + uFirstBox;
+        const FLOAT* pExtentsX = m_aComponents[EXTENTS_X].data() + uFirstBox;
+        const FLOAT* pExtentsY = m_aComponents[EXTENTS_Y].data() + uFirstBox;
+        const FLOAT* pExtentsZ = m_aComponents[EXTENTS_Z].data() + uFirstBox;
+
+        UINT uBoxIdx = 0u;
+        for (; uBoxIdx + SSE_WIDTH <= uNumBoxes; uBoxIdx += SSE_WIDTH)
+        {
+            __m128 centerX = _mm_loadu_ps(pCentersX + uBoxIdx);
+            __m128 centerY = _mm_loadu_ps(pCentersY + uBoxIdx);
+            __m128 centerZ = _mm_loadu_ps(pCentersZ + uBoxIdx);
+            __m128 extentsX = _mm_loadu_ps(pExtentsX + uBoxIdx);
+            __m128 extentsY = _mm_loadu_ps(pExtentsY + uBoxIdx);
+            __m128 extentsZ = _mm_loadu_ps(pExtentsZ + uBoxIdx);
+
+            __m128 outside = zero;
+            for (UINT uPlane = 0u; uPlane < NUM_PLANES; ++uPlane)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(centerX, aNormalsX[uPlane]), aDistances[uPlane]);
+                distance = _mm_add_ps(_mm_mul_ps(centerY, aNormalsY[uPlane]), distance);
+                distance = _mm_add_ps(_mm_mul_ps(centerZ, aNormalsZ[uPlane]), distance);
+
+                __m128 radius = _mm_mul_ps(extentsX, _mm_andnot_ps(signMask, aNormalsX[uPlane]));
+                radius = _mm_add_ps(_mm_mul_ps(extentsY, _mm_andnot_ps(signMask, aNormalsY[uPlane])), radius);
+                radius = _mm_add_ps(_mm_mul_ps(extentsZ, _mm_andnot_ps(signMask, aNormalsZ[uPlane])), radius);
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            __m128i visible = _mm_andnot_si128(_mm_castps_si128(outside), one);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutVisible + uBoxIdx), visible);
+        }
+
+        return uBoxIdx;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   FrustumCuller::cullAvx2
+
+      Summary:  Tests the boxes 8 at a time with AVX2, only called when
+                IsAvx2Supported
+
+      Args:     const XMFLOAT4* aPlanes
+                  Planes of the frustum
+                UINT uFirstBox
+                  Index of the first box to test
+                UINT uNumBoxes
+                  Number of boxes to test
+                BOOL* pOutVisible
+                  Result of the first box to test
+
+      Returns:  UINT
+                  Number of boxes tested, a multiple of 8
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT FrustumCuller::cullAvx2(_In_reads_(NUM_PLANES) const XMFLOAT4* aPlanes, _In_ UINT uFirstBox, _In_ UINT uNumBoxes, _Out_writes_(uNumBoxes) BOOL* pOutVisible) const
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+        __m256 aNormalsX[NUM_PLANES];
+        __m256 aNormalsY[NUM_PLANES];
+        __m256 aNormalsZ[NUM_PLANES];
+        __m256 aDistances[NUM_PLANES];
+        for (UINT uPlane = 0u; uPlane < NUM_PLANES; ++uPlane)
+        {
+            aNormalsX[uPlane] = _mm256_set1_ps(aPlanes[uPlane].x);
+            aNormalsY[uPlane] = _mm256_set1_ps(aPlanes[uPlane].y);
+            aNormalsZ[uPlane] = _mm256_set1_ps(aPlanes[uPlane].z);
+            aDistances[uPlane] = _mm256_set1_ps(aPlanes[uPlane].w);
+        }
+
+        const FLOAT* pCentersX = m_aComponents[CENTER_X].data() + uFirstBox;
+        const FLOAT* pCentersY = m_aComponents[CENTER_Y].data() + uFirstBox;
+        const FLOAT* pCentersZ = m_aComponents[CENTER_Z].data() + uFirstBox;
+        const FLOAT* pExtentsX = m_aComponents[EXTENTS_X].data() + uFirstBox;
+        const FLOAT* pExtentsY = m_aComponents[EXTENTS_Y].data() + uFirstBox;
+        const FLOAT* pExtentsZ = m_aComponents[EXTENTS_Z].data() + uFirstBox;
+
+        UINT uBoxIdx = 0u;
+        for (; uBoxIdx + AVX2_WIDTH <= uNumBoxes; uBoxIdx += AVX2_WIDTH)
+        {
+            __m256 centerX = _mm256_loadu_ps(pCentersX + uBoxIdx);
+            __m256 centerY = _mm256_loadu_ps(pCentersY + uBoxIdx);
+            __m256 centerZ = _mm256_loadu_ps(pCentersZ + uBoxIdx);
+            __m256 extentsX = _mm256_loadu_ps(pExtentsX + uBoxIdx);
+            __m256 extentsY = _mm256_loadu_ps(pExtentsY + uBoxIdx);
+            __m256 extentsZ = _mm256_loadu_ps(pExtentsZ + uBoxIdx);
+
+            __m256 outside = zero;
+            for (UINT uPlane = 0u; uPlane < NUM_PLANES; ++uPlane)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(centerX, aNormalsX[uPlane]), aDistances[uPlane]);
+                distance = _mm256_add_ps(_mm256_mul_ps(centerY, aNormalsY[uPlane]), distance);
+                distance = _mm256_add_ps(_mm256_mul_ps(centerZ, aNormalsZ[uPlane]), distance);
+
+                __m256 radius = _mm256_mul_ps(extentsX, _mm256_andnot_ps(signMask, aNormalsX[uPlane]));
+                radius = _mm256_add_ps(_mm256_mul_ps(extentsY, _mm256_andnot_ps(signMask, aNormalsY[uPlane])), radius);
+                radius = _mm256_add_ps(_mm256_mul_ps(extentsZ, _mm256_andnot_ps(signMask, aNormalsZ[uPlane])), radius);
+
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+
+            __m256i visible = _mm256_andnot_si256(_mm256_castps_si256(outside), one);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pOutVisible + uBoxIdx), visible);
+        }
+
+        return uBoxIdx;
+    }
+}
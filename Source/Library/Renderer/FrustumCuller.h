@@ -0,0 +1,122 @@
+/*+===================================================================
+  File:      FRUSTUMCULLER.H
+
+  Summary:   FrustumCuller header file contains declarations of the
+             FrustumCuller class that rejects the bounding boxes outside
+             of the view frustum.
+
+  Classes: FrustumCuller
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    FrustumCuller
+
+      Summary:  Tests world space boxes against the six planes of a view
+                frustum.
+
+                The boxes are kept as separate arrays of their center and
+                extent components, so a test loads the same component of
+                4 boxes into an SSE register, or of 8 boxes into an AVX2
+                register when the CPU supports it, and a loop iteration
+                tests all of them against a plane. A box is outside when
+                its center is farther behind a plane than the projection
+                of its extents onto the plane normal. The test is
+                conservative: a box near a corner of the frustum may
+                pass while none of it is inside.
+
+                The planes are extracted from the view projection matrix
+                and normalized, they point into the frustum.
+
+      Methods:  ExtractPlanes
+                  Returns the planes of a view frustum
+                Add
+                  Adds a box to test
+                AddUnbounded
+                  Adds a box that is never culled
+                Clear
+                  Removes the boxes
+                Cull
+                  Marks the boxes that intersect the frustum
+                GetNumBoxes
+                  Returns the number of boxes
+                GetStatistics
+                  Returns the counters of the last Cull
+                FrustumCuller
+                  Constructor.
+                ~FrustumCuller
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class FrustumCuller final
+    {
+    public:
+        static constexpr const UINT NUM_PLANES = 6u;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Statistics
+
+            Summary:  Counters of the last Cull, the time is in
+                      milliseconds
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Statistics
+        {
+            UINT uNumTestedBoxes;
+            UINT uNumCulledBoxes;
+            FLOAT cullTime;
+        };
+
+    public:
+        static void ExtractPlanes(_In_ FXMMATRIX viewProjection, _Out_writes_(NUM_PLANES) XMFLOAT4* aOutPlanes);
+
+        FrustumCuller();
+        FrustumCuller(const FrustumCuller& other) = delete;
+        FrustumCuller(FrustumCuller&& other) = delete;
+        FrustumCuller& operator=(const FrustumCuller& other) = delete;
+        FrustumCuller& operator=(FrustumCuller&& other) = delete;
+        ~FrustumCuller() = default;
+
+        void Add(_In_ const AxisAlignedBox& box);
+        void AddUnbounded();
+        void Clear();
+        void Cull(_In_ FXMMATRIX viewProjection, _Out_ std::vector<BOOL>& aOutVisible);
+        UINT GetNumBoxes() const;
+        const Statistics& GetStatistics() const;
+
+    private:
+        /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+            Enum:     eBoxComponent
+
+            Summary:  Enumeration of the component arrays of the boxes
+        E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+        enum eBoxComponent : UINT
+        {
+            CENTER_X,
+            CENTER_Y,
+            CENTER_Z,
+            EXTENTS_X,
+            EXTENTS_Y,
+            EXTENTS_Z,
+            NUM_BOX_COMPONENTS,
+        };
+
+        static constexpr const UINT SSE_WIDTH = 4u;
+        static constexpr const UINT AVX2_WIDTH = 8u;
+
+        UINT cullSse(_In_reads_(NUM_PLANES) const XMFLOAT4* aPlanes, _In_ UINT uFirstBox, _In_ UINT uNumBoxes, _Out_writes_(uNumBoxes) BOOL* pOutVisible) const;
+        UINT cullAvx2(_In_reads_(NUM_PLANES) const XMFLOAT4* aPlanes, _In_ UINT uFirstBox, _In_ UINT uNumBoxes, _Out_writes_(uNumBoxes) BOOL* pOutVisible) const;
+
+    private:
+        UINT m_uNumBoxes;
+        // One array per eBoxComponent, padded with empty boxes to a multiple of SSE_WIDTH by Cull
+        std::vector<FLOAT> m_aComponents[NUM_BOX_COMPONENTS];
+        Statistics m_statistics;
+    };
+}
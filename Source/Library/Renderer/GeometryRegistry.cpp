@@ -0,0 +1,236 @@
+#include "Renderer/GeometryRegistry.h"
+
+#include <cstring>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::GeometryRegistry
+
+      Summary:  Constructor
+
+      Args:     HashFunction pfnHash
+                  Hash of the geometries, nullptr for the FNV-1a hash
+
+      Modifies: [m_entries, m_statistics, m_pfnHash].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    GeometryRegistry::GeometryRegistry(_In_opt_ HashFunction pfnHash)
+        : m_entries()
+        , m_statistics()
+        , m_pfnHash(pfnHash ? pfnHash : getHash)
+    { }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::Add
+
+      Summary:  Creates the immutable vertex, normal and index buffers
+                of a geometry and registers them under the hash of the
+                vertices and indices. Call Find first, adding the same
+                geometry twice registers two copies.
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers, the same
+                  for every geometry of the registry
+                const SimpleVertex* aVertices
+                  Vertices of the geometry
+                UINT uNumVertices
+                  Number of vertices
+                const WORD* aIndices
+                  Indices of the geometry
+                UINT uNumIndices
+                  Number of indices
+                const NormalData* aNormalData
+                  Tangent and bitangent of every vertex
+                Geometry& outGeometry
+                  Buffers of the geometry
+
+      Modifies: [m_entries, m_statistics].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT GeometryRegistry::Add(
+        _In_ ID3D11Device* pDevice,
+        _In_reads_(uNumVertices) const SimpleVertex* aVertices,
+        _In_ UINT uNumVertices,
+        _In_reads_(uNumIndices) const WORD* aIndices,
+        _In_ UINT uNumIndices,
+        _In_reads_(uNumVertices) const NormalData* aNormalData,
+        _Out_ Geometry& outGeometry
+    )
+    {
+        outGeometry = Geometry();
+        if (uNumVertices == 0u || uNumIndices == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        Geometry geometry;
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(SimpleVertex) * uNumVertices,
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = 0
+        };
+
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = aVertices
+        };
+
+        HRESULT hr = pDevice->CreateBuffer(&bd, &initData, geometry.VertexBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(NormalData) * uNumVertices;
+        initData.pSysMem = aNormalData;
+
+        hr = pDevice->CreateBuffer(&bd, &initData, geometry.NormalBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(WORD) * uNumIndices;
+        bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        initData.pSysMem = aIndices;
+
+        hr = pDevice->CreateBuffer(&bd, &initData, geometry.IndexBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_entries.emplace(
+            m_pfnHash(aVertices, uNumVertices, aIndices, uNumIndices),
+            Entry
+            {
+                .aVertices = std::vector<SimpleVertex>(aVertices, aVertices + uNumVertices),
+                .aIndices = std::vector<WORD>(aIndices, aIndices + uNumIndices),
+                .Buffers = geometry
+            }
+        );
+        ++m_statistics.uNumGeometries;
+        m_statistics.uNumBufferBytes += (sizeof(SimpleVertex) + sizeof(NormalData)) * static_cast<UINT64>(uNumVertices) + sizeof(WORD) * static_cast<UINT64>(uNumIndices);
+
+        outGeometry = geometry;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::Clear
+
+      Summary:  Releases the buffers of every geometry and resets the
+                counters. Called before the device is released, the
+                renderables that still hold the buffers keep them alive.
+
+      Modifies: [m_entries, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void GeometryRegistry::Clear()
+    {
+        m_entries.clear();
+        m_statistics = Statistics();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::Find
+
+      Summary:  Returns the buffers of a geometry added before with the
+                same vertices and indices
+
+      Args:     const SimpleVertex* aVertices
+                  Vertices of the geometry
+                UINT uNumVertices
+                  Number of vertices
+                const WORD* aIndices
+                  Indices of the geometry
+                UINT uNumIndices
+                  Number of indices
+                Geometry& outGeometry
+                  Buffers of the geometry, empty if it was not found
+
+      Modifies: [m_statistics].
+
+      Returns:  BOOL
+                  TRUE if the geometry was found
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL GeometryRegistry::Find(
+        _In_reads_(uNumVertices) const SimpleVertex* aVertices,
+        _In_ UINT uNumVertices,
+        _In_reads_(uNumIndices) const WORD* aIndices,
+        _In_ UINT uNumIndices,
+        _Out_ Geometry& outGeometry
+    )
+    {
+        outGeometry = Geometry();
+
+        auto range = m_entries.equal_range(m_pfnHash(aVertices, uNumVertices, aIndices, uNumIndices));
+        for (auto entryElem = range.first; entryElem != range.second; ++entryElem)
+        {
+            const Entry& entry = entryElem->second;
+            if (entry.aVertices.size() == uNumVertices
+                && entry.aIndices.size() == uNumIndices
+                && memcmp(entry.aVertices.data(), aVertices, sizeof(SimpleVertex) * uNumVertices) == 0
+                && memcmp(entry.aIndices.data(), aIndices, sizeof(WORD) * uNumIndices) == 0)
+            {
+                outGeometry = entry.Buffers;
+                ++m_statistics.uNumSharedFinds;
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::GetStatistics
+
+      Summary:  Returns the counters of the registry
+
+      Returns:  const Statistics&
+                  Counters since the registry was created or cleared
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const GeometryRegistry::Statistics& GeometryRegistry::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   GeometryRegistry::getHash
+
+      Summary:  Returns the 64-bit FNV-1a hash of the bytes of the
+                vertices followed by the bytes of the indices
+
+      Args:     const SimpleVertex* aVertices
+                  Vertices of the geometry
+                UINT uNumVertices
+                  Number of vertices
+                const WORD* aIndices
+                  Indices of the geometry
+                UINT uNumIndices
+                  Number of indices
+
+      Returns:  UINT64
+                  Hash of the geometry
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 GeometryRegistry::getHash(_In_reads_(uNumVertices) const SimpleVertex* aVertices, _In_ UINT uNumVertices, _In_reads_(uNumIndices) const WORD* aIndices, _In_ UINT uNumIndices)
+    {
+        UINT64 uHash = 14695981039346656037ull;
+        auto hashBytes = [&uHash](const void* pData, size_t uNumBytes)
+        {
+            const BYTE* pBytes = static_cast<const BYTE*>(pData);
+            for (size_t i = 0u; i < uNumBytes; ++i)
+            {
+                uHash = (uHash ^ pBytes[i]) * 1099511628211ull;
+            }
+        };
+        hashBytes(aVertices, sizeof(SimpleVertex) * static_cast<size_t>(uNumVertices));
+        hashBytes(aIndices, sizeof(WORD) * static_cast<size_t>(uNumIndices));
+
+        return uHash;
+    }
+}
@@ -0,0 +1,135 @@
+/*+===================================================================
+  File:      GEOMETRYREGISTRY.H
+
+  Summary:   GeometryRegistry header file contains declarations of the
+             GeometryRegistry class that shares the buffers of
+             identical geometry between renderables.
+
+  Classes: GeometryRegistry
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    GeometryRegistry
+
+      Summary:  Table of immutable vertex, tangent and index buffers of
+                one device, keyed by the FNV-1a hash of the vertices and
+                indices they were created from. Renderables with the
+                same geometry, every cube or every voxel type, get the
+                same buffers, so their video memory and the tangents
+                computed for them no longer grow with their number.
+
+                Find returns the buffers of geometry that was added
+                before, the content is compared on a hash match, so a
+                collision only costs a second geometry. The buffers are
+                D3D11_USAGE_IMMUTABLE and stay alive with the registry
+                or until Clear. The registry is owned by the Renderer
+                next to the device the buffers were created on, handed
+                to the renderables by the scene that initializes them
+                and used from that thread only. A registry can be given
+                another hash, tests make geometries collide with it.
+
+      Methods:  Add
+                  Creates and registers the buffers of a geometry
+                Clear
+                  Releases the buffers of every geometry
+                Find
+                  Returns the buffers of a registered geometry
+                GetStatistics
+                  Returns the counters of the registry
+                GeometryRegistry
+                  Constructor.
+                ~GeometryRegistry
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class GeometryRegistry final
+    {
+    public:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Geometry
+
+            Summary:  Shared buffers of one geometry, the normal buffer
+                      holds the tangents and bitangents of the vertices
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Geometry
+        {
+            ComPtr<ID3D11Buffer> VertexBuffer;
+            ComPtr<ID3D11Buffer> NormalBuffer;
+            ComPtr<ID3D11Buffer> IndexBuffer;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Statistics
+
+            Summary:  Number of registered geometries, of the finds
+                      that returned one of them and of the bytes of
+                      their buffers
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Statistics
+        {
+            UINT uNumGeometries;
+            UINT uNumSharedFinds;
+            UINT64 uNumBufferBytes;
+        };
+
+        // Hash of the vertices and indices of a geometry
+        using HashFunction = UINT64 (*)(_In_reads_(uNumVertices) const SimpleVertex* aVertices, _In_ UINT uNumVertices, _In_reads_(uNumIndices) const WORD* aIndices, _In_ UINT uNumIndices);
+
+    public:
+        explicit GeometryRegistry(_In_opt_ HashFunction pfnHash = nullptr);
+        GeometryRegistry(const GeometryRegistry& other) = delete;
+        GeometryRegistry(GeometryRegistry&& other) = delete;
+        GeometryRegistry& operator=(const GeometryRegistry& other) = delete;
+        GeometryRegistry& operator=(GeometryRegistry&& other) = delete;
+        ~GeometryRegistry() = default;
+
+        HRESULT Add(
+            _In_ ID3D11Device* pDevice,
+            _In_reads_(uNumVertices) const SimpleVertex* aVertices,
+            _In_ UINT uNumVertices,
+            _In_reads_(uNumIndices) const WORD* aIndices,
+            _In_ UINT uNumIndices,
+            _In_reads_(uNumVertices) const NormalData* aNormalData,
+            _Out_ Geometry& outGeometry
+        );
+        void Clear();
+        BOOL Find(
+            _In_reads_(uNumVertices) const SimpleVertex* aVertices,
+            _In_ UINT uNumVertices,
+            _In_reads_(uNumIndices) const WORD* aIndices,
+            _In_ UINT uNumIndices,
+            _Out_ Geometry& outGeometry
+        );
+        const Statistics& GetStatistics() const;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Entry
+
+            Summary:  Registered geometry with the content it was
+                      created from, to tell apart geometries whose
+                      hashes collide
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Entry
+        {
+            std::vector<SimpleVertex> aVertices;
+            std::vector<WORD> aIndices;
+            Geometry Buffers;
+        };
+
+        static UINT64 getHash(_In_reads_(uNumVertices) const SimpleVertex* aVertices, _In_ UINT uNumVertices, _In_reads_(uNumIndices) const WORD* aIndices, _In_ UINT uNumIndices);
+
+    private:
+        std::unordered_multimap<UINT64, Entry> m_entries;
+        Statistics m_statistics;
+        HashFunction m_pfnHash;
+    };
+}
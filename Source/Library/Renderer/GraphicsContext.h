@@ -0,0 +1,135 @@
+/*+===================================================================
+  File:      GRAPHICSCONTEXT.H
+
+  Summary:   GraphicsContext header file contains declarations of the
+             GraphicsContext interface that the frame code of the
+             renderer binds state and draws through.
+
+  Classes: GraphicsContext
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    GraphicsContext
+
+      Summary:  Thin interface over the device context calls that the
+                renderer makes every frame. The methods take the same
+                arguments as their ID3D11DeviceContext counterparts,
+                except UpdateBuffer, which replaces UpdateSubresource
+                of whole buffers and passes the number of bytes, and
+                MapBuffer and UnmapBuffer, which replace Map and Unmap
+                of whole buffers for writing. MapBuffer passes the
+                number of bytes that will be written too.
+
+                CreateBuffer creates a buffer of the device of the
+                context, so the renderer can create its frame buffers
+                without a device. CreateDeferredContext creates a
+                context that records
+                calls on another thread. FinishCommandList closes what a
+                deferred context recorded, and ExecuteCommandList of the
+                context that created it runs the calls in order. The
+                state of the executing context is then cleared, like
+                ExecuteCommandList with RestoreContextState FALSE.
+
+                D3D11GraphicsContext forwards to a device context,
+                RecordingGraphicsContext logs the calls, so the frame
+                code runs the same against a GPU or headless.
+
+      Methods:  ClearDepthStencilView
+                  Clears a depth stencil view
+                ClearRenderTargetView
+                  Clears a render target view
+                CreateBuffer
+                  Creates a buffer
+                CreateDeferredContext
+                  Creates a context that records calls for this one
+                DrawIndexed
+                  Draws indexed primitives
+                DrawIndexedInstanced
+                  Draws instances of indexed primitives
+                ExecuteCommandList
+                  Runs the calls of a finished deferred context
+                FinishCommandList
+                  Closes the calls a deferred context recorded
+                IASetIndexBuffer
+                  Binds the index buffer
+                IASetInputLayout
+                  Binds the input layout
+                IASetPrimitiveTopology
+                  Sets the primitive topology
+                IASetVertexBuffers
+                  Binds vertex buffers
+                MapBuffer
+                  Maps a buffer for writing
+                OMSetRenderTargets
+                  Binds render targets and a depth stencil view
+                PSSetConstantBuffers
+                  Binds constant buffers of the pixel shader stage
+                PSSetConstantBuffers1
+                  Binds ranges of constant buffers of the pixel shader
+                  stage
+                PSSetSamplers
+                  Binds samplers of the pixel shader stage
+                PSSetShader
+                  Binds the pixel shader
+                PSSetShaderResources
+                  Binds shader resources of the pixel shader stage
+                RSSetViewports
+                  Sets the viewports
+                UnmapBuffer
+                  Unmaps a mapped buffer
+                UpdateBuffer
+                  Replaces the contents of a buffer
+                VSSetConstantBuffers
+                  Binds constant buffers of the vertex shader stage
+                VSSetConstantBuffers1
+                  Binds ranges of constant buffers of the vertex shader
+                  stage
+                VSSetShader
+                  Binds the vertex shader
+                ~GraphicsContext
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class GraphicsContext
+    {
+    public:
+        GraphicsContext() = default;
+        GraphicsContext(const GraphicsContext& other) = delete;
+        GraphicsContext(GraphicsContext&& other) = delete;
+        GraphicsContext& operator=(const GraphicsContext& other) = delete;
+        GraphicsContext& operator=(GraphicsContext&& other) = delete;
+        virtual ~GraphicsContext() = default;
+
+        virtual void ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil) = 0;
+        virtual void ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4]) = 0;
+        virtual HRESULT CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer) = 0;
+        virtual HRESULT CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext) = 0;
+        virtual void DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation) = 0;
+        virtual void DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation) = 0;
+        virtual void ExecuteCommandList(_In_ GraphicsContext& deferredContext) = 0;
+        virtual HRESULT FinishCommandList() = 0;
+        virtual void IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset) = 0;
+        virtual void IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout) = 0;
+        virtual void IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+        virtual void IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets) = 0;
+        virtual HRESULT MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData) = 0;
+        virtual void OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView) = 0;
+        virtual void PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) = 0;
+        virtual void PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) = 0;
+        virtual void PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers) = 0;
+        virtual void PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) = 0;
+        virtual void PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews) = 0;
+        virtual void RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports) = 0;
+        virtual void UnmapBuffer(_In_ ID3D11Buffer* pBuffer) = 0;
+        virtual void UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes) = 0;
+        virtual void VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) = 0;
+        virtual void VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) = 0;
+        virtual void VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) = 0;
+    };
+}
@@ -97,6 +97,33 @@ namespace library
         return static_cast<UINT>(m_aInstanceData.size());
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   InstancedRenderable::GetInstanceStride
+
+      Summary:  Returns the size of one instance in the instance buffer
+
+      Returns:  UINT
+                  Stride of the instance buffer in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT InstancedRenderable::GetInstanceStride() const
+    {
+        return sizeof(InstanceData);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   InstancedRenderable::getInstanceData
+
+      Summary:  Returns the pointer to the instance data
+
+      Returns:  const void*
+                  Pointer to GetNumInstances() instances of
+                  GetInstanceStride() bytes each
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* InstancedRenderable::getInstanceData() const
+    {
+        return m_aInstanceData.data();
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   InstancedRenderable::initializeInstance
 
@@ -120,7 +147,7 @@ namespace library
 
         D3D11_BUFFER_DESC bd =
         {
-            .ByteWidth = static_cast<UINT>(sizeof(InstanceData) * m_aInstanceData.size()),
+            .ByteWidth = GetInstanceStride() * GetNumInstances(),
             .Usage = D3D11_USAGE_DEFAULT,
             .BindFlags = D3D11_BIND_VERTEX_BUFFER,
             .CPUAccessFlags = 0
@@ -128,7 +155,7 @@ namespace library
 
         D3D11_SUBRESOURCE_DATA initData =
         {
-            .pSysMem = m_aInstanceData.data()
+            .pSysMem = getInstanceData()
         };
 
         hr = pDevice->CreateBuffer(&bd, &initData, m_instanceBuffer.GetAddressOf());
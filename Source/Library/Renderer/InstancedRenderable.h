@@ -29,6 +29,10 @@ namespace library
                   Returns a instance buffer
                 GetNumInstances
                   Returns the number of instance data
+                GetInstanceStride
+                  Returns the size of one instance in bytes
+                getInstanceData
+                  Returns the pointer to the instance data
                 initializeInstance
                   Initialize the instance buffer
                 InstancedRenderable
@@ -47,13 +51,14 @@ namespace library
         InstancedRenderable& operator=(InstancedRenderable&& other) = delete;
         ~InstancedRenderable() = default;
 
-        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override = 0;
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry) override = 0;
         virtual void Update(_In_ FLOAT deltaTime) override = 0;
 
         void SetInstanceData(_In_ std::vector<InstanceData>&& aInstanceData);
 
         virtual ComPtr<ID3D11Buffer>& GetInstanceBuffer();
         virtual UINT GetNumInstances() const;
+        virtual UINT GetInstanceStride() const;
 
         UINT GetNumVertices() const override = 0;
         UINT GetNumIndices() const override = 0;
@@ -62,6 +67,7 @@ namespace library
         const SimpleVertex* getVertices() const override = 0;
         const WORD* getIndices() const override = 0;
 
+        virtual const void* getInstanceData() const;
         virtual HRESULT initializeInstance(_In_ ID3D11Device* pDevice);
 
     protected:
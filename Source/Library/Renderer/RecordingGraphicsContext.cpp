@@ -0,0 +1,1132 @@
+#include "Renderer/RecordingGraphicsContext.h"
+
+#include <atomic>
+
+namespace library
+{
+    namespace
+    {
+        /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+          Class:    RecordedBuffer
+
+          Summary:  Stand-in for a buffer created without a next
+                    context. It only counts its references and returns
+                    its description, the recording context never
+                    dereferences the buffers it is given.
+        C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+        class RecordedBuffer final : public ID3D11Buffer
+        {
+        public:
+            explicit RecordedBuffer(_In_ const D3D11_BUFFER_DESC& desc)
+                : m_uNumReferences(1u)
+                , m_desc(desc)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE QueryInterface(_In_ REFIID riid, _Outptr_ void** ppvObject) override
+            {
+                UNREFERENCED_PARAMETER(riid);
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            ULONG STDMETHODCALLTYPE AddRef() override
+            {
+                return ++m_uNumReferences;
+            }
+
+            ULONG STDMETHODCALLTYPE Release() override
+            {
+                ULONG uNumReferences = --m_uNumReferences;
+                if (uNumReferences == 0u)
+                {
+                    delete this;
+                }
+                return uNumReferences;
+            }
+
+            void STDMETHODCALLTYPE GetDevice(_Outptr_ ID3D11Device** ppDevice) override
+            {
+                *ppDevice = nullptr;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetPrivateData(_In_ REFGUID guid, _Inout_ UINT* pDataSize, _Out_writes_bytes_opt_(*pDataSize) void* pData) override
+            {
+                UNREFERENCED_PARAMETER(guid);
+                UNREFERENCED_PARAMETER(pData);
+                *pDataSize = 0u;
+                return E_NOTIMPL;
+            }
+
+            HRESULT STDMETHODCALLTYPE SetPrivateData(_In_ REFGUID guid, _In_ UINT uDataSize, _In_reads_bytes_opt_(uDataSize) const void* pData) override
+            {
+                UNREFERENCED_PARAMETER(guid);
+                UNREFERENCED_PARAMETER(uDataSize);
+                UNREFERENCED_PARAMETER(pData);
+                return E_NOTIMPL;
+            }
+
+            HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(_In_ REFGUID guid, _In_opt_ const IUnknown* pData) override
+            {
+                UNREFERENCED_PARAMETER(guid);
+                UNREFERENCED_PARAMETER(pData);
+                return E_NOTIMPL;
+            }
+
+            void STDMETHODCALLTYPE GetType(_Out_ D3D11_RESOURCE_DIMENSION* pResourceDimension) override
+            {
+                *pResourceDimension = D3D11_RESOURCE_DIMENSION_BUFFER;
+            }
+
+            void STDMETHODCALLTYPE SetEvictionPriority(_In_ UINT uEvictionPriority) override
+            {
+                UNREFERENCED_PARAMETER(uEvictionPriority);
+            }
+
+            UINT STDMETHODCALLTYPE GetEvictionPriority() override
+            {
+                return 0u;
+            }
+
+            void STDMETHODCALLTYPE GetDesc(_Out_ D3D11_BUFFER_DESC* pDesc) override
+            {
+                *pDesc = m_desc;
+            }
+
+        private:
+            std::atomic<ULONG> m_uNumReferences;
+            D3D11_BUFFER_DESC m_desc;
+        };
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::IsStateChange
+
+      Summary:  Returns whether a command binds or sets pipeline state
+
+      Args:     eGraphicsCommand command
+                  Recorded call
+
+      Returns:  BOOL
+                  TRUE for the IA, OM, RS, PS and VS calls
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL RecordingGraphicsContext::IsStateChange(_In_ eGraphicsCommand command)
+    {
+        switch (command)
+        {
+        case eGraphicsCommand::CLEAR_DEPTH_STENCIL_VIEW:
+        case eGraphicsCommand::CLEAR_RENDER_TARGET_VIEW:
+        case eGraphicsCommand::DRAW_INDEXED:
+        case eGraphicsCommand::DRAW_INDEXED_INSTANCED:
+        case eGraphicsCommand::EXECUTE_COMMAND_LIST:
+        case eGraphicsCommand::MAP_BUFFER:
+        case eGraphicsCommand::UNMAP_BUFFER:
+        case eGraphicsCommand::UPDATE_BUFFER:
+        case eGraphicsCommand::COUNT:
+            return FALSE;
+        default:
+            return TRUE;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::RecordingGraphicsContext
+
+      Summary:  Constructor
+
+      Args:     const std::shared_ptr<GraphicsContext>& next
+                  Context to forward the calls to, the calls are only
+                  recorded if nullptr
+
+      Modifies: [m_next, m_aCommands, m_aObjects, m_counters,
+                 m_mappedMemory, m_uNumFinishedCommands,
+                 m_uNumFinishedObjects, m_uNumDeferredContexts,
+                 m_uFailingDeferredContext, m_failingFinishResult,
+                 m_finishResult].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    RecordingGraphicsContext::RecordingGraphicsContext(_In_opt_ const std::shared_ptr<GraphicsContext>& next)
+        : m_next(next)
+        , m_aCommands()
+        , m_aObjects()
+        , m_counters()
+        , m_mappedMemory()
+        , m_uNumFinishedCommands(0u)
+        , m_uNumFinishedObjects(0u)
+        , m_uNumDeferredContexts(0u)
+        , m_uFailingDeferredContext(0u)
+        , m_failingFinishResult(S_OK)
+        , m_finishResult(S_OK)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::FailFinishCommandList
+
+      Summary:  Makes FinishCommandList of a deferred context this
+                context creates from now on return a failure and drop
+                the commands recorded since the last finish, like a
+                driver that cannot build the command list would
+
+      Args:     UINT uDeferredContextIdx
+                  Index of the deferred context in the order
+                  CreateDeferredContext creates them, counting the
+                  ones created before
+                HRESULT hr
+                  Status code FinishCommandList returns, S_OK for none
+
+      Modifies: [m_uFailingDeferredContext, m_failingFinishResult].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::FailFinishCommandList(_In_ UINT uDeferredContextIdx, _In_ HRESULT hr)
+    {
+        m_uFailingDeferredContext = uDeferredContextIdx;
+        m_failingFinishResult = hr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::GetCommands
+
+      Summary:  Returns the commands recorded since the last reset
+
+      Returns:  const std::vector<GraphicsCommand>&
+                  Commands in the order of the calls
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<GraphicsCommand>& RecordingGraphicsContext::GetCommands() const
+    {
+        return m_aCommands;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::GetCounters
+
+      Summary:  Returns the counters since the last reset
+
+      Returns:  const RecordingGraphicsContext::Counters&
+                  Counters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const RecordingGraphicsContext::Counters& RecordingGraphicsContext::GetCounters() const
+    {
+        return m_counters;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::GetMappedMemory
+
+      Summary:  Returns the memory that backs a buffer mapped without a
+                next context, with the bytes last written to it
+
+      Args:     const ID3D11Buffer* pBuffer
+                  Mapped buffer
+
+      Returns:  const BYTE*
+                  Memory of the buffer, nullptr if it was never mapped
+                  without a next context
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const BYTE* RecordingGraphicsContext::GetMappedMemory(_In_ const ID3D11Buffer* pBuffer) const
+    {
+        auto it = m_mappedMemory.find(pBuffer);
+        if (it == m_mappedMemory.end())
+        {
+            return nullptr;
+        }
+
+        return it->second.data();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::GetObjects
+
+      Summary:  Returns the objects of the recorded commands, see
+                GraphicsCommand
+
+      Returns:  const std::vector<const void*>&
+                  Objects
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<const void*>& RecordingGraphicsContext::GetObjects() const
+    {
+        return m_aObjects;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::HasSameDraws
+
+      Summary:  Replays this stream and a reference stream side by side
+                and compares their draws. Every draw of this stream has
+                to have the same command, indices and instances as the
+                draw of the reference stream at the same position, and
+                every slot this stream has bound for it has to hold the
+                same object with the same range in the reference stream,
+                a slot it never bound counts as nullptr. The slots only
+                the reference stream bound are not compared, since a
+                deferred context starts from a cleared state while one
+                context keeps the bindings of the earlier passes of a
+                frame. Executing a command list clears the state.
+
+      Args:     const RecordingGraphicsContext& reference
+                  Stream to compare with, typically the frame recorded
+                  on one context
+
+      Returns:  BOOL
+                  TRUE if both streams have the same draws in the same
+                  order
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL RecordingGraphicsContext::HasSameDraws(_In_ const RecordingGraphicsContext& reference) const
+    {
+        std::unordered_map<UINT64, BoundObject> boundObjects;
+        std::unordered_map<UINT64, BoundObject> referenceBoundObjects;
+        size_t uCommandIdx = 0u;
+        size_t uReferenceCommandIdx = 0u;
+        for (;;)
+        {
+            BOOL bDraw = replayToDraw(uCommandIdx, boundObjects);
+            BOOL bReferenceDraw = reference.replayToDraw(uReferenceCommandIdx, referenceBoundObjects);
+            if (!bDraw || !bReferenceDraw)
+            {
+                return bDraw == bReferenceDraw;
+            }
+
+            const GraphicsCommand& draw = m_aCommands[uCommandIdx];
+            const GraphicsCommand& referenceDraw = reference.m_aCommands[uReferenceCommandIdx];
+            if (draw.Command != referenceDraw.Command
+                || draw.uValue != referenceDraw.uValue
+                || draw.uNumInstances != referenceDraw.uNumInstances)
+            {
+                return FALSE;
+            }
+
+            for (const auto& [uKey, boundObject] : boundObjects)
+            {
+                auto it = referenceBoundObjects.find(uKey);
+                BoundObject referenceBoundObject = it != referenceBoundObjects.end() ? it->second : BoundObject{};
+                if (!(boundObject == referenceBoundObject))
+                {
+                    return FALSE;
+                }
+            }
+
+            ++uCommandIdx;
+            ++uReferenceCommandIdx;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::Reset
+
+      Summary:  Clears the commands and the counters, typically at the
+                start of a frame. The memory of the stream is kept.
+
+      Modifies: [m_aCommands, m_aObjects, m_counters,
+                 m_uNumFinishedCommands, m_uNumFinishedObjects].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::Reset()
+    {
+        m_aCommands.clear();
+        m_aObjects.clear();
+        m_counters = {};
+        m_uNumFinishedCommands = 0u;
+        m_uNumFinishedObjects = 0u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::ClearDepthStencilView
+
+      Summary:  Records the clear of a depth stencil view
+
+      Args:     ID3D11DepthStencilView* pDepthStencilView
+                  View to clear
+                UINT uClearFlags
+                  D3D11_CLEAR_FLAG bits
+                FLOAT depth
+                  Depth to clear to
+                UINT8 stencil
+                  Stencil to clear to
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil)
+    {
+        record(eGraphicsCommand::CLEAR_DEPTH_STENCIL_VIEW, 0u, &pDepthStencilView, 1u, uClearFlags);
+        if (m_next)
+        {
+            m_next->ClearDepthStencilView(pDepthStencilView, uClearFlags, depth, stencil);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::ClearRenderTargetView
+
+      Summary:  Records the clear of a render target view
+
+      Args:     ID3D11RenderTargetView* pRenderTargetView
+                  View to clear
+                const FLOAT aColorRGBA[4]
+                  Color to clear to
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4])
+    {
+        record(eGraphicsCommand::CLEAR_RENDER_TARGET_VIEW, 0u, &pRenderTargetView, 1u);
+        if (m_next)
+        {
+            m_next->ClearRenderTargetView(pRenderTargetView, aColorRGBA);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::CreateBuffer
+
+      Summary:  Creates a buffer of the next context, or a stand-in
+                buffer without a next context, so the renderer creates
+                its frame buffers headless. The call is not recorded.
+
+      Args:     const D3D11_BUFFER_DESC* pDesc
+                  Description of the buffer
+                ID3D11Buffer** ppBuffer
+                  Receives the buffer
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT RecordingGraphicsContext::CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer)
+    {
+        if (m_next)
+        {
+            return m_next->CreateBuffer(pDesc, ppBuffer);
+        }
+
+        *ppBuffer = new RecordedBuffer(*pDesc);
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::CreateDeferredContext
+
+      Summary:  Creates a recording deferred context, in front of a
+                deferred context of the next context if there is one,
+                which fails to finish if FailFinishCommandList chose it
+
+      Args:     std::shared_ptr<GraphicsContext>& outDeferredContext
+                  Receives the deferred context
+
+      Modifies: [m_uNumDeferredContexts].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT RecordingGraphicsContext::CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext)
+    {
+        outDeferredContext.reset();
+
+        std::shared_ptr<GraphicsContext> nextDeferredContext;
+        if (m_next)
+        {
+            HRESULT hr = m_next->CreateDeferredContext(nextDeferredContext);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        std::shared_ptr<RecordingGraphicsContext> deferredContext = std::make_shared<RecordingGraphicsContext>(nextDeferredContext);
+        if (m_uNumDeferredContexts == m_uFailingDeferredContext)
+        {
+            deferredContext->m_finishResult = m_failingFinishResult;
+        }
+        ++m_uNumDeferredContexts;
+
+        outDeferredContext = deferredContext;
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::DrawIndexed
+
+      Summary:  Records a draw of indexed primitives
+
+      Args:     UINT uIndexCount
+                  Number of indices
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation)
+    {
+        record<const void>(eGraphicsCommand::DRAW_INDEXED, 0u, nullptr, 0u, uIndexCount, 1u);
+        if (m_next)
+        {
+            m_next->DrawIndexed(uIndexCount, uStartIndexLocation, baseVertexLocation);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::DrawIndexedInstanced
+
+      Summary:  Records a draw of instances of indexed primitives
+
+      Args:     UINT uIndexCountPerInstance
+                  Number of indices of an instance
+                UINT uInstanceCount
+                  Number of instances
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+                UINT uStartInstanceLocation
+                  First instance
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation)
+    {
+        record<const void>(eGraphicsCommand::DRAW_INDEXED_INSTANCED, 0u, nullptr, 0u, uIndexCountPerInstance, uInstanceCount);
+        if (m_next)
+        {
+            m_next->DrawIndexedInstanced(uIndexCountPerInstance, uInstanceCount, uStartIndexLocation, baseVertexLocation, uStartInstanceLocation);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::ExecuteCommandList
+
+      Summary:  Moves the commands a deferred context had when it was
+                last finished to the end of this stream, counts them
+                and records a EXECUTE_COMMAND_LIST. The command list of
+                the next deferred context is executed on the next
+                context.
+
+      Args:     GraphicsContext& deferredContext
+                  RecordingGraphicsContext created by
+                  CreateDeferredContext of this context
+
+      Modifies: [m_aCommands, m_aObjects, m_counters, and the
+                 finished commands and objects of deferredContext].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::ExecuteCommandList(_In_ GraphicsContext& deferredContext)
+    {
+        RecordingGraphicsContext& recordingDeferredContext = static_cast<RecordingGraphicsContext&>(deferredContext);
+        std::vector<GraphicsCommand>& aDeferredCommands = recordingDeferredContext.m_aCommands;
+        std::vector<const void*>& aDeferredObjects = recordingDeferredContext.m_aObjects;
+        size_t uNumCommands = recordingDeferredContext.m_uNumFinishedCommands;
+        size_t uNumObjects = recordingDeferredContext.m_uNumFinishedObjects;
+
+        UINT uFirstObject = static_cast<UINT>(m_aObjects.size());
+        for (size_t uCommandIdx = 0u; uCommandIdx < uNumCommands; ++uCommandIdx)
+        {
+            GraphicsCommand command = aDeferredCommands[uCommandIdx];
+            command.uFirstObject += uFirstObject;
+            m_aCommands.push_back(command);
+            count(command);
+        }
+        m_aObjects.insert(m_aObjects.end(), aDeferredObjects.begin(), aDeferredObjects.begin() + uNumObjects);
+        record<const void>(eGraphicsCommand::EXECUTE_COMMAND_LIST, 0u, nullptr, 0u, static_cast<UINT>(uNumCommands));
+
+        // The commands recorded since the finish stay for the next command list
+        aDeferredCommands.erase(aDeferredCommands.begin(), aDeferredCommands.begin() + uNumCommands);
+        aDeferredObjects.erase(aDeferredObjects.begin(), aDeferredObjects.begin() + uNumObjects);
+        for (GraphicsCommand& command : aDeferredCommands)
+        {
+            command.uFirstObject -= static_cast<UINT>(uNumObjects);
+        }
+        recordingDeferredContext.m_uNumFinishedCommands = 0u;
+        recordingDeferredContext.m_uNumFinishedObjects = 0u;
+
+        if (m_next && recordingDeferredContext.m_next)
+        {
+            m_next->ExecuteCommandList(*recordingDeferredContext.m_next);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::FinishCommandList
+
+      Summary:  Marks the commands recorded so far as the command list
+                that the context that created this one executes, and
+                finishes the next context. A context made to fail drops
+                the commands recorded since the last finish instead.
+
+      Modifies: [m_aCommands, m_aObjects, m_uNumFinishedCommands,
+                 m_uNumFinishedObjects].
+
+      Returns:  HRESULT
+                  Status code of the next context, S_OK without one,
+                  or the one given to FailFinishCommandList
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT RecordingGraphicsContext::FinishCommandList()
+    {
+        if (m_next)
+        {
+            HRESULT hr = m_next->FinishCommandList();
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        if (FAILED(m_finishResult))
+        {
+            m_aCommands.resize(m_uNumFinishedCommands);
+            m_aObjects.resize(m_uNumFinishedObjects);
+            return m_finishResult;
+        }
+
+        m_uNumFinishedCommands = m_aCommands.size();
+        m_uNumFinishedObjects = m_aObjects.size();
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::IASetIndexBuffer
+
+      Summary:  Records the bind of the index buffer
+
+      Args:     ID3D11Buffer* pIndexBuffer
+                  Index buffer
+                DXGI_FORMAT format
+                  Format of the indices
+                UINT uOffset
+                  Offset of the first index in bytes
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset)
+    {
+        record(eGraphicsCommand::IA_SET_INDEX_BUFFER, 0u, &pIndexBuffer, 1u, static_cast<UINT>(format));
+        if (m_next)
+        {
+            m_next->IASetIndexBuffer(pIndexBuffer, format, uOffset);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::IASetInputLayout
+
+      Summary:  Records the bind of the input layout
+
+      Args:     ID3D11InputLayout* pInputLayout
+                  Input layout
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout)
+    {
+        record(eGraphicsCommand::IA_SET_INPUT_LAYOUT, 0u, &pInputLayout, 1u);
+        if (m_next)
+        {
+            m_next->IASetInputLayout(pInputLayout);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::IASetPrimitiveTopology
+
+      Summary:  Records the primitive topology
+
+      Args:     D3D11_PRIMITIVE_TOPOLOGY topology
+                  Primitive topology
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology)
+    {
+        record<const void>(eGraphicsCommand::IA_SET_PRIMITIVE_TOPOLOGY, 0u, nullptr, 0u, static_cast<UINT>(topology));
+        if (m_next)
+        {
+            m_next->IASetPrimitiveTopology(topology);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::IASetVertexBuffers
+
+      Summary:  Records the bind of vertex buffers
+
+      Args:     UINT uStartSlot
+                  First input slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppVertexBuffers
+                  Vertex buffers
+                const UINT* pStrides
+                  Stride of every buffer
+                const UINT* pOffsets
+                  Offset of every buffer
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets)
+    {
+        record(eGraphicsCommand::IA_SET_VERTEX_BUFFERS, uStartSlot, ppVertexBuffers, uNumBuffers);
+        if (m_next)
+        {
+            m_next->IASetVertexBuffers(uStartSlot, uNumBuffers, ppVertexBuffers, pStrides, pOffsets);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::MapBuffer
+
+      Summary:  Records the map of a buffer. Without a next context the
+                buffer is backed by memory of the context that grows to
+                the bytes to write, and keeps its contents between maps
+                like a D3D11_MAP_WRITE_NO_OVERWRITE map would.
+
+      Args:     ID3D11Buffer* pBuffer
+                  Buffer to map
+                D3D11_MAP mapType
+                  D3D11_MAP_WRITE_DISCARD or D3D11_MAP_WRITE_NO_OVERWRITE
+                UINT uNumBytes
+                  Number of bytes that will be written
+                void** ppData
+                  Receives the mapped memory
+
+      Modifies: [m_aCommands, m_aObjects, m_counters, m_mappedMemory].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT RecordingGraphicsContext::MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData)
+    {
+        record(eGraphicsCommand::MAP_BUFFER, 0u, &pBuffer, 1u, uNumBytes);
+        m_aCommands.back().MapType = mapType;
+        if (m_next)
+        {
+            return m_next->MapBuffer(pBuffer, mapType, uNumBytes, ppData);
+        }
+
+        std::vector<BYTE>& memory = m_mappedMemory[pBuffer];
+        if (memory.size() < uNumBytes)
+        {
+            memory.resize(uNumBytes);
+        }
+        *ppData = memory.data();
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::OMSetRenderTargets
+
+      Summary:  Records the bind of render targets and a depth stencil
+                view, the depth stencil view is the last object
+
+      Args:     UINT uNumViews
+                  Number of render targets
+                ID3D11RenderTargetView* const* ppRenderTargetViews
+                  Render targets
+                ID3D11DepthStencilView* pDepthStencilView
+                  Depth stencil view
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView)
+    {
+        record(eGraphicsCommand::OM_SET_RENDER_TARGETS, 0u, ppRenderTargetViews, uNumViews);
+        m_aObjects.push_back(pDepthStencilView);
+        ++m_aCommands.back().uNumObjects;
+        if (m_next)
+        {
+            m_next->OMSetRenderTargets(uNumViews, ppRenderTargetViews, pDepthStencilView);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::PSSetConstantBuffers
+
+      Summary:  Records the bind of constant buffers of the pixel
+                shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        record(eGraphicsCommand::PS_SET_CONSTANT_BUFFERS, uStartSlot, ppConstantBuffers, uNumBuffers);
+        if (m_next)
+        {
+            m_next->PSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::PSSetConstantBuffers1
+
+      Summary:  Records the bind of ranges of constant buffers of the
+                pixel shader stage with the range of the first buffer
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First constant of every range
+                const UINT* pNumConstants
+                  Number of constants of every range
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        record(eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1, uStartSlot, ppConstantBuffers, uNumBuffers, pFirstConstant ? pFirstConstant[0] : 0u);
+        m_aCommands.back().uNumConstants = pNumConstants ? pNumConstants[0] : 0u;
+        if (m_next)
+        {
+            m_next->PSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::PSSetSamplers
+
+      Summary:  Records the bind of samplers of the pixel shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumSamplers
+                  Number of samplers
+                ID3D11SamplerState* const* ppSamplers
+                  Samplers
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers)
+    {
+        record(eGraphicsCommand::PS_SET_SAMPLERS, uStartSlot, ppSamplers, uNumSamplers);
+        if (m_next)
+        {
+            m_next->PSSetSamplers(uStartSlot, uNumSamplers, ppSamplers);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::PSSetShader
+
+      Summary:  Records the bind of the pixel shader
+
+      Args:     ID3D11PixelShader* pPixelShader
+                  Pixel shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        record(eGraphicsCommand::PS_SET_SHADER, 0u, &pPixelShader, 1u);
+        if (m_next)
+        {
+            m_next->PSSetShader(pPixelShader, ppClassInstances, uNumClassInstances);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::PSSetShaderResources
+
+      Summary:  Records the bind of shader resources of the pixel
+                shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumViews
+                  Number of views
+                ID3D11ShaderResourceView* const* ppShaderResourceViews
+                  Shader resource views
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews)
+    {
+        record(eGraphicsCommand::PS_SET_SHADER_RESOURCES, uStartSlot, ppShaderResourceViews, uNumViews);
+        if (m_next)
+        {
+            m_next->PSSetShaderResources(uStartSlot, uNumViews, ppShaderResourceViews);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::RSSetViewports
+
+      Summary:  Records the viewports
+
+      Args:     UINT uNumViewports
+                  Number of viewports
+                const D3D11_VIEWPORT* pViewports
+                  Viewports
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports)
+    {
+        record<const void>(eGraphicsCommand::RS_SET_VIEWPORTS, 0u, nullptr, 0u, uNumViewports);
+        if (m_next)
+        {
+            m_next->RSSetViewports(uNumViewports, pViewports);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::UnmapBuffer
+
+      Summary:  Records the unmap of a mapped buffer
+
+      Args:     ID3D11Buffer* pBuffer
+                  Mapped buffer
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::UnmapBuffer(_In_ ID3D11Buffer* pBuffer)
+    {
+        record(eGraphicsCommand::UNMAP_BUFFER, 0u, &pBuffer, 1u);
+        if (m_next)
+        {
+            m_next->UnmapBuffer(pBuffer);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::UpdateBuffer
+
+      Summary:  Records the update of a buffer and counts its bytes
+
+      Args:     ID3D11Buffer* pBuffer
+                  Buffer to update
+                const void* pData
+                  New contents of the buffer
+                UINT uNumBytes
+                  Size of the buffer in bytes
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes)
+    {
+        record(eGraphicsCommand::UPDATE_BUFFER, 0u, &pBuffer, 1u, uNumBytes);
+        if (m_next)
+        {
+            m_next->UpdateBuffer(pBuffer, pData, uNumBytes);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::VSSetConstantBuffers
+
+      Summary:  Records the bind of constant buffers of the vertex
+                shader stage
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        record(eGraphicsCommand::VS_SET_CONSTANT_BUFFERS, uStartSlot, ppConstantBuffers, uNumBuffers);
+        if (m_next)
+        {
+            m_next->VSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::VSSetConstantBuffers1
+
+      Summary:  Records the bind of ranges of constant buffers of the
+                vertex shader stage with the range of the first buffer
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First constant of every range
+                const UINT* pNumConstants
+                  Number of constants of every range
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        record(eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, uStartSlot, ppConstantBuffers, uNumBuffers, pFirstConstant ? pFirstConstant[0] : 0u);
+        m_aCommands.back().uNumConstants = pNumConstants ? pNumConstants[0] : 0u;
+        if (m_next)
+        {
+            m_next->VSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::VSSetShader
+
+      Summary:  Records the bind of the vertex shader
+
+      Args:     ID3D11VertexShader* pVertexShader
+                  Vertex shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        record(eGraphicsCommand::VS_SET_SHADER, 0u, &pVertexShader, 1u);
+        if (m_next)
+        {
+            m_next->VSSetShader(pVertexShader, ppClassInstances, uNumClassInstances);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::getBindKey
+
+      Summary:  Returns the key of a slot of the state bound by a
+                command. The ranged constant buffer binds share the
+                slots of the plain ones.
+
+      Args:     eGraphicsCommand command
+                  Bind command
+                UINT uSlot
+                  Slot of the bound object
+
+      Returns:  UINT64
+                  Key of the slot
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 RecordingGraphicsContext::getBindKey(_In_ eGraphicsCommand command, _In_ UINT uSlot)
+    {
+        if (command == eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1)
+        {
+            command = eGraphicsCommand::PS_SET_CONSTANT_BUFFERS;
+        }
+        else if (command == eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1)
+        {
+            command = eGraphicsCommand::VS_SET_CONSTANT_BUFFERS;
+        }
+
+        return (static_cast<UINT64>(command) << 32u) | uSlot;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::count
+
+      Summary:  Counts a recorded or executed command
+
+      Args:     const GraphicsCommand& command
+                  Command to count
+
+      Modifies: [m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void RecordingGraphicsContext::count(_In_ const GraphicsCommand& command)
+    {
+        ++m_counters.aNumCalls[static_cast<size_t>(command.Command)];
+        if (IsStateChange(command.Command))
+        {
+            ++m_counters.uNumStateChanges;
+        }
+
+        switch (command.Command)
+        {
+        case eGraphicsCommand::DRAW_INDEXED:
+        case eGraphicsCommand::DRAW_INDEXED_INSTANCED:
+            ++m_counters.uNumDrawCalls;
+            m_counters.uNumIndices += static_cast<UINT64>(command.uValue) * command.uNumInstances;
+            m_counters.uNumInstances += command.uNumInstances;
+            break;
+        case eGraphicsCommand::UPDATE_BUFFER:
+            ++m_counters.uNumUpdates;
+            m_counters.uNumUpdatedBytes += command.uValue;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::replayToDraw
+
+      Summary:  Applies the binds of the stream to a map of the bound
+                objects until the next draw
+
+      Args:     size_t& uCommandIdx
+                  Command to start at, receives the index of the draw
+                std::unordered_map<UINT64, BoundObject>& boundObjects
+                  Bound objects by getBindKey
+
+      Returns:  BOOL
+                  TRUE if a draw was reached, FALSE at the end of the
+                  stream
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL RecordingGraphicsContext::replayToDraw(_Inout_ size_t& uCommandIdx, _Inout_ std::unordered_map<UINT64, BoundObject>& boundObjects) const
+    {
+        for (; uCommandIdx < m_aCommands.size(); ++uCommandIdx)
+        {
+            const GraphicsCommand& command = m_aCommands[uCommandIdx];
+            switch (command.Command)
+            {
+            case eGraphicsCommand::DRAW_INDEXED:
+            case eGraphicsCommand::DRAW_INDEXED_INSTANCED:
+                return TRUE;
+            case eGraphicsCommand::EXECUTE_COMMAND_LIST:
+                boundObjects.clear();
+                break;
+            case eGraphicsCommand::IA_SET_INDEX_BUFFER:
+            case eGraphicsCommand::IA_SET_INPUT_LAYOUT:
+            case eGraphicsCommand::IA_SET_PRIMITIVE_TOPOLOGY:
+            case eGraphicsCommand::PS_SET_SHADER:
+            case eGraphicsCommand::RS_SET_VIEWPORTS:
+            case eGraphicsCommand::VS_SET_SHADER:
+                boundObjects[getBindKey(command.Command, 0u)] =
+                {
+                    .pObject = command.uNumObjects > 0u ? m_aObjects[command.uFirstObject] : nullptr,
+                    .uValue = command.uValue
+                };
+                break;
+            case eGraphicsCommand::OM_SET_RENDER_TARGETS:
+                // The render targets past the bound ones are unbound
+                for (UINT uSlot = 0u; uSlot <= D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++uSlot)
+                {
+                    boundObjects.erase(getBindKey(command.Command, uSlot));
+                }
+                [[fallthrough]];
+            case eGraphicsCommand::IA_SET_VERTEX_BUFFERS:
+            case eGraphicsCommand::PS_SET_CONSTANT_BUFFERS:
+            case eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1:
+            case eGraphicsCommand::PS_SET_SAMPLERS:
+            case eGraphicsCommand::PS_SET_SHADER_RESOURCES:
+            case eGraphicsCommand::VS_SET_CONSTANT_BUFFERS:
+            case eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1:
+                for (UINT uObjectIdx = 0u; uObjectIdx < command.uNumObjects; ++uObjectIdx)
+                {
+                    // Only the range of the first buffer of a ranged bind is recorded
+                    boundObjects[getBindKey(command.Command, command.uStartSlot + uObjectIdx)] =
+                    {
+                        .pObject = m_aObjects[command.uFirstObject + uObjectIdx],
+                        .uValue = uObjectIdx == 0u ? command.uValue : 0u,
+                        .uNumConstants = uObjectIdx == 0u ? command.uNumConstants : 0u
+                    };
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        return FALSE;
+    }
+}
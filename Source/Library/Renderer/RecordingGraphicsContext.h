@@ -0,0 +1,283 @@
+/*+===================================================================
+  File:      RECORDINGGRAPHICSCONTEXT.H
+
+  Summary:   RecordingGraphicsContext header file contains declarations
+             of the RecordingGraphicsContext class that logs the frame
+             calls of the renderer into a command stream.
+
+  Classes: RecordingGraphicsContext
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/GraphicsContext.h"
+
+namespace library
+{
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eGraphicsCommand
+
+        Summary:  Enumeration of the calls of a GraphicsContext
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eGraphicsCommand : BYTE
+    {
+        CLEAR_DEPTH_STENCIL_VIEW,
+        CLEAR_RENDER_TARGET_VIEW,
+        DRAW_INDEXED,
+        DRAW_INDEXED_INSTANCED,
+        EXECUTE_COMMAND_LIST,
+        IA_SET_INDEX_BUFFER,
+        IA_SET_INPUT_LAYOUT,
+        IA_SET_PRIMITIVE_TOPOLOGY,
+        IA_SET_VERTEX_BUFFERS,
+        MAP_BUFFER,
+        OM_SET_RENDER_TARGETS,
+        PS_SET_CONSTANT_BUFFERS,
+        PS_SET_CONSTANT_BUFFERS1,
+        PS_SET_SAMPLERS,
+        PS_SET_SHADER,
+        PS_SET_SHADER_RESOURCES,
+        RS_SET_VIEWPORTS,
+        UNMAP_BUFFER,
+        UPDATE_BUFFER,
+        VS_SET_CONSTANT_BUFFERS,
+        VS_SET_CONSTANT_BUFFERS1,
+        VS_SET_SHADER,
+        COUNT,
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   GraphicsCommand
+
+      Summary:  Recorded call of a GraphicsContext. The objects it
+                bound, cleared or updated are uNumObjects entries of
+                RecordingGraphicsContext::GetObjects from uFirstObject
+                on. uValue is the number of indices of a draw, the
+                number of bytes of an update or a map, the topology of
+                IA_SET_PRIMITIVE_TOPOLOGY, the format of
+                IA_SET_INDEX_BUFFER, the number of commands a
+                EXECUTE_COMMAND_LIST ran and the first constant of the
+                first range of a ranged constant buffer bind, whose
+                number of constants is uNumConstants. MapType is the
+                D3D11_MAP of a MAP_BUFFER.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct GraphicsCommand
+    {
+        eGraphicsCommand Command;
+        UINT uStartSlot;
+        UINT uFirstObject;
+        UINT uNumObjects;
+        UINT uValue;
+        UINT uNumInstances;
+        UINT uNumConstants;
+        D3D11_MAP MapType;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    RecordingGraphicsContext
+
+      Summary:  GraphicsContext that appends every call to a command
+                stream and counts the draws, state changes and uploaded
+                bytes. The objects passed in are only recorded, never
+                dereferenced, so without a next context it is a null
+                backend that runs the frame code headless with any
+                non-null stand-ins for the Direct3D resources. A mapped
+                buffer is then backed by memory of the context, which
+                keeps what was written to it for GetMappedMemory, and
+                CreateBuffer returns reference counted stand-ins that
+                can be held in a ComPtr. With
+                a next context every call is forwarded after it is
+                recorded, which measures a real frame.
+
+                A deferred context is a RecordingGraphicsContext too,
+                in front of a deferred context of the next context if
+                there is one. Executing it moves the commands it had
+                when it was finished into this stream, followed by a
+                EXECUTE_COMMAND_LIST, and counts them here. HasSameDraws
+                compares the draws of two streams, so a frame recorded
+                on deferred contexts can be checked against the same
+                frame recorded on one context. FailFinishCommandList
+                makes one of the deferred contexts fail to finish, as a
+                driver out of memory would, to test what the caller
+                does in its place.
+
+                A state change is a call that binds or sets pipeline
+                state, the calls that clear, update or draw are counted
+                on their own.
+
+      Methods:  FailFinishCommandList
+                  Makes a deferred context fail to finish its command
+                  lists
+                GetCommands
+                  Returns the recorded commands
+                GetCounters
+                  Returns the counters since the last reset
+                GetMappedMemory
+                  Returns the memory backing a buffer mapped without a
+                  next context
+                GetObjects
+                  Returns the objects of the recorded commands
+                HasSameDraws
+                  Returns whether another stream draws the same way
+                IsStateChange
+                  Returns whether a command binds or sets state
+                Reset
+                  Clears the commands and the counters
+                RecordingGraphicsContext
+                  Constructor.
+                ~RecordingGraphicsContext
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class RecordingGraphicsContext final : public GraphicsContext
+    {
+    public:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Counters
+
+            Summary:  Totals of the recorded commands, with the number
+                      of calls of every eGraphicsCommand
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Counters
+        {
+            UINT uNumDrawCalls;
+            UINT uNumStateChanges;
+            UINT uNumUpdates;
+            UINT64 uNumUpdatedBytes;
+            UINT64 uNumIndices;
+            UINT64 uNumInstances;
+            UINT aNumCalls[static_cast<size_t>(eGraphicsCommand::COUNT)];
+        };
+
+    public:
+        static BOOL IsStateChange(_In_ eGraphicsCommand command);
+
+        RecordingGraphicsContext(_In_opt_ const std::shared_ptr<GraphicsContext>& next = nullptr);
+        RecordingGraphicsContext(const RecordingGraphicsContext& other) = delete;
+        RecordingGraphicsContext(RecordingGraphicsContext&& other) = delete;
+        RecordingGraphicsContext& operator=(const RecordingGraphicsContext& other) = delete;
+        RecordingGraphicsContext& operator=(RecordingGraphicsContext&& other) = delete;
+        ~RecordingGraphicsContext() = default;
+
+        void FailFinishCommandList(_In_ UINT uDeferredContextIdx, _In_ HRESULT hr);
+        const std::vector<GraphicsCommand>& GetCommands() const;
+        const Counters& GetCounters() const;
+        const BYTE* GetMappedMemory(_In_ const ID3D11Buffer* pBuffer) const;
+        const std::vector<const void*>& GetObjects() const;
+        BOOL HasSameDraws(_In_ const RecordingGraphicsContext& reference) const;
+        void Reset();
+
+        void ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil) override;
+        void ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4]) override;
+        HRESULT CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer) override;
+        HRESULT CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext) override;
+        void DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation) override;
+        void DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation) override;
+        void ExecuteCommandList(_In_ GraphicsContext& deferredContext) override;
+        HRESULT FinishCommandList() override;
+        void IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset) override;
+        void IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout) override;
+        void IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology) override;
+        void IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets) override;
+        HRESULT MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData) override;
+        void OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView) override;
+        void PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers) override;
+        void PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+        void PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+        void RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports) override;
+        void UnmapBuffer(_In_ ID3D11Buffer* pBuffer) override;
+        void UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes) override;
+        void VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   BoundObject
+
+            Summary:  Object bound to a slot while a stream is replayed,
+                      with the value and the number of constants of
+                      the bind
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct BoundObject
+        {
+            const void* pObject;
+            UINT uValue;
+            UINT uNumConstants;
+
+            bool operator==(const BoundObject& other) const = default;
+        };
+
+        static UINT64 getBindKey(_In_ eGraphicsCommand command, _In_ UINT uSlot);
+
+        void count(_In_ const GraphicsCommand& command);
+        BOOL replayToDraw(_Inout_ size_t& uCommandIdx, _Inout_ std::unordered_map<UINT64, BoundObject>& boundObjects) const;
+
+        template <class T>
+        void record(_In_ eGraphicsCommand command, _In_ UINT uStartSlot, _In_reads_(uNumObjects) T* const* ppObjects, _In_ UINT uNumObjects, _In_ UINT uValue = 0u, _In_ UINT uNumInstances = 0u);
+
+    private:
+        std::shared_ptr<GraphicsContext> m_next;
+        std::vector<GraphicsCommand> m_aCommands;
+        std::vector<const void*> m_aObjects;
+        Counters m_counters;
+        std::unordered_map<const ID3D11Buffer*, std::vector<BYTE>> m_mappedMemory;
+        // Commands and objects of the last FinishCommandList, the ones after them belong to the next
+        size_t m_uNumFinishedCommands;
+        size_t m_uNumFinishedObjects;
+        // Deferred contexts created so far, and the one whose FinishCommandList is made to fail
+        UINT m_uNumDeferredContexts;
+        UINT m_uFailingDeferredContext;
+        HRESULT m_failingFinishResult;
+        // Status code FinishCommandList of this deferred context returns, S_OK unless made to fail
+        HRESULT m_finishResult;
+    };
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   RecordingGraphicsContext::record
+
+      Summary:  Appends a command with its objects and counts it
+
+      Args:     eGraphicsCommand command
+                  Recorded call
+                UINT uStartSlot
+                  First slot of a bind
+                T* const* ppObjects
+                  Objects bound, cleared or updated by the call, a
+                  nullptr array records nullptr objects
+                UINT uNumObjects
+                  Number of objects
+                UINT uValue
+                  Indices of a draw, bytes of an update, topology or
+                  index format
+                UINT uNumInstances
+                  Instances of a draw
+
+      Modifies: [m_aCommands, m_aObjects, m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <class T>
+    void RecordingGraphicsContext::record(_In_ eGraphicsCommand command, _In_ UINT uStartSlot, _In_reads_(uNumObjects) T* const* ppObjects, _In_ UINT uNumObjects, _In_ UINT uValue, _In_ UINT uNumInstances)
+    {
+        m_aCommands.push_back(
+            GraphicsCommand
+            {
+                .Command = command,
+                .uStartSlot = uStartSlot,
+                .uFirstObject = static_cast<UINT>(m_aObjects.size()),
+                .uNumObjects = uNumObjects,
+                .uValue = uValue,
+                .uNumInstances = uNumInstances
+            }
+        );
+        for (UINT uObjectIdx = 0u; uObjectIdx < uNumObjects; ++uObjectIdx)
+        {
+            m_aObjects.push_back(ppObjects ? ppObjects[uObjectIdx] : nullptr);
+        }
+
+        count(m_aCommands.back());
+    }
+}
@@ -1,5 +1,10 @@
 ﻿#include "Renderer/Renderable.h"
 
+#include <cstring>
+
+#include "Renderer/GeometryRegistry.h"
+#include "Renderer/GraphicsContext.h"
+
 #include "assimp/Importer.hpp"	// C++ importer interface
 #include "assimp/scene.h"		// output data structure
 #include "assimp/postprocess.h"	// post processing flags
@@ -17,7 +22,13 @@ namespace library
       Modifies: [m_vertexBuffer, m_indexBuffer, m_constantBuffer,
                  m_normalBuffer, m_aMeshes, m_aMaterials, m_vertexShader,
                  m_pixelShader, m_outputColor, m_world, m_bHasNormalMap
-                 m_aNormalData].
+                 m_aNormalData, m_localBounds, m_constantsWorld,
+                 m_constantsOutputColor, m_bConstantsHaveNormalMap,
+                 m_constants, m_uConstantsVersion,
+                 m_uUploadedConstantsVersion, m_shadowConstantBuffer,
+                 m_shadowConstantsWorld, m_shadowConstants,
+                 m_uShadowConstantsVersion,
+                 m_uUploadedShadowConstantsVersion].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Renderable::Renderable definition (remove the comment)
@@ -37,22 +48,39 @@ namespace library
         , m_world(XMMatrixIdentity())
         , m_padding()
         , m_bHasNormalMap(FALSE)
+        , m_localBounds()
+        , m_constantsWorld()
+        , m_constantsOutputColor()
+        , m_bConstantsHaveNormalMap(FALSE)
+        , m_constants()
+        , m_uConstantsVersion(0u)
+        , m_uUploadedConstantsVersion(0u)
+        , m_shadowConstantBuffer(nullptr)
+        , m_shadowConstantsWorld()
+        , m_shadowConstants()
+        , m_uShadowConstantsVersion(0u)
+        , m_uUploadedShadowConstantsVersion(0u)
     {}
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::initialize
 
-      Summary:  Initializes the buffers and the world matrix
+      Summary:  Initializes the buffers and the world matrix. The
+                renderables without their own normal data, the built-in
+                primitives, share the immutable buffers of their
+                geometry through the GeometryRegistry of the device,
+                the tangents are computed only for the first of them.
+                Without a registry they create buffers of their own.
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
-                PCWSTR pszTextureFileName
-                  File name of the texture to usen
+                GeometryRegistry* pGeometryRegistry
+                  Shared buffers of the device, may be nullptr
 
       Modifies: [m_vertexBuffer, m_normalBuffer, m_indexBuffer
-                 m_constantBuffer].
+                 m_constantBuffer, m_localBounds, m_aMeshes].
 
       Returns:  HRESULT
                   Status code
@@ -61,10 +89,39 @@ namespace library
       TODO: Renderable::initialize definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    HRESULT Renderable::initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext*)
+    HRESULT Renderable::initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext*, _In_opt_ GeometryRegistry* pGeometryRegistry)
     {
         HRESULT hr = S_OK;
 
+        calculateBounds();
+
+        if (m_aNormalData.empty() && pGeometryRegistry)
+        {
+            GeometryRegistry::Geometry geometry;
+            if (!pGeometryRegistry->Find(getVertices(), GetNumVertices(), getIndices(), GetNumIndices(), geometry))
+            {
+                calculateNormalMapVectors();
+
+                hr = pGeometryRegistry->Add(pDevice, getVertices(), GetNumVertices(), getIndices(), GetNumIndices(), m_aNormalData.data(), geometry);
+
+                // Keep the tangents in the registry only, so a second initialize finds them again
+                m_aNormalData.clear();
+                if (FAILED(hr))
+                    return hr;
+            }
+
+            m_vertexBuffer = geometry.VertexBuffer;
+            m_normalBuffer = geometry.NormalBuffer;
+            m_indexBuffer = geometry.IndexBuffer;
+
+            return createConstantBuffer(pDevice);
+        }
+
+        if (m_aNormalData.empty())
+        {
+            calculateNormalMapVectors();
+        }
+
         // Create vertex buffer
         D3D11_BUFFER_DESC bd =
         {
@@ -83,11 +140,6 @@ namespace library
         if (FAILED(hr))
             return hr;
 
-        if (m_aNormalData.empty())
-        {
-            calculateNormalMapVectors();
-        }
-
         // Create m_normalBuffer vertex buffer 
         bd =
         {
@@ -118,14 +170,121 @@ namespace library
         if (FAILED(hr))
             return hr;
 
-        // Create constant buffer
-        bd.Usage = D3D11_USAGE_DEFAULT;
-        bd.ByteWidth = sizeof(CBChangesEveryFrame);
-        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd.CPUAccessFlags = 0;
-        pDevice->CreateBuffer(&bd, nullptr, m_constantBuffer.GetAddressOf());
+        return createConstantBuffer(pDevice);
+    }
 
-        return S_OK;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::createConstantBuffer
+
+      Summary:  Creates the constant buffer of the renderable, it is
+                never shared
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffer
+
+      Modifies: [m_constantBuffer].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderable::createConstantBuffer(_In_ ID3D11Device* pDevice)
+    {
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBChangesEveryFrame),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0
+        };
+
+        return pDevice->CreateBuffer(&bd, nullptr, m_constantBuffer.GetAddressOf());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::transformBounds
+
+      Summary:  Returns the smallest axis-aligned box around a
+                transformed box. The center is transformed as a point,
+                every extent of the result sums the absolute values of
+                the linear part of the matrix times the extents.
+
+      Args:     const AxisAlignedBox& bounds
+                  Box to transform
+                FXMMATRIX world
+                  Affine transformation
+
+      Returns:  AxisAlignedBox
+                  Transformed box
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AxisAlignedBox Renderable::transformBounds(_In_ const AxisAlignedBox& bounds, _In_ FXMMATRIX world)
+    {
+        XMVECTOR center = XMVector3Transform(XMLoadFloat3(&bounds.Center), world);
+        XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+
+        // Row vectors, row i of the matrix is where the unit vector along axis i goes
+        XMVECTOR newExtents = XMVectorMultiply(XMVectorAbs(world.r[0]), XMVectorSplatX(extents));
+        newExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[1]), XMVectorSplatY(extents), newExtents);
+        newExtents = XMVectorMultiplyAdd(XMVectorAbs(world.r[2]), XMVectorSplatZ(extents), newExtents);
+
+        AxisAlignedBox result;
+        XMStoreFloat3(&result.Center, center);
+        XMStoreFloat3(&result.Extents, newExtents);
+        return result;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::calculateBounds
+
+      Summary:  Calculates the object space bounds of all vertices and
+                of the vertices indexed by every mesh
+
+      Modifies: [m_localBounds, m_aMeshes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderable::calculateBounds()
+    {
+        const SimpleVertex* aVertices = getVertices();
+        const WORD* aIndices = getIndices();
+
+        auto makeBounds = [](FXMVECTOR minimum, FXMVECTOR maximum) -> AxisAlignedBox
+        {
+            AxisAlignedBox bounds;
+            XMStoreFloat3(&bounds.Center, XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f));
+            XMStoreFloat3(&bounds.Extents, XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f));
+            return bounds;
+        };
+
+        m_localBounds = AxisAlignedBox();
+        if (GetNumVertices() > 0u)
+        {
+            XMVECTOR minimum = XMLoadFloat3(&aVertices[0].Position);
+            XMVECTOR maximum = minimum;
+            for (UINT i = 1u; i < GetNumVertices(); ++i)
+            {
+                XMVECTOR position = XMLoadFloat3(&aVertices[i].Position);
+                minimum = XMVectorMin(minimum, position);
+                maximum = XMVectorMax(maximum, position);
+            }
+            m_localBounds = makeBounds(minimum, maximum);
+        }
+
+        for (BasicMeshEntry& mesh : m_aMeshes)
+        {
+            mesh.LocalBounds = AxisAlignedBox();
+            if (mesh.uNumIndices == 0u)
+            {
+                continue;
+            }
+
+            XMVECTOR minimum = XMLoadFloat3(&aVertices[mesh.uBaseVertex + aIndices[mesh.uBaseIndex]].Position);
+            XMVECTOR maximum = minimum;
+            for (UINT i = 1u; i < mesh.uNumIndices; ++i)
+            {
+                XMVECTOR position = XMLoadFloat3(&aVertices[mesh.uBaseVertex + aIndices[mesh.uBaseIndex + i]].Position);
+                minimum = XMVectorMin(minimum, position);
+                maximum = XMVectorMax(maximum, position);
+            }
+            mesh.LocalBounds = makeBounds(minimum, maximum);
+        }
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -392,6 +551,21 @@ namespace library
         return m_vertexShader->GetVertexLayout();
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetInstancedVertexShader
+
+      Summary:  Returns the instanced variant of the vertex shader
+
+      Returns:  const std::shared_ptr<VertexShader>&
+                  Instanced variant, empty if the renderable is never
+                  drawn instanced
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    const std::shared_ptr<VertexShader>& Renderable::GetInstancedVertexShader() const
+    {
+        return m_vertexShader->GetInstancedVariant();
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::GetVertexBuffer
 
@@ -532,6 +706,309 @@ namespace library
         return m_aMeshes[uIndex];
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetLocalBounds
+
+      Summary:  Returns the bounds of the vertices in object space,
+                calculated when the renderable is initialized
+
+      Returns:  const AxisAlignedBox&
+                  Object space bounds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const AxisAlignedBox& Renderable::GetLocalBounds() const
+    {
+        return m_localBounds;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetWorldBounds
+
+      Summary:  Returns the bounds of the vertices transformed by the
+                world matrix
+
+      Returns:  AxisAlignedBox
+                  World space bounds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AxisAlignedBox Renderable::GetWorldBounds() const
+    {
+        return transformBounds(m_localBounds, m_world);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetMeshWorldBounds
+
+      Summary:  Returns the bounds of the vertices of a mesh transformed
+                by the world matrix
+
+      Args:     UINT uIndex
+                  Index of the mesh
+
+      Returns:  AxisAlignedBox
+                  World space bounds of the mesh
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AxisAlignedBox Renderable::GetMeshWorldBounds(_In_ UINT uIndex) const
+    {
+        assert(uIndex < m_aMeshes.size());
+
+        return transformBounds(m_aMeshes[uIndex].LocalBounds, m_world);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetGeometryKey
+
+      Summary:  Returns the array the vertices were created from. The
+                renderables of one kind, every cube for instance, share
+                the key, renderables with the same key may still differ
+                in their indices, see HasSameGeometry.
+
+      Returns:  const void*
+                  Key of the geometry
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const void* Renderable::GetGeometryKey() const
+    {
+        return getVertices();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::HasSameGeometry
+
+      Summary:  Returns whether another renderable draws the same
+                vertices and indices, either from the same buffers or
+                from buffers created from the same arrays, so the
+                buffers of one can draw the other
+
+      Args:     const Renderable& other
+                  Renderable to compare with
+
+      Returns:  BOOL
+                  TRUE if the geometry is the same
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::HasSameGeometry(_In_ const Renderable& other) const
+    {
+        if (m_vertexBuffer && m_vertexBuffer.Get() == other.m_vertexBuffer.Get() && m_indexBuffer.Get() == other.m_indexBuffer.Get())
+        {
+            return TRUE;
+        }
+
+        return getVertices() == other.getVertices()
+            && getIndices() == other.getIndices()
+            && GetNumVertices() == other.GetNumVertices()
+            && GetNumIndices() == other.GetNumIndices();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetConstants
+
+      Summary:  Returns the constants of the draws as of the last
+                UpdateConstants
+
+      Returns:  const CBChangesEveryFrame&
+                  Constants of the draws
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const CBChangesEveryFrame& Renderable::GetConstants() const
+    {
+        return m_constants;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::UpdateConstants
+
+      Summary:  Rebuilds the constants of the draws if the world matrix,
+                the output color or the normal map flag changed since
+                the last call. The sources are compared rather than
+                flagged by the setters, since derived classes assign
+                m_world directly.
+
+      Modifies: [m_constantsWorld, m_constantsOutputColor,
+                 m_bConstantsHaveNormalMap, m_constants,
+                 m_uConstantsVersion].
+
+      Returns:  BOOL
+                  TRUE if the constants changed, always on the first
+                  call
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::UpdateConstants()
+    {
+        if (m_uConstantsVersion != 0u
+            && memcmp(&m_constantsWorld, &m_world, sizeof(m_world)) == 0
+            && memcmp(&m_constantsOutputColor, &m_outputColor, sizeof(m_outputColor)) == 0
+            && m_bConstantsHaveNormalMap == m_bHasNormalMap)
+        {
+            return FALSE;
+        }
+
+        m_constantsWorld = m_world;
+        m_constantsOutputColor = m_outputColor;
+        m_bConstantsHaveNormalMap = m_bHasNormalMap;
+        m_constants =
+        {
+            .World = XMMatrixTranspose(m_world),
+            .OutputColor = m_outputColor,
+            .HasNormalMap = m_bHasNormalMap
+        };
+
+        // Skip 0 on wrap around, it means never built
+        ++m_uConstantsVersion;
+        if (m_uConstantsVersion == 0u)
+        {
+            m_uConstantsVersion = 1u;
+        }
+
+        return TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::UploadConstants
+
+      Summary:  Updates the constant buffer with the constants of the
+                draws if it does not hold them yet
+
+      Args:     GraphicsContext& context
+                  Context to update the buffer with
+
+      Modifies: [m_uUploadedConstantsVersion].
+
+      Returns:  UINT
+                  Number of bytes uploaded, 0 if the buffer was current
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::UploadConstants(_In_ GraphicsContext& context)
+    {
+        if (m_uUploadedConstantsVersion == m_uConstantsVersion)
+        {
+            return 0u;
+        }
+
+        context.UpdateBuffer(m_constantBuffer.Get(), &m_constants, sizeof(m_constants));
+        m_uUploadedConstantsVersion = m_uConstantsVersion;
+
+        return sizeof(m_constants);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetShadowConstantBuffer
+
+      Summary:  Returns the constant buffer of the shadow pass, null
+                until the first UploadShadowConstants
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Constant buffer of the shadow pass
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& Renderable::GetShadowConstantBuffer()
+    {
+        return m_shadowConstantBuffer;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::GetShadowConstants
+
+      Summary:  Returns the constants of the shadow pass as of the last
+                UpdateShadowConstants
+
+      Returns:  const CBShadowMatrix&
+                  Constants of the shadow pass
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const CBShadowMatrix& Renderable::GetShadowConstants() const
+    {
+        return m_shadowConstants;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::UpdateShadowConstants
+
+      Summary:  Rebuilds the constants of the shadow pass if the world
+                matrix or the light changed since the last call, like
+                UpdateConstants does for the constants of the draws
+
+      Args:     const XMMATRIX& lightView
+                  Transposed view matrix of the light
+                const XMMATRIX& lightProjection
+                  Transposed projection matrix of the light
+                BOOL bIsVoxel
+                  Whether the draws are voxel instances
+
+      Modifies: [m_shadowConstantsWorld, m_shadowConstants,
+                 m_uShadowConstantsVersion].
+
+      Returns:  BOOL
+                  TRUE if the constants changed, always on the first
+                  call
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderable::UpdateShadowConstants(_In_ const XMMATRIX& lightView, _In_ const XMMATRIX& lightProjection, _In_ BOOL bIsVoxel)
+    {
+        if (m_uShadowConstantsVersion != 0u
+            && memcmp(&m_shadowConstantsWorld, &m_world, sizeof(m_world)) == 0
+            && memcmp(&m_shadowConstants.View, &lightView, sizeof(lightView)) == 0
+            && memcmp(&m_shadowConstants.Projection, &lightProjection, sizeof(lightProjection)) == 0
+            && m_shadowConstants.IsVoxel == bIsVoxel)
+        {
+            return FALSE;
+        }
+
+        m_shadowConstantsWorld = m_world;
+        m_shadowConstants =
+        {
+            .World = XMMatrixTranspose(m_world),
+            .View = lightView,
+            .Projection = lightProjection,
+            .IsVoxel = bIsVoxel
+        };
+
+        // Skip 0 on wrap around, it means never built
+        ++m_uShadowConstantsVersion;
+        if (m_uShadowConstantsVersion == 0u)
+        {
+            m_uShadowConstantsVersion = 1u;
+        }
+
+        return TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderable::UploadShadowConstants
+
+      Summary:  Updates the constant buffer of the shadow pass with the
+                constants of the pass if it does not hold them yet. The
+                buffer is created through the context by the first
+                upload, renderables that never cast a shadow have none.
+
+      Args:     GraphicsContext& context
+                  Context to create and update the buffer with
+
+      Modifies: [m_shadowConstantBuffer,
+                 m_uUploadedShadowConstantsVersion].
+
+      Returns:  UINT
+                  Number of bytes uploaded, 0 if the buffer was current
+                  or could not be created
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Renderable::UploadShadowConstants(_In_ GraphicsContext& context)
+    {
+        if (m_uUploadedShadowConstantsVersion == m_uShadowConstantsVersion)
+        {
+            return 0u;
+        }
+
+        if (!m_shadowConstantBuffer)
+        {
+            D3D11_BUFFER_DESC bd =
+            {
+                .ByteWidth = sizeof(CBShadowMatrix),
+                .Usage = D3D11_USAGE_DEFAULT,
+                .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+                .CPUAccessFlags = 0
+            };
+            if (FAILED(context.CreateBuffer(&bd, m_shadowConstantBuffer.GetAddressOf())))
+            {
+                return 0u;
+            }
+        }
+
+        context.UpdateBuffer(m_shadowConstantBuffer.Get(), &m_shadowConstants, sizeof(m_shadowConstants));
+        m_uUploadedShadowConstantsVersion = m_uShadowConstantsVersion;
+
+        return sizeof(m_shadowConstants);
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderable::RotateX
 
@@ -20,6 +20,8 @@
 
 namespace library
 {
+    class GeometryRegistry;
+    class GraphicsContext;
 
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    Renderable
@@ -39,6 +41,36 @@ namespace library
                   Returns the constant buffer
                 GetWorldMatrix
                   Returns the world matrix
+                GetLocalBounds
+                  Returns the bounds of the vertices in object space
+                GetWorldBounds
+                  Returns the bounds of the vertices in world space
+                GetMeshWorldBounds
+                  Returns the bounds of a mesh in world space
+                GetInstancedVertexShader
+                  Returns the instanced variant of the vertex shader
+                GetGeometryKey
+                  Returns the source of the vertices
+                HasSameGeometry
+                  Returns whether another renderable draws the same
+                  vertices and indices
+                GetConstants
+                  Returns the constants of the draws
+                UpdateConstants
+                  Rebuilds the constants of the draws if they changed
+                UploadConstants
+                  Updates the constant buffer if it is behind the
+                  constants
+                GetShadowConstantBuffer
+                  Returns the constant buffer of the shadow pass
+                GetShadowConstants
+                  Returns the constants of the shadow pass
+                UpdateShadowConstants
+                  Rebuilds the constants of the shadow pass if they
+                  changed
+                UploadShadowConstants
+                  Updates the constant buffer of the shadow pass if it
+                  is behind the constants
                 GetNumVertices
                   Pure virtual function that returns the number of
                   vertices
@@ -63,6 +95,7 @@ namespace library
                 , uBaseVertex(0u)
                 , uBaseIndex(0u)
                 , uMaterialIndex(INVALID_MATERIAL)
+                , LocalBounds()
             {
             }
 
@@ -70,6 +103,7 @@ namespace library
             UINT uBaseVertex;
             UINT uBaseIndex;
             UINT uMaterialIndex;
+            AxisAlignedBox LocalBounds;
         };
 
     public:
@@ -80,7 +114,7 @@ namespace library
         Renderable& operator=(Renderable&& other) = delete;
         virtual ~Renderable() = default;
 
-        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) = 0;
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry) = 0;
         virtual void Update(_In_ FLOAT deltaTime) = 0;
 
         void SetVertexShader(_In_ const std::shared_ptr<VertexShader>& vertexShader);
@@ -102,6 +136,21 @@ namespace library
         BOOL HasTexture() const;
         const std::shared_ptr<Material>& GetMaterial(UINT uIndex) const;
         const BasicMeshEntry& GetMesh(UINT uIndex) const;
+        const AxisAlignedBox& GetLocalBounds() const;
+        AxisAlignedBox GetWorldBounds() const;
+        AxisAlignedBox GetMeshWorldBounds(_In_ UINT uIndex) const;
+        const std::shared_ptr<VertexShader>& GetInstancedVertexShader() const;
+        const void* GetGeometryKey() const;
+        BOOL HasSameGeometry(_In_ const Renderable& other) const;
+
+        const CBChangesEveryFrame& GetConstants() const;
+        BOOL UpdateConstants();
+        UINT UploadConstants(_In_ GraphicsContext& context);
+
+        ComPtr<ID3D11Buffer>& GetShadowConstantBuffer();
+        const CBShadowMatrix& GetShadowConstants() const;
+        BOOL UpdateShadowConstants(_In_ const XMMATRIX& lightView, _In_ const XMMATRIX& lightProjection, _In_ BOOL bIsVoxel);
+        UINT UploadShadowConstants(_In_ GraphicsContext& context);
 
         void RotateX(_In_ FLOAT angle);
         void RotateY(_In_ FLOAT angle);
@@ -122,9 +171,14 @@ namespace library
         virtual const WORD* getIndices() const = 0;
         virtual HRESULT initialize(
             _In_ ID3D11Device* pDevice,
-            _In_ ID3D11DeviceContext* pImmediateContext
+            _In_ ID3D11DeviceContext* pImmediateContext,
+            _In_opt_ GeometryRegistry* pGeometryRegistry
         );
 
+        static AxisAlignedBox transformBounds(_In_ const AxisAlignedBox& bounds, _In_ FXMMATRIX world);
+
+        HRESULT createConstantBuffer(_In_ ID3D11Device* pDevice);
+        void calculateBounds();
         void calculateNormalMapVectors();
         void calculateTangentBitangent(_In_ const SimpleVertex& v1, _In_ const SimpleVertex& v2, _In_ const SimpleVertex& v3, _Out_ XMFLOAT3& tangent, _Out_ XMFLOAT3& bitangent);
 
@@ -145,5 +199,23 @@ namespace library
         BYTE m_padding[8];
         XMMATRIX m_world;
         BOOL m_bHasNormalMap;
+        AxisAlignedBox m_localBounds;
+
+    private:
+        // The world matrix, color and normal map flag that m_constants was built from
+        XMMATRIX m_constantsWorld;
+        XMFLOAT4 m_constantsOutputColor;
+        BOOL m_bConstantsHaveNormalMap;
+        CBChangesEveryFrame m_constants;
+        // 0 until the first UpdateConstants, the constant buffer holds m_uUploadedConstantsVersion
+        UINT m_uConstantsVersion;
+        UINT m_uUploadedConstantsVersion;
+
+        // Same scheme for the shadow pass, the buffer is created by the first upload
+        ComPtr<ID3D11Buffer> m_shadowConstantBuffer;
+        XMMATRIX m_shadowConstantsWorld;
+        CBShadowMatrix m_shadowConstants;
+        UINT m_uShadowConstantsVersion;
+        UINT m_uUploadedShadowConstantsVersion;
     };
 }
\ No newline at end of file
@@ -1,5 +1,10 @@
 ﻿#include "Renderer/Renderer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
 namespace library
 {
 
@@ -9,10 +14,17 @@ namespace library
       Modifies: [m_driverType, m_featureLevel, m_d3dDevice, m_d3dDevice1,
                   m_immediateContext, m_immediateContext1, m_swapChain,
                   m_swapChain1, m_renderTargetView, m_depthStencil,
-                  m_depthStencilView, m_cbChangeOnResize, m_cbShadowMatrix,
-                  m_pszMainSceneName, m_camera, m_projection, m_scenes
-                  m_invalidTexture, m_shadowMapTexture, m_shadowVertexShader,
-                  m_shadowPixelShader].
+                  m_depthStencilView, m_viewport, m_cbChangeOnResize,
+                  m_pszMainSceneName, m_camera, m_projection, m_scenes,
+                  m_geometryRegistry, m_invalidTexture, m_shadowMapTexture,
+                  m_shadowVertexShader, m_shadowPixelShader, m_physics,
+                  m_walker, m_bWalkMode,
+                  m_drawStatistics, m_graphicsContext, m_drawQueue,
+                  m_aVisibleProxies, m_frustumCuller, m_aVisibleDrawItems,
+                  m_stateCache, m_constantRing, m_aPassConstants,
+                  m_instanceStream, m_aInstanceCandidates,
+                  m_aInstanceLeaders, m_aRunLeaders, m_recordingThreadPool,
+                  m_uNumRecordingContexts, m_aDrawRecorders].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Renderer::Renderer definition (remove the comment)
@@ -29,17 +41,37 @@ namespace library
         , m_renderTargetView()
         , m_depthStencil()
         , m_depthStencilView()
+        , m_viewport()
         , m_cbChangeOnResize()
         , m_pszMainSceneName(nullptr)
         , m_padding{ '\0' }
         , m_camera(XMVectorSet(0.0f, 3.0f, -6.0f, 0.0f))
         , m_projection()
         , m_scenes()
+        , m_geometryRegistry()
         , m_invalidTexture(std::make_shared<Texture>(L"Content/Common/InvalidTexture.png"))
-        , m_cbShadowMatrix()
         , m_shadowMapTexture()
         , m_shadowVertexShader()
         , m_shadowPixelShader()
+        , m_physics()
+        , m_walker()
+        , m_bWalkMode(FALSE)
+        , m_drawStatistics()
+        , m_graphicsContext()
+        , m_drawQueue()
+        , m_aVisibleProxies()
+        , m_frustumCuller()
+        , m_aVisibleDrawItems()
+        , m_stateCache()
+        , m_constantRing()
+        , m_aPassConstants()
+        , m_instanceStream()
+        , m_aInstanceCandidates()
+        , m_aInstanceLeaders()
+        , m_aRunLeaders()
+        , m_recordingThreadPool()
+        , m_uNumRecordingContexts(0u)
+        , m_aDrawRecorders()
     {
     }
 
@@ -53,7 +85,10 @@ namespace library
                   m_d3dDevice1, m_immediateContext1, m_swapChain1,
                   m_swapChain, m_renderTargetView, m_vertexShader,
                   m_vertexLayout, m_pixelShader, m_vertexBuffer
-                  m_cbShadowMatrix].
+                  m_viewport, m_projection, m_cbChangeOnResize,
+                  m_cbLights, m_graphicsContext,
+                  m_stateCache, m_constantRing, m_instanceStream,
+                  m_aDrawRecorders, m_geometryRegistry].
       Returns:  HRESULT
                   Status code
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
@@ -114,6 +149,10 @@ namespace library
             return hr;
         }
 
+        m_graphicsContext = std::make_shared<D3D11GraphicsContext>(m_immediateContext.Get());
+        m_stateCache.SetNext(m_graphicsContext);
+        m_aDrawRecorders.clear();
+
         // Obtain DXGI factory from device (since we used nullptr for pAdapter above)
         ComPtr<IDXGIFactory1> dxgiFactory;
         {
@@ -235,94 +274,232 @@ namespace library
 
         m_immediateContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
 
-        // Setup the viewport
-        D3D11_VIEWPORT vp =
+        hr = createFrameBuffers(uWidth, uHeight);
+        if (FAILED(hr))
         {
-            .TopLeftX = 0.0f,
-            .TopLeftY = 0.0f,
-            .Width = static_cast<FLOAT>(uWidth),
-            .Height = static_cast<FLOAT>(uHeight),
-            .MinDepth = 0.0f,
-            .MaxDepth = 1.0f,
-        };
-        m_immediateContext->RSSetViewports(1, &vp);
+            return hr;
+        }
 
-        // Set primitive topology
-        m_immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        // Ranges of one constant buffer can only be bound on Direct3D 11.1 drivers that support it,
+        // and the ring appends with D3D11_MAP_WRITE_NO_OVERWRITE, which drivers only have to allow on
+        // dynamic constant buffers when they say so. Otherwise every draw keeps updating its own
+        // constant buffer
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+        if (m_immediateContext1
+            && SUCCEEDED(m_d3dDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))
+            && options.ConstantBufferOffsetting
+            && options.MapNoOverwriteOnDynamicConstantBuffer)
+        {
+            hr = InitializeConstantRing(ConstantRing::DEFAULT_SIZE);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
 
-        // Create the constant buffers
-        D3D11_BUFFER_DESC bd =
+        m_shadowMapTexture = std::make_shared<RenderTexture>(uWidth, uHeight);
+        m_shadowMapTexture->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
+
+        for (UINT i = 0u; i < NUM_LIGHTS; i++)
         {
-            .ByteWidth = sizeof(CBChangeOnResize),
-            .Usage = D3D11_USAGE_DEFAULT,
-            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
-            .CPUAccessFlags = 0
-        };
-        hr = m_d3dDevice->CreateBuffer(&bd, nullptr, m_cbChangeOnResize.GetAddressOf());
+            m_scenes[m_pszMainSceneName]->GetPointLight(i)->Initialize(uWidth, uHeight);
+        }
+
+        m_camera.Initialize(m_d3dDevice.Get());
+
+        if (!m_scenes.contains(m_pszMainSceneName))
+        {
+            return E_FAIL;
+        }
+
+        hr = m_scenes[m_pszMainSceneName]->Initialize(m_d3dDevice.Get(), m_immediateContext.Get(), &m_geometryRegistry);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        // Initialize the projection matrix
-        m_projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<FLOAT>(uWidth) / static_cast<FLOAT>(uHeight), 0.01f, 1000.0f);
+        hr = m_invalidTexture->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
 
-        CBChangeOnResize cbChangesOnResize =
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::Initialize
+
+      Summary:  Prepares the renderer to render headless through a
+                context, without a device, a window or a swap chain.
+                The frame buffers and the constant buffer of the camera
+                are created by the context, a RecordingGraphicsContext
+                without a next context hands out stand-ins. There is no
+                back buffer or depth stencil view and Present does
+                nothing. Only the renderables of the main scene are
+                initialized, without a device, so they keep the buffers
+                they were given.
+
+      Args:     const std::shared_ptr<GraphicsContext>& graphicsContext
+                  Context to render through
+                UINT uWidth
+                  Width of the viewport
+                UINT uHeight
+                  Height of the viewport
+
+      Modifies: [m_graphicsContext, m_stateCache, m_aDrawRecorders,
+                 m_viewport, m_projection, m_cbChangeOnResize,
+                 m_cbLights, m_instanceStream, m_camera].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL without a main scene
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderer::Initialize(_In_ const std::shared_ptr<GraphicsContext>& graphicsContext, _In_ UINT uWidth, _In_ UINT uHeight)
+    {
+        if (!graphicsContext || uWidth == 0u || uHeight == 0u)
         {
-            .Projection = XMMatrixTranspose(m_projection)
-        };
-        m_immediateContext->UpdateSubresource(m_cbChangeOnResize.Get(), 0, nullptr, &cbChangesOnResize, 0, 0);
+            return E_INVALIDARG;
+        }
 
-        bd.ByteWidth = sizeof(CBLights);
-        bd.Usage = D3D11_USAGE_DEFAULT;
-        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd.CPUAccessFlags = 0u;
+        if (!m_pszMainSceneName || !m_scenes.contains(m_pszMainSceneName))
+        {
+            return E_FAIL;
+        }
+
+        SetGraphicsContext(graphicsContext);
 
-        hr = m_d3dDevice->CreateBuffer(&bd, nullptr, m_cbLights.GetAddressOf());
+        HRESULT hr = createFrameBuffers(uWidth, uHeight);
         if (FAILED(hr))
         {
             return hr;
         }
 
-        bd.ByteWidth = sizeof(CBShadowMatrix);
-        bd.Usage = D3D11_USAGE_DEFAULT;
-        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd.CPUAccessFlags = 0u;
-
-        hr = m_d3dDevice->CreateBuffer(&bd, nullptr, m_cbShadowMatrix.GetAddressOf());
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBChangeOnCameraMovement),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0u
+        };
+        m_camera.GetConstantBuffer().Reset();
+        hr = m_graphicsContext->CreateBuffer(&bd, m_camera.GetConstantBuffer().GetAddressOf());
         if (FAILED(hr))
         {
             return hr;
         }
 
-        m_shadowMapTexture = std::make_shared<RenderTexture>(uWidth, uHeight);
-        m_shadowMapTexture->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
-
         for (UINT i = 0u; i < NUM_LIGHTS; i++)
         {
             m_scenes[m_pszMainSceneName]->GetPointLight(i)->Initialize(uWidth, uHeight);
         }
 
-        m_camera.Initialize(m_d3dDevice.Get());
+        return m_scenes[m_pszMainSceneName]->InitializeRenderables(nullptr, nullptr, &m_geometryRegistry);
+    }
 
-        if (!m_scenes.contains(m_pszMainSceneName))
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::InitializeConstantRing
+
+      Summary:  Creates the constant ring the per draw constants are
+                written into through the graphics context. Initialize
+                with a window calls it when the driver can bind ranges
+                of a constant buffer, a headless renderer renders
+                without a ring until it is called. Draws that find the
+                ring full update their own constant buffer.
+
+      Args:     UINT uSize
+                  Size of the ring in bytes, a multiple of
+                  ConstantRing::RANGE_ALIGNMENT
+
+      Modifies: [m_constantRing].
+
+      Returns:  HRESULT
+                  Status code, E_NOT_VALID_STATE without a graphics
+                  context
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderer::InitializeConstantRing(_In_ UINT uSize)
+    {
+        if (!m_graphicsContext)
         {
-            return E_FAIL;
+            return E_NOT_VALID_STATE;
         }
 
-        hr = m_scenes[m_pszMainSceneName]->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
+        return m_constantRing.Initialize(*m_graphicsContext, uSize);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::createFrameBuffers
+
+      Summary:  Sets up the viewport and the projection, and creates the
+                projection and light constant buffers and the instance
+                stream through the graphics context
+
+      Args:     UINT uWidth
+                  Width of the viewport
+                UINT uHeight
+                  Height of the viewport
+
+      Modifies: [m_viewport, m_projection, m_cbChangeOnResize,
+                 m_cbLights, m_instanceStream].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderer::createFrameBuffers(_In_ UINT uWidth, _In_ UINT uHeight)
+    {
+        // Setup the viewport
+        m_viewport =
+        {
+            .TopLeftX = 0.0f,
+            .TopLeftY = 0.0f,
+            .Width = static_cast<FLOAT>(uWidth),
+            .Height = static_cast<FLOAT>(uHeight),
+            .MinDepth = 0.0f,
+            .MaxDepth = 1.0f,
+        };
+
+        // Create the constant buffers
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBChangeOnResize),
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0
+        };
+        m_cbChangeOnResize.Reset();
+        HRESULT hr = m_graphicsContext->CreateBuffer(&bd, m_cbChangeOnResize.GetAddressOf());
         if (FAILED(hr))
         {
             return hr;
         }
 
-        hr = m_invalidTexture->Initialize(m_d3dDevice.Get(), m_immediateContext.Get());
+        // Initialize the projection matrix
+        m_projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<FLOAT>(uWidth) / static_cast<FLOAT>(uHeight), 0.01f, 1000.0f);
+
+        CBChangeOnResize cbChangesOnResize =
+        {
+            .Projection = XMMatrixTranspose(m_projection)
+        };
+        m_graphicsContext->UpdateBuffer(m_cbChangeOnResize.Get(), &cbChangesOnResize, sizeof(cbChangesOnResize));
+
+        bd.ByteWidth = sizeof(CBLights);
+        bd.Usage = D3D11_USAGE_DEFAULT;
+        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        bd.CPUAccessFlags = 0u;
+
+        m_cbLights.Reset();
+        hr = m_graphicsContext->CreateBuffer(&bd, m_cbLights.GetAddressOf());
         if (FAILED(hr))
         {
             return hr;
         }
 
-        return S_OK;
+        bd.ByteWidth = MAX_STREAM_INSTANCES * sizeof(InstanceData);
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        m_instanceStream.Reset();
+        return m_graphicsContext->CreateBuffer(&bd, m_instanceStream.GetAddressOf());
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -427,7 +604,88 @@ namespace library
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     void Renderer::HandleInput(_In_ const DirectionsInput& directions, _In_ const MouseRelativeMovement& mouseRelativeMovement, _In_ FLOAT deltaTime)
     {
-        m_camera.HandleInput(directions, mouseRelativeMovement, deltaTime);
+        if (!m_bWalkMode)
+        {
+            m_camera.HandleInput(directions, mouseRelativeMovement, deltaTime);
+            return;
+        }
+
+        // The mouse turns the camera, the keys steer the walker
+        m_camera.HandleInput(DirectionsInput{}, mouseRelativeMovement, deltaTime);
+
+        XMVECTOR walkDirection = XMVectorZero();
+        if (directions.bFront)
+        {
+            walkDirection += m_camera.GetForward();
+        }
+        if (directions.bBack)
+        {
+            walkDirection -= m_camera.GetForward();
+        }
+        if (directions.bRight)
+        {
+            walkDirection += m_camera.GetRight();
+        }
+        if (directions.bLeft)
+        {
+            walkDirection -= m_camera.GetRight();
+        }
+        XMVECTOR walkVelocity = XMVector3Normalize(walkDirection) * WALK_SPEED;
+
+        m_walker.Velocity.x = XMVectorGetX(walkVelocity);
+        m_walker.Velocity.z = XMVectorGetZ(walkVelocity);
+        if (directions.bUp && (m_walker.ContactMask & Voxel::FACE_NEGATIVE_Y))
+        {
+            m_walker.Velocity.y = JUMP_SPEED;
+        }
+
+        m_physics.Update(*m_scenes[m_pszMainSceneName], &m_walker, 1u, deltaTime);
+
+        m_camera.SetEye(XMVectorSet(m_walker.Position.x, m_walker.Position.y + WALKER_EYE_HEIGHT, m_walker.Position.z, 0.0f));
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::SetWalkMode
+
+      Summary:  Switches the camera between flying freely and walking
+                on the blocks of the main scene with gravity, where
+                SPACE jumps. The walker starts below the current eye.
+
+      Args:     BOOL bWalkMode
+                  TRUE to walk, FALSE to fly
+
+      Modifies: [m_walker, m_bWalkMode].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::SetWalkMode(_In_ BOOL bWalkMode)
+    {
+        if (bWalkMode && !m_bWalkMode)
+        {
+            XMFLOAT3 eye;
+            XMStoreFloat3(&eye, m_camera.GetEye());
+            m_walker =
+            {
+                .Position = XMFLOAT3(eye.x, eye.y - WALKER_EYE_HEIGHT, eye.z),
+                .HalfExtents = WALKER_HALF_EXTENTS,
+                .Velocity = XMFLOAT3(0.0f, 0.0f, 0.0f),
+                .GravityScale = 1.0f,
+                .ContactMask = 0u
+            };
+        }
+
+        m_bWalkMode = bWalkMode;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::IsWalkMode
+
+      Summary:  Returns whether the camera walks on the blocks
+
+      Returns:  BOOL
+                  TRUE if walking, FALSE if flying
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderer::IsWalkMode() const
+    {
+        return m_bWalkMode;
     }
 
 
@@ -444,13 +702,33 @@ namespace library
         m_scenes[m_pszMainSceneName]->Update(deltaTime);
 
         m_camera.Update(deltaTime);
+
+        if (m_scenes[m_pszMainSceneName]->GetVoxelWorld())
+        {
+            m_scenes[m_pszMainSceneName]->GetVoxelWorld()->Update(m_camera.GetEye());
+        }
     }
 
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderer::Render
 
-      Summary:  Render the frame
+      Summary:  Render the frame, Present shows it. The binds go
+                through the state cache, which is invalidated at the
+                start of the frame since Present may unbind the back
+                buffer. The renderable tree of the scene drops the
+                renderables outside of the view frustum, the culler the
+                mesh draws of the others outside of it, before their
+                constants are written. The mesh draws that can share an
+                instanced draw are merged. The constant ring is rewound
+                for the per draw constants of the frame. The back buffer
+                is bound every frame, since executing a command list
+                clears the state of the context.
+
+      Modifies: [m_drawStatistics, m_drawQueue, m_aVisibleProxies,
+                 m_frustumCuller, m_aVisibleDrawItems, m_stateCache,
+                 m_constantRing, m_aPassConstants, m_aInstanceCandidates,
+                 m_aInstanceLeaders, m_aRunLeaders, m_aDrawRecorders].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Renderer::Render definition (remove the comment)
@@ -458,13 +736,21 @@ namespace library
 
     void Renderer::Render()
     {
+        m_drawStatistics = {};
+        m_stateCache.Invalidate();
+        m_stateCache.ResetCounters();
+        m_constantRing.BeginFrame();
+
+        m_stateCache.OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+        m_stateCache.RSSetViewports(1, &m_viewport);
+
         // RenderSceneToTexture();
 
         // Clear the backbuffer
-        m_immediateContext->ClearRenderTargetView(m_renderTargetView.Get(), Colors::MidnightBlue);
+        m_stateCache.ClearRenderTargetView(m_renderTargetView.Get(), Colors::MidnightBlue);
 
         // Clear the depth buffer to 1.0 (max depth)
-        m_immediateContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+        m_stateCache.ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
         // Create camera constant buffer and update 
         CBChangeOnCameraMovement cbChangeOnCameraMovement =
@@ -472,7 +758,8 @@ namespace library
             .View = XMMatrixTranspose(m_camera.GetView())
         };
         XMStoreFloat4(&cbChangeOnCameraMovement.CameraPosition, m_camera.GetEye());
-        m_immediateContext->UpdateSubresource(m_camera.GetConstantBuffer().Get(), 0, nullptr, &cbChangeOnCameraMovement, 0, 0);
+        m_stateCache.UpdateBuffer(m_camera.GetConstantBuffer().Get(), &cbChangeOnCameraMovement, sizeof(cbChangeOnCameraMovement));
+        m_drawStatistics.uNumUploadedBytes += sizeof(cbChangeOnCameraMovement);
 
         for (auto sceneElem = m_scenes.begin(); sceneElem != m_scenes.end(); ++sceneElem)
         {
@@ -491,391 +778,162 @@ namespace library
                     attenuationDistanceSquared
                 );
             }
-            m_immediateContext->UpdateSubresource(m_cbLights.Get(), 0, nullptr, &cbLights, 0, 0);
-
-            for (auto renderableElem = sceneElem->second->GetRenderables().begin();
-                renderableElem != sceneElem->second->GetRenderables().end(); ++renderableElem)
-            {
-                // Set the vertex buffer
-                UINT aStrides[2] =
-                {
-                    sizeof(SimpleVertex),
-                    sizeof(NormalData),
-                };
-                UINT aOffsets[2] = { 0u, 0u };
-
-                ComPtr<ID3D11Buffer> aBuffers[2]
-                {
-                    renderableElem->second->GetVertexBuffer(),
-                    renderableElem->second->GetNormalBuffer()
-                };
+            m_stateCache.UpdateBuffer(m_cbLights.Get(), &cbLights, sizeof(cbLights));
+            m_drawStatistics.uNumUploadedBytes += sizeof(cbLights);
 
-                // Set the vertex buffer
-                m_immediateContext->IASetVertexBuffers(0, 2, aBuffers->GetAddressOf(), aStrides, aOffsets);
+            renderVoxels(sceneElem->second->GetVoxels(), sceneElem->second->GetPaletteBuffer());
 
-                // Set the index buffer
-                m_immediateContext->IASetIndexBuffer(renderableElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-
-                // Set primitive topology
-                m_immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            if (sceneElem->second->GetVoxelWorld())
+            {
+                renderVoxels(sceneElem->second->GetVoxelWorld()->GetVoxels(), sceneElem->second->GetVoxelWorld()->GetPaletteBuffer());
+            }
 
-                // Set the input layout
-                m_immediateContext->IASetInputLayout(renderableElem->second->GetVertexLayout().Get());
+            // Queue a draw item for every mesh of the renderables the scene tree finds in the frustum, drop
+            // the meshes outside of it, sort the rest by state and submit them in order, the skybox pass
+            // comes last. Models are not in the tree, skinning moves their vertices out of their bounds.
+            XMMATRIX viewProjection = XMMatrixMultiply(m_camera.GetView(), m_projection);
+            m_drawQueue.Clear();
+            m_frustumCuller.Clear();
+
+            std::chrono::steady_clock::time_point queryStart = std::chrono::steady_clock::now();
+            const DynamicAabbTree& renderableTree = sceneElem->second->GetRenderableTree();
+            renderableTree.QueryFrustum(viewProjection, m_aVisibleProxies);
+            m_drawStatistics.uNumCulledRenderables += renderableTree.GetNumProxies() - static_cast<UINT>(m_aVisibleProxies.size());
+            m_drawStatistics.meshCullTime += std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - queryStart).count();
+            for (UINT uProxy : m_aVisibleProxies)
+            {
+                addDrawItems(*renderableTree.GetRenderable(uProxy), nullptr, eRenderPass::MESHES);
+            }
 
-                // Update the constant buffers 
-                CBChangesEveryFrame cbChangesEveryFrame =
-                {
-                    .World = XMMatrixTranspose(renderableElem->second->GetWorldMatrix()),
-                    .OutputColor = renderableElem->second->GetOutputColor(),
-                    .HasNormalMap = renderableElem->second->HasNormalMap()
-                };
-                m_immediateContext->UpdateSubresource(renderableElem->second->GetConstantBuffer().Get(), 0, nullptr, &cbChangesEveryFrame, 0, 0);
-
-                // Set shaders and constant buffers, shader resources, and samplers
-                m_immediateContext->VSSetShader(renderableElem->second->GetVertexShader().Get(), nullptr, 0);
-                m_immediateContext->VSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(1, 1, m_cbChangeOnResize.GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(2, 1, renderableElem->second->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-                m_immediateContext->PSSetShader(renderableElem->second->GetPixelShader().Get(), nullptr, 0);
-                m_immediateContext->PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(2, 1, renderableElem->second->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-
-                if (renderableElem->second->HasTexture())
-                {
-                    for (UINT i = 0; i < renderableElem->second->GetNumMeshes(); ++i)
-                    {
-                        UINT MaterialIndex = renderableElem->second->GetMesh(i).uMaterialIndex;
-
-                        if (renderableElem->second->GetMaterial(MaterialIndex)->pDiffuse)
-                        {
-                            eTextureSamplerType textureSamplerType = renderableElem->second->GetMaterial(MaterialIndex)->pDiffuse->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(0u, 1u, renderableElem->second->GetMaterial(MaterialIndex)->pDiffuse->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(0u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        if (renderableElem->second->GetMaterial(MaterialIndex)->pNormal)
-                        {
-                            eTextureSamplerType textureSamplerType = renderableElem->second->GetMaterial(MaterialIndex)->pNormal->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(1u, 1u, renderableElem->second->GetMaterial(MaterialIndex)->pNormal->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(1u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-
-                        // Draw
-                        m_immediateContext->DrawIndexed(renderableElem->second->GetMesh(i).uNumIndices,
-                            renderableElem->second->GetMesh(i).uBaseIndex,
-                            renderableElem->second->GetMesh(i).uBaseVertex);
-                    }
-                }
-                else
-                {
-                    // Draw
-                    m_immediateContext->DrawIndexed(renderableElem->second->GetNumIndices(), 0, 0);
-                }
+            for (auto modelElem = sceneElem->second->GetModels().begin();
+                modelElem != sceneElem->second->GetModels().end(); ++modelElem)
+            {
+                addDrawItems(*modelElem->second, modelElem->second->GetAnimationBuffer().Get(), eRenderPass::MESHES);
             }
 
-            for (auto voxelElem = sceneElem->second->GetVoxels().begin();
-                voxelElem != sceneElem->second->GetVoxels().end(); ++voxelElem)
+            if (m_scenes[m_pszMainSceneName]->GetSkyBox())
             {
-                // Set the vertex buffer
-                UINT aStrides[3] =
-                {
-                    sizeof(SimpleVertex),
-                    sizeof(NormalData),
-                    sizeof(InstanceData)
-                };
-                UINT aOffsets[3] = { 0u, 0u, 0u };
+                addDrawItems(*m_scenes[m_pszMainSceneName]->GetSkyBox(), nullptr, eRenderPass::SKYBOX);
+            }
 
-                ComPtr<ID3D11Buffer> aBuffers[3]
-                {
-                    voxelElem->get()->GetVertexBuffer(),
-                    voxelElem->get()->GetNormalBuffer(),
-                    voxelElem->get()->GetInstanceBuffer()
-                };
+            m_frustumCuller.Cull(viewProjection, m_aVisibleDrawItems);
+            m_drawQueue.RemoveHidden(m_aVisibleDrawItems);
+            m_drawStatistics.uNumCulledMeshDraws += m_frustumCuller.GetStatistics().uNumCulledBoxes;
+            m_drawStatistics.meshCullTime += m_frustumCuller.GetStatistics().cullTime;
 
-                // Set the vertex buffer
-                m_immediateContext->IASetVertexBuffers(0, 3, aBuffers->GetAddressOf(), aStrides, aOffsets);
+            batchDrawItems();
+            updateConstantBuffers();
+            m_drawQueue.Sort();
+            renderDrawItems();
+        }
 
-                // Set the index buffer
-                m_immediateContext->IASetIndexBuffer(voxelElem->get()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+        m_drawStatistics.uNumIssuedBinds += m_stateCache.GetCounters().uNumIssued;
+        m_drawStatistics.uNumSkippedBinds += m_stateCache.GetCounters().uNumSkipped;
+    }
 
-                // Set primitive topology
-                m_immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::Present
 
-                // Set the input layout
-                m_immediateContext->IASetInputLayout(voxelElem->get()->GetVertexLayout().Get());
+      Summary:  Presents the information rendered to the back buffer to
+                the front buffer (the screen)
 
-                // Update the constant buffers 
-                CBChangesEveryFrame cbChangesEveryFrame =
-                {
-                    .World = XMMatrixTranspose(voxelElem->get()->GetWorldMatrix()),
-                    .OutputColor = voxelElem->get()->GetOutputColor(),
-                    .HasNormalMap = voxelElem->get()->HasNormalMap()
-                };
-                m_immediateContext->UpdateSubresource(voxelElem->get()->GetConstantBuffer().Get(), 0, nullptr, &cbChangesEveryFrame, 0, 0);
-
-                // Set shaders and constant buffers, shader resources, and samplers
-                m_immediateContext->VSSetShader(voxelElem->get()->GetVertexShader().Get(), nullptr, 0);
-                m_immediateContext->VSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(1, 1, m_cbChangeOnResize.GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(2, 1, voxelElem->get()->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-                m_immediateContext->PSSetShader(voxelElem->get()->GetPixelShader().Get(), nullptr, 0);
-                m_immediateContext->PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(2, 1, voxelElem->get()->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-
-                if (voxelElem->get()->HasTexture())
-                {
-                    for (UINT i = 0; i < voxelElem->get()->GetNumMeshes(); ++i)
-                    {
-                        if (voxelElem->get()->GetMaterial(0)->pDiffuse)
-                        {
-                            eTextureSamplerType textureSamplerType = voxelElem->get()->GetMaterial(0)->pDiffuse->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(0u, 1u, voxelElem->get()->GetMaterial(0)->pDiffuse->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(0u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        if (voxelElem->get()->GetMaterial(0)->pNormal)
-                        {
-                            eTextureSamplerType textureSamplerType = voxelElem->get()->GetMaterial(0)->pNormal->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(1u, 1u, voxelElem->get()->GetMaterial(0)->pNormal->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(1u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-
-                        // Draw
-                        m_immediateContext->DrawIndexedInstanced(voxelElem->get()->GetNumIndices(),
-                            voxelElem->get()->GetNumInstances(), 0, 0, 0);
-                    }
-                }
+      Returns:  HRESULT
+                  Status code, S_FALSE without a swap chain
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Renderer::Present()
+    {
+        if (!m_swapChain)
+        {
+            return S_FALSE;
+        }
 
-                else
-                {
-                    // Draw
-                    m_immediateContext->DrawIndexedInstanced(voxelElem->get()->GetNumIndices(), voxelElem->get()->GetNumInstances(), 0, 0, 0);
-                }
-            }
+        return m_swapChain->Present(0, 0);
+    }
 
-            for (auto modelElem = sceneElem->second->GetModels().begin();
-                modelElem != sceneElem->second->GetModels().end(); ++modelElem)
-            {
-                // Set the vertex buffer
-                UINT aStrides[3] =
-                {
-                    sizeof(SimpleVertex),
-                    sizeof(NormalData),
-                    sizeof(AnimationData)
-                };
-                UINT aOffsets[3] = { 0u, 0u, 0u};
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::RenderSceneToTexture
 
-                ComPtr<ID3D11Buffer> aBuffers[3]
-                {
-                    modelElem->second->GetVertexBuffer(),
-                    modelElem->second->GetNormalBuffer(),
-                    modelElem->second->GetAnimationBuffer()
-                };
+      Summary:  Render scene to the texture. The constants of every
+                renderable, voxel and model are brought up to date like
+                those of the main pass, a static scene uploads none.
+                Without a shadow map, as when headless, only the depth
+                is written.
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    /*--------------------------------------------------------------------
+      TODO: Renderer::RenderSceneToTexture definition (remove the comment)
+    --------------------------------------------------------------------*/
 
-                // Set the vertex buffer
-                m_immediateContext->IASetVertexBuffers(0, 3, aBuffers->GetAddressOf(), aStrides, aOffsets);
+    void Renderer::RenderSceneToTexture()
+    {
+        if (!m_shadowVertexShader || !m_shadowPixelShader)
+        {
+            return;
+        }
 
-                // Set the index buffer 
-                m_immediateContext->IASetIndexBuffer(modelElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-
-                // Set primitive topology
-                m_immediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-                // Set the input layout
-                m_immediateContext->IASetInputLayout(modelElem->second->GetVertexLayout().Get());
-
-                CBChangesEveryFrame cbChangesEveryFrame =
-                {
-                    .World = XMMatrixTranspose(modelElem->second->GetWorldMatrix()),
-                    .OutputColor = modelElem->second->GetOutputColor(),
-                    .HasNormalMap = modelElem->second->HasNormalMap()
-                };
-                m_immediateContext->UpdateSubresource(modelElem->second->GetConstantBuffer().Get(), 0, nullptr, &cbChangesEveryFrame, 0, 0);
-
-                // Set shaders and constant buffers, shader resources, and samplers
-                m_immediateContext->VSSetShader(modelElem->second->GetVertexShader().Get(), nullptr, 0);
-                m_immediateContext->VSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(1, 1, m_cbChangeOnResize.GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(2, 1, modelElem->second->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-                m_immediateContext->PSSetShader(modelElem->second->GetPixelShader().Get(), nullptr, 0);
-                m_immediateContext->PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(2, 1, modelElem->second->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-
-                if (modelElem->second->HasTexture())
-                {
-                    for (UINT i = 0; i < modelElem->second->GetNumMeshes(); ++i)
-                    {
-                        UINT MaterialIndex = modelElem->second->GetMesh(i).uMaterialIndex;
-
-                        if (modelElem->second->GetMaterial(MaterialIndex)->pDiffuse)
-                        {
-                            eTextureSamplerType textureSamplerType = modelElem->second->GetMaterial(MaterialIndex)->pDiffuse->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(0u, 1u, modelElem->second->GetMaterial(MaterialIndex)->pDiffuse->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(0u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        if (modelElem->second->GetMaterial(MaterialIndex)->pNormal)
-                        {
-                            eTextureSamplerType textureSamplerType = modelElem->second->GetMaterial(MaterialIndex)->pNormal->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(1u, 1u, modelElem->second->GetMaterial(MaterialIndex)->pNormal->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(1u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        // Draw
-                        m_immediateContext->DrawIndexed(modelElem->second->GetMesh(i).uNumIndices,
-                            modelElem->second->GetMesh(i).uBaseIndex,
-                            modelElem->second->GetMesh(i).uBaseVertex);
-                    }
-                }
-                else
-                {
-                    // Draw
-                    m_immediateContext->DrawIndexed(modelElem->second->GetNumIndices(), 0, 0);
-                }
-            }
-
-            // Render Skybox 
-            if (m_scenes[m_pszMainSceneName]->GetSkyBox())
-            {
-                // Set the vertex buffer
-                UINT aStrides[2] =
-                {
-                    sizeof(SimpleVertex),
-                    sizeof(NormalData),
-                };
-                UINT aOffsets[2] = { 0u, 0u };
-
-                ComPtr<ID3D11Buffer> aBuffers[2]
-                {
-                    m_scenes[m_pszMainSceneName]->GetSkyBox()->GetVertexBuffer(), 
-                    m_scenes[m_pszMainSceneName]->GetSkyBox()->GetNormalBuffer()
-                };
-
-                // Set the vertex buffer
-                m_immediateContext->IASetVertexBuffers(0, 2, aBuffers->GetAddressOf(), aStrides, aOffsets);
-
-                // Set the index buffer 
-                m_immediateContext->IASetIndexBuffer(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-
-                // Set the input layout
-                m_immediateContext->IASetInputLayout(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetVertexLayout().Get());
+        //Unbind current pixel shader resources
+        ID3D11ShaderResourceView* const pSRV[2] = { NULL, NULL };
+        m_stateCache.PSSetShaderResources(0, 2, pSRV);
+        m_stateCache.PSSetShaderResources(2, 1, pSRV);
 
-                CBChangesEveryFrame cbChangesEveryFrame =
-                {
-                    .World = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetWorldMatrix()),
-                    .OutputColor = m_scenes[m_pszMainSceneName]->GetSkyBox()->GetOutputColor(),
-                    .HasNormalMap = m_scenes[m_pszMainSceneName]->GetSkyBox()->HasNormalMap()
-                };
-                m_immediateContext->UpdateSubresource(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetConstantBuffer().Get(), 0, nullptr, &cbChangesEveryFrame, 0, 0);
-
-                // Set shaders and constant buffers, shader resources, and samplers
-                m_immediateContext->VSSetShader(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetVertexShader().Get(), nullptr, 0);
-                m_immediateContext->VSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(1, 1, m_cbChangeOnResize.GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(2, 1, m_scenes[m_pszMainSceneName]->GetSkyBox()->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->VSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-                m_immediateContext->PSSetShader(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetPixelShader().Get(), nullptr, 0);
-                m_immediateContext->PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(2, 1, m_scenes[m_pszMainSceneName]->GetSkyBox()->GetConstantBuffer().GetAddressOf());
-                m_immediateContext->PSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
-
-                if (m_scenes[m_pszMainSceneName]->GetSkyBox()->HasTexture())
-                {
-                    for (UINT i = 0; i < m_scenes[m_pszMainSceneName]->GetSkyBox()->GetNumMeshes(); ++i)
-                    {
-                        UINT MaterialIndex = m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMesh(i).uMaterialIndex;
-
-                        if (m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pDiffuse)
-                        {
-                            eTextureSamplerType textureSamplerType = m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pDiffuse->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(3u, 1u, m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pDiffuse->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(3u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        if (m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pNormal)
-                        {
-                            eTextureSamplerType textureSamplerType = m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pNormal->GetSamplerType();
-                            m_immediateContext->PSSetShaderResources(4u, 1u, m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMaterial(MaterialIndex)->pNormal->GetTextureResourceView().GetAddressOf());
-                            m_immediateContext->PSSetSamplers(4u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
-                        }
-
-                        // Draw
-                        m_immediateContext->DrawIndexed(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMesh(i).uNumIndices,
-                            m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMesh(i).uBaseIndex,
-                            m_scenes[m_pszMainSceneName]->GetSkyBox()->GetMesh(i).uBaseVertex);
-                    }
-                }
-                else
-                {
-                    // Draw
-                    m_immediateContext->DrawIndexed(m_scenes[m_pszMainSceneName]->GetSkyBox()->GetNumIndices(), 0, 0);
-                }
-            }
+        if (m_shadowMapTexture)
+        {
+            m_stateCache.OMSetRenderTargets(1,
+                m_shadowMapTexture->GetRenderTargetView().GetAddressOf(),
+                m_depthStencilView.Get());
 
-            // Present the information rendered to the back buffer to the front buffer (the screen)
-            m_swapChain->Present(0, 0);
+            m_stateCache.ClearRenderTargetView(m_shadowMapTexture->GetRenderTargetView().Get(), Colors::White);
+        }
+        else
+        {
+            m_stateCache.OMSetRenderTargets(0, nullptr, m_depthStencilView.Get());
         }
-    }
 
-    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Renderer::RenderSceneToTexture
+        m_stateCache.ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-      Summary:  Render scene to the texture
-    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    /*--------------------------------------------------------------------
-      TODO: Renderer::RenderSceneToTexture definition (remove the comment)
-    --------------------------------------------------------------------*/
+        // The light matrices are shared, only the world matrix changes per object
+        XMMATRIX lightView = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetViewMatrix());
+        XMMATRIX lightProjection = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetProjectionMatrix());
 
-    void Renderer::RenderSceneToTexture()
-    {
-        //Unbind current pixel shader resources
-        ID3D11ShaderResourceView* const pSRV[2] = { NULL, NULL };
-        m_immediateContext->PSSetShaderResources(0, 2, pSRV);
-        m_immediateContext->PSSetShaderResources(2, 1, pSRV);
-
-        m_immediateContext->OMSetRenderTargets(1,
-            m_shadowMapTexture->GetRenderTargetView().GetAddressOf(),
-            m_depthStencilView.Get());
+        // The constants that changed are written under one map of the ring, in draw order
+        m_aPassConstants.clear();
+        for (auto renderableElem = m_scenes[m_pszMainSceneName]->GetRenderables().begin();
+            renderableElem != m_scenes[m_pszMainSceneName]->GetRenderables().end(); ++renderableElem)
+        {
+            updateShadowConstants(*renderableElem->second, lightView, lightProjection, FALSE);
+        }
 
-        m_immediateContext->ClearRenderTargetView(m_shadowMapTexture->GetRenderTargetView().Get(), Colors::White);
+        for (auto voxelElem = m_scenes[m_pszMainSceneName]->GetVoxels().begin();
+            voxelElem != m_scenes[m_pszMainSceneName]->GetVoxels().end(); ++voxelElem)
+        {
+            updateShadowConstants(*voxelElem->get(), lightView, lightProjection, TRUE);
+        }
 
-        m_immediateContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+        for (auto modelElem = m_scenes[m_pszMainSceneName]->GetModels().begin();
+            modelElem != m_scenes[m_pszMainSceneName]->GetModels().end(); ++modelElem)
+        {
+            updateShadowConstants(*modelElem->second, lightView, lightProjection, FALSE);
+        }
+        m_constantRing.Unmap(m_stateCache);
 
+        UINT uDrawIdx = 0u;
         for (auto renderableElem = m_scenes[m_pszMainSceneName]->GetRenderables().begin();
             renderableElem != m_scenes[m_pszMainSceneName]->GetRenderables().end(); ++renderableElem)
         {
             UINT uStride = sizeof(SimpleVertex);
             UINT uOffset = 0;
-            m_immediateContext->IASetVertexBuffers(0, 1, renderableElem->second->GetVertexBuffer().GetAddressOf(), &uStride, &uOffset);
-            m_immediateContext->IASetIndexBuffer(renderableElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
+            m_stateCache.IASetVertexBuffers(0, 1, renderableElem->second->GetVertexBuffer().GetAddressOf(), &uStride, &uOffset);
+            m_stateCache.IASetIndexBuffer(renderableElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_stateCache.IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
 
-            CBShadowMatrix cb =
-            {
-                .World = XMMatrixTranspose(renderableElem->second->GetWorldMatrix()),
-                .View = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetViewMatrix()),
-                .Projection = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetProjectionMatrix()),
-                .IsVoxel = FALSE
-            };
-            m_immediateContext->UpdateSubresource(m_cbShadowMatrix.Get(), 0, nullptr, &cb, 0, 0);
+            bindDrawConstants(0u, uDrawIdx++, renderableElem->second->GetShadowConstantBuffer().Get());
 
-            m_immediateContext->VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
-            m_immediateContext->VSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
-            m_immediateContext->PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
-            m_immediateContext->PSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
+            m_stateCache.VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
+            m_stateCache.PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
 
             for (UINT i = 0; i < renderableElem->second->GetNumMeshes(); ++i)
             {
                 // Draw
-                m_immediateContext->DrawIndexed(renderableElem->second->GetMesh(i).uNumIndices,
+                m_stateCache.DrawIndexed(renderableElem->second->GetMesh(i).uNumIndices,
                     renderableElem->second->GetMesh(i).uBaseIndex,
                     renderableElem->second->GetMesh(i).uBaseVertex);
             }
@@ -888,38 +946,29 @@ namespace library
             UINT aStrides[2] =
             {
                 sizeof(SimpleVertex),
-                sizeof(InstanceData),
+                voxelElem->get()->GetInstanceStride(),
             };
             UINT aOffsets[2] = { 0u, 0u };
 
-            ComPtr<ID3D11Buffer> aBuffers[2]
+            ID3D11Buffer* const aBuffers[2] =
             {
-                voxelElem->get()->GetVertexBuffer(),
-                voxelElem->get()->GetInstanceBuffer()
+                voxelElem->get()->GetVertexBuffer().Get(),
+                voxelElem->get()->GetInstanceBuffer().Get()
             };
 
-            m_immediateContext->IASetVertexBuffers(0, 2, aBuffers->GetAddressOf(), aStrides, aOffsets);
-            m_immediateContext->IASetIndexBuffer(voxelElem->get()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(voxelElem->get()->GetVertexLayout().Get());
+            m_stateCache.IASetVertexBuffers(0, 2, aBuffers, aStrides, aOffsets);
+            m_stateCache.IASetIndexBuffer(voxelElem->get()->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_stateCache.IASetInputLayout(m_shadowVertexShader->GetVertexLayout().Get());
 
-            CBShadowMatrix cb =
-            {
-                .World = XMMatrixTranspose(voxelElem->get()->GetWorldMatrix()),
-                .View = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetViewMatrix()),
-                .Projection = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetProjectionMatrix()),
-                .IsVoxel = TRUE
-            };
-            m_immediateContext->UpdateSubresource(m_cbShadowMatrix.Get(), 0, nullptr, &cb, 0, 0);
+            bindDrawConstants(0u, uDrawIdx++, voxelElem->get()->GetShadowConstantBuffer().Get());
 
-            m_immediateContext->VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
-            m_immediateContext->VSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
-            m_immediateContext->PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
-            m_immediateContext->PSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
+            m_stateCache.VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
+            m_stateCache.PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
 
             for (UINT i = 0; i < voxelElem->get()->GetNumMeshes(); ++i)
             {
                 // Draw
-                m_immediateContext->DrawIndexedInstanced(voxelElem->get()->GetNumIndices(),
+                m_stateCache.DrawIndexedInstanced(voxelElem->get()->GetNumIndices(),
                     voxelElem->get()->GetNumInstances(), voxelElem->get()->GetMesh(i).uBaseIndex,
                     voxelElem->get()->GetMesh(i).uBaseVertex, 0);
             }
@@ -936,45 +985,960 @@ namespace library
             };
             UINT aOffsets[3] = { 0u, 0u, 0u };
 
-            ComPtr<ID3D11Buffer> aBuffers[3]
+            ID3D11Buffer* const aBuffers[3] =
             {
-                modelElem->second->GetVertexBuffer(),
-                modelElem->second->GetNormalBuffer(),
-                modelElem->second->GetAnimationBuffer()
+                modelElem->second->GetVertexBuffer().Get(),
+                modelElem->second->GetNormalBuffer().Get(),
+                modelElem->second->GetAnimationBuffer().Get()
             };
 
-            m_immediateContext->IASetVertexBuffers(0, 3, aBuffers->GetAddressOf(), aStrides, aOffsets);
-            m_immediateContext->IASetIndexBuffer(modelElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_immediateContext->IASetInputLayout(modelElem->second->GetVertexLayout().Get());
+            m_stateCache.IASetVertexBuffers(0, 3, aBuffers, aStrides, aOffsets);
+            m_stateCache.IASetIndexBuffer(modelElem->second->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_stateCache.IASetInputLayout(modelElem->second->GetVertexLayout().Get());
 
-            CBShadowMatrix cb =
-            {
-                .World = XMMatrixTranspose(modelElem->second->GetWorldMatrix()),
-                .View = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetViewMatrix()),
-                .Projection = XMMatrixTranspose(m_scenes[m_pszMainSceneName]->GetPointLight(0)->GetProjectionMatrix()),
-                .IsVoxel = FALSE
-            };
-            m_immediateContext->UpdateSubresource(m_cbShadowMatrix.Get(), 0, nullptr, &cb, 0, 0);
+            bindDrawConstants(0u, uDrawIdx++, modelElem->second->GetShadowConstantBuffer().Get());
 
-            m_immediateContext->VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
-            m_immediateContext->VSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
-            m_immediateContext->PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
-            m_immediateContext->PSSetConstantBuffers(0, 1, m_cbShadowMatrix.GetAddressOf());
+            m_stateCache.VSSetShader(m_shadowVertexShader->GetVertexShader().Get(), nullptr, 0);
+            m_stateCache.PSSetShader(m_shadowPixelShader->GetPixelShader().Get(), nullptr, 0);
 
             for (UINT i = 0; i < modelElem->second->GetNumMeshes(); ++i)
             {
                 // Draw
-                m_immediateContext->DrawIndexed(
+                m_stateCache.DrawIndexed(
                     modelElem->second->GetMesh(i).uNumIndices,
                     modelElem->second->GetMesh(i).uBaseIndex,
                     modelElem->second->GetMesh(i).uBaseVertex);
             }
         }
 
-        m_immediateContext->OMSetRenderTargets(1,
+        m_stateCache.OMSetRenderTargets(1,
             m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::addDrawItems
+
+      Summary:  Queues a draw item for each mesh of a renderable, or one
+                for its whole index buffer if it has no texture, with
+                its world space bounds for the frustum culler. Skinned
+                models move their vertices on the GPU and the skybox
+                surrounds the camera, their draws are never culled.
+
+      Args:     Renderable& renderable
+                  Renderable to draw
+                ID3D11Buffer* pAnimationBuffer
+                  Third vertex stream of a skinned model, or nullptr
+                eRenderPass pass
+                  Pass of the draws
+
+      Modifies: [m_drawQueue, m_frustumCuller].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::addDrawItems(_In_ Renderable& renderable, _In_opt_ ID3D11Buffer* pAnimationBuffer, _In_ eRenderPass pass)
+    {
+        BOOL bCullable = !pAnimationBuffer && pass != eRenderPass::SKYBOX;
+
+        UINT uShaderId = m_drawQueue.GetShaderId(renderable.GetVertexShader().Get(), renderable.GetPixelShader().Get());
+        FLOAT depth = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(renderable.GetWorldMatrix().r[3], m_camera.GetEye())));
+
+        if (!renderable.HasTexture())
+        {
+            m_drawQueue.Add(
+                DrawItem
+                {
+                    .uSortKey = DrawQueue::MakeSortKey(pass, uShaderId, 0u, depth),
+                    .pRenderable = &renderable,
+                    .pAnimationBuffer = pAnimationBuffer,
+                    .uMeshIndex = DrawQueue::WHOLE_RENDERABLE
+                }
+            );
+            if (bCullable)
+            {
+                m_frustumCuller.Add(renderable.GetWorldBounds());
+            }
+            else
+            {
+                m_frustumCuller.AddUnbounded();
+            }
+            return;
+        }
+
+        for (UINT i = 0u; i < renderable.GetNumMeshes(); ++i)
+        {
+            const Material* pMaterial = renderable.GetMaterial(renderable.GetMesh(i).uMaterialIndex).get();
+            m_drawQueue.Add(
+                DrawItem
+                {
+                    .uSortKey = DrawQueue::MakeSortKey(pass, uShaderId, m_drawQueue.GetMaterialId(pMaterial), depth),
+                    .pRenderable = &renderable,
+                    .pAnimationBuffer = pAnimationBuffer,
+                    .uMeshIndex = i
+                }
+            );
+            if (bCullable)
+            {
+                m_frustumCuller.Add(renderable.GetMeshWorldBounds(i));
+            }
+            else
+            {
+                m_frustumCuller.AddUnbounded();
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::canInstance
+
+      Summary:  Returns whether a draw item can be drawn as an instance
+                of the instanced draw of another. Everything but the
+                world matrix comes from the first item, so both have to
+                draw the same mesh of the same geometry with the same
+                shaders, material, color and normal map flag.
+
+      Args:     const DrawItem& first
+                  First item of the instanced draw
+                const DrawItem& other
+                  Item to draw as an instance
+
+      Returns:  BOOL
+                  TRUE if the items can share an instanced draw
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Renderer::canInstance(_In_ const DrawItem& first, _In_ const DrawItem& other)
+    {
+        Renderable& firstRenderable = *first.pRenderable;
+        Renderable& otherRenderable = *other.pRenderable;
+        if (first.uMeshIndex != other.uMeshIndex
+            || firstRenderable.GetVertexShader().Get() != otherRenderable.GetVertexShader().Get()
+            || firstRenderable.GetPixelShader().Get() != otherRenderable.GetPixelShader().Get()
+            || firstRenderable.HasNormalMap() != otherRenderable.HasNormalMap()
+            || !XMVector4Equal(XMLoadFloat4(&firstRenderable.GetOutputColor()), XMLoadFloat4(&otherRenderable.GetOutputColor()))
+            || !firstRenderable.HasSameGeometry(otherRenderable))
+        {
+            return FALSE;
+        }
+
+        if (first.uMeshIndex == DrawQueue::WHOLE_RENDERABLE)
+        {
+            return TRUE;
+        }
+
+        return firstRenderable.GetMesh(first.uMeshIndex).uNumIndices == otherRenderable.GetMesh(other.uMeshIndex).uNumIndices
+            && firstRenderable.GetMesh(first.uMeshIndex).uBaseIndex == otherRenderable.GetMesh(other.uMeshIndex).uBaseIndex
+            && firstRenderable.GetMesh(first.uMeshIndex).uBaseVertex == otherRenderable.GetMesh(other.uMeshIndex).uBaseVertex
+            && firstRenderable.GetMaterial(firstRenderable.GetMesh(first.uMeshIndex).uMaterialIndex).get()
+                == otherRenderable.GetMaterial(otherRenderable.GetMesh(other.uMeshIndex).uMaterialIndex).get();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::batchDrawItems
+
+      Summary:  Merges the visible draw items that can share an
+                instanced draw, see canInstance, into the first of them
+                in the queue, which draws them all with the instanced
+                variant of its vertex shader. The world matrices of the
+                merged renderables are written into the instance stream,
+                the rest of the constants come from the first item.
+                Skinned models and the skybox are never merged, nor are
+                the renderables whose vertex shader has no instanced
+                variant.
+
+                The candidates are sorted by state, geometry and mesh,
+                so the items that may be merged form runs, and every
+                item of a run joins the first draw of the run it can be
+                merged into. Must be called before
+                updateConstantBuffers, the merged renderables need no
+                constants of their own.
+
+      Modifies: [m_drawQueue, m_aVisibleDrawItems, m_stateCache,
+                 m_aInstanceCandidates, m_aInstanceLeaders,
+                 m_aRunLeaders].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::batchDrawItems()
+    {
+        std::vector<DrawItem>& aItems = m_drawQueue.GetItems();
+        const UINT uNumItems = static_cast<UINT>(aItems.size());
+
+        m_aInstanceCandidates.clear();
+        for (UINT uItemIdx = 0u; uItemIdx < uNumItems; ++uItemIdx)
+        {
+            const DrawItem& item = aItems[uItemIdx];
+            if (!item.pAnimationBuffer
+                && DrawQueue::GetPass(item.uSortKey) == eRenderPass::MESHES
+                && item.pRenderable->GetInstancedVertexShader())
+            {
+                m_aInstanceCandidates.push_back(
+                    InstanceCandidate
+                    {
+                        .uStateKey = DrawQueue::GetStateKey(item.uSortKey),
+                        .uMeshIndex = item.uMeshIndex,
+                        .pGeometryKey = item.pRenderable->GetGeometryKey(),
+                        .uItemIdx = uItemIdx
+                    }
+                );
+            }
+        }
+
+        if (!m_instanceStream || m_aInstanceCandidates.size() < 2u)
+        {
+            return;
+        }
+
+        // The candidates of a run keep the order of the queue, so the first item of a draw comes first
+        std::sort(m_aInstanceCandidates.begin(), m_aInstanceCandidates.end(), [](const InstanceCandidate& a, const InstanceCandidate& b)
+        {
+            if (a.uStateKey != b.uStateKey)
+            {
+                return a.uStateKey < b.uStateKey;
+            }
+            if (a.pGeometryKey != b.pGeometryKey)
+            {
+                return std::less<const void*>()(a.pGeometryKey, b.pGeometryKey);
+            }
+            if (a.uMeshIndex != b.uMeshIndex)
+            {
+                return a.uMeshIndex < b.uMeshIndex;
+            }
+            return a.uItemIdx < b.uItemIdx;
+        });
+
+        InstanceData* pInstances = nullptr;
+        if (FAILED(m_stateCache.MapBuffer(m_instanceStream.Get(), D3D11_MAP_WRITE_DISCARD, MAX_STREAM_INSTANCES * sizeof(InstanceData), reinterpret_cast<void**>(&pInstances))))
+        {
+            return;
+        }
+
+        m_aVisibleDrawItems.assign(uNumItems, TRUE);
+        m_aInstanceLeaders.resize(uNumItems);
+        UINT uNumInstances = 0u;
+        size_t uRunBegin = 0u;
+        while (uRunBegin < m_aInstanceCandidates.size())
+        {
+            const InstanceCandidate& firstCandidate = m_aInstanceCandidates[uRunBegin];
+            size_t uRunEnd = uRunBegin + 1u;
+            while (uRunEnd < m_aInstanceCandidates.size()
+                && m_aInstanceCandidates[uRunEnd].uStateKey == firstCandidate.uStateKey
+                && m_aInstanceCandidates[uRunEnd].pGeometryKey == firstCandidate.pGeometryKey
+                && m_aInstanceCandidates[uRunEnd].uMeshIndex == firstCandidate.uMeshIndex)
+            {
+                ++uRunEnd;
+            }
+
+            // A run almost always is one draw, it only splits for different colors or materials
+            m_aRunLeaders.clear();
+            for (size_t uCandidateIdx = uRunBegin; uCandidateIdx < uRunEnd; ++uCandidateIdx)
+            {
+                UINT uItemIdx = m_aInstanceCandidates[uCandidateIdx].uItemIdx;
+                size_t uLeaderIdx = 0u;
+                while (uLeaderIdx < m_aRunLeaders.size() && !canInstance(aItems[m_aRunLeaders[uLeaderIdx]], aItems[uItemIdx]))
+                {
+                    ++uLeaderIdx;
+                }
+
+                if (uLeaderIdx == m_aRunLeaders.size())
+                {
+                    m_aRunLeaders.push_back(uItemIdx);
+                }
+                m_aInstanceLeaders[uItemIdx] = m_aRunLeaders[uLeaderIdx];
+                ++aItems[m_aRunLeaders[uLeaderIdx]].uNumInstances;
+            }
+
+            // A draw of one instance, or one that does not fit into the stream, stays a plain draw
+            for (UINT uLeader : m_aRunLeaders)
+            {
+                DrawItem& leader = aItems[uLeader];
+                if (leader.uNumInstances < 2u || leader.uNumInstances > MAX_STREAM_INSTANCES - uNumInstances)
+                {
+                    leader.uNumInstances = 0u;
+                    continue;
+                }
+
+                leader.uFirstInstance = uNumInstances;
+                uNumInstances += leader.uNumInstances;
+            }
+
+            // uFirstInstance points past the written instances until the run is done
+            for (size_t uCandidateIdx = uRunBegin; uCandidateIdx < uRunEnd; ++uCandidateIdx)
+            {
+                UINT uItemIdx = m_aInstanceCandidates[uCandidateIdx].uItemIdx;
+                DrawItem& leader = aItems[m_aInstanceLeaders[uItemIdx]];
+                if (leader.uNumInstances == 0u)
+                {
+                    continue;
+                }
+
+                pInstances[leader.uFirstInstance++].Transformation = aItems[uItemIdx].pRenderable->GetWorldMatrix();
+                m_aVisibleDrawItems[uItemIdx] = m_aInstanceLeaders[uItemIdx] == uItemIdx;
+            }
+
+            for (UINT uLeader : m_aRunLeaders)
+            {
+                aItems[uLeader].uFirstInstance -= aItems[uLeader].uNumInstances;
+            }
+
+            uRunBegin = uRunEnd;
+        }
+
+        m_stateCache.UnmapBuffer(m_instanceStream.Get());
+
+        // The merged items are drawn by the first item of their draw
+        m_drawQueue.RemoveHidden(m_aVisibleDrawItems);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::updateConstantBuffers
+
+      Summary:  Brings the constants of every renderable with a queued
+                draw item up to date and keeps the range of the constant
+                ring they were written to, if any, in its items. Must be
+                called before Sort, while the items of a renderable are
+                still next to each other.
+
+      Modifies: [m_drawQueue, m_drawStatistics, m_stateCache,
+                 m_constantRing].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::updateConstantBuffers()
+    {
+        Renderable* pUpdatedRenderable = nullptr;
+        UINT uFirstConstant = 0u;
+        UINT uNumConstants = 0u;
+        for (DrawItem& item : m_drawQueue.GetItems())
+        {
+            if (item.pRenderable != pUpdatedRenderable)
+            {
+                // Every mesh of the renderable draws with the same constants
+                pUpdatedRenderable = item.pRenderable;
+                updateRenderableConstants(*pUpdatedRenderable, uFirstConstant, uNumConstants);
+            }
+
+            item.uFirstConstant = uFirstConstant;
+            item.uNumConstants = uNumConstants;
+        }
+
+        m_constantRing.Unmap(m_stateCache);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::updateRenderableConstants
+
+      Summary:  Brings the constants of a renderable up to date.
+                Constants that changed since the last frame are written
+                into a range of the constant ring, so a renderable that
+                moves every frame never updates its own buffer. The
+                constant buffer of a renderable that stopped changing is
+                updated once and then bound as it is, a static renderable
+                costs no upload at all. The ring is mapped by the first
+                range and left mapped, the caller unmaps it before the
+                draws.
+
+      Args:     Renderable& renderable
+                  Renderable to update
+                UINT& uOutFirstConstant
+                  First constant of the range in the ring
+                UINT& uOutNumConstants
+                  Number of constants of the range, 0 if the constant
+                  buffer of the renderable is to be bound instead
+
+      Modifies: [m_drawStatistics, m_stateCache, m_constantRing].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::updateRenderableConstants(_In_ Renderable& renderable, _Out_ UINT& uOutFirstConstant, _Out_ UINT& uOutNumConstants)
+    {
+        uOutFirstConstant = 0u;
+        uOutNumConstants = 0u;
+
+        if (renderable.UpdateConstants())
+        {
+            if (!m_constantRing.IsMapped())
+            {
+                m_constantRing.Map(m_stateCache);
+            }
+
+            void* pConstants = m_constantRing.Allocate(sizeof(CBChangesEveryFrame), uOutFirstConstant, uOutNumConstants);
+            if (pConstants)
+            {
+                memcpy(pConstants, &renderable.GetConstants(), sizeof(CBChangesEveryFrame));
+                m_drawStatistics.uNumUploadedBytes += uOutNumConstants * ConstantRing::CONSTANT_SIZE;
+                return;
+            }
+
+            uOutFirstConstant = 0u;
+            uOutNumConstants = 0u;
+        }
+
+        m_drawStatistics.uNumUploadedBytes += renderable.UploadConstants(m_stateCache);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::renderDrawItems
+
+      Summary:  Submits the sorted draw items. With a recording thread
+                pool and enough items, the items are split into
+                contiguous ranges of about the same size that the pool
+                records in parallel on deferred contexts, each through
+                its own state cache. The command lists are then executed
+                in the order of the ranges, so the draws keep the order
+                of the queue. Otherwise, or without deferred contexts,
+                the items are recorded on the state cache. A range whose
+                command list could not be finished is recorded on the
+                state cache in its place.
+
+      Modifies: [m_drawStatistics, m_stateCache, m_aDrawRecorders].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::renderDrawItems()
+    {
+        UINT uNumItems = static_cast<UINT>(m_drawQueue.GetItems().size());
+        if (uNumItems == 0u)
+        {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        // A command list costs more than it saves for a few draws
+        UINT uNumCommandLists = m_recordingThreadPool ? uNumItems / MIN_DRAW_ITEMS_PER_COMMAND_LIST : 0u;
+        uNumCommandLists = uNumCommandLists < m_uNumRecordingContexts ? uNumCommandLists : m_uNumRecordingContexts;
+        while (m_aDrawRecorders.size() < uNumCommandLists)
+        {
+            std::unique_ptr<DrawRecorder> recorder = std::make_unique<DrawRecorder>();
+            if (FAILED(m_stateCache.CreateDeferredContext(recorder->deferredContext)))
+            {
+                break;
+            }
+            recorder->stateCache.SetNext(recorder->deferredContext);
+            m_aDrawRecorders.push_back(std::move(recorder));
+        }
+        uNumCommandLists = uNumCommandLists < m_aDrawRecorders.size() ? uNumCommandLists : static_cast<UINT>(m_aDrawRecorders.size());
+
+        if (uNumCommandLists <= 1u)
+        {
+            recordDrawItems(m_stateCache, 0u, uNumItems, m_drawStatistics);
+        }
+        else
+        {
+            m_recordingThreadPool->ParallelFor(uNumCommandLists, [this, uNumItems, uNumCommandLists](UINT uListIdx)
+            {
+                DrawRecorder& recorder = *m_aDrawRecorders[uListIdx];
+                recorder.uBeginItem = static_cast<UINT>(static_cast<UINT64>(uNumItems) * uListIdx / uNumCommandLists);
+                recorder.uEndItem = static_cast<UINT>(static_cast<UINT64>(uNumItems) * (uListIdx + 1u) / uNumCommandLists);
+                recorder.statistics = {};
+                recorder.stateCache.ResetCounters();
+
+                // A deferred context starts from a cleared state
+                recorder.stateCache.OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+                recorder.stateCache.RSSetViewports(1, &m_viewport);
+                recordDrawItems(recorder.stateCache, recorder.uBeginItem, recorder.uEndItem, recorder.statistics);
+                recorder.hr = recorder.stateCache.FinishCommandList();
+            });
+
+            for (UINT uListIdx = 0u; uListIdx < uNumCommandLists; ++uListIdx)
+            {
+                DrawRecorder& recorder = *m_aDrawRecorders[uListIdx];
+                if (FAILED(recorder.hr))
+                {
+                    m_stateCache.OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+                    m_stateCache.RSSetViewports(1, &m_viewport);
+                    recordDrawItems(m_stateCache, recorder.uBeginItem, recorder.uEndItem, m_drawStatistics);
+                    continue;
+                }
+
+                m_stateCache.ExecuteCommandList(*recorder.deferredContext);
+                ++m_drawStatistics.uNumCommandLists;
+                m_drawStatistics.uNumMeshDrawCalls += recorder.statistics.uNumMeshDrawCalls;
+                m_drawStatistics.uNumMeshStateChanges += recorder.statistics.uNumMeshStateChanges;
+                m_drawStatistics.uNumMeshInstances += recorder.statistics.uNumMeshInstances;
+                m_drawStatistics.uNumIssuedBinds += recorder.stateCache.GetCounters().uNumIssued;
+                m_drawStatistics.uNumSkippedBinds += recorder.stateCache.GetCounters().uNumSkipped;
+            }
+
+            // Executing a command list clears the state of the context
+            m_stateCache.OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+            m_stateCache.RSSetViewports(1, &m_viewport);
+        }
+
+        m_drawStatistics.meshRecordTime += std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::recordDrawItems
+
+      Summary:  Records a range of the sorted draw items. The topology,
+                the camera, projection and light constant buffers are
+                bound once, the shaders, the input layout, the buffers
+                of a renderable and every texture and sampler only when
+                they differ from the bound ones, so the state changes
+                follow the number of distinct states rather than the
+                number of draws. The textures of the skybox pass go to
+                slots 3 and 4, the others to slots 0 and 1. An item with
+                instances binds the instance stream as the third vertex
+                stream and draws with the instanced variant of the
+                vertex shader. Only reads
+                the renderer, so ranges may be recorded on several
+                threads at once.
+
+      Args:     GraphicsContext& context
+                  Context to record on
+                UINT uBeginItem
+                  First item of the range
+                UINT uEndItem
+                  Item past the last one of the range
+                DrawStatistics& statistics
+                  Counters of the range
+
+      Modifies: [statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::recordDrawItems(_In_ GraphicsContext& context, _In_ UINT uBeginItem, _In_ UINT uEndItem, _Inout_ DrawStatistics& statistics)
+    {
+        const std::vector<DrawItem>& aItems = m_drawQueue.GetItems();
+
+        // Set primitive topology
+        context.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        // Set the constant buffers shared by every draw
+        ID3D11Buffer* const aVertexConstantBuffers[2] = { m_camera.GetConstantBuffer().Get(), m_cbChangeOnResize.Get() };
+        context.VSSetConstantBuffers(0, 2, aVertexConstantBuffers);
+        context.VSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
+        context.PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
+        context.PSSetConstantBuffers(3, 1, m_cbLights.GetAddressOf());
+        statistics.uNumMeshStateChanges += 5u;
+
+        ID3D11VertexShader* pBoundVertexShader = nullptr;
+        ID3D11PixelShader* pBoundPixelShader = nullptr;
+        ID3D11InputLayout* pBoundInputLayout = nullptr;
+        const Renderable* pBoundRenderable = nullptr;
+        BOOL bBoundInstanced = FALSE;
+        ID3D11ShaderResourceView* apBoundViews[5] = { nullptr, };
+        ID3D11SamplerState* apBoundSamplers[5] = { nullptr, };
+        for (UINT uItemIdx = uBeginItem; uItemIdx < uEndItem; ++uItemIdx)
+        {
+            const DrawItem& item = aItems[uItemIdx];
+            Renderable& renderable = *item.pRenderable;
+            BOOL bInstanced = item.uNumInstances > 0u;
+            VertexShader* pVertexShader = bInstanced ? renderable.GetInstancedVertexShader().get() : nullptr;
+
+            ID3D11VertexShader* pItemVertexShader = pVertexShader ? pVertexShader->GetVertexShader().Get() : renderable.GetVertexShader().Get();
+            if (pItemVertexShader != pBoundVertexShader)
+            {
+                pBoundVertexShader = pItemVertexShader;
+                context.VSSetShader(pBoundVertexShader, nullptr, 0);
+                ++statistics.uNumMeshStateChanges;
+            }
+
+            if (renderable.GetPixelShader().Get() != pBoundPixelShader)
+            {
+                pBoundPixelShader = renderable.GetPixelShader().Get();
+                context.PSSetShader(pBoundPixelShader, nullptr, 0);
+                ++statistics.uNumMeshStateChanges;
+            }
+
+            ID3D11InputLayout* pItemInputLayout = pVertexShader ? pVertexShader->GetVertexLayout().Get() : renderable.GetVertexLayout().Get();
+            if (pItemInputLayout != pBoundInputLayout)
+            {
+                pBoundInputLayout = pItemInputLayout;
+                context.IASetInputLayout(pBoundInputLayout);
+                ++statistics.uNumMeshStateChanges;
+            }
+
+            if (&renderable != pBoundRenderable || bInstanced != bBoundInstanced)
+            {
+                pBoundRenderable = &renderable;
+                bBoundInstanced = bInstanced;
+
+                // Set the vertex buffers, skinned models and instanced draws have a third stream
+                UINT aStrides[3] =
+                {
+                    sizeof(SimpleVertex),
+                    sizeof(NormalData),
+                    static_cast<UINT>(bInstanced ? sizeof(InstanceData) : sizeof(AnimationData))
+                };
+                UINT aOffsets[3] = { 0u, 0u, 0u };
+
+                ID3D11Buffer* const aBuffers[3] =
+                {
+                    renderable.GetVertexBuffer().Get(),
+                    renderable.GetNormalBuffer().Get(),
+                    bInstanced ? m_instanceStream.Get() : item.pAnimationBuffer
+                };
+                context.IASetVertexBuffers(0, aBuffers[2] ? 3 : 2, aBuffers, aStrides, aOffsets);
+
+                // Set the index buffer
+                context.IASetIndexBuffer(renderable.GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+
+                if (item.uNumConstants > 0u)
+                {
+                    context.VSSetConstantBuffers1(2, 1, m_constantRing.GetBuffer().GetAddressOf(), &item.uFirstConstant, &item.uNumConstants);
+                    context.PSSetConstantBuffers1(2, 1, m_constantRing.GetBuffer().GetAddressOf(), &item.uFirstConstant, &item.uNumConstants);
+                }
+                else
+                {
+                    context.VSSetConstantBuffers(2, 1, renderable.GetConstantBuffer().GetAddressOf());
+                    context.PSSetConstantBuffers(2, 1, renderable.GetConstantBuffer().GetAddressOf());
+                }
+                statistics.uNumMeshStateChanges += 4u;
+            }
+
+            if (item.uMeshIndex == DrawQueue::WHOLE_RENDERABLE)
+            {
+                // Draw
+                if (bInstanced)
+                {
+                    context.DrawIndexedInstanced(renderable.GetNumIndices(), item.uNumInstances, 0, 0, item.uFirstInstance);
+                    statistics.uNumMeshInstances += item.uNumInstances;
+                }
+                else
+                {
+                    context.DrawIndexed(renderable.GetNumIndices(), 0, 0);
+                }
+                ++statistics.uNumMeshDrawCalls;
+                continue;
+            }
+
+            // Set the textures and samplers that differ from the bound ones
+            const Material* pMaterial = renderable.GetMaterial(renderable.GetMesh(item.uMeshIndex).uMaterialIndex).get();
+            const std::shared_ptr<Texture>* apTextures[2] = { &pMaterial->pDiffuse, &pMaterial->pNormal };
+            UINT uFirstSlot = DrawQueue::GetPass(item.uSortKey) == eRenderPass::SKYBOX ? 3u : 0u;
+            for (UINT uTextureIdx = 0u; uTextureIdx < 2u; ++uTextureIdx)
+            {
+                const std::shared_ptr<Texture>& texture = *apTextures[uTextureIdx];
+                if (!texture)
+                {
+                    continue;
+                }
+
+                UINT uSlot = uFirstSlot + uTextureIdx;
+                ID3D11ShaderResourceView* pView = texture->GetTextureResourceView().Get();
+                if (pView != apBoundViews[uSlot])
+                {
+                    apBoundViews[uSlot] = pView;
+                    context.PSSetShaderResources(uSlot, 1u, &pView);
+                    ++statistics.uNumMeshStateChanges;
+                }
+
+                ID3D11SamplerState* pSampler = Texture::s_samplers[static_cast<size_t>(texture->GetSamplerType())].Get();
+                if (pSampler != apBoundSamplers[uSlot])
+                {
+                    apBoundSamplers[uSlot] = pSampler;
+                    context.PSSetSamplers(uSlot, 1u, &pSampler);
+                    ++statistics.uNumMeshStateChanges;
+                }
+            }
+
+            // Draw
+            if (bInstanced)
+            {
+                context.DrawIndexedInstanced(renderable.GetMesh(item.uMeshIndex).uNumIndices, item.uNumInstances,
+                    renderable.GetMesh(item.uMeshIndex).uBaseIndex,
+                    renderable.GetMesh(item.uMeshIndex).uBaseVertex, item.uFirstInstance);
+                statistics.uNumMeshInstances += item.uNumInstances;
+            }
+            else
+            {
+                context.DrawIndexed(renderable.GetMesh(item.uMeshIndex).uNumIndices,
+                    renderable.GetMesh(item.uMeshIndex).uBaseIndex,
+                    renderable.GetMesh(item.uMeshIndex).uBaseVertex);
+            }
+            ++statistics.uNumMeshDrawCalls;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::renderVoxels
+
+      Summary:  Draws all instances of a list of voxels with one
+                instanced draw per voxel. The topology, the camera,
+                projection, light and palette constant buffers are
+                bound once for the list, the shaders, the input layout
+                and the textures only when they differ from the
+                previous voxel, so a map with blocks of every type is
+                one draw with only its buffers and world matrix bound.
+                The constants of all the voxels are written under one
+                map of the constant ring before the first draw.
+
+      Args:     const std::vector<std::shared_ptr<Voxel>>& voxels
+                  Voxels to draw
+                const ComPtr<ID3D11Buffer>& paletteBuffer
+                  Constant buffer of the block colors of the voxels
+
+      Modifies: [m_drawStatistics, m_stateCache, m_constantRing,
+                 m_aPassConstants].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::renderVoxels(_In_ const std::vector<std::shared_ptr<Voxel>>& voxels, _In_ const ComPtr<ID3D11Buffer>& paletteBuffer)
+    {
+        if (voxels.empty())
+        {
+            return;
+        }
+
+        // Set primitive topology
+        m_stateCache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        // Set the constant buffers shared by every voxel
+        ID3D11Buffer* const aVertexConstantBuffers[2] = { m_camera.GetConstantBuffer().Get(), m_cbChangeOnResize.Get() };
+        ID3D11Buffer* const aSharedConstantBuffers[2] = { m_cbLights.Get(), paletteBuffer.Get() };
+        m_stateCache.VSSetConstantBuffers(0, 2, aVertexConstantBuffers);
+        m_stateCache.VSSetConstantBuffers(3, 2, aSharedConstantBuffers);
+        m_stateCache.PSSetConstantBuffers(0, 1, m_camera.GetConstantBuffer().GetAddressOf());
+        m_stateCache.PSSetConstantBuffers(3, 2, aSharedConstantBuffers);
+        m_drawStatistics.uNumVoxelStateChanges += 5u;
+
+        // The colors come from the palette, only the world matrix of a voxel is its own
+        m_aPassConstants.clear();
+        for (const std::shared_ptr<Voxel>& voxel : voxels)
+        {
+            if (voxel->GetNumInstances() == 0u || !voxel->GetInstanceBuffer())
+            {
+                continue;
+            }
+
+            UINT uFirstConstant = 0u;
+            UINT uNumConstants = 0u;
+            updateRenderableConstants(*voxel, uFirstConstant, uNumConstants);
+            m_aPassConstants.emplace_back(uFirstConstant, uNumConstants);
+        }
+        m_constantRing.Unmap(m_stateCache);
+
+        UINT uDrawIdx = 0u;
+        ID3D11VertexShader* pBoundVertexShader = nullptr;
+        ID3D11PixelShader* pBoundPixelShader = nullptr;
+        const Material* pBoundMaterial = nullptr;
+        for (const std::shared_ptr<Voxel>& voxel : voxels)
+        {
+            if (voxel->GetNumInstances() == 0u || !voxel->GetInstanceBuffer())
+            {
+                continue;
+            }
+
+            if (voxel->GetVertexShader().Get() != pBoundVertexShader)
+            {
+                pBoundVertexShader = voxel->GetVertexShader().Get();
+                m_stateCache.VSSetShader(pBoundVertexShader, nullptr, 0);
+                m_stateCache.IASetInputLayout(voxel->GetVertexLayout().Get());
+                m_drawStatistics.uNumVoxelStateChanges += 2u;
+            }
+
+            if (voxel->GetPixelShader().Get() != pBoundPixelShader)
+            {
+                pBoundPixelShader = voxel->GetPixelShader().Get();
+                m_stateCache.PSSetShader(pBoundPixelShader, nullptr, 0);
+                ++m_drawStatistics.uNumVoxelStateChanges;
+            }
+
+            if (voxel->HasTexture() && voxel->GetMaterial(0).get() != pBoundMaterial)
+            {
+                pBoundMaterial = voxel->GetMaterial(0).get();
+                if (pBoundMaterial->pDiffuse)
+                {
+                    eTextureSamplerType textureSamplerType = pBoundMaterial->pDiffuse->GetSamplerType();
+                    m_stateCache.PSSetShaderResources(0u, 1u, pBoundMaterial->pDiffuse->GetTextureResourceView().GetAddressOf());
+                    m_stateCache.PSSetSamplers(0u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
+                    m_drawStatistics.uNumVoxelStateChanges += 2u;
+                }
+
+                if (pBoundMaterial->pNormal)
+                {
+                    eTextureSamplerType textureSamplerType = pBoundMaterial->pNormal->GetSamplerType();
+                    m_stateCache.PSSetShaderResources(1u, 1u, pBoundMaterial->pNormal->GetTextureResourceView().GetAddressOf());
+                    m_stateCache.PSSetSamplers(1u, 1u, Texture::s_samplers[static_cast<size_t>(textureSamplerType)].GetAddressOf());
+                    m_drawStatistics.uNumVoxelStateChanges += 2u;
+                }
+            }
+
+            // Set the vertex buffer
+            UINT aStrides[3] =
+            {
+                sizeof(SimpleVertex),
+                sizeof(NormalData),
+                voxel->GetInstanceStride()
+            };
+            UINT aOffsets[3] = { 0u, 0u, 0u };
+
+            ID3D11Buffer* const aBuffers[3] =
+            {
+                voxel->GetVertexBuffer().Get(),
+                voxel->GetNormalBuffer().Get(),
+                voxel->GetInstanceBuffer().Get()
+            };
+            m_stateCache.IASetVertexBuffers(0, 3, aBuffers, aStrides, aOffsets);
+
+            // Set the index buffer
+            m_stateCache.IASetIndexBuffer(voxel->GetIndexBuffer().Get(), DXGI_FORMAT_R16_UINT, 0);
+
+            // Bind the constants of the voxel
+            auto [uFirstConstant, uNumConstants] = m_aPassConstants[uDrawIdx++];
+            if (uNumConstants > 0u)
+            {
+                m_stateCache.VSSetConstantBuffers1(2, 1, m_constantRing.GetBuffer().GetAddressOf(), &uFirstConstant, &uNumConstants);
+                m_stateCache.PSSetConstantBuffers1(2, 1, m_constantRing.GetBuffer().GetAddressOf(), &uFirstConstant, &uNumConstants);
+            }
+            else
+            {
+                m_stateCache.VSSetConstantBuffers(2, 1, voxel->GetConstantBuffer().GetAddressOf());
+                m_stateCache.PSSetConstantBuffers(2, 1, voxel->GetConstantBuffer().GetAddressOf());
+            }
+            m_drawStatistics.uNumVoxelStateChanges += 5u;
+
+            // Draw
+            m_stateCache.DrawIndexedInstanced(voxel->GetNumIndices(), voxel->GetNumInstances(), 0, 0, 0);
+            ++m_drawStatistics.uNumVoxelDrawCalls;
+            m_drawStatistics.uNumVoxelInstances += voxel->GetNumInstances();
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::updateShadowConstants
+
+      Summary:  Brings the shadow pass constants of a renderable up to
+                date the way updateRenderableConstants does for the
+                main pass, and keeps the range of the next draw of the
+                pass in the ranges of the pass. Constants that changed
+                are written into a range of the constant ring, the
+                shadow constant buffer of a renderable that stopped
+                changing is updated once and then bound as it is. A
+                draw that gets no range keeps an empty one.
+
+      Args:     Renderable& renderable
+                  Renderable to update
+                const XMMATRIX& lightView
+                  Transposed view matrix of the light
+                const XMMATRIX& lightProjection
+                  Transposed projection matrix of the light
+                BOOL bIsVoxel
+                  Whether the draws are voxel instances
+
+      Modifies: [m_drawStatistics, m_stateCache, m_constantRing,
+                 m_aPassConstants].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::updateShadowConstants(_In_ Renderable& renderable, _In_ const XMMATRIX& lightView, _In_ const XMMATRIX& lightProjection, _In_ BOOL bIsVoxel)
+    {
+        if (renderable.UpdateShadowConstants(lightView, lightProjection, bIsVoxel)
+            && (m_constantRing.IsMapped() || SUCCEEDED(m_constantRing.Map(m_stateCache))))
+        {
+            UINT uFirstConstant = 0u;
+            UINT uNumConstants = 0u;
+            void* pConstants = m_constantRing.Allocate(sizeof(CBShadowMatrix), uFirstConstant, uNumConstants);
+            if (pConstants)
+            {
+                memcpy(pConstants, &renderable.GetShadowConstants(), sizeof(CBShadowMatrix));
+                m_drawStatistics.uNumUploadedBytes += uNumConstants * ConstantRing::CONSTANT_SIZE;
+                m_aPassConstants.emplace_back(uFirstConstant, uNumConstants);
+                return;
+            }
+        }
+
+        m_drawStatistics.uNumUploadedBytes += renderable.UploadShadowConstants(m_stateCache);
+        m_aPassConstants.emplace_back(0u, 0u);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::bindDrawConstants
+
+      Summary:  Binds the range of the constant ring a draw of the pass
+                was written to, to a slot of the vertex and pixel shader
+                stages. Without a range the constant buffer of the draw,
+                already up to date, is bound instead.
+
+      Args:     UINT uSlot
+                  Constant buffer slot of both stages
+                UINT uDraw
+                  Index of the draw in the pass
+                ID3D11Buffer* pBuffer
+                  Constant buffer of the draw
+
+      Modifies: [m_stateCache].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::bindDrawConstants(_In_ UINT uSlot, _In_ UINT uDraw, _In_opt_ ID3D11Buffer* pBuffer)
+    {
+        auto [uFirstConstant, uNumConstants] = m_aPassConstants[uDraw];
+        if (uNumConstants > 0u)
+        {
+            m_stateCache.VSSetConstantBuffers1(uSlot, 1, m_constantRing.GetBuffer().GetAddressOf(), &uFirstConstant, &uNumConstants);
+            m_stateCache.PSSetConstantBuffers1(uSlot, 1, m_constantRing.GetBuffer().GetAddressOf(), &uFirstConstant, &uNumConstants);
+            return;
+        }
+
+        m_stateCache.VSSetConstantBuffers(uSlot, 1, &pBuffer);
+        m_stateCache.PSSetConstantBuffers(uSlot, 1, &pBuffer);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::GetDrawStatistics
+
+      Summary:  Returns the draw counters of the last rendered frame
+
+      Returns:  const Renderer::DrawStatistics&
+                  Draw counters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const Renderer::DrawStatistics& Renderer::GetDrawStatistics() const
+    {
+        return m_drawStatistics;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::GetGraphicsContext
+
+      Summary:  Returns the context the frame is rendered through
+
+      Returns:  const std::shared_ptr<GraphicsContext>&
+                  Graphics context, nullptr before Initialize if none
+                  was set
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::shared_ptr<GraphicsContext>& Renderer::GetGraphicsContext() const
+    {
+        return m_graphicsContext;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::SetGraphicsContext
+
+      Summary:  Replaces the context the frame is rendered through, for
+                example with a RecordingGraphicsContext that wraps the
+                context of GetGraphicsContext to measure the frames, or
+                one without a next context to render headless.
+                Initialize with a window creates a D3D11GraphicsContext,
+                so a context set before it is replaced. The state cache stays
+                in front of the context, so it only sees the binds that
+                change the state. The deferred contexts of the old
+                context are released, the next parallel frame creates
+                them from the new one.
+
+      Args:     const std::shared_ptr<GraphicsContext>& graphicsContext
+                  Graphics context
+
+      Modifies: [m_graphicsContext, m_stateCache, m_aDrawRecorders].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::SetGraphicsContext(_In_ const std::shared_ptr<GraphicsContext>& graphicsContext)
+    {
+        m_graphicsContext = graphicsContext;
+        m_stateCache.SetNext(m_graphicsContext);
+        m_aDrawRecorders.clear();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Renderer::SetRecordingThreadPool
+
+      Summary:  Records the draw items of the frame on deferred contexts
+                on the threads of a pool, see renderDrawItems. Rendering
+                the same frame headless with and without a pool, each
+                time through a RecordingGraphicsContext, and calling
+                HasSameDraws checks that the parallel recording draws
+                in the same order as the serial one.
+
+      Args:     const std::shared_ptr<ThreadPool>& threadPool
+                  Pool to record on, nullptr records on the immediate
+                  context
+                UINT uNumRecordingContexts
+                  Most command lists of a frame, 0 picks one for every
+                  thread of the pool and one for the calling thread
+
+      Modifies: [m_recordingThreadPool, m_uNumRecordingContexts].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Renderer::SetRecordingThreadPool(_In_opt_ const std::shared_ptr<ThreadPool>& threadPool, _In_ UINT uNumRecordingContexts)
+    {
+        m_recordingThreadPool = threadPool;
+        m_uNumRecordingContexts = uNumRecordingContexts;
+        if (m_recordingThreadPool && m_uNumRecordingContexts == 0u)
+        {
+            m_uNumRecordingContexts = m_recordingThreadPool->GetNumThreads() + 1u;
+        }
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Renderer::GetDriverType
 
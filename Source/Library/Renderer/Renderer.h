@@ -16,11 +16,19 @@
 #include "Camera/Camera.h"
 #include "Light/PointLight.h"
 #include "Model/Model.h"
+#include "Renderer/ConstantRing.h"
+#include "Renderer/D3D11GraphicsContext.h"
 #include "Renderer/DataTypes.h"
+#include "Renderer/DrawQueue.h"
+#include "Renderer/FrustumCuller.h"
+#include "Renderer/GeometryRegistry.h"
 #include "Renderer/Renderable.h"
+#include "Renderer/StateCacheGraphicsContext.h"
 #include "Scene/Scene.h"
+#include "Scene/VoxelPhysics.h"
 #include "Shader/PixelShader.h"
 #include "Shader/VertexShader.h"
+#include "Thread/ThreadPool.h"
 #include "Window/MainWindow.h"
 #include "Texture/RenderTexture.h"
 #include "Shader/ShadowVertexShader.h"
@@ -34,15 +42,57 @@ namespace library
                 data onto the screen
 
       Methods:  Initialize
-                  Creates Direct3D device and swap chain
+                  Creates Direct3D device and swap chain, or renders
+                  headless through a graphics context
+                InitializeConstantRing
+                  Creates the ring of the per draw constants
                 AddRenderable
                   Add a renderable object and initialize the object
                 Update
                   Update the renderables each frame
                 Render
                   Renders the frame
+                Present
+                  Presents the rendered frame
                 GetDriverType
                   Returns the Direct3D driver type
+                GetDrawStatistics
+                  Returns the draw counters of the last frame
+                GetGraphicsContext
+                  Returns the context the frame is rendered through
+                SetGraphicsContext
+                  Replaces the context the frame is rendered through
+                SetRecordingThreadPool
+                  Records the draw items on deferred contexts in
+                  parallel
+                SetWalkMode
+                  Switches the camera between flying and walking on
+                  the blocks
+                createFrameBuffers
+                  Creates the constant buffers and the instance stream
+                  of the frame
+                addDrawItems
+                  Queues the draws of the meshes of a renderable
+                batchDrawItems
+                  Merges the draw items that can be drawn instanced
+                canInstance
+                  Returns whether two draw items can share an
+                  instanced draw
+                updateConstantBuffers
+                  Updates the constant buffers of the queued renderables
+                updateRenderableConstants
+                  Brings the constants of a renderable up to date
+                renderDrawItems
+                  Submits the sorted draw items
+                recordDrawItems
+                  Records a range of the sorted draw items
+                renderVoxels
+                  Draws all instances of a list of voxels
+                updateShadowConstants
+                  Brings the shadow pass constants of a renderable up
+                  to date
+                bindDrawConstants
+                  Binds the constants of a draw of a pass
                 Renderer
                   Constructor.
                 ~Renderer
@@ -50,6 +100,46 @@ namespace library
     C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
     class Renderer final
     {
+    public:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   DrawStatistics
+
+            Summary:  Counters of the mesh and voxel passes of the last
+                      rendered frame. A state change is one bind,
+                      constant buffer update or topology call on the
+                      context. The binds of the frame that the state
+                      cache issued and skipped are counted apart, as
+                      are the renderables the renderable tree of the
+                      scene found outside of the view frustum, the mesh
+                      draws of the others outside of it and the time
+                      spent testing both in milliseconds.
+                      The uploaded bytes are the constants written to
+                      the GPU, by buffer updates or into the constant
+                      ring. The mesh draws recorded on deferred contexts
+                      are counted with the command lists that executed
+                      them, the recording time is the wall time of the
+                      mesh draws in milliseconds, command lists
+                      included. The mesh instances are the renderables
+                      drawn by instanced mesh draws.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct DrawStatistics
+        {
+            UINT uNumMeshDrawCalls;
+            UINT uNumMeshStateChanges;
+            UINT uNumVoxelDrawCalls;
+            UINT uNumVoxelStateChanges;
+            UINT uNumVoxelInstances;
+            UINT uNumIssuedBinds;
+            UINT uNumSkippedBinds;
+            UINT uNumCulledRenderables;
+            UINT uNumCulledMeshDraws;
+            FLOAT meshCullTime;
+            UINT uNumUploadedBytes;
+            UINT uNumCommandLists;
+            FLOAT meshRecordTime;
+            UINT uNumMeshInstances;
+        };
+
     public:
         Renderer();
         Renderer(const Renderer& other) = delete;
@@ -59,6 +149,8 @@ namespace library
         ~Renderer() = default;
 
         HRESULT Initialize(_In_ HWND hWnd);
+        HRESULT Initialize(_In_ const std::shared_ptr<GraphicsContext>& graphicsContext, _In_ UINT uWidth, _In_ UINT uHeight);
+        HRESULT InitializeConstantRing(_In_ UINT uSize = ConstantRing::DEFAULT_SIZE);
 
         HRESULT AddScene(_In_ PCWSTR pszSceneName, _In_ const std::shared_ptr<Scene>& scene);
         std::shared_ptr<Scene> GetSceneOrNull(_In_ PCWSTR pszSceneName);
@@ -68,9 +160,73 @@ namespace library
         void HandleInput(_In_ const DirectionsInput& directions, _In_ const MouseRelativeMovement& mouseRelativeMovement, _In_ FLOAT deltaTime);
         void Update(_In_ FLOAT deltaTime);
         void Render();
+        HRESULT Present();
         void RenderSceneToTexture();
 
         D3D_DRIVER_TYPE GetDriverType() const;
+        const DrawStatistics& GetDrawStatistics() const;
+        const std::shared_ptr<GraphicsContext>& GetGraphicsContext() const;
+        void SetGraphicsContext(_In_ const std::shared_ptr<GraphicsContext>& graphicsContext);
+        void SetRecordingThreadPool(_In_opt_ const std::shared_ptr<ThreadPool>& threadPool, _In_ UINT uNumRecordingContexts = 0u);
+
+        void SetWalkMode(_In_ BOOL bWalkMode);
+        BOOL IsWalkMode() const;
+
+    private:
+        static constexpr const FLOAT WALK_SPEED = 10.0f;
+        static constexpr const FLOAT JUMP_SPEED = 12.0f;
+        static constexpr const XMFLOAT3 WALKER_HALF_EXTENTS = XMFLOAT3(0.6f, 1.8f, 0.6f);
+        // Height of the eye above the center of the walker box
+        static constexpr const FLOAT WALKER_EYE_HEIGHT = 1.5f;
+        // Fewer draw items per command list are recorded on the immediate context
+        static constexpr const UINT MIN_DRAW_ITEMS_PER_COMMAND_LIST = 64u;
+        // Instances of the frame past the stream are drawn one by one
+        static constexpr const UINT MAX_STREAM_INSTANCES = 1u << 14u;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   InstanceCandidate
+
+            Summary:  Draw item that may be drawn instanced, with the
+                      fields the candidates are grouped by
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct InstanceCandidate
+        {
+            UINT uStateKey;
+            UINT uMeshIndex;
+            const void* pGeometryKey;
+            UINT uItemIdx;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   DrawRecorder
+
+            Summary:  Deferred context that records a range of the draw
+                      items on a thread of the recording pool, with its
+                      own state cache, the range and its counters, and
+                      the status of FinishCommandList
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct DrawRecorder
+        {
+            std::shared_ptr<GraphicsContext> deferredContext;
+            StateCacheGraphicsContext stateCache;
+            UINT uBeginItem;
+            UINT uEndItem;
+            DrawStatistics statistics;
+            HRESULT hr;
+        };
+
+        static BOOL canInstance(_In_ const DrawItem& first, _In_ const DrawItem& other);
+
+        HRESULT createFrameBuffers(_In_ UINT uWidth, _In_ UINT uHeight);
+        void addDrawItems(_In_ Renderable& renderable, _In_opt_ ID3D11Buffer* pAnimationBuffer, _In_ eRenderPass pass);
+        void batchDrawItems();
+        void renderDrawItems();
+        void recordDrawItems(_In_ GraphicsContext& context, _In_ UINT uBeginItem, _In_ UINT uEndItem, _Inout_ DrawStatistics& statistics);
+        void updateConstantBuffers();
+        void updateRenderableConstants(_In_ Renderable& renderable, _Out_ UINT& uOutFirstConstant, _Out_ UINT& uOutNumConstants);
+        void renderVoxels(_In_ const std::vector<std::shared_ptr<Voxel>>& voxels, _In_ const ComPtr<ID3D11Buffer>& paletteBuffer);
+        void updateShadowConstants(_In_ Renderable& renderable, _In_ const XMMATRIX& lightView, _In_ const XMMATRIX& lightProjection, _In_ BOOL bIsVoxel);
+        void bindDrawConstants(_In_ UINT uSlot, _In_ UINT uDraw, _In_opt_ ID3D11Buffer* pBuffer);
 
     private:
         D3D_DRIVER_TYPE m_driverType;
@@ -84,18 +240,47 @@ namespace library
         ComPtr<ID3D11RenderTargetView> m_renderTargetView;
         ComPtr<ID3D11Texture2D> m_depthStencil;
         ComPtr<ID3D11DepthStencilView> m_depthStencilView;
+        D3D11_VIEWPORT m_viewport;
         ComPtr<ID3D11Buffer> m_cbChangeOnResize;
         ComPtr<ID3D11Buffer> m_cbLights;
-        ComPtr<ID3D11Buffer> m_cbShadowMatrix;
         PCWSTR m_pszMainSceneName;
         BYTE m_padding[8];
         Camera m_camera;
         XMMATRIX m_projection;
 
         std::unordered_map<std::wstring, std::shared_ptr<Scene>> m_scenes;
+        // Buffers of the geometry the renderables of m_d3dDevice share, released with the renderer
+        GeometryRegistry m_geometryRegistry;
         std::shared_ptr<Texture> m_invalidTexture;
         std::shared_ptr<RenderTexture> m_shadowMapTexture;
         std::shared_ptr<ShadowVertexShader> m_shadowVertexShader;
         std::shared_ptr<PixelShader> m_shadowPixelShader;
+        VoxelPhysics m_physics;
+        VoxelBody m_walker;
+        BOOL m_bWalkMode;
+        DrawStatistics m_drawStatistics;
+        std::shared_ptr<GraphicsContext> m_graphicsContext;
+        DrawQueue m_drawQueue;
+        // Renderables of the scene tree in the frustum, only their meshes are queued
+        std::vector<UINT> m_aVisibleProxies;
+        // One box per queued draw item, in the order they are queued
+        FrustumCuller m_frustumCuller;
+        std::vector<BOOL> m_aVisibleDrawItems;
+        // Every frame bind goes through the cache, which forwards to m_graphicsContext
+        StateCacheGraphicsContext m_stateCache;
+        // Per draw constants of the frame, empty without constant buffer offsetting
+        ConstantRing m_constantRing;
+        // First constant and number of constants in the ring of every draw of the voxel or shadow pass
+        std::vector<std::pair<UINT, UINT>> m_aPassConstants;
+        // World matrices of the instanced mesh draws of the frame
+        ComPtr<ID3D11Buffer> m_instanceStream;
+        std::vector<InstanceCandidate> m_aInstanceCandidates;
+        // First item of the instanced draw of every draw item
+        std::vector<UINT> m_aInstanceLeaders;
+        std::vector<UINT> m_aRunLeaders;
+        // The draw items are recorded on the state cache without a pool
+        std::shared_ptr<ThreadPool> m_recordingThreadPool;
+        UINT m_uNumRecordingContexts;
+        std::vector<std::unique_ptr<DrawRecorder>> m_aDrawRecorders;
     };
 }
\ No newline at end of file
@@ -37,6 +37,8 @@ namespace library
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
+                GeometryRegistry* pGeometryRegistry
+                  Shared buffers of the device, may be nullptr
 
       Modifies: [m_aMeshes, m_aMaterials].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
@@ -44,11 +46,11 @@ namespace library
       TODO: Skybox::Initialize definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    HRESULT Skybox::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    HRESULT Skybox::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry)
     {
         HRESULT hr = S_OK;
 
-        hr = Model::Initialize(pDevice, pImmediateContext);
+        hr = Model::Initialize(pDevice, pImmediateContext, pGeometryRegistry);
         if (FAILED(hr))
             return hr;
 
@@ -0,0 +1,738 @@
+#include "Renderer/StateCacheGraphicsContext.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::StateCacheGraphicsContext
+
+      Summary:  Constructor
+
+      Args:     const std::shared_ptr<GraphicsContext>& next
+                  Context to forward the binds to, it has to be set
+                  with SetNext before the first call if nullptr
+
+      Modifies: [m_next, m_counters, m_uKnownStates, m_topology, m_pInputLayout,
+                  m_pIndexBuffer, m_indexFormat, m_uIndexOffset,
+                  m_pVertexShader, m_pPixelShader, m_vertexBuffers,
+                  m_auStrides, m_auOffsets, m_vsConstantBuffers,
+                  m_psConstantBuffers, m_psShaderResources, m_psSamplers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    StateCacheGraphicsContext::StateCacheGraphicsContext(_In_opt_ const std::shared_ptr<GraphicsContext>& next)
+        : m_next(next)
+        , m_counters()
+        , m_uKnownStates(0u)
+        , m_topology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
+        , m_pInputLayout(nullptr)
+        , m_pIndexBuffer(nullptr)
+        , m_indexFormat(DXGI_FORMAT_UNKNOWN)
+        , m_uIndexOffset(0u)
+        , m_pVertexShader(nullptr)
+        , m_pPixelShader(nullptr)
+        , m_vertexBuffers()
+        , m_auStrides()
+        , m_auOffsets()
+        , m_vsConstantBuffers()
+        , m_psConstantBuffers()
+        , m_psShaderResources()
+        , m_psSamplers()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::GetCounters
+
+      Summary:  Returns the binds issued and skipped since the last
+                reset
+
+      Returns:  const StateCacheGraphicsContext::Counters&
+                  Counters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const StateCacheGraphicsContext::Counters& StateCacheGraphicsContext::GetCounters() const
+    {
+        return m_counters;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::GetNext
+
+      Summary:  Returns the context the binds are forwarded to
+
+      Returns:  const std::shared_ptr<GraphicsContext>&
+                  Next context
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::shared_ptr<GraphicsContext>& StateCacheGraphicsContext::GetNext() const
+    {
+        return m_next;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::Invalidate
+
+      Summary:  Forgets the shadowed state, so the next bind of every
+                state is issued
+
+      Modifies: [m_uKnownStates, m_vertexBuffers, m_vsConstantBuffers,
+                  m_psConstantBuffers, m_psShaderResources, m_psSamplers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::Invalidate()
+    {
+        m_uKnownStates = 0u;
+        m_vertexBuffers.uKnownSlots = 0u;
+        m_vsConstantBuffers.uKnownSlots = 0u;
+        m_psConstantBuffers.uKnownSlots = 0u;
+        m_psShaderResources.uKnownSlots = 0u;
+        m_psSamplers.uKnownSlots = 0u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::ResetCounters
+
+      Summary:  Zeroes the counters, typically at the start of a frame
+
+      Modifies: [m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::ResetCounters()
+    {
+        m_counters = {};
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::SetNext
+
+      Summary:  Sets the context the binds are forwarded to and forgets
+                the shadowed state
+
+      Args:     const std::shared_ptr<GraphicsContext>& next
+                  Next context
+
+      Modifies: [m_next, m_uKnownStates, m_vertexBuffers,
+                  m_vsConstantBuffers, m_psConstantBuffers,
+                  m_psShaderResources, m_psSamplers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::SetNext(_In_ const std::shared_ptr<GraphicsContext>& next)
+    {
+        m_next = next;
+        Invalidate();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::ClearDepthStencilView
+
+      Summary:  Forwards the clear of a depth stencil view
+
+      Args:     ID3D11DepthStencilView* pDepthStencilView
+                  View to clear
+                UINT uClearFlags
+                  D3D11_CLEAR_FLAG bits
+                FLOAT depth
+                  Depth to clear to
+                UINT8 stencil
+                  Stencil to clear to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil)
+    {
+        m_next->ClearDepthStencilView(pDepthStencilView, uClearFlags, depth, stencil);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::ClearRenderTargetView
+
+      Summary:  Forwards the clear of a render target view
+
+      Args:     ID3D11RenderTargetView* pRenderTargetView
+                  View to clear
+                const FLOAT aColorRGBA[4]
+                  Color to clear to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4])
+    {
+        m_next->ClearRenderTargetView(pRenderTargetView, aColorRGBA);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::CreateBuffer
+
+      Summary:  Forwards the creation of a buffer
+
+      Args:     const D3D11_BUFFER_DESC* pDesc
+                  Description of the buffer
+                ID3D11Buffer** ppBuffer
+                  Receives the buffer
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT StateCacheGraphicsContext::CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer)
+    {
+        return m_next->CreateBuffer(pDesc, ppBuffer);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::CreateDeferredContext
+
+      Summary:  Forwards the creation of a deferred context, the binds
+                of the deferred context do not go through this cache
+
+      Args:     std::shared_ptr<GraphicsContext>& outDeferredContext
+                  Receives the deferred context
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT StateCacheGraphicsContext::CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext)
+    {
+        return m_next->CreateDeferredContext(outDeferredContext);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::DrawIndexed
+
+      Summary:  Forwards a draw of indexed primitives
+
+      Args:     UINT uIndexCount
+                  Number of indices
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation)
+    {
+        m_next->DrawIndexed(uIndexCount, uStartIndexLocation, baseVertexLocation);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::DrawIndexedInstanced
+
+      Summary:  Forwards a draw of instances of indexed primitives
+
+      Args:     UINT uIndexCountPerInstance
+                  Number of indices of an instance
+                UINT uInstanceCount
+                  Number of instances
+                UINT uStartIndexLocation
+                  First index
+                INT baseVertexLocation
+                  Value added to every index
+                UINT uStartInstanceLocation
+                  First instance
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation)
+    {
+        m_next->DrawIndexedInstanced(uIndexCountPerInstance, uInstanceCount, uStartIndexLocation, baseVertexLocation, uStartInstanceLocation);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::ExecuteCommandList
+
+      Summary:  Forwards the execution of a deferred context and forgets
+                the shadow, since the execution clears the state
+
+      Args:     GraphicsContext& deferredContext
+                  Deferred context created by the next context
+
+      Modifies: [m_uKnownStates, m_vertexBuffers, m_vsConstantBuffers,
+                  m_psConstantBuffers, m_psShaderResources, m_psSamplers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::ExecuteCommandList(_In_ GraphicsContext& deferredContext)
+    {
+        m_next->ExecuteCommandList(deferredContext);
+        Invalidate();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::FinishCommandList
+
+      Summary:  Forwards the end of the recording of a deferred context
+                and forgets the shadow, since finishing clears the state
+
+      Modifies: [m_uKnownStates, m_vertexBuffers, m_vsConstantBuffers,
+                  m_psConstantBuffers, m_psShaderResources, m_psSamplers].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT StateCacheGraphicsContext::FinishCommandList()
+    {
+        HRESULT hr = m_next->FinishCommandList();
+        Invalidate();
+        return hr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::IASetIndexBuffer
+
+      Summary:  Binds the index buffer if it, its format or its offset
+                differ from the bound ones
+
+      Args:     ID3D11Buffer* pIndexBuffer
+                  Index buffer
+                DXGI_FORMAT format
+                  Format of the indices
+                UINT uOffset
+                  Offset of the first index in bytes
+
+      Modifies: [m_counters, m_uKnownStates, m_pIndexBuffer, m_indexFormat,
+                  m_uIndexOffset].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset)
+    {
+        if ((m_uKnownStates & KNOWN_INDEX_BUFFER) && m_pIndexBuffer == pIndexBuffer && m_indexFormat == format && m_uIndexOffset == uOffset)
+        {
+            count(FALSE);
+            return;
+        }
+
+        m_uKnownStates |= KNOWN_INDEX_BUFFER;
+        m_pIndexBuffer = pIndexBuffer;
+        m_indexFormat = format;
+        m_uIndexOffset = uOffset;
+        count(TRUE);
+        m_next->IASetIndexBuffer(pIndexBuffer, format, uOffset);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::IASetInputLayout
+
+      Summary:  Binds the input layout if it differs from the bound one
+
+      Args:     ID3D11InputLayout* pInputLayout
+                  Input layout
+
+      Modifies: [m_counters, m_uKnownStates, m_pInputLayout].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout)
+    {
+        if ((m_uKnownStates & KNOWN_INPUT_LAYOUT) && m_pInputLayout == pInputLayout)
+        {
+            count(FALSE);
+            return;
+        }
+
+        m_uKnownStates |= KNOWN_INPUT_LAYOUT;
+        m_pInputLayout = pInputLayout;
+        count(TRUE);
+        m_next->IASetInputLayout(pInputLayout);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::IASetPrimitiveTopology
+
+      Summary:  Sets the primitive topology if it differs from the set
+                one
+
+      Args:     D3D11_PRIMITIVE_TOPOLOGY topology
+                  Primitive topology
+
+      Modifies: [m_counters, m_uKnownStates, m_topology].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology)
+    {
+        if ((m_uKnownStates & KNOWN_TOPOLOGY) && m_topology == topology)
+        {
+            count(FALSE);
+            return;
+        }
+
+        m_uKnownStates |= KNOWN_TOPOLOGY;
+        m_topology = topology;
+        count(TRUE);
+        m_next->IASetPrimitiveTopology(topology);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::IASetVertexBuffers
+
+      Summary:  Binds the vertex buffers whose buffer, stride or offset
+                differ from the bound ones
+
+      Args:     UINT uStartSlot
+                  First input slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppVertexBuffers
+                  Vertex buffers
+                const UINT* pStrides
+                  Stride of every buffer
+                const UINT* pOffsets
+                  Offset of every buffer
+
+      Modifies: [m_counters, m_vertexBuffers, m_auStrides, m_auOffsets].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets)
+    {
+        if (uStartSlot + uNumBuffers > NUM_CACHED_SLOTS)
+        {
+            for (UINT uSlot = uStartSlot; uSlot < NUM_CACHED_SLOTS; ++uSlot)
+            {
+                m_vertexBuffers.uKnownSlots &= ~(1u << uSlot);
+            }
+            count(TRUE);
+            m_next->IASetVertexBuffers(uStartSlot, uNumBuffers, ppVertexBuffers, pStrides, pOffsets);
+            return;
+        }
+
+        UINT uFirstChanged = uNumBuffers;
+        UINT uLastChanged = 0u;
+        for (UINT uBufferIdx = 0u; uBufferIdx < uNumBuffers; ++uBufferIdx)
+        {
+            UINT uSlot = uStartSlot + uBufferIdx;
+            if (!(m_vertexBuffers.uKnownSlots & (1u << uSlot))
+                || m_vertexBuffers.apObjects[uSlot] != ppVertexBuffers[uBufferIdx]
+                || m_auStrides[uSlot] != pStrides[uBufferIdx]
+                || m_auOffsets[uSlot] != pOffsets[uBufferIdx])
+            {
+                m_vertexBuffers.apObjects[uSlot] = ppVertexBuffers[uBufferIdx];
+                m_vertexBuffers.uKnownSlots |= 1u << uSlot;
+                m_auStrides[uSlot] = pStrides[uBufferIdx];
+                m_auOffsets[uSlot] = pOffsets[uBufferIdx];
+                uFirstChanged = uFirstChanged < uBufferIdx ? uFirstChanged : uBufferIdx;
+                uLastChanged = uBufferIdx;
+            }
+        }
+
+        if (uFirstChanged == uNumBuffers)
+        {
+            count(FALSE);
+            return;
+        }
+
+        count(TRUE);
+        m_next->IASetVertexBuffers(uStartSlot + uFirstChanged, uLastChanged - uFirstChanged + 1u,
+            ppVertexBuffers + uFirstChanged, pStrides + uFirstChanged, pOffsets + uFirstChanged);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::MapBuffer
+
+      Summary:  Forwards the map of a buffer
+
+      Args:     ID3D11Buffer* pBuffer
+                  Buffer to map
+                D3D11_MAP mapType
+                  D3D11_MAP_WRITE_DISCARD or D3D11_MAP_WRITE_NO_OVERWRITE
+                UINT uNumBytes
+                  Number of bytes that will be written
+                void** ppData
+                  Receives the mapped memory
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT StateCacheGraphicsContext::MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData)
+    {
+        return m_next->MapBuffer(pBuffer, mapType, uNumBytes, ppData);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::OMSetRenderTargets
+
+      Summary:  Binds render targets and a depth stencil view, always
+                forwarded. The shadow of the shader resources is
+                forgotten, since Direct3D unbinds the views of a
+                resource bound as a render target.
+
+      Args:     UINT uNumViews
+                  Number of render targets
+                ID3D11RenderTargetView* const* ppRenderTargetViews
+                  Render targets
+                ID3D11DepthStencilView* pDepthStencilView
+                  Depth stencil view
+
+      Modifies: [m_counters, m_psShaderResources].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView)
+    {
+        m_psShaderResources.uKnownSlots = 0u;
+        count(TRUE);
+        m_next->OMSetRenderTargets(uNumViews, ppRenderTargetViews, pDepthStencilView);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::PSSetConstantBuffers
+
+      Summary:  Binds the constant buffers of the pixel shader stage
+                that differ from the bound ones
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+
+      Modifies: [m_counters, m_psConstantBuffers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        if (!filterSlots(m_psConstantBuffers, uStartSlot, uNumBuffers, ppConstantBuffers))
+        {
+            count(FALSE);
+            return;
+        }
+
+        count(TRUE);
+        m_next->PSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::PSSetConstantBuffers1
+
+      Summary:  Binds ranges of constant buffers of the pixel shader
+                stage and forgets the shadow of their slots
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First constant of every range
+                const UINT* pNumConstants
+                  Number of constants of every range
+
+      Modifies: [m_counters, m_psConstantBuffers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        forgetSlots(m_psConstantBuffers, uStartSlot, uNumBuffers);
+        count(TRUE);
+        m_next->PSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::PSSetSamplers
+
+      Summary:  Binds the samplers of the pixel shader stage that
+                differ from the bound ones
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumSamplers
+                  Number of samplers
+                ID3D11SamplerState* const* ppSamplers
+                  Samplers
+
+      Modifies: [m_counters, m_psSamplers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers)
+    {
+        if (!filterSlots(m_psSamplers, uStartSlot, uNumSamplers, ppSamplers))
+        {
+            count(FALSE);
+            return;
+        }
+
+        count(TRUE);
+        m_next->PSSetSamplers(uStartSlot, uNumSamplers, ppSamplers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::PSSetShader
+
+      Summary:  Binds the pixel shader if it differs from the bound one.
+                A bind with class instances is always forwarded.
+
+      Args:     ID3D11PixelShader* pPixelShader
+                  Pixel shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+
+      Modifies: [m_counters, m_uKnownStates, m_pPixelShader].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        if (uNumClassInstances == 0u && (m_uKnownStates & KNOWN_PIXEL_SHADER) && m_pPixelShader == pPixelShader)
+        {
+            count(FALSE);
+            return;
+        }
+
+        m_uKnownStates = uNumClassInstances == 0u ? m_uKnownStates | KNOWN_PIXEL_SHADER : m_uKnownStates & ~KNOWN_PIXEL_SHADER;
+        m_pPixelShader = pPixelShader;
+        count(TRUE);
+        m_next->PSSetShader(pPixelShader, ppClassInstances, uNumClassInstances);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::PSSetShaderResources
+
+      Summary:  Binds the shader resources of the pixel shader stage
+                that differ from the bound ones
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumViews
+                  Number of views
+                ID3D11ShaderResourceView* const* ppShaderResourceViews
+                  Shader resource views
+
+      Modifies: [m_counters, m_psShaderResources].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews)
+    {
+        if (!filterSlots(m_psShaderResources, uStartSlot, uNumViews, ppShaderResourceViews))
+        {
+            count(FALSE);
+            return;
+        }
+
+        count(TRUE);
+        m_next->PSSetShaderResources(uStartSlot, uNumViews, ppShaderResourceViews);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::RSSetViewports
+
+      Summary:  Sets the viewports, always forwarded
+
+      Args:     UINT uNumViewports
+                  Number of viewports
+                const D3D11_VIEWPORT* pViewports
+                  Viewports
+
+      Modifies: [m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports)
+    {
+        count(TRUE);
+        m_next->RSSetViewports(uNumViewports, pViewports);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::UnmapBuffer
+
+      Summary:  Forwards the unmap of a mapped buffer
+
+      Args:     ID3D11Buffer* pBuffer
+                  Mapped buffer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::UnmapBuffer(_In_ ID3D11Buffer* pBuffer)
+    {
+        m_next->UnmapBuffer(pBuffer);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::UpdateBuffer
+
+      Summary:  Forwards the update of a buffer
+
+      Args:     ID3D11Buffer* pBuffer
+                  Buffer to update
+                const void* pData
+                  New contents of the buffer
+                UINT uNumBytes
+                  Size of the buffer in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes)
+    {
+        m_next->UpdateBuffer(pBuffer, pData, uNumBytes);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::VSSetConstantBuffers
+
+      Summary:  Binds the constant buffers of the vertex shader stage
+                that differ from the bound ones
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+
+      Modifies: [m_counters, m_vsConstantBuffers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers)
+    {
+        if (!filterSlots(m_vsConstantBuffers, uStartSlot, uNumBuffers, ppConstantBuffers))
+        {
+            count(FALSE);
+            return;
+        }
+
+        count(TRUE);
+        m_next->VSSetConstantBuffers(uStartSlot, uNumBuffers, ppConstantBuffers);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::VSSetConstantBuffers1
+
+      Summary:  Binds ranges of constant buffers of the vertex shader
+                stage and forgets the shadow of their slots
+
+      Args:     UINT uStartSlot
+                  First slot
+                UINT uNumBuffers
+                  Number of buffers
+                ID3D11Buffer* const* ppConstantBuffers
+                  Constant buffers
+                const UINT* pFirstConstant
+                  First constant of every range
+                const UINT* pNumConstants
+                  Number of constants of every range
+
+      Modifies: [m_counters, m_vsConstantBuffers].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants)
+    {
+        forgetSlots(m_vsConstantBuffers, uStartSlot, uNumBuffers);
+        count(TRUE);
+        m_next->VSSetConstantBuffers1(uStartSlot, uNumBuffers, ppConstantBuffers, pFirstConstant, pNumConstants);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::VSSetShader
+
+      Summary:  Binds the vertex shader if it differs from the bound
+                one. A bind with class instances is always forwarded.
+
+      Args:     ID3D11VertexShader* pVertexShader
+                  Vertex shader
+                ID3D11ClassInstance* const* ppClassInstances
+                  Class instances
+                UINT uNumClassInstances
+                  Number of class instances
+
+      Modifies: [m_counters, m_uKnownStates, m_pVertexShader].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances)
+    {
+        if (uNumClassInstances == 0u && (m_uKnownStates & KNOWN_VERTEX_SHADER) && m_pVertexShader == pVertexShader)
+        {
+            count(FALSE);
+            return;
+        }
+
+        m_uKnownStates = uNumClassInstances == 0u ? m_uKnownStates | KNOWN_VERTEX_SHADER : m_uKnownStates & ~KNOWN_VERTEX_SHADER;
+        m_pVertexShader = pVertexShader;
+        count(TRUE);
+        m_next->VSSetShader(pVertexShader, ppClassInstances, uNumClassInstances);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::count
+
+      Summary:  Counts an issued or a skipped bind
+
+      Args:     BOOL bIssued
+                  TRUE if the bind was forwarded
+
+      Modifies: [m_counters].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void StateCacheGraphicsContext::count(_In_ BOOL bIssued)
+    {
+        if (bIssued)
+        {
+            ++m_counters.uNumIssued;
+        }
+        else
+        {
+            ++m_counters.uNumSkipped;
+        }
+    }
+}
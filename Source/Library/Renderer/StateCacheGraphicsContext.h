@@ -0,0 +1,263 @@
+/*+===================================================================
+  File:      STATECACHEGRAPHICSCONTEXT.H
+
+  Summary:   StateCacheGraphicsContext header file contains
+             declarations of the StateCacheGraphicsContext class that
+             drops the binds that would not change the pipeline state.
+
+  Classes: StateCacheGraphicsContext
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/GraphicsContext.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    StateCacheGraphicsContext
+
+      Summary:  GraphicsContext in front of another one that shadows the
+                bound state and only forwards the binds that change it.
+                The shadow keeps raw pointers, it never holds a
+                reference. A bind of several slots is narrowed to the
+                slots that change, the first NUM_CACHED_SLOTS slots of
+                every stage are shadowed and the binds past them are
+                always forwarded.
+
+                Deferred contexts are created by the next context,
+                without a cache in front of them. Finishing or executing
+                a command list clears the state of the context, so both
+                forget the shadow.
+
+                A ranged constant buffer bind is always forwarded and
+                forgets the slots it binds, since the same buffer is
+                bound there with other ranges. Maps are forwarded as
+                they are.
+
+                The render targets and the viewports are always
+                forwarded. Binding render targets forgets the shader
+                resources, since Direct3D unbinds the views of a
+                resource that becomes a render target. Clears, updates
+                and draws are forwarded as they are.
+
+                The shadow is only right if every bind goes through the
+                cache, Invalidate forgets it after the state is changed
+                elsewhere or by Present.
+
+      Methods:  GetCounters
+                  Returns the issued and skipped binds since the last
+                  reset
+                GetNext
+                  Returns the context the binds are forwarded to
+                Invalidate
+                  Forgets the shadowed state
+                ResetCounters
+                  Zeroes the counters
+                SetNext
+                  Sets the context the binds are forwarded to
+                StateCacheGraphicsContext
+                  Constructor.
+                ~StateCacheGraphicsContext
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class StateCacheGraphicsContext final : public GraphicsContext
+    {
+    public:
+        static constexpr const UINT NUM_CACHED_SLOTS = 16u;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Counters
+
+            Summary:  Binds forwarded to the next context and binds
+                      dropped because they would not change the state
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Counters
+        {
+            UINT uNumIssued;
+            UINT uNumSkipped;
+        };
+
+    public:
+        StateCacheGraphicsContext(_In_opt_ const std::shared_ptr<GraphicsContext>& next = nullptr);
+        StateCacheGraphicsContext(const StateCacheGraphicsContext& other) = delete;
+        StateCacheGraphicsContext(StateCacheGraphicsContext&& other) = delete;
+        StateCacheGraphicsContext& operator=(const StateCacheGraphicsContext& other) = delete;
+        StateCacheGraphicsContext& operator=(StateCacheGraphicsContext&& other) = delete;
+        ~StateCacheGraphicsContext() = default;
+
+        const Counters& GetCounters() const;
+        const std::shared_ptr<GraphicsContext>& GetNext() const;
+        void Invalidate();
+        void ResetCounters();
+        void SetNext(_In_ const std::shared_ptr<GraphicsContext>& next);
+
+        void ClearDepthStencilView(_In_ ID3D11DepthStencilView* pDepthStencilView, _In_ UINT uClearFlags, _In_ FLOAT depth, _In_ UINT8 stencil) override;
+        void ClearRenderTargetView(_In_ ID3D11RenderTargetView* pRenderTargetView, _In_ const FLOAT aColorRGBA[4]) override;
+        HRESULT CreateBuffer(_In_ const D3D11_BUFFER_DESC* pDesc, _Outptr_ ID3D11Buffer** ppBuffer) override;
+        HRESULT CreateDeferredContext(_Out_ std::shared_ptr<GraphicsContext>& outDeferredContext) override;
+        void DrawIndexed(_In_ UINT uIndexCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation) override;
+        void DrawIndexedInstanced(_In_ UINT uIndexCountPerInstance, _In_ UINT uInstanceCount, _In_ UINT uStartIndexLocation, _In_ INT baseVertexLocation, _In_ UINT uStartInstanceLocation) override;
+        void ExecuteCommandList(_In_ GraphicsContext& deferredContext) override;
+        HRESULT FinishCommandList() override;
+        void IASetIndexBuffer(_In_opt_ ID3D11Buffer* pIndexBuffer, _In_ DXGI_FORMAT format, _In_ UINT uOffset) override;
+        void IASetInputLayout(_In_opt_ ID3D11InputLayout* pInputLayout) override;
+        void IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology) override;
+        void IASetVertexBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppVertexBuffers, _In_reads_(uNumBuffers) const UINT* pStrides, _In_reads_(uNumBuffers) const UINT* pOffsets) override;
+        HRESULT MapBuffer(_In_ ID3D11Buffer* pBuffer, _In_ D3D11_MAP mapType, _In_ UINT uNumBytes, _Outptr_ void** ppData) override;
+        void OMSetRenderTargets(_In_ UINT uNumViews, _In_reads_opt_(uNumViews) ID3D11RenderTargetView* const* ppRenderTargetViews, _In_opt_ ID3D11DepthStencilView* pDepthStencilView) override;
+        void PSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void PSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void PSSetSamplers(_In_ UINT uStartSlot, _In_ UINT uNumSamplers, _In_reads_(uNumSamplers) ID3D11SamplerState* const* ppSamplers) override;
+        void PSSetShader(_In_opt_ ID3D11PixelShader* pPixelShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+        void PSSetShaderResources(_In_ UINT uStartSlot, _In_ UINT uNumViews, _In_reads_(uNumViews) ID3D11ShaderResourceView* const* ppShaderResourceViews) override;
+        void RSSetViewports(_In_ UINT uNumViewports, _In_reads_opt_(uNumViewports) const D3D11_VIEWPORT* pViewports) override;
+        void UnmapBuffer(_In_ ID3D11Buffer* pBuffer) override;
+        void UpdateBuffer(_In_ ID3D11Buffer* pBuffer, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes) override;
+        void VSSetConstantBuffers(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers) override;
+        void VSSetConstantBuffers1(_In_ UINT uStartSlot, _In_ UINT uNumBuffers, _In_reads_(uNumBuffers) ID3D11Buffer* const* ppConstantBuffers, _In_reads_(uNumBuffers) const UINT* pFirstConstant, _In_reads_(uNumBuffers) const UINT* pNumConstants) override;
+        void VSSetShader(_In_opt_ ID3D11VertexShader* pVertexShader, _In_reads_opt_(uNumClassInstances) ID3D11ClassInstance* const* ppClassInstances, _In_ UINT uNumClassInstances) override;
+
+    private:
+        /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+            Enum:     eKnownState
+
+            Summary:  Bits of the single states whose shadow is valid
+        E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+        enum eKnownState : UINT
+        {
+            KNOWN_TOPOLOGY = 0x1u,
+            KNOWN_INPUT_LAYOUT = 0x2u,
+            KNOWN_INDEX_BUFFER = 0x4u,
+            KNOWN_VERTEX_SHADER = 0x8u,
+            KNOWN_PIXEL_SHADER = 0x10u,
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   SlotShadow
+
+            Summary:  Objects bound to the shadowed slots of a stage,
+                      with a bit for every slot whose object is known
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        template <class T>
+        struct SlotShadow
+        {
+            T* apObjects[NUM_CACHED_SLOTS];
+            UINT uKnownSlots;
+        };
+
+        template <class T>
+        BOOL filterSlots(_Inout_ SlotShadow<T>& shadow, _Inout_ UINT& uStartSlot, _Inout_ UINT& uNumSlots, _Inout_ T* const*& ppObjects);
+        template <class T>
+        void forgetSlots(_Inout_ SlotShadow<T>& shadow, _In_ UINT uStartSlot, _In_ UINT uNumSlots);
+        void count(_In_ BOOL bIssued);
+
+    private:
+        std::shared_ptr<GraphicsContext> m_next;
+        Counters m_counters;
+
+        UINT m_uKnownStates;
+        D3D11_PRIMITIVE_TOPOLOGY m_topology;
+        ID3D11InputLayout* m_pInputLayout;
+        ID3D11Buffer* m_pIndexBuffer;
+        DXGI_FORMAT m_indexFormat;
+        UINT m_uIndexOffset;
+        ID3D11VertexShader* m_pVertexShader;
+        ID3D11PixelShader* m_pPixelShader;
+
+        SlotShadow<ID3D11Buffer> m_vertexBuffers;
+        UINT m_auStrides[NUM_CACHED_SLOTS];
+        UINT m_auOffsets[NUM_CACHED_SLOTS];
+        SlotShadow<ID3D11Buffer> m_vsConstantBuffers;
+        SlotShadow<ID3D11Buffer> m_psConstantBuffers;
+        SlotShadow<ID3D11ShaderResourceView> m_psShaderResources;
+        SlotShadow<ID3D11SamplerState> m_psSamplers;
+    };
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::filterSlots
+
+      Summary:  Updates the shadow of the slots of a bind and narrows the
+                bind to the slots that change. A bind that reaches past
+                the shadowed slots forgets them and is kept whole.
+
+      Args:     SlotShadow<T>& shadow
+                  Shadow of the stage
+                UINT& uStartSlot
+                  First slot of the bind, the first changed slot on
+                  return
+                UINT& uNumSlots
+                  Number of slots of the bind, the number from the
+                  first to the last changed slot on return
+                T* const*& ppObjects
+                  Objects of the bind, the object of the first changed
+                  slot on return
+
+      Returns:  BOOL
+                  TRUE if the bind has to be issued
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <class T>
+    BOOL StateCacheGraphicsContext::filterSlots(_Inout_ SlotShadow<T>& shadow, _Inout_ UINT& uStartSlot, _Inout_ UINT& uNumSlots, _Inout_ T* const*& ppObjects)
+    {
+        if (uStartSlot + uNumSlots > NUM_CACHED_SLOTS)
+        {
+            for (UINT uSlot = uStartSlot; uSlot < NUM_CACHED_SLOTS; ++uSlot)
+            {
+                shadow.uKnownSlots &= ~(1u << uSlot);
+            }
+            return TRUE;
+        }
+
+        UINT uFirstChanged = uNumSlots;
+        UINT uLastChanged = 0u;
+        for (UINT uSlotIdx = 0u; uSlotIdx < uNumSlots; ++uSlotIdx)
+        {
+            UINT uSlot = uStartSlot + uSlotIdx;
+            T* pObject = ppObjects ? ppObjects[uSlotIdx] : nullptr;
+            if (!(shadow.uKnownSlots & (1u << uSlot)) || shadow.apObjects[uSlot] != pObject)
+            {
+                shadow.apObjects[uSlot] = pObject;
+                shadow.uKnownSlots |= 1u << uSlot;
+                uFirstChanged = uFirstChanged < uSlotIdx ? uFirstChanged : uSlotIdx;
+                uLastChanged = uSlotIdx;
+            }
+        }
+
+        if (uFirstChanged == uNumSlots)
+        {
+            return FALSE;
+        }
+
+        uStartSlot += uFirstChanged;
+        uNumSlots = uLastChanged - uFirstChanged + 1u;
+        if (ppObjects)
+        {
+            ppObjects += uFirstChanged;
+        }
+        return TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   StateCacheGraphicsContext::forgetSlots
+
+      Summary:  Forgets the shadowed objects of the slots of a bind
+
+      Args:     SlotShadow<T>& shadow
+                  Shadow of the stage
+                UINT uStartSlot
+                  First slot of the bind
+                UINT uNumSlots
+                  Number of slots of the bind
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    template <class T>
+    void StateCacheGraphicsContext::forgetSlots(_Inout_ SlotShadow<T>& shadow, _In_ UINT uStartSlot, _In_ UINT uNumSlots)
+    {
+        for (UINT uSlot = uStartSlot; uSlot < uStartSlot + uNumSlots && uSlot < NUM_CACHED_SLOTS; ++uSlot)
+        {
+            shadow.uKnownSlots &= ~(1u << uSlot);
+        }
+    }
+}
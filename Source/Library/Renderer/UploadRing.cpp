@@ -0,0 +1,150 @@
+#include "Renderer/UploadRing.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   UploadRing::UploadRing
+
+      Summary:  Constructor
+
+      Modifies: [m_ringBuffer, m_uSize, m_uOffset, m_uNumUploadedBytes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UploadRing::UploadRing()
+        : m_ringBuffer()
+        , m_uSize(0u)
+        , m_uOffset(0u)
+        , m_uNumUploadedBytes(0u)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   UploadRing::Initialize
+
+      Summary:  Creates the dynamic ring buffer
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffer
+                UINT uSize
+                  Size of the ring in bytes
+
+      Modifies: [m_ringBuffer, m_uSize, m_uOffset].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT UploadRing::Initialize(_In_ ID3D11Device* pDevice, _In_ UINT uSize)
+    {
+        if (uSize == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        // Dynamic buffers need a bind flag, the ring is only ever the source of copies
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = uSize,
+            .Usage = D3D11_USAGE_DYNAMIC,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE
+        };
+
+        m_ringBuffer.Reset();
+        HRESULT hr = pDevice->CreateBuffer(&bd, nullptr, m_ringBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_uSize = uSize;
+
+        // The first map has to discard
+        m_uOffset = uSize;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   UploadRing::Upload
+
+      Summary:  Writes bytes into the ring and copies them into a range
+                of a buffer. Updates larger than the ring are split.
+
+      Args:     ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to map and copy with
+                ID3D11Buffer* pDestination
+                  Buffer to update, not immutable
+                UINT uDestinationOffset
+                  Offset of the range in the buffer in bytes
+                const void* pData
+                  Bytes to upload
+                UINT uSize
+                  Number of bytes
+
+      Modifies: [m_uOffset, m_uNumUploadedBytes].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT UploadRing::Upload(_In_ ID3D11DeviceContext* pImmediateContext, _In_ ID3D11Buffer* pDestination, _In_ UINT uDestinationOffset, _In_reads_bytes_(uSize) const void* pData, _In_ UINT uSize)
+    {
+        if (!m_ringBuffer)
+        {
+            return E_FAIL;
+        }
+
+        const BYTE* pBytes = static_cast<const BYTE*>(pData);
+        while (uSize > 0u)
+        {
+            UINT uNumBytes = uSize < m_uSize ? uSize : m_uSize;
+
+            D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+            if (m_uOffset + uNumBytes > m_uSize)
+            {
+                mapType = D3D11_MAP_WRITE_DISCARD;
+                m_uOffset = 0u;
+            }
+
+            D3D11_MAPPED_SUBRESOURCE mappedSubresource = {};
+            HRESULT hr = pImmediateContext->Map(m_ringBuffer.Get(), 0u, mapType, 0u, &mappedSubresource);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            memcpy(static_cast<BYTE*>(mappedSubresource.pData) + m_uOffset, pBytes, uNumBytes);
+            pImmediateContext->Unmap(m_ringBuffer.Get(), 0u);
+
+            D3D11_BOX sourceBox =
+            {
+                .left = m_uOffset,
+                .top = 0u,
+                .front = 0u,
+                .right = m_uOffset + uNumBytes,
+                .bottom = 1u,
+                .back = 1u
+            };
+            pImmediateContext->CopySubresourceRegion(pDestination, 0u, uDestinationOffset, 0u, 0u, m_ringBuffer.Get(), 0u, &sourceBox);
+
+            m_uOffset += uNumBytes;
+            m_uNumUploadedBytes += uNumBytes;
+            uDestinationOffset += uNumBytes;
+            pBytes += uNumBytes;
+            uSize -= uNumBytes;
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   UploadRing::GetNumUploadedBytes
+
+      Summary:  Returns the number of bytes uploaded since the ring was
+                created
+
+      Returns:  UINT64
+                  Number of bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 UploadRing::GetNumUploadedBytes() const
+    {
+        return m_uNumUploadedBytes;
+    }
+}
@@ -0,0 +1,64 @@
+/*+===================================================================
+  File:      UPLOADRING.H
+
+  Summary:   UploadRing header file contains declarations of the
+             UploadRing class that copies small CPU updates into
+             default usage buffers through a dynamic ring buffer.
+
+  Classes: UploadRing
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    UploadRing
+
+      Summary:  Dynamic buffer that partial updates are written into
+                with D3D11_MAP_WRITE_NO_OVERWRITE, one after the other,
+                and copied from into their destination with
+                CopySubresourceRegion. The GPU may still be reading the
+                earlier updates, so the ring is only rewound with
+                D3D11_MAP_WRITE_DISCARD once it is full, which lets the
+                driver hand out a fresh buffer instead of stalling.
+
+      Methods:  Initialize
+                  Creates the ring buffer
+                Upload
+                  Copies bytes into a buffer through the ring
+                GetNumUploadedBytes
+                  Returns the number of bytes uploaded so far
+                UploadRing
+                  Constructor.
+                ~UploadRing
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class UploadRing
+    {
+    public:
+        static constexpr const UINT DEFAULT_SIZE = 1u << 18u;
+
+    public:
+        UploadRing();
+        UploadRing(const UploadRing& other) = delete;
+        UploadRing(UploadRing&& other) = delete;
+        UploadRing& operator=(const UploadRing& other) = delete;
+        UploadRing& operator=(UploadRing&& other) = delete;
+        ~UploadRing() = default;
+
+        HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ UINT uSize = DEFAULT_SIZE);
+        HRESULT Upload(_In_ ID3D11DeviceContext* pImmediateContext, _In_ ID3D11Buffer* pDestination, _In_ UINT uDestinationOffset, _In_reads_bytes_(uSize) const void* pData, _In_ UINT uSize);
+
+        UINT64 GetNumUploadedBytes() const;
+
+    private:
+        ComPtr<ID3D11Buffer> m_ringBuffer;
+        UINT m_uSize;
+        UINT m_uOffset;
+        UINT64 m_uNumUploadedBytes;
+    };
+}
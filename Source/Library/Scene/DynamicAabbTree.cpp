@@ -0,0 +1,1027 @@
+#include "Scene/DynamicAabbTree.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "Renderer/FrustumCuller.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::getArea
+
+      Summary:  Returns half of the surface area of a box, the cost of
+                the surface area heuristic only compares areas
+
+      Args:     const XMFLOAT3& minimum
+                  Minimum corner
+                const XMFLOAT3& maximum
+                  Maximum corner
+
+      Returns:  FLOAT
+                  Half of the surface area
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT DynamicAabbTree::getArea(_In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum)
+    {
+        FLOAT dx = maximum.x - minimum.x;
+        FLOAT dy = maximum.y - minimum.y;
+        FLOAT dz = maximum.z - minimum.z;
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::getUnionArea
+
+      Summary:  Returns half of the surface area of the box around two
+                nodes
+
+      Args:     const Node& a
+                  First node
+                const Node& b
+                  Second node
+
+      Returns:  FLOAT
+                  Half of the surface area of the union
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT DynamicAabbTree::getUnionArea(_In_ const Node& a, _In_ const Node& b)
+    {
+        return getArea(
+            XMFLOAT3(
+                a.Minimum.x < b.Minimum.x ? a.Minimum.x : b.Minimum.x,
+                a.Minimum.y < b.Minimum.y ? a.Minimum.y : b.Minimum.y,
+                a.Minimum.z < b.Minimum.z ? a.Minimum.z : b.Minimum.z
+            ),
+            XMFLOAT3(
+                a.Maximum.x > b.Maximum.x ? a.Maximum.x : b.Maximum.x,
+                a.Maximum.y > b.Maximum.y ? a.Maximum.y : b.Maximum.y,
+                a.Maximum.z > b.Maximum.z ? a.Maximum.z : b.Maximum.z
+            )
+        );
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::DynamicAabbTree
+
+      Summary:  Constructor
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList, m_uNumProxies,
+                 m_buildArea, m_refitGrowth, m_aBuildLeaves].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DynamicAabbTree::DynamicAabbTree()
+        : m_aNodes()
+        , m_uRoot(NULL_NODE)
+        , m_uFreeList(NULL_NODE)
+        , m_uNumProxies(0u)
+        , m_buildArea(0.0f)
+        , m_refitGrowth(0.0f)
+        , m_aBuildLeaves()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Clear
+
+      Summary:  Removes every proxy, the memory is kept
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList, m_uNumProxies,
+                 m_buildArea, m_refitGrowth].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::Clear()
+    {
+        m_aNodes.clear();
+        m_uRoot = NULL_NODE;
+        m_uFreeList = NULL_NODE;
+        m_uNumProxies = 0u;
+        m_buildArea = 0.0f;
+        m_refitGrowth = 0.0f;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::GetBounds
+
+      Summary:  Returns the bounds of a proxy
+
+      Args:     UINT uProxy
+                  Id returned by Insert
+
+      Returns:  AxisAlignedBox
+                  Bounds of the last Insert or Update
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    AxisAlignedBox DynamicAabbTree::GetBounds(_In_ UINT uProxy) const
+    {
+        assert(uProxy < m_aNodes.size() && m_aNodes[uProxy].height == 0);
+
+        const Node& node = m_aNodes[uProxy];
+        return AxisAlignedBox
+        {
+            .Center = XMFLOAT3(
+                (node.Minimum.x + node.Maximum.x) * 0.5f,
+                (node.Minimum.y + node.Maximum.y) * 0.5f,
+                (node.Minimum.z + node.Maximum.z) * 0.5f
+            ),
+            .Extents = XMFLOAT3(
+                (node.Maximum.x - node.Minimum.x) * 0.5f,
+                (node.Maximum.y - node.Minimum.y) * 0.5f,
+                (node.Maximum.z - node.Minimum.z) * 0.5f
+            )
+        };
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::GetHeight
+
+      Summary:  Returns the height of the tree
+
+      Returns:  UINT
+                  Number of edges from the root to the deepest leaf
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::GetHeight() const
+    {
+        return m_uRoot == NULL_NODE ? 0u : static_cast<UINT>(m_aNodes[m_uRoot].height);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::GetNumProxies
+
+      Summary:  Returns the number of proxies
+
+      Returns:  UINT
+                  Number of leaves
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::GetNumProxies() const
+    {
+        return m_uNumProxies;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::GetRenderable
+
+      Summary:  Returns the renderable of a proxy
+
+      Args:     UINT uProxy
+                  Id returned by Insert
+
+      Returns:  Renderable*
+                  Renderable passed to Insert
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Renderable* DynamicAabbTree::GetRenderable(_In_ UINT uProxy) const
+    {
+        assert(uProxy < m_aNodes.size() && m_aNodes[uProxy].height == 0);
+
+        return m_aNodes[uProxy].pRenderable;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Insert
+
+      Summary:  Adds a leaf for a renderable
+
+      Args:     const AxisAlignedBox& bounds
+                  World space bounds of the renderable
+                Renderable* pRenderable
+                  Renderable returned by GetRenderable
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList, m_uNumProxies].
+
+      Returns:  UINT
+                  Proxy id of the leaf
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::Insert(_In_ const AxisAlignedBox& bounds, _In_opt_ Renderable* pRenderable)
+    {
+        UINT uLeaf = allocateNode();
+        Node& leaf = m_aNodes[uLeaf];
+        leaf.Minimum = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+        leaf.Maximum = XMFLOAT3(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z);
+        leaf.height = 0;
+        leaf.pRenderable = pRenderable;
+
+        insertLeaf(uLeaf);
+        ++m_uNumProxies;
+        return uLeaf;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::NeedsRebuild
+
+      Summary:  Returns whether the refits since the last Rebuild grew
+                the internal boxes by more than REBUILD_GROWTH_RATIO of
+                their area after it. A tree that was never rebuilt needs
+                it after any growth.
+
+      Returns:  BOOL
+                  TRUE if Rebuild should be called
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL DynamicAabbTree::NeedsRebuild() const
+    {
+        return m_uNumProxies > 2u && m_refitGrowth > REBUILD_GROWTH_RATIO * m_buildArea;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::QueryBox
+
+      Summary:  Finds the proxies whose bounds overlap a box, for
+                proximity queries
+
+      Args:     const AxisAlignedBox& box
+                  World space box
+                std::vector<UINT>& aOutProxies
+                  Overlapping proxies, cleared first
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::QueryBox(_In_ const AxisAlignedBox& box, _Out_ std::vector<UINT>& aOutProxies) const
+    {
+        aOutProxies.clear();
+        if (m_uRoot == NULL_NODE)
+        {
+            return;
+        }
+
+        XMFLOAT3 minimum(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+        XMFLOAT3 maximum(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+        std::vector<UINT> aStack;
+        aStack.reserve(64u);
+        aStack.push_back(m_uRoot);
+        while (!aStack.empty())
+        {
+            const Node& node = m_aNodes[aStack.back()];
+            UINT uNode = aStack.back();
+            aStack.pop_back();
+
+            if (node.Maximum.x < minimum.x || node.Minimum.x > maximum.x
+                || node.Maximum.y < minimum.y || node.Minimum.y > maximum.y
+                || node.Maximum.z < minimum.z || node.Minimum.z > maximum.z)
+            {
+                continue;
+            }
+
+            if (node.height == 0)
+            {
+                aOutProxies.push_back(uNode);
+                continue;
+            }
+            aStack.push_back(node.auChildren[0]);
+            aStack.push_back(node.auChildren[1]);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::QueryFrustum
+
+      Summary:  Finds the proxies whose bounds intersect a view frustum.
+                A node carries the planes its parent was not fully
+                inside of, and a node inside of all planes adds its
+                leaves without testing them.
+
+      Args:     FXMMATRIX viewProjection
+                  View matrix times the projection matrix
+                std::vector<UINT>& aOutProxies
+                  Intersecting proxies, cleared first
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::QueryFrustum(_In_ FXMMATRIX viewProjection, _Out_ std::vector<UINT>& aOutProxies) const
+    {
+        aOutProxies.clear();
+        if (m_uRoot == NULL_NODE)
+        {
+            return;
+        }
+
+        XMFLOAT4 aPlanes[FrustumCuller::NUM_PLANES];
+        FrustumCuller::ExtractPlanes(viewProjection, aPlanes);
+
+        // Node and the bit mask of the planes that still have to be tested
+        std::vector<std::pair<UINT, UINT>> aStack;
+        aStack.reserve(64u);
+        aStack.emplace_back(m_uRoot, (1u << FrustumCuller::NUM_PLANES) - 1u);
+        while (!aStack.empty())
+        {
+            UINT uNode = aStack.back().first;
+            UINT uPlaneMask = aStack.back().second;
+            aStack.pop_back();
+            const Node& node = m_aNodes[uNode];
+
+            FLOAT centerX = (node.Minimum.x + node.Maximum.x) * 0.5f;
+            FLOAT centerY = (node.Minimum.y + node.Maximum.y) * 0.5f;
+            FLOAT centerZ = (node.Minimum.z + node.Maximum.z) * 0.5f;
+            FLOAT extentsX = (node.Maximum.x - node.Minimum.x) * 0.5f;
+            FLOAT extentsY = (node.Maximum.y - node.Minimum.y) * 0.5f;
+            FLOAT extentsZ = (node.Maximum.z - node.Minimum.z) * 0.5f;
+
+            BOOL bOutside = FALSE;
+            for (UINT uPlane = 0u; uPlane < FrustumCuller::NUM_PLANES && !bOutside; ++uPlane)
+            {
+                if (!(uPlaneMask & (1u << uPlane)))
+                {
+                    continue;
+                }
+
+                const XMFLOAT4& plane = aPlanes[uPlane];
+                FLOAT distance = plane.x * centerX + plane.y * centerY + plane.z * centerZ + plane.w;
+                FLOAT radius = std::abs(plane.x) * extentsX + std::abs(plane.y) * extentsY + std::abs(plane.z) * extentsZ;
+                if (distance + radius < 0.0f)
+                {
+                    bOutside = TRUE;
+                }
+                else if (distance - radius >= 0.0f)
+                {
+                    uPlaneMask &= ~(1u << uPlane);
+                }
+            }
+
+            if (bOutside)
+            {
+                continue;
+            }
+            if (node.height == 0)
+            {
+                aOutProxies.push_back(uNode);
+                continue;
+            }
+            if (uPlaneMask == 0u)
+            {
+                collectLeaves(uNode, aOutProxies);
+                continue;
+            }
+            aStack.emplace_back(node.auChildren[0], uPlaneMask);
+            aStack.emplace_back(node.auChildren[1], uPlaneMask);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::QuerySphere
+
+      Summary:  Finds the proxies whose bounds overlap a sphere, for
+                assigning lights to the renderables they reach
+
+      Args:     FXMVECTOR center
+                  Center of the sphere
+                FLOAT radius
+                  Radius of the sphere
+                std::vector<UINT>& aOutProxies
+                  Overlapping proxies, cleared first
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::QuerySphere(_In_ FXMVECTOR center, _In_ FLOAT radius, _Out_ std::vector<UINT>& aOutProxies) const
+    {
+        aOutProxies.clear();
+        if (m_uRoot == NULL_NODE)
+        {
+            return;
+        }
+
+        XMFLOAT3 sphereCenter;
+        XMStoreFloat3(&sphereCenter, center);
+        FLOAT radiusSquared = radius * radius;
+
+        std::vector<UINT> aStack;
+        aStack.reserve(64u);
+        aStack.push_back(m_uRoot);
+        while (!aStack.empty())
+        {
+            UINT uNode = aStack.back();
+            aStack.pop_back();
+            const Node& node = m_aNodes[uNode];
+
+            // Distance from the center to the closest point of the box
+            FLOAT dx = sphereCenter.x < node.Minimum.x ? node.Minimum.x - sphereCenter.x : (sphereCenter.x > node.Maximum.x ? sphereCenter.x - node.Maximum.x : 0.0f);
+            FLOAT dy = sphereCenter.y < node.Minimum.y ? node.Minimum.y - sphereCenter.y : (sphereCenter.y > node.Maximum.y ? sphereCenter.y - node.Maximum.y : 0.0f);
+            FLOAT dz = sphereCenter.z < node.Minimum.z ? node.Minimum.z - sphereCenter.z : (sphereCenter.z > node.Maximum.z ? sphereCenter.z - node.Maximum.z : 0.0f);
+            if (dx * dx + dy * dy + dz * dz > radiusSquared)
+            {
+                continue;
+            }
+
+            if (node.height == 0)
+            {
+                aOutProxies.push_back(uNode);
+                continue;
+            }
+            aStack.push_back(node.auChildren[0]);
+            aStack.push_back(node.auChildren[1]);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Raycast
+
+      Summary:  Finds the proxy whose bounds a ray enters first, for
+                picking. The nearer child is visited first and the
+                nodes entered past the nearest hit so far are skipped.
+
+      Args:     FXMVECTOR origin
+                  Origin of the ray
+                FXMVECTOR direction
+                  Direction of the ray, the distances are in its length
+                FLOAT maxDistance
+                  Farthest distance to hit
+                UINT& uOutProxy
+                  Proxy hit, NULL_NODE if none
+                FLOAT& outDistance
+                  Distance at which the ray enters the bounds, 0 if the
+                  origin is inside of them
+
+      Returns:  BOOL
+                  TRUE if a proxy was hit
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL DynamicAabbTree::Raycast(_In_ FXMVECTOR origin, _In_ FXMVECTOR direction, _In_ FLOAT maxDistance, _Out_ UINT& uOutProxy, _Out_ FLOAT& outDistance) const
+    {
+        uOutProxy = NULL_NODE;
+        outDistance = maxDistance;
+        if (m_uRoot == NULL_NODE)
+        {
+            return FALSE;
+        }
+
+        XMFLOAT3 rayOrigin;
+        XMFLOAT3 inverseDirection;
+        XMStoreFloat3(&rayOrigin, origin);
+        XMStoreFloat3(&inverseDirection, XMVectorReciprocal(direction));
+
+        // Distance at which the ray enters a node, FLT_MAX if it misses it
+        auto getEntryDistance = [&](const Node& node) -> FLOAT
+        {
+            FLOAT t1 = (node.Minimum.x - rayOrigin.x) * inverseDirection.x;
+            FLOAT t2 = (node.Maximum.x - rayOrigin.x) * inverseDirection.x;
+            FLOAT entry = t1 < t2 ? t1 : t2;
+            FLOAT exit = t1 < t2 ? t2 : t1;
+
+            t1 = (node.Minimum.y - rayOrigin.y) * inverseDirection.y;
+            t2 = (node.Maximum.y - rayOrigin.y) * inverseDirection.y;
+            entry = (t1 < t2 ? t1 : t2) > entry ? (t1 < t2 ? t1 : t2) : entry;
+            exit = (t1 < t2 ? t2 : t1) < exit ? (t1 < t2 ? t2 : t1) : exit;
+
+            t1 = (node.Minimum.z - rayOrigin.z) * inverseDirection.z;
+            t2 = (node.Maximum.z - rayOrigin.z) * inverseDirection.z;
+            entry = (t1 < t2 ? t1 : t2) > entry ? (t1 < t2 ? t1 : t2) : entry;
+            exit = (t1 < t2 ? t2 : t1) < exit ? (t1 < t2 ? t2 : t1) : exit;
+
+            entry = entry > 0.0f ? entry : 0.0f;
+            return entry <= exit ? entry : FLT_MAX;
+        };
+
+        std::vector<std::pair<UINT, FLOAT>> aStack;
+        aStack.reserve(64u);
+        FLOAT rootDistance = getEntryDistance(m_aNodes[m_uRoot]);
+        if (rootDistance <= outDistance)
+        {
+            aStack.emplace_back(m_uRoot, rootDistance);
+        }
+        while (!aStack.empty())
+        {
+            UINT uNode = aStack.back().first;
+            FLOAT entryDistance = aStack.back().second;
+            aStack.pop_back();
+            if (entryDistance > outDistance)
+            {
+                continue;
+            }
+
+            const Node& node = m_aNodes[uNode];
+            if (node.height == 0)
+            {
+                uOutProxy = uNode;
+                outDistance = entryDistance;
+                continue;
+            }
+
+            UINT uNear = node.auChildren[0];
+            UINT uFar = node.auChildren[1];
+            FLOAT nearDistance = getEntryDistance(m_aNodes[uNear]);
+            FLOAT farDistance = getEntryDistance(m_aNodes[uFar]);
+            if (farDistance < nearDistance)
+            {
+                std::swap(uNear, uFar);
+                std::swap(nearDistance, farDistance);
+            }
+
+            // The near child is pushed last so it is visited first
+            if (farDistance <= outDistance)
+            {
+                aStack.emplace_back(uFar, farDistance);
+            }
+            if (nearDistance <= outDistance)
+            {
+                aStack.emplace_back(uNear, nearDistance);
+            }
+        }
+
+        return uOutProxy != NULL_NODE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Rebuild
+
+      Summary:  Frees the internal nodes and builds them again top-down
+                with the binned surface area heuristic. The leaves, and
+                so the proxy ids, are kept.
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList, m_buildArea,
+                 m_refitGrowth, m_aBuildLeaves].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::Rebuild()
+    {
+        m_aBuildLeaves.clear();
+        for (UINT uNode = 0u; uNode < static_cast<UINT>(m_aNodes.size()); ++uNode)
+        {
+            if (m_aNodes[uNode].height == 0)
+            {
+                m_aBuildLeaves.push_back(uNode);
+            }
+            else if (m_aNodes[uNode].height > 0)
+            {
+                freeNode(uNode);
+            }
+        }
+
+        m_buildArea = 0.0f;
+        m_refitGrowth = 0.0f;
+        if (m_aBuildLeaves.empty())
+        {
+            m_uRoot = NULL_NODE;
+            return;
+        }
+
+        m_uRoot = buildRange(m_aBuildLeaves.data(), static_cast<UINT>(m_aBuildLeaves.size()));
+        m_aNodes[m_uRoot].uParent = NULL_NODE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Remove
+
+      Summary:  Removes a proxy, its id may be returned again by Insert
+
+      Args:     UINT uProxy
+                  Id returned by Insert
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList, m_uNumProxies].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::Remove(_In_ UINT uProxy)
+    {
+        assert(uProxy < m_aNodes.size() && m_aNodes[uProxy].height == 0);
+
+        removeLeaf(uProxy);
+        freeNode(uProxy);
+        --m_uNumProxies;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::Update
+
+      Summary:  Refits a proxy to new bounds without changing the
+                structure of the tree. The ancestors are refitted up to
+                the first one whose box does not change.
+
+      Args:     UINT uProxy
+                  Id returned by Insert
+                const AxisAlignedBox& bounds
+                  New world space bounds
+
+      Modifies: [m_aNodes, m_refitGrowth].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::Update(_In_ UINT uProxy, _In_ const AxisAlignedBox& bounds)
+    {
+        assert(uProxy < m_aNodes.size() && m_aNodes[uProxy].height == 0);
+
+        Node& leaf = m_aNodes[uProxy];
+        leaf.Minimum = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+        leaf.Maximum = XMFLOAT3(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z);
+
+        for (UINT uNode = leaf.uParent; uNode != NULL_NODE; uNode = m_aNodes[uNode].uParent)
+        {
+            Node& node = m_aNodes[uNode];
+            XMFLOAT3 oldMinimum = node.Minimum;
+            XMFLOAT3 oldMaximum = node.Maximum;
+
+            fitToChildren(uNode);
+            if (node.Minimum.x == oldMinimum.x && node.Minimum.y == oldMinimum.y && node.Minimum.z == oldMinimum.z
+                && node.Maximum.x == oldMaximum.x && node.Maximum.y == oldMaximum.y && node.Maximum.z == oldMaximum.z)
+            {
+                break;
+            }
+            m_refitGrowth += getArea(node.Minimum, node.Maximum) - getArea(oldMinimum, oldMaximum);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::allocateNode
+
+      Summary:  Takes a node from the free list, or appends one
+
+      Modifies: [m_aNodes, m_uFreeList].
+
+      Returns:  UINT
+                  Index of the node, with no parent and no children
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::allocateNode()
+    {
+        UINT uNode = m_uFreeList;
+        if (uNode == NULL_NODE)
+        {
+            uNode = static_cast<UINT>(m_aNodes.size());
+            m_aNodes.emplace_back();
+        }
+        else
+        {
+            m_uFreeList = m_aNodes[uNode].uParent;
+        }
+
+        Node& node = m_aNodes[uNode];
+        node.uParent = NULL_NODE;
+        node.auChildren[0] = NULL_NODE;
+        node.auChildren[1] = NULL_NODE;
+        node.height = 0;
+        node.pRenderable = nullptr;
+        return uNode;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::balance
+
+      Summary:  Rotates the taller grandchild of a node up when the
+                heights of its children differ by more than one
+
+      Args:     UINT uNode
+                  Internal node whose children are balanced
+
+      Modifies: [m_aNodes, m_uRoot].
+
+      Returns:  UINT
+                  Node at the place of uNode after the rotation
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::balance(_In_ UINT uNode)
+    {
+        if (m_aNodes[uNode].height < 2)
+        {
+            return uNode;
+        }
+
+        UINT uLeft = m_aNodes[uNode].auChildren[0];
+        UINT uRight = m_aNodes[uNode].auChildren[1];
+        INT difference = m_aNodes[uRight].height - m_aNodes[uLeft].height;
+        if (difference >= -1 && difference <= 1)
+        {
+            return uNode;
+        }
+
+        // The taller child takes the place of the node, the node takes its shorter grandchild
+        UINT uSide = difference > 1 ? 1u : 0u;
+        UINT uTall = m_aNodes[uNode].auChildren[uSide];
+        UINT uGrandchild0 = m_aNodes[uTall].auChildren[0];
+        UINT uGrandchild1 = m_aNodes[uTall].auChildren[1];
+        BOOL bKeepFirst = m_aNodes[uGrandchild0].height > m_aNodes[uGrandchild1].height;
+        UINT uKept = bKeepFirst ? uGrandchild0 : uGrandchild1;
+        UINT uMoved = bKeepFirst ? uGrandchild1 : uGrandchild0;
+
+        UINT uParent = m_aNodes[uNode].uParent;
+        m_aNodes[uTall].uParent = uParent;
+        if (uParent == NULL_NODE)
+        {
+            m_uRoot = uTall;
+        }
+        else
+        {
+            UINT uParentSide = m_aNodes[uParent].auChildren[0] == uNode ? 0u : 1u;
+            m_aNodes[uParent].auChildren[uParentSide] = uTall;
+        }
+
+        m_aNodes[uTall].auChildren[0] = uNode;
+        m_aNodes[uTall].auChildren[1] = uKept;
+        m_aNodes[uNode].uParent = uTall;
+        m_aNodes[uNode].auChildren[uSide] = uMoved;
+        m_aNodes[uMoved].uParent = uNode;
+
+        fitToChildren(uNode);
+        fitToChildren(uTall);
+        return uTall;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::buildRange
+
+      Summary:  Builds the subtree of a range of leaves. The centers are
+                binned along the axis where they spread the most and the
+                range is split at the bin boundary with the lowest area
+                times count cost. Leaves whose centers fall in one bin
+                are split in half.
+
+      Args:     UINT* puLeaves
+                  Leaves of the subtree, reordered
+                UINT uCount
+                  Number of leaves, at least 1
+
+      Modifies: [m_aNodes, m_uFreeList, m_buildArea].
+
+      Returns:  UINT
+                  Root of the subtree
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT DynamicAabbTree::buildRange(_Inout_updates_(uCount) UINT* puLeaves, _In_ UINT uCount)
+    {
+        if (uCount == 1u)
+        {
+            return puLeaves[0];
+        }
+
+        // Twice the centers, the factor does not change the split
+        auto getCenter = [this](UINT uLeaf, UINT uAxis) -> FLOAT
+        {
+            const Node& leaf = m_aNodes[uLeaf];
+            return (&leaf.Minimum.x)[uAxis] + (&leaf.Maximum.x)[uAxis];
+        };
+
+        FLOAT aCenterMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        FLOAT aCenterMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (UINT uLeafIdx = 0u; uLeafIdx < uCount; ++uLeafIdx)
+        {
+            for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+            {
+                FLOAT center = getCenter(puLeaves[uLeafIdx], uAxis);
+                aCenterMin[uAxis] = center < aCenterMin[uAxis] ? center : aCenterMin[uAxis];
+                aCenterMax[uAxis] = center > aCenterMax[uAxis] ? center : aCenterMax[uAxis];
+            }
+        }
+
+        UINT uAxis = 0u;
+        for (UINT uOtherAxis = 1u; uOtherAxis < 3u; ++uOtherAxis)
+        {
+            if (aCenterMax[uOtherAxis] - aCenterMin[uOtherAxis] > aCenterMax[uAxis] - aCenterMin[uAxis])
+            {
+                uAxis = uOtherAxis;
+            }
+        }
+
+        UINT uSplit = uCount / 2u;
+        FLOAT spread = aCenterMax[uAxis] - aCenterMin[uAxis];
+        if (spread > 0.0f)
+        {
+            FLOAT binsPerUnit = static_cast<FLOAT>(NUM_SAH_BINS) / spread;
+            auto getBin = [&](UINT uLeaf) -> UINT
+            {
+                UINT uBin = static_cast<UINT>((getCenter(uLeaf, uAxis) - aCenterMin[uAxis]) * binsPerUnit);
+                return uBin < NUM_SAH_BINS ? uBin : NUM_SAH_BINS - 1u;
+            };
+
+            UINT auBinCounts[NUM_SAH_BINS] = {};
+            XMFLOAT3 aBinMin[NUM_SAH_BINS];
+            XMFLOAT3 aBinMax[NUM_SAH_BINS];
+            std::fill(aBinMin, aBinMin + NUM_SAH_BINS, XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX));
+            std::fill(aBinMax, aBinMax + NUM_SAH_BINS, XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+            for (UINT uLeafIdx = 0u; uLeafIdx < uCount; ++uLeafIdx)
+            {
+                const Node& leaf = m_aNodes[puLeaves[uLeafIdx]];
+                UINT uBin = getBin(puLeaves[uLeafIdx]);
+                ++auBinCounts[uBin];
+                XMStoreFloat3(&aBinMin[uBin], XMVectorMin(XMLoadFloat3(&aBinMin[uBin]), XMLoadFloat3(&leaf.Minimum)));
+                XMStoreFloat3(&aBinMax[uBin], XMVectorMax(XMLoadFloat3(&aBinMax[uBin]), XMLoadFloat3(&leaf.Maximum)));
+            }
+
+            // Cost of the leaves right of every boundary, swept from the right
+            FLOAT aRightCosts[NUM_SAH_BINS] = {};
+            XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+            XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+            UINT uNumRight = 0u;
+            for (UINT uBin = NUM_SAH_BINS - 1u; uBin > 0u; --uBin)
+            {
+                minimum = XMVectorMin(minimum, XMLoadFloat3(&aBinMin[uBin]));
+                maximum = XMVectorMax(maximum, XMLoadFloat3(&aBinMax[uBin]));
+                uNumRight += auBinCounts[uBin];
+                XMFLOAT3 rightMin;
+                XMFLOAT3 rightMax;
+                XMStoreFloat3(&rightMin, minimum);
+                XMStoreFloat3(&rightMax, maximum);
+                aRightCosts[uBin] = uNumRight > 0u ? getArea(rightMin, rightMax) * static_cast<FLOAT>(uNumRight) : 0.0f;
+            }
+
+            FLOAT bestCost = FLT_MAX;
+            UINT uBestBin = 0u;
+            minimum = XMVectorReplicate(FLT_MAX);
+            maximum = XMVectorReplicate(-FLT_MAX);
+            UINT uNumLeft = 0u;
+            for (UINT uBin = 1u; uBin < NUM_SAH_BINS; ++uBin)
+            {
+                minimum = XMVectorMin(minimum, XMLoadFloat3(&aBinMin[uBin - 1u]));
+                maximum = XMVectorMax(maximum, XMLoadFloat3(&aBinMax[uBin - 1u]));
+                uNumLeft += auBinCounts[uBin - 1u];
+                if (uNumLeft == 0u || uNumLeft == uCount)
+                {
+                    continue;
+                }
+
+                XMFLOAT3 leftMin;
+                XMFLOAT3 leftMax;
+                XMStoreFloat3(&leftMin, minimum);
+                XMStoreFloat3(&leftMax, maximum);
+                FLOAT cost = getArea(leftMin, leftMax) * static_cast<FLOAT>(uNumLeft) + aRightCosts[uBin];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    uBestBin = uBin;
+                }
+            }
+
+            if (uBestBin > 0u)
+            {
+                UINT* puMiddle = std::partition(puLeaves, puLeaves + uCount, [&](UINT uLeaf) { return getBin(uLeaf) < uBestBin; });
+                uSplit = static_cast<UINT>(puMiddle - puLeaves);
+            }
+        }
+
+        UINT uLeft = buildRange(puLeaves, uSplit);
+        UINT uRight = buildRange(puLeaves + uSplit, uCount - uSplit);
+
+        UINT uNode = allocateNode();
+        m_aNodes[uNode].auChildren[0] = uLeft;
+        m_aNodes[uNode].auChildren[1] = uRight;
+        m_aNodes[uLeft].uParent = uNode;
+        m_aNodes[uRight].uParent = uNode;
+        fitToChildren(uNode);
+
+        m_buildArea += getArea(m_aNodes[uNode].Minimum, m_aNodes[uNode].Maximum);
+        return uNode;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::collectLeaves
+
+      Summary:  Appends every leaf of a subtree
+
+      Args:     UINT uNode
+                  Root of the subtree
+                std::vector<UINT>& aOutProxies
+                  Proxies to append to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::collectLeaves(_In_ UINT uNode, _Inout_ std::vector<UINT>& aOutProxies) const
+    {
+        std::vector<UINT> aStack;
+        aStack.reserve(64u);
+        aStack.push_back(uNode);
+        while (!aStack.empty())
+        {
+            const Node& node = m_aNodes[aStack.back()];
+            UINT uCurrent = aStack.back();
+            aStack.pop_back();
+
+            if (node.height == 0)
+            {
+                aOutProxies.push_back(uCurrent);
+                continue;
+            }
+            aStack.push_back(node.auChildren[0]);
+            aStack.push_back(node.auChildren[1]);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::fitToChildren
+
+      Summary:  Sets the box of an internal node to the union of the
+                boxes of its children and its height to one more than
+                the taller one
+
+      Args:     UINT uNode
+                  Internal node
+
+      Modifies: [m_aNodes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::fitToChildren(_In_ UINT uNode)
+    {
+        Node& node = m_aNodes[uNode];
+        const Node& left = m_aNodes[node.auChildren[0]];
+        const Node& right = m_aNodes[node.auChildren[1]];
+
+        XMStoreFloat3(&node.Minimum, XMVectorMin(XMLoadFloat3(&left.Minimum), XMLoadFloat3(&right.Minimum)));
+        XMStoreFloat3(&node.Maximum, XMVectorMax(XMLoadFloat3(&left.Maximum), XMLoadFloat3(&right.Maximum)));
+        node.height = 1 + (left.height > right.height ? left.height : right.height);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::freeNode
+
+      Summary:  Puts a node on the free list
+
+      Args:     UINT uNode
+                  Node to free
+
+      Modifies: [m_aNodes, m_uFreeList].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::freeNode(_In_ UINT uNode)
+    {
+        m_aNodes[uNode].uParent = m_uFreeList;
+        m_aNodes[uNode].height = -1;
+        m_aNodes[uNode].pRenderable = nullptr;
+        m_uFreeList = uNode;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::insertLeaf
+
+      Summary:  Links a leaf into the tree. From the root, the descent
+                stops at the node where pairing the leaf costs less than
+                pushing it into either child, the cost being the area of
+                the new parent plus the growth of the ancestors. The
+                path back to the root is refitted and balanced.
+
+      Args:     UINT uLeaf
+                  Leaf with its box set
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::insertLeaf(_In_ UINT uLeaf)
+    {
+        if (m_uRoot == NULL_NODE)
+        {
+            m_uRoot = uLeaf;
+            m_aNodes[uLeaf].uParent = NULL_NODE;
+            return;
+        }
+
+        UINT uSibling = m_uRoot;
+        while (m_aNodes[uSibling].height > 0)
+        {
+            const Node& node = m_aNodes[uSibling];
+            const Node& leaf = m_aNodes[uLeaf];
+            FLOAT area = getArea(node.Minimum, node.Maximum);
+            FLOAT combinedArea = getUnionArea(node, leaf);
+
+            // Pairing the leaf with this node, or the growth every ancestor of a deeper sibling pays
+            FLOAT cost = 2.0f * combinedArea;
+            FLOAT inheritedCost = 2.0f * (combinedArea - area);
+
+            FLOAT aChildCosts[2];
+            for (UINT uSide = 0u; uSide < 2u; ++uSide)
+            {
+                const Node& child = m_aNodes[node.auChildren[uSide]];
+                FLOAT childCombinedArea = getUnionArea(child, leaf);
+                aChildCosts[uSide] = (child.height == 0 ? childCombinedArea : childCombinedArea - getArea(child.Minimum, child.Maximum)) + inheritedCost;
+            }
+
+            if (cost < aChildCosts[0] && cost < aChildCosts[1])
+            {
+                break;
+            }
+            uSibling = node.auChildren[aChildCosts[0] < aChildCosts[1] ? 0u : 1u];
+        }
+
+        UINT uOldParent = m_aNodes[uSibling].uParent;
+        UINT uNewParent = allocateNode();
+        m_aNodes[uNewParent].uParent = uOldParent;
+        m_aNodes[uNewParent].auChildren[0] = uSibling;
+        m_aNodes[uNewParent].auChildren[1] = uLeaf;
+        m_aNodes[uSibling].uParent = uNewParent;
+        m_aNodes[uLeaf].uParent = uNewParent;
+        if (uOldParent == NULL_NODE)
+        {
+            m_uRoot = uNewParent;
+        }
+        else
+        {
+            UINT uSide = m_aNodes[uOldParent].auChildren[0] == uSibling ? 0u : 1u;
+            m_aNodes[uOldParent].auChildren[uSide] = uNewParent;
+        }
+
+        for (UINT uNode = uNewParent; uNode != NULL_NODE; uNode = m_aNodes[uNode].uParent)
+        {
+            fitToChildren(uNode);
+            uNode = balance(uNode);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   DynamicAabbTree::removeLeaf
+
+      Summary:  Unlinks a leaf, its sibling takes the place of their
+                parent, which is freed. The path back to the root is
+                refitted and balanced.
+
+      Args:     UINT uLeaf
+                  Leaf to unlink
+
+      Modifies: [m_aNodes, m_uRoot, m_uFreeList].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void DynamicAabbTree::removeLeaf(_In_ UINT uLeaf)
+    {
+        if (uLeaf == m_uRoot)
+        {
+            m_uRoot = NULL_NODE;
+            return;
+        }
+
+        UINT uParent = m_aNodes[uLeaf].uParent;
+        UINT uGrandparent = m_aNodes[uParent].uParent;
+        UINT uSibling = m_aNodes[uParent].auChildren[m_aNodes[uParent].auChildren[0] == uLeaf ? 1u : 0u];
+        freeNode(uParent);
+
+        m_aNodes[uSibling].uParent = uGrandparent;
+        if (uGrandparent == NULL_NODE)
+        {
+            m_uRoot = uSibling;
+            return;
+        }
+
+        UINT uSide = m_aNodes[uGrandparent].auChildren[0] == uParent ? 0u : 1u;
+        m_aNodes[uGrandparent].auChildren[uSide] = uSibling;
+        for (UINT uNode = uGrandparent; uNode != NULL_NODE; uNode = m_aNodes[uNode].uParent)
+        {
+            fitToChildren(uNode);
+            uNode = balance(uNode);
+        }
+    }
+}
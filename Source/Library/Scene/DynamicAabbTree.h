@@ -0,0 +1,146 @@
+/*+===================================================================
+  File:      DYNAMICAABBTREE.H
+
+  Summary:   DynamicAabbTree header file contains declarations of the
+             DynamicAabbTree class, a bounding volume hierarchy of the
+             renderables of a scene.
+
+  Classes: DynamicAabbTree
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+
+namespace library
+{
+    class Renderable;
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    DynamicAabbTree
+
+      Summary:  Binary tree of axis-aligned boxes whose leaves are the
+                world space bounds of objects, every internal node
+                bounds its two children.
+
+                Insert descends to the sibling that grows the surface
+                area of the tree the least and rebalances the path back
+                to the root with tree rotations. Update refits a leaf in
+                place and the ancestors up to the first one that does not
+                change, which is cheap but lets the internal boxes grow
+                as objects move apart. The growth is tracked and
+                NeedsRebuild reports when it passes half of the internal
+                area of the last build, Rebuild then rebuilds the tree
+                top-down with a binned surface area heuristic.
+
+                The proxy id returned by Insert is the index of the leaf
+                node, it stays valid until the leaf is removed, including
+                across Rebuild.
+
+      Methods:  Clear
+                  Removes every proxy
+                GetBounds
+                  Returns the bounds of a proxy
+                GetHeight
+                  Returns the height of the tree
+                GetNumProxies
+                  Returns the number of proxies
+                GetRenderable
+                  Returns the renderable of a proxy
+                Insert
+                  Adds a renderable with its bounds
+                NeedsRebuild
+                  Returns whether refits have degraded the tree
+                QueryBox
+                  Finds the proxies that overlap a box
+                QueryFrustum
+                  Finds the proxies that intersect a view frustum
+                QuerySphere
+                  Finds the proxies that overlap a sphere
+                Raycast
+                  Finds the nearest proxy hit by a ray
+                Rebuild
+                  Rebuilds the tree with the surface area heuristic
+                Remove
+                  Removes a proxy
+                Update
+                  Refits a proxy to new bounds
+                DynamicAabbTree
+                  Constructor.
+                ~DynamicAabbTree
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class DynamicAabbTree final
+    {
+    public:
+        static constexpr const UINT NULL_NODE = 0xFFFFFFFF;
+        static constexpr const UINT NUM_SAH_BINS = 16u;
+        // Refits may grow the internal area by this fraction of the area of the last build before a rebuild
+        static constexpr const FLOAT REBUILD_GROWTH_RATIO = 0.5f;
+
+    public:
+        DynamicAabbTree();
+        DynamicAabbTree(const DynamicAabbTree& other) = delete;
+        DynamicAabbTree(DynamicAabbTree&& other) = delete;
+        DynamicAabbTree& operator=(const DynamicAabbTree& other) = delete;
+        DynamicAabbTree& operator=(DynamicAabbTree&& other) = delete;
+        ~DynamicAabbTree() = default;
+
+        void Clear();
+        AxisAlignedBox GetBounds(_In_ UINT uProxy) const;
+        UINT GetHeight() const;
+        UINT GetNumProxies() const;
+        Renderable* GetRenderable(_In_ UINT uProxy) const;
+        UINT Insert(_In_ const AxisAlignedBox& bounds, _In_opt_ Renderable* pRenderable);
+        BOOL NeedsRebuild() const;
+        void QueryBox(_In_ const AxisAlignedBox& box, _Out_ std::vector<UINT>& aOutProxies) const;
+        void QueryFrustum(_In_ FXMMATRIX viewProjection, _Out_ std::vector<UINT>& aOutProxies) const;
+        void QuerySphere(_In_ FXMVECTOR center, _In_ FLOAT radius, _Out_ std::vector<UINT>& aOutProxies) const;
+        BOOL Raycast(_In_ FXMVECTOR origin, _In_ FXMVECTOR direction, _In_ FLOAT maxDistance, _Out_ UINT& uOutProxy, _Out_ FLOAT& outDistance) const;
+        void Rebuild();
+        void Remove(_In_ UINT uProxy);
+        void Update(_In_ UINT uProxy, _In_ const AxisAlignedBox& bounds);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Node
+
+            Summary:  Node of the tree. A leaf has no children and a
+                      height of 0, a free node a height of -1 and the
+                      next free node in uParent.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Node
+        {
+            XMFLOAT3 Minimum;
+            XMFLOAT3 Maximum;
+            UINT uParent;
+            UINT auChildren[2];
+            INT height;
+            Renderable* pRenderable;
+        };
+
+        static FLOAT getArea(_In_ const XMFLOAT3& minimum, _In_ const XMFLOAT3& maximum);
+        static FLOAT getUnionArea(_In_ const Node& a, _In_ const Node& b);
+
+        UINT allocateNode();
+        UINT balance(_In_ UINT uNode);
+        UINT buildRange(_Inout_updates_(uCount) UINT* puLeaves, _In_ UINT uCount);
+        void collectLeaves(_In_ UINT uNode, _Inout_ std::vector<UINT>& aOutProxies) const;
+        void fitToChildren(_In_ UINT uNode);
+        void freeNode(_In_ UINT uNode);
+        void insertLeaf(_In_ UINT uLeaf);
+        void removeLeaf(_In_ UINT uLeaf);
+
+    private:
+        std::vector<Node> m_aNodes;
+        UINT m_uRoot;
+        UINT m_uFreeList;
+        UINT m_uNumProxies;
+        FLOAT m_buildArea;
+        FLOAT m_refitGrowth;
+        std::vector<UINT> m_aBuildLeaves;
+    };
+}
@@ -0,0 +1,387 @@
+#include "Scene/HorizonCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::HorizonCuller
+
+      Summary:  Constructor
+
+      Modifies: [m_aHorizon, m_aCandidates, m_aOccluders, m_aBucketOffsets,
+                 m_aBlocks, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HorizonCuller::HorizonCuller()
+        : m_aHorizon()
+        , m_aCandidates()
+        , m_aOccluders()
+        , m_aBucketOffsets()
+        , m_aBlocks()
+        , m_statistics()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::Cull
+
+      Summary:  Sweeps the blocks from the eye outwards and marks the
+                ones that may be seen over the occluders. Blocks that
+                contain the eye are always visible.
+
+      Args:     FXMVECTOR eye
+                  Position of the camera
+                const std::vector<HeightBounds>& aOccluders
+                  Terrain that hides what is behind it
+                const std::vector<HeightBounds>& aBlocks
+                  Blocks to test
+                std::vector<BOOL>& aOutVisible
+                  FALSE for every hidden block, resized to the number
+                  of blocks
+
+      Modifies: [m_aHorizon, m_aCandidates, m_aOccluders, m_aBucketOffsets,
+                 m_aBlocks, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::Cull(_In_ FXMVECTOR eye, _In_ const std::vector<HeightBounds>& aOccluders, _In_ const std::vector<HeightBounds>& aBlocks, _Out_ std::vector<BOOL>& aOutVisible)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        FLOAT eyeX = XMVectorGetX(eye);
+        FLOAT eyeY = XMVectorGetY(eye);
+        FLOAT eyeZ = XMVectorGetZ(eye);
+
+        aOutVisible.assign(aBlocks.size(), TRUE);
+        std::fill(m_aHorizon, m_aHorizon + NUM_BINS, -FLT_MAX);
+
+        // Counting sort of the occluders on their far edge rounded up to a bucket, so an occluder whose bucket is
+        // not past the near edge of a block rounded down is in front of the block
+        getCandidates(eyeX, eyeZ, aOccluders, m_aCandidates);
+        FLOAT maxDistance = 0.0f;
+        for (const Candidate& candidate : m_aCandidates)
+        {
+            maxDistance = candidate.maxDistance > maxDistance ? candidate.maxDistance : maxDistance;
+        }
+        FLOAT bucketsPerUnit = static_cast<FLOAT>(NUM_DISTANCE_BUCKETS) / (maxDistance > 0.0f ? maxDistance : 1.0f);
+        auto getOccluderBucket = [bucketsPerUnit](const Candidate& candidate) -> UINT
+        {
+            UINT uBucket = static_cast<UINT>(std::ceil(candidate.maxDistance * bucketsPerUnit));
+            return uBucket < NUM_DISTANCE_BUCKETS ? uBucket : NUM_DISTANCE_BUCKETS;
+        };
+
+        m_aBucketOffsets.assign(NUM_DISTANCE_BUCKETS + 2u, 0u);
+        for (const Candidate& candidate : m_aCandidates)
+        {
+            ++m_aBucketOffsets[getOccluderBucket(candidate) + 1u];
+        }
+        for (UINT uBucket = 1u; uBucket < NUM_DISTANCE_BUCKETS + 2u; ++uBucket)
+        {
+            m_aBucketOffsets[uBucket] += m_aBucketOffsets[uBucket - 1u];
+        }
+        m_aOccluders.resize(m_aCandidates.size());
+        for (const Candidate& candidate : m_aCandidates)
+        {
+            m_aOccluders[m_aBucketOffsets[getOccluderBucket(candidate)]++] = candidate;
+        }
+
+        getCandidates(eyeX, eyeZ, aBlocks, m_aBlocks);
+        std::sort(m_aBlocks.begin(), m_aBlocks.end(), [](const Candidate& a, const Candidate& b)
+            {
+                return a.minDistance < b.minDistance;
+            });
+
+        size_t uOccluderIdx = 0u;
+        UINT uNumCulledBlocks = 0u;
+        for (const Candidate& block : m_aBlocks)
+        {
+            // Every ray through a fully covered bin crosses the footprint, so it is blocked below the lowest top
+            UINT uBlockBucket = static_cast<UINT>(std::floor(block.minDistance * bucketsPerUnit));
+            for (; uOccluderIdx < m_aOccluders.size() && getOccluderBucket(m_aOccluders[uOccluderIdx]) <= uBlockBucket; ++uOccluderIdx)
+            {
+                const Candidate& occluder = m_aOccluders[uOccluderIdx];
+                const HeightBounds& bounds = aOccluders[occluder.uIndex];
+                FLOAT firstBin = 0.0f;
+                FLOAT lastBin = 0.0f;
+                getBinRange(eyeX, eyeZ, bounds, firstBin, lastBin);
+
+                FLOAT minRise = bounds.minTop - eyeY;
+                FLOAT slope = minRise / (minRise >= 0.0f ? occluder.maxDistance : occluder.minDistance);
+                raiseHorizon(static_cast<INT>(std::ceil(firstBin)), static_cast<INT>(std::floor(lastBin)), slope);
+            }
+
+            // The highest top is steepest at the near edge when it is above the eye, at the far edge otherwise
+            const HeightBounds& bounds = aBlocks[block.uIndex];
+            FLOAT firstBin = 0.0f;
+            FLOAT lastBin = 0.0f;
+            getBinRange(eyeX, eyeZ, bounds, firstBin, lastBin);
+
+            FLOAT maxRise = bounds.maxTop - eyeY;
+            FLOAT maxSlope = maxRise / (maxRise >= 0.0f ? block.minDistance : block.maxDistance);
+            if (!isAboveHorizon(static_cast<INT>(std::floor(firstBin)), static_cast<INT>(std::floor(lastBin)) + 1, maxSlope))
+            {
+                aOutVisible[block.uIndex] = FALSE;
+                ++uNumCulledBlocks;
+            }
+        }
+
+        m_statistics.uNumTestedBlocks = static_cast<UINT>(m_aBlocks.size());
+        m_statistics.uNumCulledBlocks = uNumCulledBlocks;
+        m_statistics.cullTime = std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::GetStatistics
+
+      Summary:  Returns the counters of the last Cull
+
+      Returns:  const HorizonCuller::Statistics&
+                  Counters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const HorizonCuller::Statistics& HorizonCuller::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getPseudoAngle
+
+      Summary:  Returns a value that grows monotonically with the
+                azimuth of a direction, without trigonometry. The bins
+                only need a consistent order, not uniform angles.
+
+      Args:     FLOAT x
+                  Direction along the x-axis
+                FLOAT z
+                  Direction along the z-axis
+
+      Returns:  FLOAT
+                  Pseudo angle in [0, FULL_TURN), 0 along +x and 1
+                  along +z
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT HorizonCuller::getPseudoAngle(_In_ FLOAT x, _In_ FLOAT z)
+    {
+        if (z >= 0.0f)
+        {
+            return x >= 0.0f ? z / (x + z) : 1.0f - x / (z - x);
+        }
+
+        return x < 0.0f ? 2.0f - z / (-x - z) : 3.0f + x / (x - z);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getCandidates
+
+      Summary:  Returns the distances of the footprints that do not
+                contain the eye
+
+      Args:     FLOAT eyeX
+                  Position of the eye along the x-axis
+                FLOAT eyeZ
+                  Position of the eye along the z-axis
+                const std::vector<HeightBounds>& aBounds
+                  Footprints
+                std::vector<Candidate>& aOutCandidates
+                  Candidates, unsorted
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::getCandidates(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ const std::vector<HeightBounds>& aBounds, _Out_ std::vector<Candidate>& aOutCandidates)
+    {
+        aOutCandidates.clear();
+        for (UINT uIndex = 0u; uIndex < static_cast<UINT>(aBounds.size()); ++uIndex)
+        {
+            const HeightBounds& bounds = aBounds[uIndex];
+            FLOAT dx = eyeX < bounds.minX ? bounds.minX - eyeX : (eyeX > bounds.maxX ? eyeX - bounds.maxX : 0.0f);
+            FLOAT dz = eyeZ < bounds.minZ ? bounds.minZ - eyeZ : (eyeZ > bounds.maxZ ? eyeZ - bounds.maxZ : 0.0f);
+            if (dx <= 0.0f && dz <= 0.0f)
+            {
+                continue;
+            }
+
+            FLOAT farX = std::fabs(eyeX - bounds.minX) > std::fabs(eyeX - bounds.maxX) ? eyeX - bounds.minX : eyeX - bounds.maxX;
+            FLOAT farZ = std::fabs(eyeZ - bounds.minZ) > std::fabs(eyeZ - bounds.maxZ) ? eyeZ - bounds.minZ : eyeZ - bounds.maxZ;
+
+            aOutCandidates.push_back(Candidate{
+                .minDistance = std::sqrt(dx * dx + dz * dz),
+                .maxDistance = std::sqrt(farX * farX + farZ * farZ),
+                .uIndex = uIndex
+            });
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::getBinRange
+
+      Summary:  Returns the bins spanned by a footprint that does not
+                contain the eye
+
+      Args:     FLOAT eyeX
+                  Position of the eye along the x-axis
+                FLOAT eyeZ
+                  Position of the eye along the z-axis
+                const HeightBounds& bounds
+                  Footprint
+                FLOAT& outFirstBin
+                  Fractional bin of the first edge, may be negative
+                FLOAT& outLastBin
+                  Fractional bin of the last edge, may be past
+                  NUM_BINS
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::getBinRange(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ const HeightBounds& bounds, _Out_ FLOAT& outFirstBin, _Out_ FLOAT& outLastBin)
+    {
+        constexpr const FLOAT BINS_PER_UNIT = static_cast<FLOAT>(NUM_BINS) / FULL_TURN;
+
+        // Silhouette corners of the footprint by the region of the eye around it, as (x, z, x, z) with 0 for the
+        // minimum and 1 for the maximum coordinate. The center region contains the eye and never gets here.
+        static constexpr const BYTE s_aSilhouettes[3][3][4] =
+        {
+            { { 1, 0, 0, 1 }, { 0, 0, 1, 0 }, { 0, 0, 1, 1 } },
+            { { 0, 0, 0, 1 }, { 0, 0, 1, 1 }, { 1, 0, 1, 1 } },
+            { { 0, 0, 1, 1 }, { 0, 1, 1, 1 }, { 1, 0, 0, 1 } },
+        };
+        UINT uRegionX = eyeX < bounds.minX ? 0u : (eyeX > bounds.maxX ? 2u : 1u);
+        UINT uRegionZ = eyeZ < bounds.minZ ? 0u : (eyeZ > bounds.maxZ ? 2u : 1u);
+        const BYTE* pSilhouette = s_aSilhouettes[uRegionZ][uRegionX];
+
+        FLOAT firstAngle = getPseudoAngle((pSilhouette[0] ? bounds.maxX : bounds.minX) - eyeX, (pSilhouette[1] ? bounds.maxZ : bounds.minZ) - eyeZ);
+        FLOAT lastAngle = getPseudoAngle((pSilhouette[2] ? bounds.maxX : bounds.minX) - eyeX, (pSilhouette[3] ? bounds.maxZ : bounds.minZ) - eyeZ);
+
+        // A footprint without the eye spans less than half a turn
+        FLOAT span = lastAngle - firstAngle;
+        span = span > 0.5f * FULL_TURN ? span - FULL_TURN : (span < -0.5f * FULL_TURN ? span + FULL_TURN : span);
+        if (span < 0.0f)
+        {
+            firstAngle = lastAngle;
+            span = -span;
+        }
+
+        outFirstBin = firstAngle * BINS_PER_UNIT;
+        outLastBin = (firstAngle + span) * BINS_PER_UNIT;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::isAboveSegment
+
+      Summary:  Tests a slope against contiguous bins, four at a time
+
+      Args:     const FLOAT* pHorizon
+                  First bin
+                UINT uCount
+                  Number of bins
+                FLOAT slope
+                  Elevation slope
+
+      Returns:  BOOL
+                  TRUE if the slope is above the horizon of any bin
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL HorizonCuller::isAboveSegment(_In_reads_(uCount) const FLOAT* pHorizon, _In_ UINT uCount, _In_ FLOAT slope)
+    {
+        __m128 slopes = _mm_set1_ps(slope);
+        UINT uBinIdx = 0u;
+        for (; uBinIdx + 4u <= uCount; uBinIdx += 4u)
+        {
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(pHorizon + uBinIdx), slopes)) != 0)
+            {
+                return TRUE;
+            }
+        }
+        for (; uBinIdx < uCount; ++uBinIdx)
+        {
+            if (pHorizon[uBinIdx] < slope)
+            {
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::raiseSegment
+
+      Summary:  Raises contiguous bins to a slope, four at a time
+
+      Args:     FLOAT* pHorizon
+                  First bin
+                UINT uCount
+                  Number of bins
+                FLOAT slope
+                  Elevation slope
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::raiseSegment(_Inout_updates_(uCount) FLOAT* pHorizon, _In_ UINT uCount, _In_ FLOAT slope)
+    {
+        __m128 slopes = _mm_set1_ps(slope);
+        UINT uBinIdx = 0u;
+        for (; uBinIdx + 4u <= uCount; uBinIdx += 4u)
+        {
+            _mm_storeu_ps(pHorizon + uBinIdx, _mm_max_ps(_mm_loadu_ps(pHorizon + uBinIdx), slopes));
+        }
+        for (; uBinIdx < uCount; ++uBinIdx)
+        {
+            pHorizon[uBinIdx] = pHorizon[uBinIdx] > slope ? pHorizon[uBinIdx] : slope;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::isAboveHorizon
+
+      Summary:  Tests a slope against a range of bins that may wrap
+                around
+
+      Args:     INT beginBin
+                  First bin, may be outside [0, NUM_BINS)
+                INT endBin
+                  One past the last bin
+                FLOAT slope
+                  Elevation slope
+
+      Returns:  BOOL
+                  TRUE if the slope is above the horizon of any bin
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL HorizonCuller::isAboveHorizon(_In_ INT beginBin, _In_ INT endBin, _In_ FLOAT slope) const
+    {
+        INT numBins = static_cast<INT>(NUM_BINS);
+        INT count = endBin - beginBin < numBins ? endBin - beginBin : numBins;
+        if (count <= 0)
+        {
+            return FALSE;
+        }
+
+        INT begin = (beginBin % numBins + numBins) % numBins;
+        INT firstCount = count < numBins - begin ? count : numBins - begin;
+
+        return isAboveSegment(m_aHorizon + begin, static_cast<UINT>(firstCount), slope) ||
+            isAboveSegment(m_aHorizon, static_cast<UINT>(count - firstCount), slope);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   HorizonCuller::raiseHorizon
+
+      Summary:  Raises a range of bins that may wrap around to a slope
+
+      Args:     INT beginBin
+                  First bin, may be outside [0, NUM_BINS)
+                INT endBin
+                  One past the last bin
+                FLOAT slope
+                  Elevation slope
+
+      Modifies: [m_aHorizon].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void HorizonCuller::raiseHorizon(_In_ INT beginBin, _In_ INT endBin, _In_ FLOAT slope)
+    {
+        INT numBins = static_cast<INT>(NUM_BINS);
+        INT count = endBin - beginBin < numBins ? endBin - beginBin : numBins;
+        if (count <= 0)
+        {
+            return;
+        }
+
+        INT begin = (beginBin % numBins + numBins) % numBins;
+        INT firstCount = count < numBins - begin ? count : numBins - begin;
+
+        raiseSegment(m_aHorizon + begin, static_cast<UINT>(firstCount), slope);
+        raiseSegment(m_aHorizon, static_cast<UINT>(count - firstCount), slope);
+    }
+}
@@ -0,0 +1,129 @@
+/*+===================================================================
+  File:      HORIZONCULLER.H
+
+  Summary:   HorizonCuller header file contains declarations of the
+             HorizonCuller class that rejects heightmap terrain hidden
+             behind nearer terrain.
+
+  Classes: HorizonCuller
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   HeightBounds
+
+      Summary:  Footprint of a block of terrain columns on the xz-plane
+                with the lowest and the highest top of its columns, in
+                world space. Occluders only use the lowest top, tested
+                blocks only the highest.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct HeightBounds
+    {
+        FLOAT minX;
+        FLOAT minZ;
+        FLOAT maxX;
+        FLOAT maxZ;
+        FLOAT minTop;
+        FLOAT maxTop;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    HorizonCuller
+
+      Summary:  CPU occlusion culling for 2.5D terrain.
+
+                The azimuth around the eye is split into NUM_BINS bins,
+                each holding the steepest elevation slope known to be
+                blocked by terrain. Blocks and occluders are swept from
+                the eye outwards: a block is hidden when its highest top
+                stays below the horizon over every bin it touches, an
+                occluder raises the horizon to its lowest top over the
+                bins it fully covers. An occluder only raises the
+                horizon once the sweep has passed its far edge, so it is
+                always in front of what it hides, so the occluders are
+                bucketed by their far edge, rounded up, and the blocks
+                sorted by their near edge.
+
+                Occluders are usually finer than the tested blocks: the
+                lowest column of a large block is too low to hide much.
+
+      Methods:  Cull
+                  Marks the blocks that are not hidden
+                GetStatistics
+                  Returns the counters of the last Cull
+                HorizonCuller
+                  Constructor.
+                ~HorizonCuller
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class HorizonCuller
+    {
+    public:
+        static constexpr const UINT NUM_BINS = 1024u;
+        static constexpr const UINT NUM_DISTANCE_BUCKETS = 1024u;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Statistics
+
+            Summary:  Counters of the last Cull, the time is in
+                      milliseconds
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Statistics
+        {
+            UINT uNumTestedBlocks;
+            UINT uNumCulledBlocks;
+            FLOAT cullTime;
+        };
+
+    public:
+        HorizonCuller();
+        HorizonCuller(const HorizonCuller& other) = delete;
+        HorizonCuller(HorizonCuller&& other) = delete;
+        HorizonCuller& operator=(const HorizonCuller& other) = delete;
+        HorizonCuller& operator=(HorizonCuller&& other) = delete;
+        ~HorizonCuller() = default;
+
+        void Cull(_In_ FXMVECTOR eye, _In_ const std::vector<HeightBounds>& aOccluders, _In_ const std::vector<HeightBounds>& aBlocks, _Out_ std::vector<BOOL>& aOutVisible);
+
+        const Statistics& GetStatistics() const;
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Candidate
+
+            Summary:  Block or occluder of the sweep, distances on the
+                      xz-plane
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Candidate
+        {
+            FLOAT minDistance;
+            FLOAT maxDistance;
+            UINT uIndex;
+        };
+
+        static constexpr const FLOAT FULL_TURN = 4.0f;
+
+        static FLOAT getPseudoAngle(_In_ FLOAT x, _In_ FLOAT z);
+        static void getCandidates(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ const std::vector<HeightBounds>& aBounds, _Out_ std::vector<Candidate>& aOutCandidates);
+        static void getBinRange(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ const HeightBounds& bounds, _Out_ FLOAT& outFirstBin, _Out_ FLOAT& outLastBin);
+        static BOOL isAboveSegment(_In_reads_(uCount) const FLOAT* pHorizon, _In_ UINT uCount, _In_ FLOAT slope);
+        static void raiseSegment(_Inout_updates_(uCount) FLOAT* pHorizon, _In_ UINT uCount, _In_ FLOAT slope);
+
+        BOOL isAboveHorizon(_In_ INT beginBin, _In_ INT endBin, _In_ FLOAT slope) const;
+        void raiseHorizon(_In_ INT beginBin, _In_ INT endBin, _In_ FLOAT slope);
+
+    private:
+        FLOAT m_aHorizon[NUM_BINS];
+        std::vector<Candidate> m_aCandidates;
+        std::vector<Candidate> m_aOccluders;
+        std::vector<UINT> m_aBucketOffsets;
+        std::vector<Candidate> m_aBlocks;
+        Statistics m_statistics;
+    };
+}
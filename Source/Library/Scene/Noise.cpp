@@ -0,0 +1,653 @@
+#include "Scene/Noise.h"
+
+#include <cmath>
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "Scene/Scene.h"
+
+namespace library
+{
+    namespace
+    {
+        inline FLOAT fade(FLOAT t)
+        {
+            return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+        }
+
+        inline __m256 fadeAvx2(__m256 t)
+        {
+            __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+
+            return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+        }
+
+        inline FLOAT lerp(FLOAT x, FLOAT y, FLOAT s)
+        {
+            return x + s * (y - x);
+        }
+
+        inline __m256 lerpAvx2(__m256 x, __m256 y, __m256 s)
+        {
+            return _mm256_add_ps(x, _mm256_mul_ps(s, _mm256_sub_ps(y, x)));
+        }
+
+        // Mixes the full 32-bit lattice coordinates with the seed hash, then
+        // applies the MurmurHash3 finalizer so every output bit depends on
+        // every input bit. No table and no mask, so the field never repeats.
+        inline UINT hashLattice(INT x, INT y, UINT uSeedHash)
+        {
+            UINT uHash = uSeedHash ^ (static_cast<UINT>(x) * 0x8da6b343u) ^ (static_cast<UINT>(y) * 0xd8163841u);
+            uHash ^= uHash >> 16u;
+            uHash *= 0x85ebca6bu;
+            uHash ^= uHash >> 13u;
+            uHash *= 0xc2b2ae35u;
+            uHash ^= uHash >> 16u;
+
+            return uHash;
+        }
+
+        inline __m256i hashLatticeAvx2(__m256i x, __m256i y, __m256i seedHash)
+        {
+            __m256i hash = _mm256_xor_si256(seedHash, _mm256_xor_si256(_mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<INT>(0x8da6b343u))), _mm256_mullo_epi32(y, _mm256_set1_epi32(static_cast<INT>(0xd8163841u)))));
+            hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+            hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(static_cast<INT>(0x85ebca6bu)));
+            hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 13));
+            hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(static_cast<INT>(0xc2b2ae35u)));
+            hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+
+            return hash;
+        }
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: IsAvx2Supported
+
+      Summary:  Checks once whether the CPU supports AVX2 and the OS
+                saves the AVX registers
+
+      Returns:  BOOL
+                  TRUE if AVX2 code paths can be used
+    -----------------------------------------------------------------F-F*/
+    BOOL IsAvx2Supported()
+    {
+        static const BOOL s_bAvx2Supported = []()
+        {
+            INT aCpuInfo[4];
+            __cpuid(aCpuInfo, 0);
+            if (aCpuInfo[0] < 7)
+            {
+                return FALSE;
+            }
+
+            __cpuid(aCpuInfo, 1);
+            BOOL bOsXSave = (aCpuInfo[2] & (1 << 27)) != 0;
+            BOOL bAvx = (aCpuInfo[2] & (1 << 28)) != 0;
+            if (!bOsXSave || !bAvx || (_xgetbv(0) & 0x6) != 0x6)
+            {
+                return FALSE;
+            }
+
+            __cpuidex(aCpuInfo, 7, 0);
+
+            return (aCpuInfo[1] & (1 << 5)) != 0 ? TRUE : FALSE;
+        }();
+
+        return s_bAvx2Supported;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::Noise
+
+      Summary:  Constructor that derives the lattice hash seed (or the
+                sample offset of LEGACY_VALUE) from the seed
+
+      Args:     eNoiseType type
+                  Noise algorithm
+                UINT uSeed
+                  Seed of the noise field
+
+      Modifies: [m_type, m_uSeed, m_offsetX, m_offsetY, m_warpAmplitude,
+                 m_warpFrequency, m_uLatticeSeed].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Noise::Noise(_In_ eNoiseType type, _In_ UINT uSeed)
+        : m_type(type)
+        , m_uSeed(uSeed)
+        , m_offsetX(0.0f)
+        , m_offsetY(0.0f)
+        , m_warpAmplitude(0.0f)
+        , m_warpFrequency(0.0f)
+        , m_uLatticeSeed(0u)
+    {
+        UINT uHash = hash(uSeed);
+
+        // The legacy table is fixed, so the seed moves the field by whole lattice cells instead
+        if (m_type == eNoiseType::LEGACY_VALUE)
+        {
+            m_offsetX = static_cast<FLOAT>(uHash & 0xffu);
+            m_offsetY = static_cast<FLOAT>((uHash >> 8u) & 0xffu);
+            return;
+        }
+
+        m_uLatticeSeed = uHash;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::GetFractal2d
+
+      Summary:  Returns the sum of uDepth octaves at a point. Every
+                octave doubles the frequency and halves the amplitude,
+                like Scene::GetPerlin2d.
+
+      Args:     FLOAT x
+                  x-coordinate of the sample point
+                FLOAT y
+                  y-coordinate of the sample point
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+
+      Returns:  FLOAT
+                  Noise value in [0, 1]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT Noise::GetFractal2d(_In_ FLOAT x, _In_ FLOAT y, _In_ FLOAT frequency, _In_ UINT uDepth) const
+    {
+        FLOAT value;
+        GetFractal2dBatch(&x, &y, frequency, uDepth, &value, 1u);
+
+        return value;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::GetFractal2dBatch
+
+      Summary:  Evaluates GetFractal2d for uCount sample points at once.
+                Uses AVX2 when the CPU supports it, the results are the
+                same either way.
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+                FLOAT* pOut
+                  Noise values of the sample points in [0, 1]
+                UINT uCount
+                  Number of sample points
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Noise::GetFractal2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const
+    {
+        FLOAT aX[BATCH_SIZE];
+        FLOAT aY[BATCH_SIZE];
+        FLOAT aWarpX[BATCH_SIZE];
+        FLOAT aWarpY[BATCH_SIZE];
+        FLOAT aWarp[BATCH_SIZE];
+
+        FLOAT offsetX = m_offsetX / frequency;
+        FLOAT offsetY = m_offsetY / frequency;
+
+        for (UINT uBegin = 0u; uBegin < uCount; uBegin += BATCH_SIZE)
+        {
+            UINT uNumSamples = uCount - uBegin < BATCH_SIZE ? uCount - uBegin : BATCH_SIZE;
+
+            for (UINT i = 0u; i < uNumSamples; ++i)
+            {
+                aX[i] = pX[uBegin + i] + offsetX;
+                aY[i] = pY[uBegin + i] + offsetY;
+            }
+
+            if (m_warpAmplitude != 0.0f)
+            {
+                for (UINT uAxis = 0u; uAxis < 2u; ++uAxis)
+                {
+                    for (UINT i = 0u; i < uNumSamples; ++i)
+                    {
+                        aWarpX[i] = aX[i] * m_warpFrequency + WARP_OFFSET_X[uAxis];
+                        aWarpY[i] = aY[i] * m_warpFrequency + WARP_OFFSET_Y[uAxis];
+                    }
+
+                    getNoise2dBatch(aWarpX, aWarpY, aWarp, uNumSamples);
+
+                    FLOAT* pAxis = uAxis == 0u ? aX : aY;
+                    for (UINT i = 0u; i < uNumSamples; ++i)
+                    {
+                        pAxis[i] += m_warpAmplitude * aWarp[i];
+                    }
+                }
+            }
+
+            if (m_type == eNoiseType::LEGACY_VALUE)
+            {
+                Scene::GetPerlin2dBatch(aX, aY, frequency, uDepth, pOut + uBegin, uNumSamples);
+            }
+            else
+            {
+                getGradientFractal2dBatch(aX, aY, frequency, uDepth, pOut + uBegin, uNumSamples);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::GetSeed
+
+      Summary:  Returns the seed
+
+      Returns:  UINT
+                  Seed of the noise field
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Noise::GetSeed() const
+    {
+        return m_uSeed;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::GetType
+
+      Summary:  Returns the noise algorithm
+
+      Returns:  eNoiseType
+                  Noise algorithm
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eNoiseType Noise::GetType() const
+    {
+        return m_type;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::SetDomainWarp
+
+      Summary:  Displaces every sample point by amplitude times a single
+                octave of the same noise sampled at frequency, which
+                breaks up the grid aligned look of the octave sum.
+                LEGACY_VALUE needs the displaced points to stay
+                non-negative.
+
+      Args:     FLOAT amplitude
+                  Largest displacement, 0 disables the warp
+                FLOAT frequency
+                  Frequency of the warp field
+
+      Modifies: [m_warpAmplitude, m_warpFrequency].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Noise::SetDomainWarp(_In_ FLOAT amplitude, _In_ FLOAT frequency)
+    {
+        m_warpAmplitude = amplitude;
+        m_warpFrequency = frequency;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::hash
+
+      Summary:  MurmurHash3 finalizer, maps 0 to 0
+
+      Args:     UINT uSeed
+                  Value to hash
+
+      Returns:  UINT
+                  Hashed value
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Noise::hash(_In_ UINT uSeed)
+    {
+        UINT uHash = uSeed;
+        uHash ^= uHash >> 16u;
+        uHash *= 0x85ebca6bu;
+        uHash ^= uHash >> 13u;
+        uHash *= 0xc2b2ae35u;
+        uHash ^= uHash >> 16u;
+
+        return uHash;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getNoise2dBatch
+
+      Summary:  Evaluates a single octave of the noise at uCount points
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT* pOut
+                  Noise values of the sample points in about [-1, 1]
+                UINT uCount
+                  Number of sample points
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Noise::getNoise2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const
+    {
+        UINT uNumDone = 0u;
+
+        switch (m_type)
+        {
+        case eNoiseType::LEGACY_VALUE:
+            Scene::GetPerlin2dBatch(pX, pY, 1.0f, 1u, pOut, uCount);
+            for (UINT i = 0u; i < uCount; ++i)
+            {
+                pOut[i] = pOut[i] * 2.0f - 1.0f;
+            }
+            break;
+
+        case eNoiseType::PERLIN:
+            if (IsAvx2Supported())
+            {
+                uNumDone = getPerlin2dBatchAvx2(pX, pY, pOut, uCount);
+            }
+            for (UINT i = uNumDone; i < uCount; ++i)
+            {
+                pOut[i] = getPerlin2d(pX[i], pY[i]);
+            }
+            break;
+
+        case eNoiseType::SIMPLEX:
+            if (IsAvx2Supported())
+            {
+                uNumDone = getSimplex2dBatchAvx2(pX, pY, pOut, uCount);
+            }
+            for (UINT i = uNumDone; i < uCount; ++i)
+            {
+                pOut[i] = getSimplex2d(pX[i], pY[i]);
+            }
+            break;
+
+        default:
+            assert(FALSE);
+            break;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getGradientFractal2dBatch
+
+      Summary:  Sums uDepth octaves of PERLIN or SIMPLEX noise
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+                FLOAT* pOut
+                  Noise values of the sample points in [0, 1]
+                UINT uCount
+                  Number of sample points, at most BATCH_SIZE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Noise::getGradientFractal2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const
+    {
+        assert(uCount <= BATCH_SIZE);
+
+        FLOAT aXa[BATCH_SIZE];
+        FLOAT aYa[BATCH_SIZE];
+        FLOAT aNoise[BATCH_SIZE];
+
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            aXa[i] = pX[i] * frequency;
+            aYa[i] = pY[i] * frequency;
+            pOut[i] = 0.0f;
+        }
+
+        FLOAT amp = 1.0f;
+        FLOAT div = 0.0f;
+        for (UINT uOctave = 0u; uOctave < uDepth; ++uOctave)
+        {
+            getNoise2dBatch(aXa, aYa, aNoise, uCount);
+
+            for (UINT i = 0u; i < uCount; ++i)
+            {
+                pOut[i] += aNoise[i] * amp;
+                aXa[i] *= 2.0f;
+                aYa[i] *= 2.0f;
+            }
+
+            div += amp;
+            amp /= 2.0f;
+        }
+
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            pOut[i] = pOut[i] / div * 0.5f + 0.5f;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getPerlin2d
+
+      Summary:  Evaluates Perlin gradient noise with quintic fading at a
+                point
+
+      Args:     FLOAT x
+                  x-coordinate of the sample point
+                FLOAT y
+                  y-coordinate of the sample point
+
+      Returns:  FLOAT
+                  Noise value in about [-1, 1]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT Noise::getPerlin2d(_In_ FLOAT x, _In_ FLOAT y) const
+    {
+        FLOAT xFloor = std::floor(x);
+        FLOAT yFloor = std::floor(y);
+        INT xi = static_cast<INT>(xFloor);
+        INT yi = static_cast<INT>(yFloor);
+        FLOAT xFrac = x - xFloor;
+        FLOAT yFrac = y - yFloor;
+
+        UINT h00 = hashLattice(xi, yi, m_uLatticeSeed) >> GRADIENT_SHIFT;
+        UINT h10 = hashLattice(xi + 1, yi, m_uLatticeSeed) >> GRADIENT_SHIFT;
+        UINT h01 = hashLattice(xi, yi + 1, m_uLatticeSeed) >> GRADIENT_SHIFT;
+        UINT h11 = hashLattice(xi + 1, yi + 1, m_uLatticeSeed) >> GRADIENT_SHIFT;
+
+        FLOAT n00 = GRADIENTS_X[h00] * xFrac + GRADIENTS_Y[h00] * yFrac;
+        FLOAT n10 = GRADIENTS_X[h10] * (xFrac - 1.0f) + GRADIENTS_Y[h10] * yFrac;
+        FLOAT n01 = GRADIENTS_X[h01] * xFrac + GRADIENTS_Y[h01] * (yFrac - 1.0f);
+        FLOAT n11 = GRADIENTS_X[h11] * (xFrac - 1.0f) + GRADIENTS_Y[h11] * (yFrac - 1.0f);
+
+        FLOAT u = fade(xFrac);
+        FLOAT v = fade(yFrac);
+
+        return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v) * PERLIN_SCALE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getSimplex2d
+
+      Summary:  Evaluates classic 2D simplex noise at a point: the
+                skewed cell picks one of two triangles, and each of the
+                three corners contributes its gradient with a
+                (0.5 - r^2)^4 falloff, with the 16 direction gradient
+                table.
+
+      Args:     FLOAT x
+                  x-coordinate of the sample point
+                FLOAT y
+                  y-coordinate of the sample point
+
+      Returns:  FLOAT
+                  Noise value in about [-1, 1]
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT Noise::getSimplex2d(_In_ FLOAT x, _In_ FLOAT y) const
+    {
+        FLOAT skew = (x + y) * SIMPLEX_SKEW;
+        FLOAT i = std::floor(x + skew);
+        FLOAT j = std::floor(y + skew);
+        FLOAT unskew = (i + j) * SIMPLEX_UNSKEW;
+        FLOAT x0 = x - (i - unskew);
+        FLOAT y0 = y - (j - unskew);
+
+        // Lower or upper triangle of the skewed cell
+        FLOAT i1 = x0 > y0 ? 1.0f : 0.0f;
+        FLOAT j1 = 1.0f - i1;
+
+        FLOAT x1 = x0 - i1 + SIMPLEX_UNSKEW;
+        FLOAT y1 = y0 - j1 + SIMPLEX_UNSKEW;
+        FLOAT x2 = x0 - 1.0f + 2.0f * SIMPLEX_UNSKEW;
+        FLOAT y2 = y0 - 1.0f + 2.0f * SIMPLEX_UNSKEW;
+
+        INT ii = static_cast<INT>(i);
+        INT jj = static_cast<INT>(j);
+        INT ii1 = static_cast<INT>(i1);
+        INT jj1 = static_cast<INT>(j1);
+
+        UINT h0 = hashLattice(ii, jj, m_uLatticeSeed) >> GRADIENT_SHIFT;
+        UINT h1 = hashLattice(ii + ii1, jj + jj1, m_uLatticeSeed) >> GRADIENT_SHIFT;
+        UINT h2 = hashLattice(ii + 1, jj + 1, m_uLatticeSeed) >> GRADIENT_SHIFT;
+
+        FLOAT t0 = 0.5f - x0 * x0 - y0 * y0;
+        FLOAT t1 = 0.5f - x1 * x1 - y1 * y1;
+        FLOAT t2 = 0.5f - x2 * x2 - y2 * y2;
+        t0 = t0 > 0.0f ? t0 : 0.0f;
+        t1 = t1 > 0.0f ? t1 : 0.0f;
+        t2 = t2 > 0.0f ? t2 : 0.0f;
+        t0 *= t0;
+        t1 *= t1;
+        t2 *= t2;
+
+        FLOAT n0 = t0 * t0 * (GRADIENTS_X[h0] * x0 + GRADIENTS_Y[h0] * y0);
+        FLOAT n1 = t1 * t1 * (GRADIENTS_X[h1] * x1 + GRADIENTS_Y[h1] * y1);
+        FLOAT n2 = t2 * t2 * (GRADIENTS_X[h2] * x2 + GRADIENTS_Y[h2] * y2);
+
+        return (n0 + n1 + n2) * SIMPLEX_SCALE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getPerlin2dBatchAvx2
+
+      Summary:  AVX2 version of getPerlin2d for 8 sample points per
+                iteration
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT* pOut
+                  Noise values of the sample points
+                UINT uCount
+                  Number of sample points
+
+      Returns:  UINT
+                  Number of sample points done, a multiple of 8
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Noise::getPerlin2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const
+    {
+        const __m256i latticeSeed = _mm256_set1_epi32(static_cast<INT>(m_uLatticeSeed));
+        const __m256i oneI = _mm256_set1_epi32(1);
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        UINT uNumBatched = uCount & ~7u;
+        for (UINT uSampleIdx = 0u; uSampleIdx < uNumBatched; uSampleIdx += 8u)
+        {
+            __m256 x = _mm256_loadu_ps(pX + uSampleIdx);
+            __m256 y = _mm256_loadu_ps(pY + uSampleIdx);
+            __m256 xFloor = _mm256_floor_ps(x);
+            __m256 yFloor = _mm256_floor_ps(y);
+            __m256i xi = _mm256_cvttps_epi32(xFloor);
+            __m256i yi = _mm256_cvttps_epi32(yFloor);
+            __m256 xFrac = _mm256_sub_ps(x, xFloor);
+            __m256 yFrac = _mm256_sub_ps(y, yFloor);
+            __m256 xFrac1 = _mm256_sub_ps(xFrac, one);
+            __m256 yFrac1 = _mm256_sub_ps(yFrac, one);
+
+            __m256i xi1 = _mm256_add_epi32(xi, oneI);
+            __m256i yi1 = _mm256_add_epi32(yi, oneI);
+
+            __m256i h00 = _mm256_srli_epi32(hashLatticeAvx2(xi, yi, latticeSeed), GRADIENT_SHIFT);
+            __m256i h10 = _mm256_srli_epi32(hashLatticeAvx2(xi1, yi, latticeSeed), GRADIENT_SHIFT);
+            __m256i h01 = _mm256_srli_epi32(hashLatticeAvx2(xi, yi1, latticeSeed), GRADIENT_SHIFT);
+            __m256i h11 = _mm256_srli_epi32(hashLatticeAvx2(xi1, yi1, latticeSeed), GRADIENT_SHIFT);
+
+            __m256 n00 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h00, 4), xFrac), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h00, 4), yFrac));
+            __m256 n10 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h10, 4), xFrac1), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h10, 4), yFrac));
+            __m256 n01 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h01, 4), xFrac), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h01, 4), yFrac1));
+            __m256 n11 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h11, 4), xFrac1), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h11, 4), yFrac1));
+
+            __m256 u = fadeAvx2(xFrac);
+            __m256 v = fadeAvx2(yFrac);
+
+            __m256 value = lerpAvx2(lerpAvx2(n00, n10, u), lerpAvx2(n01, n11, u), v);
+            _mm256_storeu_ps(pOut + uSampleIdx, _mm256_mul_ps(value, _mm256_set1_ps(PERLIN_SCALE)));
+        }
+
+        return uNumBatched;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Noise::getSimplex2dBatchAvx2
+
+      Summary:  AVX2 version of getSimplex2d for 8 sample points per
+                iteration
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT* pOut
+                  Noise values of the sample points
+                UINT uCount
+                  Number of sample points
+
+      Returns:  UINT
+                  Number of sample points done, a multiple of 8
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Noise::getSimplex2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const
+    {
+        const __m256i latticeSeed = _mm256_set1_epi32(static_cast<INT>(m_uLatticeSeed));
+        const __m256i oneI = _mm256_set1_epi32(1);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 unskew = _mm256_set1_ps(SIMPLEX_UNSKEW);
+        const __m256 unskew2 = _mm256_set1_ps(2.0f * SIMPLEX_UNSKEW);
+
+        UINT uNumBatched = uCount & ~7u;
+        for (UINT uSampleIdx = 0u; uSampleIdx < uNumBatched; uSampleIdx += 8u)
+        {
+            __m256 x = _mm256_loadu_ps(pX + uSampleIdx);
+            __m256 y = _mm256_loadu_ps(pY + uSampleIdx);
+
+            __m256 skew = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(SIMPLEX_SKEW));
+            __m256 i = _mm256_floor_ps(_mm256_add_ps(x, skew));
+            __m256 j = _mm256_floor_ps(_mm256_add_ps(y, skew));
+            __m256 cellUnskew = _mm256_mul_ps(_mm256_add_ps(i, j), unskew);
+            __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(i, cellUnskew));
+            __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(j, cellUnskew));
+
+            __m256 i1 = _mm256_and_ps(_mm256_cmp_ps(x0, y0, _CMP_GT_OQ), one);
+            __m256 j1 = _mm256_sub_ps(one, i1);
+
+            __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, i1), unskew);
+            __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, j1), unskew);
+            __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, one), unskew2);
+            __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, one), unskew2);
+
+            __m256i ii = _mm256_cvttps_epi32(i);
+            __m256i jj = _mm256_cvttps_epi32(j);
+            __m256i ii1 = _mm256_cvttps_epi32(i1);
+            __m256i jj1 = _mm256_cvttps_epi32(j1);
+
+            __m256i h0 = _mm256_srli_epi32(hashLatticeAvx2(ii, jj, latticeSeed), GRADIENT_SHIFT);
+            __m256i h1 = _mm256_srli_epi32(hashLatticeAvx2(_mm256_add_epi32(ii, ii1), _mm256_add_epi32(jj, jj1), latticeSeed), GRADIENT_SHIFT);
+            __m256i h2 = _mm256_srli_epi32(hashLatticeAvx2(_mm256_add_epi32(ii, oneI), _mm256_add_epi32(jj, oneI), latticeSeed), GRADIENT_SHIFT);
+
+            __m256 t0 = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0)), zero);
+            __m256 t1 = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1)), zero);
+            __m256 t2 = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x2, x2)), _mm256_mul_ps(y2, y2)), zero);
+            t0 = _mm256_mul_ps(t0, t0);
+            t1 = _mm256_mul_ps(t1, t1);
+            t2 = _mm256_mul_ps(t2, t2);
+
+            __m256 n0 = _mm256_mul_ps(_mm256_mul_ps(t0, t0), _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h0, 4), x0), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h0, 4), y0)));
+            __m256 n1 = _mm256_mul_ps(_mm256_mul_ps(t1, t1), _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h1, 4), x1), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h1, 4), y1)));
+            __m256 n2 = _mm256_mul_ps(_mm256_mul_ps(t2, t2), _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_X, h2, 4), x2), _mm256_mul_ps(_mm256_i32gather_ps(GRADIENTS_Y, h2, 4), y2)));
+
+            __m256 value = _mm256_add_ps(_mm256_add_ps(n0, n1), n2);
+            _mm256_storeu_ps(pOut + uSampleIdx, _mm256_mul_ps(value, _mm256_set1_ps(SIMPLEX_SCALE)));
+        }
+
+        return uNumBatched;
+    }
+}
@@ -0,0 +1,138 @@
+/*+===================================================================
+  File:      NOISE.H
+
+  Summary:   Noise header file contains declarations of the Noise class
+             that evaluates seedable 2D value, gradient and simplex
+             noise for terrain generation.
+
+  Classes: Noise
+
+  Functions: IsAvx2Supported
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    BOOL IsAvx2Supported();
+
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eNoiseType
+
+        Summary:  Enumeration of noise algorithms
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eNoiseType : BYTE
+    {
+        LEGACY_VALUE,
+        PERLIN,
+        SIMPLEX,
+        COUNT,
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    Noise
+
+      Summary:  Seedable 2D noise field.
+
+                LEGACY_VALUE is the value noise of Scene::GetPerlin2d,
+                which has a fixed hash table, so the seed only moves the
+                sample points by a whole number of lattice cells.
+                PERLIN (gradient noise) and SIMPLEX (classic 2D simplex
+                noise on a skewed triangular lattice) pick the gradient
+                of a lattice corner by an integer hash of its full
+                32-bit coordinates mixed with the hashed seed. There is
+                no table to wrap around, so the field does not repeat,
+                and different seeds give different fields and not
+                shifted copies of one field.
+
+                Optionally the sample points are displaced by the noise
+                itself (domain warping) before evaluation.
+
+                Every algorithm has an AVX2 batch path that returns the
+                same values as the scalar path.
+
+      Methods:  GetFractal2d
+                  Returns the octave sum at a point in [0, 1]
+                GetFractal2dBatch
+                  Returns the octave sums of many points in [0, 1]
+                GetSeed
+                  Returns the seed
+                GetType
+                  Returns the noise algorithm
+                SetDomainWarp
+                  Sets the strength and scale of the domain warp
+                Noise
+                  Constructor.
+                ~Noise
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class Noise
+    {
+    public:
+        Noise() = delete;
+        Noise(_In_ eNoiseType type, _In_ UINT uSeed);
+        Noise(const Noise& other) = default;
+        Noise(Noise&& other) = default;
+        Noise& operator=(const Noise& other) = default;
+        Noise& operator=(Noise&& other) = default;
+        ~Noise() = default;
+
+        FLOAT GetFractal2d(_In_ FLOAT x, _In_ FLOAT y, _In_ FLOAT frequency, _In_ UINT uDepth) const;
+        void GetFractal2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const;
+
+        UINT GetSeed() const;
+        eNoiseType GetType() const;
+
+        void SetDomainWarp(_In_ FLOAT amplitude, _In_ FLOAT frequency);
+
+    private:
+        static constexpr const UINT BATCH_SIZE = 256u;
+        static constexpr const UINT NUM_GRADIENTS = 16u;
+
+        // Unit vectors at (k + 0.5) * 22.5 degrees, so no gradient is axis aligned
+        static constexpr const FLOAT GRADIENTS_X[NUM_GRADIENTS] =
+        {
+            0.98078528f, 0.83146961f, 0.55557023f, 0.19509032f, -0.19509032f, -0.55557023f, -0.83146961f, -0.98078528f,
+            -0.98078528f, -0.83146961f, -0.55557023f, -0.19509032f, 0.19509032f, 0.55557023f, 0.83146961f, 0.98078528f,
+        };
+        static constexpr const FLOAT GRADIENTS_Y[NUM_GRADIENTS] =
+        {
+            0.19509032f, 0.55557023f, 0.83146961f, 0.98078528f, 0.98078528f, 0.83146961f, 0.55557023f, 0.19509032f,
+            -0.19509032f, -0.55557023f, -0.83146961f, -0.98078528f, -0.98078528f, -0.83146961f, -0.55557023f, -0.19509032f,
+        };
+
+        static constexpr const FLOAT PERLIN_SCALE = 1.41421356f;
+        static constexpr const FLOAT SIMPLEX_SKEW = 0.36602540f;
+        static constexpr const FLOAT SIMPLEX_UNSKEW = 0.21132487f;
+        static constexpr const FLOAT SIMPLEX_SCALE = 99.2043f;
+
+        // Sample point offsets of the two warp fields, keeps them uncorrelated with the field itself
+        static constexpr const FLOAT WARP_OFFSET_X[2] = { 31.416f, 113.5f };
+        static constexpr const FLOAT WARP_OFFSET_Y[2] = { 47.853f, 71.25f };
+
+        // The top 4 bits of a lattice hash index the 16 gradients
+        static constexpr const INT GRADIENT_SHIFT = 28;
+
+        static UINT hash(_In_ UINT uSeed);
+
+        void getNoise2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const;
+        void getGradientFractal2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const;
+
+        FLOAT getPerlin2d(_In_ FLOAT x, _In_ FLOAT y) const;
+        FLOAT getSimplex2d(_In_ FLOAT x, _In_ FLOAT y) const;
+        UINT getPerlin2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const;
+        UINT getSimplex2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount) const;
+
+    private:
+        eNoiseType m_type;
+        UINT m_uSeed;
+        FLOAT m_offsetX;
+        FLOAT m_offsetY;
+        FLOAT m_warpAmplitude;
+        FLOAT m_warpFrequency;
+        UINT m_uLatticeSeed;
+    };
+}
@@ -1,9 +1,38 @@
 #include "Scene/Scene.h"
 
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+#include "Scene/Noise.h"
 #include "Shader/SkyMapVertexShader.h"
 
 namespace library
 {
+    namespace
+    {
+        /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+          Function: smoothLerpSse / smoothLerpAvx2
+
+          Summary:  Vector versions of Scene::smoothLerp. The operations
+                    are done in the same order as the scalar version so
+                    the results are bit-identical.
+        -----------------------------------------------------------------F-F*/
+        inline __m128 smoothLerpSse(__m128 x, __m128 y, __m128 s)
+        {
+            __m128 weight = _mm_mul_ps(_mm_mul_ps(s, s), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), s)));
+
+            return _mm_add_ps(x, _mm_mul_ps(weight, _mm_sub_ps(y, x)));
+        }
+
+        inline __m256 smoothLerpAvx2(__m256 x, __m256 y, __m256 s)
+        {
+            __m256 weight = _mm256_mul_ps(_mm256_mul_ps(s, s), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_set1_ps(2.0f), s)));
+
+            return _mm256_add_ps(x, _mm256_mul_ps(weight, _mm256_sub_ps(y, x)));
+        }
+    }
+
     FLOAT Scene::GetPerlin2d(FLOAT x, FLOAT y, FLOAT frequency, UINT uDepth)
     {
         FLOAT xa = x * frequency;
@@ -24,158 +53,197 @@ namespace library
         return fin / div;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetPerlin2dBatch
+
+      Summary:  Evaluates GetPerlin2d for uCount sample points at once.
+                Uses AVX2 (8 samples per iteration, hashing with
+                gathers) when the CPU and OS support it, otherwise SSE2
+                (4 samples per iteration), and the scalar GetPerlin2d for
+                the remainder. Every path returns exactly the same
+                values as GetPerlin2d. Sample coordinates times
+                frequency * 2^(uDepth - 1) must stay below 2^31.
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+                FLOAT* pOut
+                  Noise values of the sample points
+                UINT uCount
+                  Number of sample points
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::GetPerlin2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount)
+    {
+        UINT uNumDone = 0u;
+        if (IsAvx2Supported())
+        {
+            uNumDone = getPerlin2dBatchAvx2(pX, pY, frequency, uDepth, pOut, uCount);
+        }
+        uNumDone += getPerlin2dBatchSse(pX + uNumDone, pY + uNumDone, frequency, uDepth, pOut + uNumDone, uCount - uNumDone);
+
+        for (UINT i = uNumDone; i < uCount; ++i)
+        {
+            pOut[i] = GetPerlin2d(pX[i], pY[i], frequency, uDepth);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Scene
+
+      Summary:  Constructor that builds the voxels from a height map
+                file. The map is empty if the file cannot be read.
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the height map file
+
+      Modifies: [m_filePath, m_hrTerrain, m_voxels, m_voxelGrid,
+                 m_voxelLight, m_blockVoxel, m_aBlockColors,
+                 m_voxelOrigin, m_renderableTree, m_aRenderableProxies].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     Scene::Scene(const std::filesystem::path& filePath)
         : m_filePath(filePath)
+        , m_hrTerrain(S_OK)
         , m_voxels()
         , m_renderables()
         , m_aPointLights{ nullptr }
         , m_vertexShaders()
         , m_pixelShaders()
         , m_skyBox()
+        , m_voxelWorld()
+        , m_voxelGrid()
+        , m_voxelLight()
+        , m_regionStore()
+        , m_blockVoxel()
+        , m_aBlockColors()
+        , m_voxelOrigin()
+        , m_aBlockEdits()
+        , m_aEditedCells()
+        , m_aLightCells()
+        , m_aLitCells()
+        , m_uploadRing()
+        , m_device()
+        , m_immediateContext()
+        , m_pGeometryRegistry(nullptr)
+        , m_paletteBuffer()
+        , m_renderableTree()
+        , m_aRenderableProxies()
     {
-        std::ifstream inputFile;
-        inputFile.open(m_filePath.string());
-
-        std::string trash;
-        UINT aDimension[4] = { 0u, };
-        UINT uDimensionIdx = 0u;
-        while (!inputFile.eof() && uDimensionIdx < ARRAYSIZE(aDimension))
+        // A missing or corrupt file leaves an empty map, Initialize reports the failure
+        TerrainData terrain;
+        m_hrTerrain = ReadTerrainData(m_filePath, terrain);
+        if (FAILED(m_hrTerrain))
         {
-            inputFile >> aDimension[uDimensionIdx];
-
-            if (inputFile.fail())
-            {
-                if (inputFile.eof())
-                {
-                    break;
-                }
-                inputFile.clear();
-                inputFile >> trash;
-            }
-            else
-            {
-                ++uDimensionIdx;
-            }
-        }
-
-        UINT uColorIdx = 0u;
-        XMFLOAT4 color;
-        while (!inputFile.eof() && uColorIdx < aDimension[3])
-        {
-            inputFile >> color.x >> color.y >> color.z;
-
-            if (inputFile.fail())
-            {
-                if (inputFile.eof())
-                {
-                    break;
-                }
-                inputFile.clear();
-                inputFile >> trash;
-            }
-            else
-            {
-                color.w = 1.0f;
-                m_voxels.push_back(std::make_shared<Voxel>(color));
-                ++uColorIdx;
-            }
+            WCHAR szMessage[512];
+            swprintf_s(szMessage, L"Scene::Scene: ReadTerrainData of %s failed with 0x%08X\n", m_filePath.c_str(), static_cast<UINT>(m_hrTerrain));
+            OutputDebugString(szMessage);
         }
 
-        std::vector<std::vector<InstanceData>> aInstanceData;
-        aInstanceData.reserve(m_voxels.size());
-        for (UINT renderableIdx = 0u; renderableIdx < m_voxels.size(); ++renderableIdx)
-        {
-            aInstanceData.push_back(std::vector<InstanceData>());
-            aInstanceData.back().reserve(
-                static_cast<size_t>(aDimension[0]) * static_cast<size_t>(aDimension[1]) * static_cast<size_t>(aDimension[2])
-            );
-        }
-
-        UINT uDepthIdx = 0u;
-        UINT uWidthIdx = 0u;
-        CHAR voxelType;
-        FLOAT height;
-        while (!inputFile.eof())
-        {
-            inputFile >> voxelType >> height;
+        createVoxels(terrain);
+    }
 
-            if (inputFile.fail())
-            {
-                if (inputFile.eof())
-                {
-                    break;
-                }
-                inputFile.clear();
-                inputFile >> trash;
-            }
-            else if (static_cast<CHAR>(eBlockType::GRASSLAND) <= voxelType && voxelType < static_cast<CHAR>(eBlockType::COUNT))
-            {
-                for (UINT heightIdx = 0; heightIdx < static_cast<UINT>(static_cast<float>(aDimension[1]) * height); ++heightIdx)
-                {
-                    aInstanceData[static_cast<size_t>(voxelType) - static_cast<size_t>(eBlockType::GRASSLAND)].push_back(
-                        InstanceData
-                        {
-                            .Transformation = XMMatrixTranslation(
-                                2.0f * (static_cast<FLOAT>(uWidthIdx) - static_cast<FLOAT>(aDimension[0]) / 2.0f),
-                                2.0f * (static_cast<FLOAT>(heightIdx) - static_cast<FLOAT>(aDimension[1])) + (static_cast<FLOAT>(aDimension[1]) * 0.75f),
-                                2.0f * (static_cast<FLOAT>(uDepthIdx) - static_cast<FLOAT>(aDimension[2]) / 2.0f)
-                                )
-                        }
-                    );
-                }
-                ++uWidthIdx;
-                if (uWidthIdx >= aDimension[0])
-                {
-                    uWidthIdx -= aDimension[0];
-                    ++uDepthIdx;
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Scene
 
-                    if (uDepthIdx >= aDimension[2])
-                    {
-                        uDepthIdx -= aDimension[2];
-                    }
-                }
-            }
-        }
+      Summary:  Constructor that builds the voxels directly from a
+                generated terrain grid, without a height map file
 
-        inputFile.close();
+      Args:     const TerrainData& terrain
+                  Height and biome grid of the map
 
-        UINT uVoxelIdx = 0u;
-        auto it = m_voxels.begin();
-        while (it != m_voxels.end())
-        {
-            if (aInstanceData[uVoxelIdx].size() <= 0)
-            {
-                it = m_voxels.erase(it);
-            }
-            else
-            {
-                (*it)->SetInstanceData(std::move(aInstanceData[uVoxelIdx]));
-                ++it;
-            }
-            ++uVoxelIdx;
-        }
+      Modifies: [m_filePath, m_hrTerrain, m_voxels, m_voxelGrid,
+                 m_voxelLight, m_blockVoxel, m_aBlockColors,
+                 m_voxelOrigin, m_renderableTree, m_aRenderableProxies].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Scene::Scene(_In_ const TerrainData& terrain)
+        : m_filePath()
+        , m_hrTerrain(S_OK)
+        , m_voxels()
+        , m_renderables()
+        , m_aPointLights{ nullptr }
+        , m_vertexShaders()
+        , m_pixelShaders()
+        , m_skyBox()
+        , m_voxelWorld()
+        , m_voxelGrid()
+        , m_voxelLight()
+        , m_regionStore()
+        , m_blockVoxel()
+        , m_aBlockColors()
+        , m_voxelOrigin()
+        , m_aBlockEdits()
+        , m_aEditedCells()
+        , m_aLightCells()
+        , m_aLitCells()
+        , m_uploadRing()
+        , m_device()
+        , m_immediateContext()
+        , m_pGeometryRegistry(nullptr)
+        , m_paletteBuffer()
+        , m_renderableTree()
+        , m_aRenderableProxies()
+    {
+        createVoxels(terrain);
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Scene::Initialize
 
       Summary:  Initializes the voxels, shaders, renderables, models,
-                and skybox
+                and skybox, creates the palette of the block colors and
+                keeps the device and the geometry registry to upload
+                block edits. The renderables are put into the renderable
+                tree once their bounds are known. Models are left out, since skinning moves their
+                vertices out of their bounds. Fails without touching the
+                device if the height map file of the scene could not be
+                read.
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
+                GeometryRegistry* pGeometryRegistry
+                  Buffers shared by the renderables with the same
+                  geometry, may be nullptr
+
+      Modifies: [m_uploadRing, m_device, m_immediateContext,
+                 m_pGeometryRegistry,
+                 m_paletteBuffer, m_renderableTree, m_aRenderableProxies].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Scene::Initialize definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    HRESULT Scene::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    HRESULT Scene::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry)
     {
+        m_device = pDevice;
+        m_immediateContext = pImmediateContext;
+        m_pGeometryRegistry = pGeometryRegistry;
+
+        if (FAILED(m_hrTerrain))
+        {
+            return m_hrTerrain;
+        }
+
+        HRESULT hr = m_uploadRing.Initialize(pDevice);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = Voxel::CreatePaletteBuffer(pDevice, m_aBlockColors, m_paletteBuffer);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
         for (auto voxel : m_voxels)
         {
-            HRESULT hr = voxel->Initialize(pDevice, pImmediateContext);
+            HRESULT hr = voxel->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
             if (FAILED(hr))
             {
                 return hr;
@@ -200,18 +268,15 @@ namespace library
             }
         }
 
-        for (auto it = m_renderables.begin(); it != m_renderables.end(); ++it)
+        hr = InitializeRenderables(pDevice, pImmediateContext, pGeometryRegistry);
+        if (FAILED(hr))
         {
-            HRESULT hr = it->second->Initialize(pDevice, pImmediateContext);
-            if (FAILED(hr))
-            {
-                return hr;
-            }
+            return hr;
         }
 
         for (auto it = m_models.begin(); it != m_models.end(); ++it)
         {
-            HRESULT hr = it->second->Initialize(pDevice, pImmediateContext);
+            HRESULT hr = it->second->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
             if (FAILED(hr))
             {
                 return hr;
@@ -234,11 +299,60 @@ namespace library
 
         if (m_skyBox != nullptr)
         {
-            HRESULT hr = m_skyBox->Initialize(pDevice, pImmediateContext);
+            HRESULT hr = m_skyBox->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        if (m_voxelWorld)
+        {
+            HRESULT hr = m_voxelWorld->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        // The leaves were inserted one by one, a build over all of them gives a better tree
+        m_renderableTree.Rebuild();
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::InitializeRenderables
+
+      Summary:  Initializes the renderables and puts them in the
+                renderable tree once their bounds are known. Initialize
+                calls it with the device, a headless renderer without
+                one, for renderables that were given their buffers.
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers, may be
+                  nullptr
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers, may be nullptr
+                GeometryRegistry* pGeometryRegistry
+                  Buffers shared by the renderables with the same
+                  geometry, may be nullptr
+
+      Modifies: [m_renderableTree, m_aRenderableProxies].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::InitializeRenderables(_In_opt_ ID3D11Device* pDevice, _In_opt_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry)
+    {
+        for (auto it = m_renderables.begin(); it != m_renderables.end(); ++it)
+        {
+            HRESULT hr = it->second->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
             if (FAILED(hr))
             {
                 return hr;
             }
+            addRenderableProxy(*it->second);
         }
 
         return S_OK;
@@ -396,59 +510,540 @@ namespace library
             return E_FAIL;
         }
 
-        m_pixelShaders[pszPixelShaderName] = pixelShader;
+        m_pixelShaders[pszPixelShaderName] = pixelShader;
+
+        return S_OK;
+    }
+
+    HRESULT Scene::AddMaterial(_In_ const std::shared_ptr<Material>& material)
+    {
+        if (m_materials.contains(material->GetName()))
+        {
+            return E_FAIL;
+        }
+
+        m_materials[material->GetName()] = material;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::AddSkyBox
+
+      Summary:  Add the skybox
+
+      Args:     const std::shared_ptr<Skybox>&
+                  Skybox to use
+
+      Modifies: [m_skyBox].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    /*--------------------------------------------------------------------
+      TODO: Scene::AddSkyBox definition (remove the comment)
+    --------------------------------------------------------------------*/
+
+    HRESULT Scene::AddSkyBox(_In_ const std::shared_ptr<Skybox>& skybox)
+    {
+        if (!skybox)
+        {
+            return E_INVALIDARG;
+        }
+        m_skyBox = skybox;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SetVoxelWorld
+
+      Summary:  Sets the streaming voxel terrain drawn in addition to
+                the voxels of the scene. The voxel shaders and material
+                of the scene apply to it as well.
+
+      Args:     const std::shared_ptr<VoxelWorld>& voxelWorld
+                  Streaming voxel terrain
+
+      Modifies: [m_voxelWorld].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SetVoxelWorld(_In_ const std::shared_ptr<VoxelWorld>& voxelWorld)
+    {
+        if (!voxelWorld)
+        {
+            return E_INVALIDARG;
+        }
+        m_voxelWorld = voxelWorld;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SetBlock
+
+      Summary:  Sets the block of a cell of the voxel grid. The grid is
+                updated at once, the voxels at the next FlushBlockEdits
+                together with the other edits of the frame.
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+                eBlockType blockType
+                  Block type, AIR to remove the block
+
+      Modifies: [m_voxelGrid, m_aBlockEdits].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG outside of the grid or for a
+                  block type without a color
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SetBlock(_In_ INT x, _In_ INT y, _In_ INT z, _In_ eBlockType blockType)
+    {
+        if (!isValidBlockType(blockType))
+        {
+            return E_INVALIDARG;
+        }
+
+        eBlockType previousBlockType = m_voxelGrid.GetBlock(x, y, z);
+        HRESULT hr = m_voxelGrid.SetBlock(x, y, z, blockType);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (previousBlockType != blockType)
+        {
+            m_aBlockEdits.push_back(
+                BlockEdit
+                {
+                    .x = x,
+                    .y = y,
+                    .z = z
+                }
+            );
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::RemoveBlock
+
+      Summary:  Clears a cell of the voxel grid to air
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Modifies: [m_voxelGrid, m_aBlockEdits].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG outside of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::RemoveBlock(_In_ INT x, _In_ INT y, _In_ INT z)
+    {
+        return SetBlock(x, y, z, eBlockType::AIR);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::FillRegion
+
+      Summary:  Sets every cell of a box of the voxel grid to a block,
+                the box is clipped to the grid
+
+      Args:     INT minX
+                  First cell along the x-axis
+                INT minY
+                  First cell along the y-axis
+                INT minZ
+                  First cell along the z-axis
+                INT maxX
+                  Last cell along the x-axis, inclusive
+                INT maxY
+                  Last cell along the y-axis, inclusive
+                INT maxZ
+                  Last cell along the z-axis, inclusive
+                eBlockType blockType
+                  Block type, AIR to dig the box out
+
+      Modifies: [m_voxelGrid, m_aBlockEdits].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::FillRegion(_In_ INT minX, _In_ INT minY, _In_ INT minZ, _In_ INT maxX, _In_ INT maxY, _In_ INT maxZ, _In_ eBlockType blockType)
+    {
+        if (!isValidBlockType(blockType) || minX > maxX || minY > maxY || minZ > maxZ)
+        {
+            return E_INVALIDARG;
+        }
+
+        minX = minX > 0 ? minX : 0;
+        minY = minY > 0 ? minY : 0;
+        minZ = minZ > 0 ? minZ : 0;
+        maxX = maxX < static_cast<INT>(m_voxelGrid.GetWidth()) ? maxX : static_cast<INT>(m_voxelGrid.GetWidth()) - 1;
+        maxY = maxY < static_cast<INT>(m_voxelGrid.GetHeight()) ? maxY : static_cast<INT>(m_voxelGrid.GetHeight()) - 1;
+        maxZ = maxZ < static_cast<INT>(m_voxelGrid.GetDepth()) ? maxZ : static_cast<INT>(m_voxelGrid.GetDepth()) - 1;
+
+        for (INT z = minZ; z <= maxZ; ++z)
+        {
+            for (INT y = minY; y <= maxY; ++y)
+            {
+                for (INT x = minX; x <= maxX; ++x)
+                {
+                    HRESULT hr = SetBlock(x, y, z, blockType);
+                    if (FAILED(hr))
+                    {
+                        return hr;
+                    }
+                }
+            }
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::FlushBlockEdits
+
+      Summary:  Applies the block edits since the last flush to the
+                voxels and uploads the changed instances. The light is
+                relit around the edits first. Only the edited cells, the
+                26 cells around them and the face neighbours of the
+                cells whose light changed are looked at, whatever the
+                size of the map, since an edit changes the faces of its
+                neighbours and the ambient occlusion of the blocks
+                around it, and a change of light the faces looking at
+                it. Blocks of every type are instances of the one voxel
+                of the map, so a replaced block is updated in place.
+                Every voxel copies its dirty instance ranges through
+                the upload ring. Called by Update once per frame.
+
+      Modifies: [m_voxels, m_voxelLight, m_blockVoxel, m_aBlockEdits,
+                 m_aEditedCells, m_aLightCells, m_aLitCells].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::FlushBlockEdits()
+    {
+        if (m_aBlockEdits.empty())
+        {
+            return S_OK;
+        }
+
+        m_aLightCells.clear();
+        for (const BlockEdit& edit : m_aBlockEdits)
+        {
+            m_aLightCells.push_back(XMINT3(edit.x, edit.y, edit.z));
+        }
+        m_aLitCells.clear();
+        m_voxelLight.UpdateBlocks(m_aLightCells.data(), static_cast<UINT>(m_aLightCells.size()), m_aLitCells);
+
+        auto addEditedCell = [this](INT x, INT y, INT z)
+        {
+            if (m_voxelGrid.IsInside(x, y, z))
+            {
+                m_aEditedCells.push_back((static_cast<UINT64>(z) << 42u) | (static_cast<UINT64>(y) << 21u) | static_cast<UINT64>(x));
+            }
+        };
+
+        // An edit covers or uncovers the faces of its face neighbours and shades the corners of every block around it, every touched cell is refreshed once
+        m_aEditedCells.clear();
+        for (const BlockEdit& edit : m_aBlockEdits)
+        {
+            for (INT z = edit.z - 1; z <= edit.z + 1; ++z)
+            {
+                for (INT y = edit.y - 1; y <= edit.y + 1; ++y)
+                {
+                    for (INT x = edit.x - 1; x <= edit.x + 1; ++x)
+                    {
+                        addEditedCell(x, y, z);
+                    }
+                }
+            }
+        }
+
+        // A face takes the light of the cell in front of it
+        for (const XMINT3& cell : m_aLitCells)
+        {
+            addEditedCell(cell.x, cell.y + 1, cell.z);
+            addEditedCell(cell.x, cell.y - 1, cell.z);
+            addEditedCell(cell.x - 1, cell.y, cell.z);
+            addEditedCell(cell.x + 1, cell.y, cell.z);
+            addEditedCell(cell.x, cell.y, cell.z - 1);
+            addEditedCell(cell.x, cell.y, cell.z + 1);
+        }
+        std::sort(m_aEditedCells.begin(), m_aEditedCells.end());
+        m_aEditedCells.erase(std::unique(m_aEditedCells.begin(), m_aEditedCells.end()), m_aEditedCells.end());
+        m_aBlockEdits.clear();
+
+        constexpr const UINT64 CELL_MASK = (1ull << 21u) - 1ull;
+        for (UINT64 uCellKey : m_aEditedCells)
+        {
+            INT x = static_cast<INT>(uCellKey & CELL_MASK);
+            INT y = static_cast<INT>((uCellKey >> 21u) & CELL_MASK);
+            INT z = static_cast<INT>(uCellKey >> 42u);
+            eBlockType blockType = m_voxelGrid.GetBlock(x, y, z);
+            UINT uNeighbourMask = m_voxelGrid.GetNeighbourMask(x, y, z);
+            BYTE faceMask = blockType == eBlockType::AIR || !isValidBlockType(blockType) ? 0u : Voxel::GetFaceMask(uNeighbourMask);
+            if (faceMask == 0u)
+            {
+                m_blockVoxel->RemoveInstance(static_cast<INT16>(x), static_cast<INT16>(y), static_cast<INT16>(z));
+            }
+            else
+            {
+                VoxelInstanceData instance =
+                {
+                    .X = static_cast<INT16>(x),
+                    .Y = static_cast<INT16>(y),
+                    .Z = static_cast<INT16>(z),
+                    .BlockType = static_cast<BYTE>(blockType),
+                    .FaceMask = faceMask
+                };
+                Voxel::BakeAmbientOcclusion(uNeighbourMask, instance);
+                m_voxelLight.BakeFaceLight(instance);
+                m_blockVoxel->SetInstance(instance);
+            }
+        }
+
+        return uploadVoxels();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SetBlockEmission
+
+      Summary:  Sets the block light level that the blocks of a type
+                emit. The whole map is relit and the light of every
+                instance baked again, so emissions are meant to be set
+                when the map is loaded rather than every frame.
+
+      Args:     eBlockType blockType
+                  Solid block type with a color
+                BYTE level
+                  Level from 0 to VoxelLight::MAX_LEVEL, 0 for no light
+                ThreadPool* pThreadPool
+                  Pool to relight the chunks on, the chunks are relit on
+                  the calling thread if nullptr
+
+      Modifies: [m_voxels, m_voxelLight].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for air, a block type
+                  without a color or a level above VoxelLight::MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SetBlockEmission(_In_ eBlockType blockType, _In_ BYTE level, _In_opt_ ThreadPool* pThreadPool)
+    {
+        if (!isValidBlockType(blockType))
+        {
+            return E_INVALIDARG;
+        }
+
+        if (m_voxelLight.GetEmission(blockType) == level)
+        {
+            return S_OK;
+        }
+
+        HRESULT hr = m_voxelLight.SetEmission(blockType, level);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_voxelLight.Initialize(m_voxelGrid, pThreadPool);
+
+        // Only the instances whose light changed are marked dirty
+        for (std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            for (UINT uInstanceIdx = 0u; uInstanceIdx < voxel->GetNumInstances(); ++uInstanceIdx)
+            {
+                VoxelInstanceData instance = voxel->GetInstance(uInstanceIdx);
+                if (instance.FaceMask != 0u)
+                {
+                    m_voxelLight.BakeFaceLight(instance);
+                    voxel->SetInstance(instance);
+                }
+            }
+        }
+
+        return uploadVoxels();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SaveBlocks
+
+      Summary:  Saves the chunks of the voxel grid edited since their
+                last save into the region files of a directory. The
+                chunks are copied and written on the save thread of the
+                region store, so the call returns without waiting for
+                the disk.
+
+      Args:     const std::filesystem::path& directoryPath
+                  Directory of the region files, created if it does not
+                  exist
+
+      Modifies: [m_voxelGrid, m_regionStore].
+
+      Returns:  HRESULT
+                  Status code, the result of the writes is returned by
+                  WaitForBlockSaves
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::SaveBlocks(_In_ const std::filesystem::path& directoryPath)
+    {
+        HRESULT hr = openRegionStore(directoryPath);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        std::vector<XMUINT3> aDirtyChunks;
+        m_voxelGrid.GetDirtyChunks(aDirtyChunks);
+
+        std::vector<VoxelChunkBlocks> aChunks(aDirtyChunks.size());
+        for (size_t i = 0u; i < aDirtyChunks.size(); ++i)
+        {
+            aChunks[i].Chunk = aDirtyChunks[i];
+            aChunks[i].Blocks.resize(VoxelGrid::NUM_CHUNK_CELLS);
+            m_voxelGrid.ReadChunk(aDirtyChunks[i], aChunks[i].Blocks.data());
+        }
+
+        hr = m_regionStore.SaveAsync(std::move(aChunks));
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        for (const XMUINT3& chunk : aDirtyChunks)
+        {
+            m_voxelGrid.ClearDirtyChunk(chunk);
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::LoadBlocks
+
+      Summary:  Replaces the chunks of the voxel grid that are saved in
+                the region files of a directory. Only the cells that
+                differ from the grid are edited, so the voxels and the
+                light are updated at the next FlushBlockEdits like any
+                other edits.
+
+      Args:     const std::filesystem::path& directoryPath
+                  Directory of the region files
+
+      Modifies: [m_voxelGrid, m_aBlockEdits, m_regionStore].
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if a region file is damaged or
+                  E_INVALIDARG if it holds a block type without a color
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::LoadBlocks(_In_ const std::filesystem::path& directoryPath)
+    {
+        HRESULT hr = openRegionStore(directoryPath);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        // Saves still queued would otherwise be read back without their chunks
+        hr = m_regionStore.WaitForSaves();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        std::vector<XMUINT3> aStoredChunks;
+        hr = m_regionStore.GetStoredChunks(aStoredChunks);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        std::vector<eBlockType> aBlocks(VoxelGrid::NUM_CHUNK_CELLS);
+        for (const XMUINT3& chunk : aStoredChunks)
+        {
+            BOOL bFound = FALSE;
+            hr = m_regionStore.ReadChunk(chunk, aBlocks.data(), bFound);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (!bFound)
+            {
+                continue;
+            }
 
-        return S_OK;
-    }
+            UINT uCellIdx = 0u;
+            for (UINT y = 0u; y < VoxelGrid::CHUNK_SIZE; ++y)
+            {
+                for (UINT z = 0u; z < VoxelGrid::CHUNK_SIZE; ++z)
+                {
+                    for (UINT x = 0u; x < VoxelGrid::CHUNK_SIZE; ++x, ++uCellIdx)
+                    {
+                        INT cellX = static_cast<INT>(chunk.x * VoxelGrid::CHUNK_SIZE + x);
+                        INT cellY = static_cast<INT>(chunk.y * VoxelGrid::CHUNK_SIZE + y);
+                        INT cellZ = static_cast<INT>(chunk.z * VoxelGrid::CHUNK_SIZE + z);
+                        if (!m_voxelGrid.IsInside(cellX, cellY, cellZ) || m_voxelGrid.GetBlock(cellX, cellY, cellZ) == aBlocks[uCellIdx])
+                        {
+                            continue;
+                        }
 
-    HRESULT Scene::AddMaterial(_In_ const std::shared_ptr<Material>& material)
-    {
-        if (m_materials.contains(material->GetName()))
-        {
-            return E_FAIL;
-        }
+                        hr = SetBlock(cellX, cellY, cellZ, aBlocks[uCellIdx]);
+                        if (FAILED(hr))
+                        {
+                            return hr;
+                        }
+                    }
+                }
+            }
 
-        m_materials[material->GetName()] = material;
+            // The chunk matches its save again
+            m_voxelGrid.ClearDirtyChunk(chunk);
+        }
 
         return S_OK;
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
-      Method:   Scene::AddSkyBox
+      Method:   Scene::WaitForBlockSaves
 
-      Summary:  Add the skybox
-
-      Args:     const std::shared_ptr<Skybox>&
-                  Skybox to use
+      Summary:  Waits until the saves of SaveBlocks are written
 
-      Modifies: [m_skyBox].
+      Modifies: [m_regionStore].
 
       Returns:  HRESULT
-                  Status code
+                  First failure of the saves since the last wait
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
-    /*--------------------------------------------------------------------
-      TODO: Scene::AddSkyBox definition (remove the comment)
-    --------------------------------------------------------------------*/
-
-    HRESULT Scene::AddSkyBox(_In_ const std::shared_ptr<Skybox>& skybox)
+    HRESULT Scene::WaitForBlockSaves()
     {
-        if (!skybox)
-        {
-            return E_INVALIDARG;
-        }
-        m_skyBox = skybox;
-
-        return S_OK;
+        return m_regionStore.WaitForSaves();
     }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Scene::Update
 
       Summary:  Update the renderables, models, point lights, skybox
-                each frame
+                each frame, flushes the block edits of the frame and
+                refits the renderable tree to the renderables that moved.
+                A failed flush is written to the debugger output, since
+                the frame goes on without a status code.
 
       Args:     FLOAT deltaTime
                   Time difference of a frame
+
+      Modifies: [m_renderableTree, m_aRenderableProxies].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
     /*--------------------------------------------------------------------
       TODO: Scene::Update definition (remove the comment)
@@ -456,6 +1051,14 @@ namespace library
 
     void Scene::Update(_In_ FLOAT deltaTime)
     {
+        HRESULT hr = FlushBlockEdits();
+        if (FAILED(hr))
+        {
+            WCHAR szMessage[128];
+            swprintf_s(szMessage, L"Scene::Update: FlushBlockEdits failed with 0x%08X\n", static_cast<UINT>(hr));
+            OutputDebugString(szMessage);
+        }
+
         for (auto it = m_renderables.begin(); it != m_renderables.end(); ++it)
         {
             it->second->Update(deltaTime);
@@ -466,6 +1069,8 @@ namespace library
             it->second->Update(deltaTime);
         }
 
+        updateRenderableTree();
+
         for (UINT lightIdx = 0; lightIdx < NUM_LIGHTS; ++lightIdx)
         {
             m_aPointLights[lightIdx]->Update(deltaTime);
@@ -490,6 +1095,20 @@ namespace library
         return m_voxels;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetPaletteBuffer
+
+      Summary:  Returns the constant buffer of the block colors of the
+                voxels, nullptr until initialized
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Constant buffer of the block colors
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& Scene::GetPaletteBuffer()
+    {
+        return m_paletteBuffer;
+    }
+
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Scene::GetRenderables
@@ -583,6 +1202,155 @@ namespace library
         return m_skyBox;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetVoxelWorld
+
+      Summary:  Returns the streaming voxel terrain
+
+      Returns:  std::shared_ptr<VoxelWorld>&
+                  Streaming voxel terrain, could be a nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::shared_ptr<VoxelWorld>& Scene::GetVoxelWorld()
+    {
+        return m_voxelWorld;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetVoxelGrid
+
+      Summary:  Returns the block storage of the map, which reflects
+                the block edits at once
+
+      Returns:  const VoxelGrid&
+                  Voxel grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const VoxelGrid& Scene::GetVoxelGrid() const
+    {
+        return m_voxelGrid;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetVoxelLight
+
+      Summary:  Returns the skylight and block light of the map, which
+                reflects the block edits at the next FlushBlockEdits
+
+      Returns:  const VoxelLight&
+                  Voxel light
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const VoxelLight& Scene::GetVoxelLight() const
+    {
+        return m_voxelLight;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::GetRenderableTree
+
+      Summary:  Returns the tree of the world space bounds of the
+                renderables, which the renderer culls with a frustum
+                query, and for light, picking and proximity queries. It
+                is refitted by Update, so the bounds are those of the
+                last Update.
+
+      Returns:  const DynamicAabbTree&
+                  Renderable tree
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const DynamicAabbTree& Scene::GetRenderableTree() const
+    {
+        return m_renderableTree;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::Raycast
+
+      Summary:  Finds the first block along a ray in world space, e.g.
+                the block under the cursor. The block next to the hit
+                face, to place a block on, is outHit.Cell + outHit.Normal.
+
+      Args:     const VoxelRay& ray
+                  Ray in world space
+                VoxelRayHit& outHit
+                  First hit, the distance is in world units
+
+      Returns:  BOOL
+                  TRUE if a block was hit
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Scene::Raycast(_In_ const VoxelRay& ray, _Out_ VoxelRayHit& outHit) const
+    {
+        BOOL bHit = m_voxelGrid.Raycast(getGridRay(ray), outHit);
+        outHit.Distance *= 2.0f;
+
+        return bHit;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::RaycastBatch
+
+      Summary:  Finds the first block along many rays in world space,
+                e.g. the line of sight checks of a frame
+
+      Args:     const VoxelRay* pRays
+                  Rays in world space
+                VoxelRayHit* pOutHits
+                  First hit of every ray, the distances are in world
+                  units
+                UINT uNumRays
+                  Number of rays
+                ThreadPool* pThreadPool
+                  Pool to cast the rays on, the rays are cast on the
+                  calling thread if nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::RaycastBatch(_In_reads_(uNumRays) const VoxelRay* pRays, _Out_writes_(uNumRays) VoxelRayHit* pOutHits, _In_ UINT uNumRays, _In_opt_ ThreadPool* pThreadPool) const
+    {
+        std::vector<VoxelRay> aGridRays(uNumRays);
+        for (UINT uRayIdx = 0u; uRayIdx < uNumRays; ++uRayIdx)
+        {
+            aGridRays[uRayIdx] = getGridRay(pRays[uRayIdx]);
+        }
+
+        m_voxelGrid.RaycastBatch(aGridRays.data(), pOutHits, uNumRays, pThreadPool);
+
+        for (UINT uRayIdx = 0u; uRayIdx < uNumRays; ++uRayIdx)
+        {
+            pOutHits[uRayIdx].Distance *= 2.0f;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::SweepBox
+
+      Summary:  Moves an axis-aligned box in world space until it
+                touches a block, see VoxelGrid::SweepBox
+
+      Args:     const XMFLOAT3& center
+                  Center of the box in world space
+                const XMFLOAT3& halfExtents
+                  Half of the size of the box
+                const XMFLOAT3& displacement
+                  Move to make
+                XMFLOAT3& outDisplacement
+                  Move made before touching the blocks
+
+      Returns:  BYTE
+                  Voxel::FACE_* bits of the faces of the box that were
+                  stopped by a block
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE Scene::SweepBox(_In_ const XMFLOAT3& center, _In_ const XMFLOAT3& halfExtents, _In_ const XMFLOAT3& displacement, _Out_ XMFLOAT3& outDisplacement) const
+    {
+        XMFLOAT3 gridCenter(
+            (center.x - m_voxelOrigin.x + 1.0f) * 0.5f,
+            (center.y - m_voxelOrigin.y + 1.0f) * 0.5f,
+            (center.z - m_voxelOrigin.z + 1.0f) * 0.5f
+        );
+        XMFLOAT3 gridHalfExtents(halfExtents.x * 0.5f, halfExtents.y * 0.5f, halfExtents.z * 0.5f);
+        XMFLOAT3 gridDisplacement(displacement.x * 0.5f, displacement.y * 0.5f, displacement.z * 0.5f);
+
+        BYTE contactMask = m_voxelGrid.SweepBox(gridCenter, gridHalfExtents, gridDisplacement, outDisplacement);
+        outDisplacement = XMFLOAT3(outDisplacement.x * 2.0f, outDisplacement.y * 2.0f, outDisplacement.z * 2.0f);
+
+        return contactMask;
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Scene::GetFilePath
 
@@ -727,7 +1495,7 @@ namespace library
                 PCWSTR pszVertexShaderName
                   Key of the vertex shader
 
-      Modifies: [m_scenes].
+      Modifies: [m_voxels].
 
       Returns:  HRESULT
                   Status code
@@ -744,6 +1512,11 @@ namespace library
             voxel->SetVertexShader(m_vertexShaders[pszVertexShaderName]);
         }
 
+        if (m_voxelWorld)
+        {
+            m_voxelWorld->SetVertexShader(m_vertexShaders[pszVertexShaderName]);
+        }
+
         return S_OK;
     }
 
@@ -757,7 +1530,7 @@ namespace library
                 PCWSTR pszPixelShaderName
                   Key of the pixel shader
 
-      Modifies: [m_renderables].
+      Modifies: [m_voxels].
 
       Returns:  HRESULT
                   Status code
@@ -774,6 +1547,11 @@ namespace library
             voxel->SetPixelShader(m_pixelShaders[pszPixelShaderName]);
         }
 
+        if (m_voxelWorld)
+        {
+            m_voxelWorld->SetPixelShader(m_pixelShaders[pszPixelShaderName]);
+        }
+
         return S_OK;
     }
 
@@ -789,9 +1567,383 @@ namespace library
             voxel->AddMaterial(m_materials[pszMaterialName]);
         }
 
+        if (m_voxelWorld)
+        {
+            m_voxelWorld->SetMaterial(m_materials[pszMaterialName]);
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::createVoxels
+
+      Summary:  Creates the voxel of the map and fills its packed
+                instance data from the height grid with the blocks of
+                every type, and fills the voxel grid that the block
+                edits work on. The colors of the terrain become the
+                palette that the shaders index with the block type.
+
+      Args:     const TerrainData& terrain
+                  Height and biome grid of the map
+
+      Modifies: [m_voxels, m_voxelGrid, m_voxelLight, m_blockVoxel,
+                 m_aBlockColors, m_voxelOrigin].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::createVoxels(_In_ const TerrainData& terrain)
+    {
+        // The faces, occlusion and light of the whole map are baked once, on every core
+        std::vector<VoxelInstanceData> aInstanceData;
+        m_voxelGrid.FillTerrain(terrain);
+        {
+            ThreadPool threadPool(ThreadPool::GetDefaultNumThreads());
+            Voxel::BuildInstanceData(terrain, 0u, 0u, terrain.uWidth, terrain.uDepth, aInstanceData, &threadPool);
+
+            // Nothing emits yet and all air of a height map is open to the sky, which is the light BuildInstanceData bakes
+            m_voxelLight.Initialize(m_voxelGrid, &threadPool);
+        }
+        m_aBlockColors = terrain.aColors;
+
+        // Grid cell (x, y, z) is drawn at 2 * (x, y, z) + origin, matching the former per-instance translation
+        m_voxelOrigin = XMFLOAT3(
+            -static_cast<FLOAT>(terrain.uWidth),
+            -1.25f * static_cast<FLOAT>(terrain.uHeight),
+            -static_cast<FLOAT>(terrain.uDepth)
+        );
+
+        // Created even for an empty map, the edits add their blocks to it
+        UINT uNumInstances = static_cast<UINT>(aInstanceData.size());
+        m_blockVoxel = std::make_shared<Voxel>(std::move(aInstanceData), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+        m_blockVoxel->ReserveInstances(uNumInstances + uNumInstances / 16u + MIN_SPARE_INSTANCES);
+        m_blockVoxel->Translate(XMLoadFloat3(&m_voxelOrigin));
+        m_voxels.push_back(m_blockVoxel);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::getGridRay
+
+      Summary:  Converts a ray from world space into the grid space of
+                the voxel grid. The cubes of the cells are 2 units wide
+                and centered on m_voxelOrigin + 2 * cell.
+
+      Args:     const VoxelRay& ray
+                  Ray in world space
+
+      Returns:  VoxelRay
+                  Ray in grid space
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelRay Scene::getGridRay(_In_ const VoxelRay& ray) const
+    {
+        return VoxelRay
+        {
+            .Origin = XMFLOAT3(
+                (ray.Origin.x - m_voxelOrigin.x + 1.0f) * 0.5f,
+                (ray.Origin.y - m_voxelOrigin.y + 1.0f) * 0.5f,
+                (ray.Origin.z - m_voxelOrigin.z + 1.0f) * 0.5f
+            ),
+            .Direction = ray.Direction,
+            .MaxDistance = ray.MaxDistance * 0.5f
+        };
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::uploadVoxels
+
+      Summary:  Copies the dirty instances of every voxel into its
+                instance buffer, once the scene is initialized
+
+      Modifies: [m_voxels].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::uploadVoxels()
+    {
+        if (!m_immediateContext)
+        {
+            return S_OK;
+        }
+
+        for (std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            // Voxels added after Initialize are initialized on their first upload
+            HRESULT hr = voxel->GetInstanceBuffer() ? voxel->UploadInstances(m_device.Get(), m_immediateContext.Get(), m_uploadRing) : voxel->Initialize(m_device.Get(), m_immediateContext.Get(), m_pGeometryRegistry);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
         return S_OK;
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::openRegionStore
+
+      Summary:  Opens the region store on a directory for the size of
+                the voxel grid, unless it is open on it already
+
+      Args:     const std::filesystem::path& directoryPath
+                  Directory of the region files
+
+      Modifies: [m_regionStore].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Scene::openRegionStore(_In_ const std::filesystem::path& directoryPath)
+    {
+        if (m_regionStore.IsOpen() && m_regionStore.GetDirectoryPath() == directoryPath)
+        {
+            return S_OK;
+        }
+
+        return m_regionStore.Open(directoryPath, m_voxelGrid.GetNumChunksX(), m_voxelGrid.GetNumChunksY(), m_voxelGrid.GetNumChunksZ());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::addRenderableProxy
+
+      Summary:  Inserts the world space bounds of an initialized
+                renderable into the renderable tree
+
+      Args:     Renderable& renderable
+                  Renderable to insert
+
+      Modifies: [m_renderableTree, m_aRenderableProxies].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::addRenderableProxy(_In_ Renderable& renderable)
+    {
+        RenderableProxy proxy =
+        {
+            .pRenderable = &renderable,
+            .uProxy = m_renderableTree.Insert(renderable.GetWorldBounds(), &renderable),
+        };
+        XMStoreFloat4x4(&proxy.World, renderable.GetWorldMatrix());
+
+        m_aRenderableProxies.push_back(proxy);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::updateRenderableTree
+
+      Summary:  Refits the proxies of the renderables whose world matrix
+                changed since the last call and rebuilds the tree when
+                the refits have degraded it. The world matrix is
+                compared rather than hooked in Translate, Rotate and
+                Scale, since renderables also set it directly in their
+                Update.
+
+      Modifies: [m_renderableTree, m_aRenderableProxies].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Scene::updateRenderableTree()
+    {
+        for (RenderableProxy& proxy : m_aRenderableProxies)
+        {
+            XMFLOAT4X4 world;
+            XMStoreFloat4x4(&world, proxy.pRenderable->GetWorldMatrix());
+            if (memcmp(&world, &proxy.World, sizeof(world)) == 0)
+            {
+                continue;
+            }
+
+            proxy.World = world;
+            m_renderableTree.Update(proxy.uProxy, proxy.pRenderable->GetWorldBounds());
+        }
+
+        if (m_renderableTree.NeedsRebuild())
+        {
+            m_renderableTree.Rebuild();
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::isValidBlockType
+
+      Summary:  Returns whether a block type can be placed in the map
+
+      Args:     eBlockType blockType
+                  Block type
+
+      Returns:  BOOL
+                  TRUE for air and the block types with a color
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Scene::isValidBlockType(_In_ eBlockType blockType) const
+    {
+        if (blockType == eBlockType::AIR)
+        {
+            return TRUE;
+        }
+
+        return eBlockType::GRASSLAND <= blockType && static_cast<size_t>(blockType) - static_cast<size_t>(eBlockType::GRASSLAND) < m_aBlockColors.size();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::getPerlin2dBatchAvx2
+
+      Summary:  AVX2 version of GetPerlin2d for 8 sample points per
+                iteration. Both hash table lookups of every lattice
+                corner are gathers.
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+                FLOAT* pOut
+                  Noise values of the sample points
+                UINT uCount
+                  Number of sample points
+
+      Returns:  UINT
+                  Number of sample points done, a multiple of 8
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Scene::getPerlin2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount)
+    {
+        const INT* pHashes = reinterpret_cast<const INT*>(ms_aHashes);
+        const __m256i hashMask = _mm256_set1_epi32(0xff);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256 two = _mm256_set1_ps(2.0f);
+
+        FLOAT div = 0.0f;
+        FLOAT amp = 1.0f;
+        for (UINT i = 0; i < uDepth; ++i)
+        {
+            div += 256.0f * amp;
+            amp /= 2.0f;
+        }
+
+        UINT uNumBatched = uCount & ~7u;
+        for (UINT uSampleIdx = 0u; uSampleIdx < uNumBatched; uSampleIdx += 8u)
+        {
+            __m256 xa = _mm256_mul_ps(_mm256_loadu_ps(pX + uSampleIdx), _mm256_set1_ps(frequency));
+            __m256 ya = _mm256_mul_ps(_mm256_loadu_ps(pY + uSampleIdx), _mm256_set1_ps(frequency));
+            __m256 fin = _mm256_setzero_ps();
+            amp = 1.0f;
+
+            for (UINT i = 0; i < uDepth; ++i)
+            {
+                __m256i x0 = _mm256_cvttps_epi32(xa);
+                __m256i y0 = _mm256_cvttps_epi32(ya);
+                __m256 xFrac = _mm256_sub_ps(xa, _mm256_cvtepi32_ps(x0));
+                __m256 yFrac = _mm256_sub_ps(ya, _mm256_cvtepi32_ps(y0));
+                __m256i x1 = _mm256_add_epi32(x0, one);
+
+                __m256i row0 = _mm256_i32gather_epi32(pHashes, _mm256_and_si256(y0, hashMask), 4);
+                __m256i row1 = _mm256_i32gather_epi32(pHashes, _mm256_and_si256(_mm256_add_epi32(y0, one), hashMask), 4);
+
+                __m256 s = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(pHashes, _mm256_and_si256(_mm256_add_epi32(row0, x0), hashMask), 4));
+                __m256 t = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(pHashes, _mm256_and_si256(_mm256_add_epi32(row0, x1), hashMask), 4));
+                __m256 u = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(pHashes, _mm256_and_si256(_mm256_add_epi32(row1, x0), hashMask), 4));
+                __m256 v = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(pHashes, _mm256_and_si256(_mm256_add_epi32(row1, x1), hashMask), 4));
+
+                __m256 low = smoothLerpAvx2(s, t, xFrac);
+                __m256 high = smoothLerpAvx2(u, v, xFrac);
+
+                fin = _mm256_add_ps(fin, _mm256_mul_ps(smoothLerpAvx2(low, high, yFrac), _mm256_set1_ps(amp)));
+                amp /= 2.0f;
+                xa = _mm256_mul_ps(xa, two);
+                ya = _mm256_mul_ps(ya, two);
+            }
+
+            _mm256_storeu_ps(pOut + uSampleIdx, _mm256_div_ps(fin, _mm256_set1_ps(div)));
+        }
+
+        return uNumBatched;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Scene::getPerlin2dBatchSse
+
+      Summary:  SSE2 version of GetPerlin2d for 4 sample points per
+                iteration. SSE has no gather, so only the hash table
+                lookups are scalar.
+
+      Args:     const FLOAT* pX
+                  x-coordinates of the sample points
+                const FLOAT* pY
+                  y-coordinates of the sample points
+                FLOAT frequency
+                  Frequency of the first octave
+                UINT uDepth
+                  Number of octaves
+                FLOAT* pOut
+                  Noise values of the sample points
+                UINT uCount
+                  Number of sample points
+
+      Returns:  UINT
+                  Number of sample points done, a multiple of 4
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Scene::getPerlin2dBatchSse(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount)
+    {
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        FLOAT div = 0.0f;
+        FLOAT amp = 1.0f;
+        for (UINT i = 0; i < uDepth; ++i)
+        {
+            div += 256.0f * amp;
+            amp /= 2.0f;
+        }
+
+        UINT uNumBatched = uCount & ~3u;
+        for (UINT uSampleIdx = 0u; uSampleIdx < uNumBatched; uSampleIdx += 4u)
+        {
+            __m128 xa = _mm_mul_ps(_mm_loadu_ps(pX + uSampleIdx), _mm_set1_ps(frequency));
+            __m128 ya = _mm_mul_ps(_mm_loadu_ps(pY + uSampleIdx), _mm_set1_ps(frequency));
+            __m128 fin = _mm_setzero_ps();
+            amp = 1.0f;
+
+            for (UINT i = 0; i < uDepth; ++i)
+            {
+                __m128i x0 = _mm_cvttps_epi32(xa);
+                __m128i y0 = _mm_cvttps_epi32(ya);
+                __m128 xFrac = _mm_sub_ps(xa, _mm_cvtepi32_ps(x0));
+                __m128 yFrac = _mm_sub_ps(ya, _mm_cvtepi32_ps(y0));
+
+                alignas(16) UINT aX[4];
+                alignas(16) UINT aY[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(aX), x0);
+                _mm_store_si128(reinterpret_cast<__m128i*>(aY), y0);
+
+                alignas(16) INT aS[4];
+                alignas(16) INT aT[4];
+                alignas(16) INT aU[4];
+                alignas(16) INT aV[4];
+                for (UINT uLane = 0u; uLane < 4u; ++uLane)
+                {
+                    UINT uRow0 = ms_aHashes[aY[uLane] % 256u];
+                    UINT uRow1 = ms_aHashes[(aY[uLane] + 1u) % 256u];
+                    aS[uLane] = static_cast<INT>(ms_aHashes[(uRow0 + aX[uLane]) % 256u]);
+                    aT[uLane] = static_cast<INT>(ms_aHashes[(uRow0 + aX[uLane] + 1u) % 256u]);
+                    aU[uLane] = static_cast<INT>(ms_aHashes[(uRow1 + aX[uLane]) % 256u]);
+                    aV[uLane] = static_cast<INT>(ms_aHashes[(uRow1 + aX[uLane] + 1u) % 256u]);
+                }
+
+                __m128 s = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(aS)));
+                __m128 t = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(aT)));
+                __m128 u = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(aU)));
+                __m128 v = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(aV)));
+
+                __m128 low = smoothLerpSse(s, t, xFrac);
+                __m128 high = smoothLerpSse(u, v, xFrac);
+
+                fin = _mm_add_ps(fin, _mm_mul_ps(smoothLerpSse(low, high, yFrac), _mm_set1_ps(amp)));
+                amp /= 2.0f;
+                xa = _mm_mul_ps(xa, two);
+                ya = _mm_mul_ps(ya, two);
+            }
+
+            _mm_storeu_ps(pOut + uSampleIdx, _mm_div_ps(fin, _mm_set1_ps(div)));
+        }
+
+        return uNumBatched;
+    }
+
     FLOAT Scene::getNoise2(UINT x, UINT y)
     {
         UINT temp = ms_aHashes[y % 256u];
@@ -16,7 +16,13 @@
 #include "Light/PointLight.h"
 #include "Renderer/Skybox.h"
 #include "Renderer/Renderable.h"
+#include "Scene/DynamicAabbTree.h"
+#include "Scene/TerrainData.h"
 #include "Scene/Voxel.h"
+#include "Scene/VoxelGrid.h"
+#include "Scene/VoxelLight.h"
+#include "Scene/VoxelRegionStore.h"
+#include "Scene/VoxelWorld.h"
 
 namespace library
 {
@@ -24,16 +30,19 @@ namespace library
     {
     public:
         static FLOAT GetPerlin2d(FLOAT x, FLOAT y, FLOAT frequency, UINT uDepth);
+        static void GetPerlin2dBatch(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount);
 
         Scene() = delete;
         Scene(const std::filesystem::path& filePath);
+        Scene(_In_ const TerrainData& terrain);
         Scene(const Scene& other) = delete;
         Scene(Scene&& other) = delete;
         Scene& operator=(const Scene& other) = delete;
         Scene& operator=(Scene&& other) = delete;
         virtual ~Scene() = default;
 
-        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext);
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry);
+        HRESULT InitializeRenderables(_In_opt_ ID3D11Device* pDevice, _In_opt_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry);
 
         HRESULT AddVoxel(_In_ const std::shared_ptr<Voxel>& voxel);
         HRESULT AddRenderable(_In_ PCWSTR pszRenderableName, _In_ const std::shared_ptr<Renderable>& renderable);
@@ -43,10 +52,25 @@ namespace library
         HRESULT AddPixelShader(_In_ PCWSTR pszPixelShaderName, _In_ const std::shared_ptr<PixelShader>& pixelShader);
         HRESULT AddMaterial(_In_ const std::shared_ptr<Material>& material);
         HRESULT AddSkyBox(_In_ const std::shared_ptr<Skybox>& skybox);
+        HRESULT SetVoxelWorld(_In_ const std::shared_ptr<VoxelWorld>& voxelWorld);
+
+        HRESULT SetBlock(_In_ INT x, _In_ INT y, _In_ INT z, _In_ eBlockType blockType);
+        HRESULT RemoveBlock(_In_ INT x, _In_ INT y, _In_ INT z);
+        HRESULT FillRegion(_In_ INT minX, _In_ INT minY, _In_ INT minZ, _In_ INT maxX, _In_ INT maxY, _In_ INT maxZ, _In_ eBlockType blockType);
+        HRESULT FlushBlockEdits();
+        HRESULT SetBlockEmission(_In_ eBlockType blockType, _In_ BYTE level, _In_opt_ ThreadPool* pThreadPool = nullptr);
+        HRESULT SaveBlocks(_In_ const std::filesystem::path& directoryPath);
+        HRESULT LoadBlocks(_In_ const std::filesystem::path& directoryPath);
+        HRESULT WaitForBlockSaves();
+
+        BOOL Raycast(_In_ const VoxelRay& ray, _Out_ VoxelRayHit& outHit) const;
+        void RaycastBatch(_In_reads_(uNumRays) const VoxelRay* pRays, _Out_writes_(uNumRays) VoxelRayHit* pOutHits, _In_ UINT uNumRays, _In_opt_ ThreadPool* pThreadPool = nullptr) const;
+        BYTE SweepBox(_In_ const XMFLOAT3& center, _In_ const XMFLOAT3& halfExtents, _In_ const XMFLOAT3& displacement, _Out_ XMFLOAT3& outDisplacement) const;
 
         void Update(_In_ FLOAT deltaTime);
 
         std::vector<std::shared_ptr<Voxel>>& GetVoxels();
+        ComPtr<ID3D11Buffer>& GetPaletteBuffer();
         std::unordered_map<std::wstring, std::shared_ptr<Renderable>>& GetRenderables();
         std::unordered_map<std::wstring, std::shared_ptr<Model>>& GetModels();
         std::shared_ptr<PointLight>& GetPointLight(_In_ size_t index);
@@ -54,6 +78,10 @@ namespace library
         std::unordered_map<std::wstring, std::shared_ptr<PixelShader>>& GetPixelShaders();
         std::unordered_map<std::wstring, std::shared_ptr<Material>>& GetMaterials();
         std::shared_ptr<Skybox>& GetSkyBox();
+        std::shared_ptr<VoxelWorld>& GetVoxelWorld();
+        const VoxelGrid& GetVoxelGrid() const;
+        const VoxelLight& GetVoxelLight() const;
+        const DynamicAabbTree& GetRenderableTree() const;
 
         const std::filesystem::path& GetFilePath() const;
         PCWSTR GetFileName() const;
@@ -69,6 +97,44 @@ namespace library
         HRESULT SetMaterialOfVoxel(_In_ PCWSTR pszMaterialName);
 
     private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   BlockEdit
+
+            Summary:  Cell changed since the last FlushBlockEdits
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct BlockEdit
+        {
+            INT x;
+            INT y;
+            INT z;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   RenderableProxy
+
+            Summary:  Renderable in the renderable tree, with
+                      the world matrix its bounds were last fitted to
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct RenderableProxy
+        {
+            Renderable* pRenderable;
+            UINT uProxy;
+            XMFLOAT4X4 World;
+        };
+
+        // Room for appended instances in the instance buffer of the map, besides 1/16 of its instances
+        static constexpr const UINT MIN_SPARE_INSTANCES = 256u;
+
+        void createVoxels(_In_ const TerrainData& terrain);
+        BOOL isValidBlockType(_In_ eBlockType blockType) const;
+        VoxelRay getGridRay(_In_ const VoxelRay& ray) const;
+        HRESULT uploadVoxels();
+        HRESULT openRegionStore(_In_ const std::filesystem::path& directoryPath);
+        void addRenderableProxy(_In_ Renderable& renderable);
+        void updateRenderableTree();
+
+        static UINT getPerlin2dBatchAvx2(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount);
+        static UINT getPerlin2dBatchSse(_In_reads_(uCount) const FLOAT* pX, _In_reads_(uCount) const FLOAT* pY, _In_ FLOAT frequency, _In_ UINT uDepth, _Out_writes_(uCount) FLOAT* pOut, _In_ UINT uCount);
         static FLOAT getNoise2(UINT x, UINT y);
         static FLOAT getNoise2d(FLOAT x, FLOAT y);
         static FLOAT lerp(FLOAT x, FLOAT y, FLOAT s);
@@ -93,6 +159,8 @@ namespace library
 
     private:
         std::filesystem::path m_filePath;
+        // Status of reading the height map file, returned by Initialize
+        HRESULT m_hrTerrain;
         std::vector<std::shared_ptr<Voxel>> m_voxels;
         std::unordered_map<std::wstring, std::shared_ptr<Renderable>> m_renderables;
         std::unordered_map<std::wstring, std::shared_ptr<Model>> m_models;
@@ -101,5 +169,24 @@ namespace library
         std::unordered_map<std::wstring, std::shared_ptr<PixelShader>> m_pixelShaders;
         std::unordered_map<std::wstring, std::shared_ptr<Material>> m_materials;
         std::shared_ptr<Skybox> m_skyBox;
+        std::shared_ptr<VoxelWorld> m_voxelWorld;
+        VoxelGrid m_voxelGrid;
+        VoxelLight m_voxelLight;
+        VoxelRegionStore m_regionStore;
+        std::shared_ptr<Voxel> m_blockVoxel;
+        std::vector<XMFLOAT4> m_aBlockColors;
+        XMFLOAT3 m_voxelOrigin;
+        std::vector<BlockEdit> m_aBlockEdits;
+        std::vector<UINT64> m_aEditedCells;
+        std::vector<XMINT3> m_aLightCells;
+        std::vector<XMINT3> m_aLitCells;
+        UploadRing m_uploadRing;
+        ComPtr<ID3D11Device> m_device;
+        ComPtr<ID3D11DeviceContext> m_immediateContext;
+        // Owned by the renderer with the device
+        GeometryRegistry* m_pGeometryRegistry;
+        ComPtr<ID3D11Buffer> m_paletteBuffer;
+        DynamicAabbTree m_renderableTree;
+        std::vector<RenderableProxy> m_aRenderableProxies;
     };
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "Scene/TerrainData.h"
+
+#include <fstream>
+
+namespace library
+{
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: ReadTerrainData
+
+      Summary:  Parses a height map file into a terrain grid
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the height map file
+                TerrainData& outTerrain
+                  Parsed terrain grid
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the file cannot be opened and
+                  ERROR_INVALID_DATA if it is missing its dimensions or
+                  cells
+    -----------------------------------------------------------------F-F*/
+    HRESULT ReadTerrainData(_In_ const std::filesystem::path& filePath, _Out_ TerrainData& outTerrain)
+    {
+        outTerrain = TerrainData{};
+
+        std::ifstream inputFile;
+        inputFile.open(filePath.string());
+        if (!inputFile.is_open())
+        {
+            return E_FAIL;
+        }
+
+        std::string trash;
+        UINT aDimension[4] = { 0u, };
+        UINT uDimensionIdx = 0u;
+        while (!inputFile.eof() && uDimensionIdx < ARRAYSIZE(aDimension))
+        {
+            inputFile >> aDimension[uDimensionIdx];
+
+            if (inputFile.fail())
+            {
+                if (inputFile.eof())
+                {
+                    break;
+                }
+                inputFile.clear();
+                inputFile >> trash;
+            }
+            else
+            {
+                ++uDimensionIdx;
+            }
+        }
+
+        if (uDimensionIdx < ARRAYSIZE(aDimension) || aDimension[0] == 0u || aDimension[1] == 0u || aDimension[2] == 0u)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        outTerrain.Resize(aDimension[0], aDimension[1], aDimension[2]);
+        outTerrain.aColors.reserve(aDimension[3]);
+
+        XMFLOAT4 color;
+        while (!inputFile.eof() && outTerrain.aColors.size() < aDimension[3])
+        {
+            inputFile >> color.x >> color.y >> color.z;
+
+            if (inputFile.fail())
+            {
+                if (inputFile.eof())
+                {
+                    break;
+                }
+                inputFile.clear();
+                inputFile >> trash;
+            }
+            else
+            {
+                color.w = 1.0f;
+                outTerrain.aColors.push_back(color);
+            }
+        }
+
+        size_t uCellIdx = 0u;
+        CHAR voxelType;
+        FLOAT height;
+        while (!inputFile.eof() && uCellIdx < outTerrain.GetNumCells())
+        {
+            inputFile >> voxelType >> height;
+
+            if (inputFile.fail())
+            {
+                if (inputFile.eof())
+                {
+                    break;
+                }
+                inputFile.clear();
+                inputFile >> trash;
+            }
+            else if (static_cast<CHAR>(eBlockType::GRASSLAND) <= voxelType && voxelType < static_cast<CHAR>(eBlockType::COUNT))
+            {
+                outTerrain.aBlockTypes[uCellIdx] = static_cast<eBlockType>(voxelType);
+                outTerrain.aHeights[uCellIdx] = height;
+                ++uCellIdx;
+            }
+        }
+
+        inputFile.close();
+
+        // A truncated file would leave the rest of the map flat at height 0
+        if (uCellIdx < outTerrain.GetNumCells())
+        {
+            outTerrain = TerrainData{};
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        return S_OK;
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: WriteTerrainData
+
+      Summary:  Serializes a terrain grid into a height map file that
+                can be read back with ReadTerrainData. Only needed for
+                caching or debugging, the Scene can be built from the
+                grid directly.
+
+      Args:     const std::filesystem::path& filePath
+                  Path to the height map file
+                const TerrainData& terrain
+                  Terrain grid to write
+
+      Returns:  HRESULT
+                  Status code
+    -----------------------------------------------------------------F-F*/
+    HRESULT WriteTerrainData(_In_ const std::filesystem::path& filePath, _In_ const TerrainData& terrain)
+    {
+        std::ofstream sceneFile;
+        sceneFile.open(filePath.string());
+        if (!sceneFile.is_open())
+        {
+            return E_FAIL;
+        }
+
+        sceneFile << terrain.uWidth << ' ' << terrain.uHeight << ' ' << terrain.uDepth << ' ' << terrain.aColors.size() << '\n';
+
+        for (const XMFLOAT4& color : terrain.aColors)
+        {
+            sceneFile << color.x << ' ' << color.y << ' ' << color.z << '\n';
+        }
+
+        for (UINT z = 0u; z < terrain.uDepth; ++z)
+        {
+            for (UINT x = 0u; x < terrain.uWidth; ++x)
+            {
+                size_t uCellIdx = static_cast<size_t>(z) * terrain.uWidth + x;
+
+                sceneFile << static_cast<CHAR>(terrain.aBlockTypes[uCellIdx]);
+                sceneFile << terrain.aHeights[uCellIdx] << ' ';
+            }
+            sceneFile << '\n';
+        }
+        sceneFile << std::endl;
+        sceneFile.close();
+
+        return S_OK;
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: DownsampleTerrainData
+
+      Summary:  Merges uFactor x uFactor x uFactor blocks of a terrain
+                grid into one block. A coarse column is as tall as the
+                tallest fine column it covers, rounded up to whole
+                coarse blocks, and takes the biome of that column. The
+                coarse terrain therefore always encloses the fine
+                terrain, so coarse and fine regions next to each other
+                overlap instead of leaving gaps.
+
+      Args:     const TerrainData& terrain
+                  Fine terrain grid
+                UINT uFactor
+                  Edge length of a coarse block in fine blocks
+                TerrainData& outTerrain
+                  Coarse terrain grid
+
+      Returns:  HRESULT
+                  Status code
+    -----------------------------------------------------------------F-F*/
+    HRESULT DownsampleTerrainData(_In_ const TerrainData& terrain, _In_ UINT uFactor, _Out_ TerrainData& outTerrain)
+    {
+        outTerrain = TerrainData{};
+
+        if (uFactor == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uCoarseHeight = (terrain.uHeight + uFactor - 1u) / uFactor;
+        outTerrain.Resize((terrain.uWidth + uFactor - 1u) / uFactor, uCoarseHeight > 0u ? uCoarseHeight : 1u, (terrain.uDepth + uFactor - 1u) / uFactor);
+        outTerrain.aColors = terrain.aColors;
+
+        for (UINT z = 0u; z < outTerrain.uDepth; ++z)
+        {
+            for (UINT x = 0u; x < outTerrain.uWidth; ++x)
+            {
+                UINT uEndX = (x + 1u) * uFactor < terrain.uWidth ? (x + 1u) * uFactor : terrain.uWidth;
+                UINT uEndZ = (z + 1u) * uFactor < terrain.uDepth ? (z + 1u) * uFactor : terrain.uDepth;
+
+                size_t uTallestCellIdx = static_cast<size_t>(z * uFactor) * terrain.uWidth + x * uFactor;
+                UINT uMaxColumnHeight = 0u;
+                for (UINT uFineZ = z * uFactor; uFineZ < uEndZ; ++uFineZ)
+                {
+                    for (UINT uFineX = x * uFactor; uFineX < uEndX; ++uFineX)
+                    {
+                        size_t uCellIdx = static_cast<size_t>(uFineZ) * terrain.uWidth + uFineX;
+                        UINT uColumnHeight = static_cast<UINT>(static_cast<FLOAT>(terrain.uHeight) * terrain.aHeights[uCellIdx]);
+                        if (uColumnHeight > uMaxColumnHeight)
+                        {
+                            uMaxColumnHeight = uColumnHeight;
+                            uTallestCellIdx = uCellIdx;
+                        }
+                    }
+                }
+
+                // Half a block of margin keeps the truncation of height * uHeight at the intended block count
+                UINT uNumCoarseBlocks = (uMaxColumnHeight + uFactor - 1u) / uFactor;
+                size_t uCoarseCellIdx = static_cast<size_t>(z) * outTerrain.uWidth + x;
+                outTerrain.aBlockTypes[uCoarseCellIdx] = terrain.aBlockTypes[uTallestCellIdx];
+                outTerrain.aHeights[uCoarseCellIdx] = uNumCoarseBlocks > 0u
+                    ? (static_cast<FLOAT>(uNumCoarseBlocks) + 0.5f) / static_cast<FLOAT>(outTerrain.uHeight)
+                    : 0.0f;
+            }
+        }
+
+        return S_OK;
+    }
+}
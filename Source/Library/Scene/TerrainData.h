@@ -0,0 +1,58 @@
+/*+===================================================================
+  File:      TERRAINDATA.H
+
+  Summary:   TerrainData header file contains the declaration of the
+             in-memory height / biome grid that is handed from the
+             terrain generator to the Scene, and the functions that
+             read and write the grid from / to a height map file and
+             downsample it for coarser levels of detail.
+
+  Classes: TerrainData
+
+  Functions: ReadTerrainData, WriteTerrainData, DownsampleTerrainData
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+        Struct:   TerrainData
+
+        Summary:  Height and biome grid of a voxel map. Cells are stored
+                  row by row along the x-axis, i.e. the cell (x, z) is
+                  at index z * uWidth + x. Heights are normalized so
+                  that a height of 1 fills the whole column of uHeight
+                  voxels.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct TerrainData
+    {
+        UINT uWidth;
+        UINT uHeight;
+        UINT uDepth;
+        std::vector<XMFLOAT4> aColors;
+        std::vector<eBlockType> aBlockTypes;
+        std::vector<FLOAT> aHeights;
+
+        size_t GetNumCells() const
+        {
+            return static_cast<size_t>(uWidth) * static_cast<size_t>(uDepth);
+        }
+
+        void Resize(_In_ UINT width, _In_ UINT height, _In_ UINT depth)
+        {
+            uWidth = width;
+            uHeight = height;
+            uDepth = depth;
+            aBlockTypes.assign(GetNumCells(), eBlockType::GRASSLAND);
+            aHeights.assign(GetNumCells(), 0.0f);
+        }
+    };
+
+    HRESULT ReadTerrainData(_In_ const std::filesystem::path& filePath, _Out_ TerrainData& outTerrain);
+    HRESULT WriteTerrainData(_In_ const std::filesystem::path& filePath, _In_ const TerrainData& terrain);
+    HRESULT DownsampleTerrainData(_In_ const TerrainData& terrain, _In_ UINT uFactor, _Out_ TerrainData& outTerrain);
+}
@@ -0,0 +1,388 @@
+#include "Scene/TerrainGenerator.h"
+
+#include <cmath>
+#include <limits>
+
+namespace library
+{
+    namespace
+    {
+        constexpr const FLOAT INF = std::numeric_limits<FLOAT>::infinity();
+    }
+
+    const TerrainGenerator::BiomeRule TerrainGenerator::DEFAULT_BIOME_RULES[6] =
+    {
+        { 0.1f,     FALSE,  { INF,      INF,    INF,    INF },  { eBlockType::OCEAN,                eBlockType::OCEAN,      eBlockType::OCEAN,                          eBlockType::OCEAN } },
+        { 0.12f,    FALSE,  { INF,      INF,    INF,    INF },  { eBlockType::SAND,                 eBlockType::SAND,       eBlockType::SAND,                           eBlockType::SAND } },
+        { 0.3f,     TRUE,   { 0.16f,    0.33f,  0.66f,  INF },  { eBlockType::SUBTROPICAL_DESERT,   eBlockType::GRASSLAND,  eBlockType::TROPICAL_SEASONAL_FOREST,       eBlockType::TROPICAL_RAIN_FOREST } },
+        { 0.6f,     TRUE,   { 0.16f,    0.5f,   0.83f,  INF },  { eBlockType::TEMPERATE_DESERT,     eBlockType::GRASSLAND,  eBlockType::TEMPERATE_DECIDUOUS_FOREST,     eBlockType::TEMPERATE_RAIN_FOREST } },
+        { 0.8f,     TRUE,   { 0.33f,    0.66f,  INF,    INF },  { eBlockType::TEMPERATE_DESERT,     eBlockType::SHRUBLAND,  eBlockType::TAIGA,                          eBlockType::TAIGA } },
+        { INF,      TRUE,   { 0.1f,     0.2f,   0.5f,   INF },  { eBlockType::SCORCHED,             eBlockType::BARE,       eBlockType::TUNDRA,                         eBlockType::SNOW } },
+    };
+
+    const XMFLOAT4 TerrainGenerator::DEFAULT_COLORS[static_cast<size_t>(eBlockType::COUNT) - static_cast<size_t>(eBlockType::GRASSLAND)] =
+    {
+        XMFLOAT4(0.0f,      0.666f, 0.0f,   1.0f),  // GRASSLAND
+        XMFLOAT4(1.0f,      1.0f,   1.0f,   1.0f),  // SNOW
+        XMFLOAT4(0.0f,      0.0f,   0.666f, 1.0f),  // OCEAN
+        XMFLOAT4(1.0f,      0.666f, 0.0f,   1.0f),  // SAND
+        XMFLOAT4(0.666f,    0.0f,   0.0f,   1.0f),  // SCORCHED
+        XMFLOAT4(0.956f,    0.643f, 0.376f, 1.0f),  // BARE
+        XMFLOAT4(0.941f,    0.0f,   1.0f,   1.0f),  // TUNDRA
+        XMFLOAT4(0.803f,    0.521f, 0.247f, 1.0f),  // TEMPERATE_DESERT
+        XMFLOAT4(0.42f,     0.556f, 0.137f, 1.0f),  // SHRUBLAND
+        XMFLOAT4(0.0f,      0.392f, 0.0f,   1.0f),  // TAIGA
+        XMFLOAT4(1.0f,      0.55f,  0.0f,   1.0f),  // TEMPERATE_DECIDUOUS_FOREST
+        XMFLOAT4(0.0f,      0.5f,   0.0f,   1.0f),  // TEMPERATE_RAIN_FOREST
+        XMFLOAT4(0.956f,    0.643f, 0.376f, 1.0f),  // SUBTROPICAL_DESERT
+        XMFLOAT4(0.133f,    0.545f, 0.133f, 1.0f),  // TROPICAL_SEASONAL_FOREST
+        XMFLOAT4(0.15f,     0.372f, 0.15f,  1.0f),  // TROPICAL_RAIN_FOREST
+    };
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::TerrainGenerator
+
+      Summary:  Constructor
+
+      Args:     UINT uSeed
+                  Seed of the noise fields
+
+      Modifies: [m_uSeed, m_uTileSize, m_aNoises, m_aBiomeRules].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TerrainGenerator::TerrainGenerator(_In_ UINT uSeed)
+        : m_uSeed(uSeed)
+        , m_uTileSize(DEFAULT_TILE_SIZE)
+        , m_aNoises
+        {
+            Noise(eNoiseType::LEGACY_VALUE, getLayerSeed(uSeed, eTerrainLayer::HEIGHT)),
+            Noise(eNoiseType::LEGACY_VALUE, getLayerSeed(uSeed, eTerrainLayer::MOISTURE)),
+        }
+        , m_aBiomeRules(DEFAULT_BIOME_RULES, DEFAULT_BIOME_RULES + ARRAYSIZE(DEFAULT_BIOME_RULES))
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::Generate
+
+      Summary:  Resizes the terrain grid and fills in the heights, biomes
+                and the default block colors. Every tile writes to its
+                own cells only, so the tiles are run on the thread pool
+                without any synchronization.
+
+      Args:     UINT uWidth
+                  Number of cells along the x-axis
+                UINT uHeight
+                  Number of voxels of a full column
+                UINT uDepth
+                  Number of cells along the z-axis
+                TerrainData& outTerrain
+                  Generated terrain grid
+                ThreadPool* pThreadPool
+                  Pool to generate the tiles on, the tiles run on the
+                  calling thread if nullptr
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TerrainGenerator::Generate(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth, _Out_ TerrainData& outTerrain, _In_opt_ ThreadPool* pThreadPool) const
+    {
+        return GenerateRegion(0u, 0u, uWidth, uHeight, uDepth, outTerrain, pThreadPool);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::GenerateRegion
+
+      Summary:  Same as Generate, but cell (0, 0) of the grid is the map
+                cell (uOriginX, uOriginZ). Regions of the same generator
+                line up seamlessly, which is what chunk streaming uses.
+
+      Args:     UINT uOriginX
+                  Map cell of the first grid cell along the x-axis
+                UINT uOriginZ
+                  Map cell of the first grid cell along the z-axis
+                UINT uWidth
+                  Number of cells along the x-axis
+                UINT uHeight
+                  Number of voxels of a full column
+                UINT uDepth
+                  Number of cells along the z-axis
+                TerrainData& outTerrain
+                  Generated terrain grid
+                ThreadPool* pThreadPool
+                  Pool to generate the tiles on, the tiles run on the
+                  calling thread if nullptr
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TerrainGenerator::GenerateRegion(_In_ UINT uOriginX, _In_ UINT uOriginZ, _In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth, _Out_ TerrainData& outTerrain, _In_opt_ ThreadPool* pThreadPool) const
+    {
+        outTerrain.Resize(uWidth, uHeight, uDepth);
+        outTerrain.aColors.assign(DEFAULT_COLORS, DEFAULT_COLORS + ARRAYSIZE(DEFAULT_COLORS));
+
+        if (m_uTileSize == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uNumTilesX = (uWidth + m_uTileSize - 1u) / m_uTileSize;
+        UINT uNumTilesZ = (uDepth + m_uTileSize - 1u) / m_uTileSize;
+        UINT uNumTiles = uNumTilesX * uNumTilesZ;
+
+        if (pThreadPool)
+        {
+            pThreadPool->ParallelFor(uNumTiles, [this, uOriginX, uOriginZ, uNumTilesX, &outTerrain](UINT uTileIdx)
+                {
+                    generateTile(uOriginX, uOriginZ, uTileIdx % uNumTilesX, uTileIdx / uNumTilesX, outTerrain);
+                });
+        }
+        else
+        {
+            for (UINT uTileIdx = 0u; uTileIdx < uNumTiles; ++uTileIdx)
+            {
+                generateTile(uOriginX, uOriginZ, uTileIdx % uNumTilesX, uTileIdx / uNumTilesX, outTerrain);
+            }
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::ClassifyBiome
+
+      Summary:  Looks up the block type of a cell in the biome table
+
+      Args:     FLOAT height
+                  Normalized height of the cell
+                FLOAT moisture
+                  Normalized moisture of the cell
+
+      Returns:  eBlockType
+                  Block type of the cell
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eBlockType TerrainGenerator::ClassifyBiome(_In_ FLOAT height, _In_ FLOAT moisture) const
+    {
+        for (const BiomeRule& rule : m_aBiomeRules)
+        {
+            if (height < rule.maxHeight || (rule.bInclusive && height == rule.maxHeight))
+            {
+                for (UINT i = 0u; i < MAX_MOISTURE_BANDS; ++i)
+                {
+                    if (moisture < rule.aMaxMoistures[i])
+                    {
+                        return rule.aBlockTypes[i];
+                    }
+                }
+
+                return rule.aBlockTypes[MAX_MOISTURE_BANDS - 1u];
+            }
+        }
+
+        return eBlockType::GRASSLAND;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::GetNoise
+
+      Summary:  Returns the noise field of a layer, e.g. to set up its
+                domain warp
+
+      Args:     eTerrainLayer layer
+                  Layer of the terrain
+
+      Returns:  Noise&
+                  Noise field of the layer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    Noise& TerrainGenerator::GetNoise(_In_ eTerrainLayer layer)
+    {
+        return m_aNoises[static_cast<size_t>(layer)];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::GetSeed
+
+      Summary:  Returns the seed
+
+      Returns:  UINT
+                  Seed of the noise fields
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TerrainGenerator::GetSeed() const
+    {
+        return m_uSeed;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::SetBiomeRules
+
+      Summary:  Replaces the biome lookup table
+
+      Args:     std::vector<BiomeRule>&& aBiomeRules
+                  Height bands sorted by ascending maxHeight
+
+      Modifies: [m_aBiomeRules].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainGenerator::SetBiomeRules(_In_ std::vector<BiomeRule>&& aBiomeRules)
+    {
+        m_aBiomeRules = std::move(aBiomeRules);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::SetNoiseType
+
+      Summary:  Replaces the noise field of a layer with a new one of
+                the given algorithm, seeded from the generator seed
+
+      Args:     eTerrainLayer layer
+                  Layer of the terrain
+                eNoiseType type
+                  Noise algorithm
+
+      Modifies: [m_aNoises].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainGenerator::SetNoiseType(_In_ eTerrainLayer layer, _In_ eNoiseType type)
+    {
+        m_aNoises[static_cast<size_t>(layer)] = Noise(type, getLayerSeed(m_uSeed, layer));
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::SetTileSize
+
+      Summary:  Sets the edge length of a tile. Does not change the
+                generated terrain, only how the work is split up.
+
+      Args:     UINT uTileSize
+                  Edge length of a tile in cells
+
+      Modifies: [m_uTileSize].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainGenerator::SetTileSize(_In_ UINT uTileSize)
+    {
+        m_uTileSize = uTileSize;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::getLayerSeed
+
+      Summary:  Derives the seed of a layer from the generator seed.
+                Seed 0 leaves the height layer at seed 0.
+
+      Args:     UINT uSeed
+                  Seed of the generator
+                eTerrainLayer layer
+                  Layer of the terrain
+
+      Returns:  UINT
+                  Seed of the noise field of the layer
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TerrainGenerator::getLayerSeed(_In_ UINT uSeed, _In_ eTerrainLayer layer)
+    {
+        return uSeed ^ (static_cast<UINT>(layer) * 0x9e3779b9u);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::sampleLayerRow
+
+      Summary:  Sums NUM_OCTAVES octaves of value noise along a run of
+                cells of one row and reshapes the result into
+                [0, 1.2^1.25]. The octaves are evaluated with
+                Noise::GetFractal2dBatch.
+
+      Args:     const Noise& noise
+                  Noise field to sample
+                UINT uBeginX
+                  Index of the first cell along the x-axis
+                UINT z
+                  Cell index along the z-axis
+                UINT uCount
+                  Number of cells
+                RowScratch& scratch
+                  Scratch buffers with room for uCount samples
+                FLOAT* pOut
+                  Noise values of the cells
+
+      Modifies: [scratch].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainGenerator::sampleLayerRow(_In_ const Noise& noise, _In_ UINT uBeginX, _In_ UINT z, _In_ UINT uCount, _Inout_ RowScratch& scratch, _Out_writes_(uCount) FLOAT* pOut)
+    {
+
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            pOut[i] = 0.0f;
+        }
+
+        FLOAT frequencySum = 0.0f;
+        for (UINT i = 0u; i < NUM_OCTAVES; ++i)
+        {
+            FLOAT frequency = static_cast<FLOAT>(1u << i);
+            frequencySum += 1.0f / frequency;
+
+            for (UINT uSampleIdx = 0u; uSampleIdx < uCount; ++uSampleIdx)
+            {
+                scratch.aX[uSampleIdx] = frequency * static_cast<FLOAT>(uBeginX + uSampleIdx);
+                scratch.aZ[uSampleIdx] = frequency * static_cast<FLOAT>(z);
+            }
+
+            noise.GetFractal2dBatch(scratch.aX.data(), scratch.aZ.data(), NOISE_FREQUENCY, NOISE_DEPTH, scratch.aNoise.data(), uCount);
+
+            for (UINT uSampleIdx = 0u; uSampleIdx < uCount; ++uSampleIdx)
+            {
+                pOut[uSampleIdx] += scratch.aNoise[uSampleIdx] / frequency;
+            }
+        }
+
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            pOut[i] = std::pow(pOut[i] / frequencySum * 1.2f, 1.25f);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TerrainGenerator::generateTile
+
+      Summary:  Generates the cells of one tile, a row at a time
+
+      Args:     UINT uOriginX
+                  Map cell of the first grid cell along the x-axis
+                UINT uOriginZ
+                  Map cell of the first grid cell along the z-axis
+                UINT uTileX
+                  Tile index along the x-axis
+                UINT uTileZ
+                  Tile index along the z-axis
+                TerrainData& terrain
+                  Terrain grid, already resized
+
+      Modifies: [terrain].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TerrainGenerator::generateTile(_In_ UINT uOriginX, _In_ UINT uOriginZ, _In_ UINT uTileX, _In_ UINT uTileZ, _Inout_ TerrainData& terrain) const
+    {
+        UINT uBeginX = uTileX * m_uTileSize;
+        UINT uBeginZ = uTileZ * m_uTileSize;
+        UINT uEndX = uBeginX + m_uTileSize < terrain.uWidth ? uBeginX + m_uTileSize : terrain.uWidth;
+        UINT uEndZ = uBeginZ + m_uTileSize < terrain.uDepth ? uBeginZ + m_uTileSize : terrain.uDepth;
+        UINT uCount = uEndX - uBeginX;
+
+        RowScratch scratch;
+        scratch.aX.resize(uCount);
+        scratch.aZ.resize(uCount);
+        scratch.aNoise.resize(uCount);
+
+        std::vector<FLOAT> aMoistures(uCount);
+
+        for (UINT z = uBeginZ; z < uEndZ; ++z)
+        {
+            size_t uRowIdx = static_cast<size_t>(z) * terrain.uWidth + uBeginX;
+            FLOAT* pHeights = terrain.aHeights.data() + uRowIdx;
+
+            sampleLayerRow(m_aNoises[static_cast<size_t>(eTerrainLayer::HEIGHT)], uOriginX + uBeginX, uOriginZ + z, uCount, scratch, pHeights);
+            sampleLayerRow(m_aNoises[static_cast<size_t>(eTerrainLayer::MOISTURE)], uOriginX + uBeginX, uOriginZ + z, uCount, scratch, aMoistures.data());
+
+            for (UINT i = 0u; i < uCount; ++i)
+            {
+                assert(pHeights[i] >= 0.0f);
+
+                terrain.aBlockTypes[uRowIdx + i] = ClassifyBiome(pHeights[i], aMoistures[i]);
+            }
+        }
+    }
+}
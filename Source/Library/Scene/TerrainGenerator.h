@@ -0,0 +1,145 @@
+/*+===================================================================
+  File:      TERRAINGENERATOR.H
+
+  Summary:   TerrainGenerator header file contains declarations of the
+             TerrainGenerator class that fills a TerrainData grid with
+             noise based heights and biomes.
+
+  Classes: TerrainGenerator
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Scene/Noise.h"
+#include "Scene/TerrainData.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eTerrainLayer
+
+        Summary:  Enumeration of the noise fields of the terrain
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eTerrainLayer : BYTE
+    {
+        HEIGHT,
+        MOISTURE,
+        COUNT,
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TerrainGenerator
+
+      Summary:  Generates the height and moisture of every cell of a
+                voxel map from layered value noise and classifies the
+                cells into biomes with a lookup table.
+
+                The map is split into square tiles that are generated
+                independently, so the output does not depend on the
+                number of threads or on the order the tiles run in.
+                The same seed always generates the same map. Every layer
+                can use its own noise algorithm; with the default
+                LEGACY_VALUE layers seed 0 generates the height field of
+                the original hard-coded generator.
+
+      Methods:  Generate
+                  Fills a terrain grid, optionally on a thread pool
+                GenerateRegion
+                  Fills a terrain grid with the cells of a region that
+                  starts at any cell of the map
+                ClassifyBiome
+                  Returns the block type of a height / moisture pair
+                GetNoise
+                  Returns the noise field of a layer
+                GetSeed
+                  Returns the seed
+                SetBiomeRules
+                  Replaces the biome lookup table
+                SetNoiseType
+                  Changes the noise algorithm of a layer
+                SetTileSize
+                  Sets the edge length of a tile in cells
+                TerrainGenerator
+                  Constructor.
+                ~TerrainGenerator
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TerrainGenerator
+    {
+    public:
+        static constexpr const UINT MAX_MOISTURE_BANDS = 4u;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   BiomeRule
+
+            Summary:  One height band of the biome lookup table. A cell
+                      belongs to the first band whose maxHeight it is
+                      below (or equal to, if bInclusive), then to the
+                      first moisture band whose upper bound it is below.
+                      The last used moisture bound should be INFINITY.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct BiomeRule
+        {
+            FLOAT maxHeight;
+            BOOL bInclusive;
+            FLOAT aMaxMoistures[MAX_MOISTURE_BANDS];
+            eBlockType aBlockTypes[MAX_MOISTURE_BANDS];
+        };
+
+        static constexpr const UINT DEFAULT_TILE_SIZE = 64u;
+        static const BiomeRule DEFAULT_BIOME_RULES[6];
+        static const XMFLOAT4 DEFAULT_COLORS[static_cast<size_t>(eBlockType::COUNT) - static_cast<size_t>(eBlockType::GRASSLAND)];
+
+    public:
+        TerrainGenerator() = delete;
+        explicit TerrainGenerator(_In_ UINT uSeed);
+        TerrainGenerator(const TerrainGenerator& other) = default;
+        TerrainGenerator(TerrainGenerator&& other) = default;
+        TerrainGenerator& operator=(const TerrainGenerator& other) = default;
+        TerrainGenerator& operator=(TerrainGenerator&& other) = default;
+        ~TerrainGenerator() = default;
+
+        HRESULT Generate(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth, _Out_ TerrainData& outTerrain, _In_opt_ ThreadPool* pThreadPool = nullptr) const;
+        HRESULT GenerateRegion(_In_ UINT uOriginX, _In_ UINT uOriginZ, _In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth, _Out_ TerrainData& outTerrain, _In_opt_ ThreadPool* pThreadPool = nullptr) const;
+        eBlockType ClassifyBiome(_In_ FLOAT height, _In_ FLOAT moisture) const;
+
+        Noise& GetNoise(_In_ eTerrainLayer layer);
+        UINT GetSeed() const;
+
+        void SetBiomeRules(_In_ std::vector<BiomeRule>&& aBiomeRules);
+        void SetNoiseType(_In_ eTerrainLayer layer, _In_ eNoiseType type);
+        void SetTileSize(_In_ UINT uTileSize);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   RowScratch
+
+            Summary:  Sample coordinates and noise values of one batch
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct RowScratch
+        {
+            std::vector<FLOAT> aX;
+            std::vector<FLOAT> aZ;
+            std::vector<FLOAT> aNoise;
+        };
+
+        static constexpr const UINT NUM_OCTAVES = 4u;
+        static constexpr const UINT NOISE_DEPTH = 4u;
+        static constexpr const FLOAT NOISE_FREQUENCY = 0.1f;
+
+        static UINT getLayerSeed(_In_ UINT uSeed, _In_ eTerrainLayer layer);
+        static void sampleLayerRow(_In_ const Noise& noise, _In_ UINT uBeginX, _In_ UINT z, _In_ UINT uCount, _Inout_ RowScratch& scratch, _Out_writes_(uCount) FLOAT* pOut);
+
+        void generateTile(_In_ UINT uOriginX, _In_ UINT uOriginZ, _In_ UINT uTileX, _In_ UINT uTileZ, _Inout_ TerrainData& terrain) const;
+
+    private:
+        UINT m_uSeed;
+        UINT m_uTileSize;
+        Noise m_aNoises[static_cast<size_t>(eTerrainLayer::COUNT)];
+        std::vector<BiomeRule> m_aBiomeRules;
+    };
+}
@@ -1,9 +1,308 @@
 #include "Scene/Voxel.h"
 
+#include <algorithm>
+
+#include "Scene/VoxelLight.h"
 #include "Texture/Material.h"
 
 namespace library
 {
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::BuildInstanceData
+
+      Summary:  Builds the packed instances of every block type in a
+                rectangular region of a terrain grid into one list, so
+                one voxel draws all of them and the shader picks the
+                color of each block from its type. Blocks whose six
+                faces are all covered by neighbours are not instanced,
+                the remaining blocks carry a mask of their exposed
+                faces, the ambient occlusion of their corners and full
+                skylight, as all air of a height map is open to the
+                sky. Cells around the region are only read as
+                neighbours, so a region with a one cell border of the
+                surrounding terrain has no faces on its own edges and
+                no seams in its occlusion. The rows of the region are
+                built in bands of NUM_ROWS_PER_TASK rows on the thread
+                pool and joined in order, so the instances come out in
+                the same order either way.
+
+      Args:     const TerrainData& terrain
+                  Height and biome grid
+                UINT uBeginX
+                  First cell of the region along the x-axis
+                UINT uBeginZ
+                  First cell of the region along the z-axis
+                UINT uWidth
+                  Number of cells of the region along the x-axis
+                UINT uDepth
+                  Number of cells of the region along the z-axis
+                std::vector<VoxelInstanceData>& aOutInstanceData
+                  Instances of every block type with a terrain color,
+                  by z, then x, then y, with grid coordinates relative
+                  to the first cell of the region
+                ThreadPool* pThreadPool
+                  Pool to build the rows on, the rows are built on the
+                  calling thread if nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::BuildInstanceData(_In_ const TerrainData& terrain, _In_ UINT uBeginX, _In_ UINT uBeginZ, _In_ UINT uWidth, _In_ UINT uDepth, _Out_ std::vector<VoxelInstanceData>& aOutInstanceData, _In_opt_ ThreadPool* pThreadPool)
+    {
+        aOutInstanceData.clear();
+
+        UINT uEndX = uBeginX + uWidth < terrain.uWidth ? uBeginX + uWidth : terrain.uWidth;
+        UINT uEndZ = uBeginZ + uDepth < terrain.uDepth ? uBeginZ + uDepth : terrain.uDepth;
+        if (uBeginX >= uEndX || uBeginZ >= uEndZ)
+        {
+            return;
+        }
+
+        // The grid edge counts as empty, and the columns are clipped to the top of the grid like in VoxelGrid::FillTerrain
+        auto getColumnHeight = [&terrain](INT x, INT z) -> UINT
+        {
+            if (x < 0 || z < 0 || x >= static_cast<INT>(terrain.uWidth) || z >= static_cast<INT>(terrain.uDepth))
+            {
+                return 0u;
+            }
+            UINT uColumnHeight = static_cast<UINT>(static_cast<FLOAT>(terrain.uHeight) * terrain.aHeights[static_cast<size_t>(z) * terrain.uWidth + static_cast<size_t>(x)]);
+            return uColumnHeight < terrain.uHeight ? uColumnHeight : terrain.uHeight;
+        };
+
+        auto buildRows = [&terrain, &getColumnHeight, uBeginX, uBeginZ, uEndX](UINT uRowBeginZ, UINT uRowEndZ, std::vector<VoxelInstanceData>& aRowInstanceData)
+        {
+            for (UINT uDepthIdx = uRowBeginZ; uDepthIdx < uRowEndZ; ++uDepthIdx)
+            {
+                for (UINT uWidthIdx = uBeginX; uWidthIdx < uEndX; ++uWidthIdx)
+                {
+                    size_t uCellIdx = static_cast<size_t>(uDepthIdx) * terrain.uWidth + uWidthIdx;
+                    size_t uColorIdx = static_cast<size_t>(terrain.aBlockTypes[uCellIdx]) - static_cast<size_t>(eBlockType::GRASSLAND);
+                    if (uColorIdx >= terrain.aColors.size())
+                    {
+                        continue;
+                    }
+
+                    // Heights of the 3x3 columns around the cell, in the order of the neighbour bits
+                    UINT aColumnHeights[9] = {};
+                    for (INT dz = -1; dz <= 1; ++dz)
+                    {
+                        for (INT dx = -1; dx <= 1; ++dx)
+                        {
+                            aColumnHeights[(dz + 1) * 3 + (dx + 1)] = getColumnHeight(static_cast<INT>(uWidthIdx) + dx, static_cast<INT>(uDepthIdx) + dz);
+                        }
+                    }
+
+                    // Blocks between the bottom block and the lowest side neighbour have no exposed face
+                    UINT uColumnHeight = aColumnHeights[4];
+                    UINT uFirstExposedIdx = uColumnHeight - 1u;
+                    for (UINT uSideIdx : { 1u, 3u, 5u, 7u })
+                    {
+                        uFirstExposedIdx = aColumnHeights[uSideIdx] < uFirstExposedIdx ? aColumnHeights[uSideIdx] : uFirstExposedIdx;
+                    }
+                    uFirstExposedIdx = uFirstExposedIdx > 1u ? uFirstExposedIdx : 1u;
+
+                    for (UINT uHeightIdx = 0u; uHeightIdx < uColumnHeight; uHeightIdx = uHeightIdx == 0u ? uFirstExposedIdx : uHeightIdx + 1u)
+                    {
+                        UINT uNeighbourMask = 0u;
+                        for (UINT uColumnIdx = 0u; uColumnIdx < 9u; ++uColumnIdx)
+                        {
+                            UINT uNeighbourHeight = aColumnHeights[uColumnIdx];
+                            uNeighbourMask |= (uHeightIdx > 0u && uHeightIdx - 1u < uNeighbourHeight) ? 1u << uColumnIdx : 0u;
+                            uNeighbourMask |= (uHeightIdx < uNeighbourHeight) ? 1u << (9u + uColumnIdx) : 0u;
+                            uNeighbourMask |= (uHeightIdx + 1u < uNeighbourHeight) ? 1u << (18u + uColumnIdx) : 0u;
+                        }
+
+                        BYTE faceMask = GetFaceMask(uNeighbourMask);
+                        if (faceMask == 0u)
+                        {
+                            continue;
+                        }
+
+                        VoxelInstanceData instance =
+                        {
+                            .X = static_cast<INT16>(uWidthIdx - uBeginX),
+                            .Y = static_cast<INT16>(uHeightIdx),
+                            .Z = static_cast<INT16>(uDepthIdx - uBeginZ),
+                            .BlockType = static_cast<BYTE>(terrain.aBlockTypes[uCellIdx]),
+                            .FaceMask = faceMask
+                        };
+                        BakeAmbientOcclusion(uNeighbourMask, instance);
+                        VoxelLight::BakeOpenSkyLight(instance);
+                        aRowInstanceData.push_back(instance);
+                    }
+                }
+            }
+        };
+
+        UINT uNumTasks = (uEndZ - uBeginZ + NUM_ROWS_PER_TASK - 1u) / NUM_ROWS_PER_TASK;
+        if (!pThreadPool || uNumTasks <= 1u)
+        {
+            buildRows(uBeginZ, uEndZ, aOutInstanceData);
+            return;
+        }
+
+        std::vector<std::vector<VoxelInstanceData>> aTaskInstanceData(uNumTasks);
+        pThreadPool->ParallelFor(uNumTasks, [&buildRows, &aTaskInstanceData, uBeginZ, uEndZ](UINT uTaskIdx)
+        {
+            UINT uRowBeginZ = uBeginZ + uTaskIdx * NUM_ROWS_PER_TASK;
+            UINT uRowEndZ = uRowBeginZ + NUM_ROWS_PER_TASK < uEndZ ? uRowBeginZ + NUM_ROWS_PER_TASK : uEndZ;
+            buildRows(uRowBeginZ, uRowEndZ, aTaskInstanceData[uTaskIdx]);
+        });
+
+        // Join the bands in the order of their rows, the vector is allocated once
+        size_t uNumInstances = 0u;
+        for (const std::vector<VoxelInstanceData>& aRowInstanceData : aTaskInstanceData)
+        {
+            uNumInstances += aRowInstanceData.size();
+        }
+
+        aOutInstanceData.reserve(uNumInstances);
+        for (const std::vector<VoxelInstanceData>& aRowInstanceData : aTaskInstanceData)
+        {
+            aOutInstanceData.insert(aOutInstanceData.end(), aRowInstanceData.begin(), aRowInstanceData.end());
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::BakeAmbientOcclusion
+
+      Summary:  Sets the ambient occlusion of the corners of the exposed
+                faces of an instance. A corner of a face is darkened by
+                the two cells beside it and the cell diagonal to it in
+                the layer in front of the face, and is fully dark when
+                both side cells are solid.
+
+      Args:     UINT uNeighbourMask
+                  Solid cells of the 3x3x3 neighbourhood of the block
+                VoxelInstanceData& instance
+                  Instance with its FaceMask set
+
+      Modifies: [instance.AmbientOcclusion].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::BakeAmbientOcclusion(_In_ UINT uNeighbourMask, _Inout_ VoxelInstanceData& instance)
+    {
+        // Neighbour bits of the two side cells and the diagonal cell of every corner, in the vertex order of VERTICES
+        static constexpr const BYTE s_aCornerNeighbours[6][4][3] =
+        {
+            { { 21, 19, 18 }, { 23, 19, 20 }, { 23, 25, 26 }, { 21, 25, 24 } },
+            { {  3,  1,  0 }, {  5,  1,  2 }, {  5,  7,  8 }, {  3,  7,  6 } },
+            { {  3, 15,  6 }, {  3,  9,  0 }, { 21,  9, 18 }, { 21, 15, 24 } },
+            { {  5, 17,  8 }, {  5, 11,  2 }, { 23, 11, 20 }, { 23, 17, 26 } },
+            { {  9,  1,  0 }, { 11,  1,  2 }, { 11, 19, 20 }, {  9, 19, 18 } },
+            { { 15,  7,  6 }, { 17,  7,  8 }, { 17, 25, 26 }, { 15, 25, 24 } },
+        };
+
+        instance.AmbientOcclusion[0] = 0u;
+        instance.AmbientOcclusion[1] = 0u;
+        for (UINT uFaceIdx = 0u; uFaceIdx < 6u; ++uFaceIdx)
+        {
+            if ((instance.FaceMask & (1u << uFaceIdx)) == 0u)
+            {
+                continue;
+            }
+
+            for (UINT uCornerIdx = 0u; uCornerIdx < 4u; ++uCornerIdx)
+            {
+                const BYTE* pNeighbours = s_aCornerNeighbours[uFaceIdx][uCornerIdx];
+                UINT uSide1 = (uNeighbourMask >> pNeighbours[0]) & 1u;
+                UINT uSide2 = (uNeighbourMask >> pNeighbours[1]) & 1u;
+                UINT uCorner = (uNeighbourMask >> pNeighbours[2]) & 1u;
+                UINT uOcclusion = (uSide1 & uSide2) ? 3u : uSide1 + uSide2 + uCorner;
+                instance.AmbientOcclusion[uFaceIdx / 4u] |= uOcclusion << ((uFaceIdx % 4u) * 8u + uCornerIdx * 2u);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::CreatePaletteBuffer
+
+      Summary:  Creates the immutable constant buffer of the colors of
+                the block types, read by the voxel shaders with the
+                block type of every instance
+
+      Args:     ID3D11Device* pDevice
+                  Pointer to a Direct3D 11 device
+                const std::vector<XMFLOAT4>& aColors
+                  Terrain colors, starting at eBlockType::GRASSLAND
+                ComPtr<ID3D11Buffer>& outPaletteBuffer
+                  Created constant buffer
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Voxel::CreatePaletteBuffer(_In_ ID3D11Device* pDevice, _In_ const std::vector<XMFLOAT4>& aColors, _Out_ ComPtr<ID3D11Buffer>& outPaletteBuffer)
+    {
+        CBVoxelPalette cbPalette = {};
+        for (size_t uColorIdx = 0u; uColorIdx < aColors.size(); ++uColorIdx)
+        {
+            size_t uBlockType = static_cast<size_t>(eBlockType::GRASSLAND) + uColorIdx;
+            if (uBlockType >= static_cast<size_t>(eBlockType::COUNT))
+            {
+                break;
+            }
+            cbPalette.BlockColors[uBlockType] = aColors[uColorIdx];
+        }
+
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(CBVoxelPalette),
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = 0
+        };
+
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = &cbPalette
+        };
+
+        return pDevice->CreateBuffer(&bd, &initData, outPaletteBuffer.ReleaseAndGetAddressOf());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetFaceMask
+
+      Summary:  Returns the faces of a block whose neighbour is not
+                solid
+
+      Args:     UINT uNeighbourMask
+                  Solid cells of the 3x3x3 neighbourhood of the block
+
+      Returns:  BYTE
+                  FACE_* bits
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE Voxel::GetFaceMask(_In_ UINT uNeighbourMask)
+    {
+        BYTE faceMask = 0u;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(0, 1, 0))) ? 0u : FACE_POSITIVE_Y;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(0, -1, 0))) ? 0u : FACE_NEGATIVE_Y;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(-1, 0, 0))) ? 0u : FACE_NEGATIVE_X;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(1, 0, 0))) ? 0u : FACE_POSITIVE_X;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(0, 0, -1))) ? 0u : FACE_NEGATIVE_Z;
+        faceMask |= (uNeighbourMask & (1u << GetNeighbourBit(0, 0, 1))) ? 0u : FACE_POSITIVE_Z;
+
+        return faceMask;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetNeighbourBit
+
+      Summary:  Returns the bit of a cell in the mask of the 3x3x3
+                neighbourhood of a block, layer by layer along the
+                y-axis, row by row along the z-axis
+
+      Args:     INT dx
+                  Offset of the cell along the x-axis, -1 to 1
+                INT dy
+                  Offset of the cell along the y-axis, -1 to 1
+                INT dz
+                  Offset of the cell along the z-axis, -1 to 1
+
+      Returns:  UINT
+                  Bit index, 13 for the block itself
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT Voxel::GetNeighbourBit(_In_ INT dx, _In_ INT dy, _In_ INT dz)
+    {
+        return static_cast<UINT>((dy + 1) * 9 + (dz + 1) * 3 + (dx + 1));
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Voxel::Voxel
 
@@ -18,6 +317,13 @@ namespace library
 
     Voxel::Voxel(_In_ const XMFLOAT4& outputColor)
         : InstancedRenderable(outputColor)
+        , m_aVoxelInstanceData()
+        , m_uNumSortedInstances(0u)
+        , m_uInstanceCapacity(0u)
+        , m_uInstanceBufferCapacity(0u)
+        , m_appendedInstances()
+        , m_aFreeInstances()
+        , m_aDirtyInstances()
     { }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
@@ -25,8 +331,8 @@ namespace library
 
       Summary:  Constructor
 
-      Args:     std::vector<InstanceData>&& aInstanceData
-                  Instance data
+      Args:     std::vector<VoxelInstanceData>&& aInstanceData
+                  Packed instance data
                 const XMFLOAT4& outputColor
                   Color of the voxel
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
@@ -34,9 +340,18 @@ namespace library
       TODO: Voxel::Voxel definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    Voxel::Voxel(_In_ std::vector<InstanceData>&& aInstanceData, _In_ const XMFLOAT4& outputColor)
-        : InstancedRenderable(std::move(aInstanceData), outputColor)
-    { }
+    Voxel::Voxel(_In_ std::vector<VoxelInstanceData>&& aInstanceData, _In_ const XMFLOAT4& outputColor)
+        : InstancedRenderable(outputColor)
+        , m_aVoxelInstanceData(std::move(aInstanceData))
+        , m_uNumSortedInstances(0u)
+        , m_uInstanceCapacity(0u)
+        , m_uInstanceBufferCapacity(0u)
+        , m_appendedInstances()
+        , m_aFreeInstances()
+        , m_aDirtyInstances()
+    {
+        resetEdits();
+    }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Voxel::Initialize
@@ -47,6 +362,8 @@ namespace library
                   The Direct3D device to create the buffers
                 ID3D11DeviceContext* pImmediateContext
                   The Direct3D context to set buffers
+                GeometryRegistry* pGeometryRegistry
+                  Shared buffers of the device, may be nullptr
 
       Returns:  HRESULT
                   Status code
@@ -55,14 +372,14 @@ namespace library
       TODO: Voxel::Initialize definition (remove the comment)
     --------------------------------------------------------------------*/
 
-    HRESULT Voxel::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext)
+    HRESULT Voxel::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry)
     {
         BasicMeshEntry basicMeshEntry;
         basicMeshEntry.uNumIndices = NUM_INDICES;
 
         m_aMeshes.push_back(basicMeshEntry);
 
-        HRESULT hr = initialize(pDevice, pImmediateContext);
+        HRESULT hr = initialize(pDevice, pImmediateContext, pGeometryRegistry);
         if (FAILED(hr))
         {
             return hr;
@@ -102,6 +419,242 @@ namespace library
     {
     }
 
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::SetVoxelInstanceData
+
+      Summary:  Sets the packed instance data
+
+      Args:     std::vector<VoxelInstanceData>&& aInstanceData
+                  Packed instance data
+
+      Modifies: [m_aVoxelInstanceData, m_uNumSortedInstances,
+                 m_appendedInstances, m_aFreeInstances, m_aDirtyInstances].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    void Voxel::SetVoxelInstanceData(_In_ std::vector<VoxelInstanceData>&& aInstanceData)
+    {
+        m_aVoxelInstanceData = std::move(aInstanceData);
+        resetEdits();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::RemoveInstance
+
+      Summary:  Removes the instance of a cell. The slot is left as an
+                instance without faces, slots of appended instances are
+                reused by the next SetInstance.
+
+      Args:     INT16 x
+                  Cell along the x-axis
+                INT16 y
+                  Cell along the y-axis
+                INT16 z
+                  Cell along the z-axis
+
+      Modifies: [m_aVoxelInstanceData, m_appendedInstances,
+                 m_aFreeInstances, m_aDirtyInstances].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::RemoveInstance(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z)
+    {
+        UINT uInstanceIdx = 0u;
+        if (!findInstance(x, y, z, uInstanceIdx) || m_aVoxelInstanceData[uInstanceIdx].FaceMask == 0u)
+        {
+            return;
+        }
+
+        m_aVoxelInstanceData[uInstanceIdx].FaceMask = 0u;
+        if (uInstanceIdx >= m_uNumSortedInstances)
+        {
+            m_appendedInstances.erase(getInstanceKey(x, y, z));
+            m_aFreeInstances.push_back(uInstanceIdx);
+        }
+        m_aDirtyInstances.push_back(uInstanceIdx);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::ReserveInstances
+
+      Summary:  Makes the instance buffer hold at least a number of
+                instances when it is created, so appended instances do
+                not recreate it
+
+      Args:     UINT uNumInstances
+                  Number of instances
+
+      Modifies: [m_uInstanceCapacity].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::ReserveInstances(_In_ UINT uNumInstances)
+    {
+        m_uInstanceCapacity = uNumInstances > m_uInstanceCapacity ? uNumInstances : m_uInstanceCapacity;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::SetInstance
+
+      Summary:  Updates the instance of the cell of an instance, or adds
+                it in a free slot or at the end
+
+      Args:     const VoxelInstanceData& instance
+                  Packed instance with the cell, the block type and the
+                  visible faces
+
+      Modifies: [m_aVoxelInstanceData, m_appendedInstances,
+                 m_aFreeInstances, m_aDirtyInstances].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::SetInstance(_In_ const VoxelInstanceData& instance)
+    {
+        UINT uInstanceIdx = 0u;
+        if (findInstance(instance.X, instance.Y, instance.Z, uInstanceIdx))
+        {
+            VoxelInstanceData& current = m_aVoxelInstanceData[uInstanceIdx];
+            if (current.BlockType == instance.BlockType && current.FaceMask == instance.FaceMask
+                && current.AmbientOcclusion[0] == instance.AmbientOcclusion[0] && current.AmbientOcclusion[1] == instance.AmbientOcclusion[1]
+                && current.Light[0] == instance.Light[0] && current.Light[1] == instance.Light[1])
+            {
+                return;
+            }
+            current = instance;
+        }
+        else
+        {
+            if (m_aFreeInstances.empty())
+            {
+                uInstanceIdx = static_cast<UINT>(m_aVoxelInstanceData.size());
+                m_aVoxelInstanceData.push_back(instance);
+            }
+            else
+            {
+                uInstanceIdx = m_aFreeInstances.back();
+                m_aFreeInstances.pop_back();
+                m_aVoxelInstanceData[uInstanceIdx] = instance;
+            }
+            m_appendedInstances[getInstanceKey(instance.X, instance.Y, instance.Z)] = uInstanceIdx;
+        }
+        m_aDirtyInstances.push_back(uInstanceIdx);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::UploadInstances
+
+      Summary:  Copies the instances edited since the last upload into
+                the instance buffer through an upload ring, one copy per
+                range of nearby dirty instances. The buffer is recreated
+                with room to spare once the appended instances no longer
+                fit.
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to recreate the buffer
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to copy with
+                UploadRing& uploadRing
+                  Ring the instances are copied through
+
+      Modifies: [m_instanceBuffer, m_uInstanceCapacity, m_aDirtyInstances].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Voxel::UploadInstances(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_ UploadRing& uploadRing)
+    {
+        if (m_aDirtyInstances.empty())
+        {
+            return S_OK;
+        }
+
+        // Initialize uploads every instance
+        if (!m_instanceBuffer)
+        {
+            m_aDirtyInstances.clear();
+            return S_OK;
+        }
+
+        UINT uNumInstances = GetNumInstances();
+        if (uNumInstances > m_uInstanceBufferCapacity)
+        {
+            m_uInstanceCapacity = uNumInstances + uNumInstances / 2u;
+            m_instanceBuffer.Reset();
+            m_aDirtyInstances.clear();
+            return initializeInstance(pDevice);
+        }
+
+        std::sort(m_aDirtyInstances.begin(), m_aDirtyInstances.end());
+        m_aDirtyInstances.erase(std::unique(m_aDirtyInstances.begin(), m_aDirtyInstances.end()), m_aDirtyInstances.end());
+
+        size_t uFirstIdx = 0u;
+        while (uFirstIdx < m_aDirtyInstances.size())
+        {
+            size_t uLastIdx = uFirstIdx;
+            while (uLastIdx + 1u < m_aDirtyInstances.size() && m_aDirtyInstances[uLastIdx + 1u] - m_aDirtyInstances[uLastIdx] <= MAX_DIRTY_GAP)
+            {
+                ++uLastIdx;
+            }
+
+            UINT uBeginInstance = m_aDirtyInstances[uFirstIdx];
+            UINT uEndInstance = m_aDirtyInstances[uLastIdx] + 1u;
+            HRESULT hr = uploadRing.Upload(
+                pImmediateContext,
+                m_instanceBuffer.Get(),
+                uBeginInstance * GetInstanceStride(),
+                &m_aVoxelInstanceData[uBeginInstance],
+                (uEndInstance - uBeginInstance) * GetInstanceStride()
+            );
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            uFirstIdx = uLastIdx + 1u;
+        }
+        m_aDirtyInstances.clear();
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetInstance
+
+      Summary:  Returns a packed instance, removed instances are left
+                without faces
+
+      Args:     UINT uInstanceIdx
+                  Index of the instance, below GetNumInstances
+
+      Returns:  const VoxelInstanceData&
+                  Packed instance
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const VoxelInstanceData& Voxel::GetInstance(_In_ UINT uInstanceIdx) const
+    {
+        return m_aVoxelInstanceData[uInstanceIdx];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetNumInstances
+
+      Summary:  Returns the number of packed instances
+
+      Returns:  UINT
+                  Number of instances
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    UINT Voxel::GetNumInstances() const
+    {
+        return static_cast<UINT>(m_aVoxelInstanceData.size());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::GetInstanceStride
+
+      Summary:  Returns the size of one packed instance
+
+      Returns:  UINT
+                  Stride of the instance buffer in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    UINT Voxel::GetInstanceStride() const
+    {
+        return sizeof(VoxelInstanceData);
+    }
+
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   Voxel::GetNumVertices
 
@@ -169,4 +722,183 @@ namespace library
     {
         return INDICES;
     }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::getInstanceData
+
+      Summary:  Returns the pointer to the packed instance data
+
+      Returns:  const void*
+                  Pointer to the VoxelInstanceData array
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    const void* Voxel::getInstanceData() const
+    {
+        return m_aVoxelInstanceData.data();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::initializeInstance
+
+      Summary:  Creates an instance buffer of the reserved number of
+                instances, the spare slots are instances without faces
+
+      Args:     ID3D11Device* pDevice
+                  Pointer to a Direct3D 11 device
+
+      Modifies: [m_instanceBuffer, m_uInstanceBufferCapacity].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT Voxel::initializeInstance(_In_ ID3D11Device* pDevice)
+    {
+        UINT uNumInstances = GetNumInstances();
+        UINT uCapacity = m_uInstanceCapacity > uNumInstances ? m_uInstanceCapacity : uNumInstances;
+
+        std::vector<VoxelInstanceData> aSpareInstanceData;
+        const void* pInitialData = getInstanceData();
+        if (uCapacity > uNumInstances)
+        {
+            aSpareInstanceData.reserve(uCapacity);
+            aSpareInstanceData.assign(m_aVoxelInstanceData.begin(), m_aVoxelInstanceData.end());
+            aSpareInstanceData.resize(uCapacity, VoxelInstanceData());
+            pInitialData = aSpareInstanceData.data();
+        }
+
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = GetInstanceStride() * uCapacity,
+            .Usage = D3D11_USAGE_DEFAULT,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = 0
+        };
+
+        D3D11_SUBRESOURCE_DATA initData =
+        {
+            .pSysMem = pInitialData
+        };
+
+        HRESULT hr = pDevice->CreateBuffer(&bd, &initData, m_instanceBuffer.ReleaseAndGetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        m_uInstanceBufferCapacity = uCapacity;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::getInstanceKey
+
+      Summary:  Returns the key of a cell in the appended instances
+
+      Args:     INT16 x
+                  Cell along the x-axis
+                INT16 y
+                  Cell along the y-axis
+                INT16 z
+                  Cell along the z-axis
+
+      Returns:  UINT64
+                  Key
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 Voxel::getInstanceKey(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z)
+    {
+        return (static_cast<UINT64>(static_cast<UINT16>(z)) << 32u) | (static_cast<UINT64>(static_cast<UINT16>(x)) << 16u) | static_cast<UINT16>(y);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::isCellBefore
+
+      Summary:  Orders instances by cell the way BuildInstanceData emits
+                them, by z, then x, then y
+
+      Args:     const VoxelInstanceData& a
+                  First instance
+                const VoxelInstanceData& b
+                  Second instance
+
+      Returns:  BOOL
+                  TRUE if the cell of a comes before the cell of b
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Voxel::isCellBefore(_In_ const VoxelInstanceData& a, _In_ const VoxelInstanceData& b)
+    {
+        if (a.Z != b.Z)
+        {
+            return a.Z < b.Z;
+        }
+        if (a.X != b.X)
+        {
+            return a.X < b.X;
+        }
+        return a.Y < b.Y;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::findInstance
+
+      Summary:  Finds the instance of a cell, removed instances of the
+                sorted instances are still found
+
+      Args:     INT16 x
+                  Cell along the x-axis
+                INT16 y
+                  Cell along the y-axis
+                INT16 z
+                  Cell along the z-axis
+                UINT& outInstanceIdx
+                  Index of the instance
+
+      Returns:  BOOL
+                  TRUE if the cell has an instance
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL Voxel::findInstance(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z, _Out_ UINT& outInstanceIdx) const
+    {
+        outInstanceIdx = 0u;
+
+        VoxelInstanceData cell = { .X = x, .Y = y, .Z = z };
+        auto sortedEnd = m_aVoxelInstanceData.begin() + m_uNumSortedInstances;
+        auto it = std::lower_bound(m_aVoxelInstanceData.begin(), sortedEnd, cell, isCellBefore);
+        if (it != sortedEnd && it->X == x && it->Y == y && it->Z == z)
+        {
+            outInstanceIdx = static_cast<UINT>(it - m_aVoxelInstanceData.begin());
+            return TRUE;
+        }
+
+        auto appended = m_appendedInstances.find(getInstanceKey(x, y, z));
+        if (appended != m_appendedInstances.end())
+        {
+            outInstanceIdx = appended->second;
+            return TRUE;
+        }
+
+        return FALSE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   Voxel::resetEdits
+
+      Summary:  Forgets the edits after the instance data is replaced.
+                The longest sorted prefix of the instances is searched
+                with a binary search, the rest is hashed.
+
+      Modifies: [m_uNumSortedInstances, m_appendedInstances,
+                 m_aFreeInstances, m_aDirtyInstances].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void Voxel::resetEdits()
+    {
+        auto sortedEnd = std::is_sorted_until(m_aVoxelInstanceData.begin(), m_aVoxelInstanceData.end(), isCellBefore);
+        m_uNumSortedInstances = static_cast<UINT>(sortedEnd - m_aVoxelInstanceData.begin());
+
+        m_appendedInstances.clear();
+        m_aFreeInstances.clear();
+        m_aDirtyInstances.clear();
+        for (UINT uInstanceIdx = m_uNumSortedInstances; uInstanceIdx < GetNumInstances(); ++uInstanceIdx)
+        {
+            const VoxelInstanceData& instance = m_aVoxelInstanceData[uInstanceIdx];
+            m_appendedInstances[getInstanceKey(instance.X, instance.Y, instance.Z)] = uInstanceIdx;
+        }
+    }
 }
\ No newline at end of file
@@ -15,15 +15,61 @@
 
 #include "Renderer/DataTypes.h"
 #include "Renderer/InstancedRenderable.h"
+#include "Renderer/UploadRing.h"
+#include "Scene/TerrainData.h"
+#include "Thread/ThreadPool.h"
 
 namespace library
 {
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    Voxel
 
-      Summary:  Base class for renderable 3d cube object
-
-      Methods:  Voxel
+      Summary:  Base class for renderable 3d cube object. Instances are
+                packed VoxelInstanceData on the integer grid, the world
+                matrix places the grid in the scene.
+
+                Instances can be edited one by one after the voxel is
+                initialized. The instances in the order of
+                BuildInstanceData are found with a binary search and
+                removed ones are left as holes without faces, instances
+                of new cells are appended and found through a hash map.
+                Edited instances are marked dirty and UploadInstances
+                copies only the dirty ranges into the instance buffer.
+
+                The faces and the ambient occlusion of a block are
+                derived from a mask of the solid cells of its 3x3x3
+                neighbourhood, see GetNeighbourBit.
+
+      Methods:  BuildInstanceData
+                  Builds the packed instances of a region of a terrain
+                BakeAmbientOcclusion
+                  Sets the corner occlusion of the faces of an instance
+                CreatePaletteBuffer
+                  Creates the constant buffer of the block type colors
+                GetFaceMask
+                  Returns the exposed faces of a neighbourhood
+                GetNeighbourBit
+                  Returns the bit of a cell of a neighbourhood mask
+                RemoveInstance
+                  Removes the instance of a cell
+                ReserveInstances
+                  Reserves room in the instance buffer for appended
+                  instances
+                SetInstance
+                  Adds or updates the instance of a cell
+                SetVoxelInstanceData
+                  Sets the packed instance data
+                UploadInstances
+                  Copies the dirty instances into the instance buffer
+                GetInstance
+                  Returns a packed instance
+                GetNumInstances
+                  Returns the number of packed instances
+                GetInstanceStride
+                  Returns the size of one packed instance in bytes
+                getInstanceData
+                  Returns the pointer to the packed instance data
+                Voxel
                   Constructor.
                 ~Voxel
                   Destructor.
@@ -31,23 +77,59 @@ namespace library
     class Voxel : public InstancedRenderable
     {
     public:
+        static void BuildInstanceData(_In_ const TerrainData& terrain, _In_ UINT uBeginX, _In_ UINT uBeginZ, _In_ UINT uWidth, _In_ UINT uDepth, _Out_ std::vector<VoxelInstanceData>& aOutInstanceData, _In_opt_ ThreadPool* pThreadPool = nullptr);
+        static void BakeAmbientOcclusion(_In_ UINT uNeighbourMask, _Inout_ VoxelInstanceData& instance);
+        static HRESULT CreatePaletteBuffer(_In_ ID3D11Device* pDevice, _In_ const std::vector<XMFLOAT4>& aColors, _Out_ ComPtr<ID3D11Buffer>& outPaletteBuffer);
+        static BYTE GetFaceMask(_In_ UINT uNeighbourMask);
+        static UINT GetNeighbourBit(_In_ INT dx, _In_ INT dy, _In_ INT dz);
+
         Voxel(_In_ const XMFLOAT4& outputColor);
-        Voxel(_In_ std::vector<InstanceData>&& aInstanceData, _In_ const XMFLOAT4& outputColor);
+        Voxel(_In_ std::vector<VoxelInstanceData>&& aInstanceData, _In_ const XMFLOAT4& outputColor);
         Voxel(const Voxel& other) = delete;
         Voxel(Voxel&& other) = delete;
         Voxel& operator=(const Voxel& other) = delete;
         Voxel& operator=(Voxel&& other) = delete;
         ~Voxel() = default;
 
-        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext) override;
+        virtual HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry) override;
         virtual void Update(_In_ FLOAT deltaTime) override;
 
+        void RemoveInstance(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z);
+        void ReserveInstances(_In_ UINT uNumInstances);
+        void SetInstance(_In_ const VoxelInstanceData& instance);
+        void SetVoxelInstanceData(_In_ std::vector<VoxelInstanceData>&& aInstanceData);
+        HRESULT UploadInstances(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_ UploadRing& uploadRing);
+
+        const VoxelInstanceData& GetInstance(_In_ UINT uInstanceIdx) const;
+        UINT GetNumInstances() const override;
+        UINT GetInstanceStride() const override;
+
         UINT GetNumVertices() const override;
         UINT GetNumIndices() const override;
 
+        // Bits of VoxelInstanceData::FaceMask, in the face order of VERTICES
+        static constexpr const BYTE FACE_POSITIVE_Y = 0x01;
+        static constexpr const BYTE FACE_NEGATIVE_Y = 0x02;
+        static constexpr const BYTE FACE_NEGATIVE_X = 0x04;
+        static constexpr const BYTE FACE_POSITIVE_X = 0x08;
+        static constexpr const BYTE FACE_NEGATIVE_Z = 0x10;
+        static constexpr const BYTE FACE_POSITIVE_Z = 0x20;
+        static constexpr const BYTE FACE_ALL = 0x3F;
+
+        // Rows of a terrain built per task of BuildInstanceData
+        static constexpr const UINT NUM_ROWS_PER_TASK = 8u;
+
     protected:
         const SimpleVertex* getVertices() const override;
         const WORD* getIndices() const override;
+        const void* getInstanceData() const override;
+        HRESULT initializeInstance(_In_ ID3D11Device* pDevice) override;
+
+        static UINT64 getInstanceKey(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z);
+        static BOOL isCellBefore(_In_ const VoxelInstanceData& a, _In_ const VoxelInstanceData& b);
+
+        BOOL findInstance(_In_ INT16 x, _In_ INT16 y, _In_ INT16 z, _Out_ UINT& outInstanceIdx) const;
+        void resetEdits();
 
         static constexpr const SimpleVertex VERTICES[] =
         {
@@ -103,5 +185,17 @@ namespace library
             23,20,22
         };
         static constexpr const UINT NUM_INDICES = 36u;
+
+        // Dirty instances at most this far apart are uploaded as one range
+        static constexpr const UINT MAX_DIRTY_GAP = 8u;
+
+    protected:
+        std::vector<VoxelInstanceData> m_aVoxelInstanceData;
+        UINT m_uNumSortedInstances;
+        UINT m_uInstanceCapacity;
+        UINT m_uInstanceBufferCapacity;
+        std::unordered_map<UINT64, UINT> m_appendedInstances;
+        std::vector<UINT> m_aFreeInstances;
+        std::vector<UINT> m_aDirtyInstances;
     };
 }
\ No newline at end of file
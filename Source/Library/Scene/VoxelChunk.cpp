@@ -0,0 +1,386 @@
+#include "Scene/VoxelChunk.h"
+
+#include <algorithm>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::VoxelChunk
+
+      Summary:  Constructor. The chunk counts as requested from here on.
+
+      Args:     INT x
+                  Chunk coordinate along the x-axis, in chunks of the
+                  level
+                INT z
+                  Chunk coordinate along the z-axis, in chunks of the
+                  level
+                UINT uLevel
+                  Level of detail, at most MAX_LEVEL
+
+      Modifies: [m_x, m_z, m_uLevel, m_state, m_uLastUsedFrame, m_uMemoryUsage,
+                 m_uMaxColumnHeight, m_aOccluderHeights, m_requestTime, m_generationLatency,
+                 m_aInstanceData, m_voxels].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelChunk::VoxelChunk(_In_ INT x, _In_ INT z, _In_ UINT uLevel)
+        : m_x(x)
+        , m_z(z)
+        , m_uLevel(uLevel < MAX_LEVEL ? uLevel : MAX_LEVEL)
+        , m_state(eChunkState::GENERATING)
+        , m_uLastUsedFrame(0u)
+        , m_uMemoryUsage(0u)
+        , m_uMaxColumnHeight(0u)
+        , m_aOccluderHeights()
+        , m_requestTime(std::chrono::steady_clock::now())
+        , m_generationLatency(0.0f)
+        , m_aInstanceData()
+        , m_voxels()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::Generate
+
+      Summary:  Generates the columns of the chunk and builds the packed
+                instances. Safe to call on a worker thread. The state
+                is left GENERATING, the VoxelWorld marks the chunk
+                GENERATED on the rendering thread once it has collected
+                it, since the rendering thread reads the state of every
+                chunk while workers generate.
+
+                Level 0 chunks are generated with a one cell border so
+                the faces against the neighbouring chunks are culled
+                the same way as inside the chunk. Coarser chunks are
+                generated at full resolution and downsampled, without a
+                border.
+
+      Args:     const TerrainGenerator& generator
+                  Generator of the map
+                UINT uHeight
+                  Number of voxels of a full column
+                UINT uOriginX
+                  Map cell of the first column along the x-axis, at
+                  least 1 for level 0
+                UINT uOriginZ
+                  Map cell of the first column along the z-axis, at
+                  least 1 for level 0
+
+      Modifies: [m_uMemoryUsage, m_uMaxColumnHeight, m_aOccluderHeights,
+                 m_generationLatency, m_aInstanceData].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelChunk::Generate(_In_ const TerrainGenerator& generator, _In_ UINT uHeight, _In_ UINT uOriginX, _In_ UINT uOriginZ)
+    {
+        TerrainData terrain;
+        if (m_uLevel == 0u)
+        {
+            if (uOriginX < 1u || uOriginZ < 1u)
+            {
+                return E_INVALIDARG;
+            }
+
+            HRESULT hr = generator.GenerateRegion(uOriginX - 1u, uOriginZ - 1u, SIZE + 2u, uHeight, SIZE + 2u, terrain);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            Voxel::BuildInstanceData(terrain, 1u, 1u, SIZE, SIZE, m_aInstanceData);
+        }
+        else
+        {
+            TerrainData fineTerrain;
+            HRESULT hr = generator.GenerateRegion(uOriginX, uOriginZ, SIZE << m_uLevel, uHeight, SIZE << m_uLevel, fineTerrain);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            hr = DownsampleTerrainData(fineTerrain, 1u << m_uLevel, terrain);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            Voxel::BuildInstanceData(terrain, 0u, 0u, SIZE, SIZE, m_aInstanceData);
+        }
+
+        // Column heights in level 0 blocks, the same rounding as Voxel::BuildInstanceData
+        constexpr const UINT TILE_SIZE = SIZE / NUM_OCCLUDER_TILES;
+        UINT uBegin = m_uLevel == 0u ? 1u : 0u;
+        m_uMaxColumnHeight = 0u;
+        std::fill(m_aOccluderHeights, m_aOccluderHeights + NUM_OCCLUDER_TILES * NUM_OCCLUDER_TILES, UINT_MAX);
+        for (UINT uDepthIdx = 0u; uDepthIdx < SIZE && uBegin + uDepthIdx < terrain.uDepth; ++uDepthIdx)
+        {
+            for (UINT uWidthIdx = 0u; uWidthIdx < SIZE && uBegin + uWidthIdx < terrain.uWidth; ++uWidthIdx)
+            {
+                FLOAT height = terrain.aHeights[static_cast<size_t>(uBegin + uDepthIdx) * terrain.uWidth + uBegin + uWidthIdx];
+                UINT uColumnHeight = static_cast<UINT>(static_cast<FLOAT>(terrain.uHeight) * height) << m_uLevel;
+                UINT& uOccluderHeight = m_aOccluderHeights[(uDepthIdx / TILE_SIZE) * NUM_OCCLUDER_TILES + uWidthIdx / TILE_SIZE];
+                uOccluderHeight = uColumnHeight < uOccluderHeight ? uColumnHeight : uOccluderHeight;
+                m_uMaxColumnHeight = uColumnHeight > m_uMaxColumnHeight ? uColumnHeight : m_uMaxColumnHeight;
+            }
+        }
+        for (UINT& uOccluderHeight : m_aOccluderHeights)
+        {
+            uOccluderHeight = uOccluderHeight < m_uMaxColumnHeight ? uOccluderHeight : m_uMaxColumnHeight;
+        }
+
+        m_uMemoryUsage = m_aInstanceData.size() * sizeof(VoxelInstanceData);
+
+        m_generationLatency = std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - m_requestTime).count();
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::Upload
+
+      Summary:  Creates one voxel for the blocks of every type, if the
+                chunk has any, and initializes its buffers. The colors
+                of the blocks come from the palette bound by the
+                renderer. Without a device the voxel is created but not
+                initialized, which lets the streaming run headless.
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers, optional
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers, optional
+                GeometryRegistry* pGeometryRegistry
+                  Shared buffers of the device, optional
+                FXMVECTOR offset
+                  World position of the center of the first fine block
+                  of the chunk
+                const std::shared_ptr<VertexShader>& vertexShader
+                  Vertex shader of the voxels
+                const std::shared_ptr<PixelShader>& pixelShader
+                  Pixel shader of the voxels
+                const std::shared_ptr<Material>& material
+                  Material of the voxels, optional
+
+      Modifies: [m_state, m_aInstanceData, m_voxels].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelChunk::Upload(_In_opt_ ID3D11Device* pDevice, _In_opt_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry, _In_ FXMVECTOR offset, _In_ const std::shared_ptr<VertexShader>& vertexShader, _In_ const std::shared_ptr<PixelShader>& pixelShader, _In_ const std::shared_ptr<Material>& material)
+    {
+        if (m_state != eChunkState::GENERATED)
+        {
+            return E_FAIL;
+        }
+
+        // A coarse block of scale s spans s fine blocks, so its center is s - 1 units past the first fine center
+        FLOAT scale = static_cast<FLOAT>(1u << m_uLevel);
+        XMVECTOR coarseOffset = offset + XMVectorReplicate(scale - 1.0f);
+
+        if (!m_aInstanceData.empty())
+        {
+            std::shared_ptr<Voxel> voxel = std::make_shared<Voxel>(std::move(m_aInstanceData), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+            voxel->Scale(scale, scale, scale);
+            voxel->Translate(coarseOffset);
+            if (vertexShader)
+            {
+                voxel->SetVertexShader(vertexShader);
+            }
+            if (pixelShader)
+            {
+                voxel->SetPixelShader(pixelShader);
+            }
+            if (material)
+            {
+                voxel->AddMaterial(material);
+            }
+
+            if (pDevice)
+            {
+                HRESULT hr = voxel->Initialize(pDevice, pImmediateContext, pGeometryRegistry);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+            }
+
+            m_voxels.push_back(voxel);
+        }
+        m_aInstanceData.clear();
+
+        m_state = eChunkState::RESIDENT;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetGenerationLatency
+
+      Summary:  Returns the time from the request of the chunk to the
+                end of Generate, including the time spent in the queue
+
+      Returns:  FLOAT
+                  Latency in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT VoxelChunk::GetGenerationLatency() const
+    {
+        return m_generationLatency;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetLastUsedFrame
+
+      Summary:  Returns the last frame the chunk was in view
+
+      Returns:  UINT64
+                  Frame index
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 VoxelChunk::GetLastUsedFrame() const
+    {
+        return m_uLastUsedFrame;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetLevel
+
+      Summary:  Returns the level of detail of the chunk
+
+      Returns:  UINT
+                  Level of detail, the blocks are 1 << level wide
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelChunk::GetLevel() const
+    {
+        return m_uLevel;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetMaxColumnHeight
+
+      Summary:  Returns the height of the tallest column, valid once
+                generated
+
+      Returns:  UINT
+                  Number of level 0 blocks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelChunk::GetMaxColumnHeight() const
+    {
+        return m_uMaxColumnHeight;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetMemoryUsage
+
+      Summary:  Returns the size of the packed instances of the chunk
+
+      Returns:  size_t
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    size_t VoxelChunk::GetMemoryUsage() const
+    {
+        return m_uMemoryUsage;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetOccluderHeight
+
+      Summary:  Returns the height of the shortest column of a tile of
+                SIZE / NUM_OCCLUDER_TILES columns, valid once generated.
+                Everything behind the tile and below that height is
+                hidden from an eye above it.
+
+      Args:     UINT uTileX
+                  Tile index along the x-axis
+                UINT uTileZ
+                  Tile index along the z-axis
+
+      Returns:  UINT
+                  Number of level 0 blocks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelChunk::GetOccluderHeight(_In_ UINT uTileX, _In_ UINT uTileZ) const
+    {
+        return m_aOccluderHeights[uTileZ * NUM_OCCLUDER_TILES + uTileX];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetState
+
+      Summary:  Returns the state of the chunk
+
+      Returns:  eChunkState
+                  State of the chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eChunkState VoxelChunk::GetState() const
+    {
+        return m_state;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetVoxels
+
+      Summary:  Returns the voxels of the chunk, at most one, empty
+                until uploaded
+
+      Returns:  std::vector<std::shared_ptr<Voxel>>&
+                  Voxels
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::vector<std::shared_ptr<Voxel>>& VoxelChunk::GetVoxels()
+    {
+        return m_voxels;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetX
+
+      Summary:  Returns the chunk coordinate along the x-axis
+
+      Returns:  INT
+                  Chunk coordinate
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    INT VoxelChunk::GetX() const
+    {
+        return m_x;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::GetZ
+
+      Summary:  Returns the chunk coordinate along the z-axis
+
+      Returns:  INT
+                  Chunk coordinate
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    INT VoxelChunk::GetZ() const
+    {
+        return m_z;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::SetLastUsedFrame
+
+      Summary:  Marks the chunk as in view in a frame
+
+      Args:     UINT64 uFrameIdx
+                  Frame index
+
+      Modifies: [m_uLastUsedFrame].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelChunk::SetLastUsedFrame(_In_ UINT64 uFrameIdx)
+    {
+        m_uLastUsedFrame = uFrameIdx;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelChunk::SetState
+
+      Summary:  Sets the state of the chunk, only on the rendering
+                thread
+
+      Args:     eChunkState state
+                  New state
+
+      Modifies: [m_state].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelChunk::SetState(_In_ eChunkState state)
+    {
+        m_state = state;
+    }
+}
@@ -0,0 +1,137 @@
+/*+===================================================================
+  File:      VOXELCHUNK.H
+
+  Summary:   VoxelChunk header file contains declarations of the
+             VoxelChunk class, a square block of terrain columns that
+             is generated, uploaded and evicted as a unit by the
+             VoxelWorld.
+
+  Classes: VoxelChunk
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+
+#include "Scene/TerrainGenerator.h"
+#include "Scene/Voxel.h"
+#include "Shader/PixelShader.h"
+#include "Shader/VertexShader.h"
+#include "Texture/Material.h"
+
+namespace library
+{
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eChunkState
+
+        Summary:  Enumeration of the life cycle of a chunk
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eChunkState : BYTE
+    {
+        GENERATING,
+        GENERATED,
+        RESIDENT,
+        COUNT,
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelChunk
+
+      Summary:  SIZE x SIZE terrain columns at chunk coordinates (x, z).
+                Generate runs on a worker thread and only touches CPU
+                memory, Upload creates one Voxel for all block types on
+                the rendering thread.
+
+                A chunk of level L covers SIZE << L cells along each
+                axis with SIZE x SIZE columns of (1 << L)-block cubes,
+                downsampled with DownsampleTerrainData, so every level
+                costs about the same number of instances. Coarse chunks
+                keep the side faces on their edges, which closes the
+                gaps against finer neighbours.
+
+      Methods:  Generate
+                  Generates the terrain and the packed instances
+                Upload
+                  Creates the voxel of the chunk
+                GetGenerationLatency
+                  Returns the time from the request to the end of
+                  Generate
+                GetLastUsedFrame
+                  Returns the last frame the chunk was in view
+                GetLevel
+                  Returns the level of detail
+                GetMaxColumnHeight
+                  Returns the number of blocks of the tallest column
+                GetMemoryUsage
+                  Returns the size of the instance data in bytes
+                GetOccluderHeight
+                  Returns the number of blocks of the shortest column
+                  of an occluder tile
+                GetState
+                  Returns the state of the chunk
+                GetVoxels
+                  Returns the voxels of the chunk
+                GetX
+                  Returns the chunk coordinate along the x-axis
+                GetZ
+                  Returns the chunk coordinate along the z-axis
+                SetLastUsedFrame
+                  Marks the chunk as in view in a frame
+                SetState
+                  Sets the state of the chunk
+                VoxelChunk
+                  Constructor.
+                ~VoxelChunk
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelChunk
+    {
+    public:
+        static constexpr const UINT SIZE = 32u;
+        static constexpr const UINT MAX_LEVEL = 3u;
+        static constexpr const UINT NUM_OCCLUDER_TILES = 4u;
+
+    public:
+        VoxelChunk() = delete;
+        VoxelChunk(_In_ INT x, _In_ INT z, _In_ UINT uLevel = 0u);
+        VoxelChunk(const VoxelChunk& other) = delete;
+        VoxelChunk(VoxelChunk&& other) = delete;
+        VoxelChunk& operator=(const VoxelChunk& other) = delete;
+        VoxelChunk& operator=(VoxelChunk&& other) = delete;
+        ~VoxelChunk() = default;
+
+        HRESULT Generate(_In_ const TerrainGenerator& generator, _In_ UINT uHeight, _In_ UINT uOriginX, _In_ UINT uOriginZ);
+        HRESULT Upload(_In_opt_ ID3D11Device* pDevice, _In_opt_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry, _In_ FXMVECTOR offset, _In_ const std::shared_ptr<VertexShader>& vertexShader, _In_ const std::shared_ptr<PixelShader>& pixelShader, _In_ const std::shared_ptr<Material>& material);
+
+        FLOAT GetGenerationLatency() const;
+        UINT64 GetLastUsedFrame() const;
+        UINT GetLevel() const;
+        UINT GetMaxColumnHeight() const;
+        size_t GetMemoryUsage() const;
+        UINT GetOccluderHeight(_In_ UINT uTileX, _In_ UINT uTileZ) const;
+        eChunkState GetState() const;
+        std::vector<std::shared_ptr<Voxel>>& GetVoxels();
+        INT GetX() const;
+        INT GetZ() const;
+
+        void SetLastUsedFrame(_In_ UINT64 uFrameIdx);
+        void SetState(_In_ eChunkState state);
+
+    private:
+        INT m_x;
+        INT m_z;
+        UINT m_uLevel;
+        eChunkState m_state;
+        UINT64 m_uLastUsedFrame;
+        size_t m_uMemoryUsage;
+        UINT m_uMaxColumnHeight;
+        UINT m_aOccluderHeights[NUM_OCCLUDER_TILES * NUM_OCCLUDER_TILES];
+        std::chrono::steady_clock::time_point m_requestTime;
+        FLOAT m_generationLatency;
+        std::vector<VoxelInstanceData> m_aInstanceData;
+        std::vector<std::shared_ptr<Voxel>> m_voxels;
+    };
+}
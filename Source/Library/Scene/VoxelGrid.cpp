@@ -0,0 +1,874 @@
+#include "Scene/VoxelGrid.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "Scene/Voxel.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::VoxelGrid
+
+      Summary:  Constructor of an empty grid
+
+      Modifies: [m_uWidth, m_uHeight, m_uDepth, m_uNumChunksX,
+                 m_uNumChunksY, m_uNumChunksZ, m_uNumAllocatedChunks,
+                 m_aChunks, m_aDirtyChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelGrid::VoxelGrid()
+        : m_uWidth(0u)
+        , m_uHeight(0u)
+        , m_uDepth(0u)
+        , m_uNumChunksX(0u)
+        , m_uNumChunksY(0u)
+        , m_uNumChunksZ(0u)
+        , m_uNumAllocatedChunks(0u)
+        , m_aChunks()
+        , m_aDirtyChunks()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::Initialize
+
+      Summary:  Resizes the grid and clears every cell to air
+
+      Args:     UINT uWidth
+                  Number of cells along the x-axis
+                UINT uHeight
+                  Number of cells along the y-axis
+                UINT uDepth
+                  Number of cells along the z-axis
+
+      Modifies: [m_uWidth, m_uHeight, m_uDepth, m_uNumChunksX,
+                 m_uNumChunksY, m_uNumChunksZ, m_uNumAllocatedChunks,
+                 m_aChunks, m_aDirtyChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::Initialize(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth)
+    {
+        m_uWidth = uWidth;
+        m_uHeight = uHeight;
+        m_uDepth = uDepth;
+        m_uNumChunksX = (uWidth + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+        m_uNumChunksY = (uHeight + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+        m_uNumChunksZ = (uDepth + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+        m_uNumAllocatedChunks = 0u;
+
+        m_aChunks.clear();
+        m_aChunks.resize(static_cast<size_t>(m_uNumChunksX) * m_uNumChunksY * m_uNumChunksZ);
+        m_aDirtyChunks.assign(m_aChunks.size(), FALSE);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::FillTerrain
+
+      Summary:  Resizes the grid to a terrain and fills its columns with
+                the block type of their cell, with the same rounding of
+                the heights as Voxel::BuildInstanceData
+
+      Args:     const TerrainData& terrain
+                  Height and biome grid of the map
+
+      Modifies: [m_uWidth, m_uHeight, m_uDepth, m_uNumChunksX,
+                 m_uNumChunksY, m_uNumChunksZ, m_uNumAllocatedChunks,
+                 m_aChunks, m_aDirtyChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::FillTerrain(_In_ const TerrainData& terrain)
+    {
+        Initialize(terrain.uWidth, terrain.uHeight, terrain.uDepth);
+
+        for (UINT uDepthIdx = 0u; uDepthIdx < terrain.uDepth; ++uDepthIdx)
+        {
+            for (UINT uWidthIdx = 0u; uWidthIdx < terrain.uWidth; ++uWidthIdx)
+            {
+                size_t uCellIdx = static_cast<size_t>(uDepthIdx) * terrain.uWidth + uWidthIdx;
+                UINT uColumnHeight = static_cast<UINT>(static_cast<FLOAT>(terrain.uHeight) * terrain.aHeights[uCellIdx]);
+                uColumnHeight = uColumnHeight < m_uHeight ? uColumnHeight : m_uHeight;
+                eBlockType blockType = terrain.aBlockTypes[uCellIdx];
+
+                // One chunk lookup per CHUNK_SIZE cells of the column
+                for (UINT uHeightIdx = 0u; uHeightIdx < uColumnHeight; uHeightIdx += CHUNK_SIZE)
+                {
+                    eBlockType* pChunk = getChunk(uWidthIdx, uHeightIdx, uDepthIdx);
+                    UINT uEndIdx = uHeightIdx + CHUNK_SIZE < uColumnHeight ? uHeightIdx + CHUNK_SIZE : uColumnHeight;
+                    for (UINT uBlockIdx = uHeightIdx; uBlockIdx < uEndIdx; ++uBlockIdx)
+                    {
+                        pChunk[getCellIndex(uWidthIdx, uBlockIdx, uDepthIdx)] = blockType;
+                    }
+                }
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::ClearDirtyChunk
+
+      Summary:  Marks a chunk as saved, it is dirty again on its next
+                edit
+
+      Args:     const XMUINT3& chunk
+                  Chunk coordinates, inside of the grid
+
+      Modifies: [m_aDirtyChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::ClearDirtyChunk(_In_ const XMUINT3& chunk)
+    {
+        m_aDirtyChunks[getChunkIndex(chunk.x * CHUNK_SIZE, chunk.y * CHUNK_SIZE, chunk.z * CHUNK_SIZE)] = FALSE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetBlock
+
+      Summary:  Returns the block type of a cell
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  eBlockType
+                  Block type, AIR outside of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eBlockType VoxelGrid::GetBlock(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        if (!IsInside(x, y, z))
+        {
+            return eBlockType::AIR;
+        }
+
+        const std::unique_ptr<eBlockType[]>& chunk = m_aChunks[getChunkIndex(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z))];
+        if (!chunk)
+        {
+            return eBlockType::AIR;
+        }
+
+        return chunk[getCellIndex(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z))];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetDirtyChunks
+
+      Summary:  Returns the chunks with cells edited since the chunk
+                was last saved
+
+      Args:     std::vector<XMUINT3>& aOutChunks
+                  Chunk coordinates
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::GetDirtyChunks(_Out_ std::vector<XMUINT3>& aOutChunks) const
+    {
+        aOutChunks.clear();
+        for (size_t uChunkIdx = 0u; uChunkIdx < m_aDirtyChunks.size(); ++uChunkIdx)
+        {
+            if (m_aDirtyChunks[uChunkIdx])
+            {
+                aOutChunks.push_back(
+                    XMUINT3(
+                        static_cast<UINT>(uChunkIdx % m_uNumChunksX),
+                        static_cast<UINT>(uChunkIdx / (static_cast<size_t>(m_uNumChunksX) * m_uNumChunksZ)),
+                        static_cast<UINT>((uChunkIdx / m_uNumChunksX) % m_uNumChunksZ)
+                    )
+                );
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetFaceMask
+
+      Summary:  Returns the faces of a block that are not covered by a
+                neighbouring block, the faces on the edges of the grid
+                are exposed
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BYTE
+                  Voxel::FACE_* bits, 0 for air
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelGrid::GetFaceMask(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        if (!IsSolid(x, y, z))
+        {
+            return 0u;
+        }
+
+        BYTE faceMask = 0u;
+        faceMask |= IsSolid(x, y + 1, z) ? 0u : Voxel::FACE_POSITIVE_Y;
+        faceMask |= IsSolid(x, y - 1, z) ? 0u : Voxel::FACE_NEGATIVE_Y;
+        faceMask |= IsSolid(x - 1, y, z) ? 0u : Voxel::FACE_NEGATIVE_X;
+        faceMask |= IsSolid(x + 1, y, z) ? 0u : Voxel::FACE_POSITIVE_X;
+        faceMask |= IsSolid(x, y, z - 1) ? 0u : Voxel::FACE_NEGATIVE_Z;
+        faceMask |= IsSolid(x, y, z + 1) ? 0u : Voxel::FACE_POSITIVE_Z;
+
+        return faceMask;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetNeighbourMask
+
+      Summary:  Returns the solid cells of the 3x3x3 neighbourhood of a
+                cell, with the bits of Voxel::GetNeighbourBit
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  UINT
+                  Neighbourhood mask, cells outside of the grid are not
+                  solid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetNeighbourMask(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        UINT uNeighbourMask = 0u;
+        for (INT dy = -1; dy <= 1; ++dy)
+        {
+            for (INT dz = -1; dz <= 1; ++dz)
+            {
+                for (INT dx = -1; dx <= 1; ++dx)
+                {
+                    uNeighbourMask |= IsSolid(x + dx, y + dy, z + dz) ? 1u << Voxel::GetNeighbourBit(dx, dy, dz) : 0u;
+                }
+            }
+        }
+
+        return uNeighbourMask;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetWidth
+
+      Summary:  Returns the number of cells along the x-axis
+
+      Returns:  UINT
+                  Width of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetWidth() const
+    {
+        return m_uWidth;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetHeight
+
+      Summary:  Returns the number of cells along the y-axis
+
+      Returns:  UINT
+                  Height of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetHeight() const
+    {
+        return m_uHeight;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetDepth
+
+      Summary:  Returns the number of cells along the z-axis
+
+      Returns:  UINT
+                  Depth of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetDepth() const
+    {
+        return m_uDepth;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetMemoryUsage
+
+      Summary:  Returns the size of the allocated chunks
+
+      Returns:  size_t
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    size_t VoxelGrid::GetMemoryUsage() const
+    {
+        return m_uNumAllocatedChunks * NUM_CHUNK_CELLS * sizeof(eBlockType);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetNumChunksX
+
+      Summary:  Returns the number of chunks along the x-axis
+
+      Returns:  UINT
+                  Number of chunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetNumChunksX() const
+    {
+        return m_uNumChunksX;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetNumChunksY
+
+      Summary:  Returns the number of chunks along the y-axis
+
+      Returns:  UINT
+                  Number of chunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetNumChunksY() const
+    {
+        return m_uNumChunksY;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::GetNumChunksZ
+
+      Summary:  Returns the number of chunks along the z-axis
+
+      Returns:  UINT
+                  Number of chunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::GetNumChunksZ() const
+    {
+        return m_uNumChunksZ;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::IsInside
+
+      Summary:  Returns whether a cell is inside of the grid
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BOOL
+                  TRUE if the cell is inside
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelGrid::IsInside(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        return static_cast<UINT>(x) < m_uWidth && static_cast<UINT>(y) < m_uHeight && static_cast<UINT>(z) < m_uDepth;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::IsSolid
+
+      Summary:  Returns whether a cell holds a block
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BOOL
+                  TRUE if the cell is not air
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelGrid::IsSolid(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        return GetBlock(x, y, z) != eBlockType::AIR;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::Raycast
+
+      Summary:  Walks the cells along a ray in grid space with the
+                Amanatides-Woo traversal, one cell per step, and stops
+                at the first solid cell. The ray is clipped to the grid
+                first, so the cost depends on the length of the ray
+                inside of the grid and not on the size of the map. The
+                chunk pointer is only looked up when the ray enters
+                another chunk, empty chunks are crossed without reading
+                any block. Safe to call from several threads as long as
+                the grid is not edited meanwhile.
+
+      Args:     const VoxelRay& ray
+                  Ray in grid space
+                VoxelRayHit& outHit
+                  First hit, bHit is FALSE when the ray reaches its
+                  maximum distance or leaves the grid first
+
+      Returns:  BOOL
+                  TRUE if a block was hit
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelGrid::Raycast(_In_ const VoxelRay& ray, _Out_ VoxelRayHit& outHit) const
+    {
+        outHit =
+        {
+            .bHit = FALSE,
+            .BlockType = eBlockType::AIR,
+            .Cell = XMINT3(0, 0, 0),
+            .Normal = XMINT3(0, 0, 0),
+            .Distance = ray.MaxDistance
+        };
+
+        FLOAT length = std::sqrt(ray.Direction.x * ray.Direction.x + ray.Direction.y * ray.Direction.y + ray.Direction.z * ray.Direction.z);
+        if (!(length > 0.0f) || !(ray.MaxDistance >= 0.0f))
+        {
+            return FALSE;
+        }
+
+        const FLOAT aOrigin[3] = { ray.Origin.x, ray.Origin.y, ray.Origin.z };
+        const FLOAT aDirection[3] = { ray.Direction.x / length, ray.Direction.y / length, ray.Direction.z / length };
+        const INT aSize[3] = { static_cast<INT>(m_uWidth), static_cast<INT>(m_uHeight), static_cast<INT>(m_uDepth) };
+
+        // Clip the ray to the box of the grid
+        FLOAT enterDistance = 0.0f;
+        FLOAT exitDistance = ray.MaxDistance;
+        INT enterAxis = -1;
+        for (INT axis = 0; axis < 3; ++axis)
+        {
+            if (aDirection[axis] == 0.0f)
+            {
+                if (aOrigin[axis] < 0.0f || aOrigin[axis] >= static_cast<FLOAT>(aSize[axis]))
+                {
+                    return FALSE;
+                }
+                continue;
+            }
+
+            FLOAT nearDistance = (0.0f - aOrigin[axis]) / aDirection[axis];
+            FLOAT farDistance = (static_cast<FLOAT>(aSize[axis]) - aOrigin[axis]) / aDirection[axis];
+            if (nearDistance > farDistance)
+            {
+                std::swap(nearDistance, farDistance);
+            }
+            if (nearDistance > enterDistance)
+            {
+                enterDistance = nearDistance;
+                enterAxis = axis;
+            }
+            exitDistance = farDistance < exitDistance ? farDistance : exitDistance;
+        }
+        if (enterDistance > exitDistance)
+        {
+            return FALSE;
+        }
+
+        INT aCell[3] = {};
+        INT aStep[3] = {};
+        FLOAT aNextDistance[3] = {};
+        FLOAT aDeltaDistance[3] = {};
+        for (INT axis = 0; axis < 3; ++axis)
+        {
+            // The entry point may round to the wrong side of the grid boundary
+            INT cell = static_cast<INT>(std::floor(aOrigin[axis] + aDirection[axis] * enterDistance));
+            cell = cell > 0 ? cell : 0;
+            cell = cell < aSize[axis] - 1 ? cell : aSize[axis] - 1;
+            if (axis == enterAxis)
+            {
+                cell = aDirection[axis] > 0.0f ? 0 : aSize[axis] - 1;
+            }
+            aCell[axis] = cell;
+
+            if (aDirection[axis] > 0.0f)
+            {
+                aStep[axis] = 1;
+                aNextDistance[axis] = (static_cast<FLOAT>(cell + 1) - aOrigin[axis]) / aDirection[axis];
+                aDeltaDistance[axis] = 1.0f / aDirection[axis];
+            }
+            else if (aDirection[axis] < 0.0f)
+            {
+                aStep[axis] = -1;
+                aNextDistance[axis] = (static_cast<FLOAT>(cell) - aOrigin[axis]) / aDirection[axis];
+                aDeltaDistance[axis] = -1.0f / aDirection[axis];
+            }
+            else
+            {
+                aStep[axis] = 0;
+                aNextDistance[axis] = FLT_MAX;
+                aDeltaDistance[axis] = FLT_MAX;
+            }
+        }
+
+        INT normalAxis = enterAxis;
+        FLOAT distance = enterDistance;
+        size_t uChunkIdx = SIZE_MAX;
+        const eBlockType* pChunk = nullptr;
+        for (;;)
+        {
+            UINT uX = static_cast<UINT>(aCell[0]);
+            UINT uY = static_cast<UINT>(aCell[1]);
+            UINT uZ = static_cast<UINT>(aCell[2]);
+            size_t uCellChunkIdx = getChunkIndex(uX, uY, uZ);
+            if (uCellChunkIdx != uChunkIdx)
+            {
+                uChunkIdx = uCellChunkIdx;
+                pChunk = m_aChunks[uChunkIdx].get();
+            }
+
+            if (pChunk)
+            {
+                eBlockType blockType = pChunk[getCellIndex(uX, uY, uZ)];
+                if (blockType != eBlockType::AIR)
+                {
+                    outHit.bHit = TRUE;
+                    outHit.BlockType = blockType;
+                    outHit.Cell = XMINT3(aCell[0], aCell[1], aCell[2]);
+                    if (normalAxis >= 0)
+                    {
+                        INT aNormal[3] = {};
+                        aNormal[normalAxis] = -aStep[normalAxis];
+                        outHit.Normal = XMINT3(aNormal[0], aNormal[1], aNormal[2]);
+                    }
+                    outHit.Distance = distance;
+                    return TRUE;
+                }
+            }
+
+            // Cross the nearest cell boundary
+            INT axis = aNextDistance[0] < aNextDistance[1] ? (aNextDistance[0] < aNextDistance[2] ? 0 : 2) : (aNextDistance[1] < aNextDistance[2] ? 1 : 2);
+            distance = aNextDistance[axis];
+            aCell[axis] += aStep[axis];
+            if (distance > exitDistance || static_cast<UINT>(aCell[axis]) >= static_cast<UINT>(aSize[axis]))
+            {
+                return FALSE;
+            }
+            aNextDistance[axis] += aDeltaDistance[axis];
+            normalAxis = axis;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::RaycastBatch
+
+      Summary:  Casts many rays, e.g. the line of sight checks of every
+                agent in a frame. The rays are split in tasks of
+                NUM_RAYS_PER_TASK rays that run on the thread pool and
+                the calling thread.
+
+      Args:     const VoxelRay* pRays
+                  Rays in grid space
+                VoxelRayHit* pOutHits
+                  First hit of every ray
+                UINT uNumRays
+                  Number of rays
+                ThreadPool* pThreadPool
+                  Pool to cast the rays on, the rays are cast on the
+                  calling thread if nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::RaycastBatch(_In_reads_(uNumRays) const VoxelRay* pRays, _Out_writes_(uNumRays) VoxelRayHit* pOutHits, _In_ UINT uNumRays, _In_opt_ ThreadPool* pThreadPool) const
+    {
+        UINT uNumTasks = (uNumRays + NUM_RAYS_PER_TASK - 1u) / NUM_RAYS_PER_TASK;
+        auto castTask = [this, pRays, pOutHits, uNumRays](UINT uTaskIdx)
+        {
+            UINT uEndIdx = (uTaskIdx + 1u) * NUM_RAYS_PER_TASK < uNumRays ? (uTaskIdx + 1u) * NUM_RAYS_PER_TASK : uNumRays;
+            for (UINT uRayIdx = uTaskIdx * NUM_RAYS_PER_TASK; uRayIdx < uEndIdx; ++uRayIdx)
+            {
+                Raycast(pRays[uRayIdx], pOutHits[uRayIdx]);
+            }
+        };
+
+        if (pThreadPool && uNumTasks > 1u)
+        {
+            pThreadPool->ParallelFor(uNumTasks, castTask);
+        }
+        else
+        {
+            for (UINT uTaskIdx = 0u; uTaskIdx < uNumTasks; ++uTaskIdx)
+            {
+                castTask(uTaskIdx);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::ReadChunk
+
+      Summary:  Copies the block types of the cells of a chunk, in the
+                order of the cells inside of a chunk with x as the
+                fastest axis. An empty chunk reads as air.
+
+      Args:     const XMUINT3& chunk
+                  Chunk coordinates, inside of the grid
+                eBlockType* pOutBlocks
+                  NUM_CHUNK_CELLS block types
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelGrid::ReadChunk(_In_ const XMUINT3& chunk, _Out_writes_(NUM_CHUNK_CELLS) eBlockType* pOutBlocks) const
+    {
+        const std::unique_ptr<eBlockType[]>& blocks = m_aChunks[getChunkIndex(chunk.x * CHUNK_SIZE, chunk.y * CHUNK_SIZE, chunk.z * CHUNK_SIZE)];
+        if (!blocks)
+        {
+            std::fill_n(pOutBlocks, NUM_CHUNK_CELLS, eBlockType::AIR);
+            return;
+        }
+
+        std::copy_n(blocks.get(), NUM_CHUNK_CELLS, pOutBlocks);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::SweepBox
+
+      Summary:  Moves an axis-aligned box in grid space along the y-axis,
+                then the x-axis, then the z-axis, and stops each move at
+                the first layer of cells with a block in front of the
+                box. Only the cells the box sweeps are read, so the cost
+                grows with the length of the move and the size of the
+                box. Cells the box already overlaps are ignored, so a
+                box stuck in a block can still move out of it. Touching
+                a face is not an overlap, closer than SWEEP_SKIN is.
+
+      Args:     const XMFLOAT3& center
+                  Center of the box in grid space
+                const XMFLOAT3& halfExtents
+                  Half of the size of the box
+                const XMFLOAT3& displacement
+                  Move to make
+                XMFLOAT3& outDisplacement
+                  Move made before touching the blocks
+
+      Returns:  BYTE
+                  Voxel::FACE_* bits of the faces of the box that were
+                  stopped by a block
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelGrid::SweepBox(_In_ const XMFLOAT3& center, _In_ const XMFLOAT3& halfExtents, _In_ const XMFLOAT3& displacement, _Out_ XMFLOAT3& outDisplacement) const
+    {
+        static constexpr const UINT s_aAxes[3] = { 1u, 0u, 2u };
+        static constexpr const BYTE s_aPositiveFaces[3] = { Voxel::FACE_POSITIVE_X, Voxel::FACE_POSITIVE_Y, Voxel::FACE_POSITIVE_Z };
+        static constexpr const BYTE s_aNegativeFaces[3] = { Voxel::FACE_NEGATIVE_X, Voxel::FACE_NEGATIVE_Y, Voxel::FACE_NEGATIVE_Z };
+
+        FLOAT aMin[3] = { center.x - halfExtents.x, center.y - halfExtents.y, center.z - halfExtents.z };
+        FLOAT aMax[3] = { center.x + halfExtents.x, center.y + halfExtents.y, center.z + halfExtents.z };
+        FLOAT aMove[3] = { displacement.x, displacement.y, displacement.z };
+        const INT aSize[3] = { static_cast<INT>(m_uWidth), static_cast<INT>(m_uHeight), static_cast<INT>(m_uDepth) };
+
+        BYTE contactMask = 0u;
+        for (UINT uAxis : s_aAxes)
+        {
+            FLOAT move = aMove[uAxis];
+            if (move == 0.0f)
+            {
+                continue;
+            }
+
+            // Cells the box covers across the move, clipped to the grid
+            UINT uAxisU = (uAxis + 1u) % 3u;
+            UINT uAxisV = (uAxis + 2u) % 3u;
+            INT minU = static_cast<INT>(std::floor(aMin[uAxisU] + SWEEP_SKIN));
+            INT maxU = static_cast<INT>(std::floor(aMax[uAxisU] - SWEEP_SKIN));
+            INT minV = static_cast<INT>(std::floor(aMin[uAxisV] + SWEEP_SKIN));
+            INT maxV = static_cast<INT>(std::floor(aMax[uAxisV] - SWEEP_SKIN));
+            minU = minU > 0 ? minU : 0;
+            maxU = maxU < aSize[uAxisU] - 1 ? maxU : aSize[uAxisU] - 1;
+            minV = minV > 0 ? minV : 0;
+            maxV = maxV < aSize[uAxisV] - 1 ? maxV : aSize[uAxisV] - 1;
+
+            if (minU <= maxU && minV <= maxV)
+            {
+                if (move > 0.0f)
+                {
+                    INT firstSlab = static_cast<INT>(std::ceil(aMax[uAxis] - SWEEP_SKIN));
+                    FLOAT end = aMax[uAxis] + move;
+                    end = end < static_cast<FLOAT>(aSize[uAxis]) ? end : static_cast<FLOAT>(aSize[uAxis]);
+                    INT lastSlab = static_cast<INT>(std::ceil(end)) - 1;
+                    firstSlab = firstSlab > 0 ? firstSlab : 0;
+                    for (INT slab = firstSlab; slab <= lastSlab; ++slab)
+                    {
+                        if (isSlabSolid(uAxis, slab, minU, maxU, minV, maxV))
+                        {
+                            move = static_cast<FLOAT>(slab) - aMax[uAxis];
+                            move = move > 0.0f ? move : 0.0f;
+                            contactMask |= s_aPositiveFaces[uAxis];
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    INT firstSlab = static_cast<INT>(std::floor(aMin[uAxis] + SWEEP_SKIN)) - 1;
+                    FLOAT end = aMin[uAxis] + move;
+                    end = end > 0.0f ? end : 0.0f;
+                    INT lastSlab = static_cast<INT>(std::floor(end));
+                    firstSlab = firstSlab < aSize[uAxis] - 1 ? firstSlab : aSize[uAxis] - 1;
+                    for (INT slab = firstSlab; slab >= lastSlab; --slab)
+                    {
+                        if (isSlabSolid(uAxis, slab, minU, maxU, minV, maxV))
+                        {
+                            move = static_cast<FLOAT>(slab + 1) - aMin[uAxis];
+                            move = move < 0.0f ? move : 0.0f;
+                            contactMask |= s_aNegativeFaces[uAxis];
+                            break;
+                        }
+                    }
+                }
+            }
+
+            aMin[uAxis] += move;
+            aMax[uAxis] += move;
+            aMove[uAxis] = move;
+        }
+
+        outDisplacement = XMFLOAT3(aMove[0], aMove[1], aMove[2]);
+
+        return contactMask;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::SetBlock
+
+      Summary:  Sets the block type of a cell, allocating its chunk when
+                a solid block is written into an empty chunk
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+                eBlockType blockType
+                  Block type, AIR to clear the cell
+
+      Modifies: [m_uNumAllocatedChunks, m_aChunks, m_aDirtyChunks].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG outside of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelGrid::SetBlock(_In_ INT x, _In_ INT y, _In_ INT z, _In_ eBlockType blockType)
+    {
+        if (!IsInside(x, y, z))
+        {
+            return E_INVALIDARG;
+        }
+
+        UINT uX = static_cast<UINT>(x);
+        UINT uY = static_cast<UINT>(y);
+        UINT uZ = static_cast<UINT>(z);
+        if (blockType == eBlockType::AIR && !m_aChunks[getChunkIndex(uX, uY, uZ)])
+        {
+            return S_OK;
+        }
+
+        eBlockType& cell = getChunk(uX, uY, uZ)[getCellIndex(uX, uY, uZ)];
+        if (cell != blockType)
+        {
+            cell = blockType;
+            m_aDirtyChunks[getChunkIndex(uX, uY, uZ)] = TRUE;
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::getCellIndex
+
+      Summary:  Returns the index of a cell inside of its chunk, x is
+                the fastest axis
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+
+      Returns:  UINT
+                  Index in the chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelGrid::getCellIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z)
+    {
+        return ((y % CHUNK_SIZE) * CHUNK_SIZE + z % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::getChunkIndex
+
+      Summary:  Returns the index of the chunk of a cell
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+
+      Returns:  size_t
+                  Index in m_aChunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    size_t VoxelGrid::getChunkIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z) const
+    {
+        return (static_cast<size_t>(y / CHUNK_SIZE) * m_uNumChunksZ + z / CHUNK_SIZE) * m_uNumChunksX + x / CHUNK_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::getChunk
+
+      Summary:  Returns the chunk of a cell, allocated and cleared to
+                air if it did not exist
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+
+      Modifies: [m_uNumAllocatedChunks, m_aChunks].
+
+      Returns:  eBlockType*
+                  NUM_CHUNK_CELLS block types
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    eBlockType* VoxelGrid::getChunk(_In_ UINT x, _In_ UINT y, _In_ UINT z)
+    {
+        std::unique_ptr<eBlockType[]>& chunk = m_aChunks[getChunkIndex(x, y, z)];
+        if (!chunk)
+        {
+            chunk = std::make_unique<eBlockType[]>(NUM_CHUNK_CELLS);
+            ++m_uNumAllocatedChunks;
+        }
+
+        return chunk.get();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelGrid::isSlabSolid
+
+      Summary:  Returns whether a rectangle of cells of a layer across
+                an axis holds a block. The rectangle has to be inside of
+                the grid. Empty chunks are skipped without reading their
+                cells.
+
+      Args:     UINT uAxis
+                  Axis the layer is across, 0 to 2 for x to z
+                INT slab
+                  Cell of the layer along the axis
+                INT minU
+                  First cell along the axis after uAxis
+                INT maxU
+                  Last cell along the axis after uAxis
+                INT minV
+                  First cell along the axis before uAxis
+                INT maxV
+                  Last cell along the axis before uAxis
+
+      Returns:  BOOL
+                  TRUE if any of the cells holds a block
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelGrid::isSlabSolid(_In_ UINT uAxis, _In_ INT slab, _In_ INT minU, _In_ INT maxU, _In_ INT minV, _In_ INT maxV) const
+    {
+        UINT aCell[3] = {};
+        aCell[uAxis] = static_cast<UINT>(slab);
+        UINT uAxisU = (uAxis + 1u) % 3u;
+        UINT uAxisV = (uAxis + 2u) % 3u;
+        for (INT v = minV; v <= maxV; ++v)
+        {
+            aCell[uAxisV] = static_cast<UINT>(v);
+            for (INT u = minU; u <= maxU; ++u)
+            {
+                aCell[uAxisU] = static_cast<UINT>(u);
+                const eBlockType* pChunk = m_aChunks[getChunkIndex(aCell[0], aCell[1], aCell[2])].get();
+                if (pChunk && pChunk[getCellIndex(aCell[0], aCell[1], aCell[2])] != eBlockType::AIR)
+                {
+                    return TRUE;
+                }
+            }
+        }
+
+        return FALSE;
+    }
+}
@@ -0,0 +1,170 @@
+/*+===================================================================
+  File:      VOXELGRID.H
+
+  Summary:   VoxelGrid header file contains declarations of the
+             VoxelGrid class, the chunked block storage of an editable
+             voxel map.
+
+  Classes: VoxelGrid
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Scene/TerrainData.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelRay
+
+      Summary:  Ray against the voxel grid. The direction does not have
+                to be normalized, the maximum distance is measured along
+                the normalized direction.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelRay
+    {
+        XMFLOAT3 Origin;
+        XMFLOAT3 Direction;
+        FLOAT MaxDistance;
+    };
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelRayHit
+
+      Summary:  First solid cell along a ray, with the normal of the
+                face the ray entered it through and the distance to
+                that face. The normal is zero when the ray starts
+                inside of the block.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelRayHit
+    {
+        BOOL bHit;
+        eBlockType BlockType;
+        XMINT3 Cell;
+        XMINT3 Normal;
+        FLOAT Distance;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelGrid
+
+      Summary:  Block type of every cell of a uWidth x uHeight x uDepth
+                map, stored in cubic chunks of CHUNK_SIZE cells. Chunks
+                are allocated on the first solid block written into
+                them, so the air above the terrain costs nothing.
+                Cells outside of the grid read as air. Chunks with
+                edited cells are marked dirty until they are saved.
+
+                In grid space the cell (x, y, z) spans [x, x + 1) along
+                every axis, which is the space of the ray queries.
+
+      Methods:  Initialize
+                  Resizes the grid and clears every cell to air
+                FillTerrain
+                  Fills the columns of a terrain grid
+                ClearDirtyChunk
+                  Marks a chunk as saved
+                GetBlock
+                  Returns the block type of a cell
+                GetDirtyChunks
+                  Returns the chunks edited since they were saved
+                GetFaceMask
+                  Returns the exposed faces of a cell
+                GetNeighbourMask
+                  Returns the solid cells around a cell
+                GetWidth
+                  Returns the number of cells along the x-axis
+                GetHeight
+                  Returns the number of cells along the y-axis
+                GetDepth
+                  Returns the number of cells along the z-axis
+                GetNumChunksX
+                  Returns the number of chunks along the x-axis
+                GetNumChunksY
+                  Returns the number of chunks along the y-axis
+                GetNumChunksZ
+                  Returns the number of chunks along the z-axis
+                GetMemoryUsage
+                  Returns the size of the allocated chunks in bytes
+                IsInside
+                  Returns whether a cell is inside of the grid
+                IsSolid
+                  Returns whether a cell holds a block
+                Raycast
+                  Finds the first block along a ray
+                RaycastBatch
+                  Finds the first block along many rays
+                ReadChunk
+                  Copies the block types of a chunk
+                SweepBox
+                  Moves a box until it touches a block
+                SetBlock
+                  Sets the block type of a cell
+                VoxelGrid
+                  Constructor.
+                ~VoxelGrid
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelGrid
+    {
+    public:
+        static constexpr const UINT CHUNK_SIZE = 16u;
+        static constexpr const UINT NUM_CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+        static constexpr const UINT NUM_RAYS_PER_TASK = 64u;
+        static constexpr const FLOAT SWEEP_SKIN = 1.0f / 1024.0f;
+
+    public:
+        VoxelGrid();
+        VoxelGrid(const VoxelGrid& other) = delete;
+        VoxelGrid(VoxelGrid&& other) = delete;
+        VoxelGrid& operator=(const VoxelGrid& other) = delete;
+        VoxelGrid& operator=(VoxelGrid&& other) = delete;
+        ~VoxelGrid() = default;
+
+        void Initialize(_In_ UINT uWidth, _In_ UINT uHeight, _In_ UINT uDepth);
+        void FillTerrain(_In_ const TerrainData& terrain);
+        void ClearDirtyChunk(_In_ const XMUINT3& chunk);
+
+        eBlockType GetBlock(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        void GetDirtyChunks(_Out_ std::vector<XMUINT3>& aOutChunks) const;
+        BYTE GetFaceMask(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        UINT GetNeighbourMask(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        UINT GetWidth() const;
+        UINT GetHeight() const;
+        UINT GetDepth() const;
+        UINT GetNumChunksX() const;
+        UINT GetNumChunksY() const;
+        UINT GetNumChunksZ() const;
+        size_t GetMemoryUsage() const;
+        BOOL IsInside(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        BOOL IsSolid(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        BOOL Raycast(_In_ const VoxelRay& ray, _Out_ VoxelRayHit& outHit) const;
+        void RaycastBatch(_In_reads_(uNumRays) const VoxelRay* pRays, _Out_writes_(uNumRays) VoxelRayHit* pOutHits, _In_ UINT uNumRays, _In_opt_ ThreadPool* pThreadPool = nullptr) const;
+        void ReadChunk(_In_ const XMUINT3& chunk, _Out_writes_(NUM_CHUNK_CELLS) eBlockType* pOutBlocks) const;
+        BYTE SweepBox(_In_ const XMFLOAT3& center, _In_ const XMFLOAT3& halfExtents, _In_ const XMFLOAT3& displacement, _Out_ XMFLOAT3& outDisplacement) const;
+
+        HRESULT SetBlock(_In_ INT x, _In_ INT y, _In_ INT z, _In_ eBlockType blockType);
+
+    private:
+        static UINT getCellIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z);
+
+        size_t getChunkIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z) const;
+        eBlockType* getChunk(_In_ UINT x, _In_ UINT y, _In_ UINT z);
+        BOOL isSlabSolid(_In_ UINT uAxis, _In_ INT slab, _In_ INT minU, _In_ INT maxU, _In_ INT minV, _In_ INT maxV) const;
+
+    private:
+        UINT m_uWidth;
+        UINT m_uHeight;
+        UINT m_uDepth;
+        UINT m_uNumChunksX;
+        UINT m_uNumChunksY;
+        UINT m_uNumChunksZ;
+        size_t m_uNumAllocatedChunks;
+        std::vector<std::unique_ptr<eBlockType[]>> m_aChunks;
+        std::vector<BOOL> m_aDirtyChunks;
+    };
+}
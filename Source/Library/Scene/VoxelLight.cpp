@@ -0,0 +1,919 @@
+#include "Scene/VoxelLight.h"
+
+#include <algorithm>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::VoxelLight
+
+      Summary:  Constructor, no block type emits light
+
+      Modifies: [m_pGrid, m_uWidth, m_uHeight, m_uDepth, m_uNumChunksX,
+                 m_uNumChunksY, m_uNumChunksZ, m_aEmissions, m_aChunks,
+                 m_aRemovalQueue, m_aPropagationQueue].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelLight::VoxelLight()
+        : m_pGrid(nullptr)
+        , m_uWidth(0u)
+        , m_uHeight(0u)
+        , m_uDepth(0u)
+        , m_uNumChunksX(0u)
+        , m_uNumChunksY(0u)
+        , m_uNumChunksZ(0u)
+        , m_aEmissions{ 0u }
+        , m_aChunks()
+        , m_aRemovalQueue()
+        , m_aPropagationQueue()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::BakeOpenSkyLight
+
+      Summary:  Sets the exposed faces of an instance to full skylight
+                without block light, which is the light of every face of
+                a height map since all of its air is open to the sky
+
+      Args:     VoxelInstanceData& instance
+                  Instance with its FaceMask set
+
+      Modifies: [instance.Light].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::BakeOpenSkyLight(_Inout_ VoxelInstanceData& instance)
+    {
+        instance.Light[0] = 0u;
+        instance.Light[1] = 0u;
+        for (UINT uFaceIdx = 0u; uFaceIdx < 6u; ++uFaceIdx)
+        {
+            if (instance.FaceMask & (1u << uFaceIdx))
+            {
+                instance.Light[uFaceIdx / 4u] |= static_cast<UINT>(OPEN_SKY_LIGHT) << ((uFaceIdx % 4u) * 8u);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::Initialize
+
+      Summary:  Floods the light of a whole grid. The columns are lit
+                from the sky down to their topmost block and every chunk
+                is filled on its own, then each light is spread chunk by
+                chunk in rounds. Light crossing into a neighbouring
+                chunk is handed over between the rounds, so every chunk
+                is only written by its own task.
+
+      Args:     const VoxelGrid& grid
+                  Grid to light, kept to relight the edits
+                ThreadPool* pThreadPool
+                  Pool to light the chunks on, the chunks are lit on the
+                  calling thread if nullptr
+
+      Modifies: [m_pGrid, m_uWidth, m_uHeight, m_uDepth, m_uNumChunksX,
+                 m_uNumChunksY, m_uNumChunksZ, m_aChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::Initialize(_In_ const VoxelGrid& grid, _In_opt_ ThreadPool* pThreadPool)
+    {
+        m_pGrid = &grid;
+        m_uWidth = grid.GetWidth();
+        m_uHeight = grid.GetHeight();
+        m_uDepth = grid.GetDepth();
+        m_uNumChunksX = (m_uWidth + VoxelGrid::CHUNK_SIZE - 1u) / VoxelGrid::CHUNK_SIZE;
+        m_uNumChunksY = (m_uHeight + VoxelGrid::CHUNK_SIZE - 1u) / VoxelGrid::CHUNK_SIZE;
+        m_uNumChunksZ = (m_uDepth + VoxelGrid::CHUNK_SIZE - 1u) / VoxelGrid::CHUNK_SIZE;
+
+        m_aChunks.clear();
+        m_aChunks.resize(static_cast<size_t>(m_uNumChunksX) * m_uNumChunksY * m_uNumChunksZ);
+        if (m_aChunks.empty())
+        {
+            return;
+        }
+
+        // Lowest cell of every column that the sky reaches, one row of columns per task
+        std::vector<UINT> aSkyHeights(static_cast<size_t>(m_uWidth) * m_uDepth);
+        runTasks(pThreadPool, m_uDepth, [this, &grid, &aSkyHeights](UINT z)
+        {
+            for (UINT x = 0u; x < m_uWidth; ++x)
+            {
+                UINT y = m_uHeight;
+                while (y > 0u && !grid.IsSolid(static_cast<INT>(x), static_cast<INT>(y) - 1, static_cast<INT>(z)))
+                {
+                    --y;
+                }
+                aSkyHeights[static_cast<size_t>(z) * m_uWidth + x] = y;
+            }
+        });
+
+        runTasks(pThreadPool, static_cast<UINT>(m_aChunks.size()), [this, &aSkyHeights](UINT uChunkIdx)
+        {
+            fillChunk(uChunkIdx, aSkyHeights);
+        });
+
+        floodChannel(SKY_SHIFT, aSkyHeights, pThreadPool);
+        if (std::any_of(std::begin(m_aEmissions), std::end(m_aEmissions), [](BYTE emission) { return emission > 0u; }))
+        {
+            floodChannel(BLOCK_SHIFT, aSkyHeights, pThreadPool);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::UpdateBlocks
+
+      Summary:  Relights the grid after cells of it were edited. The
+                light of the edited cells is removed together with the
+                light that came through them, then the light around the
+                cleared cells, of emissive edited blocks and of the sky
+                above the grid is spread back in. Only the cells the
+                light changed in are visited.
+
+      Args:     const XMINT3* pCells
+                  Edited cells, the grid already holds their new blocks
+                UINT uNumCells
+                  Number of edited cells
+                std::vector<XMINT3>& aChangedCells
+                  Appended with the cells whose light changed, a cell
+                  may be appended more than once
+
+      Modifies: [m_aChunks, m_aRemovalQueue, m_aPropagationQueue].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::UpdateBlocks(_In_reads_(uNumCells) const XMINT3* pCells, _In_ UINT uNumCells, _Inout_ std::vector<XMINT3>& aChangedCells)
+    {
+        if (!m_pGrid)
+        {
+            return;
+        }
+
+        for (UINT uShift : { SKY_SHIFT, BLOCK_SHIFT })
+        {
+            m_aRemovalQueue.clear();
+            m_aPropagationQueue.clear();
+
+            for (UINT uCellIdx = 0u; uCellIdx < uNumCells; ++uCellIdx)
+            {
+                const XMINT3& cell = pCells[uCellIdx];
+                if (!isInside(cell.x, cell.y, cell.z))
+                {
+                    continue;
+                }
+
+                BYTE level = getLevel(static_cast<UINT>(cell.x), static_cast<UINT>(cell.y), static_cast<UINT>(cell.z), uShift);
+                if (level > 0u)
+                {
+                    setLevel(static_cast<UINT>(cell.x), static_cast<UINT>(cell.y), static_cast<UINT>(cell.z), uShift, 0u);
+                    m_aRemovalQueue.push_back(LightNode{ .x = cell.x, .y = cell.y, .z = cell.z, .level = level });
+                }
+                aChangedCells.push_back(cell);
+            }
+
+            removeLight(uShift, aChangedCells);
+
+            for (UINT uCellIdx = 0u; uCellIdx < uNumCells; ++uCellIdx)
+            {
+                const XMINT3& cell = pCells[uCellIdx];
+                if (!isInside(cell.x, cell.y, cell.z))
+                {
+                    continue;
+                }
+
+                eBlockType blockType = m_pGrid->GetBlock(cell.x, cell.y, cell.z);
+                if (blockType != eBlockType::AIR)
+                {
+                    BYTE emission = uShift == BLOCK_SHIFT ? GetEmission(blockType) : 0u;
+                    if (emission > 0u)
+                    {
+                        setLevel(static_cast<UINT>(cell.x), static_cast<UINT>(cell.y), static_cast<UINT>(cell.z), uShift, emission);
+                        m_aPropagationQueue.push_back(LightNode{ .x = cell.x, .y = cell.y, .z = cell.z, .level = emission });
+                    }
+                    continue;
+                }
+
+                // The top layer is lit by the sky above the grid
+                if (uShift == SKY_SHIFT && cell.y == static_cast<INT>(m_uHeight) - 1)
+                {
+                    setLevel(static_cast<UINT>(cell.x), static_cast<UINT>(cell.y), static_cast<UINT>(cell.z), uShift, MAX_LEVEL);
+                    m_aPropagationQueue.push_back(LightNode{ .x = cell.x, .y = cell.y, .z = cell.z, .level = MAX_LEVEL });
+                }
+
+                // A cleared cell is lit again by its neighbours
+                for (UINT uDirectionIdx = 0u; uDirectionIdx < 6u; ++uDirectionIdx)
+                {
+                    INT x = cell.x + DIRECTIONS[uDirectionIdx][0];
+                    INT y = cell.y + DIRECTIONS[uDirectionIdx][1];
+                    INT z = cell.z + DIRECTIONS[uDirectionIdx][2];
+                    if (isInside(x, y, z))
+                    {
+                        BYTE level = getLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift);
+                        if (level > 0u)
+                        {
+                            m_aPropagationQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = level });
+                        }
+                    }
+                }
+            }
+
+            propagateLight(uShift, aChangedCells);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::BakeFaceLight
+
+      Summary:  Sets the light of the exposed faces of an instance to
+                the light of the cell in front of each face
+
+      Args:     VoxelInstanceData& instance
+                  Instance with its FaceMask set, in grid coordinates
+
+      Modifies: [instance.Light].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::BakeFaceLight(_Inout_ VoxelInstanceData& instance) const
+    {
+        instance.Light[0] = 0u;
+        instance.Light[1] = 0u;
+        for (UINT uFaceIdx = 0u; uFaceIdx < 6u; ++uFaceIdx)
+        {
+            if ((instance.FaceMask & (1u << uFaceIdx)) == 0u)
+            {
+                continue;
+            }
+
+            BYTE light = GetLight(
+                static_cast<INT>(instance.X) + DIRECTIONS[uFaceIdx][0],
+                static_cast<INT>(instance.Y) + DIRECTIONS[uFaceIdx][1],
+                static_cast<INT>(instance.Z) + DIRECTIONS[uFaceIdx][2]
+            );
+            instance.Light[uFaceIdx / 4u] |= static_cast<UINT>(light) << ((uFaceIdx % 4u) * 8u);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::GetEmission
+
+      Summary:  Returns the block light level a block type emits
+
+      Args:     eBlockType blockType
+                  Block type
+
+      Returns:  BYTE
+                  Level from 0 to MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::GetEmission(_In_ eBlockType blockType) const
+    {
+        size_t uTypeIdx = static_cast<size_t>(static_cast<BYTE>(blockType));
+        return uTypeIdx < ARRAYSIZE(m_aEmissions) ? m_aEmissions[uTypeIdx] : 0u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::GetLight
+
+      Summary:  Returns both light levels of a cell
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BYTE
+                  Skylight level in the low and block light level in the
+                  high nibble, OPEN_SKY_LIGHT outside of the grid
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::GetLight(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        if (!isInside(x, y, z))
+        {
+            return OPEN_SKY_LIGHT;
+        }
+
+        const std::unique_ptr<BYTE[]>& chunk = m_aChunks[getChunkIndex(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z))];
+        if (!chunk)
+        {
+            return OPEN_SKY_LIGHT;
+        }
+
+        return chunk[getCellIndex(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z))];
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::GetSkyLight
+
+      Summary:  Returns the skylight level of a cell
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BYTE
+                  Level from 0 to MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::GetSkyLight(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        return (GetLight(x, y, z) >> SKY_SHIFT) & MAX_LEVEL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::GetBlockLight
+
+      Summary:  Returns the block light level of a cell
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BYTE
+                  Level from 0 to MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::GetBlockLight(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        return (GetLight(x, y, z) >> BLOCK_SHIFT) & MAX_LEVEL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::GetMemoryUsage
+
+      Summary:  Returns the memory held by the allocated chunks
+
+      Returns:  size_t
+                  Size in bytes
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    size_t VoxelLight::GetMemoryUsage() const
+    {
+        size_t uNumAllocatedChunks = static_cast<size_t>(std::count_if(m_aChunks.begin(), m_aChunks.end(), [](const std::unique_ptr<BYTE[]>& chunk) { return chunk != nullptr; }));
+        return uNumAllocatedChunks * VoxelGrid::NUM_CHUNK_CELLS;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::SetEmission
+
+      Summary:  Sets the block light level a block type emits. The grid
+                is not relit, call Initialize after changing emissions.
+
+      Args:     eBlockType blockType
+                  Solid block type
+                BYTE level
+                  Level from 0 to MAX_LEVEL, 0 for no light
+
+      Modifies: [m_aEmissions].
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG for air or a level above
+                  MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelLight::SetEmission(_In_ eBlockType blockType, _In_ BYTE level)
+    {
+        size_t uTypeIdx = static_cast<size_t>(static_cast<BYTE>(blockType));
+        if (blockType == eBlockType::AIR || uTypeIdx >= ARRAYSIZE(m_aEmissions) || level > MAX_LEVEL)
+        {
+            return E_INVALIDARG;
+        }
+
+        m_aEmissions[uTypeIdx] = level;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::getCellIndex
+
+      Summary:  Returns the index of a cell inside of its chunk, in the
+                same order as VoxelGrid
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+
+      Returns:  UINT
+                  Index in the chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelLight::getCellIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z)
+    {
+        return ((y % VoxelGrid::CHUNK_SIZE) * VoxelGrid::CHUNK_SIZE + z % VoxelGrid::CHUNK_SIZE) * VoxelGrid::CHUNK_SIZE + x % VoxelGrid::CHUNK_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::getPropagatedLevel
+
+      Summary:  Returns the level a light spreads to a neighbour with.
+                Full skylight goes down without loss.
+
+      Args:     UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                BYTE level
+                  Level of the lit cell
+                UINT uDirectionIdx
+                  Direction of the neighbour in DIRECTIONS
+
+      Returns:  BYTE
+                  Level of the neighbour, 0 if the light does not reach
+                  it
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::getPropagatedLevel(_In_ UINT uShift, _In_ BYTE level, _In_ UINT uDirectionIdx)
+    {
+        if (level == 0u)
+        {
+            return 0u;
+        }
+
+        if (uShift == SKY_SHIFT && uDirectionIdx == DIRECTION_DOWN && level == MAX_LEVEL)
+        {
+            return MAX_LEVEL;
+        }
+
+        return level - 1u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::runTasks
+
+      Summary:  Runs tasks on a thread pool, or one after the other on
+                the calling thread without one
+
+      Args:     ThreadPool* pThreadPool
+                  Pool to run the tasks on, may be nullptr
+                UINT uNumTasks
+                  Number of tasks
+                const std::function<void(UINT)>& task
+                  Task called with the task index
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::runTasks(_In_opt_ ThreadPool* pThreadPool, _In_ UINT uNumTasks, _In_ const std::function<void(UINT)>& task)
+    {
+        if (!pThreadPool || uNumTasks <= 1u)
+        {
+            for (UINT uTaskIdx = 0u; uTaskIdx < uNumTasks; ++uTaskIdx)
+            {
+                task(uTaskIdx);
+            }
+            return;
+        }
+
+        pThreadPool->ParallelFor(uNumTasks, task);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::isInside
+
+      Summary:  Returns whether a cell is inside of the lit grid
+
+      Args:     INT x
+                  Cell along the x-axis
+                INT y
+                  Cell along the y-axis
+                INT z
+                  Cell along the z-axis
+
+      Returns:  BOOL
+                  TRUE if the cell is inside
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelLight::isInside(_In_ INT x, _In_ INT y, _In_ INT z) const
+    {
+        return static_cast<UINT>(x) < m_uWidth && static_cast<UINT>(y) < m_uHeight && static_cast<UINT>(z) < m_uDepth;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::getChunkIndex
+
+      Summary:  Returns the index of the chunk of a cell
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+
+      Returns:  size_t
+                  Index in m_aChunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    size_t VoxelLight::getChunkIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z) const
+    {
+        return (static_cast<size_t>(y / VoxelGrid::CHUNK_SIZE) * m_uNumChunksZ + z / VoxelGrid::CHUNK_SIZE) * m_uNumChunksX + x / VoxelGrid::CHUNK_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::getLevel
+
+      Summary:  Returns one light level of a cell inside of the grid
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+                UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+
+      Returns:  BYTE
+                  Level from 0 to MAX_LEVEL
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BYTE VoxelLight::getLevel(_In_ UINT x, _In_ UINT y, _In_ UINT z, _In_ UINT uShift) const
+    {
+        const std::unique_ptr<BYTE[]>& chunk = m_aChunks[getChunkIndex(x, y, z)];
+        BYTE light = chunk ? chunk[getCellIndex(x, y, z)] : OPEN_SKY_LIGHT;
+
+        return (light >> uShift) & MAX_LEVEL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::setLevel
+
+      Summary:  Sets one light level of a cell inside of the grid, the
+                chunk of the cell is allocated open to the sky if it did
+                not exist
+
+      Args:     UINT x
+                  Cell along the x-axis
+                UINT y
+                  Cell along the y-axis
+                UINT z
+                  Cell along the z-axis
+                UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                BYTE level
+                  Level from 0 to MAX_LEVEL
+
+      Modifies: [m_aChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::setLevel(_In_ UINT x, _In_ UINT y, _In_ UINT z, _In_ UINT uShift, _In_ BYTE level)
+    {
+        std::unique_ptr<BYTE[]>& chunk = m_aChunks[getChunkIndex(x, y, z)];
+        if (!chunk)
+        {
+            if (((OPEN_SKY_LIGHT >> uShift) & MAX_LEVEL) == level)
+            {
+                return;
+            }
+
+            chunk = std::make_unique<BYTE[]>(VoxelGrid::NUM_CHUNK_CELLS);
+            std::fill_n(chunk.get(), VoxelGrid::NUM_CHUNK_CELLS, OPEN_SKY_LIGHT);
+        }
+
+        BYTE& light = chunk[getCellIndex(x, y, z)];
+        light = static_cast<BYTE>((light & ~(MAX_LEVEL << uShift)) | (level << uShift));
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::fillChunk
+
+      Summary:  Sets the light of the cells of a chunk before the
+                flood. Air above the topmost block of its column has
+                full skylight, emissive blocks have their emission and
+                every other cell is dark. The chunk is only kept if any
+                of its cells is not open to the sky.
+
+      Args:     size_t uChunkIdx
+                  Index of the chunk in m_aChunks
+                const std::vector<UINT>& aSkyHeights
+                  Lowest cell of every column that the sky reaches
+
+      Modifies: [m_aChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::fillChunk(_In_ size_t uChunkIdx, _In_ const std::vector<UINT>& aSkyHeights)
+    {
+        UINT uBeginX = static_cast<UINT>(uChunkIdx % m_uNumChunksX) * VoxelGrid::CHUNK_SIZE;
+        UINT uBeginZ = static_cast<UINT>((uChunkIdx / m_uNumChunksX) % m_uNumChunksZ) * VoxelGrid::CHUNK_SIZE;
+        UINT uBeginY = static_cast<UINT>(uChunkIdx / (static_cast<size_t>(m_uNumChunksX) * m_uNumChunksZ)) * VoxelGrid::CHUNK_SIZE;
+        UINT uEndX = uBeginX + VoxelGrid::CHUNK_SIZE < m_uWidth ? uBeginX + VoxelGrid::CHUNK_SIZE : m_uWidth;
+        UINT uEndY = uBeginY + VoxelGrid::CHUNK_SIZE < m_uHeight ? uBeginY + VoxelGrid::CHUNK_SIZE : m_uHeight;
+        UINT uEndZ = uBeginZ + VoxelGrid::CHUNK_SIZE < m_uDepth ? uBeginZ + VoxelGrid::CHUNK_SIZE : m_uDepth;
+
+        std::unique_ptr<BYTE[]> chunk = std::make_unique<BYTE[]>(VoxelGrid::NUM_CHUNK_CELLS);
+        std::fill_n(chunk.get(), VoxelGrid::NUM_CHUNK_CELLS, OPEN_SKY_LIGHT);
+
+        BOOL bOpen = TRUE;
+        for (UINT y = uBeginY; y < uEndY; ++y)
+        {
+            for (UINT z = uBeginZ; z < uEndZ; ++z)
+            {
+                for (UINT x = uBeginX; x < uEndX; ++x)
+                {
+                    eBlockType blockType = m_pGrid->GetBlock(static_cast<INT>(x), static_cast<INT>(y), static_cast<INT>(z));
+                    BYTE light = 0u;
+                    if (blockType != eBlockType::AIR)
+                    {
+                        light = static_cast<BYTE>(GetEmission(blockType) << BLOCK_SHIFT);
+                    }
+                    else if (y >= aSkyHeights[static_cast<size_t>(z) * m_uWidth + x])
+                    {
+                        light = OPEN_SKY_LIGHT;
+                    }
+
+                    chunk[getCellIndex(x, y, z)] = light;
+                    bOpen = bOpen && light == OPEN_SKY_LIGHT;
+                }
+            }
+        }
+
+        if (!bOpen)
+        {
+            m_aChunks[uChunkIdx] = std::move(chunk);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::seedChunk
+
+      Summary:  Returns the cells of a chunk that one light spreads
+                from after fillChunk. Skylight spreads from the cells
+                open to the sky beside a column that is shaded at their
+                height, block light from the emissive blocks.
+
+      Args:     size_t uChunkIdx
+                  Index of the chunk in m_aChunks
+                UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                const std::vector<UINT>& aSkyHeights
+                  Lowest cell of every column that the sky reaches
+                std::vector<LightNode>& aOutSeeds
+                  Lit cells to spread from
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::seedChunk(_In_ size_t uChunkIdx, _In_ UINT uShift, _In_ const std::vector<UINT>& aSkyHeights, _Out_ std::vector<LightNode>& aOutSeeds) const
+    {
+        aOutSeeds.clear();
+
+        UINT uBeginX = static_cast<UINT>(uChunkIdx % m_uNumChunksX) * VoxelGrid::CHUNK_SIZE;
+        UINT uBeginZ = static_cast<UINT>((uChunkIdx / m_uNumChunksX) % m_uNumChunksZ) * VoxelGrid::CHUNK_SIZE;
+        UINT uBeginY = static_cast<UINT>(uChunkIdx / (static_cast<size_t>(m_uNumChunksX) * m_uNumChunksZ)) * VoxelGrid::CHUNK_SIZE;
+        UINT uEndX = uBeginX + VoxelGrid::CHUNK_SIZE < m_uWidth ? uBeginX + VoxelGrid::CHUNK_SIZE : m_uWidth;
+        UINT uEndY = uBeginY + VoxelGrid::CHUNK_SIZE < m_uHeight ? uBeginY + VoxelGrid::CHUNK_SIZE : m_uHeight;
+        UINT uEndZ = uBeginZ + VoxelGrid::CHUNK_SIZE < m_uDepth ? uBeginZ + VoxelGrid::CHUNK_SIZE : m_uDepth;
+
+        if (uShift == SKY_SHIFT)
+        {
+            for (UINT z = uBeginZ; z < uEndZ; ++z)
+            {
+                for (UINT x = uBeginX; x < uEndX; ++x)
+                {
+                    UINT uSkyHeight = aSkyHeights[static_cast<size_t>(z) * m_uWidth + x];
+                    UINT uMaxSkyHeight = uSkyHeight;
+                    for (UINT uDirectionIdx = 2u; uDirectionIdx < 6u; ++uDirectionIdx)
+                    {
+                        INT neighbourX = static_cast<INT>(x) + DIRECTIONS[uDirectionIdx][0];
+                        INT neighbourZ = static_cast<INT>(z) + DIRECTIONS[uDirectionIdx][2];
+                        if (isInside(neighbourX, 0, neighbourZ))
+                        {
+                            UINT uNeighbourSkyHeight = aSkyHeights[static_cast<size_t>(neighbourZ) * m_uWidth + static_cast<size_t>(neighbourX)];
+                            uMaxSkyHeight = uNeighbourSkyHeight > uMaxSkyHeight ? uNeighbourSkyHeight : uMaxSkyHeight;
+                        }
+                    }
+
+                    UINT uSeedBeginY = uSkyHeight > uBeginY ? uSkyHeight : uBeginY;
+                    UINT uSeedEndY = uMaxSkyHeight < uEndY ? uMaxSkyHeight : uEndY;
+                    for (UINT y = uSeedBeginY; y < uSeedEndY; ++y)
+                    {
+                        aOutSeeds.push_back(LightNode{ .x = static_cast<INT>(x), .y = static_cast<INT>(y), .z = static_cast<INT>(z), .level = MAX_LEVEL });
+                    }
+                }
+            }
+            return;
+        }
+
+        for (UINT y = uBeginY; y < uEndY; ++y)
+        {
+            for (UINT z = uBeginZ; z < uEndZ; ++z)
+            {
+                for (UINT x = uBeginX; x < uEndX; ++x)
+                {
+                    BYTE emission = GetEmission(m_pGrid->GetBlock(static_cast<INT>(x), static_cast<INT>(y), static_cast<INT>(z)));
+                    if (emission > 0u)
+                    {
+                        aOutSeeds.push_back(LightNode{ .x = static_cast<INT>(x), .y = static_cast<INT>(y), .z = static_cast<INT>(z), .level = emission });
+                    }
+                }
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::floodChunk
+
+      Summary:  Spreads one light from lit cells through the air of
+                their chunk. Light leaving the chunk is not written but
+                handed back to be applied by the neighbouring chunk.
+
+      Args:     size_t uChunkIdx
+                  Index of the chunk in m_aChunks
+                UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                std::vector<LightNode>& aQueue
+                  Lit cells of the chunk to spread from, emptied
+                std::vector<LightNode>& aOutgoing
+                  Appended with the cells of other chunks that the light
+                  reached, with their new level
+
+      Modifies: [m_aChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::floodChunk(_In_ size_t uChunkIdx, _In_ UINT uShift, _Inout_ std::vector<LightNode>& aQueue, _Inout_ std::vector<LightNode>& aOutgoing)
+    {
+        for (size_t uHead = 0u; uHead < aQueue.size(); ++uHead)
+        {
+            LightNode node = aQueue[uHead];
+            BYTE level = getLevel(static_cast<UINT>(node.x), static_cast<UINT>(node.y), static_cast<UINT>(node.z), uShift);
+            for (UINT uDirectionIdx = 0u; uDirectionIdx < 6u; ++uDirectionIdx)
+            {
+                INT x = node.x + DIRECTIONS[uDirectionIdx][0];
+                INT y = node.y + DIRECTIONS[uDirectionIdx][1];
+                INT z = node.z + DIRECTIONS[uDirectionIdx][2];
+                BYTE neighbourLevel = getPropagatedLevel(uShift, level, uDirectionIdx);
+                if (neighbourLevel == 0u || !isInside(x, y, z) || m_pGrid->IsSolid(x, y, z))
+                {
+                    continue;
+                }
+
+                if (getChunkIndex(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z)) != uChunkIdx)
+                {
+                    aOutgoing.push_back(LightNode{ .x = x, .y = y, .z = z, .level = neighbourLevel });
+                    continue;
+                }
+
+                if (getLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift) < neighbourLevel)
+                {
+                    setLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift, neighbourLevel);
+                    aQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = neighbourLevel });
+                }
+            }
+        }
+
+        aQueue.clear();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::floodChannel
+
+      Summary:  Spreads one light through the whole grid after
+                fillChunk. Every round floods the chunks with lit cells
+                in parallel, then the light that crossed into other
+                chunks is applied on the calling thread and seeds the
+                next round, until no light crosses anymore. Light fades
+                within MAX_LEVEL cells, so it takes a few rounds.
+
+      Args:     UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                const std::vector<UINT>& aSkyHeights
+                  Lowest cell of every column that the sky reaches
+                ThreadPool* pThreadPool
+                  Pool to flood the chunks on, may be nullptr
+
+      Modifies: [m_aChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::floodChannel(_In_ UINT uShift, _In_ const std::vector<UINT>& aSkyHeights, _In_opt_ ThreadPool* pThreadPool)
+    {
+        std::vector<std::vector<LightNode>> aQueues(m_aChunks.size());
+        runTasks(pThreadPool, static_cast<UINT>(m_aChunks.size()), [this, uShift, &aSkyHeights, &aQueues](UINT uChunkIdx)
+        {
+            seedChunk(uChunkIdx, uShift, aSkyHeights, aQueues[uChunkIdx]);
+        });
+
+        std::vector<size_t> aActiveChunks;
+        for (size_t uChunkIdx = 0u; uChunkIdx < aQueues.size(); ++uChunkIdx)
+        {
+            if (!aQueues[uChunkIdx].empty())
+            {
+                aActiveChunks.push_back(uChunkIdx);
+            }
+        }
+
+        std::vector<std::vector<LightNode>> aOutgoing;
+        while (!aActiveChunks.empty())
+        {
+            aOutgoing.resize(aActiveChunks.size());
+            runTasks(pThreadPool, static_cast<UINT>(aActiveChunks.size()), [this, uShift, &aActiveChunks, &aQueues, &aOutgoing](UINT uTaskIdx)
+            {
+                aOutgoing[uTaskIdx].clear();
+                floodChunk(aActiveChunks[uTaskIdx], uShift, aQueues[aActiveChunks[uTaskIdx]], aOutgoing[uTaskIdx]);
+            });
+
+            aActiveChunks.clear();
+            for (const std::vector<LightNode>& aTaskOutgoing : aOutgoing)
+            {
+                for (const LightNode& node : aTaskOutgoing)
+                {
+                    UINT x = static_cast<UINT>(node.x);
+                    UINT y = static_cast<UINT>(node.y);
+                    UINT z = static_cast<UINT>(node.z);
+                    if (getLevel(x, y, z, uShift) >= node.level)
+                    {
+                        continue;
+                    }
+
+                    setLevel(x, y, z, uShift, node.level);
+                    size_t uChunkIdx = getChunkIndex(x, y, z);
+                    if (aQueues[uChunkIdx].empty())
+                    {
+                        aActiveChunks.push_back(uChunkIdx);
+                    }
+                    aQueues[uChunkIdx].push_back(node);
+                }
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::removeLight
+
+      Summary:  Clears the light that spread from the cells of the
+                removal queue. A neighbour with a lower level, or full
+                skylight below full skylight, was lit through the
+                cleared cell and is cleared too. A neighbour that is as
+                bright or brighter has its own source and is queued to
+                spread its light back into the cleared cells.
+
+      Args:     UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                std::vector<XMINT3>& aChangedCells
+                  Appended with the cleared cells
+
+      Modifies: [m_aChunks, m_aRemovalQueue, m_aPropagationQueue].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::removeLight(_In_ UINT uShift, _Inout_ std::vector<XMINT3>& aChangedCells)
+    {
+        for (size_t uHead = 0u; uHead < m_aRemovalQueue.size(); ++uHead)
+        {
+            LightNode node = m_aRemovalQueue[uHead];
+            for (UINT uDirectionIdx = 0u; uDirectionIdx < 6u; ++uDirectionIdx)
+            {
+                INT x = node.x + DIRECTIONS[uDirectionIdx][0];
+                INT y = node.y + DIRECTIONS[uDirectionIdx][1];
+                INT z = node.z + DIRECTIONS[uDirectionIdx][2];
+                if (!isInside(x, y, z))
+                {
+                    continue;
+                }
+
+                BYTE neighbourLevel = getLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift);
+                if (neighbourLevel == 0u)
+                {
+                    continue;
+                }
+
+                if (neighbourLevel >= node.level && !(neighbourLevel == MAX_LEVEL && getPropagatedLevel(uShift, node.level, uDirectionIdx) == MAX_LEVEL))
+                {
+                    m_aPropagationQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = neighbourLevel });
+                    continue;
+                }
+
+                setLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift, 0u);
+                m_aRemovalQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = neighbourLevel });
+                aChangedCells.push_back(XMINT3(x, y, z));
+
+                // Emitters keep their own light
+                BYTE emission = uShift == BLOCK_SHIFT ? GetEmission(m_pGrid->GetBlock(x, y, z)) : 0u;
+                if (emission > 0u)
+                {
+                    setLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift, emission);
+                    m_aPropagationQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = emission });
+                }
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelLight::propagateLight
+
+      Summary:  Spreads the light of the cells of the propagation queue
+                into the air around them, across chunks
+
+      Args:     UINT uShift
+                  SKY_SHIFT or BLOCK_SHIFT
+                std::vector<XMINT3>& aChangedCells
+                  Appended with the cells that were lit
+
+      Modifies: [m_aChunks, m_aPropagationQueue].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelLight::propagateLight(_In_ UINT uShift, _Inout_ std::vector<XMINT3>& aChangedCells)
+    {
+        for (size_t uHead = 0u; uHead < m_aPropagationQueue.size(); ++uHead)
+        {
+            LightNode node = m_aPropagationQueue[uHead];
+            BYTE level = getLevel(static_cast<UINT>(node.x), static_cast<UINT>(node.y), static_cast<UINT>(node.z), uShift);
+            for (UINT uDirectionIdx = 0u; uDirectionIdx < 6u; ++uDirectionIdx)
+            {
+                INT x = node.x + DIRECTIONS[uDirectionIdx][0];
+                INT y = node.y + DIRECTIONS[uDirectionIdx][1];
+                INT z = node.z + DIRECTIONS[uDirectionIdx][2];
+                BYTE neighbourLevel = getPropagatedLevel(uShift, level, uDirectionIdx);
+                if (neighbourLevel == 0u || !isInside(x, y, z) || m_pGrid->IsSolid(x, y, z))
+                {
+                    continue;
+                }
+
+                if (getLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift) < neighbourLevel)
+                {
+                    setLevel(static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), uShift, neighbourLevel);
+                    m_aPropagationQueue.push_back(LightNode{ .x = x, .y = y, .z = z, .level = neighbourLevel });
+                    aChangedCells.push_back(XMINT3(x, y, z));
+                }
+            }
+        }
+    }
+}
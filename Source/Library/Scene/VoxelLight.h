@@ -0,0 +1,150 @@
+/*+===================================================================
+  File:      VOXELLIGHT.H
+
+  Summary:   VoxelLight header file contains declarations of the
+             VoxelLight class that floods skylight and block light
+             through the cells of a voxel grid.
+
+  Classes: VoxelLight
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/DataTypes.h"
+#include "Scene/VoxelGrid.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelLight
+
+      Summary:  Light of every cell of a VoxelGrid, with the skylight
+                level in the low and the block light level in the high
+                nibble of a byte. Skylight enters the grid from above
+                and goes down through air without loss, block light
+                starts at the emission of the emissive block types, and
+                both lose one level per cell they spread to. Light only
+                passes through air, blocks other than emitters are
+                dark.
+
+                The levels are stored in chunks of the grid, a chunk
+                whose every cell is open to the sky without block light
+                is not allocated. Cells outside of the grid read as
+                open to the sky.
+
+                Initialize floods the whole grid chunk by chunk on a
+                thread pool, UpdateBlocks relights around edited cells
+                with a removal and a propagation queue. The levels are
+                baked into the faces of the voxel instances, so any
+                number of emitters costs nothing when rendering.
+
+      Methods:  Initialize
+                  Floods the light of a whole grid
+                UpdateBlocks
+                  Relights the cells around edited cells
+                BakeFaceLight
+                  Sets the light of the faces of an instance
+                BakeOpenSkyLight
+                  Sets the faces of an instance to full skylight
+                GetEmission
+                  Returns the block light level a block type emits
+                GetLight
+                  Returns both light levels of a cell
+                GetSkyLight
+                  Returns the skylight level of a cell
+                GetBlockLight
+                  Returns the block light level of a cell
+                GetMemoryUsage
+                  Returns the size of the allocated chunks in bytes
+                SetEmission
+                  Sets the block light level a block type emits
+                VoxelLight
+                  Constructor.
+                ~VoxelLight
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelLight
+    {
+    public:
+        static constexpr const BYTE MAX_LEVEL = 15u;
+        static constexpr const UINT SKY_SHIFT = 0u;
+        static constexpr const UINT BLOCK_SHIFT = 4u;
+        static constexpr const BYTE OPEN_SKY_LIGHT = MAX_LEVEL << SKY_SHIFT;
+
+    public:
+        VoxelLight();
+        VoxelLight(const VoxelLight& other) = delete;
+        VoxelLight(VoxelLight&& other) = delete;
+        VoxelLight& operator=(const VoxelLight& other) = delete;
+        VoxelLight& operator=(VoxelLight&& other) = delete;
+        ~VoxelLight() = default;
+
+        static void BakeOpenSkyLight(_Inout_ VoxelInstanceData& instance);
+
+        void Initialize(_In_ const VoxelGrid& grid, _In_opt_ ThreadPool* pThreadPool = nullptr);
+        void UpdateBlocks(_In_reads_(uNumCells) const XMINT3* pCells, _In_ UINT uNumCells, _Inout_ std::vector<XMINT3>& aChangedCells);
+        void BakeFaceLight(_Inout_ VoxelInstanceData& instance) const;
+
+        BYTE GetEmission(_In_ eBlockType blockType) const;
+        BYTE GetLight(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        BYTE GetSkyLight(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        BYTE GetBlockLight(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        size_t GetMemoryUsage() const;
+
+        HRESULT SetEmission(_In_ eBlockType blockType, _In_ BYTE level);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   LightNode
+
+          Summary:  Cell in a light queue, with the level it was lit to
+                    or had before it was cleared
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct LightNode
+        {
+            INT x;
+            INT y;
+            INT z;
+            BYTE level;
+        };
+
+        static UINT getCellIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z);
+        static BYTE getPropagatedLevel(_In_ UINT uShift, _In_ BYTE level, _In_ UINT uDirectionIdx);
+        static void runTasks(_In_opt_ ThreadPool* pThreadPool, _In_ UINT uNumTasks, _In_ const std::function<void(UINT)>& task);
+
+        BOOL isInside(_In_ INT x, _In_ INT y, _In_ INT z) const;
+        size_t getChunkIndex(_In_ UINT x, _In_ UINT y, _In_ UINT z) const;
+        BYTE getLevel(_In_ UINT x, _In_ UINT y, _In_ UINT z, _In_ UINT uShift) const;
+        void setLevel(_In_ UINT x, _In_ UINT y, _In_ UINT z, _In_ UINT uShift, _In_ BYTE level);
+        void fillChunk(_In_ size_t uChunkIdx, _In_ const std::vector<UINT>& aSkyHeights);
+        void seedChunk(_In_ size_t uChunkIdx, _In_ UINT uShift, _In_ const std::vector<UINT>& aSkyHeights, _Out_ std::vector<LightNode>& aOutSeeds) const;
+        void floodChunk(_In_ size_t uChunkIdx, _In_ UINT uShift, _Inout_ std::vector<LightNode>& aQueue, _Inout_ std::vector<LightNode>& aOutgoing);
+        void floodChannel(_In_ UINT uShift, _In_ const std::vector<UINT>& aSkyHeights, _In_opt_ ThreadPool* pThreadPool);
+        void removeLight(_In_ UINT uShift, _Inout_ std::vector<XMINT3>& aChangedCells);
+        void propagateLight(_In_ UINT uShift, _Inout_ std::vector<XMINT3>& aChangedCells);
+
+        // Face neighbours in the face order of Voxel::VERTICES, the second one is the cell below
+        static constexpr const INT DIRECTIONS[6][3] =
+        {
+            { 0, 1, 0 }, { 0, -1, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+        };
+        static constexpr const UINT DIRECTION_DOWN = 1u;
+
+    private:
+        const VoxelGrid* m_pGrid;
+        UINT m_uWidth;
+        UINT m_uHeight;
+        UINT m_uDepth;
+        UINT m_uNumChunksX;
+        UINT m_uNumChunksY;
+        UINT m_uNumChunksZ;
+        BYTE m_aEmissions[static_cast<size_t>(eBlockType::COUNT)];
+        std::vector<std::unique_ptr<BYTE[]>> m_aChunks;
+        std::vector<LightNode> m_aRemovalQueue;
+        std::vector<LightNode> m_aPropagationQueue;
+    };
+}
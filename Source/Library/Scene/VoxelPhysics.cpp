@@ -0,0 +1,173 @@
+#include "Scene/VoxelPhysics.h"
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::VoxelPhysics
+
+      Summary:  Constructor
+
+      Modifies: [m_gravity, m_accumulatedTime].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelPhysics::VoxelPhysics()
+        : m_gravity(DEFAULT_GRAVITY)
+        , m_accumulatedTime(0.0f)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::Update
+
+      Summary:  Accumulates the frame time and makes the fixed steps
+                that fit in it. Time beyond MAX_STEPS_PER_UPDATE steps,
+                e.g. after a hitch, is dropped instead of being caught
+                up over the next frames.
+
+      Args:     const Scene& scene
+                  Scene whose blocks the bodies collide with
+                VoxelBody* pBodies
+                  Bodies to move
+                UINT uNumBodies
+                  Number of bodies
+                FLOAT deltaTime
+                  Time difference of a frame
+                ThreadPool* pThreadPool
+                  Pool to move the bodies on, the bodies are moved on
+                  the calling thread if nullptr
+
+      Modifies: [m_accumulatedTime].
+
+      Returns:  UINT
+                  Number of steps made
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelPhysics::Update(_In_ const Scene& scene, _Inout_updates_(uNumBodies) VoxelBody* pBodies, _In_ UINT uNumBodies, _In_ FLOAT deltaTime, _In_opt_ ThreadPool* pThreadPool)
+    {
+        m_accumulatedTime += deltaTime;
+
+        UINT uNumSteps = 0u;
+        while (m_accumulatedTime >= FIXED_TIME_STEP && uNumSteps < MAX_STEPS_PER_UPDATE)
+        {
+            Step(scene, pBodies, uNumBodies, pThreadPool);
+            m_accumulatedTime -= FIXED_TIME_STEP;
+            ++uNumSteps;
+        }
+
+        if (m_accumulatedTime >= FIXED_TIME_STEP)
+        {
+            m_accumulatedTime = 0.0f;
+        }
+
+        return uNumSteps;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::Step
+
+      Summary:  Moves every body by one fixed step. The bodies do not
+                collide with each other, so they are split in tasks of
+                NUM_BODIES_PER_TASK bodies that run on the thread pool
+                and the calling thread.
+
+      Args:     const Scene& scene
+                  Scene whose blocks the bodies collide with
+                VoxelBody* pBodies
+                  Bodies to move
+                UINT uNumBodies
+                  Number of bodies
+                ThreadPool* pThreadPool
+                  Pool to move the bodies on, the bodies are moved on
+                  the calling thread if nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelPhysics::Step(_In_ const Scene& scene, _Inout_updates_(uNumBodies) VoxelBody* pBodies, _In_ UINT uNumBodies, _In_opt_ ThreadPool* pThreadPool) const
+    {
+        UINT uNumTasks = (uNumBodies + NUM_BODIES_PER_TASK - 1u) / NUM_BODIES_PER_TASK;
+        auto stepTask = [this, &scene, pBodies, uNumBodies](UINT uTaskIdx)
+        {
+            UINT uEndIdx = (uTaskIdx + 1u) * NUM_BODIES_PER_TASK < uNumBodies ? (uTaskIdx + 1u) * NUM_BODIES_PER_TASK : uNumBodies;
+            for (UINT uBodyIdx = uTaskIdx * NUM_BODIES_PER_TASK; uBodyIdx < uEndIdx; ++uBodyIdx)
+            {
+                stepBody(scene, pBodies[uBodyIdx]);
+            }
+        };
+
+        if (pThreadPool && uNumTasks > 1u)
+        {
+            pThreadPool->ParallelFor(uNumTasks, stepTask);
+        }
+        else
+        {
+            for (UINT uTaskIdx = 0u; uTaskIdx < uNumTasks; ++uTaskIdx)
+            {
+                stepTask(uTaskIdx);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::GetGravity
+
+      Summary:  Returns the downward acceleration
+
+      Returns:  FLOAT
+                  Acceleration in world units per second squared
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT VoxelPhysics::GetGravity() const
+    {
+        return m_gravity;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::SetGravity
+
+      Summary:  Sets the downward acceleration
+
+      Args:     FLOAT gravity
+                  Acceleration in world units per second squared
+
+      Modifies: [m_gravity].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelPhysics::SetGravity(_In_ FLOAT gravity)
+    {
+        m_gravity = gravity;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelPhysics::stepBody
+
+      Summary:  Applies the gravity to a body, sweeps it along its
+                velocity and stops its velocity along the axes it was
+                stopped on
+
+      Args:     const Scene& scene
+                  Scene whose blocks the body collides with
+                VoxelBody& body
+                  Body to move
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelPhysics::stepBody(_In_ const Scene& scene, _Inout_ VoxelBody& body) const
+    {
+        body.Velocity.y -= m_gravity * body.GravityScale * FIXED_TIME_STEP;
+        body.Velocity.y = body.Velocity.y > -MAX_FALL_SPEED ? body.Velocity.y : -MAX_FALL_SPEED;
+
+        XMFLOAT3 displacement(body.Velocity.x * FIXED_TIME_STEP, body.Velocity.y * FIXED_TIME_STEP, body.Velocity.z * FIXED_TIME_STEP);
+        XMFLOAT3 move;
+        BYTE contactMask = scene.SweepBox(body.Position, body.HalfExtents, displacement, move);
+
+        body.Position.x += move.x;
+        body.Position.y += move.y;
+        body.Position.z += move.z;
+
+        if (contactMask & (Voxel::FACE_NEGATIVE_X | Voxel::FACE_POSITIVE_X))
+        {
+            body.Velocity.x = 0.0f;
+        }
+        if (contactMask & (Voxel::FACE_NEGATIVE_Y | Voxel::FACE_POSITIVE_Y))
+        {
+            body.Velocity.y = 0.0f;
+        }
+        if (contactMask & (Voxel::FACE_NEGATIVE_Z | Voxel::FACE_POSITIVE_Z))
+        {
+            body.Velocity.z = 0.0f;
+        }
+        body.ContactMask = contactMask;
+    }
+}
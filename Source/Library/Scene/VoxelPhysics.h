@@ -0,0 +1,91 @@
+/*+===================================================================
+  File:      VOXELPHYSICS.H
+
+  Summary:   VoxelPhysics header file contains declarations of the
+             VoxelPhysics class that moves boxes through the blocks of
+             a scene at a fixed time step.
+
+  Classes: VoxelPhysics
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Scene/Scene.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelBody
+
+      Summary:  Axis-aligned box in world space that collides with the
+                blocks, e.g. the camera in walk mode or an agent.
+                ContactMask holds the Voxel::FACE_* bits of the faces
+                that touched a block in the last step, the body stands
+                on the ground if Voxel::FACE_NEGATIVE_Y is set.
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelBody
+    {
+        XMFLOAT3 Position;
+        XMFLOAT3 HalfExtents;
+        XMFLOAT3 Velocity;
+        FLOAT GravityScale;
+        BYTE ContactMask;
+        BYTE padding[3];
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelPhysics
+
+      Summary:  Steps voxel bodies at FIXED_TIME_STEP, so their motion
+                does not depend on the frame rate and scripted moves
+                replay the same way. The frame time is accumulated and
+                at most MAX_STEPS_PER_UPDATE steps are made per update.
+
+      Methods:  Update
+                  Makes the fixed steps that fit in the elapsed time
+                Step
+                  Makes one fixed step
+                GetGravity
+                  Returns the downward acceleration
+                SetGravity
+                  Sets the downward acceleration
+                VoxelPhysics
+                  Constructor.
+                ~VoxelPhysics
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelPhysics
+    {
+    public:
+        static constexpr const FLOAT FIXED_TIME_STEP = 1.0f / 60.0f;
+        static constexpr const UINT MAX_STEPS_PER_UPDATE = 8u;
+        static constexpr const UINT NUM_BODIES_PER_TASK = 64u;
+        static constexpr const FLOAT DEFAULT_GRAVITY = 30.0f;
+        static constexpr const FLOAT MAX_FALL_SPEED = 60.0f;
+
+    public:
+        VoxelPhysics();
+        VoxelPhysics(const VoxelPhysics& other) = delete;
+        VoxelPhysics(VoxelPhysics&& other) = delete;
+        VoxelPhysics& operator=(const VoxelPhysics& other) = delete;
+        VoxelPhysics& operator=(VoxelPhysics&& other) = delete;
+        ~VoxelPhysics() = default;
+
+        UINT Update(_In_ const Scene& scene, _Inout_updates_(uNumBodies) VoxelBody* pBodies, _In_ UINT uNumBodies, _In_ FLOAT deltaTime, _In_opt_ ThreadPool* pThreadPool = nullptr);
+        void Step(_In_ const Scene& scene, _Inout_updates_(uNumBodies) VoxelBody* pBodies, _In_ UINT uNumBodies, _In_opt_ ThreadPool* pThreadPool = nullptr) const;
+
+        FLOAT GetGravity() const;
+        void SetGravity(_In_ FLOAT gravity);
+
+    private:
+        void stepBody(_In_ const Scene& scene, _Inout_ VoxelBody& body) const;
+
+    private:
+        FLOAT m_gravity;
+        FLOAT m_accumulatedTime;
+    };
+}
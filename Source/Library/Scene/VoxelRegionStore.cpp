@@ -0,0 +1,1054 @@
+#include "Scene/VoxelRegionStore.h"
+
+#include <algorithm>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::VoxelRegionStore
+
+      Summary:  Constructor, no directory is open
+
+      Modifies: [m_directoryPath, m_uNumChunksX, m_uNumChunksY,
+                 m_uNumChunksZ, m_mutex, m_regions, m_aFailedChunks,
+                 m_saveResult, m_saveThread].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelRegionStore::VoxelRegionStore()
+        : m_directoryPath()
+        , m_uNumChunksX(0u)
+        , m_uNumChunksY(0u)
+        , m_uNumChunksZ(0u)
+        , m_mutex()
+        , m_regions()
+        , m_aFailedChunks()
+        , m_saveResult(S_OK)
+        , m_saveThread(1u)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::~VoxelRegionStore
+
+      Summary:  Destructor, finishes the queued saves before the region
+                files are closed
+
+      Modifies: [m_regions].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelRegionStore::~VoxelRegionStore()
+    {
+        Close();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::EncodeChunk
+
+      Summary:  Run-length encodes the block types of a chunk into pairs
+                of bytes, the length of the run minus one and the block
+                type
+
+      Args:     const eBlockType* pBlocks
+                  Block types of the chunk
+                std::vector<BYTE>& aOutBytes
+                  Encoded chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::EncodeChunk(_In_reads_(VoxelGrid::NUM_CHUNK_CELLS) const eBlockType* pBlocks, _Out_ std::vector<BYTE>& aOutBytes)
+    {
+        aOutBytes.clear();
+
+        UINT i = 0u;
+        while (i < VoxelGrid::NUM_CHUNK_CELLS)
+        {
+            UINT uRunLength = 1u;
+            while (i + uRunLength < VoxelGrid::NUM_CHUNK_CELLS && uRunLength < 256u && pBlocks[i + uRunLength] == pBlocks[i])
+            {
+                ++uRunLength;
+            }
+
+            aOutBytes.push_back(static_cast<BYTE>(uRunLength - 1u));
+            aOutBytes.push_back(static_cast<BYTE>(pBlocks[i]));
+            i += uRunLength;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::DecodeChunk
+
+      Summary:  Decodes a run-length encoded chunk
+
+      Args:     const BYTE* pBytes
+                  Encoded chunk
+                UINT uNumBytes
+                  Size of the encoded chunk
+                eBlockType* pOutBlocks
+                  Block types of the chunk
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the runs are not a whole chunk
+                  of known block types
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::DecodeChunk(_In_reads_bytes_(uNumBytes) const BYTE* pBytes, _In_ UINT uNumBytes, _Out_writes_(VoxelGrid::NUM_CHUNK_CELLS) eBlockType* pOutBlocks)
+    {
+        if (uNumBytes % 2u != 0u)
+        {
+            return E_FAIL;
+        }
+
+        UINT uNumCells = 0u;
+        for (UINT i = 0u; i < uNumBytes; i += 2u)
+        {
+            UINT uRunLength = static_cast<UINT>(pBytes[i]) + 1u;
+            if (pBytes[i + 1u] >= static_cast<BYTE>(eBlockType::COUNT) || uNumCells + uRunLength > VoxelGrid::NUM_CHUNK_CELLS)
+            {
+                return E_FAIL;
+            }
+
+            std::fill_n(pOutBlocks + uNumCells, uRunLength, static_cast<eBlockType>(pBytes[i + 1u]));
+            uNumCells += uRunLength;
+        }
+
+        return uNumCells == VoxelGrid::NUM_CHUNK_CELLS ? S_OK : E_FAIL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::Open
+
+      Summary:  Closes the open directory and opens another one for a
+                grid of the given size, creating it if it does not
+                exist. Region files are opened when they are first used.
+
+      Args:     const std::filesystem::path& directoryPath
+                  Directory of the region files
+                UINT uNumChunksX
+                  Number of chunks of the grid along the x-axis
+                UINT uNumChunksY
+                  Number of chunks of the grid along the y-axis
+                UINT uNumChunksZ
+                  Number of chunks of the grid along the z-axis
+
+      Modifies: [m_directoryPath, m_uNumChunksX, m_uNumChunksY,
+                 m_uNumChunksZ].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::Open(_In_ const std::filesystem::path& directoryPath, _In_ UINT uNumChunksX, _In_ UINT uNumChunksY, _In_ UINT uNumChunksZ)
+    {
+        Close();
+
+        if (directoryPath.empty() || uNumChunksX == 0u || uNumChunksY == 0u || uNumChunksZ == 0u)
+        {
+            return E_INVALIDARG;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directoryPath, error);
+        if (error)
+        {
+            return HRESULT_FROM_WIN32(error.value());
+        }
+
+        m_directoryPath = directoryPath;
+        m_uNumChunksX = uNumChunksX;
+        m_uNumChunksY = uNumChunksY;
+        m_uNumChunksZ = uNumChunksZ;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::Close
+
+      Summary:  Waits for the queued saves, then unmaps and closes the
+                region files. Chunks that failed to save are dropped.
+
+      Modifies: [m_directoryPath, m_regions, m_aFailedChunks,
+                 m_saveResult].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::Close()
+    {
+        WaitForSaves();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& region : m_regions)
+        {
+            closeRegion(*region.second);
+        }
+        m_regions.clear();
+        m_aFailedChunks.clear();
+        m_directoryPath.clear();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::GetDirectoryPath
+
+      Summary:  Returns the directory of the region files
+
+      Returns:  const std::filesystem::path&
+                  Directory of the region files, empty if none is open
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::filesystem::path& VoxelRegionStore::GetDirectoryPath() const
+    {
+        return m_directoryPath;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::GetStoredChunks
+
+      Summary:  Returns the chunks of the grid saved in the region files
+                by reading only the sector tables
+
+      Args:     std::vector<XMUINT3>& aOutChunks
+                  Saved chunks
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::GetStoredChunks(_Out_ std::vector<XMUINT3>& aOutChunks)
+    {
+        aOutChunks.clear();
+
+        if (!IsOpen())
+        {
+            return E_FAIL;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        UINT uNumRegionsX = (m_uNumChunksX + REGION_SIZE - 1u) / REGION_SIZE;
+        UINT uNumRegionsZ = (m_uNumChunksZ + REGION_SIZE - 1u) / REGION_SIZE;
+        for (UINT uRegionZ = 0u; uRegionZ < uNumRegionsZ; ++uRegionZ)
+        {
+            for (UINT uRegionX = 0u; uRegionX < uNumRegionsX; ++uRegionX)
+            {
+                Region* pRegion = nullptr;
+                HRESULT hr = openRegion(uRegionX, uRegionZ, FALSE, pRegion);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                for (UINT i = 0u; i < static_cast<UINT>(pRegion->aEntries.size()); ++i)
+                {
+                    if (pRegion->aEntries[i].uNumBytes == 0u)
+                    {
+                        continue;
+                    }
+
+                    XMUINT3 chunk(
+                        uRegionX * REGION_SIZE + i % REGION_SIZE,
+                        i / (REGION_SIZE * REGION_SIZE),
+                        uRegionZ * REGION_SIZE + (i / REGION_SIZE) % REGION_SIZE
+                    );
+                    if (chunk.x < m_uNumChunksX && chunk.z < m_uNumChunksZ)
+                    {
+                        aOutChunks.push_back(chunk);
+                    }
+                }
+            }
+        }
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::IsOpen
+
+      Summary:  Returns whether a directory is open
+
+      Returns:  BOOL
+                  TRUE if a directory is open
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelRegionStore::IsOpen() const
+    {
+        return !m_directoryPath.empty();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::ReadChunk
+
+      Summary:  Decodes the block types of a saved chunk straight from
+                the mapped view of its region file
+
+      Args:     const XMUINT3& chunk
+                  Chunk coordinates
+                eBlockType* pOutBlocks
+                  Block types of the chunk, in the cell order of
+                  VoxelGrid::ReadChunk
+                BOOL& bOutFound
+                  Whether the chunk is saved, pOutBlocks is left as it
+                  is if not
+
+      Returns:  HRESULT
+                  Status code, E_FAIL if the region file is damaged
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::ReadChunk(_In_ const XMUINT3& chunk, _Out_writes_(VoxelGrid::NUM_CHUNK_CELLS) eBlockType* pOutBlocks, _Out_ BOOL& bOutFound)
+    {
+        bOutFound = FALSE;
+
+        if (!IsOpen() || chunk.x >= m_uNumChunksX || chunk.y >= m_uNumChunksY || chunk.z >= m_uNumChunksZ)
+        {
+            return E_INVALIDARG;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Region* pRegion = nullptr;
+        HRESULT hr = openRegion(chunk.x / REGION_SIZE, chunk.z / REGION_SIZE, FALSE, pRegion);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const SectorRange& entry = pRegion->aEntries[getEntryIndex(chunk)];
+        if (entry.uNumBytes == 0u)
+        {
+            return S_OK;
+        }
+
+        UINT64 uOffset = static_cast<UINT64>(entry.uFirstSector) * SECTOR_SIZE;
+        if (!pRegion->pView || uOffset + entry.uNumBytes > pRegion->uViewSize)
+        {
+            return E_FAIL;
+        }
+
+        hr = DecodeChunk(pRegion->pView + uOffset, entry.uNumBytes, pOutBlocks);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bOutFound = TRUE;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::SaveAsync
+
+      Summary:  Queues chunks to be written into their region files on
+                the save thread, saves run in the order they are queued.
+                The chunks that failed to save before are retried with
+                them, even if none are given.
+
+      Args:     std::vector<VoxelChunkBlocks>&& aChunks
+                  Chunks to save, owned by the save from now on
+
+      Returns:  HRESULT
+                  Status code, E_INVALIDARG if a chunk is outside of the
+                  grid or is not a whole chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::SaveAsync(_In_ std::vector<VoxelChunkBlocks>&& aChunks)
+    {
+        if (!IsOpen())
+        {
+            return E_FAIL;
+        }
+
+        for (const VoxelChunkBlocks& chunk : aChunks)
+        {
+            if (chunk.Chunk.x >= m_uNumChunksX || chunk.Chunk.y >= m_uNumChunksY || chunk.Chunk.z >= m_uNumChunksZ ||
+                chunk.Blocks.size() != VoxelGrid::NUM_CHUNK_CELLS)
+            {
+                return E_INVALIDARG;
+            }
+        }
+
+        m_saveThread.Enqueue([this, aSavedChunks = std::move(aChunks)]() mutable
+        {
+            saveChunks(aSavedChunks);
+        });
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::WaitForSaves
+
+      Summary:  Waits until every queued save is written
+
+      Modifies: [m_saveResult].
+
+      Returns:  HRESULT
+                  First failure of the saves since the last wait, the
+                  region files keep the chunks of their last save
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::WaitForSaves()
+    {
+        m_saveThread.WaitIdle();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        HRESULT hr = m_saveResult;
+        m_saveResult = S_OK;
+
+        return hr;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::allocateSectors
+
+      Summary:  Marks the first run of free sectors that is long enough
+                as used, past the end of the file if there is none
+
+      Args:     Region& region
+                  Region to allocate in
+                UINT uNumSectors
+                  Number of sectors
+
+      Returns:  UINT
+                  First sector of the run
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelRegionStore::allocateSectors(_Inout_ Region& region, _In_ UINT uNumSectors)
+    {
+        UINT uNumUsedSectors = static_cast<UINT>(region.aUsedSectors.size());
+        UINT uFirstSector = uNumUsedSectors;
+        UINT uRunLength = 0u;
+        for (UINT i = 0u; i < uNumUsedSectors; ++i)
+        {
+            if (region.aUsedSectors[i])
+            {
+                uRunLength = 0u;
+                continue;
+            }
+
+            if (++uRunLength == uNumSectors)
+            {
+                uFirstSector = i + 1u - uNumSectors;
+                break;
+            }
+        }
+
+        if (uFirstSector == uNumUsedSectors)
+        {
+            // Reuse the free sectors at the end of the file
+            uFirstSector -= uRunLength;
+            region.aUsedSectors.resize(static_cast<size_t>(uFirstSector) + uNumSectors, FALSE);
+        }
+
+        std::fill_n(region.aUsedSectors.begin() + uFirstSector, uNumSectors, TRUE);
+
+        return uFirstSector;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::closeRegion
+
+      Summary:  Unmaps and closes the file of a region
+
+      Args:     Region& region
+                  Region to close
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::closeRegion(_Inout_ Region& region)
+    {
+        unmapFile(region.hMapping, region.pView);
+        region.hMapping = nullptr;
+        region.pView = nullptr;
+        region.uViewSize = 0u;
+
+        if (region.hFile != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(region.hFile);
+            region.hFile = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::freeSectors
+
+      Summary:  Marks the sectors of encoded chunks as free
+
+      Args:     Region& region
+                  Region of the chunks
+                const std::vector<SectorRange>& aEntries
+                  Sector ranges of the chunks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::freeSectors(_Inout_ Region& region, _In_ const std::vector<SectorRange>& aEntries)
+    {
+        for (const SectorRange& entry : aEntries)
+        {
+            UINT uNumSectors = (entry.uNumBytes + SECTOR_SIZE - 1u) / SECTOR_SIZE;
+            std::fill_n(region.aUsedSectors.begin() + entry.uFirstSector, uNumSectors, FALSE);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::getChecksum
+
+      Summary:  Returns the FNV-1a hash of a table slot, with the
+                checksum of the header taken as zero
+
+      Args:     const RegionHeader& header
+                  Header of the slot
+                const SectorRange* pEntries
+                  Sector ranges of the slot
+
+      Returns:  UINT
+                  Checksum
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelRegionStore::getChecksum(_In_ const RegionHeader& header, _In_reads_(header.uNumEntries) const SectorRange* pEntries)
+    {
+        RegionHeader zeroedHeader = header;
+        zeroedHeader.uChecksum = 0u;
+
+        UINT uHash = 2166136261u;
+        auto hashBytes = [&uHash](const void* pData, size_t uNumBytes)
+        {
+            const BYTE* pBytes = static_cast<const BYTE*>(pData);
+            for (size_t i = 0u; i < uNumBytes; ++i)
+            {
+                uHash = (uHash ^ pBytes[i]) * 16777619u;
+            }
+        };
+        hashBytes(&zeroedHeader, sizeof(zeroedHeader));
+        hashBytes(pEntries, static_cast<size_t>(header.uNumEntries) * sizeof(SectorRange));
+
+        return uHash;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::mapFile
+
+      Summary:  Maps the whole of a region file read-only into a new
+                view, an empty file has no view. The previous view of
+                the file stays valid until it is unmapped, so the view
+                can be made while chunks are read from the old one.
+
+      Args:     HANDLE hFile
+                  Open region file
+                HANDLE& hOutMapping
+                  File mapping, nullptr on failure
+                const BYTE*& pOutView
+                  View of the whole file, nullptr on failure
+                UINT64& uOutViewSize
+                  Size of the view in bytes
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::mapFile(_In_ HANDLE hFile, _Out_ HANDLE& hOutMapping, _Out_ const BYTE*& pOutView, _Out_ UINT64& uOutViewSize)
+    {
+        hOutMapping = nullptr;
+        pOutView = nullptr;
+        uOutViewSize = 0u;
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(hFile, &fileSize))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        if (fileSize.QuadPart == 0)
+        {
+            return S_OK;
+        }
+
+        HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+        if (!hMapping)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        const BYTE* pView = static_cast<const BYTE*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0u, 0u, 0u));
+        if (!pView)
+        {
+            HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            CloseHandle(hMapping);
+            return hr;
+        }
+
+        hOutMapping = hMapping;
+        pOutView = pView;
+        uOutViewSize = static_cast<UINT64>(fileSize.QuadPart);
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::unmapFile
+
+      Summary:  Unmaps a view of a region file and closes its mapping
+
+      Args:     HANDLE hMapping
+                  File mapping, may be nullptr
+                const BYTE* pView
+                  View of the file, may be nullptr
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::unmapFile(_In_opt_ HANDLE hMapping, _In_opt_ const BYTE* pView)
+    {
+        if (pView)
+        {
+            UnmapViewOfFile(pView);
+        }
+
+        if (hMapping)
+        {
+            CloseHandle(hMapping);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::writeBytes
+
+      Summary:  Writes bytes at an offset of a file
+
+      Args:     HANDLE hFile
+                  File opened for writing
+                UINT64 uOffset
+                  Offset in the file
+                const void* pData
+                  Bytes to write
+                UINT uNumBytes
+                  Number of bytes
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::writeBytes(_In_ HANDLE hFile, _In_ UINT64 uOffset, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(uOffset & 0xFFFFFFFFu);
+        overlapped.OffsetHigh = static_cast<DWORD>(uOffset >> 32u);
+
+        DWORD uNumWrittenBytes = 0u;
+        if (!WriteFile(hFile, pData, uNumBytes, &uNumWrittenBytes, &overlapped))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        return uNumWrittenBytes == uNumBytes ? S_OK : E_FAIL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::getEntryIndex
+
+      Summary:  Returns the index of a chunk in the sector table of its
+                region
+
+      Args:     const XMUINT3& chunk
+                  Chunk coordinates
+
+      Returns:  UINT
+                  Index of the sector range
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelRegionStore::getEntryIndex(_In_ const XMUINT3& chunk) const
+    {
+        return (chunk.y * REGION_SIZE + chunk.z % REGION_SIZE) * REGION_SIZE + chunk.x % REGION_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::getNumEntries
+
+      Summary:  Returns the number of chunks of a region
+
+      Returns:  UINT
+                  Number of sector ranges of a table slot
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelRegionStore::getNumEntries() const
+    {
+        return REGION_SIZE * REGION_SIZE * m_uNumChunksY;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::getNumTableSectors
+
+      Summary:  Returns the number of sectors of a table slot
+
+      Returns:  UINT
+                  Number of sectors
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT VoxelRegionStore::getNumTableSectors() const
+    {
+        UINT uNumTableBytes = static_cast<UINT>(sizeof(RegionHeader) + getNumEntries() * sizeof(SectorRange));
+
+        return (uNumTableBytes + SECTOR_SIZE - 1u) / SECTOR_SIZE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::getRegionPath
+
+      Summary:  Returns the path of the file of a region
+
+      Args:     UINT uRegionX
+                  Region coordinate along the x-axis
+                UINT uRegionZ
+                  Region coordinate along the z-axis
+
+      Returns:  std::filesystem::path
+                  Path of "r.<x>.<z>.vxr" in the open directory
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::filesystem::path VoxelRegionStore::getRegionPath(_In_ UINT uRegionX, _In_ UINT uRegionZ) const
+    {
+        return m_directoryPath / (L"r." + std::to_wstring(uRegionX) + L"." + std::to_wstring(uRegionZ) + L".vxr");
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::openRegion
+
+      Summary:  Returns an open region, opening its file and reading
+                the live table slot on first use. The live slot is the
+                valid one with the higher generation, a file without a
+                valid slot has no saved chunks. Must be called with the
+                mutex held.
+
+      Args:     UINT uRegionX
+                  Region coordinate along the x-axis
+                UINT uRegionZ
+                  Region coordinate along the z-axis
+                BOOL bCreate
+                  Whether to create the file if it does not exist
+                Region*& pOutRegion
+                  Region, without a file if it does not exist and
+                  bCreate is FALSE
+
+      Modifies: [m_regions].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::openRegion(_In_ UINT uRegionX, _In_ UINT uRegionZ, _In_ BOOL bCreate, _Out_ Region*& pOutRegion)
+    {
+        pOutRegion = nullptr;
+
+        UINT64 uKey = (static_cast<UINT64>(uRegionZ) << 32u) | uRegionX;
+        auto it = m_regions.find(uKey);
+        if (it == m_regions.end())
+        {
+            std::unique_ptr<Region> region = std::make_unique<Region>();
+            region->hFile = INVALID_HANDLE_VALUE;
+            region->hMapping = nullptr;
+            region->pView = nullptr;
+            region->uViewSize = 0u;
+            region->uTableSlot = 1u;
+            region->uGeneration = 0u;
+            region->aEntries.assign(getNumEntries(), SectorRange{ 0u, 0u });
+            region->aUsedSectors.assign(static_cast<size_t>(getNumTableSectors()) * 2u, TRUE);
+
+            it = m_regions.emplace(uKey, std::move(region)).first;
+        }
+
+        Region& region = *it->second;
+        if (region.hFile != INVALID_HANDLE_VALUE)
+        {
+            pOutRegion = &region;
+            return S_OK;
+        }
+
+        std::filesystem::path regionPath = getRegionPath(uRegionX, uRegionZ);
+        region.hFile = CreateFileW(
+            regionPath.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            bCreate ? OPEN_ALWAYS : OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (region.hFile == INVALID_HANDLE_VALUE)
+        {
+            DWORD uError = GetLastError();
+            if (!bCreate && (uError == ERROR_FILE_NOT_FOUND || uError == ERROR_PATH_NOT_FOUND))
+            {
+                pOutRegion = &region;
+                return S_OK;
+            }
+
+            return HRESULT_FROM_WIN32(uError);
+        }
+
+        HRESULT hr = mapFile(region.hFile, region.hMapping, region.pView, region.uViewSize);
+        if (FAILED(hr))
+        {
+            closeRegion(region);
+            return hr;
+        }
+
+        UINT uNumEntries = getNumEntries();
+        UINT64 uSlotSize = static_cast<UINT64>(getNumTableSectors()) * SECTOR_SIZE;
+        for (UINT uSlot = 0u; uSlot < 2u; ++uSlot)
+        {
+            if (region.uViewSize < uSlotSize * (uSlot + 1u))
+            {
+                break;
+            }
+
+            RegionHeader header;
+            memcpy(&header, region.pView + uSlotSize * uSlot, sizeof(header));
+            const SectorRange* pEntries = reinterpret_cast<const SectorRange*>(region.pView + uSlotSize * uSlot + sizeof(header));
+            if (header.uMagic != FILE_MAGIC || header.uVersion != FILE_VERSION || header.uRegionSize != REGION_SIZE ||
+                header.uNumChunksY != m_uNumChunksY || header.uNumEntries != uNumEntries ||
+                header.uChecksum != getChecksum(header, pEntries))
+            {
+                continue;
+            }
+
+            if (header.uGeneration > region.uGeneration)
+            {
+                region.uTableSlot = uSlot;
+                region.uGeneration = header.uGeneration;
+                memcpy(region.aEntries.data(), pEntries, static_cast<size_t>(uNumEntries) * sizeof(SectorRange));
+            }
+        }
+
+        for (SectorRange& entry : region.aEntries)
+        {
+            if (entry.uNumBytes == 0u)
+            {
+                continue;
+            }
+
+            if (static_cast<UINT64>(entry.uFirstSector) * SECTOR_SIZE + entry.uNumBytes > region.uViewSize)
+            {
+                // Chunk cut off by a damaged file, the generated terrain is kept instead
+                entry = { 0u, 0u };
+                continue;
+            }
+
+            UINT uEndSector = entry.uFirstSector + (entry.uNumBytes + SECTOR_SIZE - 1u) / SECTOR_SIZE;
+            if (region.aUsedSectors.size() < uEndSector)
+            {
+                region.aUsedSectors.resize(uEndSector, FALSE);
+            }
+            std::fill(region.aUsedSectors.begin() + entry.uFirstSector, region.aUsedSectors.begin() + uEndSector, TRUE);
+        }
+
+        pOutRegion = &region;
+
+        return S_OK;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::saveChunks
+
+      Summary:  Writes chunks into their region files one region at a
+                time together with the chunks that failed to save
+                before, runs on the save thread. The chunks of a region
+                whose table was not committed are kept for the next
+                save. The mutex is only held to look up the regions and
+                to record the results, see writeRegion.
+
+      Args:     std::vector<VoxelChunkBlocks>& aChunks
+                  Chunks to save
+
+      Modifies: [m_regions, m_aFailedChunks, m_saveResult].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelRegionStore::saveChunks(_Inout_ std::vector<VoxelChunkBlocks>& aChunks)
+    {
+        {
+            // A newer copy of a chunk comes later and replaces the failed one
+            std::lock_guard<std::mutex> lock(m_mutex);
+            aChunks.insert(aChunks.begin(), std::make_move_iterator(m_aFailedChunks.begin()), std::make_move_iterator(m_aFailedChunks.end()));
+            m_aFailedChunks.clear();
+        }
+
+        std::vector<const VoxelChunkBlocks*> aSortedChunks(aChunks.size());
+        for (size_t i = 0u; i < aChunks.size(); ++i)
+        {
+            aSortedChunks[i] = &aChunks[i];
+        }
+
+        auto getRegionKey = [](const VoxelChunkBlocks* pChunk)
+        {
+            return (static_cast<UINT64>(pChunk->Chunk.z / REGION_SIZE) << 32u) | (pChunk->Chunk.x / REGION_SIZE);
+        };
+        std::stable_sort(aSortedChunks.begin(), aSortedChunks.end(), [this, &getRegionKey](const VoxelChunkBlocks* pA, const VoxelChunkBlocks* pB)
+        {
+            UINT64 uRegionKeyA = getRegionKey(pA);
+            UINT64 uRegionKeyB = getRegionKey(pB);
+
+            return uRegionKeyA != uRegionKeyB ? uRegionKeyA < uRegionKeyB : getEntryIndex(pA->Chunk) < getEntryIndex(pB->Chunk);
+        });
+
+        // Only the newest copy of a chunk is written, the last of its copies after the stable sort
+        size_t uNumUniqueChunks = 0u;
+        for (size_t i = 0u; i < aSortedChunks.size(); ++i)
+        {
+            if (i + 1u < aSortedChunks.size() && getRegionKey(aSortedChunks[i]) == getRegionKey(aSortedChunks[i + 1u]) &&
+                getEntryIndex(aSortedChunks[i]->Chunk) == getEntryIndex(aSortedChunks[i + 1u]->Chunk))
+            {
+                continue;
+            }
+
+            aSortedChunks[uNumUniqueChunks++] = aSortedChunks[i];
+        }
+        aSortedChunks.resize(uNumUniqueChunks);
+
+        std::vector<const VoxelChunkBlocks*> aRegionChunks;
+        for (size_t uBegin = 0u; uBegin < aSortedChunks.size(); uBegin += aRegionChunks.size())
+        {
+            aRegionChunks.clear();
+            for (size_t i = uBegin; i < aSortedChunks.size() && getRegionKey(aSortedChunks[i]) == getRegionKey(aSortedChunks[uBegin]); ++i)
+            {
+                aRegionChunks.push_back(aSortedChunks[i]);
+            }
+
+            // The region stays in m_regions until Close, which waits for the saves
+            Region* pRegion = nullptr;
+            HRESULT hr = S_OK;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                hr = openRegion(aRegionChunks[0]->Chunk.x / REGION_SIZE, aRegionChunks[0]->Chunk.z / REGION_SIZE, TRUE, pRegion);
+            }
+
+            HRESULT mapResult = S_OK;
+            if (SUCCEEDED(hr))
+            {
+                hr = writeRegion(*pRegion, aRegionChunks, mapResult);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (FAILED(hr))
+            {
+                for (const VoxelChunkBlocks* pChunk : aRegionChunks)
+                {
+                    m_aFailedChunks.push_back(*pChunk);
+                }
+            }
+
+            // The chunks of a region that could not be mapped again are saved, only their reads fail until the next save
+            hr = FAILED(hr) ? hr : mapResult;
+            if (FAILED(hr) && SUCCEEDED(m_saveResult))
+            {
+                m_saveResult = hr;
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelRegionStore::writeRegion
+
+      Summary:  Copy-on-write save of chunks of one region. The chunks
+                go to free sectors and are flushed before the table
+                that points at them is written into the older slot, so
+                the live slot stays valid until the new one is complete.
+                The sectors of the replaced chunks are freed once the
+                new slot is flushed.
+
+                Runs on the save thread, which is the only writer of
+                the tables and sectors of the regions. The chunks are
+                encoded, written and flushed without the mutex, which
+                is only held to allocate the sectors and to publish the
+                committed table together with a view that covers it, so
+                ReadChunk never waits for the disk.
+
+      Args:     Region& region
+                  Region with an open file
+                const std::vector<const VoxelChunkBlocks*>& aChunks
+                  Chunks of the region to save
+                HRESULT& outMapResult
+                  Status of mapping the file again after the table was
+                  committed, the previous view is kept on failure
+
+      Modifies: [region].
+
+      Returns:  HRESULT
+                  Status of the commit, the live slot is unchanged on
+                  failure and the chunks are saved on success
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelRegionStore::writeRegion(_Inout_ Region& region, _In_ const std::vector<const VoxelChunkBlocks*>& aChunks, _Out_ HRESULT& outMapResult)
+    {
+        outMapResult = S_OK;
+
+        std::vector<std::vector<BYTE>> aEncodedChunks(aChunks.size());
+        for (size_t i = 0u; i < aChunks.size(); ++i)
+        {
+            EncodeChunk(aChunks[i]->Blocks.data(), aEncodedChunks[i]);
+        }
+
+        std::vector<SectorRange> aEntries;
+        std::vector<SectorRange> aWrittenEntries;
+        std::vector<SectorRange> aReplacedEntries;
+        UINT uSlot = 0u;
+        UINT64 uGeneration = 0u;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            aEntries = region.aEntries;
+            uSlot = region.uTableSlot ^ 1u;
+            uGeneration = region.uGeneration + 1u;
+            for (size_t i = 0u; i < aChunks.size(); ++i)
+            {
+                UINT uNumBytes = static_cast<UINT>(aEncodedChunks[i].size());
+                UINT uFirstSector = allocateSectors(region, (uNumBytes + SECTOR_SIZE - 1u) / SECTOR_SIZE);
+                aWrittenEntries.push_back({ uFirstSector, uNumBytes });
+
+                SectorRange& entry = aEntries[getEntryIndex(aChunks[i]->Chunk)];
+                if (entry.uNumBytes > 0u)
+                {
+                    aReplacedEntries.push_back(entry);
+                }
+                entry = aWrittenEntries.back();
+            }
+        }
+
+        // The new sectors are free in the live table, so nothing reads them while they are written
+        HRESULT hr = S_OK;
+        for (size_t i = 0u; i < aChunks.size() && SUCCEEDED(hr); ++i)
+        {
+            hr = writeBytes(region.hFile, static_cast<UINT64>(aWrittenEntries[i].uFirstSector) * SECTOR_SIZE, aEncodedChunks[i].data(), aWrittenEntries[i].uNumBytes);
+        }
+
+        if (SUCCEEDED(hr) && !FlushFileBuffers(region.hFile))
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        RegionHeader header =
+        {
+            .uMagic = FILE_MAGIC,
+            .uVersion = FILE_VERSION,
+            .uRegionSize = REGION_SIZE,
+            .uNumChunksY = m_uNumChunksY,
+            .uGeneration = uGeneration,
+            .uNumEntries = static_cast<UINT>(aEntries.size()),
+            .uChecksum = 0u,
+        };
+        header.uChecksum = getChecksum(header, aEntries.data());
+
+        if (SUCCEEDED(hr))
+        {
+            std::vector<BYTE> aTableBytes(static_cast<size_t>(getNumTableSectors()) * SECTOR_SIZE, static_cast<BYTE>(0u));
+            memcpy(aTableBytes.data(), &header, sizeof(header));
+            memcpy(aTableBytes.data() + sizeof(header), aEntries.data(), aEntries.size() * sizeof(SectorRange));
+
+            hr = writeBytes(region.hFile, static_cast<UINT64>(uSlot) * aTableBytes.size(), aTableBytes.data(), static_cast<UINT>(aTableBytes.size()));
+        }
+
+        if (SUCCEEDED(hr) && !FlushFileBuffers(region.hFile))
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        if (FAILED(hr))
+        {
+            // The live slot still points at the old chunks, only the new sectors are given back
+            std::lock_guard<std::mutex> lock(m_mutex);
+            freeSectors(region, aWrittenEntries);
+            return hr;
+        }
+
+        // The table is committed, the new view is made while the chunks are still read from the old one
+        HANDLE hMapping = nullptr;
+        const BYTE* pView = nullptr;
+        UINT64 uViewSize = 0u;
+        outMapResult = mapFile(region.hFile, hMapping, pView, uViewSize);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            region.aEntries = std::move(aEntries);
+            region.uTableSlot = uSlot;
+            region.uGeneration = header.uGeneration;
+            freeSectors(region, aReplacedEntries);
+
+            if (SUCCEEDED(outMapResult))
+            {
+                std::swap(region.hMapping, hMapping);
+                std::swap(region.pView, pView);
+                std::swap(region.uViewSize, uViewSize);
+            }
+        }
+
+        // The old view, no read uses it once the mutex is released
+        unmapFile(hMapping, pView);
+
+        return S_OK;
+    }
+}
@@ -0,0 +1,195 @@
+/*+===================================================================
+  File:      VOXELREGIONSTORE.H
+
+  Summary:   VoxelRegionStore header file contains declarations of the
+             VoxelRegionStore class that keeps the edited chunks of a
+             voxel grid in region files.
+
+  Classes: VoxelRegionStore
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <mutex>
+
+#include "Scene/VoxelGrid.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   VoxelChunkBlocks
+
+      Summary:  Copy of the block types of a chunk of a voxel grid, in
+                the cell order of VoxelGrid::ReadChunk
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct VoxelChunkBlocks
+    {
+        XMUINT3 Chunk;
+        std::vector<eBlockType> Blocks;
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelRegionStore
+
+      Summary:  Directory of region files, each holding the saved chunks
+                of REGION_SIZE x REGION_SIZE chunk columns of a grid.
+
+                A region file starts with two slots of a sector table,
+                which gives the first sector and the size of every saved
+                chunk, followed by SECTOR_SIZE sectors of run-length
+                encoded chunks. Saves are copy-on-write: the chunks are
+                written into free sectors, then the table is written
+                into the older slot with the next generation and a
+                checksum, and only then are the sectors of the replaced
+                chunks freed. A save that is cut short leaves the
+                previous table and every chunk it points at intact.
+
+                A region file is memory-mapped when a chunk of it is
+                first read, and a chunk is only decoded when it is read.
+                Saves run on a background thread on copies of the
+                chunks, so the frame loop never waits for the disk:
+                reads only wait while the save thread allocates sectors
+                or publishes a committed table, never while it encodes,
+                writes or flushes. The chunks of a region that failed
+                to save are written again with the next save.
+
+      Methods:  EncodeChunk
+                  Run-length encodes the block types of a chunk
+                DecodeChunk
+                  Decodes the block types of a chunk
+                Open
+                  Sets the directory and the size of the grid
+                Close
+                  Waits for the saves and unmaps the region files
+                GetDirectoryPath
+                  Returns the directory of the region files
+                GetStoredChunks
+                  Returns the chunks saved in the region files
+                IsOpen
+                  Returns whether a directory is open
+                ReadChunk
+                  Decodes the block types of a saved chunk
+                SaveAsync
+                  Queues chunks to be saved on the background thread
+                WaitForSaves
+                  Waits until the queued saves are written
+                VoxelRegionStore
+                  Constructor.
+                ~VoxelRegionStore
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelRegionStore
+    {
+    public:
+        static constexpr const UINT REGION_SIZE = 16u;
+        static constexpr const UINT SECTOR_SIZE = 4096u;
+        static constexpr const UINT FILE_MAGIC = 0x47525856u;
+        static constexpr const UINT FILE_VERSION = 1u;
+
+    public:
+        VoxelRegionStore();
+        VoxelRegionStore(const VoxelRegionStore& other) = delete;
+        VoxelRegionStore(VoxelRegionStore&& other) = delete;
+        VoxelRegionStore& operator=(const VoxelRegionStore& other) = delete;
+        VoxelRegionStore& operator=(VoxelRegionStore&& other) = delete;
+        ~VoxelRegionStore();
+
+        static void EncodeChunk(_In_reads_(VoxelGrid::NUM_CHUNK_CELLS) const eBlockType* pBlocks, _Out_ std::vector<BYTE>& aOutBytes);
+        static HRESULT DecodeChunk(_In_reads_bytes_(uNumBytes) const BYTE* pBytes, _In_ UINT uNumBytes, _Out_writes_(VoxelGrid::NUM_CHUNK_CELLS) eBlockType* pOutBlocks);
+
+        HRESULT Open(_In_ const std::filesystem::path& directoryPath, _In_ UINT uNumChunksX, _In_ UINT uNumChunksY, _In_ UINT uNumChunksZ);
+        void Close();
+
+        const std::filesystem::path& GetDirectoryPath() const;
+        HRESULT GetStoredChunks(_Out_ std::vector<XMUINT3>& aOutChunks);
+        BOOL IsOpen() const;
+        HRESULT ReadChunk(_In_ const XMUINT3& chunk, _Out_writes_(VoxelGrid::NUM_CHUNK_CELLS) eBlockType* pOutBlocks, _Out_ BOOL& bOutFound);
+
+        HRESULT SaveAsync(_In_ std::vector<VoxelChunkBlocks>&& aChunks);
+        HRESULT WaitForSaves();
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   RegionHeader
+
+          Summary:  Start of a table slot, followed by uNumEntries
+                    sector ranges. The checksum covers the header with
+                    a zero checksum and the sector ranges.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct RegionHeader
+        {
+            UINT uMagic;
+            UINT uVersion;
+            UINT uRegionSize;
+            UINT uNumChunksY;
+            UINT64 uGeneration;
+            UINT uNumEntries;
+            UINT uChecksum;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   SectorRange
+
+          Summary:  Encoded chunk in a region file, no chunk is saved if
+                    uNumBytes is 0
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct SectorRange
+        {
+            UINT uFirstSector;
+            UINT uNumBytes;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   Region
+
+          Summary:  Open region file with its mapped view, its live
+                    sector table and the sectors in use. A region
+                    without a file has an invalid file handle and no
+                    saved chunks.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Region
+        {
+            HANDLE hFile;
+            HANDLE hMapping;
+            const BYTE* pView;
+            UINT64 uViewSize;
+            UINT uTableSlot;
+            UINT64 uGeneration;
+            std::vector<SectorRange> aEntries;
+            std::vector<BOOL> aUsedSectors;
+        };
+
+        static UINT allocateSectors(_Inout_ Region& region, _In_ UINT uNumSectors);
+        static void closeRegion(_Inout_ Region& region);
+        static void freeSectors(_Inout_ Region& region, _In_ const std::vector<SectorRange>& aEntries);
+        static UINT getChecksum(_In_ const RegionHeader& header, _In_reads_(header.uNumEntries) const SectorRange* pEntries);
+        static HRESULT mapFile(_In_ HANDLE hFile, _Out_ HANDLE& hOutMapping, _Out_ const BYTE*& pOutView, _Out_ UINT64& uOutViewSize);
+        static void unmapFile(_In_opt_ HANDLE hMapping, _In_opt_ const BYTE* pView);
+        static HRESULT writeBytes(_In_ HANDLE hFile, _In_ UINT64 uOffset, _In_reads_bytes_(uNumBytes) const void* pData, _In_ UINT uNumBytes);
+
+        UINT getEntryIndex(_In_ const XMUINT3& chunk) const;
+        UINT getNumEntries() const;
+        UINT getNumTableSectors() const;
+        std::filesystem::path getRegionPath(_In_ UINT uRegionX, _In_ UINT uRegionZ) const;
+        HRESULT openRegion(_In_ UINT uRegionX, _In_ UINT uRegionZ, _In_ BOOL bCreate, _Out_ Region*& pOutRegion);
+        void saveChunks(_Inout_ std::vector<VoxelChunkBlocks>& aChunks);
+        HRESULT writeRegion(_Inout_ Region& region, _In_ const std::vector<const VoxelChunkBlocks*>& aChunks, _Out_ HRESULT& outMapResult);
+
+    private:
+        std::filesystem::path m_directoryPath;
+        UINT m_uNumChunksX;
+        UINT m_uNumChunksY;
+        UINT m_uNumChunksZ;
+
+        // Guards the regions, their tables, sectors and views, and the save results between the frame loop and the save thread
+        std::mutex m_mutex;
+        std::unordered_map<UINT64, std::unique_ptr<Region>> m_regions;
+        std::vector<VoxelChunkBlocks> m_aFailedChunks;
+        HRESULT m_saveResult;
+        ThreadPool m_saveThread;
+    };
+}
@@ -0,0 +1,970 @@
+#include "Scene/VoxelWorld.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::VoxelWorld
+
+      Summary:  Constructor
+
+      Args:     const TerrainGenerator& generator
+                  Generator of the map, copied
+                UINT uHeight
+                  Number of voxels of a full column
+                const std::shared_ptr<ThreadPool>& threadPool
+                  Pool to generate the chunks on, the chunks are
+                  generated inside Update if nullptr
+
+      Modifies: [m_sharedState, m_threadPool, m_device,
+                 m_immediateContext, m_pGeometryRegistry,
+                 m_paletteBuffer, m_vertexShader,
+                 m_pixelShader, m_material, m_chunks, m_aUploadQueue, m_aDrawnChunks,
+                 m_aVisibleChunks, m_horizonCuller, m_aOccluderBounds,
+                 m_aChunkBounds, m_aIsVisible, m_voxels, m_uViewDistance,
+                 m_uUploadBudget, m_uNumLodLevels, m_lodDistance,
+                 m_bOcclusionCulling, m_uMaxResidentBytes,
+                 m_uFrameIdx, m_totalGenerationLatency, m_bVoxelsDirty,
+                 m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelWorld::VoxelWorld(_In_ const TerrainGenerator& generator, _In_ UINT uHeight, _In_ const std::shared_ptr<ThreadPool>& threadPool)
+        : m_sharedState(std::make_shared<SharedState>(generator, uHeight))
+        , m_threadPool(threadPool)
+        , m_device()
+        , m_immediateContext()
+        , m_pGeometryRegistry(nullptr)
+        , m_paletteBuffer()
+        , m_vertexShader()
+        , m_pixelShader()
+        , m_material()
+        , m_chunks()
+        , m_aUploadQueue()
+        , m_aDrawnChunks()
+        , m_aVisibleChunks()
+        , m_horizonCuller()
+        , m_aOccluderBounds()
+        , m_aChunkBounds()
+        , m_aIsVisible()
+        , m_voxels()
+        , m_uViewDistance(DEFAULT_VIEW_DISTANCE)
+        , m_uUploadBudget(DEFAULT_UPLOAD_BUDGET)
+        , m_uNumLodLevels(DEFAULT_NUM_LOD_LEVELS)
+        , m_lodDistance(DEFAULT_LOD_DISTANCE)
+        , m_bOcclusionCulling(TRUE)
+        , m_uMaxResidentBytes(DEFAULT_MAX_RESIDENT_BYTES)
+        , m_uFrameIdx(0u)
+        , m_totalGenerationLatency(0.0f)
+        , m_bVoxelsDirty(FALSE)
+        , m_statistics()
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::~VoxelWorld
+
+      Summary:  Destructor. Queued generation tasks that have not
+                started yet are skipped.
+
+      Modifies: [m_sharedState].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    VoxelWorld::~VoxelWorld()
+    {
+        std::lock_guard<std::mutex> lock(m_sharedState->mutex);
+        m_sharedState->bCancelled = TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::Initialize
+
+      Summary:  Stores the device and the geometry registry that the
+                chunks are uploaded with and creates the palette of the
+                block colors
+
+      Args:     ID3D11Device* pDevice
+                  The Direct3D device to create the buffers
+                ID3D11DeviceContext* pImmediateContext
+                  The Direct3D context to set buffers
+                GeometryRegistry* pGeometryRegistry
+                  Shared buffers of the device, may be nullptr
+
+      Modifies: [m_device, m_immediateContext, m_pGeometryRegistry,
+                 m_paletteBuffer].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT VoxelWorld::Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry)
+    {
+        if (!pDevice || !pImmediateContext)
+        {
+            return E_INVALIDARG;
+        }
+
+        m_device = pDevice;
+        m_immediateContext = pImmediateContext;
+        m_pGeometryRegistry = pGeometryRegistry;
+
+        // Every chunk is generated with the default colors
+        std::vector<XMFLOAT4> aColors(TerrainGenerator::DEFAULT_COLORS, TerrainGenerator::DEFAULT_COLORS + ARRAYSIZE(TerrainGenerator::DEFAULT_COLORS));
+        return Voxel::CreatePaletteBuffer(pDevice, aColors, m_paletteBuffer);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::Update
+
+      Summary:  Streams the chunks around an eye position, called once
+                per frame
+
+      Args:     FXMVECTOR eye
+                  Position of the camera
+
+      Modifies: [m_uFrameIdx, m_chunks, m_aUploadQueue, m_aDrawnChunks,
+                 m_aVisibleChunks, m_voxels, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::Update(_In_ FXMVECTOR eye)
+    {
+        ++m_uFrameIdx;
+
+        // Clamp before the conversion so far away eyes cannot overflow the chunk coordinates. Chunk x spans
+        // [CHUNK_EXTENT * x - 1, CHUNK_EXTENT * (x + 1) - 1) since the blocks are centered on even coordinates.
+        constexpr const FLOAT LIMIT = static_cast<FLOAT>(MAX_CHUNK_COORD + 1);
+        FLOAT eyeX = (XMVectorGetX(eye) + 1.0f) / CHUNK_EXTENT;
+        FLOAT eyeZ = (XMVectorGetZ(eye) + 1.0f) / CHUNK_EXTENT;
+        eyeX = eyeX < -LIMIT ? -LIMIT : (eyeX > LIMIT ? LIMIT : eyeX);
+        eyeZ = eyeZ < -LIMIT ? -LIMIT : (eyeZ > LIMIT ? LIMIT : eyeZ);
+
+        FLOAT radius = static_cast<FLOAT>(m_uViewDistance);
+        FLOAT rootSize = static_cast<FLOAT>(1u << m_uNumLodLevels);
+        INT minRootX = static_cast<INT>(std::floor((eyeX - radius) / rootSize));
+        INT maxRootX = static_cast<INT>(std::floor((eyeX + radius) / rootSize));
+        INT minRootZ = static_cast<INT>(std::floor((eyeZ - radius) / rootSize));
+        INT maxRootZ = static_cast<INT>(std::floor((eyeZ + radius) / rootSize));
+
+        std::vector<ChunkNode> aLeaves;
+        for (INT z = minRootZ; z <= maxRootZ; ++z)
+        {
+            for (INT x = minRootX; x <= maxRootX; ++x)
+            {
+                if (getNodeDistance(eyeX, eyeZ, m_uNumLodLevels, x, z) <= radius)
+                {
+                    selectChunks(eyeX, eyeZ, m_uNumLodLevels, x, z, aLeaves);
+                }
+            }
+        }
+
+        std::sort(aLeaves.begin(), aLeaves.end(), [](const ChunkNode& a, const ChunkNode& b)
+            {
+                return a.distance < b.distance;
+            });
+
+        requestChunks(aLeaves);
+        collectChunks();
+        uploadChunks(eyeX, eyeZ);
+        selectDrawnChunks(aLeaves);
+        evictChunks();
+        cullChunks(eye);
+
+        if (m_bVoxelsDirty)
+        {
+            rebuildVoxels();
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::GetPaletteBuffer
+
+      Summary:  Returns the constant buffer of the block colors of the
+                voxels, nullptr until initialized
+
+      Returns:  ComPtr<ID3D11Buffer>&
+                  Constant buffer of the block colors
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ComPtr<ID3D11Buffer>& VoxelWorld::GetPaletteBuffer()
+    {
+        return m_paletteBuffer;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::GetStatistics
+
+      Summary:  Returns the streaming counters
+
+      Returns:  const VoxelWorld::Statistics&
+                  Streaming counters
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const VoxelWorld::Statistics& VoxelWorld::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::GetVisibleChunks
+
+      Summary:  Returns the chunks whose voxels GetVoxels returns, at
+                the level of detail they are drawn with
+
+      Returns:  const std::vector<std::shared_ptr<VoxelChunk>>&
+                  Chunks in view
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const std::vector<std::shared_ptr<VoxelChunk>>& VoxelWorld::GetVisibleChunks() const
+    {
+        return m_aVisibleChunks;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::GetVoxels
+
+      Summary:  Returns the voxels of the chunks in view
+
+      Returns:  std::vector<std::shared_ptr<Voxel>>&
+                  Voxels
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::vector<std::shared_ptr<Voxel>>& VoxelWorld::GetVoxels()
+    {
+        return m_voxels;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetLodDistance
+
+      Summary:  Sets the distance at which chunks are split into their
+                finer children
+
+      Args:     FLOAT lodDistance
+                  A chunk of level L is split while it is closer than
+                  lodDistance * 2^L level 0 chunks to the eye
+
+      Modifies: [m_lodDistance].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetLodDistance(_In_ FLOAT lodDistance)
+    {
+        m_lodDistance = lodDistance > 0.0f ? lodDistance : 0.0f;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetMaterial
+
+      Summary:  Sets the material of the voxels uploaded from now on
+
+      Args:     const std::shared_ptr<Material>& material
+                  Material of the voxels
+
+      Modifies: [m_material].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetMaterial(_In_ const std::shared_ptr<Material>& material)
+    {
+        m_material = material;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetMaxResidentBytes
+
+      Summary:  Sets the memory cap of the resident chunks. Chunks in
+                view are never evicted, so the cap can be exceeded when
+                it is too small for the view distance.
+
+      Args:     size_t uMaxResidentBytes
+                  Size of the packed instances of all resident chunks
+
+      Modifies: [m_uMaxResidentBytes].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetMaxResidentBytes(_In_ size_t uMaxResidentBytes)
+    {
+        m_uMaxResidentBytes = uMaxResidentBytes;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetNumLodLevels
+
+      Summary:  Sets the number of coarser levels of detail. With 0
+                every chunk is full resolution.
+
+      Args:     UINT uNumLodLevels
+                  Number of levels, at most VoxelChunk::MAX_LEVEL
+
+      Modifies: [m_uNumLodLevels].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetNumLodLevels(_In_ UINT uNumLodLevels)
+    {
+        m_uNumLodLevels = uNumLodLevels < VoxelChunk::MAX_LEVEL ? uNumLodLevels : VoxelChunk::MAX_LEVEL;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetOcclusionCulling
+
+      Summary:  Enables the culling of chunks hidden behind nearer
+                terrain, enabled by default
+
+      Args:     BOOL bOcclusionCulling
+                  TRUE to cull hidden chunks
+
+      Modifies: [m_bOcclusionCulling].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetOcclusionCulling(_In_ BOOL bOcclusionCulling)
+    {
+        m_bOcclusionCulling = bOcclusionCulling;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetPixelShader
+
+      Summary:  Sets the pixel shader of the resident and future voxels
+
+      Args:     const std::shared_ptr<PixelShader>& pixelShader
+                  Pixel shader of the voxels
+
+      Modifies: [m_pixelShader, m_voxels].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetPixelShader(_In_ const std::shared_ptr<PixelShader>& pixelShader)
+    {
+        m_pixelShader = pixelShader;
+
+        for (std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            voxel->SetPixelShader(pixelShader);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetUploadBudget
+
+      Summary:  Sets the number of chunks uploaded per frame
+
+      Args:     UINT uNumChunksPerFrame
+                  Number of chunks, at least 1
+
+      Modifies: [m_uUploadBudget].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetUploadBudget(_In_ UINT uNumChunksPerFrame)
+    {
+        m_uUploadBudget = uNumChunksPerFrame > 0u ? uNumChunksPerFrame : 1u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetVertexShader
+
+      Summary:  Sets the vertex shader of the resident and future voxels
+
+      Args:     const std::shared_ptr<VertexShader>& vertexShader
+                  Vertex shader of the voxels, with the PACKED_VOXEL
+                  instance layout
+
+      Modifies: [m_vertexShader, m_voxels].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetVertexShader(_In_ const std::shared_ptr<VertexShader>& vertexShader)
+    {
+        m_vertexShader = vertexShader;
+
+        for (std::shared_ptr<Voxel>& voxel : m_voxels)
+        {
+            voxel->SetVertexShader(vertexShader);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::SetViewDistance
+
+      Summary:  Sets the radius of the streamed area
+
+      Args:     UINT uNumChunks
+                  Radius in chunks
+
+      Modifies: [m_uViewDistance].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::SetViewDistance(_In_ UINT uNumChunks)
+    {
+        m_uViewDistance = uNumChunks;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::getChunkKey
+
+      Summary:  Packs the level and the coordinates of a chunk into a
+                map key
+
+      Args:     UINT uLevel
+                  Level of detail
+                INT x
+                  Chunk coordinate along the x-axis
+                INT z
+                  Chunk coordinate along the z-axis
+
+      Returns:  UINT64
+                  Key of the chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT64 VoxelWorld::getChunkKey(_In_ UINT uLevel, _In_ INT x, _In_ INT z)
+    {
+        return (static_cast<UINT64>(uLevel) << 56u) |
+            ((static_cast<UINT64>(static_cast<UINT>(x)) & 0xFFFFFFFull) << 28u) |
+            (static_cast<UINT64>(static_cast<UINT>(z)) & 0xFFFFFFFull);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::getNodeDistance
+
+      Summary:  Returns the distance from the eye to the nearest point
+                of a chunk
+
+      Args:     FLOAT eyeX
+                  Position of the eye along the x-axis, in level 0
+                  chunks
+                FLOAT eyeZ
+                  Position of the eye along the z-axis, in level 0
+                  chunks
+                UINT uLevel
+                  Level of detail of the chunk
+                INT x
+                  Chunk coordinate along the x-axis
+                INT z
+                  Chunk coordinate along the z-axis
+
+      Returns:  FLOAT
+                  Distance in level 0 chunks, 0 inside the chunk
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    FLOAT VoxelWorld::getNodeDistance(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uLevel, _In_ INT x, _In_ INT z)
+    {
+        FLOAT size = static_cast<FLOAT>(1u << uLevel);
+        FLOAT minX = static_cast<FLOAT>(x) * size;
+        FLOAT minZ = static_cast<FLOAT>(z) * size;
+
+        FLOAT dx = eyeX < minX ? minX - eyeX : (eyeX > minX + size ? eyeX - minX - size : 0.0f);
+        FLOAT dz = eyeZ < minZ ? minZ - eyeZ : (eyeZ > minZ + size ? eyeZ - minZ - size : 0.0f);
+
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::isValidNode
+
+      Summary:  Returns whether a chunk lies inside the map
+
+      Args:     UINT uLevel
+                  Level of detail of the chunk
+                INT x
+                  Chunk coordinate along the x-axis
+                INT z
+                  Chunk coordinate along the z-axis
+
+      Returns:  BOOL
+                  TRUE if all level 0 chunks it covers are within
+                  MAX_CHUNK_COORD
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL VoxelWorld::isValidNode(_In_ UINT uLevel, _In_ INT x, _In_ INT z)
+    {
+        INT size = 1 << uLevel;
+
+        return x * size >= -MAX_CHUNK_COORD && (x + 1) * size - 1 <= MAX_CHUNK_COORD &&
+            z * size >= -MAX_CHUNK_COORD && (z + 1) * size - 1 <= MAX_CHUNK_COORD;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::findResidentChunk
+
+      Summary:  Finds an uploaded chunk
+
+      Args:     UINT uLevel
+                  Level of detail of the chunk
+                INT x
+                  Chunk coordinate along the x-axis
+                INT z
+                  Chunk coordinate along the z-axis
+
+      Returns:  std::shared_ptr<VoxelChunk>
+                  The chunk, nullptr if it is not resident
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::shared_ptr<VoxelChunk> VoxelWorld::findResidentChunk(_In_ UINT uLevel, _In_ INT x, _In_ INT z) const
+    {
+        auto it = m_chunks.find(getChunkKey(uLevel, x, z));
+        if (it == m_chunks.end() || it->second->GetState() != eChunkState::RESIDENT)
+        {
+            return nullptr;
+        }
+
+        return it->second;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::selectChunks
+
+      Summary:  Walks the level of detail quadtree below a chunk and
+                collects the chunks to show. A chunk is split while it
+                is closer than the LOD distance times its width, or when
+                it reaches outside the map.
+
+      Args:     FLOAT eyeX
+                  Position of the eye along the x-axis, in level 0
+                  chunks
+                FLOAT eyeZ
+                  Position of the eye along the z-axis, in level 0
+                  chunks
+                UINT uLevel
+                  Level of detail of the chunk
+                INT x
+                  Chunk coordinate along the x-axis
+                INT z
+                  Chunk coordinate along the z-axis
+                std::vector<ChunkNode>& aLeaves
+                  Chunks to show, appended to
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::selectChunks(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uLevel, _In_ INT x, _In_ INT z, _Inout_ std::vector<ChunkNode>& aLeaves) const
+    {
+        FLOAT distance = getNodeDistance(eyeX, eyeZ, uLevel, x, z);
+        BOOL bIsValid = isValidNode(uLevel, x, z);
+        if (uLevel == 0u)
+        {
+            if (bIsValid && distance <= static_cast<FLOAT>(m_uViewDistance))
+            {
+                aLeaves.push_back(ChunkNode{ .distance = distance, .uLevel = uLevel, .x = x, .z = z });
+            }
+            return;
+        }
+
+        if (bIsValid && distance >= m_lodDistance * static_cast<FLOAT>(1u << uLevel))
+        {
+            aLeaves.push_back(ChunkNode{ .distance = distance, .uLevel = uLevel, .x = x, .z = z });
+            return;
+        }
+
+        for (INT childZ = 2 * z; childZ <= 2 * z + 1; ++childZ)
+        {
+            for (INT childX = 2 * x; childX <= 2 * x + 1; ++childX)
+            {
+                selectChunks(eyeX, eyeZ, uLevel - 1u, childX, childZ, aLeaves);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::requestChunks
+
+      Summary:  Marks the selected chunks as used and queues the
+                generation of the missing ones, nearest first. At most
+                two chunks per worker thread are in flight, so a fast
+                camera does not fill the queue with chunks it has
+                already left behind.
+
+      Args:     const std::vector<ChunkNode>& aLeaves
+                  Selected chunks, sorted by distance
+
+      Modifies: [m_chunks, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::requestChunks(_In_ const std::vector<ChunkNode>& aLeaves)
+    {
+        UINT uMaxPendingChunks = m_threadPool ? 2u * m_threadPool->GetNumThreads() : 1u;
+        for (const ChunkNode& leaf : aLeaves)
+        {
+            UINT64 uKey = getChunkKey(leaf.uLevel, leaf.x, leaf.z);
+            auto it = m_chunks.find(uKey);
+            if (it != m_chunks.end())
+            {
+                it->second->SetLastUsedFrame(m_uFrameIdx);
+                continue;
+            }
+
+            if (m_statistics.uNumPendingChunks >= uMaxPendingChunks)
+            {
+                continue;
+            }
+
+            std::shared_ptr<VoxelChunk> chunk = std::make_shared<VoxelChunk>(leaf.x, leaf.z, leaf.uLevel);
+            chunk->SetLastUsedFrame(m_uFrameIdx);
+            m_chunks.emplace(uKey, chunk);
+            ++m_statistics.uNumPendingChunks;
+
+            INT extent = static_cast<INT>(VoxelChunk::SIZE << leaf.uLevel);
+            UINT uOriginX = static_cast<UINT>(static_cast<INT>(WORLD_ORIGIN) + leaf.x * extent);
+            UINT uOriginZ = static_cast<UINT>(static_cast<INT>(WORLD_ORIGIN) + leaf.z * extent);
+            auto task = [sharedState = m_sharedState, chunk, uOriginX, uOriginZ]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(sharedState->mutex);
+                    if (sharedState->bCancelled)
+                    {
+                        return;
+                    }
+                }
+
+                // The chunk stays GENERATING here, collectChunks publishes it on the rendering thread
+                HRESULT hr = chunk->Generate(sharedState->generator, sharedState->uHeight, uOriginX, uOriginZ);
+
+                std::lock_guard<std::mutex> lock(sharedState->mutex);
+                if (SUCCEEDED(hr))
+                {
+                    sharedState->aFinishedChunks.push_back(chunk);
+                }
+                else
+                {
+                    sharedState->aFailedChunks.push_back(chunk);
+                }
+            };
+
+            if (m_threadPool)
+            {
+                m_threadPool->Enqueue(std::move(task));
+            }
+            else
+            {
+                task();
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::collectChunks
+
+      Summary:  Moves the chunks that finished generating to the upload
+                queue and marks them GENERATED. The state is only
+                written here, on the rendering thread, after the mutex
+                handed the chunk over, so findResidentChunk and
+                evictChunks never read it while a worker writes it.
+                Chunks that failed to generate are dropped.
+
+      Modifies: [m_chunks, m_aUploadQueue, m_totalGenerationLatency,
+                 m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::collectChunks()
+    {
+        std::vector<std::shared_ptr<VoxelChunk>> aFinishedChunks;
+        std::vector<std::shared_ptr<VoxelChunk>> aFailedChunks;
+        {
+            std::lock_guard<std::mutex> lock(m_sharedState->mutex);
+            aFinishedChunks.swap(m_sharedState->aFinishedChunks);
+            aFailedChunks.swap(m_sharedState->aFailedChunks);
+        }
+
+        for (std::shared_ptr<VoxelChunk>& chunk : aFailedChunks)
+        {
+            --m_statistics.uNumPendingChunks;
+            m_chunks.erase(getChunkKey(chunk->GetLevel(), chunk->GetX(), chunk->GetZ()));
+        }
+
+        for (std::shared_ptr<VoxelChunk>& chunk : aFinishedChunks)
+        {
+            --m_statistics.uNumPendingChunks;
+            chunk->SetState(eChunkState::GENERATED);
+
+            ++m_statistics.uNumGeneratedChunks;
+            m_totalGenerationLatency += chunk->GetGenerationLatency();
+            m_statistics.averageGenerationLatency = m_totalGenerationLatency / static_cast<FLOAT>(m_statistics.uNumGeneratedChunks);
+            if (chunk->GetGenerationLatency() > m_statistics.maxGenerationLatency)
+            {
+                m_statistics.maxGenerationLatency = chunk->GetGenerationLatency();
+            }
+
+            m_aUploadQueue.push_back(chunk);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::uploadChunks
+
+      Summary:  Uploads the nearest generated chunks, at most the upload
+                budget. Chunks that left the view distance while they
+                were generated are discarded instead.
+
+      Args:     FLOAT eyeX
+                  Position of the eye along the x-axis, in level 0
+                  chunks
+                FLOAT eyeZ
+                  Position of the eye along the z-axis, in level 0
+                  chunks
+
+      Modifies: [m_chunks, m_aUploadQueue, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::uploadChunks(_In_ FLOAT eyeX, _In_ FLOAT eyeZ)
+    {
+        auto getDistance = [eyeX, eyeZ](const std::shared_ptr<VoxelChunk>& chunk) -> FLOAT
+        {
+            return getNodeDistance(eyeX, eyeZ, chunk->GetLevel(), chunk->GetX(), chunk->GetZ());
+        };
+
+        std::sort(m_aUploadQueue.begin(), m_aUploadQueue.end(),
+            [&getDistance](const std::shared_ptr<VoxelChunk>& a, const std::shared_ptr<VoxelChunk>& b)
+            {
+                return getDistance(a) < getDistance(b);
+            });
+
+        UINT uNumUploadedChunks = 0u;
+        std::vector<std::shared_ptr<VoxelChunk>> aRemainingChunks;
+        for (std::shared_ptr<VoxelChunk>& chunk : m_aUploadQueue)
+        {
+            FLOAT size = static_cast<FLOAT>(1u << chunk->GetLevel());
+            if (getDistance(chunk) > static_cast<FLOAT>(m_uViewDistance) + size)
+            {
+                m_chunks.erase(getChunkKey(chunk->GetLevel(), chunk->GetX(), chunk->GetZ()));
+                continue;
+            }
+
+            if (uNumUploadedChunks >= m_uUploadBudget)
+            {
+                aRemainingChunks.push_back(chunk);
+                continue;
+            }
+
+            XMVECTOR offset = XMVectorSet(
+                CHUNK_EXTENT * size * static_cast<FLOAT>(chunk->GetX()),
+                -1.25f * static_cast<FLOAT>(m_sharedState->uHeight),
+                CHUNK_EXTENT * size * static_cast<FLOAT>(chunk->GetZ()),
+                0.0f
+            );
+            if (FAILED(chunk->Upload(m_device.Get(), m_immediateContext.Get(), m_pGeometryRegistry, offset, m_vertexShader, m_pixelShader, m_material)))
+            {
+                m_chunks.erase(getChunkKey(chunk->GetLevel(), chunk->GetX(), chunk->GetZ()));
+                continue;
+            }
+
+            ++uNumUploadedChunks;
+            ++m_statistics.uNumResidentChunks;
+            m_statistics.uResidentBytes += chunk->GetMemoryUsage();
+        }
+        m_aUploadQueue.swap(aRemainingChunks);
+
+        m_statistics.uNumUploadedChunks = uNumUploadedChunks;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::selectDrawnChunks
+
+      Summary:  Picks the resident chunks that cover the selected ones.
+                A selected chunk that is not resident is replaced by its
+                nearest resident ancestor, or else by its resident
+                children. Chunks inside a drawn ancestor are skipped so
+                no area is drawn twice.
+
+      Args:     const std::vector<ChunkNode>& aLeaves
+                  Selected chunks, sorted by distance
+
+      Modifies: [m_chunks, m_aDrawnChunks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::selectDrawnChunks(_In_ const std::vector<ChunkNode>& aLeaves)
+    {
+        std::unordered_set<UINT64> ancestorKeys;
+        std::vector<std::shared_ptr<VoxelChunk>> aCandidates;
+        for (const ChunkNode& leaf : aLeaves)
+        {
+            std::shared_ptr<VoxelChunk> chunk = findResidentChunk(leaf.uLevel, leaf.x, leaf.z);
+            if (chunk)
+            {
+                aCandidates.push_back(chunk);
+                continue;
+            }
+
+            BOOL bHasAncestor = FALSE;
+            for (UINT uLevel = leaf.uLevel + 1u; uLevel <= m_uNumLodLevels; ++uLevel)
+            {
+                INT x = leaf.x >> (uLevel - leaf.uLevel);
+                INT z = leaf.z >> (uLevel - leaf.uLevel);
+                std::shared_ptr<VoxelChunk> ancestor = findResidentChunk(uLevel, x, z);
+                if (ancestor)
+                {
+                    if (ancestorKeys.insert(getChunkKey(uLevel, x, z)).second)
+                    {
+                        aCandidates.push_back(ancestor);
+                    }
+                    bHasAncestor = TRUE;
+                    break;
+                }
+            }
+
+            if (!bHasAncestor && leaf.uLevel > 0u)
+            {
+                for (INT z = 2 * leaf.z; z <= 2 * leaf.z + 1; ++z)
+                {
+                    for (INT x = 2 * leaf.x; x <= 2 * leaf.x + 1; ++x)
+                    {
+                        std::shared_ptr<VoxelChunk> child = findResidentChunk(leaf.uLevel - 1u, x, z);
+                        if (child)
+                        {
+                            aCandidates.push_back(child);
+                        }
+                    }
+                }
+            }
+        }
+
+        m_aDrawnChunks.clear();
+        for (std::shared_ptr<VoxelChunk>& chunk : aCandidates)
+        {
+            BOOL bIsCovered = FALSE;
+            for (UINT uLevel = chunk->GetLevel() + 1u; uLevel <= m_uNumLodLevels && !bIsCovered; ++uLevel)
+            {
+                bIsCovered = ancestorKeys.contains(getChunkKey(uLevel, chunk->GetX() >> (uLevel - chunk->GetLevel()), chunk->GetZ() >> (uLevel - chunk->GetLevel())));
+            }
+
+            if (!bIsCovered)
+            {
+                chunk->SetLastUsedFrame(m_uFrameIdx);
+                m_aDrawnChunks.push_back(chunk);
+            }
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::evictChunks
+
+      Summary:  Evicts the least recently viewed resident chunks until
+                they fit in the memory cap. Chunks viewed in the current
+                frame are kept. The candidates are collected and sorted
+                once per call, so evicting k of n chunks costs
+                O(n log n) and not O(k n).
+
+      Modifies: [m_chunks, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::evictChunks()
+    {
+        if (m_statistics.uResidentBytes <= m_uMaxResidentBytes)
+        {
+            return;
+        }
+
+        std::vector<std::shared_ptr<VoxelChunk>> aCandidates;
+        for (auto& entry : m_chunks)
+        {
+            if (entry.second->GetState() == eChunkState::RESIDENT && entry.second->GetLastUsedFrame() < m_uFrameIdx)
+            {
+                aCandidates.push_back(entry.second);
+            }
+        }
+
+        std::sort(aCandidates.begin(), aCandidates.end(), [](const std::shared_ptr<VoxelChunk>& a, const std::shared_ptr<VoxelChunk>& b)
+            {
+                return a->GetLastUsedFrame() < b->GetLastUsedFrame();
+            });
+
+        for (std::shared_ptr<VoxelChunk>& chunk : aCandidates)
+        {
+            if (m_statistics.uResidentBytes <= m_uMaxResidentBytes)
+            {
+                break;
+            }
+
+            --m_statistics.uNumResidentChunks;
+            m_statistics.uResidentBytes -= chunk->GetMemoryUsage();
+            ++m_statistics.uNumEvictedChunks;
+            m_chunks.erase(getChunkKey(chunk->GetLevel(), chunk->GetX(), chunk->GetZ()));
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::cullChunks
+
+      Summary:  Removes the drawn chunks hidden behind nearer terrain
+
+      Args:     FXMVECTOR eye
+                  Position of the camera
+
+      Modifies: [m_aVisibleChunks, m_aOccluderBounds, m_aChunkBounds,
+                 m_aIsVisible, m_bVoxelsDirty, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::cullChunks(_In_ FXMVECTOR eye)
+    {
+        m_aIsVisible.assign(m_aDrawnChunks.size(), TRUE);
+        m_statistics.uNumOccludedChunks = 0u;
+        m_statistics.occlusionTime = 0.0f;
+
+        if (m_bOcclusionCulling)
+        {
+            // Blocks are 2 units wide and centered on even coordinates, hence the -1
+            FLOAT bottom = -1.25f * static_cast<FLOAT>(m_sharedState->uHeight) - 1.0f;
+            m_aOccluderBounds.clear();
+            m_aChunkBounds.clear();
+            for (const std::shared_ptr<VoxelChunk>& chunk : m_aDrawnChunks)
+            {
+                FLOAT extent = CHUNK_EXTENT * static_cast<FLOAT>(1u << chunk->GetLevel());
+                FLOAT minX = extent * static_cast<FLOAT>(chunk->GetX()) - 1.0f;
+                FLOAT minZ = extent * static_cast<FLOAT>(chunk->GetZ()) - 1.0f;
+                FLOAT maxTop = bottom + 2.0f * static_cast<FLOAT>(chunk->GetMaxColumnHeight());
+                m_aChunkBounds.push_back(HeightBounds{
+                    .minX = minX,
+                    .minZ = minZ,
+                    .maxX = minX + extent,
+                    .maxZ = minZ + extent,
+                    .minTop = maxTop,
+                    .maxTop = maxTop
+                });
+
+                FLOAT tileExtent = extent / static_cast<FLOAT>(VoxelChunk::NUM_OCCLUDER_TILES);
+                for (UINT uTileZ = 0u; uTileZ < VoxelChunk::NUM_OCCLUDER_TILES; ++uTileZ)
+                {
+                    for (UINT uTileX = 0u; uTileX < VoxelChunk::NUM_OCCLUDER_TILES; ++uTileX)
+                    {
+                        FLOAT minTop = bottom + 2.0f * static_cast<FLOAT>(chunk->GetOccluderHeight(uTileX, uTileZ));
+                        m_aOccluderBounds.push_back(HeightBounds{
+                            .minX = minX + tileExtent * static_cast<FLOAT>(uTileX),
+                            .minZ = minZ + tileExtent * static_cast<FLOAT>(uTileZ),
+                            .maxX = minX + tileExtent * static_cast<FLOAT>(uTileX + 1u),
+                            .maxZ = minZ + tileExtent * static_cast<FLOAT>(uTileZ + 1u),
+                            .minTop = minTop,
+                            .maxTop = minTop
+                        });
+                    }
+                }
+            }
+
+            m_horizonCuller.Cull(eye, m_aOccluderBounds, m_aChunkBounds, m_aIsVisible);
+            m_statistics.uNumOccludedChunks = m_horizonCuller.GetStatistics().uNumCulledBlocks;
+            m_statistics.occlusionTime = m_horizonCuller.GetStatistics().cullTime;
+        }
+
+        BOOL bIsChanged = FALSE;
+        size_t uNumVisibleChunks = 0u;
+        for (size_t uChunkIdx = 0u; uChunkIdx < m_aDrawnChunks.size(); ++uChunkIdx)
+        {
+            if (!m_aIsVisible[uChunkIdx])
+            {
+                continue;
+            }
+
+            if (uNumVisibleChunks >= m_aVisibleChunks.size())
+            {
+                m_aVisibleChunks.push_back(m_aDrawnChunks[uChunkIdx]);
+                bIsChanged = TRUE;
+            }
+            else if (m_aVisibleChunks[uNumVisibleChunks] != m_aDrawnChunks[uChunkIdx])
+            {
+                m_aVisibleChunks[uNumVisibleChunks] = m_aDrawnChunks[uChunkIdx];
+                bIsChanged = TRUE;
+            }
+            ++uNumVisibleChunks;
+        }
+
+        if (uNumVisibleChunks != m_aVisibleChunks.size())
+        {
+            m_aVisibleChunks.resize(uNumVisibleChunks);
+            bIsChanged = TRUE;
+        }
+
+        if (bIsChanged)
+        {
+            m_bVoxelsDirty = TRUE;
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VoxelWorld::rebuildVoxels
+
+      Summary:  Gathers the voxels of the visible chunks
+
+      Modifies: [m_voxels, m_bVoxelsDirty, m_statistics].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void VoxelWorld::rebuildVoxels()
+    {
+        m_voxels.clear();
+        m_statistics.uNumDrawnInstances = 0u;
+        for (std::shared_ptr<VoxelChunk>& chunk : m_aVisibleChunks)
+        {
+            std::vector<std::shared_ptr<Voxel>>& voxels = chunk->GetVoxels();
+            for (const std::shared_ptr<Voxel>& voxel : voxels)
+            {
+                m_statistics.uNumDrawnInstances += voxel->GetNumInstances();
+            }
+            m_voxels.insert(m_voxels.end(), voxels.begin(), voxels.end());
+        }
+        m_statistics.uNumDrawnChunks = static_cast<UINT>(m_aVisibleChunks.size());
+
+        m_bVoxelsDirty = FALSE;
+    }
+}
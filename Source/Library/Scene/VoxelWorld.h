@@ -0,0 +1,238 @@
+/*+===================================================================
+  File:      VOXELWORLD.H
+
+  Summary:   VoxelWorld header file contains declarations of the
+             VoxelWorld class that streams voxel terrain chunks around
+             the camera for open-world maps.
+
+  Classes: VoxelWorld
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <mutex>
+
+#include "Scene/HorizonCuller.h"
+#include "Scene/TerrainGenerator.h"
+#include "Scene/VoxelChunk.h"
+#include "Thread/ThreadPool.h"
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    VoxelWorld
+
+      Summary:  Camera centred, streaming voxel terrain.
+
+                Every Update requests the missing chunks within the view
+                distance of the eye, nearest first, and generates them
+                on the thread pool (noise and packed instances). Chunks
+                that finished generating are uploaded on the calling
+                thread, at most the upload budget per frame, so the
+                frame time does not depend on how fast the camera moves.
+                When the resident chunks take more than the memory cap
+                the least recently viewed chunks are evicted.
+
+                With level of detail enabled the view is a quadtree of
+                chunks whose roots have the coarsest level. A node is
+                split into its four children while its distance to the
+                eye is below the LOD distance times its width, so the
+                number of chunks per ring stays about the same however
+                far the view distance reaches. A leaf that is not
+                resident yet is drawn with its nearest resident
+                ancestor, or else its resident children, so switching
+                levels does not open holes.
+
+                The drawn chunks then go through a HorizonCuller with
+                the lowest column of every occluder tile of the chunks
+                as occluders, the chunks hidden behind nearer hills are
+                left out of GetVoxels.
+
+                Chunk (0, 0) starts at map cell WORLD_ORIGIN, the map
+                extends MAX_CHUNK_COORD chunks in every direction.
+
+                Without Initialize the chunks are generated and tracked
+                but no Direct3D resources are created, so the streaming
+                can be driven headless.
+
+      Methods:  Initialize
+                  Stores the device that the chunks are uploaded with
+                Update
+                  Streams the chunks around an eye position
+                GetPaletteBuffer
+                  Returns the constant buffer of the block colors
+                GetStatistics
+                  Returns the streaming counters
+                GetVisibleChunks
+                  Returns the chunks whose voxels are drawn
+                GetVoxels
+                  Returns the voxels of the chunks in view
+                SetMaterial
+                  Sets the material of the voxels
+                SetLodDistance
+                  Sets the distance at which chunks are split
+                SetMaxResidentBytes
+                  Sets the memory cap of the resident chunks
+                SetNumLodLevels
+                  Sets the number of coarser levels of detail
+                SetOcclusionCulling
+                  Enables the culling of chunks behind nearer terrain
+                SetPixelShader
+                  Sets the pixel shader of the voxels
+                SetUploadBudget
+                  Sets the number of chunks uploaded per frame
+                SetVertexShader
+                  Sets the vertex shader of the voxels
+                SetViewDistance
+                  Sets the radius of the streamed area in chunks
+                VoxelWorld
+                  Constructor.
+                ~VoxelWorld
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class VoxelWorld
+    {
+    public:
+        static constexpr const UINT DEFAULT_VIEW_DISTANCE = 8u;
+        static constexpr const UINT DEFAULT_UPLOAD_BUDGET = 2u;
+        static constexpr const UINT DEFAULT_NUM_LOD_LEVELS = 0u;
+        static constexpr const FLOAT DEFAULT_LOD_DISTANCE = 2.0f;
+        static constexpr const size_t DEFAULT_MAX_RESIDENT_BYTES = 16u << 20u;
+        static constexpr const UINT WORLD_ORIGIN = 1u << 14u;
+        static constexpr const INT MAX_CHUNK_COORD = static_cast<INT>(WORLD_ORIGIN / VoxelChunk::SIZE) - 1;
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Statistics
+
+            Summary:  Streaming counters. Latencies are measured from the
+                      request of a chunk to the end of its generation,
+                      in milliseconds, the occlusion time is the CPU
+                      time of the last culling pass in milliseconds.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Statistics
+        {
+            UINT uNumResidentChunks;
+            UINT uNumPendingChunks;
+            UINT uNumUploadedChunks;
+            UINT uNumGeneratedChunks;
+            UINT uNumEvictedChunks;
+            UINT uNumDrawnChunks;
+            UINT uNumDrawnInstances;
+            UINT uNumOccludedChunks;
+            size_t uResidentBytes;
+            FLOAT averageGenerationLatency;
+            FLOAT maxGenerationLatency;
+            FLOAT occlusionTime;
+        };
+
+    public:
+        VoxelWorld() = delete;
+        VoxelWorld(_In_ const TerrainGenerator& generator, _In_ UINT uHeight, _In_ const std::shared_ptr<ThreadPool>& threadPool);
+        VoxelWorld(const VoxelWorld& other) = delete;
+        VoxelWorld(VoxelWorld&& other) = delete;
+        VoxelWorld& operator=(const VoxelWorld& other) = delete;
+        VoxelWorld& operator=(VoxelWorld&& other) = delete;
+        ~VoxelWorld();
+
+        HRESULT Initialize(_In_ ID3D11Device* pDevice, _In_ ID3D11DeviceContext* pImmediateContext, _In_opt_ GeometryRegistry* pGeometryRegistry);
+        void Update(_In_ FXMVECTOR eye);
+
+        ComPtr<ID3D11Buffer>& GetPaletteBuffer();
+        const Statistics& GetStatistics() const;
+        const std::vector<std::shared_ptr<VoxelChunk>>& GetVisibleChunks() const;
+        std::vector<std::shared_ptr<Voxel>>& GetVoxels();
+
+        void SetLodDistance(_In_ FLOAT lodDistance);
+        void SetMaterial(_In_ const std::shared_ptr<Material>& material);
+        void SetMaxResidentBytes(_In_ size_t uMaxResidentBytes);
+        void SetNumLodLevels(_In_ UINT uNumLodLevels);
+        void SetOcclusionCulling(_In_ BOOL bOcclusionCulling);
+        void SetPixelShader(_In_ const std::shared_ptr<PixelShader>& pixelShader);
+        void SetUploadBudget(_In_ UINT uNumChunksPerFrame);
+        void SetVertexShader(_In_ const std::shared_ptr<VertexShader>& vertexShader);
+        void SetViewDistance(_In_ UINT uNumChunks);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   SharedState
+
+            Summary:  State shared with the generation tasks. The tasks
+                      hold a reference, so they stay valid if the world
+                      is destroyed while they are queued.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct SharedState
+        {
+            TerrainGenerator generator;
+            UINT uHeight;
+            std::mutex mutex;
+            std::vector<std::shared_ptr<VoxelChunk>> aFinishedChunks;
+            std::vector<std::shared_ptr<VoxelChunk>> aFailedChunks;
+            BOOL bCancelled;
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   ChunkNode
+
+            Summary:  Node of the level of detail quadtree, in chunks of
+                      its level. The distance to the eye is in level 0
+                      chunks.
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct ChunkNode
+        {
+            FLOAT distance;
+            UINT uLevel;
+            INT x;
+            INT z;
+        };
+
+        static constexpr const FLOAT CHUNK_EXTENT = 2.0f * static_cast<FLOAT>(VoxelChunk::SIZE);
+
+        static UINT64 getChunkKey(_In_ UINT uLevel, _In_ INT x, _In_ INT z);
+        static FLOAT getNodeDistance(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uLevel, _In_ INT x, _In_ INT z);
+        static BOOL isValidNode(_In_ UINT uLevel, _In_ INT x, _In_ INT z);
+
+        std::shared_ptr<VoxelChunk> findResidentChunk(_In_ UINT uLevel, _In_ INT x, _In_ INT z) const;
+        void selectChunks(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uLevel, _In_ INT x, _In_ INT z, _Inout_ std::vector<ChunkNode>& aLeaves) const;
+        void requestChunks(_In_ const std::vector<ChunkNode>& aLeaves);
+        void collectChunks();
+        void uploadChunks(_In_ FLOAT eyeX, _In_ FLOAT eyeZ);
+        void selectDrawnChunks(_In_ const std::vector<ChunkNode>& aLeaves);
+        void evictChunks();
+        void cullChunks(_In_ FXMVECTOR eye);
+        void rebuildVoxels();
+
+    private:
+        std::shared_ptr<SharedState> m_sharedState;
+        std::shared_ptr<ThreadPool> m_threadPool;
+        ComPtr<ID3D11Device> m_device;
+        ComPtr<ID3D11DeviceContext> m_immediateContext;
+        // Owned by the renderer with the device
+        GeometryRegistry* m_pGeometryRegistry;
+        ComPtr<ID3D11Buffer> m_paletteBuffer;
+        std::shared_ptr<VertexShader> m_vertexShader;
+        std::shared_ptr<PixelShader> m_pixelShader;
+        std::shared_ptr<Material> m_material;
+        std::unordered_map<UINT64, std::shared_ptr<VoxelChunk>> m_chunks;
+        std::vector<std::shared_ptr<VoxelChunk>> m_aUploadQueue;
+        std::vector<std::shared_ptr<VoxelChunk>> m_aDrawnChunks;
+        std::vector<std::shared_ptr<VoxelChunk>> m_aVisibleChunks;
+        HorizonCuller m_horizonCuller;
+        std::vector<HeightBounds> m_aOccluderBounds;
+        std::vector<HeightBounds> m_aChunkBounds;
+        std::vector<BOOL> m_aIsVisible;
+        std::vector<std::shared_ptr<Voxel>> m_voxels;
+        UINT m_uViewDistance;
+        UINT m_uUploadBudget;
+        UINT m_uNumLodLevels;
+        FLOAT m_lodDistance;
+        BOOL m_bOcclusionCulling;
+        size_t m_uMaxResidentBytes;
+        UINT64 m_uFrameIdx;
+        FLOAT m_totalGenerationLatency;
+        BOOL m_bVoxelsDirty;
+        Statistics m_statistics;
+    };
+}
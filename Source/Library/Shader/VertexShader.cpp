@@ -15,19 +15,24 @@ namespace library
                 PCSTR pszShaderModel
                   Specifies the shader target or set of shader features
                   to compile against
+                eInstanceLayout instanceLayout
+                  Layout of the per-instance data in slot 2
 
-      Modifies: [m_vertexShader].
+      Modifies: [m_vertexShader, m_instanceLayout, m_instancedVariant].
     M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
 
-    VertexShader::VertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel)
+    VertexShader::VertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel, _In_ eInstanceLayout instanceLayout)
         : Shader(pszFileName, pszEntryPoint, pszShaderModel)
         , m_vertexShader(nullptr)
+        , m_instanceLayout(instanceLayout)
+        , m_instancedVariant()
     { }
 
     /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
       Method:   VertexShader::Initialize
 
-      Summary:  Initializes the vertex shader and the input layout
+      Summary:  Initializes the vertex shader and the input layout,
+                then the instanced variant if there is one
 
       Args:     ID3D11Device* pDevice
                   The Direct3D device to create the vertex shader
@@ -57,7 +62,7 @@ namespace library
         }
 
         // Define the input layout
-        D3D11_INPUT_ELEMENT_DESC layout[] =
+        D3D11_INPUT_ELEMENT_DESC layout[9] =
         {
             { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
             { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -71,6 +76,15 @@ namespace library
         };
         UINT numElements = ARRAYSIZE(layout);
 
+        // Packed voxels replace the four transform rows with one VoxelInstanceData
+        if (m_instanceLayout == eInstanceLayout::PACKED_VOXEL)
+        {
+            layout[5] = { "VOXEL_INSTANCE", 0, DXGI_FORMAT_R16G16B16A16_SINT, 2, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+            layout[6] = { "VOXEL_OCCLUSION", 0, DXGI_FORMAT_R32G32_UINT, 2, 8, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+            layout[7] = { "VOXEL_LIGHT", 0, DXGI_FORMAT_R32G32_UINT, 2, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+            numElements = 8u;
+        }
+
         // Create the input layout
         hr = pDevice->CreateInputLayout(layout, numElements, pVSBlob->GetBufferPointer(),
             pVSBlob->GetBufferSize(), m_vertexLayout.GetAddressOf());
@@ -78,6 +92,11 @@ namespace library
         if (FAILED(hr))
             return hr;
 
+        if (m_instancedVariant)
+        {
+            return m_instancedVariant->Initialize(pDevice);
+        }
+
         return S_OK;
     }
 
@@ -108,4 +127,53 @@ namespace library
     {
         return m_vertexLayout;
     }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexShader::GetInstanceLayout
+
+      Summary:  Returns the per-instance input layout
+
+      Returns:  eInstanceLayout
+                  Layout of the per-instance data
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    eInstanceLayout VertexShader::GetInstanceLayout() const
+    {
+        return m_instanceLayout;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexShader::GetInstancedVariant
+
+      Summary:  Returns the variant of the shader that reads the world
+                matrix from the instance stream
+
+      Returns:  const std::shared_ptr<VertexShader>&
+                  Instanced variant, empty if the renderables drawn
+                  with this shader are never instanced
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    const std::shared_ptr<VertexShader>& VertexShader::GetInstancedVariant() const
+    {
+        return m_instancedVariant;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   VertexShader::SetInstancedVariant
+
+      Summary:  Sets the variant of the shader that reads the world
+                matrix from the INSTANCE_TRANSFORM elements of the
+                TRANSFORM layout and everything else like this shader.
+                Must be set before Initialize.
+
+      Args:     const std::shared_ptr<VertexShader>& instancedVariant
+                  Instanced variant, nullptr to never instance
+
+      Modifies: [m_instancedVariant].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+
+    void VertexShader::SetInstancedVariant(_In_ const std::shared_ptr<VertexShader>& instancedVariant)
+    {
+        m_instancedVariant = instancedVariant;
+    }
 }
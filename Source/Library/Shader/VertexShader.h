@@ -17,17 +17,44 @@
 
 namespace library
 {
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eInstanceLayout
+
+        Summary:  Enumeration of per-instance input layouts. TRANSFORM
+                  reads an InstanceData matrix, PACKED_VOXEL reads a
+                  VoxelInstanceData
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eInstanceLayout : BYTE
+    {
+        TRANSFORM,
+        PACKED_VOXEL,
+        COUNT,
+    };
+
     /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
       Class:    VertexShader
 
       Summary:  Vertex shader
 
+                A shader may have an instanced variant that reads the
+                world matrix from an InstanceData stream in slot 2
+                instead of the per draw constants, the renderer draws
+                the renderables that share geometry, shaders and
+                material with it in one instanced draw. The variant is
+                initialized with the shader.
+
       Methods:  Initialize
                   Initializes the vertex shader and the input layout
                 GetVertexShader
                   Returns the vertex shader
                 GetVertexLayout
                   Returns the vertex input layout
+                GetInstanceLayout
+                  Returns the per-instance input layout
+                GetInstancedVariant
+                  Returns the instanced variant
+                SetInstancedVariant
+                  Sets the instanced variant
                 Game
                   Constructor.
                 ~Game
@@ -37,7 +64,7 @@ namespace library
     {
     public:
         VertexShader() = delete;
-        VertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel);
+        VertexShader(_In_ PCWSTR pszFileName, _In_ PCSTR pszEntryPoint, _In_ PCSTR pszShaderModel, _In_ eInstanceLayout instanceLayout = eInstanceLayout::TRANSFORM);
         VertexShader(const VertexShader& other) = delete;
         VertexShader(VertexShader&& other) = delete;
         VertexShader& operator=(const VertexShader& other) = delete;
@@ -48,9 +75,14 @@ namespace library
 
         ComPtr<ID3D11VertexShader>& GetVertexShader();
         ComPtr<ID3D11InputLayout>& GetVertexLayout();
+        eInstanceLayout GetInstanceLayout() const;
+        const std::shared_ptr<VertexShader>& GetInstancedVariant() const;
+        void SetInstancedVariant(_In_ const std::shared_ptr<VertexShader>& instancedVariant);
 
     protected:
         ComPtr<ID3D11VertexShader> m_vertexShader;
         ComPtr<ID3D11InputLayout> m_vertexLayout;
+        eInstanceLayout m_instanceLayout;
+        std::shared_ptr<VertexShader> m_instancedVariant;
     };
 }
\ No newline at end of file
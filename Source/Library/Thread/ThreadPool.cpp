@@ -0,0 +1,222 @@
+#include "Thread/ThreadPool.h"
+
+#include <atomic>
+
+namespace library
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::ThreadPool
+
+      Summary:  Constructor that spawns the worker threads
+
+      Args:     UINT uNumThreads
+                  Number of worker threads, 0 picks
+                  GetDefaultNumThreads()
+
+      Modifies: [m_aThreads, m_tasks, m_uNumActiveTasks, m_bStopping].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ThreadPool::ThreadPool(_In_ UINT uNumThreads)
+        : m_aThreads()
+        , m_tasks()
+        , m_mutex()
+        , m_taskAvailable()
+        , m_idle()
+        , m_uNumActiveTasks(0u)
+        , m_bStopping(FALSE)
+    {
+        if (uNumThreads == 0u)
+        {
+            uNumThreads = GetDefaultNumThreads();
+        }
+
+        m_aThreads.reserve(uNumThreads);
+        for (UINT i = 0u; i < uNumThreads; ++i)
+        {
+            m_aThreads.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::~ThreadPool
+
+      Summary:  Destructor that finishes the queued tasks and joins the
+                worker threads
+
+      Modifies: [m_aThreads, m_bStopping].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStopping = TRUE;
+        }
+        m_taskAvailable.notify_all();
+
+        for (std::thread& thread : m_aThreads)
+        {
+            thread.join();
+        }
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::GetDefaultNumThreads
+
+      Summary:  Returns the number of worker threads that leaves one
+                hardware thread for the calling (render) thread
+
+      Returns:  UINT
+                  Default number of worker threads, at least 1
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT ThreadPool::GetDefaultNumThreads()
+    {
+        UINT uNumHardwareThreads = std::thread::hardware_concurrency();
+
+        return uNumHardwareThreads > 1u ? uNumHardwareThreads - 1u : 1u;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::GetNumThreads
+
+      Summary:  Returns the number of worker threads
+
+      Returns:  UINT
+                  Number of worker threads
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT ThreadPool::GetNumThreads() const
+    {
+        return static_cast<UINT>(m_aThreads.size());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::Enqueue
+
+      Summary:  Queues a task to be run on one of the worker threads
+
+      Args:     std::function<void()>&& task
+                  Task to run
+
+      Modifies: [m_tasks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ThreadPool::Enqueue(_In_ std::function<void()>&& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push(std::move(task));
+        }
+        m_taskAvailable.notify_one();
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::ParallelFor
+
+      Summary:  Calls func(i) for every i in [0, uNumItems) on the worker
+                threads and the calling thread, and returns once every
+                call has finished. Indices are handed out one at a time
+                so uneven items balance themselves out. The calling
+                thread takes part in the work, so this may also be used
+                from inside a task without dead-locking the pool.
+
+      Args:     UINT uNumItems
+                  Number of indices to process
+                const std::function<void(UINT)>& func
+                  Function called once for every index
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ThreadPool::ParallelFor(_In_ UINT uNumItems, _In_ const std::function<void(UINT)>& func)
+    {
+        struct ParallelForState
+        {
+            std::atomic<UINT> uNextItem;
+            std::atomic<UINT> uNumDoneItems;
+            std::mutex mutex;
+            std::condition_variable done;
+        };
+
+        if (uNumItems == 0u)
+        {
+            return;
+        }
+
+        std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+        state->uNextItem = 0u;
+        state->uNumDoneItems = 0u;
+
+        // Helpers only dereference pFunc for an index they claimed, and the caller does not
+        // return before every index has been processed, so pFunc outlives every use
+        const std::function<void(UINT)>* pFunc = &func;
+        auto runItems = [state, pFunc, uNumItems]()
+        {
+            UINT uItem;
+            while ((uItem = state->uNextItem.fetch_add(1u)) < uNumItems)
+            {
+                (*pFunc)(uItem);
+                if (state->uNumDoneItems.fetch_add(1u) + 1u == uNumItems)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->done.notify_all();
+                }
+            }
+        };
+
+        UINT uNumHelpers = GetNumThreads() < uNumItems - 1u ? GetNumThreads() : uNumItems - 1u;
+        for (UINT i = 0u; i < uNumHelpers; ++i)
+        {
+            Enqueue(runItems);
+        }
+
+        runItems();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state, uNumItems]() { return state->uNumDoneItems.load() == uNumItems; });
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::WaitIdle
+
+      Summary:  Blocks until the queue is empty and no task is running
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ThreadPool::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]() { return m_tasks.empty() && m_uNumActiveTasks == 0u; });
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   ThreadPool::workerLoop
+
+      Summary:  Body of a worker thread, pops and runs tasks until the
+                pool is destroyed
+
+      Modifies: [m_tasks, m_uNumActiveTasks].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void ThreadPool::workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_taskAvailable.wait(lock, [this]() { return m_bStopping || !m_tasks.empty(); });
+
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+                ++m_uNumActiveTasks;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_uNumActiveTasks;
+                if (m_tasks.empty() && m_uNumActiveTasks == 0u)
+                {
+                    m_idle.notify_all();
+                }
+            }
+        }
+    }
+}
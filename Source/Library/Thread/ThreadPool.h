@@ -0,0 +1,75 @@
+/*+===================================================================
+  File:      THREADPOOL.H
+
+  Summary:   ThreadPool header file contains declarations of the
+             ThreadPool class that runs CPU side jobs such as terrain
+             generation on a fixed set of worker threads.
+
+  Classes: ThreadPool
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace library
+{
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    ThreadPool
+
+      Summary:  Fixed size pool of worker threads that execute queued
+                tasks in FIFO order
+
+      Methods:  GetNumThreads
+                  Returns the number of worker threads
+                Enqueue
+                  Queues a task to be run on a worker thread
+                ParallelFor
+                  Runs a function for every index of a range and
+                  waits until all of them are done
+                WaitIdle
+                  Waits until every queued task is done
+                ThreadPool
+                  Constructor.
+                ~ThreadPool
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class ThreadPool
+    {
+    public:
+        ThreadPool() = delete;
+        explicit ThreadPool(_In_ UINT uNumThreads);
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool(ThreadPool&& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        ThreadPool& operator=(ThreadPool&& other) = delete;
+        ~ThreadPool();
+
+        static UINT GetDefaultNumThreads();
+
+        UINT GetNumThreads() const;
+
+        void Enqueue(_In_ std::function<void()>&& task);
+        void ParallelFor(_In_ UINT uNumItems, _In_ const std::function<void(UINT)>& func);
+        void WaitIdle();
+
+    private:
+        void workerLoop();
+
+    private:
+        std::vector<std::thread> m_aThreads;
+        std::queue<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_taskAvailable;
+        std::condition_variable m_idle;
+        UINT m_uNumActiveTasks;
+        BOOL m_bStopping;
+    };
+}
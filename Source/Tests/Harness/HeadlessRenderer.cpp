@@ -0,0 +1,337 @@
+#include "Harness/HeadlessRenderer.h"
+
+#include <cstdio>
+
+#include "Light/PointLight.h"
+#include "Scene/TerrainData.h"
+#include "Shader/PixelShader.h"
+#include "Shader/VertexShader.h"
+
+using namespace library;
+
+namespace tests
+{
+    namespace
+    {
+        constexpr const SimpleVertex CUBE_VERTICES[] =
+        {
+            {.Position = XMFLOAT3(-0.5f, -0.5f, -0.5f), .TexCoord = XMFLOAT2(0.0f, 1.0f), .Normal = XMFLOAT3(-1.0f, -1.0f, -1.0f) },
+            {.Position = XMFLOAT3(0.5f, -0.5f, -0.5f), .TexCoord = XMFLOAT2(1.0f, 1.0f), .Normal = XMFLOAT3(1.0f, -1.0f, -1.0f) },
+            {.Position = XMFLOAT3(0.5f,  0.5f, -0.5f), .TexCoord = XMFLOAT2(1.0f, 0.0f), .Normal = XMFLOAT3(1.0f, 1.0f, -1.0f) },
+            {.Position = XMFLOAT3(-0.5f,  0.5f, -0.5f), .TexCoord = XMFLOAT2(0.0f, 0.0f), .Normal = XMFLOAT3(-1.0f, 1.0f, -1.0f) },
+            {.Position = XMFLOAT3(-0.5f, -0.5f,  0.5f), .TexCoord = XMFLOAT2(1.0f, 1.0f), .Normal = XMFLOAT3(-1.0f, -1.0f, 1.0f) },
+            {.Position = XMFLOAT3(0.5f, -0.5f,  0.5f), .TexCoord = XMFLOAT2(0.0f, 1.0f), .Normal = XMFLOAT3(1.0f, -1.0f, 1.0f) },
+            {.Position = XMFLOAT3(0.5f,  0.5f,  0.5f), .TexCoord = XMFLOAT2(0.0f, 0.0f), .Normal = XMFLOAT3(1.0f, 1.0f, 1.0f) },
+            {.Position = XMFLOAT3(-0.5f,  0.5f,  0.5f), .TexCoord = XMFLOAT2(1.0f, 0.0f), .Normal = XMFLOAT3(-1.0f, 1.0f, 1.0f) },
+        };
+        constexpr const WORD CUBE_INDICES[] =
+        {
+            0,2,1, 0,3,2,
+            1,6,5, 1,2,6,
+            5,7,4, 5,6,7,
+            4,3,0, 4,7,3,
+            3,6,2, 3,7,6,
+            4,1,5, 4,0,1,
+        };
+
+        constexpr const SimpleVertex QUAD_VERTICES[] =
+        {
+            {.Position = XMFLOAT3(-0.5f, -0.5f, 0.0f), .TexCoord = XMFLOAT2(0.0f, 1.0f), .Normal = XMFLOAT3(0.0f, 0.0f, -1.0f) },
+            {.Position = XMFLOAT3(0.5f, -0.5f, 0.0f), .TexCoord = XMFLOAT2(1.0f, 1.0f), .Normal = XMFLOAT3(0.0f, 0.0f, -1.0f) },
+            {.Position = XMFLOAT3(0.5f,  0.5f, 0.0f), .TexCoord = XMFLOAT2(1.0f, 0.0f), .Normal = XMFLOAT3(0.0f, 0.0f, -1.0f) },
+            {.Position = XMFLOAT3(-0.5f,  0.5f, 0.0f), .TexCoord = XMFLOAT2(0.0f, 0.0f), .Normal = XMFLOAT3(0.0f, 0.0f, -1.0f) },
+        };
+        constexpr const WORD QUAD_INDICES[] =
+        {
+            0,2,1, 0,3,2,
+        };
+
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+          Struct:   TestGeometry
+
+          Summary:  Static vertices and indices of an eTestGeometry
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct TestGeometry
+        {
+            const SimpleVertex* pVertices;
+            UINT uNumVertices;
+            const WORD* pIndices;
+            UINT uNumIndices;
+        };
+
+        constexpr const TestGeometry TEST_GEOMETRIES[static_cast<size_t>(eTestGeometry::COUNT)] =
+        {
+            { CUBE_VERTICES, ARRAYSIZE(CUBE_VERTICES), CUBE_INDICES, ARRAYSIZE(CUBE_INDICES) },
+            { QUAD_VERTICES, ARRAYSIZE(QUAD_VERTICES), QUAD_INDICES, ARRAYSIZE(QUAD_INDICES) },
+        };
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::TestRenderable
+
+      Summary:  Constructor
+
+      Args:     const std::shared_ptr<GraphicsContext>& context
+                  Context to create the buffers with
+                eTestGeometry geometry
+                  Vertices and indices to draw
+                const XMFLOAT4& outputColor
+                  Default color to shade the renderable
+
+      Modifies: [m_context, m_geometry].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TestRenderable::TestRenderable(_In_ const std::shared_ptr<GraphicsContext>& context, _In_ eTestGeometry geometry, _In_ const XMFLOAT4& outputColor)
+        : Renderable(outputColor)
+        , m_context(context)
+        , m_geometry(geometry)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::SetMaterial
+
+      Summary:  Draws all indices of the geometry as one mesh of a
+                material, so the renderable is drawn like a model. Must
+                be called before Initialize, which computes the bounds
+                of the mesh.
+
+      Args:     const std::shared_ptr<Material>& material
+                  Material of the mesh, its textures may be nullptr
+
+      Modifies: [m_aMeshes, m_aMaterials].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TestRenderable::SetMaterial(_In_ const std::shared_ptr<Material>& material)
+    {
+        BasicMeshEntry mesh;
+        mesh.uNumIndices = GetNumIndices();
+        mesh.uMaterialIndex = 0u;
+        m_aMeshes.assign(1u, mesh);
+        m_aMaterials.assign(1u, material);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::Initialize
+
+      Summary:  Creates the vertex, normal, index and constant buffers
+                through the context and computes the bounds. The device
+                is not used, a headless renderer passes nullptr.
+
+      Args:     ID3D11Device* pDevice
+                  Unused
+                ID3D11DeviceContext* pImmediateContext
+                  Unused
+                GeometryRegistry* pGeometryRegistry
+                  Unused
+
+      Modifies: [m_vertexBuffer, m_normalBuffer, m_indexBuffer,
+                 m_constantBuffer, m_localBounds].
+
+      Returns:  HRESULT
+                  Status code
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    HRESULT TestRenderable::Initialize(_In_opt_ ID3D11Device*, _In_opt_ ID3D11DeviceContext*, _In_opt_ GeometryRegistry*)
+    {
+        calculateBounds();
+
+        D3D11_BUFFER_DESC bd =
+        {
+            .ByteWidth = sizeof(SimpleVertex) * GetNumVertices(),
+            .Usage = D3D11_USAGE_IMMUTABLE,
+            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+            .CPUAccessFlags = 0u
+        };
+        m_vertexBuffer.Reset();
+        HRESULT hr = m_context->CreateBuffer(&bd, m_vertexBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(NormalData) * GetNumVertices();
+        m_normalBuffer.Reset();
+        hr = m_context->CreateBuffer(&bd, m_normalBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(WORD) * GetNumIndices();
+        bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        m_indexBuffer.Reset();
+        hr = m_context->CreateBuffer(&bd, m_indexBuffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        bd.ByteWidth = sizeof(CBChangesEveryFrame);
+        bd.Usage = D3D11_USAGE_DEFAULT;
+        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        m_constantBuffer.Reset();
+        return m_context->CreateBuffer(&bd, m_constantBuffer.GetAddressOf());
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::Update
+
+      Summary:  Does nothing, the tests move the renderables themselves
+
+      Args:     FLOAT deltaTime
+                  Unused
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TestRenderable::Update(_In_ FLOAT)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::GetNumVertices
+
+      Summary:  Returns the number of vertices of the geometry
+
+      Returns:  UINT
+                  Number of vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TestRenderable::GetNumVertices() const
+    {
+        return TEST_GEOMETRIES[static_cast<size_t>(m_geometry)].uNumVertices;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::GetNumIndices
+
+      Summary:  Returns the number of indices of the geometry
+
+      Returns:  UINT
+                  Number of indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TestRenderable::GetNumIndices() const
+    {
+        return TEST_GEOMETRIES[static_cast<size_t>(m_geometry)].uNumIndices;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::getVertices
+
+      Summary:  Returns the static vertices of the geometry
+
+      Returns:  const SimpleVertex*
+                  Vertices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const SimpleVertex* TestRenderable::getVertices() const
+    {
+        return TEST_GEOMETRIES[static_cast<size_t>(m_geometry)].pVertices;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRenderable::getIndices
+
+      Summary:  Returns the static indices of the geometry
+
+      Returns:  const WORD*
+                  Indices
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    const WORD* TestRenderable::getIndices() const
+    {
+        return TEST_GEOMETRIES[static_cast<size_t>(m_geometry)].pIndices;
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: CreateHeadlessScene
+
+      Summary:  Creates a scene without voxels or a height map file, with
+                the point lights and the shaders its renderables use
+
+      Args:     BOOL bInstanced
+                  Whether the vertex shader has an instanced variant,
+                  so the renderer merges the renderables that can share
+                  an instanced draw
+
+      Returns:  std::shared_ptr<Scene>
+                  Empty scene
+    -----------------------------------------------------------------F-F*/
+    std::shared_ptr<Scene> CreateHeadlessScene(_In_ BOOL bInstanced)
+    {
+        std::shared_ptr<Scene> scene = std::make_shared<Scene>(TerrainData{});
+        for (UINT i = 0u; i < NUM_LIGHTS; ++i)
+        {
+            scene->AddPointLight(i, std::make_shared<PointLight>(XMFLOAT4(-5.0f + 10.0f * i, 10.0f, 0.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 50.0f));
+        }
+        std::shared_ptr<VertexShader> vertexShader = std::make_shared<VertexShader>(L"Shaders/Headless.fxh", "VS", "vs_5_0");
+        if (bInstanced)
+        {
+            vertexShader->SetInstancedVariant(std::make_shared<VertexShader>(L"Shaders/Headless.fxh", "VSInstanced", "vs_5_0"));
+        }
+        scene->AddVertexShader(HEADLESS_VERTEX_SHADER, vertexShader);
+        scene->AddPixelShader(HEADLESS_PIXEL_SHADER, std::make_shared<PixelShader>(L"Shaders/Headless.fxh", "PS", "ps_5_0"));
+
+        return scene;
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: AddTestRenderable
+
+      Summary:  Adds a TestRenderable drawn with the headless shaders to
+                a scene of CreateHeadlessScene
+
+      Args:     Scene& scene
+                  Scene to add the renderable to
+                const std::shared_ptr<GraphicsContext>& context
+                  Context to create the buffers with
+                eTestGeometry geometry
+                  Vertices and indices to draw
+                const XMFLOAT4& outputColor
+                  Color of the renderable
+                const XMFLOAT3& position
+                  World position of the renderable
+
+      Returns:  std::shared_ptr<TestRenderable>
+                  Added renderable
+    -----------------------------------------------------------------F-F*/
+    std::shared_ptr<TestRenderable> AddTestRenderable(_In_ Scene& scene, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ eTestGeometry geometry, _In_ const XMFLOAT4& outputColor, _In_ const XMFLOAT3& position)
+    {
+        WCHAR szName[32];
+        swprintf_s(szName, L"TestRenderable%zu", scene.GetRenderables().size());
+
+        std::shared_ptr<TestRenderable> renderable = std::make_shared<TestRenderable>(context, geometry, outputColor);
+        renderable->Translate(XMLoadFloat3(&position));
+        scene.AddRenderable(szName, renderable);
+        scene.SetVertexShaderOfRenderable(szName, HEADLESS_VERTEX_SHADER);
+        scene.SetPixelShaderOfRenderable(szName, HEADLESS_PIXEL_SHADER);
+
+        return renderable;
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: InitializeHeadlessRenderer
+
+      Summary:  Makes a scene the main scene of a renderer and
+                initializes the renderer headless, rendering through a
+                context
+
+      Args:     Renderer& renderer
+                  Renderer to initialize
+                const std::shared_ptr<GraphicsContext>& context
+                  Context to render through
+                const std::shared_ptr<Scene>& scene
+                  Scene to render
+
+      Returns:  HRESULT
+                  Status code
+    -----------------------------------------------------------------F-F*/
+    HRESULT InitializeHeadlessRenderer(_Inout_ Renderer& renderer, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ const std::shared_ptr<Scene>& scene)
+    {
+        HRESULT hr = renderer.AddScene(L"Headless", scene);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        hr = renderer.SetMainScene(L"Headless");
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        return renderer.Initialize(context, HEADLESS_WIDTH, HEADLESS_HEIGHT);
+    }
+}
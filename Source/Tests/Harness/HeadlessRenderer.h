@@ -0,0 +1,102 @@
+/*+===================================================================
+  File:      HEADLESSRENDERER.H
+
+  Summary:   HeadlessRenderer header file contains declarations of the
+             TestRenderable class and of the functions that set up a
+             Renderer without a device or a window for the tests.
+
+  Classes: TestRenderable
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include "Renderer/GraphicsContext.h"
+#include "Renderer/Renderable.h"
+#include "Renderer/Renderer.h"
+#include "Scene/Scene.h"
+
+namespace tests
+{
+    // Viewport of a headless renderer
+    constexpr const UINT HEADLESS_WIDTH = 1280u;
+    constexpr const UINT HEADLESS_HEIGHT = 720u;
+
+    // Shaders of a headless scene, never compiled, so they bind as nullptr
+    constexpr const PCWSTR HEADLESS_VERTEX_SHADER = L"HeadlessVS";
+    constexpr const PCWSTR HEADLESS_PIXEL_SHADER = L"HeadlessPS";
+
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eTestGeometry
+
+        Summary:  Enumeration of the vertices and indices a
+                  TestRenderable draws
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eTestGeometry : BYTE
+    {
+        CUBE,
+        QUAD,
+        COUNT,
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TestRenderable
+
+      Summary:  Renderable that creates its buffers through a graphics
+                context instead of a device, so a headless renderer can
+                draw it through a RecordingGraphicsContext. The
+                renderables of a geometry draw the same static arrays,
+                like the built-in shapes, but have buffers of their own.
+
+      Methods:  SetMaterial
+                  Draws the geometry as one mesh of a material
+                Initialize
+                  Creates the buffers through the context
+                Update
+                  Does nothing
+                GetNumVertices
+                  Returns the number of vertices
+                GetNumIndices
+                  Returns the number of indices
+                getVertices
+                  Returns the vertices of the geometry
+                getIndices
+                  Returns the indices of the geometry
+                TestRenderable
+                  Constructor.
+                ~TestRenderable
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TestRenderable final : public library::Renderable
+    {
+    public:
+        TestRenderable(_In_ const std::shared_ptr<library::GraphicsContext>& context, _In_ eTestGeometry geometry, _In_ const XMFLOAT4& outputColor);
+        TestRenderable(const TestRenderable& other) = delete;
+        TestRenderable(TestRenderable&& other) = delete;
+        TestRenderable& operator=(const TestRenderable& other) = delete;
+        TestRenderable& operator=(TestRenderable&& other) = delete;
+        ~TestRenderable() = default;
+
+        void SetMaterial(_In_ const std::shared_ptr<library::Material>& material);
+
+        HRESULT Initialize(_In_opt_ ID3D11Device* pDevice, _In_opt_ ID3D11DeviceContext* pImmediateContext, _In_opt_ library::GeometryRegistry* pGeometryRegistry) override;
+        void Update(_In_ FLOAT deltaTime) override;
+
+        UINT GetNumVertices() const override;
+        UINT GetNumIndices() const override;
+
+    protected:
+        const library::SimpleVertex* getVertices() const override;
+        const WORD* getIndices() const override;
+
+    private:
+        std::shared_ptr<library::GraphicsContext> m_context;
+        eTestGeometry m_geometry;
+    };
+
+    std::shared_ptr<library::Scene> CreateHeadlessScene(_In_ BOOL bInstanced = FALSE);
+    std::shared_ptr<TestRenderable> AddTestRenderable(_In_ library::Scene& scene, _In_ const std::shared_ptr<library::GraphicsContext>& context, _In_ eTestGeometry geometry, _In_ const XMFLOAT4& outputColor, _In_ const XMFLOAT3& position);
+    HRESULT InitializeHeadlessRenderer(_Inout_ library::Renderer& renderer, _In_ const std::shared_ptr<library::GraphicsContext>& context, _In_ const std::shared_ptr<library::Scene>& scene);
+}
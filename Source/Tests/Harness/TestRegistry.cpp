@@ -0,0 +1,199 @@
+#include "Harness/TestRegistry.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace tests
+{
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestContext::TestContext
+
+      Summary:  Constructor
+
+      Modifies: [m_uNumFailures].
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    TestContext::TestContext()
+        : m_uNumFailures(0u)
+    {
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestContext::Check
+
+      Summary:  Prints and counts a failed check
+
+      Args:     BOOL bCondition
+                  Result of the checked expression
+                PCSTR pszExpression
+                  Source text of the expression
+                PCSTR pszFile
+                  Source file of the check
+                INT iLine
+                  Source line of the check
+
+      Modifies: [m_uNumFailures].
+
+      Returns:  BOOL
+                  bCondition
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL TestContext::Check(_In_ BOOL bCondition, _In_ PCSTR pszExpression, _In_ PCSTR pszFile, _In_ INT iLine)
+    {
+        if (!bCondition)
+        {
+            ++m_uNumFailures;
+            printf("    %s(%d): CHECK(%s) failed\n", pszFile, iLine, pszExpression);
+        }
+
+        return bCondition;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestContext::Report
+
+      Summary:  Prints a measurement of a benchmark
+
+      Args:     PCSTR pszName
+                  Name of the measurement
+                DOUBLE value
+                  Measured value
+                PCSTR pszUnit
+                  Unit of the value
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    void TestContext::Report(_In_ PCSTR pszName, _In_ DOUBLE value, _In_ PCSTR pszUnit) const
+    {
+        printf("    %-48s %14.3f %s\n", pszName, value, pszUnit);
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestContext::MeasureMilliseconds
+
+      Summary:  Runs a function several times and returns the time of
+                the fastest run, which is the least disturbed by the
+                rest of the system
+
+      Args:     UINT uNumRuns
+                  Number of runs, at least one is made
+                const std::function<void()>& func
+                  Function to measure
+
+      Returns:  DOUBLE
+                  Time of the fastest run in milliseconds
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    DOUBLE TestContext::MeasureMilliseconds(_In_ UINT uNumRuns, _In_ const std::function<void()>& func) const
+    {
+        DOUBLE bestTime = 0.0;
+        for (UINT i = 0u; i < uNumRuns || i == 0u; ++i)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            func();
+            DOUBLE time = std::chrono::duration<DOUBLE, std::milli>(std::chrono::steady_clock::now() - start).count();
+            bestTime = (i == 0u || time < bestTime) ? time : bestTime;
+        }
+
+        return bestTime;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestContext::GetNumFailures
+
+      Summary:  Returns the number of failed checks
+
+      Returns:  UINT
+                  Number of failed checks
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TestContext::GetNumFailures() const
+    {
+        return m_uNumFailures;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRegistry::Add
+
+      Summary:  Registers a test or benchmark, called by the static
+                initializers that TEST_CASE and BENCHMARK define
+
+      Args:     eTestKind kind
+                  Kind of the function
+                PCSTR pszName
+                  Name of the function
+                TestFunction pFunction
+                  Function to run
+
+      Modifies: [getEntries()].
+
+      Returns:  BOOL
+                  TRUE
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    BOOL TestRegistry::Add(_In_ eTestKind kind, _In_ PCSTR pszName, _In_ TestFunction pFunction)
+    {
+        getEntries().push_back(
+            Entry
+            {
+                .Kind = kind,
+                .pszName = pszName,
+                .pFunction = pFunction
+            }
+        );
+
+        return TRUE;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRegistry::Run
+
+      Summary:  Runs the registered functions of a kind in registration
+                order and prints their results
+
+      Args:     eTestKind kind
+                  Kind of the functions to run
+                PCSTR pszFilter
+                  Only the functions whose name contains this string
+                  run, nullptr runs all of them
+
+      Returns:  UINT
+                  Number of functions with a failed check
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    UINT TestRegistry::Run(_In_ eTestKind kind, _In_opt_ PCSTR pszFilter)
+    {
+        UINT uNumRun = 0u;
+        UINT uNumFailed = 0u;
+        for (const Entry& entry : getEntries())
+        {
+            if (entry.Kind != kind || (pszFilter && !strstr(entry.pszName, pszFilter)))
+            {
+                continue;
+            }
+
+            printf("[ RUN  ] %s\n", entry.pszName);
+            TestContext context;
+            entry.pFunction(context);
+            printf("[ %s ] %s\n", context.GetNumFailures() == 0u ? " OK " : "FAIL", entry.pszName);
+
+            ++uNumRun;
+            if (context.GetNumFailures() != 0u)
+            {
+                ++uNumFailed;
+            }
+        }
+
+        printf("%u of %u %s passed\n", uNumRun - uNumFailed, uNumRun, kind == eTestKind::TEST ? "tests" : "benchmarks");
+
+        return uNumFailed;
+    }
+
+    /*M+M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M+++M
+      Method:   TestRegistry::getEntries
+
+      Summary:  Returns the registered functions. The list is a local
+                static so it exists before the first static initializer
+                of a test source adds to it.
+
+      Returns:  std::vector<Entry>&
+                  Registered functions
+    M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M---M-M*/
+    std::vector<TestRegistry::Entry>& TestRegistry::getEntries()
+    {
+        static std::vector<Entry> s_aEntries;
+        return s_aEntries;
+    }
+}
@@ -0,0 +1,127 @@
+/*+===================================================================
+  File:      TESTREGISTRY.H
+
+  Summary:   TestRegistry header file contains declarations of the
+             TestContext and TestRegistry classes and of the macros
+             that define headless tests and benchmarks of the Library.
+
+  Classes: TestContext, TestRegistry
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <functional>
+
+namespace tests
+{
+    /*E+E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E+++E
+        Enum:     eTestKind
+
+        Summary:  Enumeration of the kinds of registered functions
+    E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E---E-E*/
+    enum class eTestKind : BYTE
+    {
+        TEST,
+        BENCHMARK,
+    };
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TestContext
+
+      Summary:  Collects the failed checks and the measurements of the
+                test or benchmark that is running
+
+      Methods:  Check
+                  Records a failed check
+                Report
+                  Prints a measurement
+                MeasureMilliseconds
+                  Returns the fastest of several runs of a function
+                GetNumFailures
+                  Returns the number of failed checks
+                TestContext
+                  Constructor.
+                ~TestContext
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TestContext final
+    {
+    public:
+        TestContext();
+        TestContext(const TestContext& other) = delete;
+        TestContext(TestContext&& other) = delete;
+        TestContext& operator=(const TestContext& other) = delete;
+        TestContext& operator=(TestContext&& other) = delete;
+        ~TestContext() = default;
+
+        BOOL Check(_In_ BOOL bCondition, _In_ PCSTR pszExpression, _In_ PCSTR pszFile, _In_ INT iLine);
+        void Report(_In_ PCSTR pszName, _In_ DOUBLE value, _In_ PCSTR pszUnit) const;
+        DOUBLE MeasureMilliseconds(_In_ UINT uNumRuns, _In_ const std::function<void()>& func) const;
+        UINT GetNumFailures() const;
+
+    private:
+        UINT m_uNumFailures;
+    };
+
+    using TestFunction = void (*)(TestContext& context);
+
+    /*C+C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C+++C
+      Class:    TestRegistry
+
+      Summary:  Process wide list of the tests and benchmarks defined
+                with TEST_CASE and BENCHMARK, filled by the static
+                initializers of the test sources
+
+      Methods:  Add
+                  Registers a test or benchmark
+                Run
+                  Runs the registered functions of a kind
+                TestRegistry
+                  Constructor.
+                ~TestRegistry
+                  Destructor.
+    C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C---C-C*/
+    class TestRegistry final
+    {
+    public:
+        TestRegistry() = delete;
+        TestRegistry(const TestRegistry& other) = delete;
+        TestRegistry(TestRegistry&& other) = delete;
+        TestRegistry& operator=(const TestRegistry& other) = delete;
+        TestRegistry& operator=(TestRegistry&& other) = delete;
+        ~TestRegistry() = default;
+
+        static BOOL Add(_In_ eTestKind kind, _In_ PCSTR pszName, _In_ TestFunction pFunction);
+        static UINT Run(_In_ eTestKind kind, _In_opt_ PCSTR pszFilter);
+
+    private:
+        /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+            Struct:   Entry
+
+            Summary:  Registered test or benchmark
+        S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+        struct Entry
+        {
+            eTestKind Kind;
+            PCSTR pszName;
+            TestFunction pFunction;
+        };
+
+        static std::vector<Entry>& getEntries();
+    };
+}
+
+#define TESTS_DEFINE_FUNCTION(kind, name) \
+    static void name(_Inout_ tests::TestContext& context); \
+    static const BOOL s_b##name##Registered = tests::TestRegistry::Add(kind, #name, name); \
+    static void name(_Inout_ tests::TestContext& context)
+
+#define TEST_CASE(name) TESTS_DEFINE_FUNCTION(tests::eTestKind::TEST, name)
+#define BENCHMARK(name) TESTS_DEFINE_FUNCTION(tests::eTestKind::BENCHMARK, name)
+
+#define CHECK(expression) context.Check(static_cast<BOOL>(!!(expression)), #expression, __FILE__, __LINE__)
+#define CHECK_HR(expression) context.Check(static_cast<BOOL>(SUCCEEDED(expression)), #expression, __FILE__, __LINE__)
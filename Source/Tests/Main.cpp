@@ -0,0 +1,62 @@
+/*+===================================================================
+  File:      MAIN.CPP
+
+  Summary:   Entry point of the headless test runner of the Library.
+             Runs every test, and the benchmarks when asked to, without
+             a window or a GPU.
+
+  © 2022 Kyung Hee University
+===================================================================+*/
+
+#include "Common.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Harness/TestRegistry.h"
+
+/*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  Function: main
+
+  Summary:  Runs the tests and returns the number of failed ones, so
+            a build script can fail on a non-zero exit code.
+
+            Tests.exe [--bench] [--filter <substring>]
+
+  Args:     INT argc
+              Number of command line arguments
+            CHAR* argv[]
+              Command line arguments
+
+  Returns:  INT
+              Number of failed tests and benchmarks
+-----------------------------------------------------------------F-F*/
+INT main(_In_ INT argc, _In_reads_(argc) CHAR* argv[])
+{
+    BOOL bRunBenchmarks = FALSE;
+    PCSTR pszFilter = nullptr;
+    for (INT i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench") == 0)
+        {
+            bRunBenchmarks = TRUE;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            pszFilter = argv[++i];
+        }
+        else
+        {
+            printf("Usage: %s [--bench] [--filter <substring>]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    UINT uNumFailed = tests::TestRegistry::Run(tests::eTestKind::TEST, pszFilter);
+    if (bRunBenchmarks)
+    {
+        uNumFailed += tests::TestRegistry::Run(tests::eTestKind::BENCHMARK, pszFilter);
+    }
+
+    return static_cast<INT>(uNumFailed);
+}
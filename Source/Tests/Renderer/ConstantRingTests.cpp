@@ -0,0 +1,291 @@
+#include "Harness/TestRegistry.h"
+
+#include <set>
+
+#include "Harness/HeadlessRenderer.h"
+#include "Renderer/ConstantRing.h"
+#include "Renderer/RecordingGraphicsContext.h"
+#include "Shader/ShadowVertexShader.h"
+
+using namespace library;
+using namespace tests;
+
+namespace
+{
+    constexpr const UINT NUM_RENDERABLES = 24u;
+    // Ranges a full ring holds in the fallback test
+    constexpr const UINT NUM_RING_RANGES = 4u;
+    // Constants of the range of a CBChangesEveryFrame
+    constexpr const UINT NUM_DRAW_CONSTANTS = ConstantRing::RANGE_ALIGNMENT / ConstantRing::CONSTANT_SIZE;
+
+    // Cubes in a row in front of the camera, none of them culled
+    std::vector<std::shared_ptr<TestRenderable>> addCubes(_In_ Scene& scene, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ UINT uNumRenderables)
+    {
+        std::vector<std::shared_ptr<TestRenderable>> aRenderables;
+        for (UINT uRenderableIdx = 0u; uRenderableIdx < uNumRenderables; ++uRenderableIdx)
+        {
+            XMFLOAT3 position(-4.5f + static_cast<FLOAT>(uRenderableIdx % 10u), -1.0f + static_cast<FLOAT>(uRenderableIdx / 10u), 10.0f);
+            aRenderables.push_back(AddTestRenderable(scene, context, eTestGeometry::CUBE, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), position));
+        }
+
+        return aRenderables;
+    }
+
+    std::vector<GraphicsCommand> findCommands(_In_ const RecordingGraphicsContext& recording, _In_ eGraphicsCommand command, _In_ UINT uStartSlot = 0u)
+    {
+        std::vector<GraphicsCommand> aFoundCommands;
+        for (const GraphicsCommand& recordedCommand : recording.GetCommands())
+        {
+            if (recordedCommand.Command == command && recordedCommand.uStartSlot == uStartSlot)
+            {
+                aFoundCommands.push_back(recordedCommand);
+            }
+        }
+
+        return aFoundCommands;
+    }
+
+    UINT countCalls(_In_ const RecordingGraphicsContext& recording, _In_ eGraphicsCommand command)
+    {
+        return recording.GetCounters().aNumCalls[static_cast<size_t>(command)];
+    }
+
+    // Bytes the shadow pass uploads, the statistics are only reset by Render
+    UINT renderShadowPass(_Inout_ Renderer& renderer, _Inout_ RecordingGraphicsContext& recording)
+    {
+        UINT uNumUploadedBytes = renderer.GetDrawStatistics().uNumUploadedBytes;
+        recording.Reset();
+        renderer.RenderSceneToTexture();
+
+        return renderer.GetDrawStatistics().uNumUploadedBytes - uNumUploadedBytes;
+    }
+}
+
+TEST_CASE(ConstantRingAlignsRangesAndDiscardsOncePerFrame)
+{
+    constexpr const UINT RING_SIZE = 8u * ConstantRing::RANGE_ALIGNMENT;
+
+    RecordingGraphicsContext recording;
+    ConstantRing ring;
+    UINT uFirstConstant = 0u;
+    UINT uNumConstants = 0u;
+    CHECK(ring.Map(recording) == E_NOT_VALID_STATE);
+    CHECK(ring.Initialize(recording, ConstantRing::RANGE_ALIGNMENT + 16u) == E_INVALIDARG);
+    if (!CHECK_HR(ring.Initialize(recording, RING_SIZE)))
+    {
+        return;
+    }
+    CHECK(ring.GetBuffer());
+    CHECK(ring.Allocate(16u, uFirstConstant, uNumConstants) == nullptr);
+
+    // Every range starts on 16 constants and is rounded up to them, until the frame used up the ring
+    CHECK_HR(ring.Map(recording));
+    CHECK(ring.Map(recording) == E_NOT_VALID_STATE);
+    const UINT aNumBytes[] = { 1u, sizeof(CBChangesEveryFrame), 256u, 257u, 600u };
+    const UINT aNumRangeBytes[] = { 256u, 256u, 256u, 512u, 768u };
+    BYTE* pBase = nullptr;
+    UINT uNextConstant = 0u;
+    for (UINT uRangeIdx = 0u; uRangeIdx < ARRAYSIZE(aNumBytes); ++uRangeIdx)
+    {
+        BYTE* pRange = static_cast<BYTE*>(ring.Allocate(aNumBytes[uRangeIdx], uFirstConstant, uNumConstants));
+        if (!CHECK(pRange))
+        {
+            return;
+        }
+        pBase = uRangeIdx == 0u ? pRange : pBase;
+        memset(pRange, 0xA5, aNumBytes[uRangeIdx]);
+
+        CHECK(uFirstConstant == uNextConstant);
+        CHECK(uFirstConstant * ConstantRing::CONSTANT_SIZE % ConstantRing::RANGE_ALIGNMENT == 0u);
+        CHECK(uNumConstants * ConstantRing::CONSTANT_SIZE == aNumRangeBytes[uRangeIdx]);
+        CHECK(pRange == pBase + uFirstConstant * ConstantRing::CONSTANT_SIZE);
+        uNextConstant += uNumConstants;
+    }
+    CHECK(uNextConstant * ConstantRing::CONSTANT_SIZE == RING_SIZE);
+    CHECK(ring.Allocate(1u, uFirstConstant, uNumConstants) == nullptr);
+    CHECK(uFirstConstant == 0u && uNumConstants == 0u);
+    ring.Unmap(recording);
+    CHECK(!ring.IsMapped());
+
+    // A later map of the frame appends, it has no room left either
+    CHECK_HR(ring.Map(recording));
+    CHECK(ring.Allocate(1u, uFirstConstant, uNumConstants) == nullptr);
+    ring.Unmap(recording);
+
+    // A new frame discards, and starts from the first constant again
+    ring.BeginFrame();
+    CHECK_HR(ring.Map(recording));
+    CHECK(ring.Allocate(ConstantRing::MAX_RANGE_SIZE + 1u, uFirstConstant, uNumConstants) == nullptr);
+    CHECK(ring.Allocate(sizeof(CBChangesEveryFrame), uFirstConstant, uNumConstants) != nullptr);
+    CHECK(uFirstConstant == 0u && uNumConstants == NUM_DRAW_CONSTANTS);
+    ring.Unmap(recording);
+    CHECK(ring.GetNumAllocatedBytes() == RING_SIZE + ConstantRing::RANGE_ALIGNMENT);
+
+    const std::vector<GraphicsCommand> aMaps = findCommands(recording, eGraphicsCommand::MAP_BUFFER);
+    if (!CHECK(aMaps.size() == 3u))
+    {
+        return;
+    }
+    CHECK(aMaps[0].MapType == D3D11_MAP_WRITE_DISCARD);
+    CHECK(aMaps[1].MapType == D3D11_MAP_WRITE_NO_OVERWRITE);
+    CHECK(aMaps[2].MapType == D3D11_MAP_WRITE_DISCARD);
+    for (const GraphicsCommand& map : aMaps)
+    {
+        CHECK(map.uValue == RING_SIZE);
+        CHECK(recording.GetObjects()[map.uFirstObject] == ring.GetBuffer().Get());
+    }
+    CHECK(countCalls(recording, eGraphicsCommand::UNMAP_BUFFER) == 3u);
+}
+
+TEST_CASE(RendererBindsRangesOfConstantRing)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    std::vector<std::shared_ptr<TestRenderable>> aRenderables = addCubes(*scene, recording, NUM_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)) || !CHECK_HR(renderer.InitializeConstantRing()))
+    {
+        return;
+    }
+
+    // The constants of every renderable go to a range of its own, in one map that discards
+    recording->Reset();
+    renderer.Render();
+    std::vector<GraphicsCommand> aMaps = findCommands(*recording, eGraphicsCommand::MAP_BUFFER);
+    if (!CHECK(aMaps.size() == 1u))
+    {
+        return;
+    }
+    const void* pRingBuffer = recording->GetObjects()[aMaps[0].uFirstObject];
+    CHECK(aMaps[0].MapType == D3D11_MAP_WRITE_DISCARD);
+    CHECK(countCalls(*recording, eGraphicsCommand::UNMAP_BUFFER) == 1u);
+    CHECK(recording->GetCounters().uNumDrawCalls == NUM_RENDERABLES);
+    CHECK(recording->GetCounters().uNumUpdates == 2u);
+    CHECK(renderer.GetDrawStatistics().uNumUploadedBytes == sizeof(CBChangeOnCameraMovement) + sizeof(CBLights) + NUM_RENDERABLES * ConstantRing::RANGE_ALIGNMENT);
+
+    const std::vector<GraphicsCommand> aVertexShaderRanges = findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, 2u);
+    const std::vector<GraphicsCommand> aPixelShaderRanges = findCommands(*recording, eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1, 2u);
+    CHECK(aVertexShaderRanges.size() == NUM_RENDERABLES);
+    CHECK(aPixelShaderRanges.size() == NUM_RENDERABLES);
+    std::set<UINT> firstConstants;
+    for (const GraphicsCommand& bind : aVertexShaderRanges)
+    {
+        CHECK(bind.uNumObjects == 1u);
+        CHECK(recording->GetObjects()[bind.uFirstObject] == pRingBuffer);
+        CHECK(bind.uValue % NUM_DRAW_CONSTANTS == 0u);
+        CHECK(bind.uValue < NUM_RENDERABLES * NUM_DRAW_CONSTANTS);
+        CHECK(bind.uNumConstants == NUM_DRAW_CONSTANTS);
+        firstConstants.insert(bind.uValue);
+    }
+    CHECK(firstConstants.size() == NUM_RENDERABLES);
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS, 2u).empty());
+
+    // Renderables that stopped moving update their own buffer once, then upload nothing
+    recording->Reset();
+    renderer.Render();
+    CHECK(countCalls(*recording, eGraphicsCommand::MAP_BUFFER) == 0u);
+    CHECK(recording->GetCounters().uNumUpdates == 2u + NUM_RENDERABLES);
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, 2u).empty());
+    recording->Reset();
+    renderer.Render();
+    CHECK(recording->GetCounters().uNumUpdates == 2u);
+    CHECK(renderer.GetDrawStatistics().uNumUploadedBytes == sizeof(CBChangeOnCameraMovement) + sizeof(CBLights));
+
+    // A renderable that moves gets the first range of the next frame, which discards again
+    aRenderables[5]->Translate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+    recording->Reset();
+    renderer.Render();
+    aMaps = findCommands(*recording, eGraphicsCommand::MAP_BUFFER);
+    CHECK(aMaps.size() == 1u && aMaps[0].MapType == D3D11_MAP_WRITE_DISCARD);
+    const std::vector<GraphicsCommand> aMovedRanges = findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, 2u);
+    CHECK(aMovedRanges.size() == 1u && aMovedRanges[0].uValue == 0u && aMovedRanges[0].uNumConstants == NUM_DRAW_CONSTANTS);
+    CHECK(recording->GetCounters().uNumUpdates == 2u);
+}
+
+TEST_CASE(RendererFallsBackWhenConstantRingIsFull)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    std::vector<std::shared_ptr<TestRenderable>> aRenderables = addCubes(*scene, recording, NUM_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene))
+        || !CHECK_HR(renderer.InitializeConstantRing(NUM_RING_RANGES * ConstantRing::RANGE_ALIGNMENT)))
+    {
+        return;
+    }
+
+    // The first renderables get the ranges, the others update and bind their own buffer
+    recording->Reset();
+    renderer.Render();
+    const std::vector<GraphicsCommand> aRanges = findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, 2u);
+    std::set<UINT> firstConstants;
+    for (const GraphicsCommand& bind : aRanges)
+    {
+        CHECK(bind.uNumConstants == NUM_DRAW_CONSTANTS);
+        firstConstants.insert(bind.uValue);
+    }
+    CHECK(aRanges.size() == NUM_RING_RANGES);
+    CHECK(firstConstants == std::set<UINT>({ 0u, NUM_DRAW_CONSTANTS, 2u * NUM_DRAW_CONSTANTS, 3u * NUM_DRAW_CONSTANTS }));
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS, 2u).size() == NUM_RENDERABLES - NUM_RING_RANGES);
+    CHECK(recording->GetCounters().uNumDrawCalls == NUM_RENDERABLES);
+    CHECK(recording->GetCounters().uNumUpdates == 2u + NUM_RENDERABLES - NUM_RING_RANGES);
+    CHECK(renderer.GetDrawStatistics().uNumUploadedBytes
+        == sizeof(CBChangeOnCameraMovement) + sizeof(CBLights)
+        + NUM_RING_RANGES * ConstantRing::RANGE_ALIGNMENT + (NUM_RENDERABLES - NUM_RING_RANGES) * sizeof(CBChangesEveryFrame));
+
+    // The next frame rewinds the ring, when all of them move it is full again after as many ranges
+    for (const std::shared_ptr<TestRenderable>& renderable : aRenderables)
+    {
+        renderable->Translate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+    }
+    recording->Reset();
+    renderer.Render();
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1, 2u).size() == NUM_RING_RANGES);
+    CHECK(recording->GetCounters().uNumUpdates == 2u + NUM_RENDERABLES - NUM_RING_RANGES);
+}
+
+TEST_CASE(ShadowPassUploadsOnlyChangedConstants)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    std::vector<std::shared_ptr<TestRenderable>> aRenderables = addCubes(*scene, recording, NUM_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)))
+    {
+        return;
+    }
+    renderer.SetShadowMapShaders(
+        std::make_shared<ShadowVertexShader>(L"Shaders/Headless.fxh", "VSShadow", "vs_5_0"),
+        std::make_shared<PixelShader>(L"Shaders/Headless.fxh", "PSShadow", "ps_5_0"));
+    const UINT uNumDraws = static_cast<UINT>(scene->GetRenderables().size() + scene->GetVoxels().size());
+
+    // Without a ring every draw creates and updates its own buffer once, there is no shadow map to bind
+    CHECK(renderShadowPass(renderer, *recording) == uNumDraws * sizeof(CBShadowMatrix));
+    CHECK(recording->GetCounters().uNumUpdates == uNumDraws);
+    CHECK(countCalls(*recording, eGraphicsCommand::CLEAR_RENDER_TARGET_VIEW) == 0u);
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS).size() == uNumDraws);
+
+    // The second frame of a static scene uploads nothing, a renderable that moves uploads its buffer alone
+    CHECK(renderShadowPass(renderer, *recording) == 0u);
+    CHECK(recording->GetCounters().uNumUpdates == 0u);
+    aRenderables[5]->Translate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+    CHECK(renderShadowPass(renderer, *recording) == sizeof(CBShadowMatrix));
+    const std::vector<GraphicsCommand> aUpdates = findCommands(*recording, eGraphicsCommand::UPDATE_BUFFER);
+    CHECK(aUpdates.size() == 1u);
+    CHECK(aUpdates.size() == 1u && recording->GetObjects()[aUpdates[0].uFirstObject] == aRenderables[5]->GetShadowConstantBuffer().Get());
+
+    // With a ring a renderable that moves gets a range, its buffer catches up once it stops
+    if (!CHECK_HR(renderer.InitializeConstantRing()))
+    {
+        return;
+    }
+    aRenderables[5]->Translate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+    CHECK(renderShadowPass(renderer, *recording) == ConstantRing::RANGE_ALIGNMENT);
+    CHECK(recording->GetCounters().uNumUpdates == 0u);
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1).size() == 1u);
+    CHECK(renderShadowPass(renderer, *recording) == sizeof(CBShadowMatrix));
+    CHECK(countCalls(*recording, eGraphicsCommand::MAP_BUFFER) == 0u);
+    CHECK(renderShadowPass(renderer, *recording) == 0u);
+    CHECK(recording->GetCounters().uNumUpdates == 0u);
+    CHECK(findCommands(*recording, eGraphicsCommand::VS_SET_CONSTANT_BUFFERS).size() == uNumDraws);
+}
@@ -0,0 +1,228 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "Renderer/DrawQueue.h"
+
+using namespace library;
+
+namespace
+{
+    // Keys like a frame queues them, few shader pairs and materials with random depths
+    std::vector<UINT64> makeFrameKeys(_In_ UINT uNumItems, _In_ UINT uSeed)
+    {
+        std::mt19937 random(uSeed);
+        std::uniform_real_distribution<FLOAT> depthDistribution(0.5f, 500.0f);
+        std::vector<UINT64> aKeys(uNumItems);
+        for (UINT64& uKey : aKeys)
+        {
+            eRenderPass pass = random() % 64u == 0u ? eRenderPass::SKYBOX : eRenderPass::MESHES;
+            uKey = DrawQueue::MakeSortKey(pass, random() % 8u, random() % 200u, depthDistribution(random));
+        }
+
+        return aKeys;
+    }
+
+    // Items that remember the order they were added in, in their first constant
+    std::vector<DrawItem> makeItems(_In_ const std::vector<UINT64>& aKeys)
+    {
+        std::vector<DrawItem> aItems(aKeys.size());
+        for (UINT uItemIdx = 0u; uItemIdx < aItems.size(); ++uItemIdx)
+        {
+            aItems[uItemIdx] = DrawItem{ .uSortKey = aKeys[uItemIdx], .uMeshIndex = DrawQueue::WHOLE_RENDERABLE, .uFirstConstant = uItemIdx };
+        }
+
+        return aItems;
+    }
+
+    void stableSortItems(_Inout_ std::vector<DrawItem>& aItems)
+    {
+        std::stable_sort(aItems.begin(), aItems.end(), [](const DrawItem& item, const DrawItem& other) { return item.uSortKey < other.uSortKey; });
+    }
+
+    // Whether the queue sorts the items into the order of std::stable_sort on their keys
+    BOOL sortsLikeStableSort(_In_ const std::vector<UINT64>& aKeys)
+    {
+        std::vector<DrawItem> aExpectedItems = makeItems(aKeys);
+        DrawQueue queue;
+        for (const DrawItem& item : aExpectedItems)
+        {
+            queue.Add(item);
+        }
+        queue.Sort();
+        stableSortItems(aExpectedItems);
+
+        const std::vector<DrawItem>& aItems = queue.GetItems();
+        if (aItems.size() != aExpectedItems.size())
+        {
+            return FALSE;
+        }
+        for (size_t uItemIdx = 0u; uItemIdx < aItems.size(); ++uItemIdx)
+        {
+            if (aItems[uItemIdx].uSortKey != aExpectedItems[uItemIdx].uSortKey || aItems[uItemIdx].uFirstConstant != aExpectedItems[uItemIdx].uFirstConstant)
+            {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+}
+
+TEST_CASE(DrawQueueSortMatchesStableSort)
+{
+    std::mt19937_64 random(17u);
+    for (UINT uNumItems : { 0u, 1u, 2u, 3u, 255u, 256u, 257u, 5000u, 100000u })
+    {
+        // Keys that vary in every digit
+        std::vector<UINT64> aKeys(uNumItems);
+        for (UINT64& uKey : aKeys)
+        {
+            uKey = random();
+        }
+        CHECK(sortsLikeStableSort(aKeys));
+
+        // Few distinct keys, so most items tie and the sort has to keep their order
+        for (UINT64& uKey : aKeys)
+        {
+            uKey = (random() % 5u) << (random() % 8u * 8u);
+        }
+        CHECK(sortsLikeStableSort(aKeys));
+
+        aKeys = makeFrameKeys(uNumItems, uNumItems);
+        CHECK(sortsLikeStableSort(aKeys));
+
+        // Sorted and reversed input, and a single key that skips every pass
+        std::sort(aKeys.begin(), aKeys.end());
+        CHECK(sortsLikeStableSort(aKeys));
+        std::reverse(aKeys.begin(), aKeys.end());
+        CHECK(sortsLikeStableSort(aKeys));
+        std::fill(aKeys.begin(), aKeys.end(), DrawQueue::MakeSortKey(eRenderPass::MESHES, 3u, 7u, 10.0f));
+        CHECK(sortsLikeStableSort(aKeys));
+    }
+}
+
+TEST_CASE(DrawQueueSortKeyOrdersFields)
+{
+    // The pass comes first, then the shader pair, the material and the depth
+    CHECK(DrawQueue::MakeSortKey(eRenderPass::MESHES, DrawQueue::MAX_SHADER_IDS - 1u, DrawQueue::MAX_MATERIAL_IDS - 1u, 1.0e6f) < DrawQueue::MakeSortKey(eRenderPass::SKYBOX, 0u, 0u, 0.0f));
+    CHECK(DrawQueue::MakeSortKey(eRenderPass::MESHES, 1u, DrawQueue::MAX_MATERIAL_IDS - 1u, 1.0e6f) < DrawQueue::MakeSortKey(eRenderPass::MESHES, 2u, 0u, 0.0f));
+    CHECK(DrawQueue::MakeSortKey(eRenderPass::MESHES, 1u, 4u, 1.0e6f) < DrawQueue::MakeSortKey(eRenderPass::MESHES, 1u, 5u, 0.0f));
+
+    // Near draws come first, negative depths clamp to zero
+    BOOL bMonotonic = TRUE;
+    FLOAT previousDepth = 0.0f;
+    for (FLOAT depth = 0.01f; depth < 1.0e5f; depth *= 1.5f)
+    {
+        bMonotonic &= DrawQueue::MakeSortKey(eRenderPass::MESHES, 0u, 0u, previousDepth) <= DrawQueue::MakeSortKey(eRenderPass::MESHES, 0u, 0u, depth);
+        previousDepth = depth;
+    }
+    CHECK(bMonotonic);
+    CHECK(DrawQueue::MakeSortKey(eRenderPass::MESHES, 0u, 0u, -3.0f) == DrawQueue::MakeSortKey(eRenderPass::MESHES, 0u, 0u, 0.0f));
+
+    UINT64 uSortKey = DrawQueue::MakeSortKey(eRenderPass::SKYBOX, 9u, 300u, 42.0f);
+    CHECK(DrawQueue::GetPass(uSortKey) == eRenderPass::SKYBOX);
+    CHECK(DrawQueue::GetStateKey(uSortKey) == DrawQueue::GetStateKey(DrawQueue::MakeSortKey(eRenderPass::SKYBOX, 9u, 300u, 0.5f)));
+    CHECK(DrawQueue::GetStateKey(uSortKey) != DrawQueue::GetStateKey(DrawQueue::MakeSortKey(eRenderPass::SKYBOX, 9u, 301u, 42.0f)));
+}
+
+TEST_CASE(DrawQueueIdsAndRemoveHidden)
+{
+    // Only the addresses are used as keys, so stand-ins do for the materials and shaders
+    DrawQueue queue;
+    const Material* pMaterial = reinterpret_cast<const Material*>(static_cast<uintptr_t>(0x30u));
+    const Material* pOtherMaterial = reinterpret_cast<const Material*>(static_cast<uintptr_t>(0x40u));
+    ID3D11VertexShader* pVertexShader = reinterpret_cast<ID3D11VertexShader*>(static_cast<uintptr_t>(0x10u));
+    ID3D11PixelShader* pPixelShader = reinterpret_cast<ID3D11PixelShader*>(static_cast<uintptr_t>(0x20u));
+
+    // Ids are given in the order they are first asked for, and forgotten by Clear
+    CHECK(queue.GetMaterialId(nullptr) == 0u);
+    CHECK(queue.GetMaterialId(pOtherMaterial) == 1u);
+    CHECK(queue.GetMaterialId(pMaterial) == 2u);
+    CHECK(queue.GetMaterialId(pOtherMaterial) == 1u);
+    CHECK(queue.GetShaderId(pVertexShader, pPixelShader) == 0u);
+    CHECK(queue.GetShaderId(pVertexShader, nullptr) == 1u);
+    CHECK(queue.GetShaderId(pVertexShader, pPixelShader) == 0u);
+
+    std::vector<DrawItem> aItems = makeItems(makeFrameKeys(100u, 5u));
+    for (const DrawItem& item : aItems)
+    {
+        queue.Add(item);
+    }
+    std::vector<BOOL> aVisible(90u);
+    for (UINT uItemIdx = 0u; uItemIdx < aVisible.size(); ++uItemIdx)
+    {
+        aVisible[uItemIdx] = uItemIdx % 3u != 0u;
+    }
+    queue.RemoveHidden(aVisible);
+
+    // The visible items keep their order, the items past the visibility are kept
+    BOOL bKeptInOrder = queue.GetItems().size() == 60u + 10u;
+    UINT uItemIdx = 0u;
+    for (const DrawItem& item : queue.GetItems())
+    {
+        while (uItemIdx < aVisible.size() && !aVisible[uItemIdx])
+        {
+            ++uItemIdx;
+        }
+        bKeptInOrder &= item.uFirstConstant == uItemIdx++;
+    }
+    CHECK(bKeptInOrder);
+
+    queue.Clear();
+    CHECK(queue.GetItems().empty());
+    CHECK(queue.GetMaterialId(pMaterial) == 1u);
+    CHECK(queue.GetShaderId(pVertexShader, nullptr) == 0u);
+}
+
+BENCHMARK(DrawQueueSortPerformance)
+{
+    constexpr const UINT NUM_ITEMS = 100000u;
+
+    std::vector<UINT64> aFrameKeys = makeFrameKeys(NUM_ITEMS, 23u);
+    std::vector<UINT64> aRandomKeys(NUM_ITEMS);
+    std::mt19937_64 random(29u);
+    for (UINT64& uKey : aRandomKeys)
+    {
+        uKey = random();
+    }
+
+    // Every run sorts a copy of the unsorted items, the copy is measured on its own
+    DrawQueue queue;
+    for (const auto& [pszKeys, pKeys] : { std::make_pair("frame keys", &aFrameKeys), std::make_pair("random keys", &aRandomKeys) })
+    {
+        std::vector<DrawItem> aItems = makeItems(*pKeys);
+        std::vector<DrawItem> aSortedItems;
+        DOUBLE copyTime = context.MeasureMilliseconds(20u, [&]()
+        {
+            aSortedItems = aItems;
+        });
+        DOUBLE radixTime = context.MeasureMilliseconds(20u, [&]()
+        {
+            queue.GetItems() = aItems;
+            queue.Sort();
+        });
+        DOUBLE stableSortTime = context.MeasureMilliseconds(20u, [&]()
+        {
+            aSortedItems = aItems;
+            stableSortItems(aSortedItems);
+        });
+        DOUBLE sortTime = context.MeasureMilliseconds(20u, [&]()
+        {
+            aSortedItems = aItems;
+            std::sort(aSortedItems.begin(), aSortedItems.end(), [](const DrawItem& item, const DrawItem& other) { return item.uSortKey < other.uSortKey; });
+        });
+
+        CHAR szName[64];
+        sprintf_s(szName, "%u items, %s, radix sort", NUM_ITEMS, pszKeys);
+        context.Report(szName, radixTime - copyTime, "ms");
+        sprintf_s(szName, "%u items, %s, std::stable_sort", NUM_ITEMS, pszKeys);
+        context.Report(szName, stableSortTime - copyTime, "ms");
+        sprintf_s(szName, "%u items, %s, std::sort", NUM_ITEMS, pszKeys);
+        context.Report(szName, sortTime - copyTime, "ms");
+        sprintf_s(szName, "%s, radix sort", pszKeys);
+        context.Report(szName, NUM_ITEMS / (radixTime - copyTime) / 1000.0, "Mitems/s");
+    }
+}
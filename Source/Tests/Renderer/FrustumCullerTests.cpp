@@ -0,0 +1,278 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Renderer/FrustumCuller.h"
+#include "Scene/Noise.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const FLOAT NEAR_Z = 0.1f;
+    constexpr const FLOAT FAR_Z = 1000.0f;
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   ReferenceFrustum
+
+      Summary:  Planes of a view frustum in double precision, built from
+                its corners instead of the view projection matrix, with
+                the matrix to test points in clip space
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct ReferenceFrustum
+    {
+        DOUBLE aPlanes[FrustumCuller::NUM_PLANES][4];
+        DOUBLE aViewProjection[4][4];
+    };
+
+    XMMATRIX makeViewProjection(_In_ const XMFLOAT3& eye, _In_ const XMFLOAT3& at, _In_ FLOAT fieldOfView, _In_ FLOAT aspectRatio)
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&at), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return view * XMMatrixPerspectiveFovLH(fieldOfView, aspectRatio, NEAR_Z, FAR_Z);
+    }
+
+    // Point of clip space on the near (z = 0) or far (z = 1) plane, back in world space
+    void unproject(_In_ const XMMATRIX& inverseViewProjection, _In_ DOUBLE x, _In_ DOUBLE y, _In_ DOUBLE z, _Out_writes_(3) DOUBLE* aOutPoint)
+    {
+        XMFLOAT4X4 m;
+        XMStoreFloat4x4(&m, inverseViewProjection);
+        DOUBLE aClip[4] = { x, y, z, 1.0 };
+        DOUBLE aWorld[4] = {};
+        for (UINT uColumn = 0u; uColumn < 4u; ++uColumn)
+        {
+            for (UINT uRow = 0u; uRow < 4u; ++uRow)
+            {
+                aWorld[uColumn] += aClip[uRow] * m.m[uRow][uColumn];
+            }
+        }
+        for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+        {
+            aOutPoint[uAxis] = aWorld[uAxis] / aWorld[3];
+        }
+    }
+
+    ReferenceFrustum makeReferenceFrustum(_In_ const XMMATRIX& viewProjection)
+    {
+        ReferenceFrustum frustum = {};
+        XMFLOAT4X4 m;
+        XMStoreFloat4x4(&m, viewProjection);
+        for (UINT uRow = 0u; uRow < 4u; ++uRow)
+        {
+            for (UINT uColumn = 0u; uColumn < 4u; ++uColumn)
+            {
+                frustum.aViewProjection[uRow][uColumn] = m.m[uRow][uColumn];
+            }
+        }
+
+        // Corner i has x = -1 or 1 by bit 0, y by bit 1 and the near or far plane by bit 2
+        XMMATRIX inverseViewProjection = XMMatrixInverse(nullptr, viewProjection);
+        DOUBLE aCorners[8][3];
+        DOUBLE aCentroid[3] = {};
+        for (UINT uCornerIdx = 0u; uCornerIdx < 8u; ++uCornerIdx)
+        {
+            unproject(inverseViewProjection, uCornerIdx & 1u ? 1.0 : -1.0, uCornerIdx & 2u ? 1.0 : -1.0, uCornerIdx & 4u ? 1.0 : 0.0, aCorners[uCornerIdx]);
+            for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+            {
+                aCentroid[uAxis] += aCorners[uCornerIdx][uAxis] / 8.0;
+            }
+        }
+
+        // Three corners of every face, in the order of ExtractPlanes: left, right, bottom, top, near, far
+        const UINT aFaceCorners[FrustumCuller::NUM_PLANES][3] = { { 0u, 2u, 4u }, { 1u, 3u, 5u }, { 0u, 1u, 4u }, { 2u, 3u, 6u }, { 0u, 1u, 2u }, { 4u, 5u, 6u } };
+        for (UINT uPlane = 0u; uPlane < FrustumCuller::NUM_PLANES; ++uPlane)
+        {
+            const DOUBLE* a = aCorners[aFaceCorners[uPlane][0]];
+            const DOUBLE* b = aCorners[aFaceCorners[uPlane][1]];
+            const DOUBLE* c = aCorners[aFaceCorners[uPlane][2]];
+            DOUBLE u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            DOUBLE v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            DOUBLE n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+            DOUBLE length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            DOUBLE d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]) / length;
+            DOUBLE sign = (n[0] * aCentroid[0] + n[1] * aCentroid[1] + n[2] * aCentroid[2]) / length + d > 0.0 ? 1.0 : -1.0;
+            for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+            {
+                frustum.aPlanes[uPlane][uAxis] = sign * n[uAxis] / length;
+            }
+            frustum.aPlanes[uPlane][3] = sign * d;
+        }
+
+        return frustum;
+    }
+
+    // Smallest margin of a box over the planes, the plane test culls the box when it is negative
+    DOUBLE getPlaneMargin(_In_ const ReferenceFrustum& frustum, _In_ const AxisAlignedBox& box)
+    {
+        DOUBLE minMargin = DBL_MAX;
+        for (const DOUBLE* aPlane : frustum.aPlanes)
+        {
+            DOUBLE distance = aPlane[0] * box.Center.x + aPlane[1] * box.Center.y + aPlane[2] * box.Center.z + aPlane[3];
+            DOUBLE radius = std::abs(aPlane[0]) * box.Extents.x + std::abs(aPlane[1]) * box.Extents.y + std::abs(aPlane[2]) * box.Extents.z;
+            minMargin = std::min(minMargin, distance + radius);
+        }
+
+        return minMargin;
+    }
+
+    // Whether a corner or the center of a box is strictly inside the clip volume
+    BOOL hasPointInside(_In_ const ReferenceFrustum& frustum, _In_ const AxisAlignedBox& box)
+    {
+        for (UINT uPointIdx = 0u; uPointIdx < 9u; ++uPointIdx)
+        {
+            DOUBLE aPoint[4] = { box.Center.x, box.Center.y, box.Center.z, 1.0 };
+            if (uPointIdx < 8u)
+            {
+                aPoint[0] += uPointIdx & 1u ? box.Extents.x : -box.Extents.x;
+                aPoint[1] += uPointIdx & 2u ? box.Extents.y : -box.Extents.y;
+                aPoint[2] += uPointIdx & 4u ? box.Extents.z : -box.Extents.z;
+            }
+
+            DOUBLE aClip[4] = {};
+            for (UINT uColumn = 0u; uColumn < 4u; ++uColumn)
+            {
+                for (UINT uRow = 0u; uRow < 4u; ++uRow)
+                {
+                    aClip[uColumn] += aPoint[uRow] * frustum.aViewProjection[uRow][uColumn];
+                }
+            }
+
+            DOUBLE w = aClip[3] * 0.999;
+            if (std::abs(aClip[0]) < w && std::abs(aClip[1]) < w && aClip[2] > w * 1.0e-3 && aClip[2] < w)
+            {
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+    AxisAlignedBox makeRandomBox(_Inout_ std::mt19937& random, _In_ FLOAT range)
+    {
+        std::uniform_real_distribution<FLOAT> centerDistribution(-range, range);
+        std::uniform_real_distribution<FLOAT> extentDistribution(-4.0f, 4.0f);
+        AxisAlignedBox box =
+        {
+            .Center = XMFLOAT3(centerDistribution(random), centerDistribution(random) * 0.25f, centerDistribution(random)),
+            .Extents = XMFLOAT3(std::exp2(extentDistribution(random)), std::exp2(extentDistribution(random)), std::exp2(extentDistribution(random)))
+        };
+
+        // Some boxes are points
+        if (random() % 16u == 0u)
+        {
+            box.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+
+        return box;
+    }
+
+    const XMFLOAT3 CAMERA_EYES[] = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(10.0f, 30.0f, -20.0f), XMFLOAT3(-50.0f, 5.0f, 40.0f) };
+    const XMFLOAT3 CAMERA_TARGETS[] = { XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(60.0f, 0.0f, 80.0f), XMFLOAT3(-80.0f, 20.0f, -10.0f) };
+}
+
+TEST_CASE(FrustumCullerExtractsPlanes)
+{
+    for (UINT uCameraIdx = 0u; uCameraIdx < ARRAYSIZE(CAMERA_EYES); ++uCameraIdx)
+    {
+        XMMATRIX viewProjection = makeViewProjection(CAMERA_EYES[uCameraIdx], CAMERA_TARGETS[uCameraIdx], XM_PIDIV4 + 0.3f * uCameraIdx, 16.0f / 9.0f);
+        ReferenceFrustum frustum = makeReferenceFrustum(viewProjection);
+
+        // The planes of the matrix are the planes through the corners of the frustum, normalized and pointing in
+        XMFLOAT4 aPlanes[FrustumCuller::NUM_PLANES];
+        FrustumCuller::ExtractPlanes(viewProjection, aPlanes);
+        DOUBLE maxNormalError = 0.0;
+        DOUBLE maxDistanceError = 0.0;
+        for (UINT uPlane = 0u; uPlane < FrustumCuller::NUM_PLANES; ++uPlane)
+        {
+            const DOUBLE* aReference = frustum.aPlanes[uPlane];
+            maxNormalError = std::max({ maxNormalError, std::abs(aPlanes[uPlane].x - aReference[0]), std::abs(aPlanes[uPlane].y - aReference[1]), std::abs(aPlanes[uPlane].z - aReference[2]) });
+            maxDistanceError = std::max(maxDistanceError, std::abs(aPlanes[uPlane].w - aReference[3]) / (1.0 + std::abs(aReference[3])));
+        }
+        CHECK(maxNormalError < 1.0e-3);
+        CHECK(maxDistanceError < 1.0e-3);
+    }
+}
+
+TEST_CASE(FrustumCullerMatchesBruteForce)
+{
+    std::mt19937 random(41u);
+    std::vector<AxisAlignedBox> aBoxes;
+    std::vector<BOOL> aVisible;
+    FrustumCuller culler;
+
+    // Counts that end in every lane of an AVX2 and an SSE register
+    for (UINT uNumBoxes : { 0u, 1u, 3u, 4u, 5u, 8u, 12u, 13u, 1003u, 20000u })
+    {
+        for (UINT uCameraIdx = 0u; uCameraIdx < ARRAYSIZE(CAMERA_EYES); ++uCameraIdx)
+        {
+            XMMATRIX viewProjection = makeViewProjection(CAMERA_EYES[uCameraIdx], CAMERA_TARGETS[uCameraIdx], XM_PIDIV4, 16.0f / 9.0f);
+            ReferenceFrustum frustum = makeReferenceFrustum(viewProjection);
+
+            culler.Clear();
+            aBoxes.clear();
+            for (UINT uBoxIdx = 0u; uBoxIdx < uNumBoxes; ++uBoxIdx)
+            {
+                aBoxes.push_back(makeRandomBox(random, 200.0f));
+                culler.Add(aBoxes.back());
+            }
+            culler.AddUnbounded();
+            culler.Cull(viewProjection, aVisible);
+
+            // Only boxes within rounding of a plane may be classified differently, and no box with a point inside is culled
+            UINT uNumMismatches = 0u;
+            UINT uNumCulledInside = 0u;
+            UINT uNumCulled = 0u;
+            for (UINT uBoxIdx = 0u; uBoxIdx < uNumBoxes; ++uBoxIdx)
+            {
+                const AxisAlignedBox& box = aBoxes[uBoxIdx];
+                DOUBLE margin = getPlaneMargin(frustum, box);
+                DOUBLE tolerance = 1.0e-3 * (1.0 + std::abs(box.Center.x) + std::abs(box.Center.y) + std::abs(box.Center.z));
+                if (std::abs(margin) > tolerance && aVisible[uBoxIdx] != (margin >= 0.0))
+                {
+                    ++uNumMismatches;
+                }
+                if (!aVisible[uBoxIdx] && hasPointInside(frustum, box))
+                {
+                    ++uNumCulledInside;
+                }
+                uNumCulled += aVisible[uBoxIdx] ? 0u : 1u;
+            }
+            CHECK(aVisible.size() == uNumBoxes + 1u);
+            CHECK(aVisible.back());
+            CHECK(uNumMismatches == 0u);
+            CHECK(uNumCulledInside == 0u);
+            CHECK(culler.GetStatistics().uNumTestedBoxes == uNumBoxes + 1u);
+            CHECK(culler.GetStatistics().uNumCulledBoxes == uNumCulled);
+        }
+    }
+}
+
+BENCHMARK(FrustumCullerPerformance)
+{
+    constexpr const UINT NUM_BOXES = 100000u;
+
+    // Boxes spread over a map around the camera, as the renderables of a large scene
+    std::mt19937 random(43u);
+    FrustumCuller culler;
+    for (UINT uBoxIdx = 0u; uBoxIdx < NUM_BOXES; ++uBoxIdx)
+    {
+        culler.Add(makeRandomBox(random, 1000.0f));
+    }
+
+    XMMATRIX viewProjection = makeViewProjection(CAMERA_EYES[1], CAMERA_TARGETS[1], XM_PIDIV4, 16.0f / 9.0f);
+    std::vector<BOOL> aVisible;
+    DOUBLE time = context.MeasureMilliseconds(50u, [&]()
+    {
+        culler.Cull(viewProjection, aVisible);
+    });
+
+    CHAR szName[64];
+    sprintf_s(szName, "%u boxes, %s", NUM_BOXES, IsAvx2Supported() ? "AVX2" : "SSE");
+    context.Report(szName, time, "ms");
+    context.Report("boxes", NUM_BOXES / time / 1000.0, "Mboxes/s");
+    context.Report("culled boxes", 100.0 * culler.GetStatistics().uNumCulledBoxes / NUM_BOXES, "%");
+    context.Report("under the 1 ms budget", time < 1.0 ? 1.0 : 0.0, "");
+}
@@ -0,0 +1,164 @@
+#include "Harness/TestRegistry.h"
+
+#include <set>
+
+#include "Renderer/GeometryRegistry.h"
+#include "Scene/Voxel.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const UINT NUM_CUBES = 64u;
+
+    // WARP creates real buffers without a GPU
+    HRESULT createDevice(_Out_ ComPtr<ID3D11Device>& outDevice)
+    {
+        return D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0u, nullptr, 0u, D3D11_SDK_VERSION, outDevice.GetAddressOf(), nullptr, nullptr);
+    }
+
+    // Every geometry collides with every other one
+    UINT64 getCollidingHash(_In_reads_(uNumVertices) const SimpleVertex*, _In_ UINT uNumVertices, _In_reads_(uNumIndices) const WORD*, _In_ UINT uNumIndices)
+    {
+        UNREFERENCED_PARAMETER(uNumVertices);
+        UNREFERENCED_PARAMETER(uNumIndices);
+        return 0ull;
+    }
+
+    // Cubes of one block each, of a few block types, so they differ in color but not in geometry. Stops at the first that fails
+    std::vector<std::shared_ptr<Voxel>> createCubes(_In_ ID3D11Device* pDevice, _In_opt_ GeometryRegistry* pGeometryRegistry, _In_ UINT uNumCubes)
+    {
+        std::vector<std::shared_ptr<Voxel>> aCubes;
+        for (UINT uCubeIdx = 0u; uCubeIdx < uNumCubes; ++uCubeIdx)
+        {
+            VoxelInstanceData instance = {};
+            instance.X = static_cast<INT16>(uCubeIdx);
+            instance.BlockType = static_cast<BYTE>(1u + uCubeIdx % 3u);
+            std::shared_ptr<Voxel> cube = std::make_shared<Voxel>(std::vector<VoxelInstanceData>{ instance }, XMFLOAT4(0.25f * static_cast<FLOAT>(uCubeIdx % 4u), 1.0f, 1.0f, 1.0f));
+            if (FAILED(cube->Initialize(pDevice, nullptr, pGeometryRegistry)))
+            {
+                break;
+            }
+            aCubes.push_back(cube);
+        }
+
+        return aCubes;
+    }
+
+    std::set<ID3D11Buffer*> getVertexBuffers(_In_ const std::vector<std::shared_ptr<Voxel>>& aCubes)
+    {
+        std::set<ID3D11Buffer*> vertexBuffers;
+        for (const std::shared_ptr<Voxel>& cube : aCubes)
+        {
+            vertexBuffers.insert(cube->GetVertexBuffer().Get());
+        }
+
+        return vertexBuffers;
+    }
+}
+
+TEST_CASE(GeometryRegistrySharesBuffersOfIdenticalCubes)
+{
+    ComPtr<ID3D11Device> device;
+    if (!CHECK_HR(createDevice(device)))
+    {
+        return;
+    }
+
+    // The first cube registers the geometry, the counters stop growing with it
+    GeometryRegistry registry;
+    std::vector<std::shared_ptr<Voxel>> aCubes = createCubes(device.Get(), &registry, 1u);
+    if (!CHECK(aCubes.size() == 1u))
+    {
+        return;
+    }
+    const GeometryRegistry::Statistics firstStatistics = registry.GetStatistics();
+    CHECK(firstStatistics.uNumGeometries == 1u);
+    CHECK(firstStatistics.uNumSharedFinds == 0u);
+    CHECK(firstStatistics.uNumBufferBytes > 0u);
+
+    std::vector<std::shared_ptr<Voxel>> aMoreCubes = createCubes(device.Get(), &registry, NUM_CUBES - 1u);
+    aCubes.insert(aCubes.end(), aMoreCubes.begin(), aMoreCubes.end());
+    if (!CHECK(aCubes.size() == NUM_CUBES))
+    {
+        return;
+    }
+    CHECK(registry.GetStatistics().uNumGeometries == 1u);
+    CHECK(registry.GetStatistics().uNumSharedFinds == NUM_CUBES - 1u);
+    CHECK(registry.GetStatistics().uNumBufferBytes == firstStatistics.uNumBufferBytes);
+
+    // Every cube draws the buffers of the first one, its instances stay its own
+    std::set<ID3D11Buffer*> instanceBuffers;
+    for (const std::shared_ptr<Voxel>& cube : aCubes)
+    {
+        CHECK(cube->GetVertexBuffer().Get() == aCubes[0]->GetVertexBuffer().Get());
+        CHECK(cube->GetNormalBuffer().Get() == aCubes[0]->GetNormalBuffer().Get());
+        CHECK(cube->GetIndexBuffer().Get() == aCubes[0]->GetIndexBuffer().Get());
+        instanceBuffers.insert(cube->GetInstanceBuffer().Get());
+    }
+    CHECK(aCubes[0]->GetVertexBuffer());
+    CHECK(instanceBuffers.size() == NUM_CUBES);
+
+    // Without a registry every cube creates its own buffers
+    std::vector<std::shared_ptr<Voxel>> aUnsharedCubes = createCubes(device.Get(), nullptr, NUM_CUBES);
+    CHECK(aUnsharedCubes.size() == NUM_CUBES);
+    CHECK(getVertexBuffers(aUnsharedCubes).size() == NUM_CUBES);
+    CHECK(registry.GetStatistics().uNumGeometries == 1u);
+
+    registry.Clear();
+    CHECK(registry.GetStatistics().uNumGeometries == 0u);
+    CHECK(registry.GetStatistics().uNumBufferBytes == 0u);
+    CHECK(getVertexBuffers(createCubes(device.Get(), &registry, 2u)).size() == 1u);
+    CHECK(registry.GetStatistics().uNumBufferBytes == firstStatistics.uNumBufferBytes);
+    CHECK(aCubes[0]->GetVertexBuffer());
+}
+
+TEST_CASE(GeometryRegistrySeparatesCollidingGeometries)
+{
+    ComPtr<ID3D11Device> device;
+    if (!CHECK_HR(createDevice(device)))
+    {
+        return;
+    }
+
+    // A quad, the same quad with one vertex moved, and its first triangle, all under one hash
+    SimpleVertex aQuadVertices[4] =
+    {
+        { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+        { XMFLOAT3(-1.0f,  1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+        { XMFLOAT3( 1.0f,  1.0f, 0.0f), XMFLOAT2(1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+        { XMFLOAT3( 1.0f, -1.0f, 0.0f), XMFLOAT2(1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+    };
+    SimpleVertex aMovedVertices[4] = { aQuadVertices[0], aQuadVertices[1], aQuadVertices[2], aQuadVertices[3] };
+    aMovedVertices[2].Position.x = 2.0f;
+    const WORD aIndices[6] = { 0u, 1u, 2u, 0u, 2u, 3u };
+    const NormalData aNormalData[4] = {};
+
+    GeometryRegistry registry(getCollidingHash);
+    GeometryRegistry::Geometry quad;
+    GeometryRegistry::Geometry found;
+    if (!CHECK_HR(registry.Add(device.Get(), aQuadVertices, 4u, aIndices, 6u, aNormalData, quad)))
+    {
+        return;
+    }
+    CHECK(!registry.Find(aMovedVertices, 4u, aIndices, 6u, found));
+    CHECK(!found.VertexBuffer);
+    CHECK(!registry.Find(aQuadVertices, 3u, aIndices, 3u, found));
+
+    GeometryRegistry::Geometry moved;
+    if (!CHECK_HR(registry.Add(device.Get(), aMovedVertices, 4u, aIndices, 6u, aNormalData, moved)))
+    {
+        return;
+    }
+    CHECK(registry.GetStatistics().uNumGeometries == 2u);
+    CHECK(moved.VertexBuffer.Get() != quad.VertexBuffer.Get());
+
+    // Each geometry finds its own buffers behind the shared hash
+    CHECK(registry.Find(aQuadVertices, 4u, aIndices, 6u, found));
+    CHECK(found.VertexBuffer.Get() == quad.VertexBuffer.Get());
+    CHECK(found.IndexBuffer.Get() == quad.IndexBuffer.Get());
+    CHECK(registry.Find(aMovedVertices, 4u, aIndices, 6u, found));
+    CHECK(found.VertexBuffer.Get() == moved.VertexBuffer.Get());
+    CHECK(found.NormalBuffer.Get() == moved.NormalBuffer.Get());
+    CHECK(registry.GetStatistics().uNumSharedFinds == 2u);
+}
@@ -0,0 +1,339 @@
+#include "Harness/TestRegistry.h"
+
+#include <map>
+
+#include "Harness/HeadlessRenderer.h"
+#include "Renderer/RecordingGraphicsContext.h"
+#include "Renderer/StateCacheGraphicsContext.h"
+#include "Thread/ThreadPool.h"
+
+using namespace library;
+using namespace tests;
+
+namespace
+{
+    constexpr const UINT NUM_RENDERABLES = 24u;
+    // Enough draw items for three command lists
+    constexpr const UINT NUM_DEFERRED_RENDERABLES = 200u;
+    constexpr const UINT NUM_DEFERRED_CONTEXTS = 3u;
+    // Enough draw items for a command list on every thread of the pool
+    constexpr const UINT NUM_PARALLEL_RENDERABLES = 320u;
+    constexpr const UINT NUM_RECORDING_THREADS = 4u;
+
+    // Cubes of their own buffers in rows in front of the camera, none of them culled
+    std::vector<std::shared_ptr<TestRenderable>> addCubeRows(_In_ Scene& scene, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ UINT uNumRenderables)
+    {
+        std::vector<std::shared_ptr<TestRenderable>> aRenderables;
+        for (UINT uRenderableIdx = 0u; uRenderableIdx < uNumRenderables; ++uRenderableIdx)
+        {
+            XMFLOAT3 position(
+                -4.5f + static_cast<FLOAT>(uRenderableIdx % 10u),
+                -1.0f + static_cast<FLOAT>(uRenderableIdx / 10u % 5u),
+                10.0f + 3.0f * static_cast<FLOAT>(uRenderableIdx / 50u)
+            );
+            aRenderables.push_back(AddTestRenderable(scene, context, eTestGeometry::CUBE, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), position));
+        }
+
+        return aRenderables;
+    }
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   BoundState
+
+      Summary:  Object and value bound to a slot while a stream is
+                replayed
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct BoundState
+    {
+        const void* pObject;
+        UINT uValue;
+
+        bool operator==(const BoundState& other) const = default;
+    };
+
+    // Binds of a stream that set every slot they bind to what it already held, over the state a state cache shadows
+    UINT countRedundantBinds(_In_ const RecordingGraphicsContext& recording)
+    {
+        const std::vector<GraphicsCommand>& aCommands = recording.GetCommands();
+        const std::vector<const void*>& aObjects = recording.GetObjects();
+
+        // The commands of an executed command list come right before its EXECUTE_COMMAND_LIST, and start from no state
+        std::vector<BOOL> aStartsCommandList(aCommands.size(), FALSE);
+        for (size_t uCommandIdx = 0u; uCommandIdx < aCommands.size(); ++uCommandIdx)
+        {
+            if (aCommands[uCommandIdx].Command == eGraphicsCommand::EXECUTE_COMMAND_LIST)
+            {
+                aStartsCommandList[uCommandIdx - aCommands[uCommandIdx].uValue] = TRUE;
+            }
+        }
+
+        std::map<std::pair<eGraphicsCommand, UINT>, BoundState> boundStates;
+        UINT uNumRedundantBinds = 0u;
+        for (size_t uCommandIdx = 0u; uCommandIdx < aCommands.size(); ++uCommandIdx)
+        {
+            const GraphicsCommand& command = aCommands[uCommandIdx];
+            if (aStartsCommandList[uCommandIdx])
+            {
+                boundStates.clear();
+            }
+
+            switch (command.Command)
+            {
+            case eGraphicsCommand::IA_SET_PRIMITIVE_TOPOLOGY:
+            case eGraphicsCommand::IA_SET_INDEX_BUFFER:
+            case eGraphicsCommand::IA_SET_INPUT_LAYOUT:
+            case eGraphicsCommand::IA_SET_VERTEX_BUFFERS:
+            case eGraphicsCommand::PS_SET_CONSTANT_BUFFERS:
+            case eGraphicsCommand::PS_SET_SAMPLERS:
+            case eGraphicsCommand::PS_SET_SHADER:
+            case eGraphicsCommand::PS_SET_SHADER_RESOURCES:
+            case eGraphicsCommand::VS_SET_CONSTANT_BUFFERS:
+            case eGraphicsCommand::VS_SET_SHADER:
+            {
+                BOOL bRedundant = TRUE;
+                UINT uNumSlots = command.uNumObjects > 0u ? command.uNumObjects : 1u;
+                for (UINT uSlotIdx = 0u; uSlotIdx < uNumSlots; ++uSlotIdx)
+                {
+                    BoundState state = { command.uNumObjects > 0u ? aObjects[command.uFirstObject + uSlotIdx] : nullptr, command.uValue };
+                    auto [it, bInserted] = boundStates.try_emplace(std::make_pair(command.Command, command.uStartSlot + uSlotIdx), state);
+                    if (bInserted || !(it->second == state))
+                    {
+                        it->second = state;
+                        bRedundant = FALSE;
+                    }
+                }
+                uNumRedundantBinds += bRedundant ? 1u : 0u;
+                break;
+            }
+            case eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1:
+            case eGraphicsCommand::VS_SET_CONSTANT_BUFFERS1:
+            {
+                // Ranged binds are never dropped, they only replace the slots they bind
+                eGraphicsCommand bind = command.Command == eGraphicsCommand::PS_SET_CONSTANT_BUFFERS1 ? eGraphicsCommand::PS_SET_CONSTANT_BUFFERS : eGraphicsCommand::VS_SET_CONSTANT_BUFFERS;
+                for (UINT uSlotIdx = 0u; uSlotIdx < command.uNumObjects; ++uSlotIdx)
+                {
+                    boundStates.erase(std::make_pair(bind, command.uStartSlot + uSlotIdx));
+                }
+                break;
+            }
+            case eGraphicsCommand::OM_SET_RENDER_TARGETS:
+                std::erase_if(boundStates, [](const auto& boundState) { return boundState.first.first == eGraphicsCommand::PS_SET_SHADER_RESOURCES; });
+                break;
+            case eGraphicsCommand::EXECUTE_COMMAND_LIST:
+                boundStates.clear();
+                break;
+            default:
+                break;
+            }
+        }
+
+        return uNumRedundantBinds;
+    }
+
+    UINT countStateChanges(_In_ const RecordingGraphicsContext& recording)
+    {
+        UINT uNumStateChanges = 0u;
+        for (const GraphicsCommand& command : recording.GetCommands())
+        {
+            uNumStateChanges += RecordingGraphicsContext::IsStateChange(command.Command) ? 1u : 0u;
+        }
+
+        return uNumStateChanges;
+    }
+}
+
+
+TEST_CASE(RecordingGraphicsContextRecordsFrame)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    addCubeRows(*scene, recording, NUM_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)))
+    {
+        return;
+    }
+
+    // Initialize only creates buffers and uploads the projection
+    CHECK(recording->GetCounters().uNumUpdates == 1u);
+    CHECK(recording->GetCounters().uNumUpdatedBytes == sizeof(CBChangeOnResize));
+    recording->Reset();
+
+    renderer.Render();
+    CHECK(renderer.Present() == S_FALSE);
+
+    // Every cube is one draw of its whole index buffer, after the camera and light constants and the first upload of its own
+    const RecordingGraphicsContext::Counters& counters = recording->GetCounters();
+    const Renderer::DrawStatistics& statistics = renderer.GetDrawStatistics();
+    const UINT64 uNumFrameBytes = sizeof(CBChangeOnCameraMovement) + sizeof(CBLights);
+    CHECK(counters.uNumDrawCalls == NUM_RENDERABLES);
+    CHECK(counters.aNumCalls[static_cast<size_t>(eGraphicsCommand::DRAW_INDEXED)] == NUM_RENDERABLES);
+    CHECK(counters.uNumIndices == NUM_RENDERABLES * 36u);
+    CHECK(counters.uNumInstances == NUM_RENDERABLES);
+    CHECK(counters.uNumUpdates == 2u + NUM_RENDERABLES);
+    CHECK(counters.uNumUpdatedBytes == uNumFrameBytes + NUM_RENDERABLES * sizeof(CBChangesEveryFrame));
+    CHECK(counters.aNumCalls[static_cast<size_t>(eGraphicsCommand::MAP_BUFFER)] == 0u);
+    CHECK(statistics.uNumUploadedBytes == counters.uNumUpdatedBytes);
+    CHECK(statistics.uNumMeshDrawCalls == NUM_RENDERABLES);
+    CHECK(statistics.uNumVoxelDrawCalls == 0u);
+    CHECK(statistics.uNumCulledRenderables == 0u);
+    CHECK(statistics.uNumCulledMeshDraws == 0u);
+
+    // The targets, the shared binds of the empty voxel pass and four buffer binds per cube, the shaders are never
+    // compiled and stay unbound. The shared binds of the mesh pass repeat the voxel pass and are dropped.
+    CHECK(statistics.uNumVoxelStateChanges == 5u);
+    CHECK(statistics.uNumMeshStateChanges == 5u + 4u * NUM_RENDERABLES);
+    CHECK(statistics.uNumSkippedBinds == 5u);
+    CHECK(statistics.uNumIssuedBinds == 2u + 5u + 4u * NUM_RENDERABLES);
+    CHECK(counters.uNumStateChanges == statistics.uNumIssuedBinds);
+    CHECK(counters.uNumStateChanges == countStateChanges(*recording));
+    CHECK(countRedundantBinds(*recording) == 0u);
+
+    recording->Reset();
+    CHECK(recording->GetCommands().empty() && recording->GetObjects().empty() && recording->GetCounters().uNumDrawCalls == 0u);
+}
+
+TEST_CASE(StateCacheDropsRedundantBindsOfFrame)
+{
+    std::shared_ptr<RecordingGraphicsContext> reference = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    std::vector<std::shared_ptr<TestRenderable>> aRenderables = addCubeRows(*scene, reference, NUM_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, reference, scene)))
+    {
+        return;
+    }
+    reference->Reset();
+    renderer.Render();
+
+    // The stand-in buffers of the first context stay valid, the next frames go to a second one
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    renderer.SetGraphicsContext(recording);
+    for (UINT uFrameIdx = 0u; uFrameIdx < 3u; ++uFrameIdx)
+    {
+        recording->Reset();
+        renderer.Render();
+
+        // The same draws with the same state, without a single redundant bind, and only the camera and lights
+        // uploaded since nothing moved
+        const Renderer::DrawStatistics& statistics = renderer.GetDrawStatistics();
+        CHECK(recording->HasSameDraws(*reference));
+        CHECK(reference->HasSameDraws(*recording));
+        CHECK(countRedundantBinds(*recording) == 0u);
+        CHECK(statistics.uNumSkippedBinds == 5u);
+        CHECK(recording->GetCounters().uNumStateChanges == statistics.uNumIssuedBinds);
+        CHECK(recording->GetCounters().uNumStateChanges == reference->GetCounters().uNumStateChanges);
+        CHECK(recording->GetCounters().uNumUpdates == 2u);
+        CHECK(statistics.uNumUploadedBytes == sizeof(CBChangeOnCameraMovement) + sizeof(CBLights));
+    }
+
+    // A frame that draws something else is not taken for the reference
+    aRenderables[0]->Translate(XMVectorSet(0.0f, 0.0f, 20.0f, 0.0f));
+    recording->Reset();
+    renderer.Render();
+    CHECK(!recording->HasSameDraws(*reference));
+    CHECK(recording->GetCounters().uNumDrawCalls == NUM_RENDERABLES);
+    CHECK(recording->GetCounters().uNumUpdates == 3u);
+}
+
+TEST_CASE(RecordingGraphicsContextExecutesDeferredFrame)
+{
+    std::shared_ptr<RecordingGraphicsContext> reference = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    addCubeRows(*scene, reference, NUM_DEFERRED_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, reference, scene)))
+    {
+        return;
+    }
+    reference->Reset();
+    renderer.Render();
+    CHECK(reference->GetCounters().aNumCalls[static_cast<size_t>(eGraphicsCommand::EXECUTE_COMMAND_LIST)] == 0u);
+
+    // The mesh pass split over deferred contexts with their own caches
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    renderer.SetGraphicsContext(recording);
+    renderer.SetRecordingThreadPool(std::make_shared<ThreadPool>(NUM_DEFERRED_CONTEXTS), NUM_DEFERRED_CONTEXTS);
+    renderer.Render();
+
+    // The command lists run the draws of the frame in order, and are counted on the immediate stream
+    const RecordingGraphicsContext::Counters& counters = recording->GetCounters();
+    const Renderer::DrawStatistics& statistics = renderer.GetDrawStatistics();
+    CHECK(recording->HasSameDraws(*reference));
+    CHECK(counters.uNumDrawCalls == NUM_DEFERRED_RENDERABLES);
+    CHECK(counters.uNumIndices == reference->GetCounters().uNumIndices);
+    CHECK(counters.aNumCalls[static_cast<size_t>(eGraphicsCommand::EXECUTE_COMMAND_LIST)] == NUM_DEFERRED_CONTEXTS);
+    CHECK(statistics.uNumCommandLists == NUM_DEFERRED_CONTEXTS);
+    CHECK(statistics.uNumMeshDrawCalls == NUM_DEFERRED_RENDERABLES);
+    CHECK(countRedundantBinds(*recording) == 0u);
+
+    // Every deferred context binds the shared buffers of the mesh pass again
+    CHECK(statistics.uNumMeshStateChanges == 5u * NUM_DEFERRED_CONTEXTS + 4u * NUM_DEFERRED_RENDERABLES);
+}
+
+TEST_CASE(ParallelRecordingDrawsSameAsSerialFrame)
+{
+    std::shared_ptr<RecordingGraphicsContext> reference = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    addCubeRows(*scene, reference, NUM_PARALLEL_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, reference, scene)))
+    {
+        return;
+    }
+    reference->Reset();
+    renderer.Render();
+
+    // Every thread of the pool records a command list, every frame on the same deferred contexts
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    renderer.SetGraphicsContext(recording);
+    renderer.SetRecordingThreadPool(std::make_shared<ThreadPool>(NUM_RECORDING_THREADS), NUM_RECORDING_THREADS);
+    for (UINT uFrameIdx = 0u; uFrameIdx < 3u; ++uFrameIdx)
+    {
+        recording->Reset();
+        renderer.Render();
+
+        const RecordingGraphicsContext::Counters& counters = recording->GetCounters();
+        CHECK(recording->HasSameDraws(*reference));
+        CHECK(reference->HasSameDraws(*recording));
+        CHECK(counters.uNumDrawCalls == NUM_PARALLEL_RENDERABLES);
+        CHECK(counters.aNumCalls[static_cast<size_t>(eGraphicsCommand::EXECUTE_COMMAND_LIST)] == NUM_RECORDING_THREADS);
+        CHECK(renderer.GetDrawStatistics().uNumCommandLists == NUM_RECORDING_THREADS);
+        CHECK(renderer.GetDrawStatistics().uNumMeshDrawCalls == NUM_PARALLEL_RENDERABLES);
+        CHECK(countRedundantBinds(*recording) == 0u);
+    }
+}
+
+TEST_CASE(FailedCommandListIsRecordedOnImmediateContext)
+{
+    std::shared_ptr<RecordingGraphicsContext> reference = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene();
+    addCubeRows(*scene, reference, NUM_PARALLEL_RENDERABLES);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, reference, scene)))
+    {
+        return;
+    }
+    reference->Reset();
+    renderer.Render();
+
+    // The second range cannot be finished, its items are recorded on the immediate context between the lists
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    recording->FailFinishCommandList(1u, E_OUTOFMEMORY);
+    renderer.SetGraphicsContext(recording);
+    renderer.SetRecordingThreadPool(std::make_shared<ThreadPool>(NUM_RECORDING_THREADS), NUM_RECORDING_THREADS);
+    for (UINT uFrameIdx = 0u; uFrameIdx < 2u; ++uFrameIdx)
+    {
+        recording->Reset();
+        renderer.Render();
+
+        const RecordingGraphicsContext::Counters& counters = recording->GetCounters();
+        CHECK(recording->HasSameDraws(*reference));
+        CHECK(reference->HasSameDraws(*recording));
+        CHECK(counters.uNumDrawCalls == NUM_PARALLEL_RENDERABLES);
+        CHECK(counters.aNumCalls[static_cast<size_t>(eGraphicsCommand::EXECUTE_COMMAND_LIST)] == NUM_RECORDING_THREADS - 1u);
+        CHECK(renderer.GetDrawStatistics().uNumCommandLists == NUM_RECORDING_THREADS - 1u);
+        CHECK(renderer.GetDrawStatistics().uNumMeshDrawCalls == NUM_PARALLEL_RENDERABLES);
+        CHECK(countRedundantBinds(*recording) == 0u);
+    }
+}
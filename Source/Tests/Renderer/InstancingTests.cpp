@@ -0,0 +1,256 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+
+#include "Harness/HeadlessRenderer.h"
+#include "Renderer/RecordingGraphicsContext.h"
+#include "Texture/Material.h"
+
+using namespace library;
+using namespace tests;
+
+namespace
+{
+    constexpr const UINT NUM_RENDERABLES = 24u;
+    // Bytes of the instance stream of the renderer, see Renderer::MAX_STREAM_INSTANCES
+    constexpr const UINT MAX_STREAM_INSTANCES = 1u << 14u;
+    constexpr const UINT INSTANCE_STREAM_SIZE = MAX_STREAM_INSTANCES * sizeof(InstanceData);
+    // Cubes of a color in the overflow test, the second color does not fit into the stream after the first
+    constexpr const UINT NUM_OVERFLOW_RENDERABLES = 10000u;
+
+    constexpr const XMFLOAT4 WHITE = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    constexpr const XMFLOAT4 RED = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
+    constexpr const XMFLOAT4 GREEN = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+
+    // Renderables in a grid in front of the camera, none of them culled
+    std::vector<std::shared_ptr<TestRenderable>> addRenderables(_In_ Scene& scene, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ eTestGeometry geometry, _In_ const XMFLOAT4& color, _In_ UINT uNumRenderables, _In_ FLOAT depth)
+    {
+        std::vector<std::shared_ptr<TestRenderable>> aRenderables;
+        for (UINT uRenderableIdx = 0u; uRenderableIdx < uNumRenderables; ++uRenderableIdx)
+        {
+            XMFLOAT3 position(-4.5f + static_cast<FLOAT>(uRenderableIdx % 10u), -1.0f + static_cast<FLOAT>(uRenderableIdx / 10u % 3u), depth);
+            aRenderables.push_back(AddTestRenderable(scene, context, geometry, color, position));
+        }
+
+        return aRenderables;
+    }
+
+    // Cubes drawn as one mesh of a material, like the meshes of a model
+    std::vector<std::shared_ptr<TestRenderable>> addMaterialCubes(_In_ Scene& scene, _In_ const std::shared_ptr<GraphicsContext>& context, _In_ const std::shared_ptr<Material>& material, _In_ UINT uNumRenderables, _In_ FLOAT depth)
+    {
+        std::vector<std::shared_ptr<TestRenderable>> aRenderables;
+        for (UINT uRenderableIdx = 0u; uRenderableIdx < uNumRenderables; ++uRenderableIdx)
+        {
+            XMFLOAT3 position(-4.5f + static_cast<FLOAT>(uRenderableIdx), 0.0f, depth);
+            aRenderables.push_back(AddTestRenderable(scene, context, eTestGeometry::CUBE, WHITE, position));
+            aRenderables.back()->SetMaterial(material);
+        }
+
+        return aRenderables;
+    }
+
+    std::vector<GraphicsCommand> findCommands(_In_ const RecordingGraphicsContext& recording, _In_ eGraphicsCommand command)
+    {
+        std::vector<GraphicsCommand> aFoundCommands;
+        for (const GraphicsCommand& recordedCommand : recording.GetCommands())
+        {
+            if (recordedCommand.Command == command)
+            {
+                aFoundCommands.push_back(recordedCommand);
+            }
+        }
+
+        return aFoundCommands;
+    }
+
+    UINT countCalls(_In_ const RecordingGraphicsContext& recording, _In_ eGraphicsCommand command)
+    {
+        return recording.GetCounters().aNumCalls[static_cast<size_t>(command)];
+    }
+
+    // Instance counts of the instanced draws, smallest first
+    std::vector<UINT> getInstanceCounts(_In_ const RecordingGraphicsContext& recording)
+    {
+        std::vector<UINT> aInstanceCounts;
+        for (const GraphicsCommand& draw : findCommands(recording, eGraphicsCommand::DRAW_INDEXED_INSTANCED))
+        {
+            aInstanceCounts.push_back(draw.uNumInstances);
+        }
+        std::sort(aInstanceCounts.begin(), aInstanceCounts.end());
+
+        return aInstanceCounts;
+    }
+
+    // The instance stream is the buffer the renderer maps with room for all instances
+    const void* findInstanceStream(_In_ const RecordingGraphicsContext& recording)
+    {
+        for (const GraphicsCommand& map : findCommands(recording, eGraphicsCommand::MAP_BUFFER))
+        {
+            if (map.uValue == INSTANCE_STREAM_SIZE && map.MapType == D3D11_MAP_WRITE_DISCARD)
+            {
+                return recording.GetObjects()[map.uFirstObject];
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Number of instances of the stream whose matrix is the world matrix of the renderable
+    UINT countInstances(_In_ const InstanceData* aInstances, _In_ UINT uNumInstances, _In_ const Renderable& renderable)
+    {
+        XMMATRIX world = renderable.GetWorldMatrix();
+        UINT uNumFound = 0u;
+        for (UINT uInstanceIdx = 0u; uInstanceIdx < uNumInstances; ++uInstanceIdx)
+        {
+            uNumFound += memcmp(&aInstances[uInstanceIdx].Transformation, &world, sizeof(XMMATRIX)) == 0 ? 1u : 0u;
+        }
+
+        return uNumFound;
+    }
+}
+
+TEST_CASE(InstancingMergesCubesOfSameGeometry)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene(TRUE);
+    std::vector<std::shared_ptr<TestRenderable>> aRenderables = addRenderables(*scene, recording, eTestGeometry::CUBE, WHITE, NUM_RENDERABLES, 10.0f);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)))
+    {
+        return;
+    }
+
+    // All cubes are one draw with an instance each
+    recording->Reset();
+    renderer.Render();
+    CHECK(countCalls(*recording, eGraphicsCommand::DRAW_INDEXED) == 0u);
+    CHECK(getInstanceCounts(*recording) == std::vector<UINT>({ NUM_RENDERABLES }));
+    CHECK(findCommands(*recording, eGraphicsCommand::DRAW_INDEXED_INSTANCED)[0].uValue == aRenderables[0]->GetNumIndices());
+    CHECK(renderer.GetDrawStatistics().uNumMeshDrawCalls == 1u);
+    CHECK(renderer.GetDrawStatistics().uNumMeshInstances == NUM_RENDERABLES);
+
+    // The instanced draw reads the stream from the third vertex slot
+    const void* pInstanceStream = findInstanceStream(*recording);
+    if (!CHECK(pInstanceStream))
+    {
+        return;
+    }
+    UINT uNumStreamBinds = 0u;
+    for (const GraphicsCommand& bind : findCommands(*recording, eGraphicsCommand::IA_SET_VERTEX_BUFFERS))
+    {
+        if (bind.uStartSlot == 0u && bind.uNumObjects == 3u && recording->GetObjects()[bind.uFirstObject + 2u] == pInstanceStream)
+        {
+            ++uNumStreamBinds;
+        }
+    }
+    CHECK(uNumStreamBinds == 1u);
+
+    // Every cube wrote its world matrix into the stream once
+    const InstanceData* aInstances = reinterpret_cast<const InstanceData*>(recording->GetMappedMemory(static_cast<const ID3D11Buffer*>(pInstanceStream)));
+    if (!CHECK(aInstances))
+    {
+        return;
+    }
+    for (const std::shared_ptr<TestRenderable>& renderable : aRenderables)
+    {
+        CHECK(countInstances(aInstances, NUM_RENDERABLES, *renderable) == 1u);
+    }
+
+    // A cube that moves writes its new matrix the next frame
+    aRenderables[7]->Translate(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+    recording->Reset();
+    renderer.Render();
+    CHECK(getInstanceCounts(*recording) == std::vector<UINT>({ NUM_RENDERABLES }));
+    aInstances = reinterpret_cast<const InstanceData*>(recording->GetMappedMemory(static_cast<const ID3D11Buffer*>(pInstanceStream)));
+    CHECK(findInstanceStream(*recording) == pInstanceStream);
+    CHECK(aInstances && countInstances(aInstances, NUM_RENDERABLES, *aRenderables[7]) == 1u);
+}
+
+TEST_CASE(InstancingSplitsOnColorAndMaterial)
+{
+    constexpr const UINT NUM_WHITE_CUBES = 12u;
+    constexpr const UINT NUM_RED_CUBES = 8u;
+    constexpr const UINT NUM_QUADS = 6u;
+    constexpr const UINT NUM_MATERIAL_CUBES = 5u;
+
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene(TRUE);
+    addRenderables(*scene, recording, eTestGeometry::CUBE, WHITE, NUM_WHITE_CUBES, 10.0f);
+    addRenderables(*scene, recording, eTestGeometry::CUBE, RED, NUM_RED_CUBES, 12.0f);
+    addRenderables(*scene, recording, eTestGeometry::QUAD, WHITE, NUM_QUADS, 14.0f);
+    addRenderables(*scene, recording, eTestGeometry::CUBE, GREEN, 1u, 16.0f);
+    std::shared_ptr<Material> stone = std::make_shared<Material>(L"Stone");
+    std::shared_ptr<Material> wood = std::make_shared<Material>(L"Wood");
+    addMaterialCubes(*scene, recording, stone, NUM_MATERIAL_CUBES, 18.0f);
+    addMaterialCubes(*scene, recording, wood, NUM_MATERIAL_CUBES, 20.0f);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)))
+    {
+        return;
+    }
+
+    // Another color, geometry or material is a draw of its own, the only green cube a plain draw
+    recording->Reset();
+    renderer.Render();
+    CHECK(getInstanceCounts(*recording) == std::vector<UINT>({ NUM_MATERIAL_CUBES, NUM_MATERIAL_CUBES, NUM_QUADS, NUM_RED_CUBES, NUM_WHITE_CUBES }));
+    CHECK(countCalls(*recording, eGraphicsCommand::DRAW_INDEXED) == 1u);
+    CHECK(renderer.GetDrawStatistics().uNumMeshDrawCalls == 6u);
+    CHECK(renderer.GetDrawStatistics().uNumMeshInstances == NUM_WHITE_CUBES + NUM_RED_CUBES + NUM_QUADS + 2u * NUM_MATERIAL_CUBES);
+
+    // The draws are packed one after the other into the stream
+    const void* pInstanceStream = findInstanceStream(*recording);
+    CHECK(countCalls(*recording, eGraphicsCommand::MAP_BUFFER) == 1u);
+    if (!CHECK(pInstanceStream))
+    {
+        return;
+    }
+    const InstanceData* aInstances = reinterpret_cast<const InstanceData*>(recording->GetMappedMemory(static_cast<const ID3D11Buffer*>(pInstanceStream)));
+    UINT uNumWritten = NUM_WHITE_CUBES + NUM_RED_CUBES + NUM_QUADS + 2u * NUM_MATERIAL_CUBES;
+    for (const auto& [name, renderable] : scene->GetRenderables())
+    {
+        BOOL bPlain = XMVector4Equal(XMLoadFloat4(&renderable->GetOutputColor()), XMLoadFloat4(&GREEN));
+        CHECK(aInstances && countInstances(aInstances, uNumWritten, *renderable) == (bPlain ? 0u : 1u));
+    }
+}
+
+TEST_CASE(InstancingFallsBackPastStreamCapacity)
+{
+    std::shared_ptr<RecordingGraphicsContext> recording = std::make_shared<RecordingGraphicsContext>();
+    std::shared_ptr<Scene> scene = CreateHeadlessScene(TRUE);
+    std::vector<std::shared_ptr<TestRenderable>> aWhiteCubes = addRenderables(*scene, recording, eTestGeometry::CUBE, WHITE, NUM_OVERFLOW_RENDERABLES, 10.0f);
+    std::vector<std::shared_ptr<TestRenderable>> aRedCubes = addRenderables(*scene, recording, eTestGeometry::CUBE, RED, NUM_OVERFLOW_RENDERABLES, 12.0f);
+    Renderer renderer;
+    if (!CHECK_HR(InitializeHeadlessRenderer(renderer, recording, scene)))
+    {
+        return;
+    }
+    static_assert(2u * NUM_OVERFLOW_RENDERABLES > MAX_STREAM_INSTANCES && NUM_OVERFLOW_RENDERABLES <= MAX_STREAM_INSTANCES);
+
+    // One color fills the stream, the cubes of the other are drawn one by one
+    recording->Reset();
+    renderer.Render();
+    CHECK(getInstanceCounts(*recording) == std::vector<UINT>({ NUM_OVERFLOW_RENDERABLES }));
+    CHECK(countCalls(*recording, eGraphicsCommand::DRAW_INDEXED) == NUM_OVERFLOW_RENDERABLES);
+    CHECK(renderer.GetDrawStatistics().uNumMeshDrawCalls == NUM_OVERFLOW_RENDERABLES + 1u);
+    CHECK(renderer.GetDrawStatistics().uNumMeshInstances == NUM_OVERFLOW_RENDERABLES);
+
+    // The instanced cubes are all of one color, the stream holds their matrices and no others
+    const void* pInstanceStream = findInstanceStream(*recording);
+    if (!CHECK(pInstanceStream))
+    {
+        return;
+    }
+    const InstanceData* aInstances = reinterpret_cast<const InstanceData*>(recording->GetMappedMemory(static_cast<const ID3D11Buffer*>(pInstanceStream)));
+    if (!CHECK(aInstances))
+    {
+        return;
+    }
+    UINT uNumWhiteInstances = 0u;
+    UINT uNumRedInstances = 0u;
+    for (UINT uRenderableIdx = 0u; uRenderableIdx < NUM_OVERFLOW_RENDERABLES; uRenderableIdx += 97u)
+    {
+        uNumWhiteInstances += countInstances(aInstances, NUM_OVERFLOW_RENDERABLES, *aWhiteCubes[uRenderableIdx]);
+        uNumRedInstances += countInstances(aInstances, NUM_OVERFLOW_RENDERABLES, *aRedCubes[uRenderableIdx]);
+    }
+    CHECK((uNumWhiteInstances == 0u) != (uNumRedInstances == 0u));
+}
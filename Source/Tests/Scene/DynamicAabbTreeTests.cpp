@@ -0,0 +1,380 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Renderer/FrustumCuller.h"
+#include "Scene/DynamicAabbTree.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const FLOAT WORLD_SIZE = 500.0f;
+
+    // Stand-in for the renderable of a proxy, the tree only keeps the pointer
+    Renderable* makeRenderableHandle(_In_ UINT uId)
+    {
+        return reinterpret_cast<Renderable*>(static_cast<uintptr_t>(uId + 1u) << 4u);
+    }
+
+    AxisAlignedBox makeRandomBox(_Inout_ std::mt19937& random, _In_ FLOAT worldSize)
+    {
+        std::uniform_real_distribution<FLOAT> centerDistribution(-worldSize, worldSize);
+        std::uniform_real_distribution<FLOAT> extentDistribution(0.1f, 4.0f);
+        return AxisAlignedBox
+        {
+            .Center = XMFLOAT3(centerDistribution(random), centerDistribution(random) * 0.1f, centerDistribution(random)),
+            .Extents = XMFLOAT3(extentDistribution(random), extentDistribution(random), extentDistribution(random))
+        };
+    }
+
+    XMMATRIX makeViewProjection(_Inout_ std::mt19937& random)
+    {
+        std::uniform_real_distribution<FLOAT> distribution(-WORLD_SIZE, WORLD_SIZE);
+        XMVECTOR eye = XMVectorSet(distribution(random), distribution(random) * 0.1f, distribution(random), 0.0f);
+        XMVECTOR at = XMVectorSet(distribution(random), 0.0f, distribution(random), 0.0f);
+        return XMMatrixLookAtLH(eye, at, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 300.0f);
+    }
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   ReferenceProxy
+
+      Summary:  Proxy of the brute force reference, with the bounds the
+                tree was last given for it
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct ReferenceProxy
+    {
+        UINT uProxy;
+        Renderable* pRenderable;
+        AxisAlignedBox Bounds;
+    };
+
+    BOOL overlapsBox(_In_ const AxisAlignedBox& bounds, _In_ const AxisAlignedBox& box)
+    {
+        return std::abs(bounds.Center.x - box.Center.x) <= bounds.Extents.x + box.Extents.x
+            && std::abs(bounds.Center.y - box.Center.y) <= bounds.Extents.y + box.Extents.y
+            && std::abs(bounds.Center.z - box.Center.z) <= bounds.Extents.z + box.Extents.z;
+    }
+
+    // Signed distance of a box from a sphere, overlapping where it is not positive
+    DOUBLE getSphereDistance(_In_ const AxisAlignedBox& bounds, _In_ const XMFLOAT3& center, _In_ FLOAT radius)
+    {
+        DOUBLE d[3] =
+        {
+            std::max(0.0, std::abs(static_cast<DOUBLE>(center.x) - bounds.Center.x) - bounds.Extents.x),
+            std::max(0.0, std::abs(static_cast<DOUBLE>(center.y) - bounds.Center.y) - bounds.Extents.y),
+            std::max(0.0, std::abs(static_cast<DOUBLE>(center.z) - bounds.Center.z) - bounds.Extents.z),
+        };
+        return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - radius;
+    }
+
+    // Smallest margin of a box over the planes of a frustum, outside where it is negative
+    DOUBLE getFrustumMargin(_In_reads_(FrustumCuller::NUM_PLANES) const XMFLOAT4* aPlanes, _In_ const AxisAlignedBox& bounds)
+    {
+        DOUBLE minMargin = DBL_MAX;
+        for (UINT uPlane = 0u; uPlane < FrustumCuller::NUM_PLANES; ++uPlane)
+        {
+            const XMFLOAT4& plane = aPlanes[uPlane];
+            DOUBLE distance = static_cast<DOUBLE>(plane.x) * bounds.Center.x + static_cast<DOUBLE>(plane.y) * bounds.Center.y + static_cast<DOUBLE>(plane.z) * bounds.Center.z + plane.w;
+            DOUBLE radius = std::abs(plane.x) * static_cast<DOUBLE>(bounds.Extents.x) + std::abs(plane.y) * static_cast<DOUBLE>(bounds.Extents.y) + std::abs(plane.z) * static_cast<DOUBLE>(bounds.Extents.z);
+            minMargin = std::min(minMargin, distance + radius);
+        }
+
+        return minMargin;
+    }
+
+    // Distance at which a ray enters a box, DBL_MAX if it misses it
+    DOUBLE getRayEntry(_In_ const AxisAlignedBox& bounds, _In_ const XMFLOAT3& origin, _In_ const XMFLOAT3& direction)
+    {
+        const FLOAT aOrigin[3] = { origin.x, origin.y, origin.z };
+        const FLOAT aDirection[3] = { direction.x, direction.y, direction.z };
+        const FLOAT aCenter[3] = { bounds.Center.x, bounds.Center.y, bounds.Center.z };
+        const FLOAT aExtents[3] = { bounds.Extents.x, bounds.Extents.y, bounds.Extents.z };
+        DOUBLE entry = 0.0;
+        DOUBLE exit = DBL_MAX;
+        for (UINT uAxis = 0u; uAxis < 3u; ++uAxis)
+        {
+            DOUBLE t1 = (static_cast<DOUBLE>(aCenter[uAxis]) - aExtents[uAxis] - aOrigin[uAxis]) / aDirection[uAxis];
+            DOUBLE t2 = (static_cast<DOUBLE>(aCenter[uAxis]) + aExtents[uAxis] - aOrigin[uAxis]) / aDirection[uAxis];
+            entry = std::max(entry, std::min(t1, t2));
+            exit = std::min(exit, std::max(t1, t2));
+        }
+
+        return entry <= exit ? entry : DBL_MAX;
+    }
+
+    // Whether the proxies of a query are the reference proxies with a non-negative test value, allowing rounding near zero
+    template <class Test>
+    BOOL matchesReference(_In_ std::vector<UINT> aProxies, _In_ const std::vector<ReferenceProxy>& aReference, _In_ DOUBLE tolerance, _In_ Test test)
+    {
+        std::sort(aProxies.begin(), aProxies.end());
+        if (std::adjacent_find(aProxies.begin(), aProxies.end()) != aProxies.end())
+        {
+            return FALSE;
+        }
+
+        size_t uNumMatched = 0u;
+        for (const ReferenceProxy& proxy : aReference)
+        {
+            DOUBLE value = test(proxy.Bounds);
+            BOOL bFound = std::binary_search(aProxies.begin(), aProxies.end(), proxy.uProxy);
+            uNumMatched += bFound ? 1u : 0u;
+            if (std::abs(value) > tolerance && bFound != (value >= 0.0))
+            {
+                return FALSE;
+            }
+        }
+
+        // Every proxy returned is a live one
+        return uNumMatched == aProxies.size();
+    }
+}
+
+TEST_CASE(DynamicAabbTreeMatchesBruteForce)
+{
+    std::mt19937 random(59u);
+    DynamicAabbTree tree;
+    std::vector<ReferenceProxy> aReference;
+    std::vector<UINT> aProxies;
+    UINT uNextId = 0u;
+    UINT uNumQueryMismatches = 0u;
+    UINT uNumRayMismatches = 0u;
+    UINT uNumRebuilds = 0u;
+
+    // Random inserts, moves, teleports, removes and rebuilds, the queries are checked against the live proxies after every few steps
+    for (UINT uStep = 0u; uStep < 20000u; ++uStep)
+    {
+        UINT uOperation = random() % 100u;
+        if (aReference.size() < 200u || uOperation < 35u)
+        {
+            AxisAlignedBox bounds = makeRandomBox(random, WORLD_SIZE);
+            Renderable* pRenderable = makeRenderableHandle(uNextId++);
+            aReference.push_back(ReferenceProxy{ .uProxy = tree.Insert(bounds, pRenderable), .pRenderable = pRenderable, .Bounds = bounds });
+        }
+        else if (uOperation < 80u)
+        {
+            ReferenceProxy& proxy = aReference[random() % aReference.size()];
+            if (uOperation < 70u)
+            {
+                std::uniform_real_distribution<FLOAT> moveDistribution(-2.0f, 2.0f);
+                proxy.Bounds.Center.x += moveDistribution(random);
+                proxy.Bounds.Center.y += moveDistribution(random);
+                proxy.Bounds.Center.z += moveDistribution(random);
+            }
+            else
+            {
+                proxy.Bounds = makeRandomBox(random, WORLD_SIZE);
+            }
+            tree.Update(proxy.uProxy, proxy.Bounds);
+        }
+        else if (uOperation < 99u)
+        {
+            size_t uIdx = random() % aReference.size();
+            tree.Remove(aReference[uIdx].uProxy);
+            aReference[uIdx] = aReference.back();
+            aReference.pop_back();
+        }
+        else
+        {
+            tree.Rebuild();
+        }
+
+        if (tree.NeedsRebuild())
+        {
+            tree.Rebuild();
+            ++uNumRebuilds;
+        }
+
+        if (uStep % 25u != 0u)
+        {
+            continue;
+        }
+
+        if (!CHECK(tree.GetNumProxies() == aReference.size()))
+        {
+            return;
+        }
+
+        AxisAlignedBox box = makeRandomBox(random, WORLD_SIZE);
+        box.Extents = XMFLOAT3(box.Extents.x * 10.0f, box.Extents.y * 10.0f, box.Extents.z * 10.0f);
+        tree.QueryBox(box, aProxies);
+        uNumQueryMismatches += matchesReference(aProxies, aReference, 0.0, [&](const AxisAlignedBox& bounds) { return overlapsBox(bounds, box) ? 1.0 : -1.0; }) ? 0u : 1u;
+
+        XMFLOAT3 center = makeRandomBox(random, WORLD_SIZE).Center;
+        FLOAT radius = std::uniform_real_distribution<FLOAT>(1.0f, 80.0f)(random);
+        tree.QuerySphere(XMLoadFloat3(&center), radius, aProxies);
+        uNumQueryMismatches += matchesReference(aProxies, aReference, 1.0e-3, [&](const AxisAlignedBox& bounds) { return -getSphereDistance(bounds, center, radius); }) ? 0u : 1u;
+
+        XMMATRIX viewProjection = makeViewProjection(random);
+        XMFLOAT4 aPlanes[FrustumCuller::NUM_PLANES];
+        FrustumCuller::ExtractPlanes(viewProjection, aPlanes);
+        tree.QueryFrustum(viewProjection, aProxies);
+        uNumQueryMismatches += matchesReference(aProxies, aReference, 1.0e-3, [&](const AxisAlignedBox& bounds) { return getFrustumMargin(aPlanes, bounds); }) ? 0u : 1u;
+
+        // The nearest hit, ties between proxies entered at the same distance may go either way
+        XMFLOAT3 origin = makeRandomBox(random, WORLD_SIZE).Center;
+        XMFLOAT3 direction;
+        XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSet(std::uniform_real_distribution<FLOAT>(-1.0f, 1.0f)(random), std::uniform_real_distribution<FLOAT>(-0.1f, 0.1f)(random), std::uniform_real_distribution<FLOAT>(-1.0f, 1.0f)(random), 0.0f)));
+        FLOAT maxDistance = 400.0f;
+        DOUBLE nearestEntry = DBL_MAX;
+        for (const ReferenceProxy& proxy : aReference)
+        {
+            nearestEntry = std::min(nearestEntry, getRayEntry(proxy.Bounds, origin, direction));
+        }
+        UINT uHitProxy = DynamicAabbTree::NULL_NODE;
+        FLOAT hitDistance = 0.0f;
+        BOOL bHit = tree.Raycast(XMLoadFloat3(&origin), XMLoadFloat3(&direction), maxDistance, uHitProxy, hitDistance);
+        if (nearestEntry < maxDistance - 1.0e-2)
+        {
+            auto it = std::find_if(aReference.begin(), aReference.end(), [&](const ReferenceProxy& proxy) { return proxy.uProxy == uHitProxy; });
+            if (!bHit || it == aReference.end() || std::abs(hitDistance - nearestEntry) > 1.0e-3 * (1.0 + nearestEntry) || std::abs(getRayEntry(it->Bounds, origin, direction) - nearestEntry) > 1.0e-3 * (1.0 + nearestEntry))
+            {
+                ++uNumRayMismatches;
+            }
+        }
+        else if (nearestEntry > maxDistance + 1.0e-2 && bHit)
+        {
+            ++uNumRayMismatches;
+        }
+    }
+    CHECK(uNumQueryMismatches == 0u);
+    CHECK(uNumRayMismatches == 0u);
+    CHECK(uNumRebuilds > 0u);
+
+    // The proxies keep their bounds and renderables across the rebuilds
+    BOOL bProxiesKept = TRUE;
+    for (const ReferenceProxy& proxy : aReference)
+    {
+        AxisAlignedBox bounds = tree.GetBounds(proxy.uProxy);
+        bProxiesKept &= tree.GetRenderable(proxy.uProxy) == proxy.pRenderable;
+        bProxiesKept &= std::abs(bounds.Center.x - proxy.Bounds.Center.x) < 1.0e-3f && std::abs(bounds.Extents.y - proxy.Bounds.Extents.y) < 1.0e-3f;
+    }
+    CHECK(bProxiesKept);
+
+    tree.Clear();
+    tree.QueryBox(AxisAlignedBox{ .Center = XMFLOAT3(0.0f, 0.0f, 0.0f), .Extents = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX) }, aProxies);
+    CHECK(tree.GetNumProxies() == 0u && aProxies.empty());
+}
+
+TEST_CASE(DynamicAabbTreeStaysBalanced)
+{
+    // Boxes inserted along a line are the worst order for an unbalanced tree
+    DynamicAabbTree tree;
+    for (UINT uProxyIdx = 0u; uProxyIdx < 4096u; ++uProxyIdx)
+    {
+        tree.Insert(AxisAlignedBox{ .Center = XMFLOAT3(static_cast<FLOAT>(uProxyIdx) * 3.0f, 0.0f, 0.0f), .Extents = XMFLOAT3(1.0f, 1.0f, 1.0f) }, makeRenderableHandle(uProxyIdx));
+    }
+    CHECK(tree.GetHeight() <= 3u * 12u);
+
+    tree.Rebuild();
+    CHECK(tree.GetHeight() <= 2u * 12u);
+    CHECK(!tree.NeedsRebuild());
+}
+
+BENCHMARK(DynamicAabbTreePerformance)
+{
+    for (UINT uNumProxies : { 10000u, 100000u, 1000000u })
+    {
+        // The renderables of a world that grows with the number of them, so the density stays the same
+        FLOAT worldSize = WORLD_SIZE * std::sqrt(uNumProxies / 10000.0f);
+        std::mt19937 random(61u);
+        std::vector<AxisAlignedBox> aBounds(uNumProxies);
+        for (AxisAlignedBox& bounds : aBounds)
+        {
+            bounds = makeRandomBox(random, worldSize);
+        }
+
+        DynamicAabbTree tree;
+        std::vector<UINT> aProxyIds(uNumProxies);
+        DOUBLE insertTime = context.MeasureMilliseconds(1u, [&]()
+        {
+            tree.Clear();
+            for (UINT uProxyIdx = 0u; uProxyIdx < uNumProxies; ++uProxyIdx)
+            {
+                aProxyIds[uProxyIdx] = tree.Insert(aBounds[uProxyIdx], makeRenderableHandle(uProxyIdx));
+            }
+        });
+        DOUBLE rebuildTime = context.MeasureMilliseconds(3u, [&]()
+        {
+            tree.Rebuild();
+        });
+
+        // Every renderable moves a little, as in a frame where everything is animated
+        std::uniform_real_distribution<FLOAT> moveDistribution(-0.5f, 0.5f);
+        for (AxisAlignedBox& bounds : aBounds)
+        {
+            bounds.Center.x += moveDistribution(random);
+            bounds.Center.z += moveDistribution(random);
+        }
+        DOUBLE updateTime = context.MeasureMilliseconds(1u, [&]()
+        {
+            for (UINT uProxyIdx = 0u; uProxyIdx < uNumProxies; ++uProxyIdx)
+            {
+                tree.Update(aProxyIds[uProxyIdx], aBounds[uProxyIdx]);
+            }
+        });
+        tree.Rebuild();
+
+        constexpr const UINT NUM_QUERIES = 200u;
+        std::vector<XMMATRIX> aViewProjections;
+        std::vector<XMFLOAT3> aPoints;
+        for (UINT uQueryIdx = 0u; uQueryIdx < NUM_QUERIES; ++uQueryIdx)
+        {
+            XMVECTOR eye = XMVectorSet(std::uniform_real_distribution<FLOAT>(-worldSize, worldSize)(random), 5.0f, std::uniform_real_distribution<FLOAT>(-worldSize, worldSize)(random), 0.0f);
+            XMVECTOR at = XMVectorAdd(eye, XMVectorSet(std::uniform_real_distribution<FLOAT>(-1.0f, 1.0f)(random), -0.1f, std::uniform_real_distribution<FLOAT>(-1.0f, 1.0f)(random), 0.0f));
+            aViewProjections.push_back(XMMatrixLookAtLH(eye, at, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 300.0f));
+            XMFLOAT3 point;
+            XMStoreFloat3(&point, eye);
+            aPoints.push_back(point);
+        }
+
+        std::vector<UINT> aProxies;
+        size_t uNumFound = 0u;
+        DOUBLE frustumTime = context.MeasureMilliseconds(1u, [&]()
+        {
+            for (const XMMATRIX& viewProjection : aViewProjections)
+            {
+                tree.QueryFrustum(viewProjection, aProxies);
+                uNumFound += aProxies.size();
+            }
+        });
+        DOUBLE sphereTime = context.MeasureMilliseconds(1u, [&]()
+        {
+            for (const XMFLOAT3& point : aPoints)
+            {
+                tree.QuerySphere(XMLoadFloat3(&point), 20.0f, aProxies);
+            }
+        });
+        DOUBLE rayTime = context.MeasureMilliseconds(1u, [&]()
+        {
+            for (const XMFLOAT3& point : aPoints)
+            {
+                UINT uProxy = 0u;
+                FLOAT distance = 0.0f;
+                tree.Raycast(XMLoadFloat3(&point), XMVectorSet(0.6f, -0.05f, 0.8f, 0.0f), 1000.0f, uProxy, distance);
+            }
+        });
+
+        CHAR szName[64];
+        sprintf_s(szName, "%u proxies, insert", uNumProxies);
+        context.Report(szName, insertTime, "ms");
+        sprintf_s(szName, "%u proxies, rebuild", uNumProxies);
+        context.Report(szName, rebuildTime, "ms");
+        sprintf_s(szName, "%u proxies, update all", uNumProxies);
+        context.Report(szName, updateTime, "ms");
+        sprintf_s(szName, "%u proxies, frustum query", uNumProxies);
+        context.Report(szName, frustumTime * 1000.0 / NUM_QUERIES, "us");
+        sprintf_s(szName, "%u proxies, proxies in the frustum", uNumProxies);
+        context.Report(szName, static_cast<DOUBLE>(uNumFound) / NUM_QUERIES, "");
+        sprintf_s(szName, "%u proxies, sphere query", uNumProxies);
+        context.Report(szName, sphereTime * 1000.0 / NUM_QUERIES, "us");
+        sprintf_s(szName, "%u proxies, raycast", uNumProxies);
+        context.Report(szName, rayTime * 1000.0 / NUM_QUERIES, "us");
+        sprintf_s(szName, "%u proxies, height", uNumProxies);
+        context.Report(szName, tree.GetHeight(), "");
+    }
+}
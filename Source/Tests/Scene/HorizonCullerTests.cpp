@@ -0,0 +1,360 @@
+#include "Harness/TestRegistry.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+#include "Scene/HorizonCuller.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const INT MAP_SIZE = 128;
+    constexpr const INT OCCLUDER_SIZE = 2;
+    constexpr const INT BLOCK_SIZE = 8;
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   Terrain
+
+      Summary:  Heightfield of MAP_SIZE x MAP_SIZE unit cells with its
+                occluder tiles and tested blocks
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct Terrain
+    {
+        std::vector<FLOAT> aHeights;
+        std::vector<HeightBounds> aOccluders;
+        std::vector<HeightBounds> aBlocks;
+
+        FLOAT GetHeight(_In_ INT x, _In_ INT z) const
+        {
+            return aHeights[static_cast<size_t>(z) * MAP_SIZE + x];
+        }
+    };
+
+    HeightBounds getTileBounds(_In_ const Terrain& terrain, _In_ INT minX, _In_ INT minZ, _In_ INT size)
+    {
+        HeightBounds bounds =
+        {
+            .minX = static_cast<FLOAT>(minX),
+            .minZ = static_cast<FLOAT>(minZ),
+            .maxX = static_cast<FLOAT>(minX + size),
+            .maxZ = static_cast<FLOAT>(minZ + size),
+            .minTop = FLT_MAX,
+            .maxTop = -FLT_MAX,
+        };
+        for (INT z = minZ; z < minZ + size; ++z)
+        {
+            for (INT x = minX; x < minX + size; ++x)
+            {
+                FLOAT height = terrain.GetHeight(x, z);
+                bounds.minTop = height < bounds.minTop ? height : bounds.minTop;
+                bounds.maxTop = height > bounds.maxTop ? height : bounds.maxTop;
+            }
+        }
+
+        return bounds;
+    }
+
+    Terrain makeTerrain(_In_ const std::function<FLOAT(INT, INT)>& getHeight)
+    {
+        Terrain terrain;
+        terrain.aHeights.resize(static_cast<size_t>(MAP_SIZE) * MAP_SIZE);
+        for (INT z = 0; z < MAP_SIZE; ++z)
+        {
+            for (INT x = 0; x < MAP_SIZE; ++x)
+            {
+                terrain.aHeights[static_cast<size_t>(z) * MAP_SIZE + x] = getHeight(x, z);
+            }
+        }
+
+        for (INT z = 0; z < MAP_SIZE; z += OCCLUDER_SIZE)
+        {
+            for (INT x = 0; x < MAP_SIZE; x += OCCLUDER_SIZE)
+            {
+                terrain.aOccluders.push_back(getTileBounds(terrain, x, z, OCCLUDER_SIZE));
+            }
+        }
+        for (INT z = 0; z < MAP_SIZE; z += BLOCK_SIZE)
+        {
+            for (INT x = 0; x < MAP_SIZE; x += BLOCK_SIZE)
+            {
+                terrain.aBlocks.push_back(getTileBounds(terrain, x, z, BLOCK_SIZE));
+            }
+        }
+
+        return terrain;
+    }
+
+    // Walks every cell the segment from the eye to a point crosses and returns whether a column outside the block
+    // reaches the segment. A sight line that grazes a column top counts as blocked, it sees the top edge-on.
+    BOOL isPointHidden(_In_ const Terrain& terrain, _In_ const XMFLOAT3& eye, _In_ const HeightBounds& block, _In_ FLOAT x, _In_ FLOAT y, _In_ FLOAT z)
+    {
+        DOUBLE dx = static_cast<DOUBLE>(x) - eye.x;
+        DOUBLE dz = static_cast<DOUBLE>(z) - eye.z;
+        INT cellX = static_cast<INT>(std::floor(eye.x));
+        INT cellZ = static_cast<INT>(std::floor(eye.z));
+        INT stepX = dx > 0.0 ? 1 : -1;
+        INT stepZ = dz > 0.0 ? 1 : -1;
+        DOUBLE deltaX = dx != 0.0 ? std::fabs(1.0 / dx) : DBL_MAX;
+        DOUBLE deltaZ = dz != 0.0 ? std::fabs(1.0 / dz) : DBL_MAX;
+        DOUBLE nextX = dx != 0.0 ? ((dx > 0.0 ? cellX + 1.0 : static_cast<DOUBLE>(cellX)) - eye.x) / dx : DBL_MAX;
+        DOUBLE nextZ = dz != 0.0 ? ((dz > 0.0 ? cellZ + 1.0 : static_cast<DOUBLE>(cellZ)) - eye.z) / dz : DBL_MAX;
+
+        DOUBLE enter = 0.0;
+        while (enter < 1.0)
+        {
+            DOUBLE exit = nextX < nextZ ? nextX : nextZ;
+            exit = exit < 1.0 ? exit : 1.0;
+
+            BOOL bIsInBlock = cellX >= static_cast<INT>(block.minX) && cellX < static_cast<INT>(block.maxX) &&
+                cellZ >= static_cast<INT>(block.minZ) && cellZ < static_cast<INT>(block.maxZ);
+            if (!bIsInBlock && cellX >= 0 && cellX < MAP_SIZE && cellZ >= 0 && cellZ < MAP_SIZE)
+            {
+                DOUBLE enterY = eye.y + enter * (y - eye.y);
+                DOUBLE exitY = eye.y + exit * (y - eye.y);
+                if ((enterY < exitY ? enterY : exitY) <= terrain.GetHeight(cellX, cellZ))
+                {
+                    return TRUE;
+                }
+            }
+
+            enter = exit;
+            if (nextX < nextZ)
+            {
+                cellX += stepX;
+                nextX += deltaX;
+            }
+            else
+            {
+                cellZ += stepZ;
+                nextZ += deltaZ;
+            }
+        }
+
+        return FALSE;
+    }
+
+    // Brute force reference: a block is hidden if every sample of the box of its highest top is hidden
+    BOOL isBlockHidden(_In_ const Terrain& terrain, _In_ const XMFLOAT3& eye, _In_ const HeightBounds& block)
+    {
+        constexpr const UINT NUM_SAMPLES = 5u;
+
+        for (UINT uSampleZ = 0u; uSampleZ < NUM_SAMPLES; ++uSampleZ)
+        {
+            for (UINT uSampleX = 0u; uSampleX < NUM_SAMPLES; ++uSampleX)
+            {
+                FLOAT x = block.minX + (block.maxX - block.minX) * static_cast<FLOAT>(uSampleX) / static_cast<FLOAT>(NUM_SAMPLES - 1u);
+                FLOAT z = block.minZ + (block.maxZ - block.minZ) * static_cast<FLOAT>(uSampleZ) / static_cast<FLOAT>(NUM_SAMPLES - 1u);
+                if (!isPointHidden(terrain, eye, block, x, block.maxTop, z))
+                {
+                    return FALSE;
+                }
+            }
+        }
+
+        return TRUE;
+    }
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   CullResult
+
+      Summary:  Agreement of the culler with the brute force reference
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct CullResult
+    {
+        UINT uNumHidden;
+        UINT uNumCulled;
+        UINT uNumWronglyCulled;
+        std::vector<BOOL> aIsVisible;
+    };
+
+    CullResult cull(_In_ HorizonCuller& culler, _In_ const Terrain& terrain, _In_ const XMFLOAT3& eye)
+    {
+        CullResult result = {};
+        culler.Cull(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), terrain.aOccluders, terrain.aBlocks, result.aIsVisible);
+
+        for (size_t i = 0u; i < terrain.aBlocks.size(); ++i)
+        {
+            BOOL bIsHidden = isBlockHidden(terrain, eye, terrain.aBlocks[i]);
+            result.uNumHidden += bIsHidden ? 1u : 0u;
+            result.uNumCulled += result.aIsVisible[i] ? 0u : 1u;
+            result.uNumWronglyCulled += !result.aIsVisible[i] && !bIsHidden ? 1u : 0u;
+        }
+
+        return result;
+    }
+
+    BOOL isBlockVisible(_In_ const Terrain& terrain, _In_ const CullResult& result, _In_ INT x, _In_ INT z)
+    {
+        for (size_t i = 0u; i < terrain.aBlocks.size(); ++i)
+        {
+            const HeightBounds& block = terrain.aBlocks[i];
+            if (static_cast<FLOAT>(x) >= block.minX && static_cast<FLOAT>(x) < block.maxX && static_cast<FLOAT>(z) >= block.minZ && static_cast<FLOAT>(z) < block.maxZ)
+            {
+                return result.aIsVisible[i];
+            }
+        }
+
+        return TRUE;
+    }
+}
+
+TEST_CASE(HorizonCullerHidesTerrainBehindRidge)
+{
+    // Flat ground with a ridge across the whole map, the eye stands low in front of it
+    Terrain terrain = makeTerrain([](INT x, INT)
+    {
+        return x >= 40 && x < 48 ? 24.0f : 0.0f;
+    });
+    XMFLOAT3 eye(16.5f, 2.0f, 64.5f);
+
+    HorizonCuller culler;
+    CullResult result = cull(culler, terrain, eye);
+
+    CHECK(result.uNumWronglyCulled == 0u);
+    CHECK(result.uNumHidden > 0u);
+    CHECK(result.uNumCulled * 10u >= result.uNumHidden * 9u);
+    CHECK(isBlockVisible(terrain, result, 20, 64));
+    CHECK(isBlockVisible(terrain, result, 44, 64));
+    CHECK(!isBlockVisible(terrain, result, 100, 64));
+    // The block around the eye is always visible and not tested
+    CHECK(culler.GetStatistics().uNumTestedBlocks == terrain.aBlocks.size() - 1u);
+    CHECK(culler.GetStatistics().uNumCulledBlocks == result.uNumCulled);
+}
+
+TEST_CASE(HorizonCullerKeepsPeaksAboveRidge)
+{
+    // A peak behind the ridge rises above the sight line over the ridge
+    Terrain terrain = makeTerrain([](INT x, INT z)
+    {
+        if (x >= 96 && x < 104 && z >= 56 && z < 72)
+        {
+            return 120.0f;
+        }
+        return x >= 40 && x < 48 ? 24.0f : 0.0f;
+    });
+    XMFLOAT3 eye(16.5f, 2.0f, 64.5f);
+
+    HorizonCuller culler;
+    CullResult result = cull(culler, terrain, eye);
+
+    CHECK(result.uNumWronglyCulled == 0u);
+    CHECK(isBlockVisible(terrain, result, 100, 64));
+    CHECK(!isBlockVisible(terrain, result, 120, 16));
+}
+
+TEST_CASE(HorizonCullerKeepsValleyFloorVisible)
+{
+    // The eye stands in a valley running along z, walls hide the low ground on both sides
+    Terrain terrain = makeTerrain([](INT x, INT)
+    {
+        if ((x >= 40 && x < 56) || (x >= 72 && x < 88))
+        {
+            return 40.0f;
+        }
+        return 0.0f;
+    });
+    XMFLOAT3 eye(64.5f, 2.0f, 4.5f);
+
+    HorizonCuller culler;
+    CullResult result = cull(culler, terrain, eye);
+
+    CHECK(result.uNumWronglyCulled == 0u);
+    CHECK(result.uNumHidden > 0u);
+    CHECK(result.uNumCulled * 10u >= result.uNumHidden * 9u);
+
+    // The whole floor of the valley is in view, the ground behind the walls is not
+    for (INT z = 4; z < MAP_SIZE; z += BLOCK_SIZE)
+    {
+        CHECK(isBlockVisible(terrain, result, 60, z));
+        CHECK(isBlockVisible(terrain, result, 68, z));
+    }
+    CHECK(!isBlockVisible(terrain, result, 20, 100));
+    CHECK(!isBlockVisible(terrain, result, 108, 100));
+}
+
+TEST_CASE(HorizonCullerCullsNothingFromAbove)
+{
+    Terrain terrain = makeTerrain([](INT x, INT z)
+    {
+        return 32.0f + 16.0f * std::sin(0.1f * static_cast<FLOAT>(x)) * std::cos(0.13f * static_cast<FLOAT>(z));
+    });
+    XMFLOAT3 eye(64.5f, 1000.0f, 64.5f);
+
+    HorizonCuller culler;
+    CullResult result = cull(culler, terrain, eye);
+
+    CHECK(result.uNumCulled == 0u);
+}
+
+TEST_CASE(HorizonCullerIsConservativeOnRandomTerrain)
+{
+    std::mt19937 random(5u);
+    std::uniform_real_distribution<FLOAT> phase(0.0f, 6.0f);
+    std::uniform_real_distribution<FLOAT> position(8.0f, static_cast<FLOAT>(MAP_SIZE) - 8.0f);
+
+    HorizonCuller culler;
+    for (UINT uTrial = 0u; uTrial < 16u; ++uTrial)
+    {
+        FLOAT phaseX = phase(random);
+        FLOAT phaseZ = phase(random);
+        Terrain terrain = makeTerrain([phaseX, phaseZ](INT x, INT z)
+        {
+            FLOAT fx = static_cast<FLOAT>(x);
+            FLOAT fz = static_cast<FLOAT>(z);
+            return std::floor(24.0f + 12.0f * std::sin(0.09f * fx + phaseX) * std::cos(0.07f * fz + phaseZ) + 6.0f * std::sin(0.31f * fx + 0.23f * fz));
+        });
+
+        XMFLOAT3 eye(position(random), 0.0f, position(random));
+        eye.y = terrain.GetHeight(static_cast<INT>(eye.x), static_cast<INT>(eye.z)) + 2.0f;
+
+        CullResult result = cull(culler, terrain, eye);
+        CHECK(result.uNumWronglyCulled == 0u);
+    }
+}
+
+BENCHMARK(HorizonCullerCullRate)
+{
+    std::mt19937 random(5u);
+    std::uniform_real_distribution<FLOAT> position(8.0f, static_cast<FLOAT>(MAP_SIZE) - 8.0f);
+
+    Terrain terrain = makeTerrain([](INT x, INT z)
+    {
+        FLOAT fx = static_cast<FLOAT>(x);
+        FLOAT fz = static_cast<FLOAT>(z);
+        return std::floor(24.0f + 12.0f * std::sin(0.09f * fx) * std::cos(0.07f * fz) + 6.0f * std::sin(0.31f * fx + 0.23f * fz));
+    });
+
+    HorizonCuller culler;
+    UINT uNumHidden = 0u;
+    UINT uNumCulled = 0u;
+    UINT uNumBlocks = 0u;
+    for (UINT uTrial = 0u; uTrial < 16u; ++uTrial)
+    {
+        XMFLOAT3 eye(position(random), 0.0f, position(random));
+        eye.y = terrain.GetHeight(static_cast<INT>(eye.x), static_cast<INT>(eye.z)) + 2.0f;
+
+        CullResult result = cull(culler, terrain, eye);
+        uNumHidden += result.uNumHidden;
+        uNumCulled += result.uNumCulled;
+        uNumBlocks += static_cast<UINT>(terrain.aBlocks.size());
+        CHECK(result.uNumWronglyCulled == 0u);
+    }
+
+    std::vector<BOOL> aIsVisible;
+    XMVECTOR eye = XMVectorSet(64.5f, terrain.GetHeight(64, 64) + 2.0f, 64.5f, 1.0f);
+    DOUBLE time = context.MeasureMilliseconds(50u, [&]()
+    {
+        culler.Cull(eye, terrain.aOccluders, terrain.aBlocks, aIsVisible);
+    });
+
+    context.Report("hidden blocks (reference)", 100.0 * uNumHidden / uNumBlocks, "%");
+    context.Report("culled blocks", 100.0 * uNumCulled / uNumBlocks, "%");
+    context.Report("hidden blocks found", uNumHidden > 0u ? 100.0 * uNumCulled / uNumHidden : 100.0, "%");
+    CHAR szName[64];
+    sprintf_s(szName, "Cull, %zu occluders, %zu blocks", terrain.aOccluders.size(), terrain.aBlocks.size());
+    context.Report(szName, time, "ms");
+}
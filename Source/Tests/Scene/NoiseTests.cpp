@@ -0,0 +1,315 @@
+#include "Harness/TestRegistry.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Scene/Noise.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const FLOAT FREQUENCY = 0.1f;
+    constexpr const UINT DEPTH = 4u;
+    constexpr const UINT SEEDS[] = { 0u, 1u, 42u, 0xdeadbeefu };
+
+    PCSTR getTypeName(_In_ eNoiseType type)
+    {
+        switch (type)
+        {
+        case eNoiseType::LEGACY_VALUE:
+            return "LEGACY_VALUE";
+        case eNoiseType::PERLIN:
+            return "PERLIN";
+        case eNoiseType::SIMPLEX:
+            return "SIMPLEX";
+        default:
+            return "?";
+        }
+    }
+
+    void makeSamplePoints(_In_ UINT uCount, _Out_ std::vector<FLOAT>& aOutX, _Out_ std::vector<FLOAT>& aOutY)
+    {
+        std::mt19937 random(99u);
+        std::uniform_real_distribution<FLOAT> coordinate(0.0f, 4096.0f);
+
+        aOutX.resize(uCount);
+        aOutY.resize(uCount);
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            aOutX[i] = coordinate(random);
+            aOutY[i] = coordinate(random);
+        }
+    }
+
+    /*F+F+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+      Function: getShiftedCorrelation
+
+      Summary:  Correlation of the fractal noise over a 256x256 sample
+                window with the same window shifted along x
+
+      Args:     const Noise& noise
+                  Noise field
+                FLOAT shift
+                  Shift of the second window in sample units
+
+      Returns:  DOUBLE
+                  Pearson correlation of the two windows
+    -----------------------------------------------------------------F-F*/
+    DOUBLE getShiftedCorrelation(_In_ const Noise& noise, _In_ FLOAT shift)
+    {
+        constexpr const UINT WINDOW_SIZE = 256u;
+
+        std::vector<FLOAT> aX(WINDOW_SIZE * WINDOW_SIZE);
+        std::vector<FLOAT> aY(WINDOW_SIZE * WINDOW_SIZE);
+        std::vector<FLOAT> aShiftedX(WINDOW_SIZE * WINDOW_SIZE);
+        for (UINT z = 0u; z < WINDOW_SIZE; ++z)
+        {
+            for (UINT x = 0u; x < WINDOW_SIZE; ++x)
+            {
+                aX[z * WINDOW_SIZE + x] = static_cast<FLOAT>(x);
+                aY[z * WINDOW_SIZE + x] = static_cast<FLOAT>(z);
+                aShiftedX[z * WINDOW_SIZE + x] = static_cast<FLOAT>(x) + shift;
+            }
+        }
+
+        std::vector<FLOAT> aValues(aX.size());
+        std::vector<FLOAT> aShiftedValues(aX.size());
+        noise.GetFractal2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aValues.data(), static_cast<UINT>(aX.size()));
+        noise.GetFractal2dBatch(aShiftedX.data(), aY.data(), FREQUENCY, DEPTH, aShiftedValues.data(), static_cast<UINT>(aX.size()));
+
+        DOUBLE sum = 0.0;
+        DOUBLE shiftedSum = 0.0;
+        for (size_t i = 0u; i < aValues.size(); ++i)
+        {
+            sum += aValues[i];
+            shiftedSum += aShiftedValues[i];
+        }
+        DOUBLE mean = sum / static_cast<DOUBLE>(aValues.size());
+        DOUBLE shiftedMean = shiftedSum / static_cast<DOUBLE>(aValues.size());
+
+        DOUBLE covariance = 0.0;
+        DOUBLE variance = 0.0;
+        DOUBLE shiftedVariance = 0.0;
+        for (size_t i = 0u; i < aValues.size(); ++i)
+        {
+            DOUBLE delta = aValues[i] - mean;
+            DOUBLE shiftedDelta = aShiftedValues[i] - shiftedMean;
+            covariance += delta * shiftedDelta;
+            variance += delta * delta;
+            shiftedVariance += shiftedDelta * shiftedDelta;
+        }
+
+        return covariance / std::sqrt(variance * shiftedVariance);
+    }
+}
+
+TEST_CASE(NoiseBatchMatchesScalar)
+{
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(1027u, aX, aY);
+    std::vector<FLOAT> aBatch(aX.size());
+
+    for (UINT uType = 0u; uType < static_cast<UINT>(eNoiseType::COUNT); ++uType)
+    {
+        for (UINT uSeed : SEEDS)
+        {
+            for (FLOAT warpAmplitude : { 0.0f, 4.0f })
+            {
+                Noise noise(static_cast<eNoiseType>(uType), uSeed);
+                noise.SetDomainWarp(warpAmplitude, 0.05f);
+                noise.GetFractal2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aBatch.data(), static_cast<UINT>(aX.size()));
+
+                UINT uNumMismatches = 0u;
+                for (size_t i = 0u; i < aX.size(); ++i)
+                {
+                    if (aBatch[i] != noise.GetFractal2d(aX[i], aY[i], FREQUENCY, DEPTH))
+                    {
+                        ++uNumMismatches;
+                    }
+                }
+                CHECK(uNumMismatches == 0u);
+            }
+        }
+    }
+}
+
+TEST_CASE(NoiseStaysInUnitRange)
+{
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(100000u, aX, aY);
+    std::vector<FLOAT> aValues(aX.size());
+
+    for (UINT uType = 0u; uType < static_cast<UINT>(eNoiseType::COUNT); ++uType)
+    {
+        Noise noise(static_cast<eNoiseType>(uType), 7u);
+        noise.GetFractal2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aValues.data(), static_cast<UINT>(aX.size()));
+
+        for (FLOAT value : aValues)
+        {
+            if (!CHECK(value >= 0.0f && value <= 1.0f))
+            {
+                break;
+            }
+        }
+    }
+}
+
+TEST_CASE(NoiseSeedsGiveDifferentFields)
+{
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(4096u, aX, aY);
+
+    for (eNoiseType type : { eNoiseType::PERLIN, eNoiseType::SIMPLEX })
+    {
+        Noise noise(type, 1u);
+        Noise sameSeed(type, 1u);
+        Noise otherSeed(type, 2u);
+
+        UINT uNumEqual = 0u;
+        for (size_t i = 0u; i < aX.size(); ++i)
+        {
+            FLOAT value = noise.GetFractal2d(aX[i], aY[i], FREQUENCY, DEPTH);
+            CHECK(value == sameSeed.GetFractal2d(aX[i], aY[i], FREQUENCY, DEPTH));
+            if (value == otherSeed.GetFractal2d(aX[i], aY[i], FREQUENCY, DEPTH))
+            {
+                ++uNumEqual;
+            }
+        }
+
+        // Equal values at a few lattice corners are fine, an equal field is not
+        CHECK(uNumEqual < aX.size() / 100u);
+    }
+}
+
+BENCHMARK(NoisePerformance)
+{
+    constexpr const UINT NUM_POINTS = 1u << 20u;
+
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(NUM_POINTS, aX, aY);
+    std::vector<FLOAT> aOut(NUM_POINTS);
+
+    for (UINT uType = 0u; uType < static_cast<UINT>(eNoiseType::COUNT); ++uType)
+    {
+        for (FLOAT warpAmplitude : { 0.0f, 4.0f })
+        {
+            Noise noise(static_cast<eNoiseType>(uType), 7u);
+            noise.SetDomainWarp(warpAmplitude, 0.05f);
+
+            DOUBLE time = context.MeasureMilliseconds(3u, [&]()
+            {
+                noise.GetFractal2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aOut.data(), NUM_POINTS);
+            });
+
+            CHAR szName[64];
+            sprintf_s(szName, "%s, %u octaves%s", getTypeName(static_cast<eNoiseType>(uType)), DEPTH, warpAmplitude != 0.0f ? ", warped" : "");
+            context.Report(szName, NUM_POINTS / time / 1000.0, "Msamples/s");
+        }
+    }
+}
+
+TEST_CASE(NoiseDoesNotRepeat)
+{
+    // Shifts of 256 and 512 lattice cells, the periods of 8- and 9-bit lattice hashes, and a
+    // large one that would wrap any table. LEGACY_VALUE keeps the fixed hash of Scene::GetPerlin2d.
+    constexpr const FLOAT LATTICE_SHIFTS[] = { 256.0f, 512.0f, 4096.0f };
+
+    for (eNoiseType type : { eNoiseType::PERLIN, eNoiseType::SIMPLEX })
+    {
+        for (UINT uSeed : SEEDS)
+        {
+            Noise noise(type, uSeed);
+            for (FLOAT latticeShift : LATTICE_SHIFTS)
+            {
+                DOUBLE correlation = getShiftedCorrelation(noise, latticeShift / FREQUENCY);
+                CHECK(std::fabs(correlation) < 0.1);
+            }
+        }
+    }
+}
+
+BENCHMARK(NoiseQuality)
+{
+    // A 512x512 cell window, and the same window 256 lattice cells away
+    constexpr const UINT WINDOW_SIZE = 512u;
+    constexpr const FLOAT PERIOD = 256.0f / FREQUENCY;
+
+    std::vector<FLOAT> aX(WINDOW_SIZE * WINDOW_SIZE);
+    std::vector<FLOAT> aY(WINDOW_SIZE * WINDOW_SIZE);
+    std::vector<FLOAT> aShiftedX(WINDOW_SIZE * WINDOW_SIZE);
+    for (UINT z = 0u; z < WINDOW_SIZE; ++z)
+    {
+        for (UINT x = 0u; x < WINDOW_SIZE; ++x)
+        {
+            aX[z * WINDOW_SIZE + x] = static_cast<FLOAT>(x);
+            aY[z * WINDOW_SIZE + x] = static_cast<FLOAT>(z);
+            aShiftedX[z * WINDOW_SIZE + x] = static_cast<FLOAT>(x) + PERIOD;
+        }
+    }
+
+    std::vector<FLOAT> aValues(aX.size());
+    std::vector<FLOAT> aShiftedValues(aX.size());
+    for (UINT uType = 0u; uType < static_cast<UINT>(eNoiseType::COUNT); ++uType)
+    {
+        Noise noise(static_cast<eNoiseType>(uType), 7u);
+        noise.GetFractal2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aValues.data(), static_cast<UINT>(aX.size()));
+        noise.GetFractal2dBatch(aShiftedX.data(), aY.data(), FREQUENCY, DEPTH, aShiftedValues.data(), static_cast<UINT>(aX.size()));
+
+        DOUBLE sum = 0.0;
+        DOUBLE sumSquares = 0.0;
+        DOUBLE minValue = 1.0;
+        DOUBLE maxValue = 0.0;
+        DOUBLE sumGradients = 0.0;
+        for (UINT z = 0u; z < WINDOW_SIZE; ++z)
+        {
+            for (UINT x = 0u; x < WINDOW_SIZE; ++x)
+            {
+                DOUBLE value = aValues[z * WINDOW_SIZE + x];
+                sum += value;
+                sumSquares += value * value;
+                minValue = value < minValue ? value : minValue;
+                maxValue = value > maxValue ? value : maxValue;
+                if (x > 0u)
+                {
+                    sumGradients += std::fabs(value - aValues[z * WINDOW_SIZE + x - 1u]);
+                }
+            }
+        }
+
+        DOUBLE count = static_cast<DOUBLE>(aValues.size());
+        DOUBLE mean = sum / count;
+        DOUBLE variance = sumSquares / count - mean * mean;
+
+        DOUBLE covariance = 0.0;
+        DOUBLE shiftedSum = 0.0;
+        DOUBLE shiftedSumSquares = 0.0;
+        for (size_t i = 0u; i < aValues.size(); ++i)
+        {
+            shiftedSum += aShiftedValues[i];
+            shiftedSumSquares += static_cast<DOUBLE>(aShiftedValues[i]) * aShiftedValues[i];
+            covariance += (aValues[i] - mean) * aShiftedValues[i];
+        }
+        DOUBLE shiftedMean = shiftedSum / count;
+        DOUBLE shiftedVariance = shiftedSumSquares / count - shiftedMean * shiftedMean;
+        DOUBLE periodCorrelation = covariance / count / std::sqrt(variance * shiftedVariance);
+
+        CHAR szName[64];
+        PCSTR pszType = getTypeName(static_cast<eNoiseType>(uType));
+        sprintf_s(szName, "%s mean", pszType);
+        context.Report(szName, mean, "");
+        sprintf_s(szName, "%s standard deviation", pszType);
+        context.Report(szName, std::sqrt(variance), "");
+        sprintf_s(szName, "%s range", pszType);
+        context.Report(szName, maxValue - minValue, "");
+        sprintf_s(szName, "%s mean gradient per cell", pszType);
+        context.Report(szName, sumGradients / (WINDOW_SIZE * (WINDOW_SIZE - 1u)), "");
+        sprintf_s(szName, "%s correlation 256 cells away", pszType);
+        context.Report(szName, periodCorrelation, "");
+    }
+}
@@ -0,0 +1,94 @@
+#include "Harness/TestRegistry.h"
+
+#include <random>
+
+#include "Scene/Noise.h"
+#include "Scene/Scene.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const FLOAT FREQUENCY = 0.1f;
+    constexpr const UINT DEPTH = 4u;
+
+    void makeSamplePoints(_In_ UINT uCount, _In_ FLOAT maxCoordinate, _Out_ std::vector<FLOAT>& aOutX, _Out_ std::vector<FLOAT>& aOutY)
+    {
+        std::mt19937 random(1234u);
+        std::uniform_real_distribution<FLOAT> coordinate(0.0f, maxCoordinate);
+
+        aOutX.resize(uCount);
+        aOutY.resize(uCount);
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            aOutX[i] = coordinate(random);
+            aOutY[i] = coordinate(random);
+        }
+    }
+}
+
+TEST_CASE(PerlinBatchMatchesScalarForEveryCount)
+{
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(64u, 4096.0f, aX, aY);
+
+    // Every count up to 64 covers the vector bodies and all scalar remainders
+    std::vector<FLOAT> aBatch(aX.size());
+    for (UINT uCount = 0u; uCount <= aX.size(); ++uCount)
+    {
+        Scene::GetPerlin2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aBatch.data(), uCount);
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            CHECK(aBatch[i] == Scene::GetPerlin2d(aX[i], aY[i], FREQUENCY, DEPTH));
+        }
+    }
+}
+
+TEST_CASE(PerlinBatchMatchesScalarOnRandomPoints)
+{
+    constexpr const UINT NUM_POINTS = 100000u;
+
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(NUM_POINTS, 65536.0f, aX, aY);
+
+    std::vector<FLOAT> aBatch(NUM_POINTS);
+    Scene::GetPerlin2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aBatch.data(), NUM_POINTS);
+
+    UINT uNumMismatches = 0u;
+    for (UINT i = 0u; i < NUM_POINTS; ++i)
+    {
+        if (aBatch[i] != Scene::GetPerlin2d(aX[i], aY[i], FREQUENCY, DEPTH))
+        {
+            ++uNumMismatches;
+        }
+    }
+    CHECK(uNumMismatches == 0u);
+}
+
+BENCHMARK(PerlinBatchSamplesPerSecond)
+{
+    constexpr const UINT NUM_POINTS = 1u << 20u;
+
+    std::vector<FLOAT> aX;
+    std::vector<FLOAT> aY;
+    makeSamplePoints(NUM_POINTS, 4096.0f, aX, aY);
+    std::vector<FLOAT> aOut(NUM_POINTS);
+
+    DOUBLE scalarTime = context.MeasureMilliseconds(3u, [&]()
+    {
+        for (UINT i = 0u; i < NUM_POINTS; ++i)
+        {
+            aOut[i] = Scene::GetPerlin2d(aX[i], aY[i], FREQUENCY, DEPTH);
+        }
+    });
+    DOUBLE batchTime = context.MeasureMilliseconds(3u, [&]()
+    {
+        Scene::GetPerlin2dBatch(aX.data(), aY.data(), FREQUENCY, DEPTH, aOut.data(), NUM_POINTS);
+    });
+
+    context.Report("GetPerlin2d", NUM_POINTS / scalarTime / 1000.0, "Msamples/s");
+    context.Report(IsAvx2Supported() ? "GetPerlin2dBatch (AVX2)" : "GetPerlin2dBatch (SSE2)", NUM_POINTS / batchTime / 1000.0, "Msamples/s");
+    context.Report("speedup", scalarTime / batchTime, "x");
+}
@@ -0,0 +1,346 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+#include "Scene/TerrainGenerator.h"
+#include "Scene/VoxelGrid.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const INT GRID_WIDTH = 40;
+    constexpr const INT GRID_HEIGHT = 24;
+    constexpr const INT GRID_DEPTH = 40;
+    constexpr const DOUBLE DISTANCE_TOLERANCE = 2e-3;
+
+    /*S+S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S+++S
+      Struct:   ReferenceHit
+
+      Summary:  Nearest hit of a ray found by testing every solid cell
+    S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S---S-S*/
+    struct ReferenceHit
+    {
+        BOOL bHit;
+        XMINT3 Cell;
+        XMINT3 Normal;
+        DOUBLE Distance;
+    };
+
+    // Entry distance of a ray into the unit box of a cell, negative when the ray misses it
+    DOUBLE intersectCell(_In_ const XMINT3& cell, _In_ const DOUBLE aOrigin[3], _In_ const DOUBLE aDirection[3], _In_ DOUBLE maxDistance, _Out_ INT& outNormalAxis)
+    {
+        const INT aCell[3] = { cell.x, cell.y, cell.z };
+        DOUBLE enterDistance = 0.0;
+        DOUBLE exitDistance = maxDistance;
+        outNormalAxis = -1;
+        for (INT axis = 0; axis < 3; ++axis)
+        {
+            if (aDirection[axis] == 0.0)
+            {
+                if (aOrigin[axis] < aCell[axis] || aOrigin[axis] >= aCell[axis] + 1.0)
+                {
+                    return -1.0;
+                }
+                continue;
+            }
+
+            DOUBLE nearDistance = (aCell[axis] - aOrigin[axis]) / aDirection[axis];
+            DOUBLE farDistance = (aCell[axis] + 1.0 - aOrigin[axis]) / aDirection[axis];
+            if (nearDistance > farDistance)
+            {
+                std::swap(nearDistance, farDistance);
+            }
+            if (nearDistance > enterDistance)
+            {
+                enterDistance = nearDistance;
+                outNormalAxis = axis;
+            }
+            exitDistance = farDistance < exitDistance ? farDistance : exitDistance;
+        }
+
+        return enterDistance <= exitDistance ? enterDistance : -1.0;
+    }
+
+    ReferenceHit raycastBruteForce(_In_ const std::vector<XMINT3>& aSolidCells, _In_ const VoxelRay& ray)
+    {
+        ReferenceHit hit = { .bHit = FALSE, .Cell = XMINT3(0, 0, 0), .Normal = XMINT3(0, 0, 0), .Distance = DBL_MAX };
+
+        DOUBLE length = std::sqrt(static_cast<DOUBLE>(ray.Direction.x) * ray.Direction.x + static_cast<DOUBLE>(ray.Direction.y) * ray.Direction.y + static_cast<DOUBLE>(ray.Direction.z) * ray.Direction.z);
+        const DOUBLE aOrigin[3] = { ray.Origin.x, ray.Origin.y, ray.Origin.z };
+        const DOUBLE aDirection[3] = { ray.Direction.x / length, ray.Direction.y / length, ray.Direction.z / length };
+        for (const XMINT3& cell : aSolidCells)
+        {
+            INT normalAxis = -1;
+            DOUBLE distance = intersectCell(cell, aOrigin, aDirection, ray.MaxDistance, normalAxis);
+            if (distance >= 0.0 && distance < hit.Distance)
+            {
+                INT aNormal[3] = {};
+                if (normalAxis >= 0)
+                {
+                    aNormal[normalAxis] = aDirection[normalAxis] > 0.0 ? -1 : 1;
+                }
+
+                hit.bHit = TRUE;
+                hit.Cell = cell;
+                hit.Normal = XMINT3(aNormal[0], aNormal[1], aNormal[2]);
+                hit.Distance = distance;
+            }
+        }
+
+        return hit;
+    }
+
+    BOOL isEqual(_In_ const XMINT3& a, _In_ const XMINT3& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    // Sparse random blocks, including the cells on the faces of the grid
+    void makeSparseGrid(_In_ UINT uSeed, _In_ FLOAT density, _Out_ VoxelGrid& outGrid, _Out_ std::vector<XMINT3>& aOutSolidCells)
+    {
+        std::mt19937 random(uSeed);
+        std::uniform_real_distribution<FLOAT> unit(0.0f, 1.0f);
+
+        outGrid.Initialize(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH);
+        aOutSolidCells.clear();
+        for (INT z = 0; z < GRID_DEPTH; ++z)
+        {
+            for (INT y = 0; y < GRID_HEIGHT; ++y)
+            {
+                for (INT x = 0; x < GRID_WIDTH; ++x)
+                {
+                    if (unit(random) < density)
+                    {
+                        outGrid.SetBlock(x, y, z, eBlockType::SNOW);
+                        aOutSolidCells.push_back(XMINT3(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+
+    // Rays starting both inside and outside of the grid, some of them along the axes and not normalized
+    std::vector<VoxelRay> makeRandomRays(_In_ UINT uSeed, _In_ UINT uCount)
+    {
+        std::mt19937 random(uSeed);
+        std::uniform_real_distribution<FLOAT> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<FLOAT> direction(-1.0f, 1.0f);
+
+        std::vector<VoxelRay> aRays(uCount);
+        for (UINT i = 0u; i < uCount; ++i)
+        {
+            VoxelRay& ray = aRays[i];
+            ray.Origin = XMFLOAT3(
+                -8.0f + unit(random) * (GRID_WIDTH + 16.0f),
+                -8.0f + unit(random) * (GRID_HEIGHT + 16.0f),
+                -8.0f + unit(random) * (GRID_DEPTH + 16.0f)
+            );
+            ray.Direction = XMFLOAT3(direction(random), direction(random), direction(random));
+            if (i % 8u == 0u)
+            {
+                FLOAT aDirection[3] = {};
+                aDirection[(i / 8u) % 3u] = (i / 24u) % 2u ? 3.0f : -3.0f;
+                ray.Direction = XMFLOAT3(aDirection[0], aDirection[1], aDirection[2]);
+            }
+            ray.MaxDistance = unit(random) * 80.0f;
+        }
+
+        return aRays;
+    }
+
+    // Compares a hit of VoxelGrid::Raycast with the brute force one, two cells at the same distance may both be right
+    BOOL matchesReference(_In_ const VoxelRayHit& hit, _In_ const ReferenceHit& reference, _In_ const std::vector<XMINT3>& aSolidCells, _In_ const VoxelRay& ray)
+    {
+        if (hit.bHit != reference.bHit)
+        {
+            return FALSE;
+        }
+        if (!hit.bHit)
+        {
+            return hit.Distance == ray.MaxDistance;
+        }
+        if (std::fabs(hit.Distance - reference.Distance) > DISTANCE_TOLERANCE || hit.BlockType != eBlockType::SNOW)
+        {
+            return FALSE;
+        }
+        if (isEqual(hit.Cell, reference.Cell))
+        {
+            return isEqual(hit.Normal, reference.Normal);
+        }
+
+        std::vector<XMINT3> aHitCell(1u, hit.Cell);
+        ReferenceHit cellHit = raycastBruteForce(aHitCell, ray);
+        return cellHit.bHit && std::fabs(cellHit.Distance - reference.Distance) <= DISTANCE_TOLERANCE
+            && std::find_if(aSolidCells.begin(), aSolidCells.end(), [&hit](const XMINT3& cell) { return isEqual(cell, hit.Cell); }) != aSolidCells.end();
+    }
+}
+
+TEST_CASE(VoxelGridRaycastMatchesBruteForce)
+{
+    constexpr const UINT NUM_RAYS = 20000u;
+
+    for (FLOAT density : { 0.002f, 0.02f, 0.2f })
+    {
+        VoxelGrid grid;
+        std::vector<XMINT3> aSolidCells;
+        makeSparseGrid(11u, density, grid, aSolidCells);
+
+        std::vector<VoxelRay> aRays = makeRandomRays(5u, NUM_RAYS);
+        UINT uNumHits = 0u;
+        UINT uNumMismatches = 0u;
+        for (const VoxelRay& ray : aRays)
+        {
+            VoxelRayHit hit;
+            BOOL bHit = grid.Raycast(ray, hit);
+            ReferenceHit reference = raycastBruteForce(aSolidCells, ray);
+
+            if (bHit != hit.bHit || !matchesReference(hit, reference, aSolidCells, ray))
+            {
+                ++uNumMismatches;
+            }
+            uNumHits += reference.bHit ? 1u : 0u;
+        }
+
+        CHECK(uNumMismatches == 0u);
+        CHECK(uNumHits > 0u);
+    }
+}
+
+TEST_CASE(VoxelGridRaycastEdgeCases)
+{
+    VoxelGrid grid;
+    grid.Initialize(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH);
+    grid.SetBlock(20, 10, 20, eBlockType::SAND);
+    VoxelRayHit hit;
+
+    // Along an axis from outside of the grid, with a direction that is not normalized
+    CHECK(grid.Raycast({ .Origin = XMFLOAT3(-5.5f, 10.5f, 20.5f), .Direction = XMFLOAT3(4.0f, 0.0f, 0.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(isEqual(hit.Cell, XMINT3(20, 10, 20)) && isEqual(hit.Normal, XMINT3(-1, 0, 0)));
+    CHECK(std::fabs(hit.Distance - 25.5f) < 1e-4f);
+    CHECK(hit.BlockType == eBlockType::SAND);
+
+    // From above, the top face is hit
+    CHECK(grid.Raycast({ .Origin = XMFLOAT3(20.5f, 30.0f, 20.5f), .Direction = XMFLOAT3(0.0f, -1.0f, 0.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(isEqual(hit.Normal, XMINT3(0, 1, 0)) && std::fabs(hit.Distance - 19.0f) < 1e-4f);
+
+    // A ray too short to reach the block
+    CHECK(!grid.Raycast({ .Origin = XMFLOAT3(10.5f, 10.5f, 20.5f), .Direction = XMFLOAT3(1.0f, 0.0f, 0.0f), .MaxDistance = 9.0f }, hit));
+    CHECK(!hit.bHit && hit.Distance == 9.0f);
+    CHECK(grid.Raycast({ .Origin = XMFLOAT3(10.5f, 10.5f, 20.5f), .Direction = XMFLOAT3(1.0f, 0.0f, 0.0f), .MaxDistance = 9.75f }, hit));
+
+    // Starting inside of the block hits it at once, without a face
+    CHECK(grid.Raycast({ .Origin = XMFLOAT3(20.25f, 10.5f, 20.75f), .Direction = XMFLOAT3(0.3f, 0.2f, -0.1f), .MaxDistance = 100.0f }, hit));
+    CHECK(isEqual(hit.Cell, XMINT3(20, 10, 20)) && isEqual(hit.Normal, XMINT3(0, 0, 0)) && hit.Distance == 0.0f);
+
+    // Rays that miss the grid, run parallel to it outside, or have no direction
+    CHECK(!grid.Raycast({ .Origin = XMFLOAT3(-5.0f, 10.5f, 20.5f), .Direction = XMFLOAT3(-1.0f, 0.0f, 0.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(!grid.Raycast({ .Origin = XMFLOAT3(-1.0f, 10.5f, 20.5f), .Direction = XMFLOAT3(0.0f, 0.0f, 1.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(!grid.Raycast({ .Origin = XMFLOAT3(20.5f, 10.5f, 10.5f), .Direction = XMFLOAT3(0.0f, 0.0f, 0.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(!grid.Raycast({ .Origin = XMFLOAT3(20.5f, 10.5f, 10.5f), .Direction = XMFLOAT3(0.0f, 0.0f, 1.0f), .MaxDistance = -1.0f }, hit));
+
+    // Diagonal through the corner region of two chunks
+    grid.SetBlock(16, 16, 16, eBlockType::SAND);
+    CHECK(grid.Raycast({ .Origin = XMFLOAT3(0.5f, 0.75f, 0.6f), .Direction = XMFLOAT3(1.0f, 1.0f, 1.0f), .MaxDistance = 100.0f }, hit));
+    CHECK(isEqual(hit.Cell, XMINT3(16, 16, 16)) && isEqual(hit.Normal, XMINT3(-1, 0, 0)));
+}
+
+TEST_CASE(VoxelGridRaycastBatchMatchesRaycast)
+{
+    VoxelGrid grid;
+    std::vector<XMINT3> aSolidCells;
+    makeSparseGrid(3u, 0.02f, grid, aSolidCells);
+
+    // Not a multiple of the rays per task
+    std::vector<VoxelRay> aRays = makeRandomRays(9u, 10001u);
+    std::vector<VoxelRayHit> aHits(aRays.size());
+    ThreadPool threadPool(4u);
+
+    for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+    {
+        grid.RaycastBatch(aRays.data(), aHits.data(), static_cast<UINT>(aRays.size()), pThreadPool);
+
+        UINT uNumMismatches = 0u;
+        for (size_t i = 0u; i < aRays.size(); ++i)
+        {
+            VoxelRayHit hit;
+            grid.Raycast(aRays[i], hit);
+            if (hit.bHit != aHits[i].bHit || !isEqual(hit.Cell, aHits[i].Cell) || !isEqual(hit.Normal, aHits[i].Normal) || hit.Distance != aHits[i].Distance)
+            {
+                ++uNumMismatches;
+            }
+        }
+        CHECK(uNumMismatches == 0u);
+    }
+}
+
+BENCHMARK(VoxelGridRaycastPerformance)
+{
+    constexpr const UINT MAP_SIZE = 512u;
+    constexpr const UINT MAP_HEIGHT = 64u;
+    constexpr const UINT NUM_RAYS = 1u << 20u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(7u).Generate(MAP_SIZE, MAP_HEIGHT, MAP_SIZE, terrain)))
+    {
+        return;
+    }
+    VoxelGrid grid;
+    grid.FillTerrain(terrain);
+
+    // Picking rays from above the terrain, and long rays skimming along it
+    std::mt19937 random(1u);
+    std::uniform_real_distribution<FLOAT> position(0.0f, static_cast<FLOAT>(MAP_SIZE));
+    std::uniform_real_distribution<FLOAT> direction(-1.0f, 1.0f);
+    std::vector<VoxelRay> aPickingRays(NUM_RAYS);
+    std::vector<VoxelRay> aSkimmingRays(NUM_RAYS);
+    for (UINT i = 0u; i < NUM_RAYS; ++i)
+    {
+        aPickingRays[i] =
+        {
+            .Origin = XMFLOAT3(position(random), static_cast<FLOAT>(MAP_HEIGHT) + 2.0f, position(random)),
+            .Direction = XMFLOAT3(direction(random), -1.0f, direction(random)),
+            .MaxDistance = 128.0f
+        };
+        aSkimmingRays[i] =
+        {
+            .Origin = XMFLOAT3(position(random), static_cast<FLOAT>(MAP_HEIGHT) * 0.5f, position(random)),
+            .Direction = XMFLOAT3(direction(random), 0.05f * direction(random), direction(random)),
+            .MaxDistance = 256.0f
+        };
+    }
+
+    std::vector<VoxelRayHit> aHits(NUM_RAYS);
+    ThreadPool threadPool(ThreadPool::GetDefaultNumThreads());
+    for (const std::vector<VoxelRay>* pRays : { &aPickingRays, &aSkimmingRays })
+    {
+        PCSTR pszRays = pRays == &aPickingRays ? "picking" : "skimming";
+        for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+        {
+            DOUBLE time = context.MeasureMilliseconds(3u, [&]()
+            {
+                grid.RaycastBatch(pRays->data(), aHits.data(), NUM_RAYS, pThreadPool);
+            });
+
+            CHAR szName[64];
+            sprintf_s(szName, "%s rays, %s", pszRays, pThreadPool ? "thread pool" : "single thread");
+            context.Report(szName, NUM_RAYS / time / 1000.0, "Mrays/s");
+        }
+
+        UINT uNumHits = 0u;
+        DOUBLE totalDistance = 0.0;
+        for (const VoxelRayHit& hit : aHits)
+        {
+            uNumHits += hit.bHit ? 1u : 0u;
+            totalDistance += hit.Distance;
+        }
+        CHAR szName[64];
+        sprintf_s(szName, "%s rays hit rate", pszRays);
+        context.Report(szName, 100.0 * uNumHits / NUM_RAYS, "%");
+        sprintf_s(szName, "%s rays average distance", pszRays);
+        context.Report(szName, totalDistance / NUM_RAYS, "cells");
+    }
+}
@@ -0,0 +1,265 @@
+#include "Harness/TestRegistry.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+
+#include "Scene/TerrainGenerator.h"
+#include "Scene/VoxelGrid.h"
+#include "Scene/VoxelLight.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const INT GRID_SIZE = 40;
+    constexpr const INT GRID_HEIGHT = 36;
+    constexpr const UINT NUM_EDIT_BATCHES = 200u;
+    constexpr const UINT MAX_EDITS_PER_BATCH = 6u;
+    constexpr const eBlockType GROUND = eBlockType::GRASSLAND;
+    constexpr const eBlockType BRIGHT_EMITTER = eBlockType::SNOW;
+    constexpr const eBlockType DIM_EMITTER = eBlockType::SAND;
+
+    void setEmissions(_Inout_ VoxelLight& light)
+    {
+        light.SetEmission(BRIGHT_EMITTER, VoxelLight::MAX_LEVEL - 1u);
+        light.SetEmission(DIM_EMITTER, 6u);
+    }
+
+    // Rolling ground with air pockets under it, so the sky reaches some of the caves and not others
+    void buildGrid(_Inout_ VoxelGrid& grid, _Inout_ std::mt19937& random)
+    {
+        grid.Initialize(GRID_SIZE, GRID_HEIGHT, GRID_SIZE);
+        for (INT z = 0; z < GRID_SIZE; ++z)
+        {
+            for (INT x = 0; x < GRID_SIZE; ++x)
+            {
+                INT iHeight = 16 + static_cast<INT>(6.0f * sinf(0.3f * static_cast<FLOAT>(x)) * cosf(0.2f * static_cast<FLOAT>(z)));
+                for (INT y = 0; y < iHeight; ++y)
+                {
+                    grid.SetBlock(x, y, z, GROUND);
+                }
+            }
+        }
+
+        std::uniform_int_distribution<INT> horizontal(0, GRID_SIZE - 1);
+        std::uniform_int_distribution<INT> vertical(2, 20);
+        for (UINT uPocketIdx = 0u; uPocketIdx < 12u; ++uPocketIdx)
+        {
+            INT aCenter[3] = { horizontal(random), vertical(random), horizontal(random) };
+            for (INT z = aCenter[2] - 3; z <= aCenter[2] + 3; ++z)
+            {
+                for (INT y = aCenter[1] - 2; y <= aCenter[1] + 2; ++y)
+                {
+                    for (INT x = aCenter[0] - 3; x <= aCenter[0] + 3; ++x)
+                    {
+                        grid.SetBlock(x, y, z, eBlockType::AIR);
+                    }
+                }
+            }
+            grid.SetBlock(aCenter[0], aCenter[1] - 2, aCenter[2], uPocketIdx % 2u == 0u ? BRIGHT_EMITTER : DIM_EMITTER);
+        }
+    }
+
+    std::vector<BYTE> readLight(_In_ const VoxelLight& light)
+    {
+        std::vector<BYTE> aLevels(static_cast<size_t>(GRID_SIZE) * GRID_HEIGHT * GRID_SIZE);
+        size_t uCellIdx = 0u;
+        for (INT z = 0; z < GRID_SIZE; ++z)
+        {
+            for (INT y = 0; y < GRID_HEIGHT; ++y)
+            {
+                for (INT x = 0; x < GRID_SIZE; ++x)
+                {
+                    aLevels[uCellIdx++] = light.GetLight(x, y, z);
+                }
+            }
+        }
+
+        return aLevels;
+    }
+
+    UINT64 getCellKey(_In_ INT x, _In_ INT y, _In_ INT z)
+    {
+        return (static_cast<UINT64>(static_cast<UINT>(z)) << 40u) | (static_cast<UINT64>(static_cast<UINT>(y)) << 20u) | static_cast<UINT>(x);
+    }
+
+    // Mostly cells between air and blocks, on the ground and the walls of the pockets, where the light changes
+    XMINT3 pickEditCell(_In_ const VoxelGrid& grid, _Inout_ std::mt19937& random)
+    {
+        static constexpr const INT DIRECTIONS[6][3] =
+        {
+            { 0, 1, 0 }, { 0, -1, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+        };
+
+        std::uniform_int_distribution<INT> horizontal(0, GRID_SIZE - 1);
+        std::uniform_int_distribution<INT> vertical(0, GRID_HEIGHT - 1);
+        BOOL bAnyCell = random() % 4u == 0u;
+        XMINT3 cell;
+        for (UINT uTryIdx = 0u; uTryIdx < 256u; ++uTryIdx)
+        {
+            cell = XMINT3(horizontal(random), vertical(random), horizontal(random));
+            BOOL bSolid = grid.IsSolid(cell.x, cell.y, cell.z);
+            for (const INT* aDirection : DIRECTIONS)
+            {
+                if (bAnyCell || grid.IsSolid(cell.x + aDirection[0], cell.y + aDirection[1], cell.z + aDirection[2]) != bSolid)
+                {
+                    return cell;
+                }
+            }
+        }
+
+        return cell;
+    }
+
+    eBlockType pickEditBlock(_Inout_ std::mt19937& random)
+    {
+        switch (random() % 8u)
+        {
+        case 0u:
+        case 1u:
+        case 2u:
+            return eBlockType::AIR;
+        case 3u:
+        case 4u:
+            return GROUND;
+        case 5u:
+        case 6u:
+            return BRIGHT_EMITTER;
+        default:
+            return DIM_EMITTER;
+        }
+    }
+}
+
+TEST_CASE(VoxelLightUpdateMatchesFullRelight)
+{
+    std::mt19937 random(11u);
+    VoxelGrid grid;
+    buildGrid(grid, random);
+    VoxelLight light;
+    setEmissions(light);
+    light.Initialize(grid);
+    std::vector<BYTE> aLevels = readLight(light);
+
+    std::vector<XMINT3> aEditedCells;
+    std::vector<XMINT3> aChangedCells;
+    for (UINT uBatchIdx = 0u; uBatchIdx < NUM_EDIT_BATCHES; ++uBatchIdx)
+    {
+        // Places and removes blocks and emitters, several at once from time to time
+        aEditedCells.clear();
+        UINT uNumEdits = uBatchIdx % 4u == 3u ? 1u + random() % MAX_EDITS_PER_BATCH : 1u;
+        for (UINT uEditIdx = 0u; uEditIdx < uNumEdits; ++uEditIdx)
+        {
+            XMINT3 cell = pickEditCell(grid, random);
+            grid.SetBlock(cell.x, cell.y, cell.z, pickEditBlock(random));
+            aEditedCells.push_back(cell);
+        }
+        aChangedCells.clear();
+        light.UpdateBlocks(aEditedCells.data(), static_cast<UINT>(aEditedCells.size()), aChangedCells);
+
+        VoxelLight reference;
+        setEmissions(reference);
+        reference.Initialize(grid);
+        std::vector<BYTE> aUpdatedLevels = readLight(light);
+        std::vector<BYTE> aReferenceLevels = readLight(reference);
+
+        // Every cell has the light of a full relight, and every cell whose light changed was reported
+        std::unordered_set<UINT64> changedCells;
+        for (const XMINT3& cell : aChangedCells)
+        {
+            changedCells.insert(getCellKey(cell.x, cell.y, cell.z));
+        }
+        UINT uNumWrongCells = 0u;
+        UINT uNumUnreportedCells = 0u;
+        size_t uCellIdx = 0u;
+        for (INT z = 0; z < GRID_SIZE; ++z)
+        {
+            for (INT y = 0; y < GRID_HEIGHT; ++y)
+            {
+                for (INT x = 0; x < GRID_SIZE; ++x, ++uCellIdx)
+                {
+                    uNumWrongCells += aUpdatedLevels[uCellIdx] != aReferenceLevels[uCellIdx] ? 1u : 0u;
+                    uNumUnreportedCells += aUpdatedLevels[uCellIdx] != aLevels[uCellIdx] && !changedCells.contains(getCellKey(x, y, z)) ? 1u : 0u;
+                }
+            }
+        }
+        CHECK(uNumWrongCells == 0u);
+        CHECK(uNumUnreportedCells == 0u);
+        if (uNumWrongCells > 0u)
+        {
+            return;
+        }
+        aLevels = std::move(aUpdatedLevels);
+    }
+}
+
+BENCHMARK(VoxelLightRelightPerEdit)
+{
+    constexpr const UINT MAP_SIZE = 256u;
+    constexpr const UINT MAP_HEIGHT = 64u;
+    constexpr const UINT NUM_EDITS = 2000u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(7u).Generate(MAP_SIZE, MAP_HEIGHT, MAP_SIZE, terrain)))
+    {
+        return;
+    }
+    VoxelGrid grid;
+    grid.FillTerrain(terrain);
+    VoxelLight light;
+    setEmissions(light);
+
+    DOUBLE initializeTime = context.MeasureMilliseconds(3u, [&]()
+    {
+        light.Initialize(grid);
+    });
+    context.Report("full relight", initializeTime, "ms");
+
+    // Digs into the ground under the sky and fills the hole again, then places an emitter and removes it
+    std::mt19937 random(5u);
+    std::uniform_int_distribution<INT> horizontal(1, static_cast<INT>(MAP_SIZE) - 2);
+    std::vector<XMINT3> aCells(NUM_EDITS);
+    for (XMINT3& cell : aCells)
+    {
+        cell.x = horizontal(random);
+        cell.z = horizontal(random);
+        cell.y = static_cast<INT>(MAP_HEIGHT) - 1;
+        while (cell.y > 0 && !grid.IsSolid(cell.x, cell.y, cell.z))
+        {
+            --cell.y;
+        }
+    }
+
+    std::vector<XMINT3> aChangedCells;
+    size_t uNumChangedCells = 0u;
+    for (eBlockType placedBlock : { eBlockType::AIR, BRIGHT_EMITTER })
+    {
+        std::vector<eBlockType> aOldBlocks(NUM_EDITS);
+        DOUBLE time = context.MeasureMilliseconds(1u, [&]()
+        {
+            uNumChangedCells = 0u;
+            for (UINT uEditIdx = 0u; uEditIdx < NUM_EDITS; ++uEditIdx)
+            {
+                const XMINT3& cell = aCells[uEditIdx];
+                aOldBlocks[uEditIdx] = grid.GetBlock(cell.x, cell.y, cell.z);
+                grid.SetBlock(cell.x, cell.y, cell.z, placedBlock);
+                aChangedCells.clear();
+                light.UpdateBlocks(&cell, 1u, aChangedCells);
+                uNumChangedCells += aChangedCells.size();
+
+                grid.SetBlock(cell.x, cell.y, cell.z, aOldBlocks[uEditIdx]);
+                aChangedCells.clear();
+                light.UpdateBlocks(&cell, 1u, aChangedCells);
+                uNumChangedCells += aChangedCells.size();
+            }
+        });
+
+        CHAR szName[64];
+        sprintf_s(szName, "%s, relight per edit", placedBlock == eBlockType::AIR ? "dig" : "emitter");
+        context.Report(szName, 1000.0 * time / (2.0 * NUM_EDITS), "us");
+        sprintf_s(szName, "%s, changed cells per edit", placedBlock == eBlockType::AIR ? "dig" : "emitter");
+        context.Report(szName, static_cast<DOUBLE>(uNumChangedCells) / (2.0 * NUM_EDITS), "cells");
+    }
+}
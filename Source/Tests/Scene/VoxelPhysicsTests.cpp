@@ -0,0 +1,400 @@
+#include "Harness/TestRegistry.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "Scene/Scene.h"
+#include "Scene/TerrainGenerator.h"
+#include "Scene/VoxelPhysics.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const UINT MAP_SIZE = 32u;
+    constexpr const UINT MAP_HEIGHT = 16u;
+    constexpr const INT GROUND_HEIGHT = 4;
+    constexpr const FLOAT WALK_SPEED = 10.0f;
+    constexpr const FLOAT JUMP_SPEED = 12.0f;
+    constexpr const FLOAT FRAME_TIME = 1.0f / 60.0f;
+    constexpr const FLOAT POSITION_TOLERANCE = 1e-3f;
+    constexpr const XMFLOAT3 HALF_EXTENTS = XMFLOAT3(0.6f, 1.8f, 0.6f);
+
+    // Flat ground GROUND_HEIGHT blocks thick, with a color for every block type so the scene accepts edits of any of them
+    TerrainData makeFlatTerrain()
+    {
+        TerrainData terrain;
+        terrain.Resize(MAP_SIZE, MAP_HEIGHT, MAP_SIZE);
+        terrain.aHeights.assign(terrain.GetNumCells(), static_cast<FLOAT>(GROUND_HEIGHT) / static_cast<FLOAT>(MAP_HEIGHT));
+        terrain.aColors.assign(static_cast<size_t>(eBlockType::COUNT) - static_cast<size_t>(eBlockType::GRASSLAND), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+
+        return terrain;
+    }
+
+    // World coordinate of a boundary between cells, the cubes of the cells are 2 units wide and the scene centers the map
+    FLOAT getWorldX(_In_ INT x)
+    {
+        return 2.0f * static_cast<FLOAT>(x) - 1.0f - static_cast<FLOAT>(MAP_SIZE);
+    }
+
+    FLOAT getWorldY(_In_ INT y)
+    {
+        return 2.0f * static_cast<FLOAT>(y) - 1.0f - 1.25f * static_cast<FLOAT>(MAP_HEIGHT);
+    }
+
+    FLOAT getWorldZ(_In_ INT z)
+    {
+        return 2.0f * static_cast<FLOAT>(z) - 1.0f - static_cast<FLOAT>(MAP_SIZE);
+    }
+
+    VoxelBody makeBody(_In_ FLOAT x, _In_ FLOAT bottom, _In_ FLOAT z)
+    {
+        return VoxelBody
+        {
+            .Position = XMFLOAT3(x, bottom + HALF_EXTENTS.y, z),
+            .HalfExtents = HALF_EXTENTS,
+            .Velocity = XMFLOAT3(0.0f, 0.0f, 0.0f),
+            .GravityScale = 1.0f,
+            .ContactMask = 0u
+        };
+    }
+
+    HRESULT fillBlocks(_In_ Scene& scene, _In_ INT minX, _In_ INT minY, _In_ INT minZ, _In_ INT maxX, _In_ INT maxY, _In_ INT maxZ)
+    {
+        return scene.FillRegion(minX, minY, minZ, maxX, maxY, maxZ, eBlockType::BARE);
+    }
+
+    // Runs frames of FRAME_TIME, the script sets the velocity of the body before every frame like Renderer::HandleInput
+    template <class Script>
+    void runFrames(_In_ VoxelPhysics& physics, _In_ const Scene& scene, _Inout_ VoxelBody& body, _In_ UINT uNumFrames, _In_ Script script)
+    {
+        for (UINT uFrame = 0u; uFrame < uNumFrames; ++uFrame)
+        {
+            script(body);
+            physics.Update(scene, &body, 1u, FRAME_TIME);
+        }
+    }
+
+    BOOL isOnGround(_In_ const VoxelBody& body, _In_ FLOAT groundY)
+    {
+        return (body.ContactMask & Voxel::FACE_NEGATIVE_Y) && std::fabs(body.Position.y - body.HalfExtents.y - groundY) < POSITION_TOLERANCE;
+    }
+
+    // Brute force test of a body against every cell it covers, the skin of the sweep may touch but not enter a block
+    BOOL overlapsBlock(_In_ const VoxelGrid& grid, _In_ const XMFLOAT3& gridCenter, _In_ const XMFLOAT3& gridHalfExtents)
+    {
+        constexpr const FLOAT SKIN = VoxelGrid::SWEEP_SKIN;
+        INT minX = static_cast<INT>(std::floor(gridCenter.x - gridHalfExtents.x + SKIN));
+        INT maxX = static_cast<INT>(std::floor(gridCenter.x + gridHalfExtents.x - SKIN));
+        INT minY = static_cast<INT>(std::floor(gridCenter.y - gridHalfExtents.y + SKIN));
+        INT maxY = static_cast<INT>(std::floor(gridCenter.y + gridHalfExtents.y - SKIN));
+        INT minZ = static_cast<INT>(std::floor(gridCenter.z - gridHalfExtents.z + SKIN));
+        INT maxZ = static_cast<INT>(std::floor(gridCenter.z + gridHalfExtents.z - SKIN));
+        for (INT z = minZ; z <= maxZ; ++z)
+        {
+            for (INT y = minY; y <= maxY; ++y)
+            {
+                for (INT x = minX; x <= maxX; ++x)
+                {
+                    if (grid.IsSolid(x, y, z))
+                    {
+                        return TRUE;
+                    }
+                }
+            }
+        }
+
+        return FALSE;
+    }
+}
+
+TEST_CASE(VoxelPhysicsBodyLandsOnGround)
+{
+    Scene scene(makeFlatTerrain());
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(0.3f, getWorldY(GROUND_HEIGHT) + 20.0f, -0.7f);
+
+    runFrames(physics, scene, body, 120u, [](VoxelBody&) {});
+
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+    CHECK(body.Velocity.y == 0.0f);
+    CHECK(body.Position.x == 0.3f && body.Position.z == -0.7f);
+
+    // Resting on the ground is stable, the gravity of every step is cancelled by the contact
+    runFrames(physics, scene, body, 60u, [](VoxelBody&) {});
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+}
+
+TEST_CASE(VoxelPhysicsFallIsNotFasterThanMaxFallSpeed)
+{
+    Scene scene(makeFlatTerrain());
+    VoxelPhysics physics;
+    physics.SetGravity(10000.0f);
+    VoxelBody body = makeBody(0.0f, getWorldY(MAP_HEIGHT) + 200.0f, 0.0f);
+
+    runFrames(physics, scene, body, 1u, [](VoxelBody&) {});
+    CHECK(body.Velocity.y == -VoxelPhysics::MAX_FALL_SPEED);
+
+    runFrames(physics, scene, body, 300u, [](VoxelBody&) {});
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+
+    // A single sweep far longer than the ground is thick stops on it instead of tunneling through
+    XMFLOAT3 move;
+    XMFLOAT3 start(0.0f, getWorldY(MAP_HEIGHT) + HALF_EXTENTS.y, 0.0f);
+    CHECK(scene.SweepBox(start, HALF_EXTENTS, XMFLOAT3(0.0f, -1000.0f, 0.0f), move) == Voxel::FACE_NEGATIVE_Y);
+    CHECK(std::fabs(start.y + move.y - HALF_EXTENTS.y - getWorldY(GROUND_HEIGHT)) < POSITION_TOLERANCE);
+}
+
+TEST_CASE(VoxelPhysicsWalkStopsAtWall)
+{
+    Scene scene(makeFlatTerrain());
+    CHECK_HR(fillBlocks(scene, 20, GROUND_HEIGHT, 0, 20, GROUND_HEIGHT + 3, MAP_SIZE - 1));
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(getWorldX(10), getWorldY(GROUND_HEIGHT), 0.5f);
+
+    runFrames(physics, scene, body, 180u, [](VoxelBody& body) { body.Velocity.x = WALK_SPEED; });
+
+    CHECK(body.ContactMask & Voxel::FACE_POSITIVE_X);
+    CHECK(std::fabs(body.Position.x + body.HalfExtents.x - getWorldX(20)) < POSITION_TOLERANCE);
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+    CHECK(body.Position.z == 0.5f);
+}
+
+TEST_CASE(VoxelPhysicsSlidesAlongWall)
+{
+    Scene scene(makeFlatTerrain());
+    CHECK_HR(fillBlocks(scene, 0, GROUND_HEIGHT, 20, MAP_SIZE - 1, GROUND_HEIGHT + 3, 20));
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(getWorldX(4), getWorldY(GROUND_HEIGHT), getWorldZ(18));
+
+    // Walking diagonally into the wall keeps the move along it
+    runFrames(physics, scene, body, 60u, [](VoxelBody& body)
+    {
+        body.Velocity.x = WALK_SPEED * 0.70710678f;
+        body.Velocity.z = WALK_SPEED * 0.70710678f;
+    });
+
+    CHECK(body.ContactMask & Voxel::FACE_POSITIVE_Z);
+    CHECK(std::fabs(body.Position.z + body.HalfExtents.z - getWorldZ(20)) < POSITION_TOLERANCE);
+    CHECK(std::fabs(body.Position.x - getWorldX(4) - WALK_SPEED * 0.70710678f) < POSITION_TOLERANCE * 10.0f);
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+}
+
+TEST_CASE(VoxelPhysicsJumpsOntoStep)
+{
+    Scene scene(makeFlatTerrain());
+    CHECK_HR(fillBlocks(scene, 20, GROUND_HEIGHT, 0, MAP_SIZE - 1, GROUND_HEIGHT, MAP_SIZE - 1));
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(getWorldX(14), getWorldY(GROUND_HEIGHT), 0.0f);
+
+    // Walk against the step and jump once the body stands in front of it
+    UINT uNumJumps = 0u;
+    runFrames(physics, scene, body, 240u, [&uNumJumps](VoxelBody& body)
+    {
+        body.Velocity.x = WALK_SPEED * 0.5f;
+        if ((body.ContactMask & Voxel::FACE_POSITIVE_X) && (body.ContactMask & Voxel::FACE_NEGATIVE_Y))
+        {
+            body.Velocity.y = JUMP_SPEED;
+            ++uNumJumps;
+        }
+    });
+
+    CHECK(uNumJumps == 1u);
+    CHECK(body.Position.x - body.HalfExtents.x > getWorldX(20));
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT + 1)));
+}
+
+TEST_CASE(VoxelPhysicsCeilingStopsJump)
+{
+    Scene scene(makeFlatTerrain());
+    CHECK_HR(fillBlocks(scene, 8, GROUND_HEIGHT + 2, 8, 12, GROUND_HEIGHT + 2, 12));
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(getWorldX(10), getWorldY(GROUND_HEIGHT), getWorldZ(10));
+    body.Velocity.y = JUMP_SPEED;
+
+    BOOL bHitCeiling = FALSE;
+    FLOAT maxTop = -FLT_MAX;
+    for (UINT uFrame = 0u; uFrame < 120u; ++uFrame)
+    {
+        physics.Update(scene, &body, 1u, FRAME_TIME);
+        bHitCeiling |= (body.ContactMask & Voxel::FACE_POSITIVE_Y) ? TRUE : FALSE;
+        maxTop = body.Position.y + body.HalfExtents.y > maxTop ? body.Position.y + body.HalfExtents.y : maxTop;
+    }
+
+    CHECK(bHitCeiling);
+    CHECK(maxTop <= getWorldY(GROUND_HEIGHT + 2) + POSITION_TOLERANCE);
+    CHECK(std::fabs(maxTop - getWorldY(GROUND_HEIGHT + 2)) < POSITION_TOLERANCE);
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+}
+
+TEST_CASE(VoxelPhysicsIsFrameRateIndependent)
+{
+    Scene scene(makeFlatTerrain());
+    CHECK_HR(fillBlocks(scene, 20, GROUND_HEIGHT, 0, MAP_SIZE - 1, GROUND_HEIGHT, MAP_SIZE - 1));
+
+    // A jump into a walk against a step and along it, at 30, 60 and 120 frames per second, makes the same fixed steps
+    VoxelBody aBodies[3];
+    UINT aNumSteps[3] = {};
+    const UINT aFramesPerStep[3] = { 1u, 2u, 4u };
+    for (UINT i = 0u; i < 3u; ++i)
+    {
+        VoxelPhysics physics;
+        VoxelBody& body = aBodies[i];
+        body = makeBody(getWorldX(14), getWorldY(GROUND_HEIGHT), 0.0f);
+        body.Velocity = XMFLOAT3(WALK_SPEED, JUMP_SPEED, 0.3f * WALK_SPEED);
+
+        FLOAT deltaTime = 2.0f * FRAME_TIME / static_cast<FLOAT>(aFramesPerStep[i]);
+        for (UINT uFrame = 0u; uFrame < 120u * aFramesPerStep[i]; ++uFrame)
+        {
+            aNumSteps[i] += physics.Update(scene, &body, 1u, deltaTime);
+        }
+    }
+
+    CHECK(aNumSteps[0] == 240u && aNumSteps[1] == 240u && aNumSteps[2] == 240u);
+    CHECK(std::memcmp(&aBodies[0], &aBodies[1], sizeof(VoxelBody)) == 0);
+    CHECK(std::memcmp(&aBodies[0], &aBodies[2], sizeof(VoxelBody)) == 0);
+    CHECK(std::fabs(aBodies[0].Position.x + HALF_EXTENTS.x - getWorldX(20)) < POSITION_TOLERANCE);
+    CHECK(std::fabs(aBodies[0].Position.z - 4.0f * 0.3f * WALK_SPEED) < POSITION_TOLERANCE * 10.0f);
+    CHECK(isOnGround(aBodies[0], getWorldY(GROUND_HEIGHT)));
+}
+
+TEST_CASE(VoxelPhysicsUpdateDropsTimeAfterHitch)
+{
+    Scene scene(makeFlatTerrain());
+    VoxelPhysics physics;
+    VoxelBody body = makeBody(0.0f, getWorldY(GROUND_HEIGHT), 0.0f);
+
+    CHECK(physics.Update(scene, &body, 1u, 0.5f * VoxelPhysics::FIXED_TIME_STEP) == 0u);
+    CHECK(physics.Update(scene, &body, 1u, 0.5f * VoxelPhysics::FIXED_TIME_STEP) == 1u);
+    CHECK(physics.Update(scene, &body, 1u, 1.0f) == VoxelPhysics::MAX_STEPS_PER_UPDATE);
+    CHECK(physics.Update(scene, &body, 1u, 0.0f) == 0u);
+    CHECK(isOnGround(body, getWorldY(GROUND_HEIGHT)));
+}
+
+TEST_CASE(VoxelPhysicsBatchStaysOutOfBlocks)
+{
+    constexpr const UINT NUM_BODIES = 1000u;
+    constexpr const UINT NUM_STEPS = 240u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(3u).Generate(64u, 32u, 64u, terrain)))
+    {
+        return;
+    }
+    Scene scene(terrain);
+    const VoxelGrid& grid = scene.GetVoxelGrid();
+
+    // Bodies dropped from above the map, walking in random directions that change every second
+    std::mt19937 random(5u);
+    std::uniform_real_distribution<FLOAT> unit(0.0f, 1.0f);
+    std::vector<VoxelBody> aBodies(NUM_BODIES);
+    std::vector<XMFLOAT2> aVelocities(NUM_BODIES * (NUM_STEPS / 60u + 1u));
+    for (UINT i = 0u; i < NUM_BODIES; ++i)
+    {
+        FLOAT x = (unit(random) - 0.5f) * 2.0f * 60.0f;
+        FLOAT z = (unit(random) - 0.5f) * 2.0f * 60.0f;
+        aBodies[i] = makeBody(x, 2.0f * 32.0f, z);
+        aBodies[i].HalfExtents = XMFLOAT3(0.2f + unit(random), 0.2f + 2.0f * unit(random), 0.2f + unit(random));
+    }
+    for (XMFLOAT2& velocity : aVelocities)
+    {
+        velocity = XMFLOAT2((unit(random) - 0.5f) * 4.0f * WALK_SPEED, (unit(random) - 0.5f) * 4.0f * WALK_SPEED);
+    }
+
+    std::vector<VoxelBody> aPooledBodies = aBodies;
+    ThreadPool threadPool(4u);
+    VoxelPhysics physics;
+    UINT uNumOverlaps = 0u;
+    UINT uNumMismatches = 0u;
+    for (UINT uStep = 0u; uStep < NUM_STEPS; ++uStep)
+    {
+        for (UINT i = 0u; i < NUM_BODIES; ++i)
+        {
+            const XMFLOAT2& velocity = aVelocities[(uStep / 60u) * NUM_BODIES + i];
+            aBodies[i].Velocity.x = aPooledBodies[i].Velocity.x = velocity.x;
+            aBodies[i].Velocity.z = aPooledBodies[i].Velocity.z = velocity.y;
+        }
+        physics.Step(scene, aBodies.data(), NUM_BODIES);
+        physics.Step(scene, aPooledBodies.data(), NUM_BODIES, &threadPool);
+
+        for (UINT i = 0u; i < NUM_BODIES; ++i)
+        {
+            const VoxelBody& body = aBodies[i];
+            if (std::memcmp(&body, &aPooledBodies[i], sizeof(VoxelBody)) != 0)
+            {
+                ++uNumMismatches;
+            }
+
+            // Same mapping as Scene::SweepBox
+            XMFLOAT3 gridCenter(
+                (body.Position.x + static_cast<FLOAT>(terrain.uWidth) + 1.0f) * 0.5f,
+                (body.Position.y + 1.25f * static_cast<FLOAT>(terrain.uHeight) + 1.0f) * 0.5f,
+                (body.Position.z + static_cast<FLOAT>(terrain.uDepth) + 1.0f) * 0.5f
+            );
+            XMFLOAT3 gridHalfExtents(body.HalfExtents.x * 0.5f, body.HalfExtents.y * 0.5f, body.HalfExtents.z * 0.5f);
+            if (overlapsBlock(grid, gridCenter, gridHalfExtents))
+            {
+                ++uNumOverlaps;
+            }
+        }
+    }
+
+    CHECK(uNumMismatches == 0u);
+    CHECK(uNumOverlaps == 0u);
+}
+
+BENCHMARK(VoxelPhysicsStepPerformance)
+{
+    constexpr const UINT MAP_WIDTH = 256u;
+    constexpr const UINT NUM_BODIES = 16384u;
+    constexpr const UINT NUM_STEPS = 60u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(7u).Generate(MAP_WIDTH, 64u, MAP_WIDTH, terrain)))
+    {
+        return;
+    }
+    Scene scene(terrain);
+
+    std::mt19937 random(1u);
+    std::uniform_real_distribution<FLOAT> position(-static_cast<FLOAT>(MAP_WIDTH), static_cast<FLOAT>(MAP_WIDTH));
+    std::uniform_real_distribution<FLOAT> direction(-1.0f, 1.0f);
+    std::vector<VoxelBody> aStartBodies(NUM_BODIES);
+    for (VoxelBody& body : aStartBodies)
+    {
+        body = makeBody(position(random), 64.0f, position(random));
+        body.Velocity = XMFLOAT3(WALK_SPEED * direction(random), 0.0f, WALK_SPEED * direction(random));
+    }
+
+    // Let the bodies land first, so the timed steps walk on the ground
+    VoxelPhysics physics;
+    for (UINT uStep = 0u; uStep < 2u * NUM_STEPS; ++uStep)
+    {
+        physics.Step(scene, aStartBodies.data(), NUM_BODIES);
+    }
+
+    ThreadPool threadPool(ThreadPool::GetDefaultNumThreads());
+    std::vector<VoxelBody> aBodies;
+    for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+    {
+        DOUBLE time = context.MeasureMilliseconds(3u, [&]()
+        {
+            aBodies = aStartBodies;
+            for (UINT uStep = 0u; uStep < NUM_STEPS; ++uStep)
+            {
+                physics.Step(scene, aBodies.data(), NUM_BODIES, pThreadPool);
+            }
+        });
+
+        context.Report(pThreadPool ? "body steps, thread pool" : "body steps, single thread", static_cast<DOUBLE>(NUM_BODIES) * NUM_STEPS / time / 1000.0, "M/s");
+    }
+
+    UINT uNumGrounded = 0u;
+    for (const VoxelBody& body : aBodies)
+    {
+        uNumGrounded += (body.ContactMask & Voxel::FACE_NEGATIVE_Y) ? 1u : 0u;
+    }
+    context.Report("bodies on the ground", 100.0 * uNumGrounded / NUM_BODIES, "%");
+}
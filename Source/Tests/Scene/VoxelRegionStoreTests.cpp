@@ -0,0 +1,305 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <thread>
+
+#include "Scene/VoxelRegionStore.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const UINT NUM_CHUNKS_X = 40u;
+    constexpr const UINT NUM_CHUNKS_Y = 4u;
+    constexpr const UINT NUM_CHUNKS_Z = 40u;
+    constexpr const UINT NUM_BLOCK_TYPES = static_cast<UINT>(eBlockType::COUNT) - static_cast<UINT>(eBlockType::GRASSLAND);
+    constexpr const UINT NUM_VERSION_DIGITS = 4u;
+    constexpr const UINT NUM_DIGIT_CELLS = VoxelGrid::NUM_CHUNK_CELLS / NUM_VERSION_DIGITS;
+
+    // Empty directory of region files, removed again with the store
+    std::filesystem::path makeStoreDirectory(_In_ PCWSTR pszName)
+    {
+        std::filesystem::path directoryPath = std::filesystem::temp_directory_path() / pszName;
+        std::error_code error;
+        std::filesystem::remove_all(directoryPath, error);
+
+        return directoryPath;
+    }
+
+    // Blocks that spell a version in base NUM_BLOCK_TYPES, one digit per quarter of the chunk
+    VoxelChunkBlocks makeVersionedChunk(_In_ const XMUINT3& chunk, _In_ UINT uVersion)
+    {
+        VoxelChunkBlocks chunkBlocks = { .Chunk = chunk, .Blocks = std::vector<eBlockType>(VoxelGrid::NUM_CHUNK_CELLS) };
+        for (UINT uDigitIdx = 0u; uDigitIdx < NUM_VERSION_DIGITS; ++uDigitIdx)
+        {
+            eBlockType blockType = static_cast<eBlockType>(static_cast<UINT>(eBlockType::GRASSLAND) + uVersion % NUM_BLOCK_TYPES);
+            std::fill_n(chunkBlocks.Blocks.begin() + uDigitIdx * NUM_DIGIT_CELLS, NUM_DIGIT_CELLS, blockType);
+            uVersion /= NUM_BLOCK_TYPES;
+        }
+
+        return chunkBlocks;
+    }
+
+    // Version spelled by the blocks of a chunk, UINT_MAX if they are not a whole versioned chunk
+    UINT readVersion(_In_ const std::vector<eBlockType>& aBlocks)
+    {
+        UINT uVersion = 0u;
+        for (UINT uDigitIdx = NUM_VERSION_DIGITS; uDigitIdx-- > 0u;)
+        {
+            eBlockType blockType = aBlocks[uDigitIdx * NUM_DIGIT_CELLS];
+            for (UINT i = 0u; i < NUM_DIGIT_CELLS; ++i)
+            {
+                if (aBlocks[uDigitIdx * NUM_DIGIT_CELLS + i] != blockType)
+                {
+                    return UINT_MAX;
+                }
+            }
+            uVersion = uVersion * NUM_BLOCK_TYPES + (static_cast<UINT>(blockType) - static_cast<UINT>(eBlockType::GRASSLAND));
+        }
+
+        return uVersion;
+    }
+
+    UINT getChunkIndex(_In_ const XMUINT3& chunk)
+    {
+        return (chunk.z * NUM_CHUNKS_Y + chunk.y) * NUM_CHUNKS_X + chunk.x;
+    }
+
+    XMUINT3 makeRandomChunk(_Inout_ std::mt19937& random)
+    {
+        return XMUINT3(random() % NUM_CHUNKS_X, random() % NUM_CHUNKS_Y, random() % NUM_CHUNKS_Z);
+    }
+}
+
+TEST_CASE(VoxelRegionStoreSavesAndReadsChunks)
+{
+    std::filesystem::path directoryPath = makeStoreDirectory(L"VoxelRegionStoreSavesAndReadsChunks");
+    std::vector<UINT> aVersions(static_cast<size_t>(NUM_CHUNKS_X) * NUM_CHUNKS_Y * NUM_CHUNKS_Z, UINT_MAX);
+    {
+        VoxelRegionStore store;
+        if (!CHECK_HR(store.Open(directoryPath, NUM_CHUNKS_X, NUM_CHUNKS_Y, NUM_CHUNKS_Z)))
+        {
+            return;
+        }
+
+        // Several saves over every region, later copies of a chunk replace the earlier ones even within a save
+        std::mt19937 random(3u);
+        UINT uVersion = 0u;
+        for (UINT uSaveIdx = 0u; uSaveIdx < 8u; ++uSaveIdx)
+        {
+            std::vector<VoxelChunkBlocks> aChunks;
+            for (UINT i = 0u; i < 200u; ++i)
+            {
+                XMUINT3 chunk = makeRandomChunk(random);
+                aChunks.push_back(makeVersionedChunk(chunk, ++uVersion));
+                aVersions[getChunkIndex(chunk)] = uVersion;
+            }
+            CHECK_HR(store.SaveAsync(std::move(aChunks)));
+        }
+        CHECK_HR(store.WaitForSaves());
+
+        std::vector<XMUINT3> aStoredChunks;
+        CHECK_HR(store.GetStoredChunks(aStoredChunks));
+        CHECK(aStoredChunks.size() == static_cast<size_t>(std::count_if(aVersions.begin(), aVersions.end(), [](UINT uChunkVersion) { return uChunkVersion != UINT_MAX; })));
+    }
+
+    // The chunks are read back from the files by a new store
+    VoxelRegionStore store;
+    CHECK_HR(store.Open(directoryPath, NUM_CHUNKS_X, NUM_CHUNKS_Y, NUM_CHUNKS_Z));
+    std::vector<eBlockType> aBlocks(VoxelGrid::NUM_CHUNK_CELLS);
+    UINT uNumMismatches = 0u;
+    for (UINT z = 0u; z < NUM_CHUNKS_Z; ++z)
+    {
+        for (UINT y = 0u; y < NUM_CHUNKS_Y; ++y)
+        {
+            for (UINT x = 0u; x < NUM_CHUNKS_X; ++x)
+            {
+                BOOL bFound = FALSE;
+                HRESULT hr = store.ReadChunk(XMUINT3(x, y, z), aBlocks.data(), bFound);
+                UINT uExpectedVersion = aVersions[getChunkIndex(XMUINT3(x, y, z))];
+                if (FAILED(hr) || bFound != (uExpectedVersion != UINT_MAX) || (bFound && readVersion(aBlocks) != uExpectedVersion))
+                {
+                    ++uNumMismatches;
+                }
+            }
+        }
+    }
+    CHECK(uNumMismatches == 0u);
+
+    store.Close();
+    std::error_code error;
+    std::filesystem::remove_all(directoryPath, error);
+}
+
+TEST_CASE(VoxelRegionStoreReadsWhileSaving)
+{
+    constexpr const UINT NUM_SAVES = 64u;
+    constexpr const UINT NUM_CHUNKS_PER_SAVE = 64u;
+
+    std::filesystem::path directoryPath = makeStoreDirectory(L"VoxelRegionStoreReadsWhileSaving");
+    VoxelRegionStore store;
+    if (!CHECK_HR(store.Open(directoryPath, NUM_CHUNKS_X, NUM_CHUNKS_Y, NUM_CHUNKS_Z)))
+    {
+        return;
+    }
+
+    // The frame loop reads chunks while the save thread writes new copies of them, a read sees a whole copy that is never older than the last one it saw
+    std::atomic<BOOL> bSaving(TRUE);
+    std::atomic<UINT> uNumTornReads(0u);
+    std::atomic<UINT> uNumStaleReads(0u);
+    std::atomic<UINT> uNumFailedReads(0u);
+    std::atomic<UINT> uNumFoundReads(0u);
+    std::thread reader([&]()
+    {
+        std::vector<UINT> aLastVersions(static_cast<size_t>(NUM_CHUNKS_X) * NUM_CHUNKS_Y * NUM_CHUNKS_Z, 0u);
+        std::vector<eBlockType> aBlocks(VoxelGrid::NUM_CHUNK_CELLS);
+        std::mt19937 random(11u);
+        while (bSaving.load())
+        {
+            XMUINT3 chunk = makeRandomChunk(random);
+            chunk.x %= 8u;
+            chunk.z %= 8u;
+
+            BOOL bFound = FALSE;
+            if (FAILED(store.ReadChunk(chunk, aBlocks.data(), bFound)))
+            {
+                ++uNumFailedReads;
+                continue;
+            }
+            if (!bFound)
+            {
+                continue;
+            }
+
+            ++uNumFoundReads;
+            UINT uVersion = readVersion(aBlocks);
+            UINT& uLastVersion = aLastVersions[getChunkIndex(chunk)];
+            if (uVersion == UINT_MAX)
+            {
+                ++uNumTornReads;
+            }
+            else if (uVersion < uLastVersion)
+            {
+                ++uNumStaleReads;
+            }
+            else
+            {
+                uLastVersion = uVersion;
+            }
+        }
+    });
+
+    std::mt19937 random(5u);
+    UINT uVersion = 0u;
+    for (UINT uSaveIdx = 0u; uSaveIdx < NUM_SAVES; ++uSaveIdx)
+    {
+        std::vector<VoxelChunkBlocks> aChunks;
+        for (UINT i = 0u; i < NUM_CHUNKS_PER_SAVE; ++i)
+        {
+            XMUINT3 chunk = makeRandomChunk(random);
+            chunk.x %= 8u;
+            chunk.z %= 8u;
+            aChunks.push_back(makeVersionedChunk(chunk, ++uVersion));
+        }
+        CHECK_HR(store.SaveAsync(std::move(aChunks)));
+
+        if (uSaveIdx % 8u == 7u)
+        {
+            CHECK_HR(store.WaitForSaves());
+        }
+    }
+    CHECK_HR(store.WaitForSaves());
+    bSaving.store(FALSE);
+    reader.join();
+
+    CHECK(uNumFoundReads.load() > 0u);
+    CHECK(uNumTornReads.load() == 0u);
+    CHECK(uNumStaleReads.load() == 0u);
+    CHECK(uNumFailedReads.load() == 0u);
+
+    store.Close();
+    std::error_code error;
+    std::filesystem::remove_all(directoryPath, error);
+}
+
+BENCHMARK(VoxelRegionStoreReadLatencyWhileSaving)
+{
+    constexpr const UINT NUM_SAVES = 32u;
+    constexpr const UINT NUM_CHUNKS_PER_SAVE = 256u;
+
+    std::filesystem::path directoryPath = makeStoreDirectory(L"VoxelRegionStoreReadLatencyWhileSaving");
+    VoxelRegionStore store;
+    if (!CHECK_HR(store.Open(directoryPath, NUM_CHUNKS_X, NUM_CHUNKS_Y, NUM_CHUNKS_Z)))
+    {
+        return;
+    }
+
+    // Every chunk is saved once, so the reads find them while the saves replace them
+    std::mt19937 random(1u);
+    UINT uVersion = 0u;
+    std::vector<VoxelChunkBlocks> aChunks;
+    for (UINT z = 0u; z < NUM_CHUNKS_Z; ++z)
+    {
+        for (UINT y = 0u; y < NUM_CHUNKS_Y; ++y)
+        {
+            for (UINT x = 0u; x < NUM_CHUNKS_X; ++x)
+            {
+                aChunks.push_back(makeVersionedChunk(XMUINT3(x, y, z), ++uVersion));
+            }
+        }
+    }
+    CHECK_HR(store.SaveAsync(std::move(aChunks)));
+    CHECK_HR(store.WaitForSaves());
+
+    auto saveStart = std::chrono::steady_clock::now();
+    for (UINT uSaveIdx = 0u; uSaveIdx < NUM_SAVES; ++uSaveIdx)
+    {
+        aChunks.clear();
+        for (UINT i = 0u; i < NUM_CHUNKS_PER_SAVE; ++i)
+        {
+            aChunks.push_back(makeVersionedChunk(makeRandomChunk(random), ++uVersion));
+        }
+        CHECK_HR(store.SaveAsync(std::move(aChunks)));
+    }
+
+    // Reads on the calling thread, like the frame loop, until the saves are written
+    std::vector<eBlockType> aBlocks(VoxelGrid::NUM_CHUNK_CELLS);
+    UINT uNumReads = 0u;
+    DOUBLE totalReadTime = 0.0;
+    DOUBLE maxReadTime = 0.0;
+    std::thread waiter([&store]() { store.WaitForSaves(); });
+    auto saveEnd = saveStart;
+    std::atomic<BOOL> bWaiting(TRUE);
+    std::thread watcher([&]()
+    {
+        waiter.join();
+        saveEnd = std::chrono::steady_clock::now();
+        bWaiting.store(FALSE);
+    });
+    while (bWaiting.load())
+    {
+        BOOL bFound = FALSE;
+        auto readStart = std::chrono::steady_clock::now();
+        store.ReadChunk(makeRandomChunk(random), aBlocks.data(), bFound);
+        DOUBLE readTime = std::chrono::duration<DOUBLE, std::micro>(std::chrono::steady_clock::now() - readStart).count();
+
+        ++uNumReads;
+        totalReadTime += readTime;
+        maxReadTime = readTime > maxReadTime ? readTime : maxReadTime;
+    }
+    watcher.join();
+
+    DOUBLE saveTime = std::chrono::duration<DOUBLE, std::milli>(saveEnd - saveStart).count();
+    context.Report("saved chunks", NUM_SAVES * NUM_CHUNKS_PER_SAVE / saveTime * 1000.0, "chunks/s");
+    context.Report("reads during the saves", uNumReads, "");
+    context.Report("average read", totalReadTime / (uNumReads > 0u ? uNumReads : 1u), "us");
+    context.Report("max read", maxReadTime, "us");
+
+    store.Close();
+    std::error_code error;
+    std::filesystem::remove_all(directoryPath, error);
+}
@@ -0,0 +1,513 @@
+#include "Harness/TestRegistry.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "Scene/Scene.h"
+#include "Scene/TerrainGenerator.h"
+#include "Scene/Voxel.h"
+#include "Scene/VoxelGrid.h"
+#include "Scene/VoxelLight.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const UINT FACE_POSITIVE_Y_IDX = 0u;
+    constexpr const eBlockType EDIT_BLOCKS[] = { eBlockType::GRASSLAND, eBlockType::SNOW, eBlockType::SAND, eBlockType::BARE };
+    constexpr const eBlockType EMITTER = eBlockType::SNOW;
+
+    // Flat ground, with a one block pit and a wall one block high along the x-axis
+    TerrainData makePitAndWallTerrain()
+    {
+        TerrainData terrain;
+        terrain.Resize(32u, 16u, 32u);
+        terrain.aColors.assign(static_cast<size_t>(eBlockType::COUNT) - static_cast<size_t>(eBlockType::GRASSLAND), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+        terrain.aHeights.assign(terrain.GetNumCells(), 4.0f / 16.0f);
+        terrain.aHeights[8u * terrain.uWidth + 8u] = 3.0f / 16.0f;
+        for (UINT z = 0u; z < terrain.uDepth; ++z)
+        {
+            terrain.aHeights[z * terrain.uWidth + 20u] = 5.0f / 16.0f;
+        }
+
+        return terrain;
+    }
+
+    const VoxelInstanceData* findInstance(_In_ const std::vector<VoxelInstanceData>& aInstanceData, _In_ INT x, _In_ INT y, _In_ INT z)
+    {
+        for (const VoxelInstanceData& instance : aInstanceData)
+        {
+            if (instance.X == x && instance.Y == y && instance.Z == z)
+            {
+                return &instance;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Occlusion of the corners of a face, sorted since only the set of values does not depend on the vertex order
+    std::vector<UINT> getSortedOcclusion(_In_ const VoxelInstanceData& instance, _In_ UINT uFaceIdx)
+    {
+        std::vector<UINT> aOcclusion(4u);
+        for (UINT uCornerIdx = 0u; uCornerIdx < 4u; ++uCornerIdx)
+        {
+            aOcclusion[uCornerIdx] = (instance.AmbientOcclusion[uFaceIdx / 4u] >> ((uFaceIdx % 4u) * 8u + uCornerIdx * 2u)) & 3u;
+        }
+        std::sort(aOcclusion.begin(), aOcclusion.end());
+
+        return aOcclusion;
+    }
+
+    // Instances of the blocks a voxel draws, in the order of the cells, without the removed ones
+    std::vector<VoxelInstanceData> getSortedInstances(_In_ const Voxel& voxel)
+    {
+        std::vector<VoxelInstanceData> aInstanceData;
+        for (UINT uInstanceIdx = 0u; uInstanceIdx < voxel.GetNumInstances(); ++uInstanceIdx)
+        {
+            if (voxel.GetInstance(uInstanceIdx).FaceMask != 0u)
+            {
+                aInstanceData.push_back(voxel.GetInstance(uInstanceIdx));
+            }
+        }
+        std::sort(aInstanceData.begin(), aInstanceData.end(), [](const VoxelInstanceData& a, const VoxelInstanceData& b)
+        {
+            if (a.Z != b.Z)
+            {
+                return a.Z < b.Z;
+            }
+            return a.Y != b.Y ? a.Y < b.Y : a.X < b.X;
+        });
+
+        return aInstanceData;
+    }
+
+    BOOL hasSameInstances(_In_ const std::vector<VoxelInstanceData>& aInstanceData, _In_ const std::vector<VoxelInstanceData>& aExpectedInstanceData)
+    {
+        return aInstanceData.size() == aExpectedInstanceData.size()
+            && std::memcmp(aInstanceData.data(), aExpectedInstanceData.data(), aInstanceData.size() * sizeof(VoxelInstanceData)) == 0;
+    }
+
+    // Gives a column of the scene and of its height map a new height and block, as a height map would have them
+    HRESULT setColumn(_Inout_ Scene& scene, _Inout_ TerrainData& terrain, _In_ INT x, _In_ INT z, _In_ UINT uHeight, _In_ eBlockType blockType)
+    {
+        HRESULT hr = scene.FillRegion(x, 0, z, x, static_cast<INT>(uHeight) - 1, z, blockType);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        hr = scene.FillRegion(x, static_cast<INT>(uHeight), z, x, static_cast<INT>(terrain.uHeight) - 1, z, eBlockType::AIR);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        size_t uCellIdx = static_cast<size_t>(z) * terrain.uWidth + static_cast<size_t>(x);
+        terrain.aHeights[uCellIdx] = static_cast<FLOAT>(uHeight) / static_cast<FLOAT>(terrain.uHeight);
+        terrain.aBlockTypes[uCellIdx] = blockType;
+
+        return S_OK;
+    }
+
+    // Faces, occlusion and light of every exposed block of a grid, baked from scratch
+    std::vector<VoxelInstanceData> rebakeGrid(_In_ const VoxelGrid& grid)
+    {
+        VoxelLight light;
+        light.SetEmission(EMITTER, VoxelLight::MAX_LEVEL - 1u);
+        light.Initialize(grid);
+
+        std::vector<VoxelInstanceData> aInstanceData;
+        for (INT z = 0; z < static_cast<INT>(grid.GetDepth()); ++z)
+        {
+            for (INT y = 0; y < static_cast<INT>(grid.GetHeight()); ++y)
+            {
+                for (INT x = 0; x < static_cast<INT>(grid.GetWidth()); ++x)
+                {
+                    UINT uNeighbourMask = grid.GetNeighbourMask(x, y, z);
+                    if (!grid.IsSolid(x, y, z) || Voxel::GetFaceMask(uNeighbourMask) == 0u)
+                    {
+                        continue;
+                    }
+
+                    VoxelInstanceData instance =
+                    {
+                        .X = static_cast<INT16>(x),
+                        .Y = static_cast<INT16>(y),
+                        .Z = static_cast<INT16>(z),
+                        .BlockType = static_cast<BYTE>(grid.GetBlock(x, y, z)),
+                        .FaceMask = Voxel::GetFaceMask(uNeighbourMask)
+                    };
+                    Voxel::BakeAmbientOcclusion(uNeighbourMask, instance);
+                    light.BakeFaceLight(instance);
+                    aInstanceData.push_back(instance);
+                }
+            }
+        }
+
+        return aInstanceData;
+    }
+
+    size_t countFaces(_In_ const std::vector<VoxelInstanceData>& aInstanceData)
+    {
+        size_t uNumFaces = 0u;
+        for (const VoxelInstanceData& instance : aInstanceData)
+        {
+            uNumFaces += static_cast<size_t>(std::popcount(static_cast<UINT>(instance.FaceMask)));
+        }
+
+        return uNumFaces;
+    }
+}
+
+TEST_CASE(VoxelAmbientOcclusionOfPitAndWall)
+{
+    TerrainData terrain = makePitAndWallTerrain();
+    std::vector<VoxelInstanceData> aInstanceData;
+    Voxel::BuildInstanceData(terrain, 0u, 0u, terrain.uWidth, terrain.uDepth, aInstanceData);
+
+    // Open ground is not darkened
+    const VoxelInstanceData* pInstance = findInstance(aInstanceData, 4, 3, 24);
+    if (CHECK(pInstance && pInstance->FaceMask == Voxel::FACE_POSITIVE_Y))
+    {
+        CHECK(getSortedOcclusion(*pInstance, FACE_POSITIVE_Y_IDX) == std::vector<UINT>({ 0u, 0u, 0u, 0u }));
+    }
+
+    // Every corner at the bottom of the pit has two solid side cells
+    pInstance = findInstance(aInstanceData, 8, 2, 8);
+    if (CHECK(pInstance && pInstance->FaceMask == Voxel::FACE_POSITIVE_Y))
+    {
+        CHECK(getSortedOcclusion(*pInstance, FACE_POSITIVE_Y_IDX) == std::vector<UINT>({ 3u, 3u, 3u, 3u }));
+    }
+
+    // In front of the wall the two corners against it have a solid side and a solid diagonal
+    pInstance = findInstance(aInstanceData, 19, 3, 16);
+    if (CHECK(pInstance && pInstance->FaceMask == Voxel::FACE_POSITIVE_Y))
+    {
+        CHECK(getSortedOcclusion(*pInstance, FACE_POSITIVE_Y_IDX) == std::vector<UINT>({ 0u, 0u, 2u, 2u }));
+    }
+}
+
+TEST_CASE(VoxelBuildInstanceDataMatchesGrid)
+{
+    // Not a multiple of the chunk size or the rows per task
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(5u).Generate(100u, 48u, 84u, terrain)))
+    {
+        return;
+    }
+    VoxelGrid grid;
+    grid.FillTerrain(terrain);
+
+    std::vector<VoxelInstanceData> aInstanceData;
+    Voxel::BuildInstanceData(terrain, 0u, 0u, terrain.uWidth, terrain.uDepth, aInstanceData);
+
+    // The bake from the column heights and the rebake of block edits from the grid agree on every exposed block
+    UINT uNumMismatches = 0u;
+    for (const VoxelInstanceData& instance : aInstanceData)
+    {
+        UINT uNeighbourMask = grid.GetNeighbourMask(instance.X, instance.Y, instance.Z);
+        VoxelInstanceData rebaked = instance;
+        rebaked.FaceMask = Voxel::GetFaceMask(uNeighbourMask);
+        Voxel::BakeAmbientOcclusion(uNeighbourMask, rebaked);
+        if (std::memcmp(&rebaked, &instance, sizeof(VoxelInstanceData)) != 0)
+        {
+            ++uNumMismatches;
+        }
+    }
+    CHECK(uNumMismatches == 0u);
+
+    size_t uNumExposedBlocks = 0u;
+    for (INT z = 0; z < static_cast<INT>(terrain.uDepth); ++z)
+    {
+        for (INT y = 0; y < static_cast<INT>(terrain.uHeight); ++y)
+        {
+            for (INT x = 0; x < static_cast<INT>(terrain.uWidth); ++x)
+            {
+                if (grid.IsSolid(x, y, z) && Voxel::GetFaceMask(grid.GetNeighbourMask(x, y, z)) != 0u)
+                {
+                    ++uNumExposedBlocks;
+                }
+            }
+        }
+    }
+    CHECK(uNumExposedBlocks == aInstanceData.size());
+
+    // The thread pool joins its bands in order
+    ThreadPool threadPool(4u);
+    std::vector<VoxelInstanceData> aPooledInstanceData;
+    Voxel::BuildInstanceData(terrain, 0u, 0u, terrain.uWidth, terrain.uDepth, aPooledInstanceData, &threadPool);
+    CHECK(aPooledInstanceData.size() == aInstanceData.size());
+    CHECK(aPooledInstanceData.size() == aInstanceData.size() && std::memcmp(aPooledInstanceData.data(), aInstanceData.data(), aInstanceData.size() * sizeof(VoxelInstanceData)) == 0);
+
+    // A region, like a streamed chunk, sees the columns around it
+    std::vector<VoxelInstanceData> aRegionInstanceData;
+    Voxel::BuildInstanceData(terrain, 16u, 32u, 32u, 32u, aRegionInstanceData);
+    std::vector<VoxelInstanceData> aExpectedInstanceData;
+    for (VoxelInstanceData instance : aInstanceData)
+    {
+        if (instance.X >= 16 && instance.X < 48 && instance.Z >= 32 && instance.Z < 64)
+        {
+            instance.X -= 16;
+            instance.Z -= 32;
+            aExpectedInstanceData.push_back(instance);
+        }
+    }
+    CHECK(aRegionInstanceData.size() == aExpectedInstanceData.size());
+    CHECK(aRegionInstanceData.size() == aExpectedInstanceData.size() && std::memcmp(aRegionInstanceData.data(), aExpectedInstanceData.data(), aExpectedInstanceData.size() * sizeof(VoxelInstanceData)) == 0);
+}
+
+TEST_CASE(SceneInitializeReportsUnreadableHeightMap)
+{
+    // A missing file leaves an empty map, and Initialize fails before it touches the device
+    Scene missingScene(std::filesystem::temp_directory_path() / L"SceneMissingHeightMap.txt");
+    CHECK(missingScene.Initialize(nullptr, nullptr, nullptr) == E_FAIL);
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(3u).Generate(24u, 16u, 20u, terrain)))
+    {
+        return;
+    }
+    std::filesystem::path filePath = std::filesystem::temp_directory_path() / L"SceneHeightMap.txt";
+    if (!CHECK_HR(WriteTerrainData(filePath, terrain)))
+    {
+        return;
+    }
+    TerrainData readTerrain;
+    CHECK_HR(ReadTerrainData(filePath, readTerrain));
+    CHECK(readTerrain.uWidth == terrain.uWidth && readTerrain.uHeight == terrain.uHeight && readTerrain.uDepth == terrain.uDepth);
+    CHECK(readTerrain.aBlockTypes == terrain.aBlockTypes);
+
+    // A file cut off in the middle of its cells is corrupt, not a map with flat ground at its end
+    std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) / 2u);
+    CHECK(ReadTerrainData(filePath, readTerrain) == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+    CHECK(readTerrain.GetNumCells() == 0u);
+    Scene corruptScene(filePath);
+    CHECK(corruptScene.Initialize(nullptr, nullptr, nullptr) == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+    // A file without its dimensions
+    {
+        std::ofstream file(filePath, std::ios::trunc);
+        file << "16 8\n";
+    }
+    CHECK(ReadTerrainData(filePath, readTerrain) == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+    std::error_code error;
+    std::filesystem::remove(filePath, error);
+}
+
+TEST_CASE(SceneBlockEditsMatchRebuiltMap)
+{
+    constexpr const UINT NUM_EDIT_BATCHES = 120u;
+
+    // Heights that are whole blocks of a power of two map, so the edited height map reads back exactly
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(9u).Generate(40u, 32u, 36u, terrain)))
+    {
+        return;
+    }
+    Scene scene(terrain);
+
+    // Columns are raised, dug and recolored, several at once from time to time, without initializing the scene
+    std::mt19937 random(3u);
+    std::uniform_int_distribution<INT> width(0, static_cast<INT>(terrain.uWidth) - 1);
+    std::uniform_int_distribution<INT> depth(0, static_cast<INT>(terrain.uDepth) - 1);
+    std::uniform_int_distribution<UINT> height(1u, terrain.uHeight - 1u);
+    for (UINT uBatchIdx = 0u; uBatchIdx < NUM_EDIT_BATCHES; ++uBatchIdx)
+    {
+        UINT uNumEdits = uBatchIdx % 4u == 3u ? 2u + random() % 6u : 1u;
+        for (UINT uEditIdx = 0u; uEditIdx < uNumEdits; ++uEditIdx)
+        {
+            if (!CHECK_HR(setColumn(scene, terrain, width(random), depth(random), height(random), EDIT_BLOCKS[random() % ARRAYSIZE(EDIT_BLOCKS)])))
+            {
+                return;
+            }
+        }
+        if (!CHECK_HR(scene.FlushBlockEdits()))
+        {
+            return;
+        }
+
+        // The faces, occlusion and light of the edited voxel are those of a scene baked from the edited map
+        if (uBatchIdx % 10u == 9u)
+        {
+            Scene rebuiltScene(terrain);
+            if (!CHECK(hasSameInstances(getSortedInstances(*scene.GetVoxels()[0]), getSortedInstances(*rebuiltScene.GetVoxels()[0]))))
+            {
+                return;
+            }
+        }
+    }
+}
+
+TEST_CASE(SceneBlockEditsMatchRebakedGrid)
+{
+    constexpr const UINT NUM_EDIT_BATCHES = 150u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(4u).Generate(36u, 32u, 36u, terrain)))
+    {
+        return;
+    }
+    Scene scene(terrain);
+    if (!CHECK_HR(scene.SetBlockEmission(EMITTER, VoxelLight::MAX_LEVEL - 1u)))
+    {
+        return;
+    }
+
+    // Tunnels, overhangs and emitters, which a height map cannot have, darken and light blocks around them
+    std::mt19937 random(8u);
+    std::uniform_int_distribution<INT> width(0, static_cast<INT>(terrain.uWidth) - 1);
+    std::uniform_int_distribution<INT> height(0, static_cast<INT>(terrain.uHeight) - 1);
+    std::uniform_int_distribution<INT> depth(0, static_cast<INT>(terrain.uDepth) - 1);
+    for (UINT uBatchIdx = 0u; uBatchIdx < NUM_EDIT_BATCHES; ++uBatchIdx)
+    {
+        INT x = width(random);
+        INT y = height(random);
+        INT z = depth(random);
+        HRESULT hr = S_OK;
+        switch (uBatchIdx % 5u)
+        {
+        case 0u:
+            hr = scene.FillRegion(x - 2, y - 1, z - 2, x + 2, y + 1, z + 2, eBlockType::AIR);
+            break;
+        case 1u:
+            hr = scene.FillRegion(x - 1, y, z - 1, x + 1, y, z + 1, EDIT_BLOCKS[random() % ARRAYSIZE(EDIT_BLOCKS)]);
+            break;
+        case 2u:
+            hr = scene.SetBlock(x, y, z, EMITTER);
+            break;
+        default:
+            hr = scene.SetBlock(x, y, z, random() % 2u == 0u ? eBlockType::AIR : EDIT_BLOCKS[random() % ARRAYSIZE(EDIT_BLOCKS)]);
+            break;
+        }
+        if (!CHECK_HR(hr) || !CHECK_HR(scene.FlushBlockEdits()))
+        {
+            return;
+        }
+
+        if (uBatchIdx % 10u == 9u && !CHECK(hasSameInstances(getSortedInstances(*scene.GetVoxels()[0]), rebakeGrid(scene.GetVoxelGrid()))))
+        {
+            return;
+        }
+    }
+}
+
+BENCHMARK(VoxelBuildInstanceDataPerformance)
+{
+    constexpr const UINT MAP_SIZE = 1024u;
+    constexpr const UINT MAP_HEIGHT = 128u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(7u).Generate(MAP_SIZE, MAP_HEIGHT, MAP_SIZE, terrain)))
+    {
+        return;
+    }
+
+    // The bake of the whole map when a scene is created, with the faces and the ambient occlusion of every exposed block
+    std::vector<VoxelInstanceData> aInstanceData;
+    ThreadPool threadPool(ThreadPool::GetDefaultNumThreads());
+    for (ThreadPool* pThreadPool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+    {
+        DOUBLE time = context.MeasureMilliseconds(3u, [&]()
+        {
+            Voxel::BuildInstanceData(terrain, 0u, 0u, MAP_SIZE, MAP_SIZE, aInstanceData, pThreadPool);
+        });
+
+        PCSTR pszThreads = pThreadPool ? "thread pool" : "single thread";
+        CHAR szName[64];
+        sprintf_s(szName, "%ux%ux%u map, %s", MAP_SIZE, MAP_HEIGHT, MAP_SIZE, pszThreads);
+        context.Report(szName, time, "ms");
+        sprintf_s(szName, "faces, %s", pszThreads);
+        context.Report(szName, countFaces(aInstanceData) / time / 1000.0, "Mfaces/s");
+        sprintf_s(szName, "instances, %s", pszThreads);
+        context.Report(szName, aInstanceData.size() / time / 1000.0, "Minstances/s");
+    }
+    context.Report("faces per instance", static_cast<DOUBLE>(countFaces(aInstanceData)) / aInstanceData.size(), "");
+
+    // The rebake of a block edit, for every exposed block of a 128x128 corner read back from the grid
+    VoxelGrid grid;
+    grid.FillTerrain(terrain);
+    std::vector<UINT> aNeighbourMasks;
+    std::vector<VoxelInstanceData> aEditedInstanceData;
+    for (const VoxelInstanceData& instance : aInstanceData)
+    {
+        if (instance.X < 128 && instance.Z < 128)
+        {
+            aNeighbourMasks.push_back(grid.GetNeighbourMask(instance.X, instance.Y, instance.Z));
+            aEditedInstanceData.push_back(instance);
+        }
+    }
+
+    DOUBLE time = context.MeasureMilliseconds(3u, [&]()
+    {
+        for (size_t i = 0u; i < aEditedInstanceData.size(); ++i)
+        {
+            aEditedInstanceData[i].FaceMask = Voxel::GetFaceMask(aNeighbourMasks[i]);
+            Voxel::BakeAmbientOcclusion(aNeighbourMasks[i], aEditedInstanceData[i]);
+        }
+    });
+    context.Report("ambient occlusion rebake", countFaces(aEditedInstanceData) / time / 1000.0, "Mfaces/s");
+}
+
+BENCHMARK(SceneBlockEditPerEdit)
+{
+    constexpr const UINT MAP_SIZE = 256u;
+    constexpr const UINT MAP_HEIGHT = 64u;
+    constexpr const UINT NUM_EDITS = 2000u;
+
+    TerrainData terrain;
+    if (!CHECK_HR(TerrainGenerator(7u).Generate(MAP_SIZE, MAP_HEIGHT, MAP_SIZE, terrain)))
+    {
+        return;
+    }
+    Scene scene(terrain);
+
+    // The top block of random columns, every edit flushed on its own like one edit per frame
+    std::mt19937 random(5u);
+    std::uniform_int_distribution<INT> horizontal(1, static_cast<INT>(MAP_SIZE) - 2);
+    std::vector<XMINT3> aCells(NUM_EDITS);
+    for (XMINT3& cell : aCells)
+    {
+        cell.x = horizontal(random);
+        cell.z = horizontal(random);
+        cell.y = static_cast<INT>(MAP_HEIGHT) - 1;
+        while (cell.y > 0 && !scene.GetVoxelGrid().IsSolid(cell.x, cell.y, cell.z))
+        {
+            --cell.y;
+        }
+    }
+
+    // Digs the block out and puts it back, then fills and digs a 3x3x3 box around it, without the upload of an initialized scene
+    std::vector<eBlockType> aOldBlocks(NUM_EDITS);
+    DOUBLE time = context.MeasureMilliseconds(1u, [&]()
+    {
+        for (UINT uEditIdx = 0u; uEditIdx < NUM_EDITS; ++uEditIdx)
+        {
+            const XMINT3& cell = aCells[uEditIdx];
+            aOldBlocks[uEditIdx] = scene.GetVoxelGrid().GetBlock(cell.x, cell.y, cell.z);
+            scene.SetBlock(cell.x, cell.y, cell.z, eBlockType::AIR);
+            scene.FlushBlockEdits();
+            scene.SetBlock(cell.x, cell.y, cell.z, aOldBlocks[uEditIdx]);
+            scene.FlushBlockEdits();
+        }
+    });
+    context.Report("block edit", 1000.0 * time / (2.0 * NUM_EDITS), "us");
+
+    time = context.MeasureMilliseconds(1u, [&]()
+    {
+        for (UINT uEditIdx = 0u; uEditIdx < NUM_EDITS; ++uEditIdx)
+        {
+            const XMINT3& cell = aCells[uEditIdx];
+            scene.FillRegion(cell.x - 1, cell.y, cell.z - 1, cell.x + 1, cell.y + 2, cell.z + 1, aOldBlocks[uEditIdx]);
+            scene.FlushBlockEdits();
+            scene.FillRegion(cell.x - 1, cell.y + 1, cell.z - 1, cell.x + 1, cell.y + 2, cell.z + 1, eBlockType::AIR);
+            scene.FlushBlockEdits();
+        }
+    });
+    context.Report("3x3x3 region edit", 1000.0 * time / (2.0 * NUM_EDITS), "us");
+}
@@ -0,0 +1,312 @@
+#include "Harness/TestRegistry.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
+
+#include "Scene/VoxelWorld.h"
+
+using namespace library;
+
+namespace
+{
+    constexpr const UINT MAP_HEIGHT = 64u;
+    constexpr const FLOAT CHUNK_EXTENT = 2.0f * static_cast<FLOAT>(VoxelChunk::SIZE);
+
+    // World position of a point given in level 0 chunks, the blocks are centered on even coordinates
+    XMVECTOR getEyePosition(_In_ FLOAT chunkX, _In_ FLOAT chunkZ)
+    {
+        return XMVectorSet(chunkX * CHUNK_EXTENT - 1.0f, static_cast<FLOAT>(MAP_HEIGHT), chunkZ * CHUNK_EXTENT - 1.0f, 1.0f);
+    }
+
+    BOOL isChunkInView(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ INT x, _In_ INT z, _In_ UINT uViewDistance)
+    {
+        FLOAT minX = static_cast<FLOAT>(x);
+        FLOAT minZ = static_cast<FLOAT>(z);
+        FLOAT dx = eyeX < minX ? minX - eyeX : (eyeX > minX + 1.0f ? eyeX - minX - 1.0f : 0.0f);
+        FLOAT dz = eyeZ < minZ ? minZ - eyeZ : (eyeZ > minZ + 1.0f ? eyeZ - minZ - 1.0f : 0.0f);
+        return std::sqrt(dx * dx + dz * dz) <= static_cast<FLOAT>(uViewDistance);
+    }
+
+    // Brute force count of the level 0 chunks within the view distance of an eye
+    UINT countChunksInView(_In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uViewDistance)
+    {
+        INT radius = static_cast<INT>(uViewDistance) + 1;
+        UINT uNumChunks = 0u;
+        for (INT z = static_cast<INT>(std::floor(eyeZ)) - radius; z <= static_cast<INT>(std::floor(eyeZ)) + radius; ++z)
+        {
+            for (INT x = static_cast<INT>(std::floor(eyeX)) - radius; x <= static_cast<INT>(std::floor(eyeX)) + radius; ++x)
+            {
+                uNumChunks += isChunkInView(eyeX, eyeZ, x, z, uViewDistance) ? 1u : 0u;
+            }
+        }
+
+        return uNumChunks;
+    }
+
+    UINT64 getCellKey(_In_ INT x, _In_ INT z)
+    {
+        return (static_cast<UINT64>(static_cast<UINT>(z)) << 32u) | static_cast<UINT>(x);
+    }
+
+    // Number of visible chunks over every level 0 chunk they cover
+    std::unordered_map<UINT64, UINT> getCoverage(_In_ const VoxelWorld& world)
+    {
+        std::unordered_map<UINT64, UINT> coverage;
+        for (const std::shared_ptr<VoxelChunk>& chunk : world.GetVisibleChunks())
+        {
+            INT size = 1 << chunk->GetLevel();
+            for (INT z = chunk->GetZ() * size; z < (chunk->GetZ() + 1) * size; ++z)
+            {
+                for (INT x = chunk->GetX() * size; x < (chunk->GetX() + 1) * size; ++x)
+                {
+                    ++coverage[getCellKey(x, z)];
+                }
+            }
+        }
+
+        return coverage;
+    }
+
+    // Level 0 chunks within the view distance that no visible chunk covers
+    UINT countHoles(_In_ const std::unordered_map<UINT64, UINT>& coverage, _In_ FLOAT eyeX, _In_ FLOAT eyeZ, _In_ UINT uViewDistance)
+    {
+        INT radius = static_cast<INT>(uViewDistance) + 1;
+        UINT uNumHoles = 0u;
+        for (INT z = static_cast<INT>(std::floor(eyeZ)) - radius; z <= static_cast<INT>(std::floor(eyeZ)) + radius; ++z)
+        {
+            for (INT x = static_cast<INT>(std::floor(eyeX)) - radius; x <= static_cast<INT>(std::floor(eyeX)) + radius; ++x)
+            {
+                uNumHoles += isChunkInView(eyeX, eyeZ, x, z, uViewDistance) && !coverage.contains(getCellKey(x, z)) ? 1u : 0u;
+            }
+        }
+
+        return uNumHoles;
+    }
+
+    UINT countOverlaps(_In_ const std::unordered_map<UINT64, UINT>& coverage)
+    {
+        UINT uNumOverlaps = 0u;
+        for (const auto& [uKey, uNumChunks] : coverage)
+        {
+            uNumOverlaps += uNumChunks > 1u ? 1u : 0u;
+        }
+
+        return uNumOverlaps;
+    }
+
+    void update(_In_ VoxelWorld& world, _In_opt_ ThreadPool* pThreadPool, _In_ FXMVECTOR eye)
+    {
+        world.Update(eye);
+        if (pThreadPool)
+        {
+            pThreadPool->WaitIdle();
+        }
+    }
+
+    // Updates until nothing is generating and a frame uploaded nothing
+    void settle(_In_ VoxelWorld& world, _In_opt_ ThreadPool* pThreadPool, _In_ FXMVECTOR eye)
+    {
+        for (UINT i = 0u; i < 1024u; ++i)
+        {
+            update(world, pThreadPool, eye);
+            if (world.GetStatistics().uNumPendingChunks == 0u && world.GetStatistics().uNumUploadedChunks == 0u)
+            {
+                return;
+            }
+        }
+    }
+}
+
+TEST_CASE(VoxelWorldLoadsEveryChunkInView)
+{
+    constexpr const UINT VIEW_DISTANCE = 3u;
+
+    // Without a thread pool the chunks are generated inside Update, one per frame
+    VoxelWorld world(TerrainGenerator(7u), MAP_HEIGHT, nullptr);
+    world.SetViewDistance(VIEW_DISTANCE);
+    world.SetUploadBudget(4u);
+    world.SetOcclusionCulling(FALSE);
+    world.SetMaxResidentBytes(SIZE_MAX);
+
+    UINT uExpectedNumChunks = countChunksInView(0.5f, 0.5f, VIEW_DISTANCE);
+    for (UINT i = 0u; i < 2u * uExpectedNumChunks; ++i)
+    {
+        update(world, nullptr, getEyePosition(0.5f, 0.5f));
+    }
+
+    const VoxelWorld::Statistics& statistics = world.GetStatistics();
+    CHECK(statistics.uNumPendingChunks == 0u);
+    CHECK(statistics.uNumResidentChunks == uExpectedNumChunks);
+    CHECK(statistics.uNumDrawnChunks == uExpectedNumChunks);
+    CHECK(statistics.uNumGeneratedChunks == uExpectedNumChunks);
+    CHECK(statistics.uNumEvictedChunks == 0u);
+
+    // A settled world neither generates nor uploads anything
+    update(world, nullptr, getEyePosition(0.5f, 0.5f));
+    CHECK(world.GetStatistics().uNumUploadedChunks == 0u);
+    CHECK(world.GetStatistics().uNumGeneratedChunks == uExpectedNumChunks);
+}
+
+TEST_CASE(VoxelWorldScriptedFlightStaysWithinMemoryCap)
+{
+    constexpr const UINT VIEW_DISTANCE = 4u;
+    constexpr const UINT NUM_FRAMES = 240u;
+    constexpr const FLOAT SPEED = 0.125f;
+
+    std::shared_ptr<ThreadPool> threadPool = std::make_shared<ThreadPool>(2u);
+    VoxelWorld world(TerrainGenerator(7u), MAP_HEIGHT, threadPool);
+    world.SetViewDistance(VIEW_DISTANCE);
+    world.SetUploadBudget(8u);
+    world.SetOcclusionCulling(FALSE);
+
+    // Let the view around the start settle, then cap the memory at twice what it uses
+    for (UINT i = 0u; i < 64u; ++i)
+    {
+        update(world, threadPool.get(), getEyePosition(0.5f, 0.5f));
+    }
+    size_t uMaxResidentBytes = 2u * world.GetStatistics().uResidentBytes;
+    CHECK(world.GetStatistics().uNumResidentChunks == countChunksInView(0.5f, 0.5f, VIEW_DISTANCE));
+    world.SetMaxResidentBytes(uMaxResidentBytes);
+
+    // Fly along a diagonal, far enough to leave the start behind several times over
+    for (UINT i = 0u; i < NUM_FRAMES; ++i)
+    {
+        FLOAT t = 0.5f + SPEED * static_cast<FLOAT>(i);
+        update(world, threadPool.get(), getEyePosition(t, 0.5f * t));
+
+        if (!CHECK(world.GetStatistics().uResidentBytes <= uMaxResidentBytes))
+        {
+            break;
+        }
+    }
+
+    // Hover at the end until the view is complete again
+    FLOAT endX = 0.5f + SPEED * static_cast<FLOAT>(NUM_FRAMES - 1u);
+    for (UINT i = 0u; i < 64u; ++i)
+    {
+        update(world, threadPool.get(), getEyePosition(endX, 0.5f * endX));
+    }
+
+    const VoxelWorld::Statistics& statistics = world.GetStatistics();
+    CHECK(statistics.uNumEvictedChunks > 0u);
+    CHECK(statistics.uNumPendingChunks == 0u);
+    CHECK(statistics.uNumDrawnChunks == countChunksInView(endX, 0.5f * endX, VIEW_DISTANCE));
+    CHECK(statistics.maxGenerationLatency > 0.0f);
+    CHECK(statistics.averageGenerationLatency <= statistics.maxGenerationLatency);
+}
+
+TEST_CASE(VoxelWorldLodCoversViewWithoutOverlap)
+{
+    constexpr const UINT VIEW_DISTANCE = 12u;
+    constexpr const UINT NUM_LOD_LEVELS = 3u;
+    constexpr const UINT NUM_FRAMES = 160u;
+    constexpr const FLOAT SPEED = 0.25f;
+
+    std::shared_ptr<ThreadPool> threadPool = std::make_shared<ThreadPool>(4u);
+    VoxelWorld world(TerrainGenerator(7u), MAP_HEIGHT, threadPool);
+    world.SetViewDistance(VIEW_DISTANCE);
+    world.SetNumLodLevels(NUM_LOD_LEVELS);
+    world.SetUploadBudget(16u);
+    world.SetOcclusionCulling(FALSE);
+    world.SetMaxResidentBytes(SIZE_MAX);
+
+    settle(world, threadPool.get(), getEyePosition(0.5f, 0.5f));
+    std::unordered_map<UINT64, UINT> coverage = getCoverage(world);
+    CHECK(countHoles(coverage, 0.5f, 0.5f, VIEW_DISTANCE) == 0u);
+    CHECK(countOverlaps(coverage) == 0u);
+
+    // Fly along a diagonal, every frame the levels switch around the eye. The eye stays off the chunk borders,
+    // so no chunk only touches the edge of the view.
+    UINT uMaxNumLodChunks = 0u;
+    for (UINT i = 0u; i < NUM_FRAMES; ++i)
+    {
+        FLOAT t = 0.4f + SPEED * static_cast<FLOAT>(i);
+
+        // A chunk covered before stays covered while its replacements stream in, and nothing is drawn twice
+        update(world, threadPool.get(), getEyePosition(t, 0.5f * t));
+        std::unordered_map<UINT64, UINT> updatedCoverage = getCoverage(world);
+        UINT uNumOpenedHoles = 0u;
+        for (const auto& [uKey, uNumChunks] : coverage)
+        {
+            INT x = static_cast<INT>(static_cast<UINT>(uKey));
+            INT z = static_cast<INT>(static_cast<UINT>(uKey >> 32u));
+            uNumOpenedHoles += isChunkInView(t, 0.5f * t, x, z, VIEW_DISTANCE) && !updatedCoverage.contains(uKey) ? 1u : 0u;
+        }
+        CHECK(uNumOpenedHoles == 0u);
+        CHECK(countOverlaps(updatedCoverage) == 0u);
+
+        // Once streamed in, the whole view is covered exactly once
+        settle(world, threadPool.get(), getEyePosition(t, 0.5f * t));
+        coverage = getCoverage(world);
+        if (!CHECK(countHoles(coverage, t, 0.5f * t, VIEW_DISTANCE) == 0u) || !CHECK(countOverlaps(coverage) == 0u) || !CHECK(uNumOpenedHoles == 0u))
+        {
+            return;
+        }
+        uMaxNumLodChunks = world.GetStatistics().uNumDrawnChunks > uMaxNumLodChunks ? world.GetStatistics().uNumDrawnChunks : uMaxNumLodChunks;
+    }
+
+    // The same view without levels of detail draws every level 0 chunk in it
+    FLOAT endX = 0.4f + SPEED * static_cast<FLOAT>(NUM_FRAMES - 1u);
+    VoxelWorld baseline(TerrainGenerator(7u), MAP_HEIGHT, threadPool);
+    baseline.SetViewDistance(VIEW_DISTANCE);
+    baseline.SetUploadBudget(16u);
+    baseline.SetOcclusionCulling(FALSE);
+    baseline.SetMaxResidentBytes(SIZE_MAX);
+    settle(baseline, threadPool.get(), getEyePosition(endX, 0.5f * endX));
+    const VoxelWorld::Statistics& baselineStatistics = baseline.GetStatistics();
+    const VoxelWorld::Statistics& statistics = world.GetStatistics();
+    CHECK(baselineStatistics.uNumDrawnChunks == countChunksInView(endX, 0.5f * endX, VIEW_DISTANCE));
+    CHECK(countHoles(getCoverage(baseline), endX, 0.5f * endX, VIEW_DISTANCE) == 0u);
+
+    // The coarser levels cover the far rings with fewer chunks and far fewer blocks
+    CHECK(2u * uMaxNumLodChunks < baselineStatistics.uNumDrawnChunks);
+    CHECK(2u * statistics.uNumDrawnInstances < baselineStatistics.uNumDrawnInstances);
+}
+
+BENCHMARK(VoxelWorldStreamingFlight)
+{
+    constexpr const UINT NUM_FRAMES = 300u;
+    constexpr const FLOAT SPEED = 0.125f;
+    constexpr const std::chrono::microseconds FRAME_TIME(16667);
+
+    std::shared_ptr<ThreadPool> threadPool = std::make_shared<ThreadPool>(ThreadPool::GetDefaultNumThreads());
+    VoxelWorld world(TerrainGenerator(7u), MAP_HEIGHT, threadPool);
+    world.SetViewDistance(VoxelWorld::DEFAULT_VIEW_DISTANCE);
+    world.SetUploadBudget(VoxelWorld::DEFAULT_UPLOAD_BUDGET);
+
+    // Frames are paced at 60 Hz and not synchronized with the workers, so the chunks lag behind the camera like in the game
+    UINT uMinNumDrawnChunks = UINT_MAX;
+    DOUBLE totalUpdateTime = 0.0;
+    DOUBLE maxUpdateTime = 0.0;
+    auto frameStart = std::chrono::steady_clock::now();
+    for (UINT i = 0u; i < NUM_FRAMES; ++i)
+    {
+        FLOAT t = SPEED * static_cast<FLOAT>(i);
+        world.Update(getEyePosition(t, 0.0f));
+        DOUBLE updateTime = std::chrono::duration<DOUBLE, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+        totalUpdateTime += updateTime;
+        maxUpdateTime = updateTime > maxUpdateTime ? updateTime : maxUpdateTime;
+        if (i >= NUM_FRAMES / 4u)
+        {
+            uMinNumDrawnChunks = world.GetStatistics().uNumDrawnChunks < uMinNumDrawnChunks ? world.GetStatistics().uNumDrawnChunks : uMinNumDrawnChunks;
+        }
+
+        frameStart += FRAME_TIME;
+        std::this_thread::sleep_until(frameStart);
+    }
+    threadPool->WaitIdle();
+
+    const VoxelWorld::Statistics& statistics = world.GetStatistics();
+    context.Report("average Update", totalUpdateTime / NUM_FRAMES, "ms");
+    context.Report("max Update", maxUpdateTime, "ms");
+    context.Report("average generation latency", statistics.averageGenerationLatency, "ms");
+    context.Report("max generation latency", statistics.maxGenerationLatency, "ms");
+    context.Report("generated chunks", statistics.uNumGeneratedChunks, "");
+    context.Report("evicted chunks", statistics.uNumEvictedChunks, "");
+    context.Report("resident chunks at the end", statistics.uNumResidentChunks, "");
+    context.Report("chunks in view", countChunksInView(SPEED * (NUM_FRAMES - 1u), 0.0f, VoxelWorld::DEFAULT_VIEW_DISTANCE), "");
+    context.Report("min drawn chunks after warm up", uMinNumDrawnChunks, "");
+}
@@ -0,0 +1,98 @@
+#include "Harness/TestRegistry.h"
+
+#include <atomic>
+#include <cstdio>
+
+#include "Scene/TerrainGenerator.h"
+#include "Thread/ThreadPool.h"
+
+using namespace library;
+
+TEST_CASE(ParallelForVisitsEveryIndexOnce)
+{
+    ThreadPool threadPool(4u);
+
+    for (UINT uNumItems : { 0u, 1u, 2u, 5u, 1000u })
+    {
+        std::vector<std::atomic<UINT>> aNumVisits(uNumItems);
+        threadPool.ParallelFor(uNumItems, [&aNumVisits](UINT i)
+        {
+            aNumVisits[i].fetch_add(1u);
+        });
+
+        for (UINT i = 0u; i < uNumItems; ++i)
+        {
+            CHECK(aNumVisits[i].load() == 1u);
+        }
+    }
+}
+
+TEST_CASE(ParallelForNestedInTaskDoesNotDeadlock)
+{
+    ThreadPool threadPool(2u);
+    std::atomic<UINT> uNumVisits = 0u;
+
+    for (UINT i = 0u; i < 4u; ++i)
+    {
+        threadPool.Enqueue([&threadPool, &uNumVisits]()
+        {
+            threadPool.ParallelFor(64u, [&uNumVisits](UINT)
+            {
+                uNumVisits.fetch_add(1u);
+            });
+        });
+    }
+    threadPool.WaitIdle();
+
+    CHECK(uNumVisits.load() == 4u * 64u);
+}
+
+TEST_CASE(TerrainIsIndependentOfThreadCount)
+{
+    TerrainGenerator terrainGenerator(7u);
+    TerrainData serialTerrain;
+    TerrainData parallelTerrain;
+    ThreadPool threadPool(3u);
+
+    CHECK_HR(terrainGenerator.Generate(300u, 64u, 200u, serialTerrain));
+    CHECK_HR(terrainGenerator.Generate(300u, 64u, 200u, parallelTerrain, &threadPool));
+
+    CHECK(serialTerrain.aHeights == parallelTerrain.aHeights);
+    CHECK(serialTerrain.aBlockTypes == parallelTerrain.aBlockTypes);
+}
+
+BENCHMARK(ParallelForScaling)
+{
+    constexpr const UINT MAP_SIZE = 2048u;
+
+    TerrainGenerator terrainGenerator(7u);
+    TerrainData terrain;
+
+    DOUBLE serialTime = context.MeasureMilliseconds(2u, [&]()
+    {
+        terrainGenerator.Generate(MAP_SIZE, 64u, MAP_SIZE, terrain);
+    });
+    context.Report("Generate 2048x2048, calling thread only", serialTime, "ms");
+
+    // ParallelFor runs on the workers and the calling thread
+    UINT uMaxNumThreads = ThreadPool::GetDefaultNumThreads();
+    for (UINT uNumWorkers = 1u; ; uNumWorkers = uNumWorkers * 2u < uMaxNumThreads ? uNumWorkers * 2u : uMaxNumThreads)
+    {
+        ThreadPool threadPool(uNumWorkers);
+        DOUBLE time = context.MeasureMilliseconds(2u, [&]()
+        {
+            terrainGenerator.Generate(MAP_SIZE, 64u, MAP_SIZE, terrain, &threadPool);
+        });
+
+        CHAR szName[64];
+        sprintf_s(szName, "Generate 2048x2048, %u workers", uNumWorkers);
+        context.Report(szName, time, "ms");
+        sprintf_s(szName, "speedup with %u workers", uNumWorkers);
+        context.Report(szName, serialTime / time, "x");
+
+        if (uNumWorkers == uMaxNumThreads)
+        {
+            break;
+        }
+    }
+}